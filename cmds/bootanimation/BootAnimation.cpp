@@ -19,7 +19,12 @@
 #define LOG_TAG "BootAnimation"
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <algorithm>
+#include <condition_variable>
 #include <filesystem>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <stdint.h>
@@ -111,6 +116,10 @@ static const char PROGRESS_PROP_NAME[] = "service.bootanim.progress";
 static const char CLOCK_ENABLED_PROP_NAME[] = "persist.sys.bootanim.clock.enabled";
 static const int ANIM_ENTRY_NAME_MAX = ANIM_PATH_MAX + 1;
 static const int MAX_CHECK_EXIT_INTERVAL_US = 50000;
+// Bounds on how far ahead of the frame being drawn the frames of a part are decoded.
+static const size_t MAX_PREFETCH_BYTES = 32 * 1024 * 1024;
+static const size_t MAX_PREFETCH_FRAMES = 8;
+static const size_t MAX_DECODER_THREADS = 2;
 static constexpr size_t TEXT_POS_LEN_MAX = 16;
 static const int DYNAMIC_COLOR_COUNT = 4;
 static const char U_TEXTURE[] = "uTexture";
@@ -347,23 +356,8 @@ status_t BootAnimation::initTexture(Texture* texture, AssetManager& assets,
     return NO_ERROR;
 }
 
-status_t BootAnimation::initTexture(FileMap* map, int* width, int* height,
-    bool premultiplyAlpha) {
-    ATRACE_CALL();
-    AndroidBitmapInfo bitmapInfo;
-    void* pixels = decodeImage(map->getDataPtr(), map->getDataLength(), &bitmapInfo,
-        premultiplyAlpha);
-    auto pixelDeleter = std::unique_ptr<void, decltype(free)*>{ pixels, free };
-
-    // FileMap memory is never released until application exit.
-    // Release it now as the texture is already loaded and the memory used for
-    // the packed resource can be released.
-    delete map;
-
-    if (!pixels) {
-        return NO_INIT;
-    }
-
+static void uploadTexture(const AndroidBitmapInfo& bitmapInfo, const void* pixels,
+    bool useNpotTextures) {
     const int w = bitmapInfo.width;
     const int h = bitmapInfo.height;
 
@@ -374,7 +368,7 @@ status_t BootAnimation::initTexture(FileMap* map, int* width, int* height,
 
     switch (bitmapInfo.format) {
         case ANDROID_BITMAP_FORMAT_RGBA_8888:
-            if (!mUseNpotTextures && (tw != w || th != h)) {
+            if (!useNpotTextures && (tw != w || th != h)) {
                 glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tw, th, 0, GL_RGBA,
                         GL_UNSIGNED_BYTE, nullptr);
                 glTexSubImage2D(GL_TEXTURE_2D, 0,
@@ -386,7 +380,7 @@ status_t BootAnimation::initTexture(FileMap* map, int* width, int* height,
             break;
 
         case ANDROID_BITMAP_FORMAT_RGB_565:
-            if (!mUseNpotTextures && (tw != w || th != h)) {
+            if (!useNpotTextures && (tw != w || th != h)) {
                 glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, tw, th, 0, GL_RGB,
                         GL_UNSIGNED_SHORT_5_6_5, nullptr);
                 glTexSubImage2D(GL_TEXTURE_2D, 0,
@@ -404,13 +398,195 @@ status_t BootAnimation::initTexture(FileMap* map, int* width, int* height,
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+status_t BootAnimation::initTexture(FileMap* map, int* width, int* height,
+    bool premultiplyAlpha) {
+    ATRACE_CALL();
+    AndroidBitmapInfo bitmapInfo;
+    void* pixels = decodeImage(map->getDataPtr(), map->getDataLength(), &bitmapInfo,
+        premultiplyAlpha);
+    auto pixelDeleter = std::unique_ptr<void, decltype(free)*>{ pixels, free };
+
+    // FileMap memory is never released until application exit.
+    // Release it now as the texture is already loaded and the memory used for
+    // the packed resource can be released.
+    delete map;
+
+    if (!pixels) {
+        return NO_INIT;
+    }
+
+    uploadTexture(bitmapInfo, pixels, mUseNpotTextures);
+
+    *width = bitmapInfo.width;
+    *height = bitmapInfo.height;
+
+    return NO_ERROR;
+}
+
+// Identifier at the start of a KTX 1.1 file.
+static const uint8_t KTX_IDENTIFIER[] = {
+    0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+static const uint32_t KTX_ENDIANNESS = 0x04030201;
+
+// The header of a KTX 1.1 file, after the identifier.
+struct KtxHeader {
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+status_t BootAnimation::initCompressedTexture(FileMap* map, int* width, int* height) {
+    ATRACE_CALL();
+    // Release the packed resource once the texture is uploaded, as initTexture does.
+    auto mapDeleter = std::unique_ptr<FileMap>(map);
+    const uint8_t* data = static_cast<const uint8_t*>(map->getDataPtr());
+    const size_t length = map->getDataLength();
+
+    KtxHeader header;
+    uint32_t imageSize;
+    const size_t headerEnd = sizeof(KTX_IDENTIFIER) + sizeof(header);
+    if (length < headerEnd + sizeof(imageSize) || memcmp(data, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0) {
+        SLOGE("Compressed frame is not a KTX file");
+        return BAD_VALUE;
+    }
+    memcpy(&header, data + sizeof(KTX_IDENTIFIER), sizeof(header));
+    // Only a single, non-array, compressed 2D image is supported.
+    if (header.endianness != KTX_ENDIANNESS || header.glType != 0 || header.glFormat != 0 ||
+        header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth != 0 ||
+        header.numberOfArrayElements != 0 || header.numberOfFaces != 1 ||
+        header.numberOfMipmapLevels > 1 ||
+        header.bytesOfKeyValueData > length - headerEnd - sizeof(imageSize)) {
+        SLOGE("Unsupported KTX frame");
+        return BAD_VALUE;
+    }
+    const size_t imageOffset = headerEnd + header.bytesOfKeyValueData + sizeof(imageSize);
+    memcpy(&imageSize, data + imageOffset - sizeof(imageSize), sizeof(imageSize));
+    if (imageSize > length - imageOffset) {
+        SLOGE("Truncated KTX frame");
+        return BAD_VALUE;
+    }
+
+    // Clear any stale error so that only the upload is checked.
+    glGetError();
+    glCompressedTexImage2D(GL_TEXTURE_2D, 0, header.glInternalFormat, header.pixelWidth,
+            header.pixelHeight, 0, imageSize, data + imageOffset);
+    const GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        SLOGE("Failed to upload compressed frame with format 0x%x: 0x%x",
+                header.glInternalFormat, error);
+        return NO_INIT;
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    *width = w;
-    *height = h;
+    *width = header.pixelWidth;
+    *height = header.pixelHeight;
 
     return NO_ERROR;
 }
 
+// Decodes the frames of a part on worker threads, at most a bounded number of frames ahead of the
+// frame being drawn, so that the animation thread only has to upload them.
+class FramePrefetcher {
+public:
+    FramePrefetcher(const BootAnimation::Animation::Part& part, size_t lookahead,
+            size_t numThreads)
+          : mPart(part), mLookahead(lookahead) {
+        for (size_t i = 0; i < numThreads; i++) {
+            mThreads.emplace_back([this] { decodeLoop(); });
+        }
+    }
+
+    ~FramePrefetcher() {
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            mStopping = true;
+        }
+        mCondition.notify_all();
+        for (auto& thread : mThreads) {
+            thread.join();
+        }
+        for (auto& entry : mDecoded) {
+            free(entry.second.pixels);
+        }
+    }
+
+    // Waits for the given frame to be decoded. Frames must be taken in order. Returns the pixels,
+    // or nullptr if the frame could not be decoded; the caller must free them.
+    void* take(size_t index, AndroidBitmapInfo* outInfo) {
+        ATRACE_CALL();
+        std::unique_lock<std::mutex> lock(mLock);
+        mCondition.wait(lock, [&] { return mDecoded.count(index) > 0; });
+        auto it = mDecoded.find(index);
+        void* pixels = it->second.pixels;
+        *outInfo = it->second.info;
+        mDecoded.erase(it);
+        mNextToTake = index + 1;
+        lock.unlock();
+        mCondition.notify_all();
+        return pixels;
+    }
+
+private:
+    struct Decoded {
+        AndroidBitmapInfo info;
+        void* pixels;
+    };
+
+    void decodeLoop() {
+        const size_t numFrames = mPart.frames.size();
+        std::unique_lock<std::mutex> lock(mLock);
+        while (true) {
+            mCondition.wait(lock, [&] {
+                return mStopping || mNextToDecode >= numFrames ||
+                        mNextToDecode < mNextToTake + mLookahead;
+            });
+            if (mStopping || mNextToDecode >= numFrames) {
+                return;
+            }
+            const size_t index = mNextToDecode++;
+            lock.unlock();
+
+            // Set decoding option to alpha unpremultiplied so that the R, G, B channels of
+            // transparent pixels are preserved.
+            const FileMap* map = mPart.frames[index].map;
+            Decoded decoded = {};
+            decoded.pixels = decodeImage(map->getDataPtr(), map->getDataLength(), &decoded.info,
+                    false /* don't premultiply alpha */);
+
+            lock.lock();
+            mDecoded[index] = decoded;
+            mCondition.notify_all();
+        }
+    }
+
+    const BootAnimation::Animation::Part& mPart;
+    const size_t mLookahead;
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    size_t mNextToDecode = 0;
+    size_t mNextToTake = 0;
+    bool mStopping = false;
+    std::map<size_t, Decoded> mDecoded;
+    std::vector<std::thread> mThreads;
+};
+
 class BootAnimation::DisplayEventCallback : public LooperCallback {
     BootAnimation* mBootAnimation;
 
@@ -1327,6 +1503,7 @@ bool BootAnimation::preloadZip(Animation& animation) {
                                     Animation::Frame frame;
                                     frame.name = leaf.c_str();
                                     frame.map = map;
+                                    frame.compressed = (leaf.extension() == ".ktx");
                                     frame.trimWidth = animation.width;
                                     frame.trimHeight = animation.height;
                                     frame.trimX = 0;
@@ -1542,6 +1719,14 @@ bool BootAnimation::playAnimation(const Animation& animation) {
     SLOGD("%sAnimationShownTiming start time: %" PRId64 "ms", mShuttingDown ? "Shutdown" : "Boot",
             elapsedRealtime());
 
+    // Bound the decoded frames waiting to be uploaded by the size of a full frame.
+    const size_t frameBytes = std::max<size_t>(4u * animation.width * animation.height, 1);
+    const size_t lookahead =
+            std::clamp<size_t>(MAX_PREFETCH_BYTES / frameBytes, 1, MAX_PREFETCH_FRAMES);
+    const size_t numDecoderThreads =
+            std::clamp<size_t>(std::thread::hardware_concurrency() / 2, 1, MAX_DECODER_THREADS);
+    int droppedFrames = 0;
+
     int fadedFramesCount = 0;
     int lastDisplayedProgress = 0;
     int colorTransitionStart = animation.colorTransitionStart;
@@ -1599,6 +1784,15 @@ bool BootAnimation::playAnimation(const Animation& animation) {
             const bool displayProgress = animation.progressEnabled && (partIdx == (numParts - 1)) &&
                     android::base::GetIntProperty(PROGRESS_PROP_NAME, 0) != 0;
 
+            // The frames are only decoded on the first play of the part, later plays reuse the
+            // textures. Compressed frames are uploaded as they are and need no decoding.
+            std::unique_ptr<FramePrefetcher> prefetcher;
+            if (frameIdx == 0 && numFramesInPart > 1 &&
+                std::none_of(part.frames.begin(), part.frames.end(),
+                        [](const Animation::Frame& frame) { return frame.compressed; })) {
+                prefetcher = std::make_unique<FramePrefetcher>(part, lookahead, numDecoderThreads);
+            }
+
             for (size_t frameIdxInPart = 0; frameIdxInPart < numFramesInPart; frameIdxInPart++) {
                 if (shouldStopPlayingPart(part, fadedFramesCount, lastDisplayedProgress)) break;
 
@@ -1625,10 +1819,24 @@ bool BootAnimation::playAnimation(const Animation& animation) {
                         glGenTextures(1, &frame.tid);
                         glBindTexture(GL_TEXTURE_2D, frame.tid);
                     }
-                    int w, h;
-                    // Set decoding option to alpha unpremultiplied so that the R, G, B channels
-                    // of transparent pixels are preserved.
-                    initTexture(frame.map, &w, &h, false /* don't premultiply alpha */);
+                    if (frame.compressed) {
+                        int w, h;
+                        initCompressedTexture(frame.map, &w, &h);
+                    } else if (prefetcher) {
+                        AndroidBitmapInfo bitmapInfo;
+                        void* pixels = prefetcher->take(frameIdxInPart, &bitmapInfo);
+                        auto pixelDeleter = std::unique_ptr<void, decltype(free)*>{ pixels, free };
+                        // Release the packed resource now that the frame is decoded.
+                        delete frame.map;
+                        if (pixels) {
+                            uploadTexture(bitmapInfo, pixels, mUseNpotTextures);
+                        }
+                    } else {
+                        int w, h;
+                        // Set decoding option to alpha unpremultiplied so that the R, G, B
+                        // channels of transparent pixels are preserved.
+                        initTexture(frame.map, &w, &h, false /* don't premultiply alpha */);
+                    }
                 }
 
                 float fade = 0;
@@ -1705,6 +1913,9 @@ bool BootAnimation::playAnimation(const Animation& animation) {
                 //SLOGD("%lld, %lld", ns2ms(now - lastFrame), ns2ms(delay));
                 lastFrame = now;
 
+                if (delay < 0) {
+                    droppedFrames++;
+                }
                 if (delay > 0) {
                     struct timespec spec;
                     spec.tv_sec  = (now + delay) / 1000000000;
@@ -1752,6 +1963,7 @@ bool BootAnimation::playAnimation(const Animation& animation) {
 
     ALOGD("%sAnimationShownTiming End time: %" PRId64 "ms", mShuttingDown ? "Shutdown" : "Boot",
             elapsedRealtime());
+    ALOGD("%s: %d frames missed their deadline", animation.fileName.c_str(), droppedFrames);
 
     return true;
 }
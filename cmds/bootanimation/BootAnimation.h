@@ -70,6 +70,8 @@ public:
             int trimY;
             int trimWidth;
             int trimHeight;
+            // Whether the frame is a KTX file holding a GPU-compressed texture.
+            bool compressed = false;
             mutable GLuint tid;
             bool operator < (const Frame& rhs) const {
                 return name < rhs.name;
@@ -192,6 +194,7 @@ private:
         bool premultiplyAlpha = true);
     status_t initTexture(FileMap* map, int* width, int* height,
         bool premultiplyAlpha = true);
+    status_t initCompressedTexture(FileMap* map, int* width, int* height);
     status_t initFont(Font* font, const char* fallback);
     void initShaders();
     bool android(const Display& display);
@@ -19,6 +19,8 @@
 #include <sys/stat.h>   // umask
 #include <sys/types.h>  // umask
 
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cstring>
 #include <filesystem>
@@ -27,6 +29,8 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -88,6 +92,83 @@ std::unique_ptr<const IdmapConstraints> ConvertAidlConstraintsToIdmapConstraints
   return idmapConstraints;
 }
 
+// The files that an idmap was last created or verified from, stored next to it. While none of
+// them changes, the idmap can be verified from its header alone, without opening the target and
+// the overlay to compute their CRCs, which at boot is most of the time spent verifying overlays.
+struct VerifiedFiles {
+  // Identifies the contents of a file without reading it, see stat(2).
+  struct Identity {
+    dev_t dev;
+    ino_t inode;
+    int64_t size;
+    struct timespec mtime;
+
+    static std::optional<Identity> ForPath(const std::string& path) {
+      struct stat st = {};
+      if (::stat(path.c_str(), &st) != 0) {
+        return std::nullopt;
+      }
+      return Identity{st.st_dev, st.st_ino, st.st_size, st.st_mtim};
+    }
+
+    bool operator==(const Identity& other) const {
+      return dev == other.dev && inode == other.inode && size == other.size &&
+             mtime.tv_sec == other.mtime.tv_sec && mtime.tv_nsec == other.mtime.tv_nsec;
+    }
+  };
+
+  Identity target;
+  Identity overlay;
+  Identity idmap;
+
+  static std::string PathFor(const std::string& idmap_path) {
+    return idmap_path + ".verified";
+  }
+
+  static std::optional<VerifiedFiles> ForPaths(const std::string& target_path,
+                                               const std::string& overlay_path,
+                                               const std::string& idmap_path) {
+    auto target = Identity::ForPath(target_path);
+    auto overlay = Identity::ForPath(overlay_path);
+    auto idmap = Identity::ForPath(idmap_path);
+    if (!target || !overlay || !idmap) {
+      return std::nullopt;
+    }
+    return VerifiedFiles{*target, *overlay, *idmap};
+  }
+
+  static std::optional<VerifiedFiles> FromPath(const std::string& path) {
+    std::ifstream fin(path);
+    VerifiedFiles files;
+    for (Identity* identity : {&files.target, &files.overlay, &files.idmap}) {
+      fin >> identity->dev >> identity->inode >> identity->size >> identity->mtime.tv_sec >>
+          identity->mtime.tv_nsec;
+    }
+    if (fin.fail()) {
+      return std::nullopt;
+    }
+    return files;
+  }
+
+  void WriteTo(const std::string& path) const {
+    umask(kIdmapFilePermissionMask);
+    std::ofstream fout(path);
+    for (const Identity* identity : {&target, &overlay, &idmap}) {
+      fout << identity->dev << ' ' << identity->inode << ' ' << identity->size << ' '
+           << identity->mtime.tv_sec << ' ' << identity->mtime.tv_nsec << '\n';
+    }
+    fout.close();
+    if (fout.fail()) {
+      LOG(WARNING) << "failed to write to " << path;
+      unlink(path.c_str());
+    }
+  }
+
+  bool operator==(const VerifiedFiles& other) const {
+    return target == other.target && overlay == other.overlay && idmap == other.idmap;
+  }
+};
+
 }  // namespace
 
 namespace android::os {
@@ -116,6 +197,7 @@ Status Idmap2Service::removeIdmap(const std::string& overlay_path, int32_t user_
     return error(base::StringPrintf("failed to unlink %s: calling uid %d lacks write access",
                                     idmap_path.c_str(), uid));
   }
+  unlink(VerifiedFiles::PathFor(idmap_path).c_str());
   if (unlink(idmap_path.c_str()) != 0) {
     *_aidl_return = false;
     return error("failed to unlink " + idmap_path + ": " + strerror(errno));
@@ -133,6 +215,9 @@ Status Idmap2Service::verifyIdmap(const std::string& target_path, const std::str
   assert(_aidl_return);
 
   const std::string idmap_path = Idmap::CanonicalIdmapPathFor(kIdmapCacheDir, overlay_path);
+  // Taken before anything is read, so that a file modified while it is read is verified again.
+  const std::optional<VerifiedFiles> files =
+      VerifiedFiles::ForPaths(target_path, overlay_path, idmap_path);
   std::ifstream fin(idmap_path);
   const std::unique_ptr<const IdmapHeader> header = IdmapHeader::FromBinaryStream(fin);
   const std::unique_ptr<const IdmapConstraints> oldConstraints =
@@ -149,6 +234,25 @@ Status Idmap2Service::verifyIdmap(const std::string& target_path, const std::str
     return ok();
   }
 
+  const PolicyBitmask policy_bitmask = ConvertAidlArgToPolicyBitmask(fulfilled_policies);
+  std::unique_ptr<const IdmapConstraints> newConstraints =
+          ConvertAidlConstraintsToIdmapConstraints(constraints);
+
+  // The target and overlay haven't changed since the idmap was last verified against them, so
+  // their CRCs are still the ones in the header, and neither needs to be opened.
+  const std::string verified_files_path = VerifiedFiles::PathFor(idmap_path);
+  if (files && VerifiedFiles::FromPath(verified_files_path) == files) {
+    auto up_to_date = header->IsUpToDate(target_path, overlay_path, overlay_name,
+                                         header->GetTargetCrc(), header->GetOverlayCrc(),
+                                         policy_bitmask, enforce_overlayable);
+    *_aidl_return = static_cast<bool>(up_to_date && (*oldConstraints == *newConstraints));
+    if (!up_to_date) {
+      LOG(WARNING) << "idmap '" << idmap_path
+                   << "' not up to date : " << up_to_date.GetErrorMessage();
+    }
+    return ok();
+  }
+
   const auto target = GetTargetContainer(target_path);
   if (!target) {
     *_aidl_return = false;
@@ -163,26 +267,35 @@ Status Idmap2Service::verifyIdmap(const std::string& target_path, const std::str
     return ok();
   }
 
-  auto up_to_date =
-      header->IsUpToDate(*GetPointer(*target), **overlay, overlay_name,
-                         ConvertAidlArgToPolicyBitmask(fulfilled_policies), enforce_overlayable);
-
-  std::unique_ptr<const IdmapConstraints> newConstraints =
-          ConvertAidlConstraintsToIdmapConstraints(constraints);
+  auto up_to_date = header->IsUpToDate(*GetPointer(*target), **overlay, overlay_name,
+                                       policy_bitmask, enforce_overlayable);
 
   *_aidl_return = static_cast<bool>(up_to_date && (*oldConstraints == *newConstraints));
   if (!up_to_date) {
     LOG(WARNING) << "idmap '" << idmap_path
                  << "' not up to date : " << up_to_date.GetErrorMessage();
+  } else if (files) {
+    files->WriteTo(verified_files_path);
   }
   return ok();
 }
 
 Status Idmap2Service::createIdmap(const std::string& target_path, const std::string& overlay_path,
                                   const std::string& overlay_name, int32_t fulfilled_policies,
-                                  bool enforce_overlayable, int32_t user_id ATTRIBUTE_UNUSED,
+                                  bool enforce_overlayable, int32_t user_id,
                                   const std::vector<os::OverlayConstraint>& constraints,
                                   std::optional<std::string>* _aidl_return) {
+  return createIdmapAs(IPCThreadState::self()->getCallingUid(), target_path, overlay_path,
+                       overlay_name, fulfilled_policies, enforce_overlayable, user_id, constraints,
+                       _aidl_return);
+}
+
+Status Idmap2Service::createIdmapAs(uid_t uid, const std::string& target_path,
+                                    const std::string& overlay_path,
+                                    const std::string& overlay_name, int32_t fulfilled_policies,
+                                    bool enforce_overlayable, int32_t user_id ATTRIBUTE_UNUSED,
+                                    const std::vector<os::OverlayConstraint>& constraints,
+                                    std::optional<std::string>* _aidl_return) {
   assert(_aidl_return);
   SYSTRACE << "Idmap2Service::createIdmap " << target_path << " " << overlay_path;
   _aidl_return->reset();
@@ -190,7 +303,6 @@ Status Idmap2Service::createIdmap(const std::string& target_path, const std::str
   const PolicyBitmask policy_bitmask = ConvertAidlArgToPolicyBitmask(fulfilled_policies);
 
   const std::string idmap_path = Idmap::CanonicalIdmapPathFor(kIdmapCacheDir, overlay_path);
-  const uid_t uid = IPCThreadState::self()->getCallingUid();
   if (!UidHasWriteAccessToPath(uid, idmap_path)) {
     return error(base::StringPrintf("will not write to %s: calling uid %d lacks write accesss",
                                     idmap_path.c_str(), uid));
@@ -200,8 +312,16 @@ Status Idmap2Service::createIdmap(const std::string& target_path, const std::str
   // that existing memory maps will continue to be valid and unaffected. The file must be deleted
   // before attempting to create the idmap, so that if idmap  creation fails, the overlay will no
   // longer be usable.
+  const std::string verified_files_path = VerifiedFiles::PathFor(idmap_path);
+  unlink(verified_files_path.c_str());
   unlink(idmap_path.c_str());
 
+  // Taken before the target and overlay are read, like in verifyIdmap.
+  const std::optional<VerifiedFiles::Identity> target_identity =
+      VerifiedFiles::Identity::ForPath(target_path);
+  const std::optional<VerifiedFiles::Identity> overlay_identity =
+      VerifiedFiles::Identity::ForPath(overlay_path);
+
   const auto target = GetTargetContainer(target_path);
   if (!target) {
     return error("failed to load target '%s'" + target_path);
@@ -235,11 +355,18 @@ Status Idmap2Service::createIdmap(const std::string& target_path, const std::str
     return error("failed to write to idmap path " + idmap_path);
   }
 
+  const std::optional<VerifiedFiles::Identity> idmap_identity =
+      VerifiedFiles::Identity::ForPath(idmap_path);
+  if (target_identity && overlay_identity && idmap_identity) {
+    VerifiedFiles{*target_identity, *overlay_identity, *idmap_identity}.WriteTo(
+        verified_files_path);
+  }
+
   *_aidl_return = idmap_path;
   return ok();
 }
 
-Status Idmap2Service::verifyOrCreateIdmap(const os::IdmapParams& params,
+Status Idmap2Service::verifyOrCreateIdmap(uid_t uid, const os::IdmapParams& params,
                                           std::optional<std::string>* _aidl_return) {
   bool verified = false;
   verifyIdmap(params.targetPath, params.overlayPath, params.overlayName,
@@ -250,9 +377,9 @@ Status Idmap2Service::verifyOrCreateIdmap(const os::IdmapParams& params,
       return ok();
   }
 
-  return createIdmap(params.targetPath, params.overlayPath, params.overlayName,
-                     params.fulfilledPolicies, params.enforceOverlayable, params.userId,
-                     params.constraints, _aidl_return);
+  return createIdmapAs(uid, params.targetPath, params.overlayPath, params.overlayName,
+                       params.fulfilledPolicies, params.enforceOverlayable, params.userId,
+                       params.constraints, _aidl_return);
 }
 
 Status Idmap2Service::verifyOrCreateIdmaps(const std::vector<os::IdmapParams>& params,
@@ -260,10 +387,24 @@ Status Idmap2Service::verifyOrCreateIdmaps(const std::vector<os::IdmapParams>& p
   assert(_aidl_return);
   SYSTRACE << "Idmap2Service::verifyOrCreateIdmaps";
 
-  std::vector<std::string> idmap_paths;
+  // The workers aren't binder threads, so they don't know the calling uid.
+  const uid_t uid = IPCThreadState::self()->getCallingUid();
+
+  // Caches the targets before the workers start, so that the overlays of a target share it rather
+  // than each worker loading its own.
+  std::unordered_set<std::string> target_paths;
   for (const auto& param : params) {
+    if (target_paths.insert(param.targetPath).second && !GetTargetContainer(param.targetPath)) {
+      LOG(WARNING) << "failed to load target '" << param.targetPath << "'";
+    }
+  }
+
+  std::vector<std::string> idmap_paths(params.size());
+  std::atomic<size_t> next_param = 0;
+  const auto verify_or_create_next = [&]() {
+    for (size_t i = next_param++; i < params.size(); i = next_param++) {
       std::optional<std::string> idmap_path;
-      verifyOrCreateIdmap(param, &idmap_path);
+      verifyOrCreateIdmap(uid, params[i], &idmap_path);
 
       /*
        * There are three possible idmap_path values:
@@ -272,9 +413,23 @@ Status Idmap2Service::verifyOrCreateIdmaps(const std::vector<os::IdmapParams>& p
        * - nullptr    -> idmap could not be created
        * We need to append a value for the third case so the caller has a result for each input.
        */
-      idmap_paths.emplace_back(std::move(idmap_path).value_or("INVALID"));
+      idmap_paths[i] = std::move(idmap_path).value_or("INVALID");
+    }
+  };
+
+  // The calling thread is one of the workers.
+  const size_t thread_count =
+      std::min<size_t>(params.size(), std::max(1U, std::thread::hardware_concurrency()));
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_count; i++) {
+    threads.emplace_back(verify_or_create_next);
   }
-  *_aidl_return = idmap_paths;
+  verify_or_create_next();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  *_aidl_return = std::move(idmap_paths);
   return ok();
 }
 
@@ -293,10 +448,11 @@ idmap2::Result<Idmap2Service::TargetResourceContainerPtr> Idmap2Service::GetTarg
   if (use_cache) {
     std::lock_guard lock(container_cache_mutex_);
     if (auto cache_it = container_cache_.find(target_path); cache_it != container_cache_.end()) {
-      const auto& item = cache_it->second;
+      auto& item = cache_it->second;
       if (is_framework ||
         (item.dev == st.st_dev && item.inode == st.st_ino && item.size == st.st_size
           && item.mtime.tv_sec == st.st_mtim.tv_sec && item.mtime.tv_nsec == st.st_mtim.tv_nsec)) {
+        item.last_use = ++container_cache_uses_;
         return {item.apk};
       }
       container_cache_.erase(cache_it);
@@ -313,12 +469,21 @@ idmap2::Result<Idmap2Service::TargetResourceContainerPtr> Idmap2Service::GetTarg
 
   auto res = std::shared_ptr(std::move(*target));
   std::lock_guard lock(container_cache_mutex_);
+  if (container_cache_.size() >= kMaxCachedContainers &&
+      container_cache_.find(target_path) == container_cache_.end()) {
+    // The containers that are still in use stay alive through their shared pointers.
+    const auto least_recently_used = std::min_element(
+        container_cache_.begin(), container_cache_.end(),
+        [](const auto& a, const auto& b) { return a.second.last_use < b.second.last_use; });
+    container_cache_.erase(least_recently_used);
+  }
   container_cache_.emplace(target_path, CachedContainer {
     .dev = dev_t(st.st_dev),
     .inode = ino_t(st.st_ino),
     .size = st.st_size,
     .mtime = st.st_mtim,
-    .apk = res
+    .apk = res,
+    .last_use = ++container_cache_uses_
   });
   return {res};
 }
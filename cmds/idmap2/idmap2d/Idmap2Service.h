@@ -93,8 +93,13 @@ class Idmap2Service : public BinderService<Idmap2Service>, public BnIdmap2 {
     int64_t size;
     struct timespec mtime;
     std::shared_ptr<idmap2::TargetResourceContainer> apk;
+    // The value of container_cache_uses_ when the container was last returned.
+    uint64_t last_use;
   };
+  // The service is mostly asked about a few targets, so only the most recently used are kept.
+  static constexpr size_t kMaxCachedContainers = 8;
   std::unordered_map<std::string, CachedContainer> container_cache_;
+  uint64_t container_cache_uses_ = 0;
   std::mutex container_cache_mutex_;
 
   int32_t frro_iter_id_ = 0;
@@ -104,7 +109,15 @@ class Idmap2Service : public BinderService<Idmap2Service>, public BnIdmap2 {
   template <typename T>
   using OwningPtr = std::variant<std::unique_ptr<T>, std::shared_ptr<T>>;
 
-  binder::Status verifyOrCreateIdmap(const os::IdmapParams& params,
+  // createIdmap() with the uid of the caller, which is only known on the binder thread.
+  binder::Status createIdmapAs(uid_t uid, const std::string& target_path,
+                               const std::string& overlay_path, const std::string& overlay_name,
+                               int32_t fulfilled_policies, bool enforce_overlayable,
+                               int32_t user_id,
+                               const std::vector<os::OverlayConstraint>& constraints,
+                               std::optional<std::string>* _aidl_return);
+
+  binder::Status verifyOrCreateIdmap(uid_t uid, const os::IdmapParams& params,
                                      std::optional<std::string>* _aidl_return);
 
   using TargetResourceContainerPtr = OwningPtr<idmap2::TargetResourceContainer>;
@@ -26,6 +26,7 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -93,6 +94,10 @@ struct FabricatedOverlay {
   Result<Unit> ToBinaryStream(std::ostream& stream) const;
   static Result<FabricatedOverlay> FromBinaryStream(std::istream& stream);
 
+  // Like FromBinaryStream(), for a fabricated overlay in memory, such as a mapped frro file. The
+  // binary files that it embeds are skipped without being read.
+  static Result<FabricatedOverlay> FromBinaryData(std::string_view data);
+
  private:
   struct SerializedData {
     std::unique_ptr<uint8_t[]> pb_data;
@@ -16,11 +16,15 @@
 
 #include "idmap2/FabricatedOverlay.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>   // umask
 #include <sys/types.h>  // umask
 
 #include <android-base/file.h>
+#include <android-base/mapped_file.h>
 #include <android-base/strings.h>
+#include <android-base/unique_fd.h>
 #include <androidfw/BigBuffer.h>
 #include <androidfw/BigBufferStream.h>
 #include <androidfw/FileStream.h>
@@ -35,6 +39,8 @@
 #include <utils/ByteOrder.h>
 #include <zlib.h>
 
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <map>
 #include <memory>
@@ -55,6 +61,17 @@ bool Read32(std::istream& stream, uint32_t* out) {
   return false;
 }
 
+bool Read32(std::string_view* data, uint32_t* out) {
+  uint32_t value;
+  if (data->size() < sizeof(uint32_t)) {
+    return false;
+  }
+  memcpy(&value, data->data(), sizeof(uint32_t));
+  data->remove_prefix(sizeof(uint32_t));
+  *out = dtohl(value);
+  return true;
+}
+
 void Write32(std::ostream& stream, uint32_t value) {
   uint32_t x = htodl(value);
   stream.write(reinterpret_cast<char*>(&x), sizeof(uint32_t));
@@ -333,7 +350,7 @@ Result<FabricatedOverlay> FabricatedOverlay::FromBinaryStream(std::istream& stre
     if (!stream.read(buf.data(), sp_size)) {
       return Error("Failed to read string pool.");
     }
-    sp_data = buf;
+    sp_data = std::move(buf);
   }
   if (!overlay.ParseFromIstream(&stream)) {
     return Error("Failed read fabricated overlay proto.");
@@ -348,6 +365,62 @@ Result<FabricatedOverlay> FabricatedOverlay::FromBinaryStream(std::istream& stre
                                                    : std::nullopt);
 }
 
+Result<FabricatedOverlay> FabricatedOverlay::FromBinaryData(std::string_view data) {
+  uint32_t magic;
+  if (!Read32(&data, &magic)) {
+    return Error("Failed to read fabricated overlay magic.");
+  }
+
+  if (magic != kFabricatedOverlayMagic) {
+    return Error("Not a fabricated overlay file.");
+  }
+
+  uint32_t version;
+  if (!Read32(&data, &version)) {
+    return Error("Failed to read fabricated overlay version.");
+  }
+
+  if (version < 1 || version > 3) {
+    return Error("Invalid fabricated overlay version '%u'.", version);
+  }
+
+  uint32_t crc;
+  if (!Read32(&data, &crc)) {
+    return Error("Failed to read fabricated overlay crc.");
+  }
+
+  uint32_t total_binary_bytes = 0;
+  if (version == 3) {
+    if (!Read32(&data, &total_binary_bytes) || data.size() < total_binary_bytes) {
+      return Error("Failed read total binary bytes.");
+    }
+    data.remove_prefix(total_binary_bytes);
+  }
+  std::string sp_data;
+  if (version >= 2) {
+    uint32_t sp_size;
+    if (!Read32(&data, &sp_size)) {
+      return Error("Failed read string pool size.");
+    }
+    if (data.size() < sp_size) {
+      return Error("Failed to read string pool.");
+    }
+    sp_data.assign(data.data(), sp_size);
+    data.remove_prefix(sp_size);
+  }
+
+  pb::FabricatedOverlay overlay{};
+  if (!overlay.ParseFromArray(data.data(), data.size())) {
+    return Error("Failed read fabricated overlay proto.");
+  }
+
+  // See FromBinaryStream().
+  return FabricatedOverlay(std::move(overlay), std::move(sp_data), {}, total_binary_bytes,
+                           version == kFabricatedOverlayCurrentVersion
+                                                   ? std::optional<uint32_t>(crc)
+                                                   : std::nullopt);
+}
+
 Result<FabricatedOverlay::SerializedData*> FabricatedOverlay::InitializeData() const {
   if (!data_.has_value()) {
     auto pb_size = overlay_pb_.ByteSizeLong();
@@ -422,8 +495,25 @@ FabContainer::FabricatedOverlayContainer(FabricatedOverlay&& overlay, std::strin
 FabContainer::~FabricatedOverlayContainer() = default;
 
 Result<std::unique_ptr<FabContainer>> FabContainer::FromPath(std::string path) {
-  std::fstream fin(path);
-  auto overlay = FabricatedOverlay::FromBinaryStream(fin);
+  // Mapped rather than read, so that the pages of the binary files embedded before the proto,
+  // which can be most of the file, are never read.
+  base::unique_fd fd(TEMP_FAILURE_RETRY(open(path.c_str(), O_RDONLY | O_CLOEXEC)));
+  if (fd < 0) {
+    return Error("Failed to open '%s': %s", path.c_str(), strerror(errno));
+  }
+  struct stat st = {};
+  if (fstat(fd, &st) != 0) {
+    return Error("Failed to stat '%s': %s", path.c_str(), strerror(errno));
+  }
+  std::unique_ptr<base::MappedFile> map;
+  if (st.st_size > 0) {
+    map = base::MappedFile::FromFd(fd, 0, st.st_size, PROT_READ);
+    if (map == nullptr) {
+      return Error("Failed to map '%s': %s", path.c_str(), strerror(errno));
+    }
+  }
+  auto overlay = FabricatedOverlay::FromBinaryData(
+      map ? std::string_view(map->data(), map->size()) : std::string_view());
   if (!overlay) {
     return overlay.GetError();
   }
@@ -19,6 +19,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -339,6 +340,13 @@ struct ApkResourceContainer : public TargetResourceContainer, public OverlayReso
 
   mutable std::mutex state_lock_;
   mutable std::variant<std::unique_ptr<ZipAssetsProvider>, ResState> state_;
+  // The AssetManager2 caches what it resolves, and idmap2d shares the container of a target
+  // between the threads creating the idmaps of its overlays.
+  mutable std::mutex am_lock_;
+  // The ids that GetResourceId() found, guarded by am_lock_. idmap2d keeps the containers of the
+  // targets it was recently asked about, so the same names are looked up whenever the overlays of
+  // a target, such as the fabricated overlays of a theme, are updated.
+  mutable std::unordered_map<std::string, ResourceId> resource_ids_;
   std::string path_;
 };
 
@@ -408,6 +416,7 @@ Result<OverlayData> ApkResourceContainer::GetOverlayData(const OverlayManifestIn
     return state.GetError();
   }
 
+  std::lock_guard lock(am_lock_);
   if (info.resource_mapping != 0) {
     return CreateResourceMapping(info.resource_mapping, GetZipAssets(), (*state)->am.get(),
                                  (*state)->arsc, (*state)->package);
@@ -428,13 +437,19 @@ Result<ResourceId> ApkResourceContainer::GetResourceId(const std::string& name)
   if (!state) {
     return state.GetError();
   }
+  std::lock_guard lock(am_lock_);
+  if (auto cached = resource_ids_.find(name); cached != resource_ids_.end()) {
+    return cached->second;
+  }
   auto id = (*state)->am->GetResourceId(name, "", (*state)->package->GetPackageName());
   if (!id.has_value()) {
     return Error("failed to find resource '%s'", name.c_str());
   }
 
   // Retrieve the compile-time resource id of the target resource.
-  return REWRITE_PACKAGE(*id, (*state)->package->GetPackageId());
+  const ResourceId resid = REWRITE_PACKAGE(*id, (*state)->package->GetPackageId());
+  resource_ids_.emplace(name, resid);
+  return resid;
 }
 
 Result<std::string> ApkResourceContainer::GetResourceName(ResourceId id) const {
@@ -442,6 +457,7 @@ Result<std::string> ApkResourceContainer::GetResourceName(ResourceId id) const {
   if (!state) {
     return state.GetError();
   }
+  std::lock_guard lock(am_lock_);
   return utils::ResToTypeEntryName(*(*state)->am, id);
 }
 
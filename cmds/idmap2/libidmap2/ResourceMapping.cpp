@@ -20,7 +20,10 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "android-base/stringprintf.h"
@@ -122,29 +125,47 @@ Result<ResourceMapping> ResourceMapping::FromContainers(const TargetResourceCont
     return overlay_data.GetError();
   }
 
-  ResourceMapping mapping;
-  for (const auto& overlay_pair : overlay_data->pairs) {
-    const auto target_resid = target.GetResourceId(overlay_pair.resource_name);
+  // Looks up the target resource of a name and checks that the overlay may overlay it, returning
+  // the warning to log if not.
+  const auto check_target_resource =
+      [&](const std::string& name) -> std::variant<ResourceId, std::string> {
+    const auto target_resid = target.GetResourceId(name);
     if (!target_resid) {
-      log_info.Warning(LogMessage() << target_resid.GetErrorMessage());
-      continue;
+      return target_resid.GetErrorMessage();
     }
 
     if (enforce_overlayable) {
       // Filter out resources the overlay is not allowed to override.
       auto overlayable = CheckOverlayable(target, overlay_info, fulfilled_policies, *target_resid);
       if (!overlayable) {
-        log_info.Warning(LogMessage() << "overlay '" << overlay.GetPath()
-                                      << "' is not allowed to overlay resource '"
-                                      << GetDebugResourceName(target, *target_resid)
-                                      << "' in target: " << overlayable.GetErrorMessage());
-        continue;
+        return (LogMessage() << "overlay '" << overlay.GetPath()
+                             << "' is not allowed to overlay resource '"
+                             << GetDebugResourceName(target, *target_resid)
+                             << "' in target: " << overlayable.GetErrorMessage())
+            .GetString();
       }
     }
+    return *target_resid;
+  };
+
+  // A fabricated overlay has an entry per configuration of each resource it overlays, and a name
+  // only needs to be looked up and checked once.
+  std::unordered_map<std::string_view, std::variant<ResourceId, std::string>> checked_names;
+  ResourceMapping mapping;
+  for (const auto& overlay_pair : overlay_data->pairs) {
+    auto [checked, inserted] = checked_names.try_emplace(overlay_pair.resource_name);
+    if (inserted) {
+      checked->second = check_target_resource(overlay_pair.resource_name);
+    }
+    if (const auto warning = std::get_if<std::string>(&checked->second)) {
+      log_info.Warning(LogMessage() << *warning);
+      continue;
+    }
+    const ResourceId target_resid = std::get<ResourceId>(checked->second);
 
-    if (auto result = mapping.AddMapping(*target_resid, overlay_pair.value); !result) {
+    if (auto result = mapping.AddMapping(target_resid, overlay_pair.value); !result) {
       return Error(result.GetError(), "failed to add mapping for '%s'",
-                   GetDebugResourceName(target, *target_resid).c_str());
+                   GetDebugResourceName(target, target_resid).c_str());
     }
   }
 
@@ -20,6 +20,7 @@
 #include "TestHelpers.h"
 
 #include <fstream>
+#include <sstream>
 #include <utility>
 
 namespace android::idmap2 {
@@ -183,4 +184,27 @@ TEST(FabricatedOverlayTests, SerializeAndDeserialize) {
   ASSERT_EQ(std::string("foobar"), string_pool.string8At(entry->value.data_value).value_or(""));
 }
 
+TEST(FabricatedOverlayTests, DeserializeFromData) {
+  auto overlay =
+      FabricatedOverlay::Builder("com.example.overlay", "SandTheme", "com.example.target")
+          .SetOverlayable("TestResources")
+          .SetResourceValue("com.example.target:integer/int1", Res_value::TYPE_INT_DEC, 1U, "")
+          .Build();
+  ASSERT_TRUE(overlay);
+  std::stringstream stream;
+  ASSERT_TRUE((*overlay).ToBinaryStream(stream));
+  const std::string data = stream.str();
+
+  auto loaded = FabricatedOverlay::FromBinaryData(data);
+  ASSERT_TRUE(loaded) << loaded.GetErrorMessage();
+  auto container = FabricatedOverlayContainer::FromOverlay(std::move(*loaded));
+  auto info = container->GetManifestInfo();
+  EXPECT_EQ("com.example.overlay", info.package_name);
+  EXPECT_EQ("SandTheme", info.name);
+  EXPECT_EQ("TestResources", info.target_name);
+
+  EXPECT_FALSE(FabricatedOverlay::FromBinaryData(std::string_view(data).substr(0, 10)));
+  EXPECT_FALSE(FabricatedOverlay::FromBinaryData("not a fabricated overlay"));
+}
+
 }  // namespace android::idmap2
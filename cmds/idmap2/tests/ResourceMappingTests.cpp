@@ -243,6 +243,36 @@ TEST(ResourceMappingTests, FabricatedOverlay) {
   ASSERT_RESULT(MappingExists(res, R::target::integer::int1, Res_value::TYPE_INT_DEC, 2U));
 }
 
+TEST(ResourceMappingTests, FabricatedOverlayWithSeveralConfigurations) {
+  auto frro = FabricatedOverlay::Builder("com.example.overlay", "SandTheme", "test.target")
+                  .SetOverlayable("TestResources")
+                  .SetResourceValue("integer/int1", Res_value::TYPE_INT_DEC, 2U, "")
+                  .SetResourceValue("integer/int1", Res_value::TYPE_INT_DEC, 3U, "land")
+                  .SetResourceValue("integer/int1", Res_value::TYPE_INT_DEC, 4U, "port")
+                  .SetResourceValue("integer/does_not_exist", Res_value::TYPE_INT_DEC, 5U, "")
+                  .SetResourceValue("integer/does_not_exist", Res_value::TYPE_INT_DEC, 6U, "land")
+                  .setFrroPath("/foo/bar/biz.frro")
+                  .Build();
+
+  ASSERT_TRUE(frro);
+  TempFrroFile tf;
+  std::ofstream out(tf.path);
+  ASSERT_TRUE((*frro).ToBinaryStream(out));
+  out.close();
+
+  auto resources = TestGetResourceMapping("target/target.apk", tf.path, "SandTheme",
+                                          PolicyFlags::PUBLIC, /* enforce_overlayable */ false);
+
+  ASSERT_TRUE(resources) << resources.GetErrorMessage();
+  auto& res = *resources;
+  ASSERT_EQ(res.GetTargetToOverlayMap().size(), 1U);
+  auto entry = res.GetTargetToOverlayMap().find(R::target::integer::int1);
+  ASSERT_NE(entry, res.GetTargetToOverlayMap().end());
+  auto config_map = std::get_if<ConfigMap>(&entry->second);
+  ASSERT_NE(config_map, nullptr);
+  EXPECT_EQ(config_map->size(), 3U);
+}
+
 TEST(ResourceMappingTests, CreateIdmapFromApkAssetsPolicySystemPublic) {
   auto resources = TestGetResourceMapping("target/target.apk", "overlay/overlay.apk",
                                           TestConstants::OVERLAY_NAME_ALL_POLICIES,
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <sstream>
+#include <string.h>
 #include <unistd.h>
 
 bool isValidChar(char c) {
@@ -78,6 +79,18 @@ static void split(const std::string& line, std::vector<std::string>& words,
     }
 }
 
+// Assigns line[begin, end) without the default whitespace around it to the index-th word,
+// reusing the storage of the word that was there.
+static void setTrimmedWord(std::vector<std::string>* words, size_t index, const std::string& line,
+        size_t begin, size_t end) {
+    while (begin < end && DEFAULT_WHITESPACE.find(line[begin]) != std::string::npos) begin++;
+    while (end > begin && DEFAULT_WHITESPACE.find(line[end - 1]) != std::string::npos) end--;
+    if (index == words->size()) {
+        words->emplace_back();
+    }
+    (*words)[index].assign(line, begin, end - begin);
+}
+
 header_t parseHeader(const std::string& line, const std::string& delimiters) {
     header_t header;
     trans_func f = &trimHeader;
@@ -87,11 +100,28 @@ header_t parseHeader(const std::string& line, const std::string& delimiters) {
 
 record_t parseRecord(const std::string& line, const std::string& delimiters) {
     record_t record;
-    trans_func f = &trimDefault;
-    split(line, record, f, delimiters);
+    parseRecord(line, &record, delimiters);
     return record;
 }
 
+void parseRecord(const std::string& line, record_t* record, const std::string& delimiters) {
+    size_t count = 0;
+    size_t base = 0;
+    while (true) {
+        size_t found = line.find_first_of(delimiters, base);
+        size_t end = found == std::string::npos ? line.size() : found;
+        if (end != base) {
+            setTrimmedWord(record, count, line, base, end);
+            if (!(*record)[count].empty()) {
+                count++;
+            }
+        }
+        if (found == std::string::npos) break;
+        base = found + 1;
+    }
+    record->resize(count);
+}
+
 bool getColumnIndices(std::vector<int>& indices, const char** headerNames, const std::string& line) {
     indices.clear();
 
@@ -114,6 +144,12 @@ bool getColumnIndices(std::vector<int>& indices, const char** headerNames, const
 
 record_t parseRecordByColumns(const std::string& line, const std::vector<int>& indices, const std::string& delimiters) {
     record_t record;
+    parseRecordByColumns(line, indices, &record, delimiters);
+    return record;
+}
+
+void parseRecordByColumns(const std::string& line, const std::vector<int>& indices, record_t* record, const std::string& delimiters) {
+    size_t count = 0;
     int lastIndex = 0;
     int lastBeginning = 0;
     int lineSize = (int)line.size();
@@ -132,25 +168,25 @@ record_t parseRecordByColumns(const std::string& line, const std::vector<int>& i
             }
             // If we're past the end of the line AND we've already saved everything up to the end.
             fprintf(stderr, "index wrong: lastIndex: %d, idx: %d, lineSize: %d\n", lastIndex, idx, lineSize);
-            record.clear(); // The indices are wrong, return empty.
-            return record;
+            record->clear(); // The indices are wrong, return empty.
+            return;
         }
         while (idx < lineSize && delimiters.find(line[idx++]) == std::string::npos);
-        record.push_back(trimDefault(line.substr(lastIndex, idx - lastIndex)));
+        setTrimmedWord(record, count++, line, lastIndex, idx);
         lastBeginning = lastIndex;
         lastIndex = idx;
     }
     if (lineSize - lastIndex > 0) {
         int beginning = lastIndex;
-        if (record.size() == indices.size() && !record.empty()) {
+        if (count == indices.size() && count != 0) {
             // We've already encountered all of the columns...put whatever is
             // left in the last column.
-            record.pop_back();
+            count--;
             beginning = lastBeginning;
         }
-        record.push_back(trimDefault(line.substr(beginning, lineSize - beginning)));
+        setTrimmedWord(record, count++, line, beginning, lineSize);
     }
-    return record;
+    record->resize(count);
 }
 
 void printRecord(const record_t& record) {
@@ -237,24 +273,29 @@ double toDouble(const std::string& s) {
 Reader::Reader(const int fd)
 {
     mFile = fdopen(fd, "r");
-    mBuffer = new char[1024];
+    // getline() reallocs the buffer when a line doesn't fit.
+    mBufferSize = 1024;
+    mBuffer = (char*)malloc(mBufferSize);
     mStatus = mFile == nullptr ? "Invalid fd " + std::to_string(fd) : "";
 }
 
 Reader::~Reader()
 {
     if (mFile != nullptr) fclose(mFile);
-    delete[] mBuffer;
+    free(mBuffer);
 }
 
 bool Reader::readLine(std::string* line) {
     if (mFile == nullptr) return false;
 
-    size_t len = 0;
-    ssize_t read = getline(&mBuffer, &len, mFile);
+    ssize_t read = getline(&mBuffer, &mBufferSize, mFile);
     if (read != -1) {
-        std::string s(mBuffer);
-        line->assign(trim(s, DEFAULT_NEWLINE));
+        // Trims the newlines in place, the line is only copied once.
+        size_t begin = 0;
+        size_t end = strnlen(mBuffer, read);
+        while (begin < end && DEFAULT_NEWLINE.find(mBuffer[begin]) != std::string::npos) begin++;
+        while (end > begin && DEFAULT_NEWLINE.find(mBuffer[end - 1]) != std::string::npos) end--;
+        line->assign(mBuffer + begin, end - begin);
         return true;
     }
     if (!feof(mFile)) {
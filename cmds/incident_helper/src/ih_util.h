@@ -57,6 +57,12 @@ std::string trim(const std::string& s, const std::string& charset);
 header_t parseHeader(const std::string& line, const std::string& delimiters = DEFAULT_WHITESPACE);
 record_t parseRecord(const std::string& line, const std::string& delimiters = DEFAULT_WHITESPACE);
 
+/**
+ * Same as parseRecord, but fills in the given record, reusing the strings it already has.
+ * Parsers should keep one record for all of the lines of a table so they don't allocate per line.
+ */
+void parseRecord(const std::string& line, record_t* record, const std::string& delimiters = DEFAULT_WHITESPACE);
+
 /**
  * Gets the list of end indices of each word in the line and places it in the given vector,
  * clearing out the vector beforehand. These indices can be used with parseRecordByColumns.
@@ -72,6 +78,11 @@ bool getColumnIndices(std::vector<int>& indices, const char* headerNames[], cons
  */
 record_t parseRecordByColumns(const std::string& line, const std::vector<int>& indices, const std::string& delimiters = DEFAULT_WHITESPACE);
 
+/**
+ * Same as parseRecordByColumns, but fills in the given record, reusing the strings it already has.
+ */
+void parseRecordByColumns(const std::string& line, const std::vector<int>& indices, record_t* record, const std::string& delimiters = DEFAULT_WHITESPACE);
+
 /** Prints record_t to stderr */
 void printRecord(const record_t& record);
 
@@ -118,6 +129,7 @@ public:
 private:
     FILE* mFile;
     char* mBuffer;
+    size_t mBufferSize;
     std::string mStatus;
 };
 
@@ -41,10 +41,11 @@ CpuFreqParser::Parse(const int in, const int out) const
     vector<pair<int, long long>> cpucores[numCpus];
 
     // parse freq and time
+    record_t record;
     while (reader.readLine(&line)) {
         if (line.empty()) continue;
 
-        record_t record = parseRecord(line, TAB_DELIMITER);
+        parseRecord(line, &record, TAB_DELIMITER);
         if (record.size() != header.size()) {
             fprintf(stderr, "Bad line: %s\n", line.c_str());
             continue;
@@ -127,7 +127,7 @@ CpuInfoParser::Parse(const int in, const int out) const
             continue;
         }
 
-        record = parseRecordByColumns(line, columnIndices);
+        parseRecordByColumns(line, columnIndices, &record);
         diff = record.size() - header.size();
         if (diff < 0) {
             fprintf(stderr, "[%s]Line %d has %d missing fields\n%s\n", this->name.c_str(), nline, -diff, line.c_str());
@@ -47,7 +47,7 @@ KernelWakesParser::Parse(const int in, const int out) const
         }
 
         // parse for each record, the line delimiter is \t only!
-        record = parseRecord(line, TAB_DELIMITER);
+        parseRecord(line, &record, TAB_DELIMITER);
 
         if (record.size() < header.size()) {
             // TODO: log this to incident report!
@@ -55,7 +55,7 @@ ProcrankParser::Parse(const int in, const int out) const
             continue;
         }
 
-        record = parseRecord(line);
+        parseRecord(line, &record);
         if (record.size() != header.size()) {
             if (record[record.size() - 1] == "TOTAL") { // TOTAL record
                 total = line;
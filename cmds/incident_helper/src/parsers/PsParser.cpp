@@ -56,7 +56,7 @@ status_t PsParser::Parse(const int in, const int out) const {
             continue;
         }
 
-        record = parseRecordByColumns(line, columnIndices);
+        parseRecordByColumns(line, columnIndices, &record);
 
         diff = record.size() - header.size();
         if (diff < 0) {
@@ -99,6 +99,28 @@ TEST(IhUtilTest, ParseRecordByColumns) {
     EXPECT_EQ(expected, result);
 }
 
+TEST(IhUtilTest, ParseRecordReusesRecord) {
+    record_t record = { "left", "over", "from", "a", "longer", "line" };
+    parseRecord(" \t 100 00\toooh \t wqrw", &record);
+    record_t expected = { "100", "00", "oooh", "wqrw" };
+    EXPECT_EQ(expected, record);
+
+    parseRecord(" \t \t\t ", &record);
+    EXPECT_TRUE(record.empty());
+
+    std::vector<int> indices = { 3, 10 };
+    parseRecordByColumns("abc \t2345  6789 ", indices, &record);
+    expected = { "abc", "2345  6789" };
+    EXPECT_EQ(expected, record);
+
+    parseRecordByColumns("abcdefgt\t     bob", indices, &record);
+    expected = { "abcdefgt", "bob" };
+    EXPECT_EQ(expected, record);
+
+    parseRecordByColumns("12345", indices, &record);
+    EXPECT_TRUE(record.empty());
+}
+
 TEST(IhUtilTest, stripPrefix) {
     string data1 = "Swap: abc ";
     EXPECT_TRUE(stripPrefix(&data1, "Swap:"));
@@ -168,6 +190,25 @@ TEST(IhUtilTest, Reader) {
     ASSERT_TRUE(r.ok(&line));
 }
 
+TEST(IhUtilTest, ReaderLongLines) {
+    TemporaryFile tf;
+    ASSERT_NE(tf.fd, -1);
+    // Longer than the initial buffer of the reader.
+    string longLine(5000, 'x');
+    ASSERT_TRUE(WriteStringToFile(longLine + "\r\nshort\n" + longLine, tf.path));
+
+    Reader r(tf.fd);
+    string line;
+    ASSERT_TRUE(r.readLine(&line));
+    EXPECT_EQ(longLine, line);
+    ASSERT_TRUE(r.readLine(&line));
+    EXPECT_THAT(line, StrEq("short"));
+    ASSERT_TRUE(r.readLine(&line));
+    EXPECT_EQ(longLine, line);
+    ASSERT_FALSE(r.readLine(&line));
+    ASSERT_TRUE(r.ok(&line));
+}
+
 TEST(IhUtilTest, ReaderEmpty) {
     TemporaryFile tf;
     ASSERT_NE(tf.fd, -1);
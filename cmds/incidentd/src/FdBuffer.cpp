@@ -32,6 +32,7 @@ namespace os {
 namespace incidentd {
 
 const ssize_t BUFFER_SIZE = 16 * 1024;  // 16 KB
+const size_t SPLICE_SIZE = 64 * 1024;  // 64 KB, the default capacity of a pipe
 const ssize_t MAX_BUFFER_SIZE = 96 * 1024 * 1024;  // 96 MB
 
 FdBuffer::FdBuffer(): FdBuffer(get_buffer_from_pool(), /* isBufferPooled= */ true)  {
@@ -157,10 +158,12 @@ status_t FdBuffer::readProcessedDataInStream(int fd, unique_fd toFd, unique_fd f
     fcntl(toFd.get(), F_SETFL, fcntl(toFd.get(), F_GETFL, 0) | O_NONBLOCK);
     fcntl(fromFd.get(), F_SETFL, fcntl(fromFd.get(), F_GETFL, 0) | O_NONBLOCK);
 
-    // A circular buffer holds data read from fd and writes to parsing process
+    // A circular buffer holds data read from fd and writes to parsing process, unless
+    // the kernel can move the data from fd into the pipe of the parsing process itself.
     uint8_t cirBuf[BUFFER_SIZE];
     size_t cirSize = 0;
     int rpos = 0, wpos = 0;
+    bool useSplice = true;
 
     // This is the buffer used to store processed data
     while (true) {
@@ -204,8 +207,28 @@ status_t FdBuffer::readProcessedDataInStream(int fd, unique_fd toFd, unique_fd f
             }
         }
 
+        // splice from fd to parsing process
+        if (useSplice && pfds[0].fd != -1) {
+            ssize_t amt = TEMP_FAILURE_RETRY(splice(fd, NULL, toFd.get(), NULL, SPLICE_SIZE,
+                                                    SPLICE_F_MOVE | SPLICE_F_NONBLOCK));
+            if (amt < 0) {
+                if (errno == EINVAL || errno == ENOSYS) {
+                    // Not every file supports it, e.g. some of procfs and sysfs, and nothing
+                    // was moved in that case.
+                    VLOG("Can't splice fd %d, copying it instead", fd);
+                    useSplice = false;
+                } else if (!(errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    VLOG("Fail to splice fd %d to toFd %d: %s", fd, toFd.get(), strerror(errno));
+                    return -errno;
+                }  // otherwise just continue
+            } else if (amt == 0) {
+                VLOG("Reached EOF of input file %d", fd);
+                pfds[0].fd = -1;  // reach EOF so don't have to poll pfds[0].
+            }
+        }
+
         // read from fd
-        if (cirSize != BUFFER_SIZE && pfds[0].fd != -1) {
+        if (!useSplice && cirSize != BUFFER_SIZE && pfds[0].fd != -1) {
             ssize_t amt;
             if (rpos >= wpos) {
                 amt = TEMP_FAILURE_RETRY(::read(fd, cirBuf + rpos, BUFFER_SIZE - rpos));
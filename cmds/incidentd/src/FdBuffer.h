@@ -56,7 +56,8 @@ public:
      * The parsing process provides IO fds which are 'toFd' and 'fromFd'. The function
      * reads original data in 'fd' and writes to parsing process through 'toFd', then it reads
      * and stores the processed data from 'fromFd' in memory for later usage.
-     * This function behaves in a streaming fashion in order to save memory usage.
+     * This function behaves in a streaming fashion in order to save memory usage, and
+     * splices the original data into 'toFd' when fd supports it, so it isn't copied.
      * Returns NO_ERROR if there were no errors or if we timed out.
      *
      * Poll will return POLLERR if fd is from sysfs, handle this edge case.
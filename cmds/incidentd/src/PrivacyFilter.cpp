@@ -26,6 +26,10 @@
 #include <android/util/ProtoFileReader.h>
 #include <log/log.h>
 
+#include <algorithm>
+#include <memory>
+#include <unistd.h>
+
 namespace android {
 namespace os {
 namespace incidentd {
@@ -70,25 +74,92 @@ void write_field_or_skip(ProtoOutputStream* out, const sp<ProtoReader>& in,
     }
     if (skip) {
         in->move(bytesToWrite);
-    } else {
-        for (size_t i = 0; i < bytesToWrite; i++) {
-            out->writeRawByte(in->next());
+        return;
+    }
+    uint8_t const* span;
+    size_t amt;
+    while (bytesToWrite > 0 && (amt = in->readSpan(bytesToWrite, &span)) > 0) {
+        out->writeRaw(span, amt);
+        bytesToWrite -= amt;
+    }
+}
+
+/**
+ * One of the privacy policies that strip_field filters the data to, in the same pass.
+ */
+struct StripTarget {
+    PrivacySpec spec;
+    ProtoOutputStream* out;
+};
+
+/**
+ * Write the field to each of the targets whose bit is set in mask based on the wire type,
+ * iterator will point to next field. The field is read only once, however many targets
+ * it is written to.
+ */
+void write_field_to_targets(const vector<StripTarget>& targets, uint32_t mask,
+        const sp<ProtoReader>& in, uint32_t fieldTag) {
+    if (mask == 0) {
+        write_field_or_skip(NULL, in, fieldTag, true);
+        return;
+    }
+    uint8_t wireType = read_wire_type(fieldTag);
+    size_t bytesToWrite = 0;
+
+    switch (wireType) {
+        case WIRE_TYPE_VARINT: {
+            uint64_t varint = in->readRawVarint();
+            for (size_t i = 0; i < targets.size(); i++) {
+                if ((mask & (1u << i)) != 0) {
+                    targets[i].out->writeRawVarint(fieldTag);
+                    targets[i].out->writeRawVarint(varint);
+                }
+            }
+            return;
         }
+        case WIRE_TYPE_LENGTH_DELIMITED:
+            bytesToWrite = in->readRawVarint();
+            for (size_t i = 0; i < targets.size(); i++) {
+                if ((mask & (1u << i)) != 0) {
+                    targets[i].out->writeLengthDelimitedHeader(read_field_id(fieldTag),
+                            bytesToWrite);
+                }
+            }
+            break;
+        case WIRE_TYPE_FIXED64:
+        case WIRE_TYPE_FIXED32:
+            for (size_t i = 0; i < targets.size(); i++) {
+                if ((mask & (1u << i)) != 0) {
+                    targets[i].out->writeRawVarint(fieldTag);
+                }
+            }
+            bytesToWrite = wireType == WIRE_TYPE_FIXED64 ? 8 : 4;
+            break;
+    }
+    uint8_t const* span;
+    size_t amt;
+    while (bytesToWrite > 0 && (amt = in->readSpan(bytesToWrite, &span)) > 0) {
+        for (size_t i = 0; i < targets.size(); i++) {
+            if ((mask & (1u << i)) != 0) {
+                targets[i].out->writeRaw(span, amt);
+            }
+        }
+        bytesToWrite -= amt;
     }
 }
 
 /**
- * Strip next field based on its private policy and request spec, then stores data in buf.
- * Return NO_ERROR if succeeds, otherwise BAD_VALUE is returned to indicate bad data in
- * FdBuffer.
+ * Strip next field based on its private policy and the spec of each target, then stores
+ * data in the target's buf. Return NO_ERROR if succeeds, otherwise BAD_VALUE is returned
+ * to indicate bad data in FdBuffer.
  *
  * The iterator must point to the head of a protobuf formatted field for successful operation.
  * After exit with NO_ERROR, iterator points to the next protobuf field's head.
  *
  * depth is the depth of recursion, for debugging.
  */
-status_t strip_field(ProtoOutputStream* out, const sp<ProtoReader>& in,
-        const Privacy* parentPolicy, const PrivacySpec& spec, int depth) {
+status_t strip_field(const vector<StripTarget>& targets, const sp<ProtoReader>& in,
+        const Privacy* parentPolicy, int depth) {
     if (!in->hasNext() || parentPolicy == NULL) {
         return BAD_VALUE;
     }
@@ -97,18 +168,25 @@ status_t strip_field(ProtoOutputStream* out, const sp<ProtoReader>& in,
     const Privacy* policy = lookup(parentPolicy, fieldId);
 
     if (policy == NULL || policy->children == NULL) {
-        bool skip = !spec.CheckPremission(policy, parentPolicy->policy);
+        uint32_t mask = 0;
+        for (size_t i = 0; i < targets.size(); i++) {
+            if (targets[i].spec.CheckPremission(policy, parentPolicy->policy)) {
+                mask |= 1u << i;
+            }
+        }
         // iterator will point to head of next field
-        size_t currentAt = in->bytesRead();
-        write_field_or_skip(out, in, fieldTag, skip);
+        write_field_to_targets(targets, mask, in, fieldTag);
         return NO_ERROR;
     }
     // current field is message type and its sub-fields have extra privacy policies
     uint32_t msgSize = in->readRawVarint();
     size_t start = in->bytesRead();
-    uint64_t token = out->start(encode_field_id(policy));
+    vector<uint64_t> tokens(targets.size());
+    for (size_t i = 0; i < targets.size(); i++) {
+        tokens[i] = targets[i].out->start(encode_field_id(policy));
+    }
     while (in->bytesRead() - start != msgSize) {
-        status_t err = strip_field(out, in, policy, spec, depth + 1);
+        status_t err = strip_field(targets, in, policy, depth + 1);
         if (err != NO_ERROR) {
             ALOGW("Bad value when stripping id %d, wiretype %d, tag %#x, depth %d, size %d, "
                     "relative pos %zu, ", fieldId, read_wire_type(fieldTag), fieldTag, depth,
@@ -116,33 +194,36 @@ status_t strip_field(ProtoOutputStream* out, const sp<ProtoReader>& in,
             return err;
         }
     }
-    out->end(token);
+    for (size_t i = 0; i < targets.size(); i++) {
+        targets[i].out->end(tokens[i]);
+    }
     return NO_ERROR;
 }
 
 // ================================================================================
 class FieldStripper {
 public:
-    FieldStripper(const Privacy* restrictions, const sp<ProtoReader>& data,
+    FieldStripper(const Privacy* restrictions, const sp<EncodedBuffer>& data,
             uint8_t bufferLevel);
 
     ~FieldStripper();
 
     /**
-     * Take the data that we have, and filter it down so that no fields
-     * are more sensitive than the given privacy policy.
+     * Take the data that we have, and filter it down to each of the given privacy
+     * policies, so that no fields are more sensitive than the policy.  The data is
+     * parsed once for all of them.
      */
-    status_t strip(uint8_t privacyPolicy);
+    status_t strip(const vector<uint8_t>& privacyPolicies);
 
     /**
-     * At the current filter level, how many bytes of data there is.
+     * At the filter level of the privacy policy, how many bytes of data there is.
      */
-    ssize_t dataSize() const { return mSize; }
+    ssize_t dataSize(uint8_t privacyPolicy) const;
 
     /**
-     * Write the data from the current filter level to the file descriptor.
+     * Write the data from the filter level of the privacy policy to the file descriptor.
      */
-    status_t writeData(int fd);
+    status_t writeData(uint8_t privacyPolicy, int fd) const;
 
 private:
     /**
@@ -151,86 +232,144 @@ private:
     const Privacy* mRestrictions;
 
     /**
-     * The current buffer.
+     * The original buffer, already filtered to mBufferLevel.
      */
-    sp<ProtoReader> mData;
+    sp<EncodedBuffer> mData;
+    uint8_t mBufferLevel;
 
     /**
-     * The current size of the buffer inside mData.
+     * The data filtered to each of the privacy policies that the original buffer
+     * isn't enough for.  The size stays -1 until the data is filtered to the level.
      */
-    ssize_t mSize;
+    struct Level {
+        uint8_t privacyPolicy;
+        sp<EncodedBuffer> buffer;
+        ssize_t size;
+    };
+    vector<Level> mLevels;
 
     /**
-     * The current privacy policy that the data is filtered to, as an optimization
-     * so we don't always re-filter data that has already been filtered.
+     * The number of privacy policies one pass over the data filters to.
      */
-    uint8_t mCurrentLevel;
+    static constexpr size_t kMaxTargetsPerPass = 32;
 
-    sp<EncodedBuffer> mEncodedBuffer;
+    status_t stripPass(const vector<uint8_t>& privacyPolicies);
+    bool needsStrip() const;
+    bool servedByData(uint8_t privacyPolicy) const;
+    const Level* findLevel(uint8_t privacyPolicy) const;
 };
 
-FieldStripper::FieldStripper(const Privacy* restrictions, const sp<ProtoReader>& data,
+FieldStripper::FieldStripper(const Privacy* restrictions, const sp<EncodedBuffer>& data,
             uint8_t bufferLevel)
         :mRestrictions(restrictions),
          mData(data),
-         mSize(data->size()),
-         mCurrentLevel(bufferLevel),
-         mEncodedBuffer(get_buffer_from_pool()) {
-    if (mSize < 0) {
-        ALOGW("FieldStripper constructed with a ProtoReader that doesn't support size."
-                " Data will be missing.");
-    }
+         mBufferLevel(bufferLevel),
+         mLevels() {
 }
 
 FieldStripper::~FieldStripper() {
-    return_buffer_to_pool(mEncodedBuffer);
+    for (const Level& level : mLevels) {
+        return_buffer_to_pool(level.buffer);
+    }
 }
 
-status_t FieldStripper::strip(const uint8_t privacyPolicy) {
-    // If the current strip level is less (fewer fields retained) than what's already in the
-    // buffer, then we can skip it.
-    if (mCurrentLevel < privacyPolicy) {
-        PrivacySpec spec(privacyPolicy);
-        mEncodedBuffer->clear();
-        ProtoOutputStream proto(mEncodedBuffer);
-
-        // Optimization when no strip happens.
-        if (mRestrictions == NULL || spec.RequireAll()
-                // Do not iterate through fields if primitive data
-                || !mRestrictions->children /* != FieldDescriptor::TYPE_MESSAGE */) {
-            if (spec.CheckPremission(mRestrictions)) {
-                mSize = mData->size();
-            }
-            return NO_ERROR;
+status_t FieldStripper::strip(const vector<uint8_t>& privacyPolicies) {
+    // Optimization when no strip happens.
+    if (!needsStrip()) {
+        return NO_ERROR;
+    }
+
+    vector<uint8_t> pending;
+    for (uint8_t privacyPolicy : privacyPolicies) {
+        if (servedByData(privacyPolicy) || findLevel(privacyPolicy) != NULL
+                || find(pending.begin(), pending.end(), privacyPolicy) != pending.end()) {
+            continue;
         }
+        pending.push_back(privacyPolicy);
+    }
 
-        while (mData->hasNext()) {
-            status_t err = strip_field(&proto, mData, mRestrictions, spec, 0);
-            if (err != NO_ERROR) {
-                return err; // Error logged in strip_field.
-            }
+    // Each pass strips to as many policies as write_field_to_targets has mask bits for.
+    for (size_t first = 0; first < pending.size(); first += kMaxTargetsPerPass) {
+        const size_t last = min(pending.size(), first + kMaxTargetsPerPass);
+        status_t err = stripPass(vector<uint8_t>(pending.begin() + first, pending.begin() + last));
+        if (err != NO_ERROR) {
+            return err;
         }
+    }
+    return NO_ERROR;
+}
 
-        if (mData->bytesRead() != mData->size()) {
-            ALOGW("Buffer corrupted: expect %zu bytes, read %zu bytes", mData->size(),
-                    mData->bytesRead());
-            return BAD_VALUE;
+status_t FieldStripper::stripPass(const vector<uint8_t>& privacyPolicies) {
+    vector<unique_ptr<ProtoOutputStream>> protos;
+    vector<StripTarget> targets;
+    for (uint8_t privacyPolicy : privacyPolicies) {
+        mLevels.push_back({privacyPolicy, get_buffer_from_pool(), -1});
+        protos.emplace_back(new ProtoOutputStream(mLevels.back().buffer));
+        targets.push_back({PrivacySpec(privacyPolicy), protos.back().get()});
+    }
+
+    sp<ProtoReader> reader = mData->read();
+    while (reader->hasNext()) {
+        status_t err = strip_field(targets, reader, mRestrictions, 0);
+        if (err != NO_ERROR) {
+            return err; // Error logged in strip_field.
         }
+    }
 
-        mData = proto.data();
-        mSize = proto.size();
-        mCurrentLevel = privacyPolicy;
+    if (reader->bytesRead() != reader->size()) {
+        ALOGW("Buffer corrupted: expect %zu bytes, read %zu bytes", reader->size(),
+                reader->bytesRead());
+        return BAD_VALUE;
+    }
+
+    const size_t firstLevel = mLevels.size() - protos.size();
+    for (size_t i = 0; i < protos.size(); i++) {
+        mLevels[firstLevel + i].size = protos[i]->size();
     }
     return NO_ERROR;
 }
 
-status_t FieldStripper::writeData(int fd) {
+bool FieldStripper::needsStrip() const {
+    // Do not iterate through fields if primitive data
+    return mRestrictions != NULL && mRestrictions->children /* == FieldDescriptor::TYPE_MESSAGE */;
+}
+
+bool FieldStripper::servedByData(uint8_t privacyPolicy) const {
+    // If the current strip level is less (fewer fields retained) than what's already in
+    // the buffer, then the buffer can be written as is.
+    return !needsStrip() || mBufferLevel >= privacyPolicy
+            || PrivacySpec(privacyPolicy).RequireAll();
+}
+
+const FieldStripper::Level* FieldStripper::findLevel(uint8_t privacyPolicy) const {
+    for (const Level& level : mLevels) {
+        if (level.privacyPolicy == privacyPolicy) {
+            return &level;
+        }
+    }
+    return NULL;
+}
+
+ssize_t FieldStripper::dataSize(uint8_t privacyPolicy) const {
+    if (servedByData(privacyPolicy)) {
+        return mData->size();
+    }
+    // Never hand out the unfiltered data for a policy that wasn't stripped to.
+    const Level* level = findLevel(privacyPolicy);
+    return level != NULL ? level->size : -1;
+}
+
+status_t FieldStripper::writeData(uint8_t privacyPolicy, int fd) const {
     status_t err = NO_ERROR;
-    sp<ProtoReader> reader = mData;
-    if (mData == nullptr) {
-        // There had been an error processing the data. We won't write anything,
-        // but we also won't return an error, because errors are fatal.
-        return NO_ERROR;
+    sp<ProtoReader> reader;
+    if (servedByData(privacyPolicy)) {
+        reader = mData->read();
+    } else {
+        const Level* level = findLevel(privacyPolicy);
+        if (level == NULL || level->size < 0) {
+            return BAD_VALUE;
+        }
+        reader = level->buffer->read();
     }
     while (reader->readBuffer() != NULL) {
         err = WriteFully(fd, reader->readBuffer(), reader->currentToRead()) ? NO_ERROR : -errno;
@@ -272,29 +411,23 @@ status_t PrivacyFilter::writeData(const FdBuffer& buffer, uint8_t bufferLevel,
         *maxSize = 0;
     }
 
-    // Order the writes by privacy filter, with increasing levels of filtration,k
-    // so we can do the filter once, and then write many times.
-    sort(mOutputs.begin(), mOutputs.end(),
-        [](const sp<FilterFd>& a, const sp<FilterFd>& b) -> bool {
-            return a->getPrivacyPolicy() < b->getPrivacyPolicy();
-        });
-
-    uint8_t privacyPolicy = PRIVACY_POLICY_LOCAL; // a.k.a. no filtering
-    FieldStripper fieldStripper(mRestrictions, buffer.data()->read(), bufferLevel);
+    // Filter the data down to all of the privacy policies of the outputs at once, so it
+    // is only parsed once.
+    vector<uint8_t> privacyPolicies;
     for (const sp<FilterFd>& output: mOutputs) {
-        // Do another level of filtering if necessary
-        if (privacyPolicy != output->getPrivacyPolicy()) {
-            privacyPolicy = output->getPrivacyPolicy();
-            err = fieldStripper.strip(privacyPolicy);
-            if (err != NO_ERROR) {
-                // We can't successfully strip this data.  We will skip
-                // the rest of this section.
-                return NO_ERROR;
-            }
-        }
+        privacyPolicies.push_back(output->getPrivacyPolicy());
+    }
+    FieldStripper fieldStripper(mRestrictions, buffer.data(), bufferLevel);
+    err = fieldStripper.strip(privacyPolicies);
+    if (err != NO_ERROR) {
+        // We can't successfully strip this data.  We will skip
+        // the rest of this section.
+        return NO_ERROR;
+    }
 
+    for (const sp<FilterFd>& output: mOutputs) {
         // Write the resultant buffer to the fd, along with the header.
-        ssize_t dataSize = fieldStripper.dataSize();
+        ssize_t dataSize = fieldStripper.dataSize(output->getPrivacyPolicy());
         if (dataSize > 0) {
             err = write_section_header(output->getFd(), mSectionId, dataSize);
             if (err != NO_ERROR) {
@@ -302,15 +435,15 @@ status_t PrivacyFilter::writeData(const FdBuffer& buffer, uint8_t bufferLevel,
                 continue;
             }
 
-            err = fieldStripper.writeData(output->getFd());
+            err = fieldStripper.writeData(output->getPrivacyPolicy(), output->getFd());
             if (err != NO_ERROR) {
                 output->onWriteError(err);
                 continue;
             }
         }
 
-        if (maxSize != NULL) {
-            if (dataSize > *maxSize) {
+        if (maxSize != NULL && dataSize > 0) {
+            if ((size_t)dataSize > *maxSize) {
                 *maxSize = dataSize;
             }
         }
@@ -341,41 +474,55 @@ void ReadbackFilterFd::onWriteError(status_t err) {
 }
 
 // ================================================================================
+/**
+ * Filter the field that the reader is at the head of to the level provided in args and
+ * write it, if it's a section that args wants.  Otherwise skip it.
+ */
+static status_t filter_and_write_field(int to, const sp<ProtoFileReader>& reader,
+        uint8_t bufferLevel, const IncidentReportArgs& args) {
+    status_t err;
+    uint64_t fieldTag = reader->readRawVarint();
+    uint32_t fieldId = read_field_id(fieldTag);
+    uint8_t wireType = read_wire_type(fieldTag);
+    if (wireType == WIRE_TYPE_LENGTH_DELIMITED
+            && args.containsSection(fieldId, section_requires_specific_mention(fieldId))) {
+        // We need this field, but we need to strip it to the level provided in args.
+        PrivacyFilter filter(fieldId, get_privacy_of_section(fieldId));
+        filter.addFd(new ReadbackFilterFd(args.getPrivacyPolicy(), to));
+
+        // Read this section from the reader into an FdBuffer
+        size_t sectionSize = reader->readRawVarint();
+        FdBuffer sectionData;
+        err = sectionData.write(reader, sectionSize);
+        if (err != NO_ERROR) {
+            ALOGW("filter_and_write_report FdBuffer.write failed (this shouldn't happen): %s",
+                    strerror(-err));
+            return err;
+        }
+
+        // Do the filter and write.
+        err = filter.writeData(sectionData, bufferLevel, nullptr);
+        if (err != NO_ERROR) {
+            ALOGW("filter_and_write_report filter.writeData had an error: %s", strerror(-err));
+            return err;
+        }
+    } else {
+        // We don't need this field.  Incident does not have any direct children
+        // other than sections.  So just skip them.
+        write_field_or_skip(NULL, reader, fieldTag, true);
+    }
+    return NO_ERROR;
+}
+
 status_t filter_and_write_report(int to, int from, uint8_t bufferLevel,
         const IncidentReportArgs& args) {
     status_t err;
     sp<ProtoFileReader> reader = new ProtoFileReader(from);
 
     while (reader->hasNext()) {
-        uint64_t fieldTag = reader->readRawVarint();
-        uint32_t fieldId = read_field_id(fieldTag);
-        uint8_t wireType = read_wire_type(fieldTag);
-        if (wireType == WIRE_TYPE_LENGTH_DELIMITED
-                && args.containsSection(fieldId, section_requires_specific_mention(fieldId))) {
-            // We need this field, but we need to strip it to the level provided in args.
-            PrivacyFilter filter(fieldId, get_privacy_of_section(fieldId));
-            filter.addFd(new ReadbackFilterFd(args.getPrivacyPolicy(), to));
-
-            // Read this section from the reader into an FdBuffer
-            size_t sectionSize = reader->readRawVarint();
-            FdBuffer sectionData;
-            err = sectionData.write(reader, sectionSize);
-            if (err != NO_ERROR) {
-                ALOGW("filter_and_write_report FdBuffer.write failed (this shouldn't happen): %s",
-                        strerror(-err));
-                return err;
-            }
-
-            // Do the filter and write.
-            err = filter.writeData(sectionData, bufferLevel, nullptr);
-            if (err != NO_ERROR) {
-                ALOGW("filter_and_write_report filter.writeData had an error: %s", strerror(-err));
-                return err;
-            }
-        } else {
-            // We don't need this field.  Incident does not have any direct children
-            // other than sections.  So just skip them.
-            write_field_or_skip(NULL, reader, fieldTag, true);
+        err = filter_and_write_field(to, reader, bufferLevel, args);
+        if (err != NO_ERROR) {
+            return err;
         }
     }
     clear_buffer_pool();
@@ -388,6 +535,33 @@ status_t filter_and_write_report(int to, int from, uint8_t bufferLevel,
     return NO_ERROR;
 }
 
+status_t filter_and_write_report_sections(int to, int from, const vector<off_t>& offsets,
+        uint8_t bufferLevel, const IncidentReportArgs& args) {
+    status_t err;
+    for (off_t offset : offsets) {
+        if (lseek(from, offset, SEEK_SET) != offset) {
+            ALOGW("filter_and_write_report_sections can't seek to %lld: %s", (long long)offset,
+                    strerror(errno));
+            return -errno;
+        }
+        // The reader reads ahead, so each section gets its own.
+        sp<ProtoFileReader> reader = new ProtoFileReader(from);
+        if (reader->hasNext()) {
+            err = filter_and_write_field(to, reader, bufferLevel, args);
+            if (err != NO_ERROR) {
+                return err;
+            }
+        }
+        err = reader->getError();
+        if (err != NO_ERROR) {
+            ALOGW("filter_and_write_report_sections reader had an error: %s", strerror(-err));
+            return err;
+        }
+    }
+    clear_buffer_pool();
+    return NO_ERROR;
+}
+
 }  // namespace incidentd
 }  // namespace os
 }  // namespace android
@@ -94,6 +94,13 @@ private:
 status_t filter_and_write_report(int to, int from, uint8_t bufferLevel,
         const IncidentReportArgs& args);
 
+/**
+ * Like filter_and_write_report, but only reads the sections at the given offsets of from,
+ * in that order.  Each offset must be the head of a section.
+ */
+status_t filter_and_write_report_sections(int to, int from, const vector<off_t>& offsets,
+        uint8_t bufferLevel, const IncidentReportArgs& args);
+
 }  // namespace incidentd
 }  // namespace os
 }  // namespace android
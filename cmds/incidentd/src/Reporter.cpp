@@ -38,8 +38,13 @@
 #include <sys/prctl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <time.h>
+#include <unistd.h>
 #include <wait.h>
 
 namespace android {
@@ -384,11 +389,27 @@ void ReportBatch::removeRequest(const sp<ReportRequest>& request) {
 // ================================================================================
 ReportWriter::ReportWriter(const sp<ReportBatch>& batch)
         :mBatch(batch),
+         mStaging(false),
+         mStagedData(),
+         mStagedDurationMs(0),
          mPersistedFile(),
          mMaxPersistedPrivacyPolicy(PRIVACY_POLICY_UNSET) {
 }
 
+ReportWriter::ReportWriter()
+        :mBatch(),
+         mStaging(true),
+         mStagedData(),
+         mStagedDurationMs(0),
+         mPersistedFile(),
+         mMaxPersistedPrivacyPolicy(PRIVACY_POLICY_UNSET),
+         mMaxSectionDataFilteredSize(0) {
+}
+
 ReportWriter::~ReportWriter() {
+    if (mStagedData != nullptr) {
+        return_buffer_to_pool(mStagedData);
+    }
 }
 
 void ReportWriter::setPersistedFile(sp<ReportFile> file) {
@@ -493,6 +514,14 @@ void ReportWriter::vflog(const Section* section, status_t err, int level, const
 
 // Reads data from FdBuffer and writes it to the requests file descriptor.
 status_t ReportWriter::writeSection(const FdBuffer& buffer) {
+    if (mStaging) {
+        // The requests are filtered when the report writes the staged data, in order.
+        if (mStagedData == nullptr) {
+            mStagedData = get_buffer_from_pool();
+        }
+        return mStagedData->writeRaw(buffer.data()->read());
+    }
+
     PrivacyFilter filter(mCurrentSectionId, get_privacy_of_section(mCurrentSectionId));
 
     // Add the fd for the persisted requests
@@ -511,9 +540,190 @@ status_t ReportWriter::writeSection(const FdBuffer& buffer) {
         }
     });
 
-    return filter.writeData(buffer, PRIVACY_POLICY_LOCAL, &mMaxSectionDataFilteredSize);
+    // Remember where the section is in the persisted file, so that it can be read without
+    // reading the rest of the report.
+    off_t persistedStart = -1;
+    if (mPersistedFile != nullptr && mPersistedFile->getDataFileFd() >= 0) {
+        persistedStart = lseek(mPersistedFile->getDataFileFd(), 0, SEEK_CUR);
+    }
+
+    status_t err = filter.writeData(buffer, PRIVACY_POLICY_LOCAL, &mMaxSectionDataFilteredSize);
+
+    if (persistedStart >= 0 && mPersistedFile->getWriteError() == NO_ERROR) {
+        off_t persistedEnd = lseek(mPersistedFile->getDataFileFd(), 0, SEEK_CUR);
+        if (persistedEnd > persistedStart) {
+            mPersistedFile->addSectionRange(mCurrentSectionId, persistedStart,
+                    persistedEnd - persistedStart);
+        }
+    }
+    return err;
+}
+
+void ReportWriter::endStagedSection() {
+    mStagedDurationMs = uptimeMillis() - mSectionStartTimeMs;
+}
+
+status_t ReportWriter::writeStagedSection(const ReportWriter& staged) {
+    // Count how long the section ran for, not how long it waited for its turn.
+    mSectionStartTimeMs = uptimeMillis() - staged.mStagedDurationMs;
+
+    if (staged.mSectionStatsCalledForSectionId == staged.mCurrentSectionId) {
+        mSectionStatsCalledForSectionId = mCurrentSectionId;
+    }
+    mDumpSizeBytes = staged.mDumpSizeBytes;
+    mDumpDurationMs = staged.mDumpDurationMs;
+    mSectionTimedOut = staged.mSectionTimedOut;
+    mSectionTruncated = staged.mSectionTruncated;
+    mSectionBufferSuccess = staged.mSectionBufferSuccess;
+    mHadError = staged.mHadError;
+    mSectionErrors = staged.mSectionErrors;
+
+    if (staged.mStagedData == nullptr) {
+        return NO_ERROR;
+    }
+    FdBuffer buffer(staged.mStagedData);
+    return writeSection(buffer);
+}
+
+size_t ReportWriter::stagedSize() const {
+    return mStagedData != nullptr ? mStagedData->size() : 0;
+}
+
+
+// ================================================================================
+/**
+ * How many threads run the independent sections, and how much of their data may be kept
+ * before the report writes it.
+ */
+const size_t SECTION_PREFETCH_THREADS = 4;
+const size_t SECTION_PREFETCH_MAX_BYTES = 32 * 1024 * 1024;  // 32 MB
+
+/**
+ * Runs the independent sections of a report on a few threads while the report runs the
+ * sections before them, so that a slow section doesn't hold them all up.  Each of them
+ * writes to its own staging ReportWriter, and the report writes those in order, so the
+ * report is the same as if they had run one at a time.
+ */
+class SectionPrefetcher {
+public:
+    struct Result {
+        ReportWriter writer;
+        status_t err;
+    };
+
+    SectionPrefetcher(const vector<const Section*>& sections);
+
+    /**
+     * Waits for the sections that are running.  The others are dropped.
+     */
+    ~SectionPrefetcher();
+
+    /**
+     * Return the result of the section, waiting for it if it is running.  Return nullptr
+     * if no thread has started it, in which case the caller runs it.
+     */
+    unique_ptr<Result> take(const Section* section);
+
+private:
+    enum State { PENDING, RUNNING, DONE, TAKEN };
+
+    struct Entry {
+        const Section* section;
+        State state;
+        unique_ptr<Result> result;
+    };
+
+    vector<Entry> mEntries;
+    vector<thread> mThreads;
+
+    // Lock protects these fields and the states and results of the entries
+    mutex mLock;
+    condition_variable mCondition;
+    size_t mNextPending;
+    size_t mHeldBytes;
+    bool mStopping;
+
+    void run();
+};
+
+SectionPrefetcher::SectionPrefetcher(const vector<const Section*>& sections)
+        :mEntries(),
+         mThreads(),
+         mNextPending(0),
+         mHeldBytes(0),
+         mStopping(false) {
+    for (const Section* section : sections) {
+        mEntries.push_back({section, PENDING, nullptr});
+    }
+    const size_t threadCount = min(mEntries.size(), SECTION_PREFETCH_THREADS);
+    for (size_t i = 0; i < threadCount; i++) {
+        mThreads.emplace_back([this]() { run(); });
+    }
 }
 
+SectionPrefetcher::~SectionPrefetcher() {
+    {
+        lock_guard<mutex> lock(mLock);
+        mStopping = true;
+    }
+    mCondition.notify_all();
+    for (thread& t : mThreads) {
+        t.join();
+    }
+}
+
+void SectionPrefetcher::run() {
+    unique_lock<mutex> lock(mLock);
+    while (true) {
+        // The report runs the sections that the threads don't get to, so it never waits
+        // on the cap.
+        mCondition.wait(lock, [this]() {
+            return mStopping || mHeldBytes < SECTION_PREFETCH_MAX_BYTES;
+        });
+        while (mNextPending < mEntries.size() && mEntries[mNextPending].state != PENDING) {
+            mNextPending++;
+        }
+        if (mStopping || mNextPending >= mEntries.size()) {
+            return;
+        }
+        Entry& entry = mEntries[mNextPending++];
+        entry.state = RUNNING;
+        lock.unlock();
+
+        unique_ptr<Result> result(new Result());
+        VLOG("Prefetch incident report section %d '%s'", entry.section->id,
+                entry.section->name.c_str());
+        result->writer.startSection(entry.section->id);
+        result->err = entry.section->Execute(&result->writer);
+        result->writer.endStagedSection();
+
+        lock.lock();
+        mHeldBytes += result->writer.stagedSize();
+        entry.result = std::move(result);
+        entry.state = DONE;
+        mCondition.notify_all();
+    }
+}
+
+unique_ptr<SectionPrefetcher::Result> SectionPrefetcher::take(const Section* section) {
+    unique_lock<mutex> lock(mLock);
+    for (Entry& entry : mEntries) {
+        if (entry.section != section || entry.state == TAKEN) {
+            continue;
+        }
+        if (entry.state == PENDING) {
+            // There is no point in waiting for a thread.
+            entry.state = TAKEN;
+            return nullptr;
+        }
+        mCondition.wait(lock, [&entry]() { return entry.state == DONE; });
+        entry.state = TAKEN;
+        mHeldBytes -= entry.result->writer.stagedSize();
+        mCondition.notify_all();
+        return std::move(entry.result);
+    }
+    return nullptr;
+}
 
 // ================================================================================
 Reporter::Reporter(const sp<WorkDirectory>& workDirectory,
@@ -633,17 +843,28 @@ void Reporter::runReport(size_t* reportByteSize) {
     // sections for it.
     cancel_and_remove_failed_requests();
 
-    // For each of the report fields, see if we need it, and if so, execute the command
-    // and report to those that care that we're doing it.
-    for (const Section** section = SECTION_LIST; *section; section++) {
-        if (execute_section(*section, &metadata, reportByteSize) != NO_ERROR) {
-            goto DONE;
+    {
+        // Start the independent sections that are needed on other threads.
+        vector<const Section*> independentSections;
+        for (const Section** section = SECTION_LIST; *section; section++) {
+            if ((*section)->IsIndependent() && mBatch->containsSection((*section)->id)) {
+                independentSections.push_back(*section);
+            }
+        }
+        SectionPrefetcher prefetcher(independentSections);
+
+        // For each of the report fields, see if we need it, and if so, execute the command
+        // and report to those that care that we're doing it.
+        for (const Section** section = SECTION_LIST; *section; section++) {
+            if (execute_section(*section, &metadata, reportByteSize, &prefetcher) != NO_ERROR) {
+                goto DONE;
+            }
         }
-    }
 
-    for (const Section* section : mRegisteredSections) {
-        if (execute_section(section, &metadata, reportByteSize) != NO_ERROR) {
-            goto DONE;
+        for (const Section* section : mRegisteredSections) {
+            if (execute_section(section, &metadata, reportByteSize, nullptr) != NO_ERROR) {
+                goto DONE;
+            }
         }
     }
 
@@ -703,7 +924,7 @@ DONE:
 }
 
 status_t Reporter::execute_section(const Section* section, IncidentMetadata* metadata,
-        size_t* reportByteSize) {
+        size_t* reportByteSize, SectionPrefetcher* prefetcher) {
     const int sectionId = section->id;
 
     // If nobody wants this section, skip it.
@@ -722,7 +943,15 @@ status_t Reporter::execute_section(const Section* section, IncidentMetadata* met
 
     // Go get the data and write it into the file descriptors.
     mWriter.startSection(sectionId);
-    status_t err = section->Execute(&mWriter);
+    status_t err;
+    unique_ptr<SectionPrefetcher::Result> prefetched =
+            prefetcher != nullptr ? prefetcher->take(section) : nullptr;
+    if (prefetched != nullptr) {
+        status_t writeErr = mWriter.writeStagedSection(prefetched->writer);
+        err = prefetched->err != NO_ERROR ? prefetched->err : writeErr;
+    } else {
+        err = section->Execute(&mWriter);
+    }
     mWriter.endSection(sectionMetadata);
 
     // Sections returning errors are fatal. Most errors should not be fatal.
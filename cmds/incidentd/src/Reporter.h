@@ -43,6 +43,7 @@ using namespace android::os;
 
 class BringYourOwnSection;
 class Section;
+class SectionPrefetcher;
 
 // ================================================================================
 class ReportRequest : public virtual RefBase {
@@ -192,6 +193,13 @@ private:
 class ReportWriter {
 public:
     ReportWriter(const sp<ReportBatch>& batch);
+
+    /**
+     * Make a writer that keeps the data of one section in memory instead of writing it,
+     * so that the section can run on another thread before its turn.  The report then
+     * writes it with writeStagedSection.
+     */
+    ReportWriter();
     ~ReportWriter();
 
     void setPersistedFile(sp<ReportFile> file);
@@ -207,10 +215,33 @@ public:
 
     status_t writeSection(const FdBuffer& buffer);
 
+    /**
+     * Called on a staging writer once the section has run.
+     */
+    void endStagedSection();
+
+    /**
+     * Write the section that a staging writer kept, with its stats and errors, as the
+     * current section.
+     */
+    status_t writeStagedSection(const ReportWriter& staged);
+
+    /**
+     * How much data a staging writer keeps.
+     */
+    size_t stagedSize() const;
+
 private:
     // Data about all requests
     sp<ReportBatch> mBatch;
 
+    /**
+     * Whether this is a staging writer, and the data of its section if it was written.
+     */
+    bool mStaging;
+    sp<EncodedBuffer> mStagedData;
+    int64_t mStagedDurationMs;
+
     /**
      * The file on disk where we will store the persisted file.
      */
@@ -275,7 +306,7 @@ private:
     const vector<BringYourOwnSection*>& mRegisteredSections;
 
     status_t execute_section(const Section* section, IncidentMetadata* metadata,
-        size_t* reportByteSize);
+        size_t* reportByteSize, SectionPrefetcher* prefetcher);
 
     void cancel_and_remove_failed_requests();
 };
@@ -83,6 +83,8 @@ Section::Section(int i, int64_t timeoutMs)
 
 Section::~Section() {}
 
+bool Section::IsIndependent() const { return false; }
+
 // ================================================================================
 static inline bool isSysfs(const char* filename) { return strncmp(filename, "/sys/", 5) == 0; }
 
@@ -95,6 +97,8 @@ FileSection::FileSection(int id, const char* filename, const int64_t timeoutMs)
 
 FileSection::~FileSection() {}
 
+bool FileSection::IsIndependent() const { return true; }
+
 status_t FileSection::Execute(ReportWriter* writer) const {
     // read from mFilename first, make sure the file is available
     // add O_CLOEXEC to make sure it is closed when exec incident helper
@@ -156,6 +160,8 @@ GZipSection::GZipSection(int id, const char* filename, ...) : Section(id) {
 
 GZipSection::~GZipSection() { free(mFilenames); }
 
+bool GZipSection::IsIndependent() const { return true; }
+
 status_t GZipSection::Execute(ReportWriter* writer) const {
     // Reads the files in order, use the first available one.
     int index = 0;
@@ -355,6 +361,8 @@ CommandSection::CommandSection(int id, const char* command, ...) : Section(id) {
 
 CommandSection::~CommandSection() { free(mCommand); }
 
+bool CommandSection::IsIndependent() const { return true; }
+
 status_t CommandSection::Execute(ReportWriter* writer) const {
     Fpipe cmdPipe;
     Fpipe ihPipe;
@@ -839,9 +847,11 @@ status_t TombstoneSection::BlockingCall(unique_fd& pipeWriteFd) const {
         }
         sp<ProtoReader> reader = buffer.data()->read();
         int i = 0;
-        while (reader->hasNext()) {
-            dumpBuffer[i] = reader->next();
-            i++;
+        uint8_t const* span;
+        size_t amt;
+        while ((amt = reader->readSpan(SIZE_MAX, &span)) > 0) {
+            memcpy(dumpBuffer + i, span, amt);
+            i += amt;
         }
         uint64_t token = proto.start(android::os::BackTraceProto::TRACES);
         proto.write(android::os::BackTraceProto::Stack::PID, pid);
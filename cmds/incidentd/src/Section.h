@@ -48,6 +48,12 @@ public:
     virtual ~Section();
 
     virtual status_t Execute(ReportWriter* writer) const = 0;
+
+    /**
+     * Whether the section only reads files or runs commands, so that it can run on another
+     * thread while the sections before it run.  It then writes to a staging ReportWriter.
+     */
+    virtual bool IsIndependent() const;
 };
 
 /**
@@ -60,6 +66,7 @@ public:
     virtual ~FileSection();
 
     virtual status_t Execute(ReportWriter* writer) const;
+    virtual bool IsIndependent() const;
 
 private:
     const char* mFilename;
@@ -75,6 +82,7 @@ public:
     virtual ~GZipSection();
 
     virtual status_t Execute(ReportWriter* writer) const;
+    virtual bool IsIndependent() const;
 
 private:
     // It looks up the content from multiple files and stops when the first one is available.
@@ -106,6 +114,7 @@ public:
     virtual ~CommandSection();
 
     virtual status_t Execute(ReportWriter* writer) const;
+    virtual bool IsIndependent() const;
 
 private:
     const char** mCommand;
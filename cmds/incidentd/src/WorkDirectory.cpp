@@ -19,6 +19,7 @@
 #include "incidentd_util.h"
 #include "proto_util.h"
 #include "PrivacyFilter.h"
+#include "Section.h"
 #include "WorkDirectory.h"
 
 #include <google/protobuf/io/zero_copy_stream_impl.h>
@@ -457,7 +458,27 @@ status_t ReportFile::startFilteringData(int writeFd, const IncidentReportArgs& a
         write_section(writeFd, FIELD_ID_INCIDENT_METADATA, mEnvelope.metadata());
     }
 
-    err = filter_and_write_report(writeFd, dataFd, mEnvelope.privacy_policy(), args);
+    // Only read the sections that args wants, if we know where they are.
+    bool useSectionRanges = mEnvelope.section_range_size() > 0;
+    vector<off_t> offsets;
+    for (const auto& range : mEnvelope.section_range()) {
+        if (range.offset() < 0 || range.size() <= 0
+                || range.offset() + range.size() > mEnvelope.data_file_size()) {
+            ALOGW("Bad range of section %d in incident report '%s', reading all of it",
+                    range.id(), getDataFileName().c_str());
+            useSectionRanges = false;
+            break;
+        }
+        if (args.containsSection(range.id(), section_requires_specific_mention(range.id()))) {
+            offsets.push_back(range.offset());
+        }
+    }
+    if (useSectionRanges) {
+        err = filter_and_write_report_sections(writeFd, dataFd, offsets,
+                mEnvelope.privacy_policy(), args);
+    } else {
+        err = filter_and_write_report(writeFd, dataFd, mEnvelope.privacy_policy(), args);
+    }
     if (err != NO_ERROR) {
         ALOGW("Error writing incident report '%s' to dropbox: %s", getDataFileName().c_str(),
                 strerror(-err));
@@ -487,6 +508,13 @@ int ReportFile::getDataFileFd() {
     return mDataFd;
 }
 
+void ReportFile::addSectionRange(int sectionId, off_t offset, size_t size) {
+    ReportFileProto_SectionRange* range = mEnvelope.add_section_range();
+    range->set_id(sectionId);
+    range->set_offset(offset);
+    range->set_size(size);
+}
+
 void ReportFile::setWriteError(status_t err) {
     mError = err;
 }
@@ -509,6 +537,7 @@ status_t ReportFile::save_envelope_impl(bool cleanup) {
         }
         return err;
     }
+    mWorkDirectory->noteEnvelopeSaved(mTimestampNs, mEnvelope);
     return NO_ERROR;
 }
 
@@ -533,15 +562,17 @@ status_t ReportFile::load_envelope_impl(bool cleanup) {
 WorkDirectory::WorkDirectory()
         :mDirectory("/data/misc/incidents"),
          mMaxFileCount(100),
-         mMaxDiskUsageBytes(400 * 1024 * 1024) {  // Incident reports can take up to 400MB on disk.
+         mMaxDiskUsageBytes(400 * 1024 * 1024),  // Incident reports can take up to 400MB on disk.
                                                  // TODO: Should be a flag.
+         mCatalogLoaded(false) {
     create_directory(mDirectory.c_str());
 }
 
 WorkDirectory::WorkDirectory(const string& dir, int maxFileCount, long maxDiskUsageBytes)
         :mDirectory(dir),
          mMaxFileCount(maxFileCount),
-         mMaxDiskUsageBytes(maxDiskUsageBytes) {
+         mMaxDiskUsageBytes(maxDiskUsageBytes),
+         mCatalogLoaded(false) {
     create_directory(mDirectory.c_str());
 }
 
@@ -657,13 +688,11 @@ void WorkDirectory::commitAll(const string& pkg) {
 
     unique_lock<mutex> lock(mLock);
 
-    map<string,WorkDirectoryEntry> files;
-    get_directory_contents_locked(&files, 0);
-
-    for (map<string,WorkDirectoryEntry>::iterator it = files.begin();
-            it != files.end(); it++) {
-        sp<ReportFile> reportFile = new ReportFile(this, it->second.timestampNs,
-                it->second.envelope, it->second.data);
+    // Only the envelopes that name pkg as a receiver need to be loaded.
+    for (int64_t timestampNs : get_reports_for_package_locked(pkg)) {
+        sp<ReportFile> reportFile = new ReportFile(this, timestampNs,
+                make_filename(timestampNs, EXTENSION_ENVELOPE),
+                make_filename(timestampNs, EXTENSION_DATA));
 
         err = reportFile->loadEnvelope();
         if (err != NO_ERROR) {
@@ -678,11 +707,66 @@ void WorkDirectory::commitAll(const string& pkg) {
 
 void WorkDirectory::remove(const sp<ReportFile>& report) {
     unique_lock<mutex> lock(mLock);
+    unlink_report_locked(report->getTimestampNs(), report->getEnvelopeFileName(),
+            report->getDataFileName());
+}
+
+void WorkDirectory::noteEnvelopeSaved(int64_t timestampNs, const ReportFileProto& envelope) {
+    unique_lock<mutex> lock(mCatalogLock);
+    if (!mCatalogLoaded) {
+        // The catalog will pick this envelope up from disk when it is built.
+        return;
+    }
+    set<string>& packages = mCatalog[timestampNs];
+    packages.clear();
+    const int reportCount = envelope.report_size();
+    for (int i = 0; i < reportCount; i++) {
+        packages.insert(envelope.report(i).pkg());
+    }
+}
+
+void WorkDirectory::unlink_report_locked(int64_t timestampNs, const string& envelope,
+        const string& data) {
     // Set this to false to leave files around for debugging.
     if (DO_UNLINK) {
-        unlink(report->getDataFileName().c_str());
-        unlink(report->getEnvelopeFileName().c_str());
+        unlink(data.c_str());
+        unlink(envelope.c_str());
+        unique_lock<mutex> lock(mCatalogLock);
+        mCatalog.erase(timestampNs);
+    }
+}
+
+vector<int64_t> WorkDirectory::get_reports_for_package_locked(const string& pkg) {
+    unique_lock<mutex> lock(mCatalogLock);
+    if (!mCatalogLoaded) {
+        // mLock keeps envelopes from being created or deleted while the directory is read,
+        // and holding mCatalogLock holds back envelopes being saved until they can be noted.
+        map<string,WorkDirectoryEntry> files;
+        get_directory_contents_locked(&files, 0);
+        map<int64_t, set<string>> catalog;
+        for (map<string,WorkDirectoryEntry>::iterator it = files.begin();
+                it != files.end(); it++) {
+            ReportFileProto envelope;
+            if (read_proto(&envelope, it->second.envelope) != NO_ERROR) {
+                continue;
+            }
+            set<string>& packages = catalog[it->second.timestampNs];
+            const int reportCount = envelope.report_size();
+            for (int i = 0; i < reportCount; i++) {
+                packages.insert(envelope.report(i).pkg());
+            }
+        }
+        mCatalog = std::move(catalog);
+        mCatalogLoaded = true;
     }
+
+    vector<int64_t> result;
+    for (const auto& [timestampNs, packages] : mCatalog) {
+        if (packages.count(pkg) != 0) {
+            result.push_back(timestampNs);
+        }
+    }
+    return result;
 }
 
 int64_t WorkDirectory::make_timestamp_ns_locked() {
@@ -829,8 +913,8 @@ void WorkDirectory::clean_directory_locked() {
                 it != files.end() && (totalSize >= mMaxDiskUsageBytes
                     || totalCount >= mMaxFileCount);
                 it++) {
-            unlink(it->second.envelope.c_str());
-            unlink(it->second.data.c_str());
+            unlink_report_locked(it->second.timestampNs, it->second.envelope,
+                    it->second.data);
             totalSize -= it->second.size;
             totalCount--;
         }
@@ -840,10 +924,8 @@ void WorkDirectory::clean_directory_locked() {
 void WorkDirectory::delete_files_for_report_if_necessary(const sp<ReportFile>& report) {
     if (report->getEnvelope().report_size() == 0) {
         ALOGI("Report %s is finished. Deleting from storage.", report->getId().c_str());
-        if (DO_UNLINK) {
-            unlink(report->getDataFileName().c_str());
-            unlink(report->getEnvelopeFileName().c_str());
-        }
+        unlink_report_locked(report->getTimestampNs(), report->getEnvelopeFileName(),
+                report->getDataFileName());
     }
 }
 
@@ -23,7 +23,9 @@
 
 #include <utils/RefBase.h>
 
+#include <map>
 #include <mutex>
+#include <set>
 #include <string>
 
 namespace android {
@@ -160,6 +162,11 @@ public:
      */
     int getDataFileFd();
 
+    /**
+     * Record that the section was written to the data file at the given offset.
+     */
+    void addSectionRange(int sectionId, off_t offset, size_t size);
+
     /**
      * Record that there was an error writing to the data file.
      */
@@ -250,6 +257,12 @@ public:
      * more pending readers or broadcasts, for example in response to an error.
      */
     void remove(const sp<ReportFile>& report);
+
+    /**
+     * Record the receivers of an envelope that was just written to disk.  Called by
+     * ReportFile, so that commitAll() doesn't have to parse every envelope.
+     */
+    void noteEnvelopeSaved(int64_t timestampNs, const ReportFileProto& envelope);
     
 private:
     string mDirectory;
@@ -260,11 +273,20 @@ private:
     // the directory consistent.
     mutex mLock;
 
+    // Receiver packages of each envelope on disk, by timestamp.  Built from the directory
+    // the first time it is needed, then kept up to date as envelopes are saved and deleted.
+    // Guarded by mCatalogLock, which may be taken while holding mLock but not the reverse.
+    mutex mCatalogLock;
+    bool mCatalogLoaded;
+    map<int64_t, set<string>> mCatalog;
+
     int64_t make_timestamp_ns_locked();
     bool file_exists_locked(int64_t timestampNs);    
     off_t get_directory_contents_locked(map<string,WorkDirectoryEntry>* files, int64_t after);
     void clean_directory_locked();
     void delete_files_for_report_if_necessary(const sp<ReportFile>& report);
+    void unlink_report_locked(int64_t timestampNs, const string& envelope, const string& data);
+    vector<int64_t> get_reports_for_package_locked(const string& pkg);
 
     string make_filename(int64_t timestampNs, const string& extension);
 };
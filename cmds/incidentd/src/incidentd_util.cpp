@@ -67,8 +67,12 @@ void return_buffer_to_pool(sp<EncodedBuffer> buffer) {
 }
 
 void clear_buffer_pool() {
-    std::scoped_lock<std::mutex> lock(gBufferPoolLock);
-    gBufferPool.clear();
+    {
+        std::scoped_lock<std::mutex> lock(gBufferPoolLock);
+        gBufferPool.clear();
+    }
+    // Also unmap the chunks that the buffers gave back to the EncodedBuffer pool.
+    EncodedBuffer::trimPool();
 }
 
 // ================================================================================
@@ -206,6 +206,41 @@ TEST_F(FdBufferTest, ReadInStreamAndWriteAllAtOnce) {
     }
 }
 
+TEST_F(FdBufferTest, ReadInStreamMoreThanAPipeHolds) {
+    // Larger than the capacity of the pipe, so that the data is moved to the child in parts.
+    std::string testdata;
+    for (int i = 0; testdata.size() < 1024 * 1024; i++) {
+        testdata += std::to_string(i);
+        testdata += '\n';
+    }
+    std::string expected = HEAD + testdata;
+    ASSERT_TRUE(WriteStringToFile(testdata, tf.path));
+
+    int pid = fork();
+    ASSERT_TRUE(pid != -1);
+
+    if (pid == 0) {
+        p2cPipe.writeFd().reset();
+        c2pPipe.readFd().reset();
+        ASSERT_TRUE(WriteStringToFd(HEAD, c2pPipe.writeFd()));
+        ASSERT_TRUE(DoDataStream(p2cPipe.readFd(), c2pPipe.writeFd()));
+        p2cPipe.readFd().reset();
+        c2pPipe.writeFd().reset();
+        // Must exit here otherwise the child process will continue executing the test binary.
+        _exit(EXIT_SUCCESS);
+    } else {
+        p2cPipe.readFd().reset();
+        c2pPipe.writeFd().reset();
+
+        ASSERT_EQ(NO_ERROR,
+                  buffer.readProcessedDataInStream(tf.fd, std::move(p2cPipe.writeFd()),
+                                                   std::move(c2pPipe.readFd()), READ_TIMEOUT));
+        AssertBufferReadSuccessful(expected.size());
+        AssertBufferContent(expected.c_str());
+        wait(&pid);
+    }
+}
+
 TEST_F(FdBufferTest, ReadInStreamEmpty) {
     ASSERT_TRUE(WriteStringToFile("", tf.path));
 
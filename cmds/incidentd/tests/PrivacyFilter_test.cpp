@@ -300,3 +300,105 @@ TEST_F(PrivacyFilterTest, AutoMessage) {
 }
 
 #endif
+
+class RecordingFilterFd : public FilterFd {
+public:
+    RecordingFilterFd(uint8_t privacyPolicy, int fd) : FilterFd(privacyPolicy, fd) {}
+
+    virtual void onWriteError(status_t err) { error = err; }
+
+    status_t error = NO_ERROR;
+};
+
+TEST(PrivacyFilterWriteDataTest, StripsToEveryPolicyOfTheOutputs) {
+    const std::string data = VARINT_FIELD_1 + STRING_FIELD_2 + FIX64_FIELD_3;
+    FdBuffer buffer;
+    ASSERT_EQ(NO_ERROR, buffer.write((const uint8_t*)data.data(), data.size()));
+
+    Privacy field1{1, OTHER_TYPE, NULL, PRIVACY_POLICY_LOCAL, NULL};
+    Privacy field2{2, STRING_TYPE, NULL, PRIVACY_POLICY_AUTOMATIC, NULL};
+    Privacy field3{3, OTHER_TYPE, NULL, PRIVACY_POLICY_EXPLICIT, NULL};
+    Privacy* fields[] = {&field1, &field2, &field3, NULL};
+    Privacy section{1, MESSAGE_TYPE, fields, PRIVACY_POLICY_EXPLICIT, NULL};
+
+    // Two of the outputs share a policy, and must both get all of the data.
+    const uint8_t policies[] = {PRIVACY_POLICY_AUTOMATIC, PRIVACY_POLICY_LOCAL,
+                                PRIVACY_POLICY_EXPLICIT, PRIVACY_POLICY_AUTOMATIC};
+    TemporaryFile files[4];
+    sp<RecordingFilterFd> outputs[4];
+    PrivacyFilter filter(1, &section);
+    for (int i = 0; i < 4; i++) {
+        outputs[i] = new RecordingFilterFd(policies[i], files[i].fd);
+        filter.addFd(outputs[i]);
+    }
+    size_t maxSize;
+    ASSERT_EQ(NO_ERROR, filter.writeData(buffer, PRIVACY_POLICY_LOCAL, &maxSize));
+    EXPECT_EQ(data.size(), maxSize);
+
+    const std::string automatic = STRING_FIELD_2;
+    const std::string explicit_ = STRING_FIELD_2 + FIX64_FIELD_3;
+    const std::string expected[] = {
+            "\x0a" + std::string(1, automatic.size()) + automatic,
+            "\x0a" + std::string(1, data.size()) + data,
+            "\x0a" + std::string(1, explicit_.size()) + explicit_,
+            "\x0a" + std::string(1, automatic.size()) + automatic,
+    };
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(NO_ERROR, outputs[i]->error);
+        std::string content;
+        ASSERT_TRUE(ReadFileToString(files[i].path, &content));
+        EXPECT_EQ(expected[i], content) << "output " << i;
+    }
+}
+
+TEST(PrivacyFilterWriteDataTest, StripsPastOnePassOfPolicies) {
+    const std::string data = VARINT_FIELD_1 + STRING_FIELD_2 + FIX64_FIELD_3;
+    FdBuffer buffer;
+    ASSERT_EQ(NO_ERROR, buffer.write((const uint8_t*)data.data(), data.size()));
+
+    Privacy field1{1, OTHER_TYPE, NULL, PRIVACY_POLICY_LOCAL, NULL};
+    Privacy field2{2, STRING_TYPE, NULL, PRIVACY_POLICY_AUTOMATIC, NULL};
+    Privacy field3{3, OTHER_TYPE, NULL, PRIVACY_POLICY_EXPLICIT, NULL};
+    Privacy* fields[] = {&field1, &field2, &field3, NULL};
+    Privacy section{1, MESSAGE_TYPE, fields, PRIVACY_POLICY_EXPLICIT, NULL};
+
+    // More distinct policies than one pass strips to. Unknown policies are treated as
+    // automatic, so none of the outputs may get the unfiltered data.
+    const int kOutputs = 40;
+    TemporaryFile files[kOutputs];
+    sp<RecordingFilterFd> outputs[kOutputs];
+    PrivacyFilter filter(1, &section);
+    for (int i = 0; i < kOutputs; i++) {
+        outputs[i] = new RecordingFilterFd(i + 1, files[i].fd);
+        filter.addFd(outputs[i]);
+    }
+    ASSERT_EQ(NO_ERROR, filter.writeData(buffer, PRIVACY_POLICY_LOCAL, NULL));
+
+    const std::string automatic = STRING_FIELD_2;
+    const std::string expected = "\x0a" + std::string(1, automatic.size()) + automatic;
+    for (int i = 0; i < kOutputs; i++) {
+        EXPECT_EQ(NO_ERROR, outputs[i]->error);
+        std::string content;
+        ASSERT_TRUE(ReadFileToString(files[i].path, &content));
+        EXPECT_EQ(expected, content) << "output " << i;
+    }
+}
+
+TEST(PrivacyFilterWriteDataTest, WritesOnlyTheSectionsAtTheOffsets) {
+    const std::string section1 = "\x0a\x03" "abc";
+    const std::string section2 = "\x12\x02" "xy";
+    TemporaryFile from;
+    ASSERT_TRUE(WriteStringToFile(section1 + section2 + section1, from.path));
+
+    IncidentReportArgs args;
+    args.setAll(true);
+    args.setPrivacyPolicy(PRIVACY_POLICY_LOCAL);
+    TemporaryFile to;
+    const vector<off_t> offsets = {(off_t)section1.size(), 0};
+    ASSERT_EQ(NO_ERROR, filter_and_write_report_sections(to.fd, from.fd, offsets,
+                                                          PRIVACY_POLICY_LOCAL, args));
+
+    std::string content;
+    ASSERT_TRUE(ReadFileToString(to.path, &content));
+    EXPECT_EQ(section2 + section1, content);
+}
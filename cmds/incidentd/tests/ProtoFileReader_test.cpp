@@ -98,3 +98,44 @@ TEST(ProtoFileReaderTest, ParseOneLevel) {
     ASSERT_EQ(msg2Size, msg_size[1]);
     close(fd);
 }
+
+TEST(ProtoFileReaderTest, ReadsSpansOfAMappedFile) {
+    TemporaryFile tf;
+    ASSERT_NE(tf.fd, -1);
+    // Larger than a chunk, so that the file is mapped.
+    string field1;
+    field1.resize(100 * 1024, 'h');
+    string field2 = "tail";
+    {
+        ProtoOutputStream proto;
+        proto.write(FIELD_TYPE_MESSAGE | 1, field1.data(), field1.length());
+        proto.write(FIELD_TYPE_MESSAGE | 2, field2.data(), field2.length());
+        ASSERT_TRUE(proto.flush(tf.fd));
+    }
+    ASSERT_EQ(0, lseek(tf.fd, 0, SEEK_SET));
+
+    sp<ProtoFileReader> reader = new ProtoFileReader(tf.fd);
+    ASSERT_TRUE(reader->hasNext());
+    ASSERT_EQ(1u, read_field_id(reader->readRawVarint()));
+    size_t size1 = reader->readRawVarint();
+    ASSERT_EQ(field1.length(), size1);
+    size_t start = reader->bytesRead();
+
+    // The whole field is contiguous.
+    uint8_t const* span;
+    ASSERT_EQ(size1, reader->readSpan(size1, &span));
+    EXPECT_EQ(field1, string(reinterpret_cast<char const*>(span), size1));
+    EXPECT_EQ(start + size1, reader->bytesRead());
+
+    ASSERT_EQ(2u, read_field_id(reader->readRawVarint()));
+    size_t size2 = reader->readRawVarint();
+    ASSERT_EQ(field2.length(), size2);
+    // Asking for more than there is stops at the end of the file.
+    ASSERT_EQ(size2, reader->readSpan(SIZE_MAX, &span));
+    EXPECT_EQ(field2, string(reinterpret_cast<char const*>(span), size2));
+
+    EXPECT_FALSE(reader->hasNext());
+    EXPECT_EQ(0u, reader->readSpan(SIZE_MAX, &span));
+    EXPECT_EQ((size_t)reader->size(), reader->bytesRead());
+    EXPECT_EQ(NO_ERROR, reader->getError());
+}
@@ -10,18 +10,27 @@ namespace incidentd {
 
 class TestSection: public Section {
 public:
-    TestSection(int id);
+    TestSection(int id, bool independent = false);
     ~TestSection();
     virtual status_t Execute(ReportWriter* writer) const;
+    virtual bool IsIndependent() const;
+
+private:
+    const bool mIndependent;
 };
 
-TestSection::TestSection(int id)
-        :Section(id, 5000 /* ms timeout */) {
+TestSection::TestSection(int id, bool independent)
+        :Section(id, 5000 /* ms timeout */),
+         mIndependent(independent) {
 }
 
 TestSection::~TestSection() {
 }
 
+bool TestSection::IsIndependent() const {
+    return mIndependent;
+}
+
 status_t TestSection::Execute(ReportWriter* writer) const {
     uint8_t buf[1024];
     status_t err;
@@ -45,7 +54,8 @@ status_t TestSection::Execute(ReportWriter* writer) const {
 }
 
 TestSection section1(1);
-TestSection section2(2);
+// Runs ahead of section1, and must still be written after it.
+TestSection section2(2, true /* independent */);
 
 const Section* SECTION_LIST[] = {
     &section1,
@@ -31,6 +31,10 @@
 #include <utils/String16.h>
 #include <utils/String8.h>
 
+#include <list>
+#include <string>
+#include <unordered_map>
+
 #include "android_database_SQLiteCommon.h"
 #include "core_jni_helpers.h"
 
@@ -53,6 +57,15 @@ namespace android {
  */
 static const int BUSY_TIMEOUT_MS = 2500;
 
+/* The number of finalized statements each connection keeps prepared.
+ *
+ * The Java side keeps a small LRU cache of statements per connection and finalizes the ones it
+ * evicts.  Instead of being finalized, the statements are parked here, so that preparing the same
+ * SQL again on this connection does not have to compile it again.  A statement is always either
+ * owned by Java or parked in this cache, never both.
+ */
+static const size_t STATEMENT_CACHE_SIZE = 100;
+
 // A useful constant class when arrays of strings are returned.
 static jclass g_stringClass = nullptr;
 
@@ -64,6 +77,75 @@ static struct {
     jmethodID apply;
 } gBinaryOperator;
 
+// Statements that were finalized by the Java side, by SQL, least recently used first.
+class StatementCache {
+public:
+    ~StatementCache() { clear(); }
+
+    // Returns a parked statement for |sql|, or null.
+    sqlite3_stmt* take(const std::u16string& sql) {
+        auto it = mIndex.find(sql);
+        if (it == mIndex.end()) {
+            return nullptr;
+        }
+        sqlite3_stmt* statement = it->second->statement;
+        mEntries.erase(it->second);
+        mIndex.erase(it);
+        return statement;
+    }
+
+    // Remembers the SQL of a statement handed out to the Java side.
+    void adopt(sqlite3_stmt* statement, std::u16string sql) {
+        mOutstanding.emplace(statement, std::move(sql));
+    }
+
+    // Parks a statement the Java side finalized, or finalizes it if it was not handed out by
+    // this cache or there is already one parked for the same SQL.
+    void put(sqlite3_stmt* statement) {
+        auto outstanding = mOutstanding.find(statement);
+        if (outstanding == mOutstanding.end()) {
+            sqlite3_finalize(statement);
+            return;
+        }
+        std::u16string sql = std::move(outstanding->second);
+        mOutstanding.erase(outstanding);
+        if (mIndex.count(sql) != 0) {
+            sqlite3_finalize(statement);
+            return;
+        }
+
+        // The result only reports errors from the last execution of the statement.
+        sqlite3_reset(statement);
+        sqlite3_clear_bindings(statement);
+        mEntries.push_back({sql, statement});
+        mIndex.emplace(std::move(sql), std::prev(mEntries.end()));
+        if (mEntries.size() > STATEMENT_CACHE_SIZE) {
+            sqlite3_finalize(mEntries.front().statement);
+            mIndex.erase(mEntries.front().sql);
+            mEntries.pop_front();
+        }
+    }
+
+    // Finalizes all parked statements.
+    void clear() {
+        for (auto& entry : mEntries) {
+            sqlite3_finalize(entry.statement);
+        }
+        mEntries.clear();
+        mIndex.clear();
+    }
+
+private:
+    struct Entry {
+        std::u16string sql;
+        sqlite3_stmt* statement;
+    };
+
+    std::list<Entry> mEntries;
+    std::unordered_map<std::u16string, std::list<Entry>::iterator> mIndex;
+    std::unordered_map<sqlite3_stmt*, std::u16string> mOutstanding;
+};
+
 struct SQLiteConnection {
     // Open flags.
     // Must be kept in sync with the constants defined in SQLiteDatabase.java.
@@ -89,6 +171,9 @@ struct SQLiteConnection {
 
     volatile bool canceled;
 
+    // Statements finalized by the Java side, kept prepared for reuse.
+    StatementCache statementCache;
+
     SQLiteConnection(sqlite3* db, int openFlags, const String8& path, const String8& label) :
             db(db), openFlags(openFlags), path(path), label(label), tableQuery(nullptr),
             canceled(false) { }
@@ -215,6 +300,7 @@ static void nativeClose(JNIEnv* env, jclass clazz, jlong connectionPtr, jboolean
         if (connection->tableQuery != nullptr) {
             sqlite3_finalize(connection->tableQuery);
         }
+        connection->statementCache.clear();
         if (fast) {
             // The caller requested a fast close, so do not checkpoint even if this is the last
             // connection to the database.  Note that the change is only to this connection.
@@ -402,9 +488,13 @@ static jlong nativePrepareStatement(JNIEnv* env, jclass clazz, jlong connectionP
 
     jsize sqlLength = env->GetStringLength(sqlString);
     const jchar* sql = env->GetStringCritical(sqlString, NULL);
-    sqlite3_stmt* statement;
-    int err = sqlite3_prepare16_v2(connection->db,
-            sql, sqlLength * sizeof(jchar), &statement, NULL);
+    std::u16string key(reinterpret_cast<const char16_t*>(sql), sqlLength);
+    sqlite3_stmt* statement = connection->statementCache.take(key);
+    int err = SQLITE_OK;
+    if (statement == nullptr) {
+        err = sqlite3_prepare16_v2(connection->db,
+                sql, sqlLength * sizeof(jchar), &statement, NULL);
+    }
     env->ReleaseStringCritical(sqlString, sql);
 
     if (err != SQLITE_OK) {
@@ -424,6 +514,9 @@ static jlong nativePrepareStatement(JNIEnv* env, jclass clazz, jlong connectionP
     }
 
     ALOGV("Prepared statement %p on connection %p", statement, connection->db);
+    if (statement != nullptr) {
+        connection->statementCache.adopt(statement, std::move(key));
+    }
     return reinterpret_cast<jlong>(statement);
 }
 
@@ -434,9 +527,9 @@ static void nativeFinalizeStatement(JNIEnv* env, jclass clazz, jlong connectionP
 
     // We ignore the result of sqlite3_finalize because it is really telling us about
     // whether any errors occurred while executing the statement.  The statement itself
-    // is always finalized regardless.
+    // is always finalized regardless, or parked in the statement cache.
     ALOGV("Finalized statement %p on connection %p", statement, connection->db);
-    sqlite3_finalize(statement);
+    connection->statementCache.put(statement);
 }
 
 static jint nativeGetParameterCount(JNIEnv* env, jclass clazz, jlong connectionPtr,
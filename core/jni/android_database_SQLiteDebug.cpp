@@ -26,6 +26,7 @@
 #include <unistd.h>
 #include <utils/Log.h>
 
+#include <androidfw/CursorWindow.h>
 #include <sqlite3.h>
 
 #include "core_jni_helpers.h"
@@ -36,6 +37,10 @@ static struct {
     jfieldID memoryUsed;
     jfieldID pageCacheOverflow;
     jfieldID largestMemAlloc;
+    // The CursorWindow pool counters, or null if this version of PagerStats doesn't have them.
+    jfieldID cursorWindowPoolHits;
+    jfieldID cursorWindowPoolMisses;
+    jfieldID cursorWindowPoolBytes;
 } gSQLiteDebugPagerStatsClassInfo;
 
 static void nativeGetPagerStats(JNIEnv *env, jobject clazz, jobject statsObj)
@@ -52,6 +57,24 @@ static void nativeGetPagerStats(JNIEnv *env, jobject clazz, jobject statsObj)
     env->SetIntField(statsObj, gSQLiteDebugPagerStatsClassInfo.pageCacheOverflow,
             pageCacheOverflow);
     env->SetIntField(statsObj, gSQLiteDebugPagerStatsClassInfo.largestMemAlloc, largestMemAlloc);
+
+    if (gSQLiteDebugPagerStatsClassInfo.cursorWindowPoolHits != nullptr) {
+        const CursorWindow::PoolStats poolStats = CursorWindow::getPoolStats();
+        env->SetLongField(statsObj, gSQLiteDebugPagerStatsClassInfo.cursorWindowPoolHits,
+                static_cast<jlong>(poolStats.hits));
+        env->SetLongField(statsObj, gSQLiteDebugPagerStatsClassInfo.cursorWindowPoolMisses,
+                static_cast<jlong>(poolStats.misses));
+        env->SetLongField(statsObj, gSQLiteDebugPagerStatsClassInfo.cursorWindowPoolBytes,
+                static_cast<jlong>(poolStats.pooledBytes));
+    }
+}
+
+static jfieldID getOptionalLongFieldID(JNIEnv* env, jclass clazz, const char* name) {
+    jfieldID field = env->GetFieldID(clazz, name, "J");
+    if (field == nullptr) {
+        env->ExceptionClear();
+    }
+    return field;
 }
 
 /*
@@ -73,6 +96,16 @@ int register_android_database_SQLiteDebug(JNIEnv *env)
             "largestMemAlloc", "I");
     gSQLiteDebugPagerStatsClassInfo.pageCacheOverflow = GetFieldIDOrDie(env, clazz,
             "pageCacheOverflow", "I");
+    gSQLiteDebugPagerStatsClassInfo.cursorWindowPoolHits = getOptionalLongFieldID(env, clazz,
+            "cursorWindowPoolHits");
+    gSQLiteDebugPagerStatsClassInfo.cursorWindowPoolMisses = getOptionalLongFieldID(env, clazz,
+            "cursorWindowPoolMisses");
+    gSQLiteDebugPagerStatsClassInfo.cursorWindowPoolBytes = getOptionalLongFieldID(env, clazz,
+            "cursorWindowPoolBytes");
+    if (gSQLiteDebugPagerStatsClassInfo.cursorWindowPoolMisses == nullptr ||
+            gSQLiteDebugPagerStatsClassInfo.cursorWindowPoolBytes == nullptr) {
+        gSQLiteDebugPagerStatsClassInfo.cursorWindowPoolHits = nullptr;
+    }
 
     return RegisterMethodsOrDie(env, "android/database/sqlite/SQLiteDebug",
             gMethods, NELEM(gMethods));
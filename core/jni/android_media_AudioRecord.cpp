@@ -436,7 +436,8 @@ static jint android_media_AudioRecord_readInArray(JNIEnv *env,  jobject thiz,
     ssize_t readSize = lpRecorder->read(
             recordBuff + offsetInSamples, sizeInBytes, isReadBlocking == JNI_TRUE /* blocking */);
 
-    envReleaseArrayElements(env, javaAudioData, recordBuff, 0);
+    // Only copy back into the Java array if anything was recorded into it.
+    envReleaseArrayElements(env, javaAudioData, recordBuff, readSize > 0 ? 0 : JNI_ABORT);
 
     if (readSize < 0) {
         return interpretReadSizeError(readSize);
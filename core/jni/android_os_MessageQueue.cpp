@@ -22,6 +22,9 @@
 
 #include <utils/Looper.h>
 #include <utils/Log.h>
+
+#include <atomic>
+
 #include "android_os_MessageQueue.h"
 
 #include "core_jni_helpers.h"
@@ -71,6 +74,10 @@ private:
     JNIEnv* mPollEnv;
     jobject mPollObj;
     jthrowable mExceptionObj;
+
+    // Set by wake() and cleared when pollOnce() returns. While it is set, the looper has a wake
+    // it hasn't returned from yet, so another one would not change anything.
+    std::atomic<bool> mWakePending;
 };
 
 
@@ -92,7 +99,7 @@ bool MessageQueue::raiseAndClearException(JNIEnv* env, const char* msg) {
 }
 
 NativeMessageQueue::NativeMessageQueue() :
-        mPollEnv(NULL), mPollObj(NULL), mExceptionObj(NULL) {
+        mPollEnv(NULL), mPollObj(NULL), mExceptionObj(NULL), mWakePending(false) {
     mLooper = Looper::getForThread();
     if (mLooper == NULL) {
         mLooper = new Looper(false);
@@ -127,6 +134,10 @@ void NativeMessageQueue::pollOnce(JNIEnv* env, jobject pollObj, int timeoutMilli
     mPollObj = NULL;
     mPollEnv = NULL;
 
+    // The caller looks at its queue after this returns, so from here on a wake is needed again
+    // for anything enqueued after that.
+    mWakePending.store(false);
+
     if (mExceptionObj) {
         env->Throw(mExceptionObj);
         env->DeleteLocalRef(mExceptionObj);
@@ -135,6 +146,9 @@ void NativeMessageQueue::pollOnce(JNIEnv* env, jobject pollObj, int timeoutMilli
 }
 
 void NativeMessageQueue::wake() {
+    if (mWakePending.exchange(true)) {
+        return;
+    }
     mLooper->wake();
 }
 
@@ -26,8 +26,13 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <unordered_set>
 
 #include "android-base/logging.h"
 #include "android-base/properties.h"
@@ -135,9 +140,16 @@ static jint CopyValue(JNIEnv* env, const AssetManager2::SelectedValue& value,
 
 // ----------------------------------------------------------------------------
 
+static std::atomic<uint64_t> gNextAssetManagerId = 1;
+
 // Let the opaque type AAssetManager refer to a guarded AssetManager2 instance.
 struct GuardedAssetManager : public ::AAssetManager {
   Guarded<AssetManager2> guarded_assetmanager;
+
+  // Identify this AssetManager and the state of its ApkAssets and configuration for the copies
+  // that background threads read from. The generation only changes with the lock held.
+  const uint64_t id = gNextAssetManagerId.fetch_add(1, std::memory_order_relaxed);
+  std::atomic<uint64_t> generation = 0;
 };
 
 ::AAssetManager* NdkAssetManagerForJavaObject(JNIEnv* env, jobject jassetmanager) {
@@ -186,6 +198,76 @@ ScopedLockedAssetsOperation LockAndStartAssetManager(jlong ptr) {
   return ScopedLockedAssetsOperation(AssetManagerFromLong(ptr));
 }
 
+// Must be called with the lock held after changing the ApkAssets, configurations or settings of
+// the AssetManager, so the background threads drop their stale copies.
+static void MarkAssetManagerChanged(jlong ptr) {
+  reinterpret_cast<GuardedAssetManager*>(ptr)->generation.fetch_add(1, std::memory_order_release);
+}
+
+// Returns whether the calling thread reads resources from its own copy of the AssetManager rather
+// than from the shared one. Background threads such as the async layout inflaters then don't
+// serialize with the UI thread on the lock, at the price of a copy of the AssetManager and its
+// caches per thread. The UI thread keeps using the shared AssetManager and its warm caches.
+static bool UsesReaderCopy() {
+#if defined(__ANDROID__)
+  static const bool enabled = base::GetBoolProperty("ro.resources.reader_copies", false);
+  return enabled && gettid() != getpid();
+#else
+  return false;
+#endif
+}
+
+// The copy of the last AssetManager that the thread read from.
+struct ReaderCopy {
+  uint64_t id = 0;
+  uint64_t generation = 0;
+  std::unique_ptr<AssetManager2> assetmanager;
+};
+
+static AssetManager2* GetReaderCopy(GuardedAssetManager& guarded) {
+  if (!UsesReaderCopy()) {
+    return nullptr;
+  }
+  static thread_local ReaderCopy reader_copy;
+  if (reader_copy.assetmanager == nullptr || reader_copy.id != guarded.id ||
+      reader_copy.generation != guarded.generation.load(std::memory_order_acquire)) {
+    // A change that is being made right now shows up on the next call, as with any snapshot.
+    ScopedLock<AssetManager2> locked(guarded.guarded_assetmanager);
+    reader_copy.assetmanager = locked->Clone();
+    reader_copy.id = guarded.id;
+    reader_copy.generation = guarded.generation.load(std::memory_order_relaxed);
+  }
+  return reader_copy.assetmanager.get();
+}
+
+// Like ScopedLockedAssetsOperation, but for the calls that only read resources: threads that have
+// a reader copy use it without taking the lock.
+class ScopedReadAssetsOperation {
+ public:
+  explicit ScopedReadAssetsOperation(GuardedAssetManager& guarded)
+        : reader_(GetReaderCopy(guarded)),
+          am_(reader_ != nullptr ? *reader_ : **lock_.emplace(guarded.guarded_assetmanager)),
+          op_(am_.StartOperation()) {}
+
+  AssetManager2& operator*() { return am_; }
+
+  AssetManager2* operator->() { return &am_; }
+
+  AssetManager2* get() { return &am_; }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ScopedReadAssetsOperation);
+
+  AssetManager2* reader_;
+  std::optional<ScopedLock<AssetManager2>> lock_;
+  AssetManager2& am_;
+  AssetManager2::ScopedOperation op_;
+};
+
+ScopedReadAssetsOperation ReadAndStartAssetManager(jlong ptr) {
+  return ScopedReadAssetsOperation(*reinterpret_cast<GuardedAssetManager*>(ptr));
+}
+
 static jobject NativeGetOverlayableMap(JNIEnv* env, jclass /*clazz*/, jlong ptr,
                                        jstring package_name) {
   auto assetmanager = LockAndStartAssetManager(ptr);
@@ -285,7 +367,48 @@ static jint NativeGetGlobalAssetCount(JNIEnv* /*env*/, jobject /*clazz*/) {
   return Asset::getGlobalCount();
 }
 
+// All live AssetManagers, so that their memory usage can be reported for the whole process.
+static std::mutex gAssetManagersLock;
+static std::unordered_set<GuardedAssetManager*>& AllAssetManagers() {
+  static auto* const asset_managers = new std::unordered_set<GuardedAssetManager*>();
+  return *asset_managers;
+}
+
+// Publishes the memory used by all AssetManagers of the process as trace counters, which Perfetto
+// records. ApkAssets shared between AssetManagers are only counted once. The breakdown of a single
+// AssetManager is part of AssetManager2::DumpToLog().
+static void TraceAssetManagersMemoryUsage() {
+  size_t cache_bytes = 0;
+  MemoryUsage apk_assets_usage;
+  std::unordered_set<const ApkAssets*> seen_apk_assets;
+
+  std::lock_guard registry_lock(gAssetManagersLock);
+  for (GuardedAssetManager* guarded : AllAssetManagers()) {
+    ScopedLock<AssetManager2> assetmanager(guarded->guarded_assetmanager);
+    cache_bytes += assetmanager->GetCacheMemoryUsage().total();
+
+    auto op = assetmanager->StartOperation();
+    for (int i = 0, count = assetmanager->GetApkAssetsCount(); i < count; i++) {
+      const auto& apk_assets = assetmanager->GetApkAssets(i);
+      if (apk_assets != nullptr && seen_apk_assets.insert(apk_assets.get()).second) {
+        apk_assets_usage += apk_assets->GetTableMemoryUsage();
+        apk_assets_usage += apk_assets->GetIdmapMemoryUsage();
+      }
+    }
+  }
+
+  ATRACE_INT64("AssetManager cache heap", cache_bytes);
+  ATRACE_INT64("ApkAssets heap", apk_assets_usage.heap_bytes);
+  ATRACE_INT64("ApkAssets mapped", apk_assets_usage.mapped_bytes);
+  ATRACE_INT64("ApkAssets resident", apk_assets_usage.resident_bytes);
+}
+
 static jobject NativeGetAssetAllocations(JNIEnv* env, jobject /*clazz*/) {
+  // The allocations keep their format for the tools reading dumpsys meminfo. The memory usage goes
+  // to the trace counters instead, and dumping is a good time to refresh them.
+  if (ATRACE_ENABLED()) {
+    TraceAssetManagersMemoryUsage();
+  }
   String8 alloc = Asset::getAssetAllocations();
   if (alloc.length() <= 0) {
     return nullptr;
@@ -301,11 +424,19 @@ static jint NativeGetGlobalAssetManagerCount(JNIEnv* /*env*/, jobject /*clazz*/)
 static jlong NativeCreate(JNIEnv* /*env*/, jclass /*clazz*/) {
   // AssetManager2 needs to be protected by a lock. To avoid cache misses, we allocate the lock and
   // AssetManager2 in a contiguous block (GuardedAssetManager).
-  return reinterpret_cast<jlong>(new GuardedAssetManager());
+  auto* guarded = new GuardedAssetManager();
+  std::lock_guard registry_lock(gAssetManagersLock);
+  AllAssetManagers().insert(guarded);
+  return reinterpret_cast<jlong>(guarded);
 }
 
 static void NativeDestroy(JNIEnv* /*env*/, jclass /*clazz*/, jlong ptr) {
-  delete reinterpret_cast<GuardedAssetManager*>(ptr);
+  auto* guarded = reinterpret_cast<GuardedAssetManager*>(ptr);
+  {
+    std::lock_guard registry_lock(gAssetManagersLock);
+    AllAssetManagers().erase(guarded);
+  }
+  delete guarded;
 }
 
 static void NativeSetApkAssets(JNIEnv* env, jclass /*clazz*/, jlong ptr,
@@ -338,11 +469,19 @@ static void NativeSetApkAssets(JNIEnv* env, jclass /*clazz*/, jlong ptr,
     apk_assets.emplace_back(*scoped_assets);
   }
 
-  auto assetmanager = LockAndStartAssetManager(ptr);
-  if (preset) {
-    assetmanager->PresetApkAssets(apk_assets);
-  } else {
-    assetmanager->SetApkAssets(apk_assets, invalidate_caches);
+  {
+    auto assetmanager = LockAndStartAssetManager(ptr);
+    if (preset) {
+      assetmanager->PresetApkAssets(apk_assets);
+    } else {
+      assetmanager->SetApkAssets(apk_assets, invalidate_caches);
+    }
+    MarkAssetManagerChanged(ptr);
+  }
+
+  // The set of ApkAssets is what changes the memory usage the most, keep the counters current.
+  if (ATRACE_ENABLED()) {
+    TraceAssetManagersMemoryUsage();
   }
 }
 
@@ -414,6 +553,7 @@ static void NativeSetConfiguration(JNIEnv* env, jclass /*clazz*/, jlong ptr, jin
     auto assetmanager = LockAndStartAssetManager(ptr);
     assetmanager->SetConfigurations(std::move(configs), force_refresh != JNI_FALSE);
     assetmanager->SetDefaultLocale(default_locale_opt);
+    MarkAssetManagerChanged(ptr);
 }
 
 static void NativeSetOverlayConstraints(JNIEnv* /*env*/, jclass /*clazz*/, jlong ptr,
@@ -423,6 +563,7 @@ static void NativeSetOverlayConstraints(JNIEnv* /*env*/, jclass /*clazz*/, jlong
     auto assetmanager = LockAndStartAssetManager(ptr);
     assetmanager->SetOverlayConstraints(static_cast<int32_t>(displayId),
                                         static_cast<int32_t>(deviceId));
+    MarkAssetManagerChanged(ptr);
 }
 
 static jobject NativeGetAssignedPackageIdentifiers(JNIEnv* env, jclass /*clazz*/, jlong ptr,
@@ -639,7 +780,7 @@ static jlong NativeOpenXmlAsset(JNIEnv* env, jobject /*clazz*/, jlong ptr, jint
   }
 
   auto xml_tree = util::make_unique<ResXMLTree>(assetmanager->GetDynamicRefTableForCookie(cookie));
-  status_t err = xml_tree->setTo(buffer.unsafe_ptr(), length, true);
+  status_t err = xml_tree->setTo(buffer.unsafe_ptr(), length, true, true /*indexAttributes*/);
   if (err != NO_ERROR) {
     jniThrowException(env, "java/io/FileNotFoundException", "Corrupt XML binary file");
     return 0;
@@ -678,7 +819,7 @@ static jlong NativeOpenXmlAssetFd(JNIEnv* env, jobject /*clazz*/, jlong ptr, int
   }
 
   auto xml_tree = util::make_unique<ResXMLTree>(assetmanager->GetDynamicRefTableForCookie(cookie));
-  status_t err = xml_tree->setTo(buffer.unsafe_ptr(), length, true);
+  status_t err = xml_tree->setTo(buffer.unsafe_ptr(), length, true, true /*indexAttributes*/);
   if (err != NO_ERROR) {
     jniThrowException(env, "java/io/FileNotFoundException", "Corrupt XML binary file");
     return 0;
@@ -689,7 +830,7 @@ static jlong NativeOpenXmlAssetFd(JNIEnv* env, jobject /*clazz*/, jlong ptr, int
 static jint NativeGetResourceValue(JNIEnv* env, jclass /*clazz*/, jlong ptr, jint resid,
                                    jshort density, jobject typed_value,
                                    jboolean resolve_references) {
-  auto assetmanager = LockAndStartAssetManager(ptr);
+  auto assetmanager = ReadAndStartAssetManager(ptr);
   ResourceTimer _timer(ResourceTimer::Counter::GetResourceValue);
 
   auto value = assetmanager->GetResource(static_cast<uint32_t>(resid), false /*may_be_bag*/,
@@ -709,7 +850,7 @@ static jint NativeGetResourceValue(JNIEnv* env, jclass /*clazz*/, jlong ptr, jin
 
 static jint NativeGetResourceBagValue(JNIEnv* env, jclass /*clazz*/, jlong ptr, jint resid,
                                       jint bag_entry_id, jobject typed_value) {
-  auto assetmanager = LockAndStartAssetManager(ptr);
+  auto assetmanager = ReadAndStartAssetManager(ptr);
 
   auto bag = assetmanager->GetBag(static_cast<uint32_t>(resid));
   if (!bag.has_value()) {
@@ -759,7 +900,7 @@ static jintArray NativeGetStyleAttributes(JNIEnv* env, jclass /*clazz*/, jlong p
 
 static jobjectArray NativeGetResourceStringArray(JNIEnv* env, jclass /*clazz*/, jlong ptr,
                                                  jint resid) {
-  auto assetmanager = LockAndStartAssetManager(ptr);
+  auto assetmanager = ReadAndStartAssetManager(ptr);
 
   auto bag_result = assetmanager->GetBag(static_cast<uint32_t>(resid));
   if (!bag_result.has_value()) {
@@ -818,7 +959,7 @@ static jobjectArray NativeGetResourceStringArray(JNIEnv* env, jclass /*clazz*/,
 
 static jintArray NativeGetResourceStringArrayInfo(JNIEnv* env, jclass /*clazz*/, jlong ptr,
                                                   jint resid) {
-  auto assetmanager = LockAndStartAssetManager(ptr);
+  auto assetmanager = ReadAndStartAssetManager(ptr);
 
   auto bag_result = assetmanager->GetBag(static_cast<uint32_t>(resid));
   if (!bag_result.has_value()) {
@@ -857,7 +998,7 @@ static jintArray NativeGetResourceStringArrayInfo(JNIEnv* env, jclass /*clazz*/,
 }
 
 static jintArray NativeGetResourceIntArray(JNIEnv* env, jclass /*clazz*/, jlong ptr, jint resid) {
-  auto assetmanager = LockAndStartAssetManager(ptr);
+  auto assetmanager = ReadAndStartAssetManager(ptr);
 
   auto bag_result = assetmanager->GetBag(static_cast<uint32_t>(resid));
   if (!bag_result.has_value()) {
@@ -893,7 +1034,7 @@ static jintArray NativeGetResourceIntArray(JNIEnv* env, jclass /*clazz*/, jlong
 }
 
 static jint NativeGetResourceArraySize(JNIEnv* env, jclass /*clazz*/, jlong ptr, jint resid) {
-  auto assetmanager = LockAndStartAssetManager(ptr);
+  auto assetmanager = ReadAndStartAssetManager(ptr);
   auto bag = assetmanager->GetBag(static_cast<uint32_t>(resid));
   if (!bag.has_value()) {
     return -1;
@@ -903,7 +1044,7 @@ static jint NativeGetResourceArraySize(JNIEnv* env, jclass /*clazz*/, jlong ptr,
 
 static jint NativeGetResourceArray(JNIEnv* env, jclass /*clazz*/, jlong ptr, jint resid,
                                    jintArray out_data) {
-    auto assetmanager = LockAndStartAssetManager(ptr);
+    auto assetmanager = ReadAndStartAssetManager(ptr);
 
     auto bag_result = assetmanager->GetBag(static_cast<uint32_t>(resid));
     if (!bag_result.has_value()) {
@@ -982,7 +1123,7 @@ static jint NativeGetResourceIdentifier(JNIEnv* env, jclass /*clazz*/, jlong ptr
     package = package_utf8.c_str();
   }
 
-  auto assetmanager = LockAndStartAssetManager(ptr);
+  auto assetmanager = ReadAndStartAssetManager(ptr);
   auto resid = assetmanager->GetResourceId(name_utf8.c_str(), type, package);
   if (!resid.has_value()) {
     return 0;
@@ -992,7 +1133,7 @@ static jint NativeGetResourceIdentifier(JNIEnv* env, jclass /*clazz*/, jlong ptr
 }
 
 static jstring NativeGetResourceName(JNIEnv* env, jclass /*clazz*/, jlong ptr, jint resid) {
-  auto assetmanager = LockAndStartAssetManager(ptr);
+  auto assetmanager = ReadAndStartAssetManager(ptr);
   auto name = assetmanager->GetResourceName(static_cast<uint32_t>(resid));
   if (!name.has_value()) {
     return nullptr;
@@ -1003,7 +1144,7 @@ static jstring NativeGetResourceName(JNIEnv* env, jclass /*clazz*/, jlong ptr, j
 }
 
 static jstring NativeGetResourcePackageName(JNIEnv* env, jclass /*clazz*/, jlong ptr, jint resid) {
-  auto assetmanager = LockAndStartAssetManager(ptr);
+  auto assetmanager = ReadAndStartAssetManager(ptr);
   auto name = assetmanager->GetResourceName(static_cast<uint32_t>(resid));
   if (!name.has_value()) {
     return nullptr;
@@ -1016,7 +1157,7 @@ static jstring NativeGetResourcePackageName(JNIEnv* env, jclass /*clazz*/, jlong
 }
 
 static jstring NativeGetResourceTypeName(JNIEnv* env, jclass /*clazz*/, jlong ptr, jint resid) {
-  auto assetmanager = LockAndStartAssetManager(ptr);
+  auto assetmanager = ReadAndStartAssetManager(ptr);
   auto name = assetmanager->GetResourceName(static_cast<uint32_t>(resid));
   if (!name.has_value()) {
     return nullptr;
@@ -1031,7 +1172,7 @@ static jstring NativeGetResourceTypeName(JNIEnv* env, jclass /*clazz*/, jlong pt
 }
 
 static jstring NativeGetResourceEntryName(JNIEnv* env, jclass /*clazz*/, jlong ptr, jint resid) {
-  auto assetmanager = LockAndStartAssetManager(ptr);
+  auto assetmanager = ReadAndStartAssetManager(ptr);
   auto name = assetmanager->GetResourceName(static_cast<uint32_t>(resid));
   if (!name.has_value()) {
     return nullptr;
@@ -1160,7 +1301,8 @@ static jintArray NativeAttributeResolutionStack(JNIEnv* env, jclass /*clazz*/, j
     jniThrowIOException(env, EBADMSG);
     return nullptr;
   }
-  const auto& style_stack = *maybe_style_stack.value();
+  // Copy the stack, as retrieving the next one may reallocate the cache that holds it.
+  const std::vector<uint32_t> style_stack = *maybe_style_stack.value();
   const auto maybe_def_style_stack = assetmanager->GetBagResIdStack(def_style_resid);
   if (!maybe_def_style_stack.ok()) {
     jniThrowIOException(env, EBADMSG);
@@ -15,6 +15,7 @@
  */
 #define LOG_TAG "JavaBinder"
 // #define LOG_NDEBUG 0
+#define ATRACE_TAG ATRACE_TAG_AIDL
 
 #include "android_util_Binder.h"
 
@@ -42,11 +43,13 @@
 #include <utils/Log.h>
 #include <utils/String8.h>
 #include <utils/SystemClock.h>
+#include <utils/Trace.h>
 #include <utils/threads.h>
 
 #include <atomic>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include "android_os_Parcel.h"
 #include "core_jni_helpers.h"
@@ -956,6 +959,113 @@ BinderProxyNativeData* getBPNativeData(JNIEnv* env, jobject obj) {
     return (BinderProxyNativeData *) env->GetLongField(obj, gBinderProxyOffsets.mNativeData);
 }
 
+// Weak references to live BinderProxy objects by IBinder, so that finding the proxy of a binder
+// we have seen before neither allocates a BinderProxyNativeData nor takes the lock around the
+// Java proxy map. This is only a cache: BinderProxy.getInstance() still owns the canonical map
+// and every miss goes through it. Sharded by IBinder address to keep binder threads apart.
+class BinderProxyCache {
+public:
+    // Returns a local reference to the live BinderProxy for binder, or NULL.
+    jobject find(JNIEnv* env, IBinder* binder) {
+        Shard& shard = shardFor(binder);
+        std::unique_lock<std::mutex> lock = lockShard(shard);
+        auto it = shard.proxies.find(binder);
+        if (it == shard.proxies.end()) {
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            return NULL;
+        }
+        jobject object = env->NewLocalRef(it->second);
+        // A live BinderProxy keeps its IBinder alive, so the address can't have been reused.
+        if (object == NULL || getBPNativeData(env, object)->mObject.get() != binder) {
+            if (object != NULL) {
+                env->DeleteLocalRef(object);
+            }
+            env->DeleteWeakGlobalRef(it->second);
+            shard.proxies.erase(it);
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            return NULL;
+        }
+        shard.hits.fetch_add(1, std::memory_order_relaxed);
+        return object;
+    }
+
+    void insert(JNIEnv* env, IBinder* binder, jobject proxy) {
+        Shard& shard = shardFor(binder);
+        std::unique_lock<std::mutex> lock = lockShard(shard);
+        auto it = shard.proxies.find(binder);
+        if (it != shard.proxies.end()) {
+            env->DeleteWeakGlobalRef(it->second);
+            it->second = env->NewWeakGlobalRef(proxy);
+            return;
+        }
+        if (shard.proxies.size() >= kMaxProxiesPerShard) {
+            // Drop every collected proxy at once rather than checking on each insert.
+            for (it = shard.proxies.begin(); it != shard.proxies.end();) {
+                if (env->IsSameObject(it->second, NULL)) {
+                    env->DeleteWeakGlobalRef(it->second);
+                    it = shard.proxies.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (shard.proxies.size() >= kMaxProxiesPerShard) {
+                it = shard.proxies.begin();
+                env->DeleteWeakGlobalRef(it->second);
+                shard.proxies.erase(it);
+            }
+        }
+        jweak ref = env->NewWeakGlobalRef(proxy);
+        if (ref != NULL) {
+            shard.proxies.emplace(binder, ref);
+        }
+    }
+
+    // Publishes the hits, misses and lock contentions of all shards as trace counters.
+    void traceStats() {
+        int64_t hits = 0, misses = 0, contended = 0;
+        for (Shard& shard : mShards) {
+            hits += shard.hits.load(std::memory_order_relaxed);
+            misses += shard.misses.load(std::memory_order_relaxed);
+            contended += shard.contended.load(std::memory_order_relaxed);
+        }
+        ATRACE_INT64("BinderProxy cache hits", hits);
+        ATRACE_INT64("BinderProxy cache misses", misses);
+        ATRACE_INT64("BinderProxy cache contended", contended);
+    }
+
+private:
+    static constexpr size_t kShardCount = 16;
+    // Bounds the weak global references held by the cache, which count against the VM's limit.
+    static constexpr size_t kMaxProxiesPerShard = 256;
+
+    struct Shard {
+        std::mutex lock;
+        std::unordered_map<IBinder*, jweak> proxies;
+        std::atomic<int64_t> hits{0};
+        std::atomic<int64_t> misses{0};
+        // Times the shard lock was already held by another thread.
+        std::atomic<int64_t> contended{0};
+    };
+
+    Shard& shardFor(IBinder* binder) {
+        // The low bits of an allocation address carry no information.
+        return mShards[(reinterpret_cast<uintptr_t>(binder) >> 4) % kShardCount];
+    }
+
+    static std::unique_lock<std::mutex> lockShard(Shard& shard) {
+        std::unique_lock<std::mutex> lock(shard.lock, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            shard.contended.fetch_add(1, std::memory_order_relaxed);
+            lock.lock();
+        }
+        return lock;
+    }
+
+    Shard mShards[kShardCount];
+};
+
+static BinderProxyCache gBinderProxyCache;
+
 // If the argument is a JavaBBinder, return the Java object that was used to create it.
 // Otherwise return a BinderProxy for the IBinder. If a previous call was passed the
 // same IBinder, and the original BinderProxy is still alive, return the same BinderProxy.
@@ -973,6 +1083,10 @@ jobject javaObjectForIBinder(JNIEnv* env, const sp<IBinder>& val)
         return object;
     }
 
+    if (jobject object = gBinderProxyCache.find(env, val.get())) {
+        return object;
+    }
+
     BinderProxyNativeData* nativeData = new BinderProxyNativeData();
     nativeData->mOrgue = sp<DeathRecipientList>::make();
     nativeData->mFrozenStateChangeCallbackList = sp<FrozenStateChangeCallbackList>::make();
@@ -988,6 +1102,7 @@ jobject javaObjectForIBinder(JNIEnv* env, const sp<IBinder>& val)
     if (actualNativeData != nativeData) {
         delete nativeData;
     }
+    gBinderProxyCache.insert(env, val.get(), object);
 
     return object;
 }
@@ -1401,6 +1516,9 @@ static void android_os_BinderInternal_handleGc(JNIEnv* env, jobject clazz)
 {
     ALOGV("Gc has executed, updating Refs count at GC");
     gCollectedAtRefs = gNumLocalRefsCreated + gNumDeathRefsCreated;
+    if (ATRACE_ENABLED()) {
+        gBinderProxyCache.traceStats();
+    }
 }
 
 static void android_os_BinderInternal_proxyLimitCallback(int uid)
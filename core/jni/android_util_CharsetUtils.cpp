@@ -24,8 +24,11 @@ static jint android_util_CharsetUtils_toModifiedUtf8Bytes(JNIEnv *env, jobject c
     char *destPtr = reinterpret_cast<char*>(dest);
 
     // Quickly check if destination has plenty of room for worst-case
-    // 4-bytes-per-char encoded size
-    const jint worstLen = (srcLen * 4);
+    // 3-bytes-per-char encoded size. Modified UTF-8 encodes each UTF-16 unit
+    // separately, including both halves of a surrogate pair, and none of them
+    // takes more than 3 bytes. The tighter bound lets more strings skip the
+    // measuring pass below.
+    const jint worstLen = (srcLen * 3);
     if (destOff >= 0 && destOff + worstLen < destLen) {
         env->GetStringUTFRegion(src, 0, srcLen, destPtr + destOff);
         return strlen(destPtr + destOff + srcLen) + srcLen;
@@ -67,6 +67,46 @@ bool android_util_Log_isVerboseLogEnabled(const char* tag) {
     return isLoggable(tag, levels.verbose);
 }
 
+/*
+ * The modified UTF-8 chars of a Java string, converted into the given buffer when they fit so
+ * that the common short tag and message cost no allocation, and obtained from
+ * GetStringUTFChars otherwise.
+ */
+class ScopedLogChars {
+public:
+    ScopedLogChars(JNIEnv* env, jstring str, char* buffer, size_t size)
+        : mEnv(env), mStr(str), mChars(NULL), mOwned(false) {
+        if (str == NULL) {
+            return;
+        }
+        const jsize utfLength = env->GetStringUTFLength(str);
+        if (size_t(utfLength) < size) {
+            env->GetStringUTFRegion(str, 0, env->GetStringLength(str), buffer);
+            buffer[utfLength] = '\0';
+            mChars = buffer;
+        } else {
+            mChars = env->GetStringUTFChars(str, NULL);
+            mOwned = mChars != NULL;
+        }
+    }
+
+    ~ScopedLogChars() {
+        if (mOwned) {
+            mEnv->ReleaseStringUTFChars(mStr, mChars);
+        }
+    }
+
+    const char* c_str() const { return mChars; }
+
+private:
+    JNIEnv* mEnv;
+    jstring mStr;
+    const char* mChars;
+    bool mOwned;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedLogChars);
+};
+
 /*
  * In class android.util.Log:
  *  public static native int println_native(int buffer, int priority, String tag, String msg)
@@ -74,9 +114,6 @@ bool android_util_Log_isVerboseLogEnabled(const char* tag) {
 static jint android_util_Log_println_native(JNIEnv* env, jobject clazz,
         jint bufID, jint priority, jstring tagObj, jstring msgObj)
 {
-    const char* tag = NULL;
-    const char* msg = NULL;
-
     if (msgObj == NULL) {
         jniThrowNullPointerException(env, "println needs a message");
         return -1;
@@ -87,17 +124,14 @@ static jint android_util_Log_println_native(JNIEnv* env, jobject clazz,
         return -1;
     }
 
-    if (tagObj != NULL)
-        tag = env->GetStringUTFChars(tagObj, NULL);
-    msg = env->GetStringUTFChars(msgObj, NULL);
-
-    int res = __android_log_buf_write(bufID, (android_LogPriority)priority, tag, msg);
-
-    if (tag != NULL)
-        env->ReleaseStringUTFChars(tagObj, tag);
-    env->ReleaseStringUTFChars(msgObj, msg);
+    // liblog truncates anything longer than the payload, so that bounds the common case.
+    char tagBuffer[128];
+    char msgBuffer[LOGGER_ENTRY_MAX_PAYLOAD];
+    ScopedLogChars tag(env, tagObj, tagBuffer, sizeof(tagBuffer));
+    ScopedLogChars msg(env, msgObj, msgBuffer, sizeof(msgBuffer));
 
-    return res;
+    return __android_log_buf_write(bufID, (android_LogPriority)priority, tag.c_str(),
+                                   msg.c_str());
 }
 
 /*
@@ -27,10 +27,88 @@
 
 #include <stdio.h>
 
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
 namespace android {
 
 // ----------------------------------------------------------------------------
 
+// A process-wide LRU cache of the Java strings created for short pool strings. Layout inflation
+// asks for the same attribute values and theme names over and over, and every call would
+// otherwise decode the string and allocate a new java.lang.String.
+//
+// Entries are keyed by ResStringPool::serial(), which is never reused, so a destroyed pool can't
+// produce stale hits; its strings simply age out of the cache.
+class JavaStringCache {
+public:
+    // Only strings up to this length are cached, long ones are rarely asked for repeatedly.
+    static constexpr size_t kMaxStringLength = 64;
+
+    // Returns a new local reference to the cached string, or NULL.
+    jstring get(JNIEnv* env, const ResStringPool& pool, jint idx) {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = mEntries.find(Key{pool.serial(), idx});
+        if (it == mEntries.end()) {
+            return NULL;
+        }
+        mLru.splice(mLru.begin(), mLru, it->second);
+        return static_cast<jstring>(env->NewLocalRef(it->second->second));
+    }
+
+    void put(JNIEnv* env, const ResStringPool& pool, jint idx, jstring str) {
+        jobject global = env->NewGlobalRef(str);
+        if (global == NULL) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mLock);
+        auto [it, inserted] = mEntries.try_emplace(Key{pool.serial(), idx});
+        if (!inserted) {
+            // Another thread cached the same string in the meantime.
+            env->DeleteGlobalRef(global);
+            return;
+        }
+        mLru.emplace_front(it->first, global);
+        it->second = mLru.begin();
+        if (mLru.size() > kMaxEntries) {
+            env->DeleteGlobalRef(mLru.back().second);
+            mEntries.erase(mLru.back().first);
+            mLru.pop_back();
+        }
+    }
+
+private:
+    static constexpr size_t kMaxEntries = 512;
+
+    struct Key {
+        uint64_t serial;
+        jint idx;
+
+        bool operator==(const Key& other) const {
+            return serial == other.serial && idx == other.idx;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<uint64_t>()(key.serial * 31 + static_cast<uint32_t>(key.idx));
+        }
+    };
+
+    using LruList = std::list<std::pair<Key, jobject>>;
+
+    std::mutex mLock;
+    LruList mLru;
+    std::unordered_map<Key, LruList::iterator, KeyHash> mEntries;
+};
+
+static JavaStringCache& getJavaStringCache() {
+    static JavaStringCache* cache = new JavaStringCache();
+    return *cache;
+}
+
 static jlong android_content_StringBlock_nativeCreate(JNIEnv* env, jobject clazz, jbyteArray bArray,
                                                       jint off, jint len) {
     if (bArray == NULL) {
@@ -75,19 +153,32 @@ static jstring android_content_StringBlock_nativeGetString(JNIEnv* env, jobject
         return NULL;
     }
 
-    if (auto str8 = osb->string8At(idx); str8.has_value()) {
-        return env->NewStringUTF(str8->data());
+    JavaStringCache& cache = getJavaStringCache();
+    if (jstring cached = cache.get(env, *osb, idx); cached != NULL) {
+        return cached;
     }
 
-    auto str = osb->stringAt(idx);
-    if (IsIOError(str)) {
-        return NULL;
-    } else if (UNLIKELY(!str.has_value())) {
-        jniThrowException(env, "java/lang/IndexOutOfBoundsException", NULL);
-        return NULL;
+    jstring result;
+    size_t length;
+    if (auto str8 = osb->string8At(idx); str8.has_value()) {
+        result = env->NewStringUTF(str8->data());
+        length = str8->size();
+    } else {
+        auto str = osb->stringAt(idx);
+        if (IsIOError(str)) {
+            return NULL;
+        } else if (UNLIKELY(!str.has_value())) {
+            jniThrowException(env, "java/lang/IndexOutOfBoundsException", NULL);
+            return NULL;
+        }
+        result = env->NewString((const jchar*)str->data(), str->size());
+        length = str->size();
     }
 
-    return env->NewString((const jchar*)str->data(), str->size());
+    if (result != NULL && length <= JavaStringCache::kMaxStringLength) {
+        cache.put(env, *osb, idx, result);
+    }
+    return result;
 }
 
 static jintArray android_content_StringBlock_nativeGetStyle(JNIEnv* env, jobject clazz, jlong token,
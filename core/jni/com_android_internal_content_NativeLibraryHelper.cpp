@@ -37,8 +37,11 @@
 #include <utils/Log.h>
 #include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "com_android_internal_content_FileSystemUtils.h"
@@ -147,6 +150,32 @@ sumFiles(JNIEnv*, void* arg, ZipFileRO* zipFile, ZipEntryRO zipEntry, const char
     return INSTALL_SUCCEEDED;
 }
 
+/*
+ * Copies a stored entry straight from the apk file, so that the kernel can share or at least copy
+ * the blocks without bouncing them through a userspace buffer.
+ */
+static bool copyStoredEntry(const char* apkPath, off64_t offset, uint32_t length, int fd) {
+    int apkFd = TEMP_FAILURE_RETRY(open(apkPath, O_RDONLY | O_CLOEXEC));
+    if (apkFd < 0) {
+        return false;
+    }
+    loff_t inOffset = offset;
+    size_t remaining = length;
+    while (remaining > 0) {
+        ssize_t copied =
+                TEMP_FAILURE_RETRY(copy_file_range(apkFd, &inOffset, fd, nullptr, remaining, 0));
+        if (copied <= 0) {
+            break;
+        }
+        remaining -= copied;
+    }
+    if (remaining > 0) {
+        ALOGV("copy_file_range from %s failed: %s", apkPath, strerror(errno));
+    }
+    close(apkFd);
+    return remaining == 0;
+}
+
 static install_status_t extractNativeLibFromApk(ZipFileRO* zipFile, ZipEntryRO zipEntry,
                                                 const char* fileName,
                                                 const std::string nativeLibPath, uint32_t when,
@@ -206,7 +235,24 @@ static install_status_t extractNativeLibFromApk(ZipFileRO* zipFile, ZipEntryRO z
         ioctl(fd, FS_IOC_SETFLAGS, &flags);
     }
 
-    if (!zipFile->uncompressEntry(zipEntry, fd)) {
+    uint16_t method;
+    off64_t offset;
+    static const size_t kPageSize = getpagesize();
+    bool copied = false;
+    if (zipFile->getEntryInfo(zipEntry, &method, nullptr, nullptr, &offset, nullptr, nullptr,
+                              nullptr) &&
+        method == ZipFileRO::kCompressStored && offset % kPageSize == 0 && uncompLen > 0) {
+        copied = copyStoredEntry(zipFile->getZipFileName(), offset, uncompLen, fd);
+        // Start over with a regular extraction.
+        if (!copied && (lseek64(fd, 0, SEEK_SET) != 0 || ftruncate64(fd, 0) != 0)) {
+            ALOGE("Couldn't reset temporary file %s: %s\n", localTmpFileName, strerror(errno));
+            close(fd);
+            unlink(localTmpFileName);
+            return INSTALL_FAILED_CONTAINER_ERROR;
+        }
+    }
+
+    if (!copied && !zipFile->uncompressEntry(zipEntry, fd)) {
         ALOGE("Failed uncompressing %s to %s\n", fileName, localTmpFileName);
         close(fd);
         unlink(localTmpFileName);
@@ -270,6 +316,88 @@ static install_status_t extractNativeLibFromApk(ZipFileRO* zipFile, ZipEntryRO z
     return INSTALL_SUCCEEDED;
 }
 
+/*
+ * The libraries that copyFileIfChanged() leaves to extractQueuedNativeLibs(), so that they are
+ * inflated in parallel once all the entries were checked.
+ */
+struct QueuedNativeLib {
+    // Owned: the entries handed out during the iteration are reused for the next one.
+    ZipEntryRO entry;
+    std::string fileName;
+    uint32_t when;
+    uint32_t uncompLen;
+    uint32_t crc;
+};
+
+struct NativeLibQueue {
+    std::string nativeLibPath;
+    std::vector<QueuedNativeLib> libs;
+
+    ZipFileRO* zipFile = nullptr;
+
+    ~NativeLibQueue() {
+        for (auto& lib : libs) {
+            zipFile->releaseEntry(lib.entry);
+        }
+    }
+};
+
+static install_status_t extractOrQueueNativeLib(ZipFileRO* zipFile, ZipEntryRO zipEntry,
+                                                const char* fileName, const char* nativeLibPath,
+                                                uint32_t when, uint32_t uncompLen, uint32_t crc,
+                                                NativeLibQueue* queue) {
+    if (queue == nullptr) {
+        return extractNativeLibFromApk(zipFile, zipEntry, fileName, nativeLibPath, when, uncompLen,
+                                       crc);
+    }
+    char entryName[PATH_MAX];
+    if (zipFile->getEntryFileName(zipEntry, entryName, sizeof(entryName))) {
+        return INSTALL_FAILED_INVALID_APK;
+    }
+    ZipEntryRO entry = zipFile->findEntryByName(entryName);
+    if (entry == nullptr) {
+        return INSTALL_FAILED_INVALID_APK;
+    }
+    queue->zipFile = zipFile;
+    queue->nativeLibPath = nativeLibPath;
+    queue->libs.push_back({entry, fileName, when, uncompLen, crc});
+    return INSTALL_SUCCEEDED;
+}
+
+static install_status_t extractQueuedNativeLibs(NativeLibQueue& queue, size_t maxThreads) {
+    auto& libs = queue.libs;
+    // Start with the largest libraries, they take the longest to inflate.
+    std::stable_sort(libs.begin(), libs.end(), [](const auto& l, const auto& r) {
+        return l.uncompLen > r.uncompLen;
+    });
+
+    std::atomic<size_t> next = 0;
+    std::atomic<install_status_t> status = INSTALL_SUCCEEDED;
+    auto extract = [&]() {
+        for (size_t i = next++; i < libs.size() && status == INSTALL_SUCCEEDED; i = next++) {
+            const auto& lib = libs[i];
+            install_status_t ret =
+                    extractNativeLibFromApk(queue.zipFile, lib.entry, lib.fileName.c_str(),
+                                            queue.nativeLibPath, lib.when, lib.uncompLen, lib.crc);
+            if (ret != INSTALL_SUCCEEDED) {
+                ALOGV("Failure for entry %s", lib.fileName.c_str());
+                install_status_t expected = INSTALL_SUCCEEDED;
+                status.compare_exchange_strong(expected, ret);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < std::min(libs.size(), maxThreads); i++) {
+        workers.emplace_back(extract);
+    }
+    extract();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return status;
+}
+
 /*
  * Copy the native library if needed.
  *
@@ -284,6 +412,7 @@ static install_status_t copyFileIfChanged(JNIEnv* env, void* arg, ZipFileRO* zip
     jboolean debuggable = *(jboolean*)args[2];
     jboolean app_compat_16kb = *(jboolean*)args[3];
     jboolean pageSizeCompatDisabled = *(jboolean*)args[4];
+    NativeLibQueue* queue = (NativeLibQueue*)args[5];
 
     ScopedUtfChars nativeLibPath(env, *javaNativeLibPath);
 
@@ -330,8 +459,8 @@ static install_status_t copyFileIfChanged(JNIEnv* env, void* arg, ZipFileRO* zip
                 ALOGI("16kB AppCompat: Library '%s' is not PAGE(%zu)-aligned - falling back to "
                       "extraction from apk\n",
                       fileName, kPageSize);
-                return extractNativeLibFromApk(zipFile, zipEntry, fileName, nativeLibPath.c_str(),
-                                               when, uncompLen, crc);
+                return extractOrQueueNativeLib(zipFile, zipEntry, fileName, nativeLibPath.c_str(),
+                                               when, uncompLen, crc, queue);
             }
 
             ALOGE("extractNativeLibs=false library '%s' is not PAGE(%zu)-"
@@ -357,8 +486,8 @@ static install_status_t copyFileIfChanged(JNIEnv* env, void* arg, ZipFileRO* zip
         return INSTALL_SUCCEEDED;
     }
 
-    return extractNativeLibFromApk(zipFile, zipEntry, fileName, nativeLibPath.c_str(), when,
-                                   uncompLen, crc);
+    return extractOrQueueNativeLib(zipFile, zipEntry, fileName, nativeLibPath.c_str(), when,
+                                   uncompLen, crc, queue);
 }
 
 /*
@@ -555,14 +684,31 @@ static inline bool app_compat_16kb_enabled() {
     return !android::base::GetBoolProperty("pm.16kb.app_compat.disabled", false);
 }
 
+static size_t native_lib_extraction_threads() {
+    static const size_t kThreads = [] {
+        const int defaultThreads = std::min(4u, std::max(1u, std::thread::hardware_concurrency()));
+        return std::max(1,
+                        android::base::GetIntProperty("pm.native_lib_extraction_threads",
+                                                      defaultThreads));
+    }();
+    return kThreads;
+}
+
 static jint com_android_internal_content_NativeLibraryHelper_copyNativeBinaries(
         JNIEnv* env, jclass clazz, jlong apkHandle, jstring javaNativeLibPath, jstring javaCpuAbi,
         jboolean extractNativeLibs, jboolean debuggable, jboolean pageSizeCompatDisabled) {
     jboolean app_compat_16kb = app_compat_16kb_enabled();
+    // With more than one thread, the libraries to extract are only collected while iterating.
+    const size_t threads = native_lib_extraction_threads();
+    NativeLibQueue queue;
     void* args[] = {&javaNativeLibPath, &extractNativeLibs, &debuggable, &app_compat_16kb,
-                    &pageSizeCompatDisabled};
-    return (jint) iterateOverNativeFiles(env, apkHandle, javaCpuAbi,
-            copyFileIfChanged, reinterpret_cast<void*>(args));
+                    &pageSizeCompatDisabled, threads > 1 ? &queue : nullptr};
+    install_status_t ret = iterateOverNativeFiles(env, apkHandle, javaCpuAbi, copyFileIfChanged,
+                                                  reinterpret_cast<void*>(args));
+    if (ret != INSTALL_SUCCEEDED || queue.libs.empty()) {
+        return (jint) ret;
+    }
+    return (jint) extractQueuedNativeLibs(queue, threads);
 }
 
 static jlong
@@ -29,7 +29,6 @@
 #include <jni.h>
 #include <libappfuse/FuseAppLoop.h>
 #include <nativehelper/ScopedLocalRef.h>
-#include <nativehelper/ScopedPrimitiveArray.h>
 
 #include "core_jni_helpers.h"
 
@@ -165,10 +164,14 @@ void com_android_internal_os_FuseAppLoop_replyWrite(
 
 void com_android_internal_os_FuseAppLoop_replyRead(
         JNIEnv* env, jobject self, jlong ptr, jlong unique, jint size, jbyteArray data) {
-    ScopedByteArrayRO array(env, data);
     CHECK_GE(size, 0);
-    CHECK_LE(static_cast<size_t>(size), array.size());
-    if (!reinterpret_cast<fuse::FuseAppLoop*>(ptr)->ReplyRead(unique, size, array.get())) {
+    CHECK_LE(size, env->GetArrayLength(data));
+    CHECK_LE(static_cast<size_t>(size), fuse::kFuseMaxRead);
+    // The Java buffer is sized for the largest read, so only copy out the bytes that were read
+    // rather than taking the elements of the whole array.
+    static thread_local std::unique_ptr<jbyte[]> buffer(new jbyte[fuse::kFuseMaxRead]);
+    env->GetByteArrayRegion(data, 0, size, buffer.get());
+    if (!reinterpret_cast<fuse::FuseAppLoop*>(ptr)->ReplyRead(unique, size, buffer.get())) {
         reinterpret_cast<fuse::FuseAppLoop*>(ptr)->Break();
     }
 }
@@ -1904,6 +1904,7 @@ static void SpecializeCommon(JNIEnv* env, uid_t uid, gid_t gid, jintArray gids,
                              bool is_top_app, jobjectArray pkg_data_info_list,
                              jobjectArray allowlisted_data_info_list, bool mount_data_dirs,
                              bool mount_storage_dirs, bool mount_sysprop_overrides) {
+    ATRACE_CALL();
     const char* process_name = is_system_server ? "system_server" : "zygote";
     auto fail_fn = std::bind(ZygoteFailure, env, process_name, managed_nice_name, _1);
     auto extract_fn = std::bind(ExtractJString, env, process_name, managed_nice_name, _1);
@@ -2484,10 +2485,14 @@ pid_t zygote::ForkCommon(JNIEnv* env, bool is_system_server,
   // files are not expected, and will be disallowed in the future.  Currently
   // they are allowed if they pass the same checks as in the
   // FileDescriptorTable::Create() above.
-  if (gOpenFdTable == nullptr) {
-    gOpenFdTable = FileDescriptorTable::Create(fds_to_ignore, fail_fn);
-  } else {
-    gOpenFdTable->Restat(fds_to_ignore, fail_fn);
+  {
+    ATRACE_NAME("ForkCommon: check fds");
+    if (gOpenFdTable == nullptr) {
+      gOpenFdTable = FileDescriptorTable::Create(fds_to_ignore, fail_fn);
+      ATRACE_INT("ZygoteCheckedFds", gOpenFdTable->size());
+    } else {
+      ATRACE_INT("ZygoteCheckedFds", gOpenFdTable->Restat(fds_to_ignore, fail_fn));
+    }
   }
 
   android_fdsan_error_level fdsan_error_level = android_fdsan_get_error_level();
@@ -2503,7 +2508,13 @@ pid_t zygote::ForkCommon(JNIEnv* env, bool is_system_server,
     }
   }
 
+  // The child can't end a section begun by its parent, so the fork itself is
+  // only traced on the zygote side.
+  ATRACE_BEGIN("ForkCommon: fork");
   pid_t pid = fork();
+  if (pid != 0) {
+    ATRACE_END();
+  }
 
   if (pid == 0) {
     if (is_top_app && use_fifo_ui) {
@@ -2533,15 +2544,19 @@ pid_t zygote::ForkCommon(JNIEnv* env, bool is_system_server,
     // The child process.
     PreApplicationInit();
 
-    // Clean up any descriptors which must be closed immediately
-    DetachDescriptors(env, fds_to_close, fail_fn);
+    {
+      ATRACE_NAME("ForkCommon: reopen fds");
+
+      // Clean up any descriptors which must be closed immediately
+      DetachDescriptors(env, fds_to_close, fail_fn);
 
-    // Invalidate the entries in the USAP table.
-    ClearUsapTable();
+      // Invalidate the entries in the USAP table.
+      ClearUsapTable();
 
-    // Re-open all remaining open file descriptors so that they aren't shared
-    // with the zygote across a fork.
-    gOpenFdTable->ReopenOrDetach(fail_fn);
+      // Re-open all remaining open file descriptors so that they aren't shared
+      // with the zygote across a fork.
+      gOpenFdTable->ReopenOrDetach(fail_fn);
+    }
 
     // Turn fdsan back on.
     android_fdsan_set_error_level(fdsan_error_level);
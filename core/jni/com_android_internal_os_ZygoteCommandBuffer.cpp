@@ -28,6 +28,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <jni.h>
+#include <limits>
 #include <nativehelper/JNIHelp.h>
 #include <optional>
 #include <poll.h>
@@ -51,20 +52,35 @@ using android::zygote::ZygoteFailure;
 // Commands and nice names have large arbitrary size limits to avoid dynamic memory allocation.
 constexpr size_t MAX_COMMAND_BYTES = 32768;
 constexpr size_t NICE_NAME_BYTES = 128;
+// The argument count line plus at most MAX_COMMAND_BYTES / 2 - 1 arguments, see getCount().
+constexpr size_t MAX_COMMAND_LINES = MAX_COMMAND_BYTES / 2;
+static_assert(MAX_COMMAND_BYTES <= std::numeric_limits<uint16_t>::max() + 1,
+              "line ends are stored as uint16_t");
 
 // A buffer optionally bundled with a file descriptor from which we can fill it.
 // Does not own the file descriptor; destroying a NativeCommandBuffer does not
 // close the descriptor.
 class NativeCommandBuffer {
  public:
-  NativeCommandBuffer(int sourceFd): mEnd(0), mNext(0), mLinesLeft(0), mFd(sourceFd) {}
+  NativeCommandBuffer(int sourceFd)
+      : mEnd(0), mNext(0), mLine(0), mLinesIndexed(0), mLinesLeft(0), mFd(sourceFd) {}
 
   // Read mNext line from mFd, filling mBuffer from file descriptor, as needed.
   // Return a pair of pointers pointing to the first character, and one past the
   // mEnd of the line, i.e. at the newline. Returns nothing on failure.
+  // The returned pointers reference mBuffer directly and stay valid until clear().
   template<class FailFn>
   std::optional<std::pair<char*, char*>> readLine(FailFn fail_fn) {
     char* result = mBuffer + mNext;
+    if (mLine < mLinesIndexed) {
+      // This line was already scanned before a reset(); don't search it again.
+      if (--mLinesLeft < 0) {
+        fail_fn("ZygoteCommandBuffer.readLine attempted to read past end of command");
+      }
+      char* nl = mBuffer + mLineEnds[mLine++];
+      mNext = nl - mBuffer + 1;
+      return std::make_pair(result, nl);
+    }
     while (true) {
       // We have scanned up to, but not including mNext for this line's newline.
       if (mNext == mEnd) {
@@ -95,6 +111,10 @@ class NativeCommandBuffer {
         if (--mLinesLeft < 0) {
           fail_fn("ZygoteCommandBuffer.readLine attempted to read past end of command");
         }
+        if (mLinesIndexed < MAX_COMMAND_LINES) {
+          mLineEnds[mLinesIndexed++] = nl - mBuffer;
+        }
+        ++mLine;
         return std::make_pair(result, nl);
       }
     }
@@ -102,6 +122,7 @@ class NativeCommandBuffer {
 
   void reset() {
     mNext = 0;
+    mLine = 0;
   }
 
   // Make sure the current command is fully buffered, without reading past the current command.
@@ -117,6 +138,7 @@ class NativeCommandBuffer {
     reset();
     mNiceName[0] = '\0';
     mEnd = 0;
+    mLinesIndexed = 0;
   }
 
   // Insert line into the mBuffer. Checks that the mBuffer is not associated with an mFd.
@@ -316,9 +338,14 @@ class NativeCommandBuffer {
 
   uint32_t mEnd;  // Index of first empty byte in the mBuffer.
   uint32_t mNext;  // Index of first character past last line returned by readLine.
+  uint32_t mLine;  // Index in mLineEnds of the line readLine will return next.
+  uint32_t mLinesIndexed;  // Number of valid entries in mLineEnds.
   int32_t mLinesLeft;  // Lines in current command that haven't yet been read.
   int mFd;  // Open file descriptor from which we can read more. -1 if none.
   char mNiceName[NICE_NAME_BYTES];  // Always null terminated.
+  // Offsets of the newlines of the lines scanned since clear(), so that a command can be read
+  // again after reset() without searching the buffer.
+  uint16_t mLineEnds[MAX_COMMAND_LINES];
   char mBuffer[MAX_COMMAND_BYTES];
 };
 
@@ -483,6 +483,8 @@ void FileDescriptorInfo::DetachSocket(fail_fn_t fail_fn) const {
 // TODO: Move the definitions here and eliminate the forward declarations. They
 // temporarily help making code reviews easier.
 static int ParseFd(dirent* dir_entry, int dir_fd);
+static void ScanOpenFdsIgnoring(const std::vector<int>& fds_to_ignore, std::vector<int>* fds,
+                                fail_fn_t fail_fn);
 static std::unique_ptr<std::set<int>> GetOpenFdsIgnoring(const std::vector<int>& fds_to_ignore,
                                                          fail_fn_t fail_fn);
 
@@ -496,8 +498,9 @@ FileDescriptorTable* FileDescriptorTable::Create(const std::vector<int>& fds_to_
   return new FileDescriptorTable(std::move(open_fd_map));
 }
 
-static std::unique_ptr<std::set<int>> GetOpenFdsIgnoring(const std::vector<int>& fds_to_ignore,
-                                                         fail_fn_t fail_fn) {
+// Fills |fds| with the sorted list of open FDs, reusing its storage.
+static void ScanOpenFdsIgnoring(const std::vector<int>& fds_to_ignore, std::vector<int>* fds,
+                                fail_fn_t fail_fn) {
   DIR* proc_fd_dir = opendir(kFdPath);
   if (proc_fd_dir == nullptr) {
     fail_fn(android::base::StringPrintf("Unable to open directory %s: %s",
@@ -505,7 +508,7 @@ static std::unique_ptr<std::set<int>> GetOpenFdsIgnoring(const std::vector<int>&
                                         strerror(errno)));
   }
 
-  auto result = std::make_unique<std::set<int>>();
+  fds->clear();
   int dir_fd = dirfd(proc_fd_dir);
   dirent* dir_entry;
   while ((dir_entry = readdir(proc_fd_dir)) != nullptr) {
@@ -518,13 +521,20 @@ static std::unique_ptr<std::set<int>> GetOpenFdsIgnoring(const std::vector<int>&
       continue;
     }
 
-    result->insert(fd);
+    fds->push_back(fd);
   }
 
   if (closedir(proc_fd_dir) == -1) {
     fail_fn(android::base::StringPrintf("Unable to close directory: %s", strerror(errno)));
   }
-  return result;
+  std::sort(fds->begin(), fds->end());
+}
+
+static std::unique_ptr<std::set<int>> GetOpenFdsIgnoring(const std::vector<int>& fds_to_ignore,
+                                                         fail_fn_t fail_fn) {
+  std::vector<int> fds;
+  ScanOpenFdsIgnoring(fds_to_ignore, &fds, fail_fn);
+  return std::make_unique<std::set<int>>(fds.begin(), fds.end());
 }
 
 std::unique_ptr<std::set<int>> GetOpenFds(fail_fn_t fail_fn) {
@@ -532,12 +542,11 @@ std::unique_ptr<std::set<int>> GetOpenFds(fail_fn_t fail_fn) {
   return GetOpenFdsIgnoring(nothing_to_ignore, fail_fn);
 }
 
-void FileDescriptorTable::Restat(const std::vector<int>& fds_to_ignore, fail_fn_t fail_fn) {
-  std::unique_ptr<std::set<int>> open_fds = GetOpenFdsIgnoring(fds_to_ignore, fail_fn);
+size_t FileDescriptorTable::Restat(const std::vector<int>& fds_to_ignore, fail_fn_t fail_fn) {
+  ScanOpenFdsIgnoring(fds_to_ignore, &scanned_fds_, fail_fn);
 
-  // Check that the files did not change, and leave only newly opened FDs in
-  // |open_fds|.
-  RestatInternal(*open_fds, fail_fn);
+  // Check that the files did not change, and pick up newly opened FDs.
+  return RestatInternal(scanned_fds_, fail_fn);
 }
 
 // Reopens all file descriptors that are contained in the table.
@@ -560,73 +569,64 @@ FileDescriptorTable::FileDescriptorTable(
 
 FileDescriptorTable::~FileDescriptorTable() {}
 
-void FileDescriptorTable::RestatInternal(std::set<int>& open_fds, fail_fn_t fail_fn) {
+size_t FileDescriptorTable::RestatInternal(const std::vector<int>& open_fds,
+                                           fail_fn_t fail_fn) {
   // ART creates a file through memfd for optimization purposes. We make sure
   // there is at most one being created.
   bool art_memfd_seen = false;
-
-  // Iterate through the list of file descriptors we've already recorded
-  // and check whether :
-  //
-  // (a) they continue to be open.
-  // (b) they refer to the same file.
-  //
-  // We'll only store the last error message.
-  std::unordered_map<int, std::unique_ptr<FileDescriptorInfo>>::iterator it = open_fd_map_.begin();
-  while (it != open_fd_map_.end()) {
-    std::set<int>::const_iterator element = open_fds.find(it->first);
-    if (element == open_fds.end()) {
-      // The entry from the file descriptor table is no longer in the list
-      // of open files. We warn about this condition and remove it from
-      // the list of FDs under consideration.
+  size_t checked = 0;
+
+  // Iterate through the list of open file descriptors and check whether the
+  // ones we've already recorded refer to the same file. Between two forks the
+  // zygote rarely opens or closes anything, so this is usually a single fstat
+  // per FD.
+  for (const int fd : open_fds) {
+    auto it = open_fd_map_.find(fd);
+    if (it == open_fd_map_.end()) {
+      // The zygote has opened a new file descriptor since our last inspection.
+      // We add it to our table if it passes the same checks as in Create().
       //
       // TODO(narayan): This will be an error in a future android release.
       // error = true;
-      // ALOGW("Zygote closed file descriptor %d.", it->first);
-      it = open_fd_map_.erase(it);
+      // ALOGW("Zygote opened new file descriptor %d.", fd);
+      it = open_fd_map_.emplace(fd, FileDescriptorInfo::CreateFromFd(fd, fail_fn)).first;
+      ++checked;
     } else {
-      // The entry from the file descriptor table is still open. Restat
-      // it and check whether it refers to the same file.
       if (!it->second->RefersToSameFile()) {
         // The file descriptor refers to a different description. We must
         // update our entry in the table.
-        it->second = FileDescriptorInfo::CreateFromFd(*element, fail_fn);
-      } else {
-        // It's the same file. Nothing to do here. Move on to the next open
-        // FD.
+        it->second = FileDescriptorInfo::CreateFromFd(fd, fail_fn);
+        ++checked;
       }
+    }
 
-      if (IsArtMemfd(it->second->file_path)) {
-        if (art_memfd_seen) {
-          fail_fn("ART fd already seen: " + it->second->file_path);
-        } else {
-          art_memfd_seen = true;
-        }
+    if (IsArtMemfd(it->second->file_path)) {
+      if (art_memfd_seen) {
+        fail_fn("ART fd already seen: " + it->second->file_path);
+      } else {
+        art_memfd_seen = true;
       }
-
-      ++it;
-
-      // Finally, remove the FD from the set of open_fds. We do this last because
-      // |element| will not remain valid after a call to erase.
-      open_fds.erase(element);
     }
   }
 
-  if (open_fds.size() > 0) {
-    // The zygote has opened new file descriptors since our last inspection.
-    // We warn about this condition and add them to our table.
-    //
-    // TODO(narayan): This will be an error in a future android release.
-    // error = true;
-    // ALOGW("Zygote opened %zd new file descriptor(s).", open_fds.size());
-
-    // TODO(narayan): This code will be removed in a future android release.
-    std::set<int>::const_iterator it;
-    for (it = open_fds.begin(); it != open_fds.end(); ++it) {
-      const int fd = (*it);
-      open_fd_map_[fd] = FileDescriptorInfo::CreateFromFd(fd, fail_fn);
+  // Entries from the file descriptor table that are no longer in the list of
+  // open files are removed from the list of FDs under consideration. Every open
+  // FD is in the table at this point, so the walk is only needed if the sizes
+  // differ.
+  //
+  // TODO(narayan): This will be an error in a future android release.
+  // error = true;
+  // ALOGW("Zygote closed file descriptor %d.", it->first);
+  if (open_fd_map_.size() != open_fds.size()) {
+    for (auto it = open_fd_map_.begin(); it != open_fd_map_.end();) {
+      if (std::binary_search(open_fds.begin(), open_fds.end(), it->first)) {
+        ++it;
+      } else {
+        it = open_fd_map_.erase(it);
+      }
     }
   }
+  return checked;
 }
 
 static int ParseFd(dirent* dir_entry, int dir_fd) {
@@ -92,7 +92,15 @@ class FileDescriptorTable {
   // Temporary: allows newly open FDs if they pass the same checks as in
   // Create(). This will be further restricted. See TODOs in the
   // implementation.
-  void Restat(const std::vector<int>& fds_to_ignore, fail_fn_t fail_fn);
+  //
+  // The table is maintained incrementally: FDs that still refer to the file
+  // they referred to at the last call are only fstat(2)ed, and the full
+  // readlink(2) and allowlist checks are only repeated for FDs that are new or
+  // that changed. Returns the number of FDs that had to be fully checked.
+  size_t Restat(const std::vector<int>& fds_to_ignore, fail_fn_t fail_fn);
+
+  // Returns the number of FDs in the table.
+  size_t size() const { return open_fd_map_.size(); }
 
   // Reopens all file descriptors that are contained in the table. Returns true
   // if all descriptors were successfully re-opened or detached, and false if an
@@ -102,11 +110,15 @@ class FileDescriptorTable {
  private:
   explicit FileDescriptorTable(std::unordered_map<int, std::unique_ptr<FileDescriptorInfo>> map);
 
-  void RestatInternal(std::set<int>& open_fds, fail_fn_t fail_fn);
+  size_t RestatInternal(const std::vector<int>& open_fds, fail_fn_t fail_fn);
 
   // Invariant: All values in this unordered_map are non-NULL.
   std::unordered_map<int, std::unique_ptr<FileDescriptorInfo>> open_fd_map_;
 
+  // The sorted FDs found by the last Restat(), kept to avoid reallocating it
+  // before every fork.
+  std::vector<int> scanned_fds_;
+
   DISALLOW_COPY_AND_ASSIGN(FileDescriptorTable);
 };
 
@@ -14,11 +14,19 @@
  * limitations under the License.
  */
 
+#define ATRACE_TAG ATRACE_TAG_RESOURCES
+
 #include "androidfw/ApkAssets.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include "android-base/errors.h"
 #include "android-base/logging.h"
 #include "android-base/utf8.h"
+#include "androidfw/ResourceTimer.h"
+#include "utils/Trace.h"
 
 namespace android {
 
@@ -27,6 +35,25 @@ using base::unique_fd;
 
 constexpr const char* kResourcesArsc = "resources.arsc";
 
+// Loading is mostly bound by page faults on the mmapped tables, so more threads than this don't
+// make it any faster while competing with the rest of the process startup.
+constexpr size_t kMaxLoaderThreads = 4;
+
+static MemoryUsage GetAssetMemoryUsage(Asset* asset) {
+  MemoryUsage usage;
+  if (asset == nullptr) {
+    return usage;
+  }
+  const size_t length = static_cast<size_t>(asset->getLength());
+  if (asset->isAllocated()) {
+    usage.heap_bytes = length;
+  } else {
+    usage.mapped_bytes = length;
+    usage.resident_bytes = GetResidentBytes(asset->getBuffer(true /*aligned*/), length);
+  }
+  return usage;
+}
+
 ApkAssets::ApkAssets(PrivateConstructorUtil, std::unique_ptr<Asset> resources_asset,
                      std::unique_ptr<LoadedArsc> loaded_arsc,
                      std::unique_ptr<AssetsProvider> assets, package_property_t property_flags,
@@ -79,7 +106,9 @@ ApkAssetsPtr ApkAssets::LoadOverlay(const std::string& idmap_path, package_prope
 
   StringPiece idmap_data(reinterpret_cast<const char*>(idmap_asset->getBuffer(true /* aligned */)),
                          static_cast<size_t>(idmap_asset->getLength()));
+  ResourceTimer idmap_timer(ResourceTimer::Counter::LoadIdmap);
   auto loaded_idmap = LoadedIdmap::Load(idmap_path, idmap_data);
+  idmap_timer.record();
   if (loaded_idmap == nullptr) {
     LOG(ERROR) << "failed to load IDMAP " << idmap_path;
     return {};
@@ -137,6 +166,7 @@ ApkAssetsPtr ApkAssets::LoadImpl(std::unique_ptr<Asset>&& resources_asset,
     return {};
   }
 
+  ResourceTimer _timer(ResourceTimer::Counter::LoadApkAssets);
   std::unique_ptr<LoadedArsc> loaded_arsc;
   if (resources_asset != nullptr) {
     const auto data = resources_asset->getIncFsBuffer(true /* aligned */);
@@ -163,6 +193,37 @@ ApkAssetsPtr ApkAssets::LoadImpl(std::unique_ptr<Asset>&& resources_asset,
                             std::move(idmap_asset), std::move(loaded_idmap));
 }
 
+std::vector<ApkAssetsPtr> ApkAssets::LoadInParallel(std::span<const Loader> loaders,
+                                                    size_t max_threads) {
+  ATRACE_NAME("ApkAssets::LoadInParallel");
+  std::vector<ApkAssetsPtr> results(loaders.size());
+  if (max_threads == 0) {
+    max_threads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, kMaxLoaderThreads);
+  }
+  const size_t thread_count = std::min(max_threads, loaders.size());
+
+  // Each worker keeps taking the next pending loader, so a single slow APK doesn't hold back the
+  // others. Every loader writes to its own slot, which keeps the results in the original order.
+  std::atomic<size_t> next = 0;
+  auto work = [&] {
+    for (size_t i = next++; i < loaders.size(); i = next++) {
+      results[i] = loaders[i]();
+    }
+  };
+
+  // The calling thread takes part in the loading as well.
+  std::vector<std::thread> workers;
+  workers.reserve(thread_count > 0 ? thread_count - 1 : 0);
+  for (size_t i = 1; i < thread_count; i++) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return results;
+}
+
 std::optional<std::string_view> ApkAssets::GetPath() const {
   return assets_provider_->GetPath();
 }
@@ -180,4 +241,18 @@ UpToDate ApkAssets::IsUpToDate() const {
   return combine(idmap_res, [this] { return assets_provider_->IsUpToDate(); });
 }
 
+MemoryUsage ApkAssets::GetTableMemoryUsage() const {
+  MemoryUsage usage = GetAssetMemoryUsage(resources_asset_.get());
+  usage += loaded_arsc_->GetMemoryUsage();
+  return usage;
+}
+
+MemoryUsage ApkAssets::GetIdmapMemoryUsage() const {
+  MemoryUsage usage = GetAssetMemoryUsage(idmap_asset_.get());
+  if (loaded_idmap_ != nullptr) {
+    usage += loaded_idmap_->GetMemoryUsage();
+  }
+  return usage;
+}
+
 }  // namespace android
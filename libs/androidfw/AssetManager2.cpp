@@ -18,19 +18,27 @@
 
 #include "androidfw/AssetManager2.h"
 
+#include <sys/stat.h>
+
 #include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <map>
 #include <set>
 #include <span>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 
 #include "android-base/logging.h"
 #include "android-base/stringprintf.h"
+#include "android-base/strings.h"
 #include "androidfw/CombinedIterator.h"
+#include "androidfw/MutexGuard.h"
 #include "androidfw/ResourceTypes.h"
 #include "androidfw/ResourceUtils.h"
 #include "androidfw/Util.h"
+#include "androidfw/misc.h"
 #include "utils/ByteOrder.h"
 #include "utils/Trace.h"
 
@@ -47,6 +55,68 @@ namespace {
 constexpr int32_t kDefaultDisplayId = 0;
 constexpr int32_t kDefaultDeviceId = 0;
 
+// The number of distinct type indices within a package group.
+constexpr size_t kTypeCountPerPackage = std::numeric_limits<uint8_t>::max() + 1;
+
+// The package ID of the system framework resources.
+constexpr uint32_t kFrameworkPackageId = 0x01;
+
+// The maximum number of distinct framework assets and configuration sets kept in the shared bag
+// cache. Buckets are never evicted, so this bounds the memory the cache can hold onto.
+constexpr size_t kMaxSharedBagBuckets = 8;
+
+std::atomic<bool> gSharedBagCacheEnabled = false;
+
+// The layout of a theme snapshot: a header followed by `entry_count` records sorted by attribute.
+// Snapshots use host endianness, as they never leave the device they were written on.
+constexpr uint32_t kThemeSnapshotMagic = 0x4e534854;  // "THSN"
+constexpr uint32_t kThemeSnapshotVersion = 1;
+
+struct ThemeSnapshotHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t fingerprint;
+  uint32_t type_spec_flags;
+  uint32_t entry_count;
+};
+
+struct ThemeSnapshotRecord {
+  uint32_t attr;
+  ApkAssetsCookie cookie;
+  uint32_t type_spec_flags;
+  Res_value value;
+};
+
+static_assert(std::is_trivially_copyable_v<ThemeSnapshotRecord>);
+
+// FNV-1a, which is stable across processes unlike std::hash.
+void HashBytes(uint64_t& hash, const void* data, size_t size) {
+  const auto bytes = reinterpret_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  }
+}
+
+template <class T>
+void HashValue(uint64_t& hash, const T& value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  HashBytes(hash, &value, sizeof(value));
+}
+
+// Hashes the identity of the file at `path`, so that a file replaced or updated in place at the
+// same path changes the hash.
+void HashFileIdentity(uint64_t& hash, std::string_view path) {
+  struct stat sb;
+  if (stat(std::string(path).c_str(), &sb) < 0) {
+    HashValue(hash, kInvalidModDate);
+    return;
+  }
+  HashValue(hash, sb.st_dev);
+  HashValue(hash, sb.st_ino);
+  HashValue(hash, sb.st_size);
+  HashValue(hash, getModDate(sb));
+}
+
 using EntryValue = std::variant<Res_value, incfs::verified_map_ptr<ResTable_map_entry>>;
 
 /* NOTE: table_entry has been verified in LoadedPackage::GetEntryFromOffset(),
@@ -105,6 +175,34 @@ struct Theme::Entry {
   Res_value value;
 };
 
+struct AssetManager2::ResolvedTypeTable {
+  explicit ResolvedTypeTable(size_t entry_count) : entries(entry_count) {
+  }
+
+  // The best entry found for each entry ID of the type under the current configurations, or
+  // std::nullopt if the entry has not been successfully looked up yet.
+  std::vector<std::optional<FindEntryResult>> entries;
+};
+
+struct AssetManager2::SharedBagBucket {
+  struct Bag {
+    util::unique_cptr<ResolvedBag> bag;
+
+    // The resource IDs of the style and its parents that the bag was resolved from.
+    std::vector<uint32_t> resid_stack;
+  };
+
+  explicit SharedBagBucket(ApkAssetsCookie framework_cookie) : cookie(framework_cookie) {
+  }
+
+  // The cookie of the framework ApkAssets. All entries of the shared bags come from it.
+  const ApkAssetsCookie cookie;
+
+  // The shared bags. They are never removed from a bucket, so the pointers handed out stay valid
+  // for as long as the bucket is referenced.
+  Guarded<std::unordered_map<uint32_t, Bag>> bags;
+};
+
 AssetManager2::AssetManager2(ApkAssetsList apk_assets, const ResTable_config& configuration)
   : display_id_(kDefaultDisplayId), device_id_(kDefaultDeviceId) {
   configurations_.push_back(configuration);
@@ -117,6 +215,10 @@ AssetManager2::AssetManager2() : display_id_(kDefaultDisplayId), device_id_(kDef
   configurations_.emplace_back();
 }
 
+AssetManager2::AssetManager2(AssetManager2&& other) = default;
+
+AssetManager2::~AssetManager2() = default;
+
 bool AssetManager2::SetApkAssets(ApkAssetsList apk_assets, bool invalidate_caches) {
   BuildDynamicRefTable(apk_assets);
   RebuildFilterList();
@@ -126,6 +228,30 @@ bool AssetManager2::SetApkAssets(ApkAssetsList apk_assets, bool invalidate_cache
   return true;
 }
 
+std::unique_ptr<AssetManager2> AssetManager2::Clone() const {
+  auto op = StartOperation();
+  std::vector<ApkAssetsPtr> apk_assets;
+  apk_assets.reserve(apk_assets_.size());
+  for (size_t i = 0, s = apk_assets_.size(); i != s; ++i) {
+    const auto& assets = GetApkAssets(i);
+    if (!assets) {
+      // The cookies of the copy must match the ones of this AssetManager.
+      return nullptr;
+    }
+    apk_assets.push_back(assets);
+  }
+
+  auto clone = std::make_unique<AssetManager2>();
+  clone->configurations_ = configurations_;
+  clone->default_locale_ = default_locale_;
+  // The overlay constraints must be in place before the overlays are added.
+  clone->display_id_ = display_id_;
+  clone->device_id_ = device_id_;
+  clone->resolution_table_enabled_ = resolution_table_enabled_;
+  clone->SetApkAssets(apk_assets, false /* invalidate_caches */);
+  return clone;
+}
+
 void AssetManager2::PresetApkAssets(ApkAssetsList apk_assets) {
   BuildDynamicRefTable(apk_assets);
 }
@@ -148,6 +274,10 @@ void AssetManager2::BuildDynamicRefTable(ApkAssetsList apk_assets) {
   package_groups_.clear();
   package_ids_.fill(0xff);
 
+  // The resolution tables are indexed by package group, which is about to be reassigned.
+  resolution_tables_.clear();
+  shared_bag_bucket_resolved_ = false;
+
   // A mapping from path of apk assets that could be target packages of overlays to the runtime
   // package id of its first loaded package. Overlays currently can only override resources in the
   // first package in the target resource table.
@@ -291,13 +421,27 @@ void AssetManager2::DumpToLog() const {
   }
   LOG(INFO) << "Package ID map: " << list;
 
+  LOG(INFO) << base::StringPrintf(
+      "Caches (size/capacity): bags %zu/%zu, bag resid stacks %zu/%zu, resolved values %zu/%zu",
+      cached_bags_.size(), cached_bags_.capacity(), cached_bag_resid_stacks_.size(),
+      cached_bag_resid_stacks_.capacity(), cached_resolved_values_.size(),
+      cached_resolved_values_.capacity());
+
+  for (const auto& line : base::Split(DumpMemoryUsage(), "\n")) {
+    if (!line.empty()) {
+      LOG(INFO) << line;
+    }
+  }
+
   for (const auto& package_group : package_groups_) {
     list = "";
     for (const auto& package : package_group.packages_) {
       const LoadedPackage* loaded_package = package.loaded_package_;
-      base::StringAppendF(&list, "%s(%02x%s), ", loaded_package->GetPackageName().c_str(),
-                          loaded_package->GetPackageId(),
-                          (loaded_package->IsDynamic() ? " dynamic" : ""));
+      base::StringAppendF(&list, "%s(%02x%s, type specs %zu/%zu), ",
+                          loaded_package->GetPackageName().c_str(), loaded_package->GetPackageId(),
+                          (loaded_package->IsDynamic() ? " dynamic" : ""),
+                          loaded_package->GetTypeSpecCount(),
+                          loaded_package->GetTypeSpecCapacity());
     }
     LOG(INFO) << base::StringPrintf("PG (%02x): ",
                                     package_group.dynamic_ref_table->mAssignedPackageId)
@@ -321,6 +465,59 @@ void AssetManager2::DumpToLog() const {
   }
 }
 
+AssetManager2::CacheMemoryUsage AssetManager2::GetCacheMemoryUsage() const {
+  CacheMemoryUsage usage;
+  usage.bags = cached_bags_.capacity() * sizeof(*cached_bags_.begin());
+  for (const auto& [resid, bag] : cached_bags_) {
+    usage.bags += sizeof(ResolvedBag) + bag->entry_count * sizeof(ResolvedBag::Entry);
+  }
+  usage.bags += shared_cached_bags_.capacity() * sizeof(*shared_cached_bags_.begin());
+  usage.bag_resid_stacks =
+      cached_bag_resid_stacks_.capacity() * sizeof(*cached_bag_resid_stacks_.begin());
+  for (const auto& [resid, stack] : cached_bag_resid_stacks_) {
+    usage.bag_resid_stacks += stack.capacity() * sizeof(uint32_t);
+  }
+  usage.resolved_values =
+      cached_resolved_values_.capacity() * sizeof(*cached_resolved_values_.begin());
+  usage.resolution_tables = resolution_tables_.capacity() * sizeof(resolution_tables_[0]);
+  for (const auto& table : resolution_tables_) {
+    if (table != nullptr) {
+      usage.resolution_tables +=
+          sizeof(*table) + table->entries.capacity() * sizeof(table->entries[0]);
+    }
+  }
+  return usage;
+}
+
+std::string AssetManager2::DumpMemoryUsage() const {
+  const CacheMemoryUsage caches = GetCacheMemoryUsage();
+  std::string out = base::StringPrintf(
+      "AssetManager2(this=%p) cache heap: %zu KiB (bags %zu, bag resid stacks %zu, resolved values "
+      "%zu, resolution tables %zu)\n",
+      this, caches.total() / 1024, caches.bags, caches.bag_resid_stacks, caches.resolved_values,
+      caches.resolution_tables);
+
+  auto op = StartOperation();
+  for (size_t i = 0, s = apk_assets_.size(); i < s; ++i) {
+    const auto& assets = GetApkAssets(i);
+    if (assets == nullptr) {
+      continue;
+    }
+    base::StringAppendF(&out, "  [%zu] %s: table %s\n", i, assets->GetDebugName().c_str(),
+                        assets->GetTableMemoryUsage().ToString().c_str());
+    for (const auto& package : assets->GetLoadedArsc()->GetPackages()) {
+      base::StringAppendF(&out, "    package %s(%02x): heap %zu KiB\n",
+                          package->GetPackageName().c_str(), package->GetPackageId(),
+                          package->GetMemoryUsage().heap_bytes / 1024);
+    }
+    if (assets->IsOverlay()) {
+      base::StringAppendF(&out, "    idmap: %s\n",
+                          assets->GetIdmapMemoryUsage().ToString().c_str());
+    }
+  }
+  return out;
+}
+
 const ResStringPool* AssetManager2::GetStringPoolForCookie(ApkAssetsCookie cookie) const {
   if (cookie < 0 || static_cast<size_t>(cookie) >= apk_assets_.size()) {
     return nullptr;
@@ -470,6 +667,9 @@ void AssetManager2::SetConfigurations(std::vector<ResTable_config> configuration
 
 void AssetManager2::SetDefaultLocale(std::optional<ResTable_config> default_locale) {
   default_locale_ = default_locale;
+  // The default locale takes part in choosing between the results for multiple locales.
+  resolution_tables_.clear();
+  shared_bag_bucket_resolved_ = false;
 }
 
 void AssetManager2::SetOverlayConstraints(int32_t display_id, int32_t device_id) {
@@ -494,6 +694,18 @@ void AssetManager2::SetOverlayConstraints(int32_t display_id, int32_t device_id)
   }
 }
 
+void AssetManager2::SetResolutionTableEnabled(bool enabled) {
+  resolution_table_enabled_ = enabled;
+  if (!enabled) {
+    resolution_tables_.clear();
+    resolution_tables_.shrink_to_fit();
+  }
+}
+
+void AssetManager2::SetSharedBagCacheEnabled(bool enabled) {
+  gSharedBagCacheEnabled = enabled;
+}
+
 AssetManager2::AssetsSet AssetManager2::GetNonSystemOverlays() const {
   AssetManager2::AssetsSet non_system_overlays;
   for (const PackageGroup& package_group : package_groups_) {
@@ -700,6 +912,23 @@ base::expected<FindEntryResult, NullOrIOError> AssetManager2::FindEntry(
   }
 
   const PackageGroup& package_group = package_groups_[package_idx];
+
+  // The resolution table only holds the results of full lookups against the set configurations.
+  // Lookups with resolution logging enabled always go through the search to record their steps.
+  std::optional<FindEntryResult>* table_slot = nullptr;
+  if (resolution_table_enabled_ && density_override == 0U && !stop_at_first_match &&
+      !ignore_configuration && !logging_enabled) {
+    table_slot = GetResolutionTableSlot(package_idx, type_idx, entry_idx);
+    if (table_slot != nullptr && table_slot->has_value()) {
+      if (UNLIKELY(!GetApkAssets((*table_slot)->cookie))) {
+        ALOGE("Found expired ApkAssets #%d for resource ID 0x%08x.", (*table_slot)->cookie, resid);
+        table_slot->reset();
+        return base::unexpected(std::nullopt);
+      }
+      return **table_slot;
+    }
+  }
+
   std::optional<FindEntryResult> final_result;
   bool final_has_locale = false;
   bool final_overlaid = false;
@@ -853,9 +1082,35 @@ base::expected<FindEntryResult, NullOrIOError> AssetManager2::FindEntry(
     }
   }
 
+  if (table_slot != nullptr) {
+    *table_slot = final_result;
+  }
   return *final_result;
 }
 
+std::optional<FindEntryResult>* AssetManager2::GetResolutionTableSlot(uint8_t package_idx,
+                                                                      uint8_t type_idx,
+                                                                      uint16_t entry_idx) const {
+  if (resolution_tables_.empty()) {
+    resolution_tables_.resize(package_groups_.size() * kTypeCountPerPackage);
+  }
+
+  // The tables are never reallocated while set, so the returned slot stays valid across nested
+  // lookups of overlay resources.
+  auto& table = resolution_tables_[package_idx * kTypeCountPerPackage + type_idx];
+  if (table == nullptr) {
+    uint32_t entry_count = 0U;
+    for (const ConfiguredPackage& package : package_groups_[package_idx].packages_) {
+      const TypeSpec* type_spec = package.loaded_package_->GetTypeSpecByTypeIndex(type_idx);
+      if (type_spec != nullptr) {
+        entry_count = std::max(entry_count, dtohl(type_spec->type_spec->entryCount));
+      }
+    }
+    table = std::make_unique<ResolvedTypeTable>(entry_count);
+  }
+  return entry_idx < table->entries.size() ? &table->entries[entry_idx] : nullptr;
+}
+
 base::expected<FindEntryResult, NullOrIOError> AssetManager2::FindEntryInternal(
     const PackageGroup& package_group, uint8_t type_idx, uint16_t entry_idx,
     const ResTable_config& desired_config, bool stop_at_first_match,
@@ -898,6 +1153,11 @@ base::expected<FindEntryResult, NullOrIOError> AssetManager2::FindEntryInternal(
     }
     type_flags |= entry_flags.value();
 
+    if (use_filtered && loaded_package->HasLazyTypes() &&
+        !loaded_package_impl.filtered_types_.test(type_idx)) {
+      FilterTypeConfigs(loaded_package_impl, *type_spec, type_idx);
+      loaded_package_impl.filtered_types_.set(type_idx);
+    }
     const FilteredConfigGroup& filtered_group = loaded_package_impl.filtered_configs_[type_idx];
     const size_t type_entry_count = (use_filtered) ? filtered_group.type_entries.size()
                                                    : type_spec->type_entries.size();
@@ -1147,8 +1407,93 @@ base::expected<AssetManager2::SelectedValue, NullOrIOError> AssetManager2::GetRe
   Res_value value = std::get<Res_value>(result->entry);
   result->dynamic_ref_table->lookupResourceValue(&value);
 
-  return SelectedValue(value.dataType, value.data, result->cookie, result->entry_flags,
-                       result->type_flags, resid, result->config);
+  SelectedValue selected(value.dataType, value.data, result->cookie, result->entry_flags,
+                         result->type_flags, resid, result->config);
+  if (UNLIKELY(access_recording_enabled_)) {
+    RecordAccess(selected);
+  }
+  return selected;
+}
+
+void AssetManager2::StartAccessRecording(std::chrono::milliseconds duration) {
+  access_profile_ = {};
+  access_recording_deadline_ = std::chrono::steady_clock::now() + duration;
+  access_recording_enabled_ = true;
+}
+
+ResourceAccessProfile AssetManager2::FinishAccessRecording() {
+  access_recording_enabled_ = false;
+  return std::exchange(access_profile_, {});
+}
+
+void AssetManager2::RecordAccess(const SelectedValue& value) const {
+  if (std::chrono::steady_clock::now() >= access_recording_deadline_) {
+    access_recording_enabled_ = false;
+    return;
+  }
+  auto op = StartOperation();
+  const auto& assets = GetApkAssets(value.cookie);
+  if (!assets) {
+    return;
+  }
+  const auto apk_path = assets->GetPath();
+  if (!apk_path) {
+    // Assets without a path can't be found again on the next launch.
+    return;
+  }
+
+  // File-based resources such as layouts and drawables are stored as strings with their path.
+  std::string file_path;
+  if (value.type == Res_value::TYPE_STRING) {
+    if (auto str = assets->GetLoadedArsc()->GetStringPool()->string8ObjectAt(value.data);
+        str.has_value() && base::StartsWith(str->c_str(), "res/")) {
+      file_path = str->c_str();
+    }
+  }
+  access_profile_.Add(value.resid, *apk_path, file_path);
+}
+
+size_t AssetManager2::ReplayAccessProfile(const ResourceAccessProfile& profile) const {
+  ATRACE_NAME("AssetManager::ReplayAccessProfile");
+  auto op = StartOperation();
+
+  // Map the ApkAssets of the profile to the loaded ones, and start reading their files first so
+  // the reads overlap with resolving the values.
+  const auto& apk_paths = profile.apk_paths();
+  std::vector<ApkAssetsCookie> cookies(apk_paths.size(), kInvalidCookie);
+  std::vector<std::vector<std::string>> file_paths(apk_paths.size());
+  for (const auto& access : profile.accesses()) {
+    if (!access.file_path.empty()) {
+      file_paths[access.apk_index].push_back(access.file_path);
+    }
+  }
+  for (size_t i = 0, s = apk_assets_.size(); i != s; ++i) {
+    const auto& assets = GetApkAssets(i);
+    const auto path = assets ? assets->GetPath() : std::nullopt;
+    if (!path) {
+      continue;
+    }
+    const auto it = std::find(apk_paths.begin(), apk_paths.end(), *path);
+    if (it == apk_paths.end()) {
+      continue;
+    }
+    const size_t index = it - apk_paths.begin();
+    cookies[index] = static_cast<ApkAssetsCookie>(i);
+    assets->GetAssetsProvider()->Prefetch(file_paths[index]);
+  }
+
+  size_t resolved = 0;
+  for (const auto& access : profile.accesses()) {
+    if (cookies[access.apk_index] == kInvalidCookie) {
+      continue;
+    }
+    SelectedValue value(Res_value::TYPE_REFERENCE, access.resid, kInvalidCookie, 0U, 0U,
+                        access.resid, {});
+    if (ResolveReference(value, true /* cache_value */).has_value()) {
+      ++resolved;
+    }
+  }
+  return resolved;
 }
 
 base::expected<std::monostate, NullOrIOError> AssetManager2::ResolveReference(
@@ -1163,13 +1508,14 @@ base::expected<std::monostate, NullOrIOError> AssetManager2::ResolveReference(
   if (cache_value) {
     auto cached_value = cached_resolved_values_.find(value.data);
     if (cached_value != cached_resolved_values_.end()) {
-      value = cached_value->second;
+      value = cached_value->second.value;
       value.flags |= original_flags;
       return {};
     }
   }
 
   uint32_t combined_flags = 0U;
+  uint32_t chain_flags = 0U;
   uint32_t resolve_resid = original_resid;
   constexpr const uint32_t kMaxIterations = 20;
   for (uint32_t i = 0U;; i++) {
@@ -1183,13 +1529,14 @@ base::expected<std::monostate, NullOrIOError> AssetManager2::ResolveReference(
     // be resolved successfully.
     value = *result;
     value.flags |= combined_flags;
+    chain_flags |= result->flags;
 
     if (result->type != Res_value::TYPE_REFERENCE ||
         result->data == Res_value::DATA_NULL_UNDEFINED ||
         result->data == resolve_resid || i == kMaxIterations) {
       // This reference can't be resolved, so exit now and let the caller deal with it.
       if (cache_value) {
-        cached_resolved_values_[original_resid] = value;
+        cached_resolved_values_[original_resid] = {value, chain_flags};
       }
 
       // Above value is cached without original_flags to ensure they don't get included in future
@@ -1250,6 +1597,28 @@ base::expected<const ResolvedBag*, NullOrIOError> AssetManager2::GetBag(
     return cached_iter->second.get();
   }
 
+  SharedBagBucket* shared_bucket =
+      get_package_id(resid) == kFrameworkPackageId ? GetSharedBagBucket() : nullptr;
+  if (shared_bucket != nullptr) {
+    // Check the bags already taken from the bucket first, so that only the first lookup of each
+    // bag takes the bucket lock.
+    if (auto shared_iter = shared_cached_bags_.find(resid);
+        shared_iter != shared_cached_bags_.end()) {
+      const auto& resid_stack = *shared_iter->second.resid_stack;
+      child_resids.insert(child_resids.end(), resid_stack.begin(), resid_stack.end());
+      return shared_iter->second.bag;
+    }
+
+    ScopedLock bags(shared_bucket->bags);
+    if (auto shared_iter = bags->find(resid); shared_iter != bags->end()) {
+      const auto& resid_stack = shared_iter->second.resid_stack;
+      child_resids.insert(child_resids.end(), resid_stack.begin(), resid_stack.end());
+      shared_cached_bags_.emplace(
+          resid, SharedCachedBag{shared_iter->second.bag.get(), &resid_stack});
+      return shared_iter->second.bag.get();
+    }
+  }
+
   auto entry = FindEntry(resid, 0u /* density_override */, false /* stop_at_first_match */,
                          false /* ignore_configuration */);
   if (!entry.has_value()) {
@@ -1268,6 +1637,7 @@ base::expected<const ResolvedBag*, NullOrIOError> AssetManager2::GetBag(
 
   // Keep track of ids that have already been seen to prevent infinite loops caused by circular
   // dependencies between bags.
+  const size_t resid_stack_start = child_resids.size();
   child_resids.push_back(resid);
 
   uint32_t parent_resid = dtohl(map->parent.ident);
@@ -1320,9 +1690,8 @@ base::expected<const ResolvedBag*, NullOrIOError> AssetManager2::GetBag(
 
     new_bag->type_spec_flags = entry->type_flags;
     new_bag->entry_count = static_cast<uint32_t>(entry_count);
-    ResolvedBag* result = new_bag.get();
-    cached_bags_[resid] = std::move(new_bag);
-    return result;
+    return CacheBag(resid, std::move(new_bag), shared_bucket,
+                    std::span(child_resids).subspan(resid_stack_start));
   }
 
   // In case the parent is a dynamic reference, resolve it.
@@ -1446,11 +1815,101 @@ base::expected<const ResolvedBag*, NullOrIOError> AssetManager2::GetBag(
   // Combine flags from the parent and our own bag.
   new_bag->type_spec_flags = entry->type_flags | (*parent_bag)->type_spec_flags;
   new_bag->entry_count = static_cast<uint32_t>(actual_count);
-  ResolvedBag* result = new_bag.get();
-  cached_bags_[resid] = std::move(new_bag);
+  return CacheBag(resid, std::move(new_bag), shared_bucket,
+                  std::span(child_resids).subspan(resid_stack_start));
+}
+
+const ResolvedBag* AssetManager2::CacheBag(uint32_t resid, util::unique_cptr<ResolvedBag> bag,
+                                           SharedBagBucket* shared_bucket,
+                                           std::span<const uint32_t> resid_stack) const {
+  if (shared_bucket != nullptr &&
+      std::all_of(begin(bag.get()), end(bag.get()),
+                  [&](const auto& entry) { return entry.cookie == shared_bucket->cookie; })) {
+    ScopedLock bags(shared_bucket->bags);
+    auto [iter, inserted] = bags->try_emplace(resid);
+    if (inserted) {
+      iter->second.bag = std::move(bag);
+      iter->second.resid_stack.assign(resid_stack.begin(), resid_stack.end());
+    }
+    // If another AssetManager resolved the same bag in the meantime, use its copy.
+    shared_cached_bags_.emplace(
+        resid, SharedCachedBag{iter->second.bag.get(), &iter->second.resid_stack});
+    return iter->second.bag.get();
+  }
+
+  ResolvedBag* result = bag.get();
+  cached_bags_[resid] = std::move(bag);
+  return result;
+}
+
+AssetManager2::SharedBagBucket* AssetManager2::GetSharedBagBucket() const {
+  if (!gSharedBagCacheEnabled) {
+    return nullptr;
+  }
+  if (shared_bag_bucket_resolved_) {
+    return shared_bag_bucket_.get();
+  }
+  shared_bag_bucket_resolved_ = true;
+
+  // The bags taken from the previous bucket stay valid only while that bucket is referenced, and
+  // only describe this AssetManager if the same bucket is picked again.
+  const auto previous_bucket = std::move(shared_bag_bucket_);
+  const auto result = ResolveSharedBagBucket();
+  if (shared_bag_bucket_ != previous_bucket) {
+    shared_cached_bags_.clear();
+  }
   return result;
 }
 
+AssetManager2::SharedBagBucket* AssetManager2::ResolveSharedBagBucket() const {
+  const uint8_t package_idx = package_ids_[kFrameworkPackageId];
+  if (package_idx == 0xff) {
+    return nullptr;
+  }
+
+  // Only share bags of a framework package that is not split, overlaid or loaded by a loader, as
+  // those vary across AssetManagers with the same framework ApkAssets.
+  const PackageGroup& package_group = package_groups_[package_idx];
+  if (package_group.packages_.size() != 1 ||
+      !package_group.packages_[0].loaded_package_->IsSystem() ||
+      package_group.packages_[0].loaded_package_->IsCustomLoader() ||
+      std::any_of(package_group.overlays_.begin(), package_group.overlays_.end(),
+                  [](const ConfiguredOverlay& overlay) { return overlay.enabled; })) {
+    return nullptr;
+  }
+
+  auto op = StartOperation();
+  const ApkAssetsCookie cookie = package_group.cookies_[0];
+  const ApkAssetsPtr& assets = GetApkAssets(cookie);
+  if (!assets) {
+    return nullptr;
+  }
+
+  // The framework ApkAssets are held by the key, so a bucket can never be matched by different
+  // assets that happen to be allocated at the same address.
+  using Key = std::tuple<ApkAssetsPtr, ApkAssetsCookie, std::vector<ResTable_config>,
+                         std::optional<ResTable_config>>;
+  static Guarded<std::map<Key, std::shared_ptr<SharedBagBucket>>> buckets;
+
+  ScopedLock locked_buckets(buckets);
+
+  // Drop the buckets of framework ApkAssets that only the key still holds: they have been replaced
+  // in every AssetManager and would otherwise pin the old assets and bags forever. AssetManagers
+  // still using such a bucket keep it alive through their own reference.
+  std::erase_if(*locked_buckets, [](const auto& item) {
+    return std::get<0>(item.first)->getStrongCount() == 1;
+  });
+
+  Key key{assets, cookie, configurations_, default_locale_};
+  if (auto iter = locked_buckets->find(key); iter != locked_buckets->end()) {
+    shared_bag_bucket_ = iter->second;
+  } else if (locked_buckets->size() < kMaxSharedBagBuckets) {
+    shared_bag_bucket_ = std::make_shared<SharedBagBucket>(cookie);
+    locked_buckets->emplace(std::move(key), shared_bag_bucket_);
+  }
+  return shared_bag_bucket_.get();
+}
+
 static bool Utf8ToUtf16(StringPiece str, std::u16string* out) {
   ssize_t len =
       utf8_to_utf16_length(reinterpret_cast<const uint8_t*>(str.data()), str.size(), false);
@@ -1524,23 +1983,18 @@ base::expected<uint32_t, NullOrIOError> AssetManager2::GetResourceId(
 }
 
 void AssetManager2::RebuildFilterList() {
+  configuration_matchers_.assign(configurations_.begin(), configurations_.end());
   for (PackageGroup& group : package_groups_) {
     for (ConfiguredPackage& package : group.packages_) {
       package.filtered_configs_.forEachItem([](auto, auto& fcg) { fcg.type_entries.clear(); });
+      if (package.loaded_package_->HasLazyTypes()) {
+        // Don't force parsing every type up front, FindEntryInternal() filters them on demand.
+        package.filtered_types_.reset();
+        continue;
+      }
       // Create the filters here.
       package.loaded_package_->ForEachTypeSpec([&](const TypeSpec& type_spec, uint8_t type_id) {
-        FilteredConfigGroup* group = nullptr;
-        for (const auto& type_entry : type_spec.type_entries) {
-          for (auto& config : configurations_) {
-            if (type_entry.config.match(config)) {
-              if (!group) {
-                group = &package.filtered_configs_.editItemAt(type_id - 1);
-              }
-              group->type_entries.push_back(&type_entry);
-              break;
-            }
-          }
-        }
+        FilterTypeConfigs(package, type_spec, type_id - 1);
       });
       package.filtered_configs_.trimBuckets(
           [](const auto& fcg) { return fcg.type_entries.empty(); });
@@ -1548,6 +2002,23 @@ void AssetManager2::RebuildFilterList() {
   }
 }
 
+void AssetManager2::FilterTypeConfigs(const ConfiguredPackage& package, const TypeSpec& type_spec,
+                                      uint8_t type_idx) const {
+  FilteredConfigGroup* group = nullptr;
+  for (const auto& type_entry : type_spec.type_entries) {
+    for (size_t i = 0; i < configurations_.size(); i++) {
+      if (configuration_matchers_[i].MayMatch(type_entry.packed_config) &&
+          type_entry.config.match(configurations_[i])) {
+        if (!group) {
+          group = &package.filtered_configs_.editItemAt(type_idx);
+        }
+        group->type_entries.push_back(&type_entry);
+        break;
+      }
+    }
+  }
+}
+
 bool AssetManager2::IsAnyOverlayConstraintSatisfied(const Idmap_constraints& constraints) const {
   if (constraints.constraint_count == 0) {
     // There are no constraints, return true.
@@ -1570,40 +2041,52 @@ bool AssetManager2::IsAnyOverlayConstraintSatisfied(const Idmap_constraints& con
 }
 
 void AssetManager2::InvalidateCaches(uint32_t diff) {
-  cached_resolved_values_.clear();
+  shared_bag_bucket_resolved_ = false;
 
   if (diff == 0xffffffffu) {
     // Everything must go.
+    cached_resolved_values_.clear();
+    resolution_tables_.clear();
     cached_bags_.clear();
     cached_bag_resid_stacks_.clear();
+    shared_cached_bags_.clear();
     return;
   }
 
+  // A resolved value or entry only changes if an entry it came from varies with one of the changed
+  // configuration axes, so e.g. a rotation keeps everything that doesn't depend on the orientation
+  // or the screen size.
+  cached_resolved_values_.erase_if(
+      [diff](const auto& item) { return (diff & item.second.config_dependencies) != 0; });
+  for (auto& table : resolution_tables_) {
+    if (table == nullptr) {
+      continue;
+    }
+    for (auto& entry : table->entries) {
+      if (entry.has_value() && (diff & entry->type_flags) != 0) {
+        entry.reset();
+      }
+    }
+  }
+
   // Be more conservative with what gets purged. Only if the bag has other possible
   // variations with respect to what changed (diff) should we remove it.
-  for (auto stack_it = cached_bag_resid_stacks_.begin();
-       stack_it != cached_bag_resid_stacks_.end();) {
-    const auto it = cached_bags_.find(stack_it->first);
+  cached_bag_resid_stacks_.erase_if([&](const auto& stack) {
+    const auto it = cached_bags_.find(stack.first);
     if (it == cached_bags_.end()) {
-      stack_it = cached_bag_resid_stacks_.erase(stack_it);
-    } else if ((diff & it->second->type_spec_flags) != 0) {
+      return true;
+    }
+    if ((diff & it->second->type_spec_flags) != 0) {
       cached_bags_.erase(it);
-      stack_it = cached_bag_resid_stacks_.erase(stack_it);
-    } else {
-      ++stack_it;  // Keep the item in both caches.
+      return true;
     }
-  }
+    return false;  // Keep the item in both caches.
+  });
 
   // Need to ensure that both bag caches are consistent, as we populate them in the same function.
-  // Iterate over the cached bags to erase the items without the corresponding resid_stack cache
-  // items.
-  for (auto it = cached_bags_.begin(); it != cached_bags_.end();) {
-    if ((diff & it->second->type_spec_flags) != 0) {
-      it = cached_bags_.erase(it);
-    } else {
-      ++it;
-    }
-  }
+  // Erase the cached bags without the corresponding resid_stack cache items.
+  cached_bags_.erase_if(
+      [diff](const auto& bag) { return (diff & bag.second->type_spec_flags) != 0; });
 }
 
 uint8_t AssetManager2::GetAssignedPackageId(const LoadedPackage* package) const {
@@ -1642,6 +2125,46 @@ AssetManager2::ScopedOperation AssetManager2::StartOperation() const {
   return ScopedOperation(*this);
 }
 
+uint64_t AssetManager2::GetThemeSnapshotFingerprint() const {
+  auto op = StartOperation();
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  HashValue(hash, apk_assets_.size());
+  for (size_t i = 0, s = apk_assets_.size(); i < s; ++i) {
+    const auto& assets = GetApkAssets(i);
+    const std::string& name = assets ? assets->GetDebugName() : std::string();
+    HashValue(hash, name.size());
+    HashBytes(hash, name.data(), name.size());
+    if (!assets) {
+      continue;
+    }
+    if (const auto path = assets->GetPath()) {
+      HashFileIdentity(hash, *path);
+    }
+    if (const auto idmap = assets->GetLoadedIdmap()) {
+      HashFileIdentity(hash, idmap->OverlayApkPath());
+    }
+  }
+  HashValue(hash, package_ids_);
+  for (const auto& package_group : package_groups_) {
+    HashValue(hash, package_group.cookies_.size());
+    HashBytes(hash, package_group.cookies_.data(),
+              package_group.cookies_.size() * sizeof(ApkAssetsCookie));
+    for (const auto& overlay : package_group.overlays_) {
+      HashValue(hash, overlay.cookie);
+      HashValue(hash, overlay.enabled);
+    }
+  }
+  HashValue(hash, configurations_.size());
+  for (const auto& config : configurations_) {
+    HashValue(hash, config);
+  }
+  HashValue(hash, default_locale_.has_value());
+  if (default_locale_) {
+    HashValue(hash, *default_locale_);
+  }
+  return hash;
+}
+
 void AssetManager2::FinishOperation() const {
   if (number_of_running_scoped_operations_ < 1) {
     ALOGW("Invalid FinishOperation() call when there's none happening");
@@ -1777,26 +2300,35 @@ void Theme::Rebase(AssetManager2* am, const uint32_t* style_ids, const uint8_t*
 }
 
 std::optional<AssetManager2::SelectedValue> Theme::GetAttribute(uint32_t resid) const {
+  const auto key_it = std::lower_bound(keys_.begin(), keys_.end(), resid);
+  if (key_it == keys_.end() || *key_it != resid) {
+    return std::nullopt;
+  }
+  return GetAttributeAt(key_it - keys_.begin());
+}
+
+std::optional<AssetManager2::SelectedValue> Theme::GetAttributeAt(size_t index) const {
   constexpr const uint32_t kMaxIterations = 20;
   uint32_t type_spec_flags = 0u;
   for (uint32_t i = 0; i <= kMaxIterations; i++) {
-    const auto key_it = std::lower_bound(keys_.begin(), keys_.end(), resid);
-    if (key_it == keys_.end() || *key_it != resid) {
-      return std::nullopt;
-    }
-    const auto entry_it = entries_.begin() + (key_it - keys_.begin());
+    const auto entry_it = entries_.begin() + index;
     if (IsUndefined(entry_it->value)) {
       return std::nullopt;
     }
     type_spec_flags |= entry_it->type_spec_flags;
-    if (entry_it->value.dataType == Res_value::TYPE_ATTRIBUTE) {
-      resid = entry_it->value.data;
-      continue;
+    if (entry_it->value.dataType != Res_value::TYPE_ATTRIBUTE) {
+      return AssetManager2::SelectedValue(entry_it->value.dataType, entry_it->value.data,
+                                          entry_it->cookie, 0U /* entry flags*/, type_spec_flags,
+                                          0U /* resid */, {} /* config */);
     }
 
-    return AssetManager2::SelectedValue(entry_it->value.dataType, entry_it->value.data,
-                                        entry_it->cookie, 0U /* entry flags*/, type_spec_flags,
-                                        0U /* resid */, {} /* config */);
+    // Follow the reference to the other attribute of this theme.
+    const uint32_t resid = entry_it->value.data;
+    const auto key_it = std::lower_bound(keys_.begin(), keys_.end(), resid);
+    if (key_it == keys_.end() || *key_it != resid) {
+      return std::nullopt;
+    }
+    index = key_it - keys_.begin();
   }
   return std::nullopt;
 }
@@ -1964,6 +2496,78 @@ base::expected<std::monostate, IOError> Theme::SetTo(const Theme& source) {
   return {};
 }
 
+std::vector<uint8_t> Theme::WriteSnapshot() const {
+  const ThemeSnapshotHeader header{
+      .magic = kThemeSnapshotMagic,
+      .version = kThemeSnapshotVersion,
+      .fingerprint = asset_manager_->GetThemeSnapshotFingerprint(),
+      .type_spec_flags = type_spec_flags_,
+      .entry_count = static_cast<uint32_t>(keys_.size()),
+  };
+  std::vector<uint8_t> snapshot(sizeof(header) + keys_.size() * sizeof(ThemeSnapshotRecord));
+  memcpy(snapshot.data(), &header, sizeof(header));
+  auto out = snapshot.data() + sizeof(header);
+  for (size_t i = 0, size = keys_.size(); i != size; ++i, out += sizeof(ThemeSnapshotRecord)) {
+    const auto& entry = entries_[i];
+    const ThemeSnapshotRecord record{
+        .attr = keys_[i],
+        .cookie = entry.cookie,
+        .type_spec_flags = entry.type_spec_flags,
+        .value = entry.value,
+    };
+    memcpy(out, &record, sizeof(record));
+  }
+  return snapshot;
+}
+
+bool Theme::SetToSnapshot(std::span<const uint8_t> snapshot) {
+  ATRACE_NAME("Theme::SetToSnapshot");
+  ThemeSnapshotHeader header;
+  if (snapshot.size() < sizeof(header)) {
+    LOG(ERROR) << "Theme snapshot is too small: " << snapshot.size();
+    return false;
+  }
+  // The snapshot may be memory-mapped at any alignment, so copy the records out instead of
+  // casting the data.
+  memcpy(&header, snapshot.data(), sizeof(header));
+  if (header.magic != kThemeSnapshotMagic || header.version != kThemeSnapshotVersion) {
+    LOG(ERROR) << base::StringPrintf("Unsupported theme snapshot (magic 0x%08x, version %u)",
+                                     header.magic, header.version);
+    return false;
+  }
+  if ((snapshot.size() - sizeof(header)) / sizeof(ThemeSnapshotRecord) != header.entry_count ||
+      (snapshot.size() - sizeof(header)) % sizeof(ThemeSnapshotRecord) != 0) {
+    LOG(ERROR) << "Theme snapshot size does not match its entry count " << header.entry_count;
+    return false;
+  }
+  // A stale snapshot is expected after the ApkAssets or the configurations change, so there is
+  // nothing to log here.
+  if (header.fingerprint != asset_manager_->GetThemeSnapshotFingerprint()) {
+    return false;
+  }
+
+  std::vector<uint32_t> keys(header.entry_count);
+  std::vector<Entry> entries(header.entry_count);
+  const int apk_assets_count = asset_manager_->GetApkAssetsCount();
+  auto in = snapshot.data() + sizeof(header);
+  for (size_t i = 0; i != header.entry_count; ++i, in += sizeof(ThemeSnapshotRecord)) {
+    ThemeSnapshotRecord record;
+    memcpy(&record, in, sizeof(record));
+    if ((i > 0 && record.attr <= keys[i - 1]) || record.cookie < kInvalidCookie ||
+        record.cookie >= apk_assets_count) {
+      LOG(ERROR) << base::StringPrintf("Corrupt theme snapshot record 0x%08x", record.attr);
+      return false;
+    }
+    keys[i] = record.attr;
+    entries[i] = Entry{record.cookie, record.type_spec_flags, record.value};
+  }
+
+  type_spec_flags_ = header.type_spec_flags;
+  keys_ = std::move(keys);
+  entries_ = std::move(entries);
+  return true;
+}
+
 void Theme::Dump() const {
   LOG(INFO) << base::StringPrintf("Theme(this=%p, AssetManager2=%p)", this, asset_manager_);
   for (size_t i = 0, size = keys_.size(); i != size; ++i) {
@@ -16,8 +16,13 @@
 
 #include "androidfw/AssetsProvider.h"
 
+#include <fcntl.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include <android-base/errors.h>
 #include <android-base/stringprintf.h>
 #include <android-base/utf8.h>
@@ -27,6 +32,10 @@ namespace android {
 
 static constexpr std::string_view kEmptyDebugString = "<empty>";
 
+// Zip entries closer than this are prefetched as a single range, as the gap costs less to read than
+// an extra request to the storage.
+static constexpr off64_t kPrefetchMergeGap = 64 * 1024;
+
 std::unique_ptr<AssetsProvider> AssetsProvider::CreateWithOverride(
     std::unique_ptr<AssetsProvider> provider, std::unique_ptr<AssetsProvider> override) {
   if (provider == nullptr) {
@@ -99,33 +108,45 @@ const std::string& ZipAssetsProvider::PathOrDebugName::GetDebugName() const {
   return value_;
 }
 
-void ZipAssetsProvider::ZipCloser::operator()(ZipArchive* a) const {
-  ::CloseArchive(a);
-}
-
 ZipAssetsProvider::ZipAssetsProvider(ZipArchiveHandle handle, PathOrDebugName&& path,
                                      package_property_t flags, time_t last_mod_time)
-    : zip_handle_(handle), name_(std::move(path)), flags_(flags), last_mod_time_(last_mod_time) {
+    : zip_handle_(ZipArchiveCache::Adopt(handle)),
+      name_(std::move(path)),
+      flags_(flags),
+      last_mod_time_(last_mod_time) {
   LOG(ERROR) << "This function is not supported and will result in "
                 "poor performance and/or crashes. Stop calling it.";
 }
 
 ZipAssetsProvider::ZipAssetsProvider(ZipArchiveHandle handle, PathOrDebugName&& path,
                                      ModDate last_mod_time, package_property_t flags)
-    : zip_handle_(handle), name_(std::move(path)), flags_(flags), last_mod_time_(last_mod_time) {
+    : zip_handle_(ZipArchiveCache::Adopt(handle)),
+      name_(std::move(path)),
+      flags_(flags),
+      last_mod_time_(last_mod_time) {
+}
+
+ZipAssetsProvider::ZipAssetsProvider(ZipArchiveCache::Archive archive, PathOrDebugName&& path,
+                                     ModDate last_mod_time, package_property_t flags)
+    : zip_handle_(std::move(archive)),
+      name_(std::move(path)),
+      flags_(flags),
+      last_mod_time_(last_mod_time) {
 }
 
 std::unique_ptr<ZipAssetsProvider> ZipAssetsProvider::Create(std::string path,
                                                              package_property_t flags,
                                                              base::unique_fd fd) {
   const auto released_fd = fd.ok() ? fd.release() : -1;
-  ZipArchiveHandle handle;
-  if (int32_t result = released_fd < 0 ? OpenArchive(path.c_str(), &handle)
-                                       : OpenArchiveFd(released_fd, path.c_str(), &handle)) {
+  int32_t result;
+  auto archive = released_fd < 0 ? ZipArchiveCache::Open(path.c_str(), &result)
+                                 : ZipArchiveCache::OpenFd(released_fd, path.c_str(),
+                                                           true /* assume_ownership */, &result);
+  if (archive == nullptr) {
     LOG(ERROR) << "Failed to open APK '" << path << "': " << ::ErrorCodeString(result);
-    CloseArchive(handle);
     return {};
   }
+  ZipArchiveHandle handle = archive.get();
 
   ModDate mod_date = kInvalidModDate;
   // Skip all up-to-date checks if the file won't ever change.
@@ -138,8 +159,8 @@ std::unique_ptr<ZipAssetsProvider> ZipAssetsProvider::Create(std::string path,
     }
   }
 
-  return std::unique_ptr<ZipAssetsProvider>(
-      new ZipAssetsProvider(handle, PathOrDebugName::Path(std::move(path)), mod_date, flags));
+  return std::unique_ptr<ZipAssetsProvider>(new ZipAssetsProvider(
+      std::move(archive), PathOrDebugName::Path(std::move(path)), mod_date, flags));
 }
 
 std::unique_ptr<ZipAssetsProvider> ZipAssetsProvider::Create(base::unique_fd fd,
@@ -147,23 +168,35 @@ std::unique_ptr<ZipAssetsProvider> ZipAssetsProvider::Create(base::unique_fd fd,
                                                              package_property_t flags,
                                                              off64_t offset,
                                                              off64_t len) {
-  ZipArchiveHandle handle;
   const int released_fd = fd.release();
-  const int32_t result = (len == AssetsProvider::kUnknownLength)
-      ? ::OpenArchiveFd(released_fd, friendly_name.c_str(), &handle)
-      : ::OpenArchiveFdRange(released_fd, friendly_name.c_str(), &handle, len, offset);
+  int32_t result = 0;
+  ZipArchiveCache::Archive archive;
+  if (len == AssetsProvider::kUnknownLength) {
+    archive = ZipArchiveCache::OpenFd(released_fd, friendly_name.c_str(),
+                                      true /* assume_ownership */, &result);
+  } else {
+    // Archives embedded in a range of a larger file are not shared.
+    ZipArchiveHandle handle;
+    result = ::OpenArchiveFdRange(released_fd, friendly_name.c_str(), &handle, len, offset);
+    if (result == 0) {
+      archive = ZipArchiveCache::Adopt(handle);
+    } else {
+      CloseArchive(handle);
+    }
+  }
 
-  if (result != 0) {
+  if (archive == nullptr) {
     LOG(ERROR) << "Failed to open APK '" << friendly_name << "' through FD with offset " << offset
                << " and length " << len << ": " << ::ErrorCodeString(result);
-    CloseArchive(handle);
     return {};
   }
 
+  // The fd may have been closed if the archive was already open, use the archive's own.
+  const int archive_fd = GetFileDescriptor(archive.get());
   ModDate mod_date = kInvalidModDate;
   // Skip all up-to-date checks if the file won't ever change.
-  if (!isReadonlyFilesystem(released_fd)) {
-    if (mod_date = getFileModDate(released_fd); mod_date == kInvalidModDate) {
+  if (!isReadonlyFilesystem(archive_fd)) {
+    if (mod_date = getFileModDate(archive_fd); mod_date == kInvalidModDate) {
       // Stat requires execute permissions on all directories path to the file. If the process does
       // not have execute permissions on this file, allow the zip to be opened but IsUpToDate() will
       // always have to return true.
@@ -173,7 +206,7 @@ std::unique_ptr<ZipAssetsProvider> ZipAssetsProvider::Create(base::unique_fd fd,
   }
 
   return std::unique_ptr<ZipAssetsProvider>(new ZipAssetsProvider(
-      handle, PathOrDebugName::DebugName(std::move(friendly_name)), mod_date, flags));
+      std::move(archive), PathOrDebugName::DebugName(std::move(friendly_name)), mod_date, flags));
 }
 
 std::unique_ptr<Asset> ZipAssetsProvider::OpenInternal(const std::string& path,
@@ -240,6 +273,32 @@ std::unique_ptr<Asset> ZipAssetsProvider::OpenInternal(const std::string& path,
     return asset;
 }
 
+static constexpr std::string_view kAssetsPrefix = "assets/";
+
+bool ZipAssetsProvider::IndexAssets() const {
+  std::call_once(assets_index_once_, [this] {
+    void* cookie;
+    if (StartIteration(zip_handle_.get(), &cookie, kAssetsPrefix, "") != 0) {
+      return;
+    }
+    std::string name;
+    ::ZipEntry entry{};
+    int32_t result;
+    while ((result = Next(cookie, &entry, &name)) == 0) {
+      assets_index_.push_back(name);
+    }
+    EndIteration(cookie);
+    if (result != -1) {
+      assets_index_.clear();
+      return;
+    }
+    std::sort(assets_index_.begin(), assets_index_.end());
+    assets_index_.shrink_to_fit();
+    assets_index_valid_ = true;
+  });
+  return assets_index_valid_;
+}
+
 bool ZipAssetsProvider::ForEachFile(
     const std::string& root_path,
     base::function_ref<void(StringPiece, FileType)> f) const {
@@ -248,6 +307,33 @@ bool ZipAssetsProvider::ForEachFile(
       root_path_full += '/';
     }
 
+    if (root_path_full.starts_with(kAssetsPrefix) && IndexAssets()) {
+      // Binary search for the directory, and skip over the entries of each subdirectory, so that
+      // only the direct children are visited.
+      std::vector<std::string_view> dirs;
+      auto it = std::lower_bound(assets_index_.begin(), assets_index_.end(), root_path_full);
+      while (it != assets_index_.end() && it->starts_with(root_path_full)) {
+        std::string_view leaf = std::string_view(*it).substr(root_path_full.size());
+        const size_t slash = leaf.find('/');
+        if (slash == std::string_view::npos) {
+          if (!leaf.empty()) {
+            f(leaf, kFileTypeRegular);
+          }
+          ++it;
+          continue;
+        }
+        dirs.push_back(leaf.substr(0, slash));
+        // '0' sorts right after '/', so this is the first name past the subdirectory.
+        std::string next = root_path_full;
+        next.append(leaf.substr(0, slash)).push_back('/' + 1);
+        it = std::lower_bound(it, assets_index_.end(), next);
+      }
+      for (std::string_view dir : dirs) {
+        f(dir, kFileTypeDirectory);
+      }
+      return true;
+    }
+
     void* cookie;
     if (StartIteration(zip_handle_.get(), &cookie, root_path_full, "") != 0) {
       return false;
@@ -294,6 +380,64 @@ std::optional<uint32_t> ZipAssetsProvider::GetCrc(std::string_view path) const {
   return entry.crc32;
 }
 
+size_t ZipAssetsProvider::Prefetch(std::span<const std::string> paths) const {
+#if defined(__linux__)
+  // Byte ranges of the entry data within the zip file.
+  std::vector<std::pair<off64_t, off64_t>> ranges;
+  ranges.reserve(paths.size());
+  for (const auto& path : paths) {
+    ::ZipEntry entry;
+    if (FindEntry(zip_handle_.get(), path, &entry) != 0) {
+      continue;
+    }
+    const off64_t length = entry.method == kCompressDeflated ? entry.compressed_length
+                                                             : entry.uncompressed_length;
+    ranges.emplace_back(entry.offset, entry.offset + length);
+  }
+  if (ranges.empty()) {
+    return 0;
+  }
+
+  // Merge the ranges that are close to each other into fewer, larger requests, counting the files
+  // each request covers.
+  std::sort(ranges.begin(), ranges.end());
+  struct Request {
+    off64_t start;
+    off64_t end;
+    size_t files;
+  };
+  std::vector<Request> merged;
+  for (const auto& range : ranges) {
+    if (!merged.empty() && range.first - merged.back().end <= kPrefetchMergeGap) {
+      merged.back().end = std::max(merged.back().end, range.second);
+      ++merged.back().files;
+    } else {
+      merged.push_back({range.first, range.second, 1});
+    }
+  }
+
+  const int fd = GetFileDescriptor(zip_handle_.get());
+  const off64_t fd_offset = GetFileDescriptorOffset(zip_handle_.get());
+  size_t prefetched = 0;
+  for (const auto& request : merged) {
+    // This only queues the readahead, so slow storage or IncFS fill the pages while the caller
+    // goes on with other startup work.
+    if (int error = posix_fadvise(fd, fd_offset + request.start, request.end - request.start,
+                                  POSIX_FADV_WILLNEED);
+        error != 0) {
+      LOG(WARNING) << "Failed to prefetch from '" << name_.GetDebugName()
+                   << "': " << base::SystemErrorCodeToString(error);
+      break;
+    }
+    prefetched += request.files;
+  }
+  return prefetched;
+#else
+  (void)paths;
+  return 0;
+#endif
+}
+
 std::optional<std::string_view> ZipAssetsProvider::GetPath() const {
   if (name_.GetPath() != nullptr) {
     return *name_.GetPath();
@@ -413,6 +557,11 @@ UpToDate MultiAssetsProvider::IsUpToDate() const {
   return combine(primary_->IsUpToDate(), [this] { return secondary_->IsUpToDate(); });
 }
 
+size_t MultiAssetsProvider::Prefetch(std::span<const std::string> paths) const {
+  // A file may come from either provider, so hint both of them.
+  return primary_->Prefetch(paths) + secondary_->Prefetch(paths);
+}
+
 EmptyAssetsProvider::EmptyAssetsProvider(std::optional<std::string>&& path) :
     path_(std::move(path)) {}
 
@@ -40,14 +40,37 @@ class XmlAttributeFinder
  public:
   explicit XmlAttributeFinder(const ResXMLParser* parser)
       : BackTrackingAttributeFinder(0, parser != nullptr ? parser->getAttributeCount() : 0),
-        parser_(parser) {}
+        parser_(parser),
+        count_(parser != nullptr ? parser->getAttributeCount() : 0),
+        order_(parser != nullptr ? parser->getAttributeResIdOrder() : nullptr) {}
 
   inline uint32_t GetAttribute(size_t index) const {
     return parser_->getAttributeNameResID(index);
   }
 
+  // If the XML tree has an attribute index, the attributes sorted by resource ID are merged with
+  // the requested attributes, which needs no package bookkeeping or backtracking.
+  size_t Find(uint32_t attr) {
+    if (order_ == nullptr) {
+      return BackTrackingAttributeFinder::Find(attr);
+    }
+    if (attr < last_attr_) {
+      // The attributes are not requested in ascending order, start over.
+      next_ = 0;
+    }
+    last_attr_ = attr;
+    while (next_ < count_ && GetAttribute(order_[next_]) < attr) {
+      next_++;
+    }
+    return next_ < count_ && GetAttribute(order_[next_]) == attr ? order_[next_] : count_;
+  }
+
  private:
   const ResXMLParser* parser_;
+  const size_t count_;
+  const uint16_t* const order_;
+  size_t next_ = 0;
+  uint32_t last_attr_ = 0;
 };
 
 class BagAttributeFinder
@@ -63,6 +86,35 @@ class BagAttributeFinder
   }
 };
 
+// Finds attributes in the theme. Requested attributes are sorted, so looking them up in order walks
+// the sorted theme attributes only once instead of binary searching them for every attribute.
+class ThemeAttributeFinder
+    : public BackTrackingAttributeFinder<ThemeAttributeFinder, const uint32_t*> {
+ public:
+  explicit ThemeAttributeFinder(const Theme* theme)
+      : BackTrackingAttributeFinder(theme->GetAttributeIds().data(),
+                                    theme->GetAttributeIds().data() +
+                                        theme->GetAttributeIds().size()),
+        theme_(theme) {
+  }
+
+  inline uint32_t GetAttribute(const uint32_t* id) const {
+    return *id;
+  }
+
+  // Same as Theme::GetAttribute(attr), for attributes requested in the sorted order.
+  std::optional<AssetManager2::SelectedValue> FindValue(uint32_t attr) {
+    const uint32_t* const id = Find(attr);
+    if (id == end()) {
+      return std::nullopt;
+    }
+    return theme_->GetAttributeAt(id - theme_->GetAttributeIds().data());
+  }
+
+ private:
+  const Theme* theme_;
+};
+
 base::expected<const ResolvedBag*, NullOrIOError> GetStyleBag(Theme* theme,
                                                               uint32_t theme_attribute_resid,
                                                               uint32_t fallback_resid,
@@ -129,6 +181,9 @@ base::expected<std::monostate, IOError> ResolveAttrs(Theme* theme, uint32_t def_
   int indices_idx = 0;
   const AssetManager2* assetmanager = theme->GetAssetManager();
 
+  // Keep the ApkAssets promoted for all the lookups below instead of once per lookup.
+  auto op = assetmanager->StartOperation();
+
   // Load default style from attribute or resource id, if specified...
   uint32_t def_style_theme_flags = 0U;
   const auto default_style_bag = GetStyleBag(theme, def_style_attr, def_style_res,
@@ -138,6 +193,7 @@ base::expected<std::monostate, IOError> ResolveAttrs(Theme* theme, uint32_t def_
   }
 
   BagAttributeFinder def_style_attr_finder(default_style_bag.value_or(nullptr));
+  ThemeAttributeFinder theme_attr_finder(theme);
 
   // Now iterate through all of the attributes that the client has requested,
   // filling in each with whatever data we can find.
@@ -173,7 +229,7 @@ base::expected<std::monostate, IOError> ResolveAttrs(Theme* theme, uint32_t def_
       DEBUG_LOG("-> Resolved attr: type=0x%x, data=0x%08x", value.type, value.data);
     } else if (value.data != Res_value::DATA_NULL_EMPTY) {
       // If we still don't have a value for this attribute, try to find it in the theme!
-      if (auto attr_value = theme->GetAttribute(cur_ident)) {
+      if (auto attr_value = theme_attr_finder.FindValue(cur_ident)) {
         value = *attr_value;
         DEBUG_LOG("-> From theme: type=0x%x, data=0x%08x", value.type, value.data);
 
@@ -228,6 +284,9 @@ base::expected<std::monostate, IOError> ApplyStyle(Theme* theme, ResXMLParser* x
   int indices_idx = 0;
   const AssetManager2* assetmanager = theme->GetAssetManager();
 
+  // Keep the ApkAssets promoted for all the lookups below instead of once per lookup.
+  auto op = assetmanager->StartOperation();
+
   // Load default style from attribute, if specified...
   uint32_t def_style_theme_flags = 0U;
   const auto default_style_bag = GetStyleBag(theme, def_style_attr, def_style_resid,
@@ -246,6 +305,7 @@ base::expected<std::monostate, IOError> ApplyStyle(Theme* theme, ResXMLParser* x
   BagAttributeFinder def_style_attr_finder(default_style_bag.value_or(nullptr));
   BagAttributeFinder xml_style_attr_finder(xml_style_bag.value_or(nullptr));
   XmlAttributeFinder xml_attr_finder(xml_parser);
+  ThemeAttributeFinder theme_attr_finder(theme);
 
   // Now iterate through all of the attributes that the client has requested,
   // filling in each with whatever data we can find.
@@ -305,7 +365,7 @@ base::expected<std::monostate, IOError> ApplyStyle(Theme* theme, ResXMLParser* x
       DEBUG_LOG("-> Resolved attr: type=0x%x, data=0x%08x", value.type, value.data);
     } else if (value.data != Res_value::DATA_NULL_EMPTY) {
       // If we still don't have a value for this attribute, try to find it in the theme!
-      if (auto attr_value = theme->GetAttribute(cur_ident)) {
+      if (auto attr_value = theme_attr_finder.FindValue(cur_ident)) {
         value = *attr_value;
         DEBUG_LOG("-> From theme: type=0x%x, data=0x%08x", value.type, value.data);
 
@@ -357,6 +417,9 @@ base::expected<std::monostate, IOError> RetrieveAttributes(AssetManager2* assetm
                                                            uint32_t* out_indices) {
   int indices_idx = 0;
 
+  // Keep the ApkAssets promoted for all the lookups below instead of once per lookup.
+  auto op = assetmanager->StartOperation();
+
   // Retrieve the XML attributes, if requested.
   size_t ix = 0;
   const size_t xml_attr_count = xml_parser->getAttributeCount();
@@ -20,6 +20,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <memory>
+
 #include <androidfw/BackupHelpers.h>
 #include <log/log.h>
 #include <utils/ByteOrder.h>
@@ -62,27 +64,6 @@ BackupDataWriter::~BackupDataWriter()
 {
 }
 
-// Pad out anything they've previously written to the next 4 byte boundary.
-status_t
-BackupDataWriter::write_padding_for(int n)
-{
-    ssize_t amt;
-    ssize_t paddingSize;
-
-    paddingSize = padding_extra(n);
-    if (paddingSize > 0) {
-        uint32_t padding = 0xbcbcbcbc;
-        if (kIsDebug) ALOGI("writing %zd padding bytes for %d", paddingSize, n);
-        amt = write(m_fd, &padding, paddingSize);
-        if (amt != paddingSize) {
-            m_status = errno;
-            return m_status;
-        }
-        m_pos += amt;
-    }
-    return NO_ERROR;
-}
-
 status_t
 BackupDataWriter::WriteEntityHeader(const String8& key, size_t dataSize)
 {
@@ -90,13 +71,6 @@ BackupDataWriter::WriteEntityHeader(const String8& key, size_t dataSize)
         return m_status;
     }
 
-    ssize_t amt;
-
-    amt = write_padding_for(m_pos);
-    if (amt != 0) {
-        return amt;
-    }
-
     String8 k;
     if (m_keyPrefix.length() > 0) {
         k = m_keyPrefix;
@@ -119,27 +93,42 @@ BackupDataWriter::WriteEntityHeader(const String8& key, size_t dataSize)
     header.keyLen = tolel(keyLen);
     header.dataSize = tolel(dataSize);
 
-    if (kIsDebug) ALOGI("writing entity header, %zu bytes", sizeof(entity_header_v1));
-    amt = write(m_fd, &header, sizeof(entity_header_v1));
-    if (amt != sizeof(entity_header_v1)) {
-        m_status = errno;
-        return m_status;
+    // The padding for whatever was written before, the header, the key and the key padding
+    // all go out in a single write, since backups of many small files are bound by syscalls.
+    const size_t leadingPadding = padding_extra(m_pos);
+    const size_t keyPadding = padding_extra(keyLen+1);
+    const size_t totalSize = leadingPadding + sizeof(entity_header_v1) + keyLen+1 + keyPadding;
+
+    uint8_t stackBuffer[256];
+    std::unique_ptr<uint8_t[]> heapBuffer;
+    uint8_t* buffer = stackBuffer;
+    if (totalSize > sizeof(stackBuffer)) {
+        heapBuffer.reset(new uint8_t[totalSize]);
+        buffer = heapBuffer.get();
     }
-    m_pos += amt;
+    uint8_t* p = buffer;
+    memset(p, 0xbc, leadingPadding);
+    p += leadingPadding;
+    memcpy(p, &header, sizeof(entity_header_v1));
+    p += sizeof(entity_header_v1);
+    memcpy(p, k.c_str(), keyLen+1);
+    p += keyLen+1;
+    memset(p, 0xbc, keyPadding);
 
-    if (kIsDebug) ALOGI("writing entity header key, %zd bytes", keyLen+1);
-    amt = write(m_fd, k.c_str(), keyLen+1);
-    if (amt != keyLen+1) {
+    if (kIsDebug) {
+        ALOGI("writing entity header, %zu bytes with key and %zu+%zu padding bytes",
+                totalSize, leadingPadding, keyPadding);
+    }
+    ssize_t amt = write(m_fd, buffer, totalSize);
+    if (amt != (ssize_t)totalSize) {
         m_status = errno;
         return m_status;
     }
     m_pos += amt;
 
-    amt = write_padding_for(keyLen+1);
-
     m_entityCount++;
 
-    return amt;
+    return NO_ERROR;
 }
 
 status_t
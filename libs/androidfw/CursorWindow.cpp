@@ -18,6 +18,13 @@
 
 #include <androidfw/CursorWindow.h>
 
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
 #include "android-base/logging.h"
 #include "android-base/mapped_file.h"
 #include "cutils/ashmem.h"
@@ -35,11 +42,109 @@ static constexpr const size_t kInlineSize = 16384;
 static constexpr const size_t kSlotShift = 4;
 static constexpr const size_t kSlotSizeBytes = 1 << kSlotShift;
 
+/**
+ * The most memory that the ashmem region pool keeps mapped, i.e. a few windows of the
+ * default 2MB size.
+ */
+static constexpr const size_t kMaxPooledBytes = 8 * 1024 * 1024;
+
+/**
+ * Strings up to this size, including the terminating null, are looked up in the string
+ * dictionary. Longer values rarely repeat and cost more to compare.
+ */
+static constexpr const size_t kMaxDictionaryStringSize = 64;
+static constexpr const size_t kStringDictionarySize = 256;
+
+namespace {
+
+/**
+ * A process-wide pool of mapped ashmem regions left behind by destroyed windows. Query-heavy
+ * processes create and destroy windows of the same few sizes all the time, and reusing the
+ * regions saves creating, mapping and faulting in a new one for each query.
+ */
+class RegionPool {
+public:
+    /**
+     * Takes a region of exactly the given size from the pool. The region is already mapped
+     * writable and restricted to read-only mappings for other processes.
+     */
+    bool take(size_t size, int* outFd, std::optional<MappedFile>* outMappedFile) {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto it = mRegions.begin(); it != mRegions.end(); ++it) {
+            if (it->mappedFile.size() == size) {
+                *outFd = it->fd;
+                *outMappedFile = std::move(it->mappedFile);
+                mRegions.erase(it);
+                mPooledBytes -= size;
+                mHits.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        mMisses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * Puts a wiped region into the pool. Returns false if the pool is full, in which case the
+     * caller still owns the region.
+     */
+    bool put(int fd, MappedFile&& mappedFile) {
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mPooledBytes + mappedFile.size() > kMaxPooledBytes) {
+            return false;
+        }
+        mPooledBytes += mappedFile.size();
+        mRegions.push_back(Region{fd, std::move(mappedFile)});
+        return true;
+    }
+
+    CursorWindow::PoolStats stats() {
+        std::lock_guard<std::mutex> lock(mLock);
+        return CursorWindow::PoolStats{
+                .hits = mHits.load(std::memory_order_relaxed),
+                .misses = mMisses.load(std::memory_order_relaxed),
+                .pooledBytes = mPooledBytes,
+        };
+    }
+
+private:
+    struct Region {
+        int fd;
+        MappedFile mappedFile;
+    };
+
+    std::mutex mLock;
+    std::vector<Region> mRegions;
+    size_t mPooledBytes = 0;
+    std::atomic<uint64_t> mHits = 0;
+    std::atomic<uint64_t> mMisses = 0;
+};
+
+RegionPool& getRegionPool() {
+    // Leaked on purpose, windows may be destroyed during static destruction.
+    static RegionPool* pool = new RegionPool();
+    return *pool;
+}
+
+} // namespace
+
 CursorWindow::CursorWindow() {
 }
 
 CursorWindow::~CursorWindow() {
     if (mAshmemFd >= 0) {
+        if (!mReadOnly && !mShared && mMappedFile) {
+            // Wipe everything this window wrote, so the next window doesn't hand out stale rows
+            // when it is sent to another process. Only the touched pages are written.
+            uint8_t* data = static_cast<uint8_t*>(mData);
+            const uint32_t allocOffset = std::max(mAllocOffset, mDirtyAllocOffset);
+            const uint32_t slotsOffset = std::min(mSlotsOffset, mDirtySlotsOffset);
+            memset(data, 0, allocOffset);
+            memset(data + slotsOffset, 0, mSize - slotsOffset);
+            if (getRegionPool().put(mAshmemFd, std::move(*mMappedFile))) {
+                return;
+            }
+        }
         mMappedFile.reset();
         ::close(mAshmemFd);
     } else {
@@ -47,6 +152,10 @@ CursorWindow::~CursorWindow() {
     }
 }
 
+CursorWindow::PoolStats CursorWindow::getPoolStats() {
+    return getRegionPool().stats();
+}
+
 status_t CursorWindow::create(const String8 &name, size_t inflatedSize, CursorWindow **outWindow) {
     *outWindow = nullptr;
 
@@ -83,10 +192,16 @@ status_t CursorWindow::maybeInflate() {
         return INVALID_OPERATION;
     }
 
-    String8 ashmemName("CursorWindow: ");
-    ashmemName.append(mName);
+    if (getRegionPool().take(mInflatedSize, &ashmemFd, &newMappedFile)) {
+        newData = newMappedFile->data();
+        goto migrate;
+    }
 
-    ashmemFd = ashmem_create_region(ashmemName.c_str(), mInflatedSize);
+    {
+        String8 ashmemName("CursorWindow: ");
+        ashmemName.append(mName);
+        ashmemFd = ashmem_create_region(ashmemName.c_str(), mInflatedSize);
+    }
     if (ashmemFd < 0) {
         PLOG(ERROR) << "Failed ashmem_create_region";
         goto fail_silent;
@@ -109,6 +224,7 @@ status_t CursorWindow::maybeInflate() {
         goto fail_silent;
     }
 
+migrate:
     {
         // Migrate existing contents into new ashmem region
         uint32_t slotsSize = sizeOfSlots();
@@ -124,6 +240,9 @@ status_t CursorWindow::maybeInflate() {
         mData = newData;
         mSize = mInflatedSize;
         mSlotsOffset = newSlotsOffset;
+        // The new region is clean apart from the migrated contents.
+        mDirtyAllocOffset = 0;
+        mDirtySlotsOffset = mSize;
 
         updateSlotsData();
     }
@@ -226,6 +345,7 @@ status_t CursorWindow::writeToParcel(Parcel* parcel) {
         if (parcel->writeUint32(mSize)) goto fail;
         if (parcel->writeBool(/*isAshmem=*/true)) goto fail;
         if (parcel->writeDupFileDescriptor(mAshmemFd)) goto fail;
+        mShared = true;
     } else {
         // Since we know we're going to be read-only on the remote side,
         // we can compact ourselves on the wire.
@@ -253,6 +373,11 @@ status_t CursorWindow::clear() {
     if (mReadOnly) {
         return INVALID_OPERATION;
     }
+    mDirtyAllocOffset = std::max(mDirtyAllocOffset, mAllocOffset);
+    mDirtySlotsOffset = std::min(mDirtySlotsOffset, mSlotsOffset);
+    if (mStringDictionary) {
+        memset(mStringDictionary.get(), 0, kStringDictionarySize * sizeof(StringDictionaryEntry));
+    }
     mAllocOffset = 0;
     mSlotsOffset = mSize;
     mNumRows = 0;
@@ -325,6 +450,8 @@ status_t CursorWindow::freeLastRow() {
     if (newOffset > mSize) {
         return NO_MEMORY;
     }
+    // The freed row stays written, so it has to be wiped with the rest when the region is pooled.
+    mDirtySlotsOffset = std::min(mDirtySlotsOffset, mSlotsOffset);
     mSlotsOffset = newOffset;
     updateSlotsData();
     mNumRows--;
@@ -370,7 +497,39 @@ status_t CursorWindow::putBlob(uint32_t row, uint32_t column, const void* value,
 
 status_t CursorWindow::putString(uint32_t row, uint32_t column, const char* value,
         size_t sizeIncludingNull) {
-    return putBlobOrString(row, column, value, sizeIncludingNull, FIELD_TYPE_STRING);
+    if (mReadOnly || sizeIncludingNull > kMaxDictionaryStringSize) {
+        return putBlobOrString(row, column, value, sizeIncludingNull, FIELD_TYPE_STRING);
+    }
+
+    // FNV-1a; the strings are short, so this costs less than the allocation it may save.
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeIncludingNull; i++) {
+        hash = (hash ^ static_cast<uint8_t>(value[i])) * 16777619u;
+    }
+    if (!mStringDictionary) {
+        mStringDictionary = std::make_unique<StringDictionaryEntry[]>(kStringDictionarySize);
+    }
+    StringDictionaryEntry& entry = mStringDictionary[hash % kStringDictionarySize];
+    if (entry.size == sizeIncludingNull && entry.hash == hash
+            && memcmp(offsetToPtr(entry.offset, entry.size), value, sizeIncludingNull) == 0) {
+        FieldSlot* fieldSlot = getFieldSlot(row, column);
+        if (!fieldSlot) {
+            return BAD_VALUE;
+        }
+        // The heap is never written in place, so the fields can share the stored value.
+        fieldSlot->type = FIELD_TYPE_STRING;
+        fieldSlot->data.buffer.offset = entry.offset;
+        fieldSlot->data.buffer.size = entry.size;
+        return OK;
+    }
+
+    status_t status = putBlobOrString(row, column, value, sizeIncludingNull, FIELD_TYPE_STRING);
+    if (status == OK) {
+        const FieldSlot* fieldSlot = getFieldSlot(row, column);
+        entry = StringDictionaryEntry{hash, fieldSlot->data.buffer.offset,
+                static_cast<uint32_t>(sizeIncludingNull)};
+    }
+    return status;
 }
 
 status_t CursorWindow::putBlobOrString(uint32_t row, uint32_t column,
@@ -444,4 +603,81 @@ status_t CursorWindow::putNull(uint32_t row, uint32_t column) {
     return OK;
 }
 
+template <typename T, typename Convert>
+status_t CursorWindow::getColumnRange(uint32_t column, uint32_t startRow, uint32_t numRows,
+        T* outValues, Convert convert) {
+    if (column >= mNumColumns || startRow > mNumRows || numRows > mNumRows - startRow) {
+        LOG(ERROR) << "Failed to read rows " << startRow << "+" << numRows << ", column "
+                << column << " from a window with " << mNumRows << " rows, " << mNumColumns
+                << " columns";
+        return BAD_VALUE;
+    }
+    if (numRows == 0) {
+        return OK;
+    }
+
+    // The slots of a column are mNumColumns slots apart, going down from mSlotsStart.
+    uint8_t* slot = static_cast<uint8_t*>(mSlotsStart)
+            - (((startRow * mNumColumns) + column) << kSlotShift);
+    const size_t rowStride = mNumColumns << kSlotShift;
+    for (uint32_t i = 0; i < numRows; i++, slot -= rowStride) {
+        if (!convert(reinterpret_cast<FieldSlot*>(slot), &outValues[i])) {
+            return BAD_TYPE;
+        }
+    }
+    return OK;
+}
+
+status_t CursorWindow::getColumnLongs(uint32_t column, uint32_t startRow, uint32_t numRows,
+        int64_t* outValues) {
+    return getColumnRange(column, startRow, numRows, outValues,
+            [this](FieldSlot* fieldSlot, int64_t* outValue) {
+        switch (fieldSlot->type) {
+            case FIELD_TYPE_INTEGER:
+                *outValue = fieldSlot->data.l;
+                return true;
+            case FIELD_TYPE_FLOAT:
+                *outValue = static_cast<int64_t>(fieldSlot->data.d);
+                return true;
+            case FIELD_TYPE_STRING: {
+                size_t sizeIncludingNull;
+                const char* value = getFieldSlotValueString(fieldSlot, &sizeIncludingNull);
+                *outValue = sizeIncludingNull > 1 ? strtoll(value, nullptr, 0) : 0;
+                return true;
+            }
+            case FIELD_TYPE_NULL:
+                *outValue = 0;
+                return true;
+            default:
+                return false;
+        }
+    });
+}
+
+status_t CursorWindow::getColumnDoubles(uint32_t column, uint32_t startRow, uint32_t numRows,
+        double* outValues) {
+    return getColumnRange(column, startRow, numRows, outValues,
+            [this](FieldSlot* fieldSlot, double* outValue) {
+        switch (fieldSlot->type) {
+            case FIELD_TYPE_FLOAT:
+                *outValue = fieldSlot->data.d;
+                return true;
+            case FIELD_TYPE_INTEGER:
+                *outValue = static_cast<double>(fieldSlot->data.l);
+                return true;
+            case FIELD_TYPE_STRING: {
+                size_t sizeIncludingNull;
+                const char* value = getFieldSlotValueString(fieldSlot, &sizeIncludingNull);
+                *outValue = sizeIncludingNull > 1 ? strtod(value, nullptr) : 0.0;
+                return true;
+            }
+            case FIELD_TYPE_NULL:
+                *outValue = 0.0;
+                return true;
+            default:
+                return false;
+        }
+    });
+}
+
 }; // namespace android
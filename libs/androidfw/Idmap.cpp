@@ -18,6 +18,9 @@
 
 #include "androidfw/Idmap.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "android-base/file.h"
 #include "android-base/logging.h"
 #include "android-base/stringprintf.h"
@@ -145,7 +148,8 @@ IdmapResMap::IdmapResMap(const Idmap_data_header* data_header, const Idmap_const
                          Idmap_target_entries entries, Idmap_target_inline_entries inline_entries,
                          const Idmap_target_entry_inline_value* inline_entry_values,
                          const ConfigDescription* configs, uint8_t target_assigned_package_id,
-                         const OverlayDynamicRefTable* overlay_ref_table)
+                         const OverlayDynamicRefTable* overlay_ref_table,
+                         const std::vector<IdmapTypeIndex>* type_indexes)
     : data_header_(data_header),
       constraints_(constraints),
       entries_(entries),
@@ -153,7 +157,8 @@ IdmapResMap::IdmapResMap(const Idmap_data_header* data_header, const Idmap_const
       inline_entry_values_(inline_entry_values),
       configurations_(configs),
       target_assigned_package_id_(target_assigned_package_id),
-      overlay_ref_table_(overlay_ref_table) {
+      overlay_ref_table_(overlay_ref_table),
+      type_indexes_(type_indexes) {
 }
 
 IdmapResMap::Result IdmapResMap::Lookup(uint32_t target_res_id) const {
@@ -166,6 +171,27 @@ IdmapResMap::Result IdmapResMap::Lookup(uint32_t target_res_id) const {
   // package id when determining if the resource in the target package is overlaid.
   target_res_id &= 0x00FFFFFFU;
 
+  if (type_indexes_ != nullptr) {
+    const size_t type_id = target_res_id >> 16U;
+    if (type_id >= type_indexes_->size()) {
+      return {};
+    }
+    const IdmapTypeIndex& type_index = (*type_indexes_)[type_id];
+    if (type_index.dense) {
+      const size_t slot_index = (target_res_id & 0xFFFFU) - type_index.first_entry;
+      if (slot_index >= type_index.slots.size()) {
+        return {};
+      }
+      const uint32_t slot = type_index.slots[slot_index];
+      if (slot == IdmapTypeIndex::kEmptySlot) {
+        return {};
+      }
+      return (slot & IdmapTypeIndex::kInlineSlot) != 0
+                 ? InlineEntryResult(slot & ~IdmapTypeIndex::kInlineSlot)
+                 : TargetEntryResult(slot);
+    }
+  }
+
   // Check if the target resource is mapped to an overlay resource.
   const auto target_end = entries_.target_id + dtohl(data_header_->target_entry_count);
   auto target_it = std::lower_bound(entries_.target_id, target_end, target_res_id,
@@ -174,12 +200,7 @@ IdmapResMap::Result IdmapResMap::Lookup(uint32_t target_res_id) const {
                                     });
 
   if (target_it != target_end && convert_dev_target_id(*target_it) == target_res_id) {
-    const auto index = target_it - entries_.target_id;
-    uint32_t overlay_resource_id = dtohl(entries_.overlay_id[index]);
-    // Lookup the resource without rewriting the overlay resource id back to the target resource id
-    // being looked up.
-    overlay_ref_table_->lookupResourceIdNoRewrite(&overlay_resource_id);
-    return Result(overlay_resource_id);
+    return TargetEntryResult(target_it - entries_.target_id);
   }
 
   // Check if the target resources is mapped to an inline table entry.
@@ -193,19 +214,30 @@ IdmapResMap::Result IdmapResMap::Lookup(uint32_t target_res_id) const {
 
   if (inline_entry_target_it != inline_entry_target_end &&
       convert_dev_target_id(*inline_entry_target_it) == target_res_id) {
-    const auto index = inline_entry_target_it - inline_entries_.target_id;
-    std::map<ConfigDescription, Res_value> values_map;
-    const auto& inline_entry = inline_entries_.entry[index];
-    for (int i = 0; i < dtohl(inline_entry.value_count); i++) {
-      const auto& value = inline_entry_values_[dtohl(inline_entry.start_value_index) + i];
-      const auto& config = configurations_[dtohl(value.config_index)];
-      values_map[config] = value.value;
-    }
-    return Result(std::move(values_map));
+    return InlineEntryResult(inline_entry_target_it - inline_entries_.target_id);
   }
   return {};
 }
 
+IdmapResMap::Result IdmapResMap::TargetEntryResult(size_t index) const {
+  uint32_t overlay_resource_id = dtohl(entries_.overlay_id[index]);
+  // Lookup the resource without rewriting the overlay resource id back to the target resource id
+  // being looked up.
+  overlay_ref_table_->lookupResourceIdNoRewrite(&overlay_resource_id);
+  return Result(overlay_resource_id);
+}
+
+IdmapResMap::Result IdmapResMap::InlineEntryResult(size_t index) const {
+  std::map<ConfigDescription, Res_value> values_map;
+  const auto& inline_entry = inline_entries_.entry[index];
+  for (int i = 0; i < dtohl(inline_entry.value_count); i++) {
+    const auto& value = inline_entry_values_[dtohl(inline_entry.start_value_index) + i];
+    const auto& config = configurations_[dtohl(value.config_index)];
+    values_map[config] = value.value;
+  }
+  return Result(std::move(values_map));
+}
+
 namespace {
 template <typename T>
 const T* ReadType(const uint8_t** in_out_data_ptr, size_t* in_out_size, const char* label,
@@ -282,6 +314,77 @@ LoadedIdmap::LoadedIdmap(const std::string& idmap_path, const Idmap_header* head
         android::base::utf8::open(idmap_path.c_str(), O_RDONLY | O_CLOEXEC | O_BINARY | O_PATH));
     idmap_last_mod_time_ = getFileModDate(idmap_fd_);
   }
+  BuildTypeIndexes();
+}
+
+void LoadedIdmap::BuildTypeIndexes() {
+  // A type is indexed densely when it has at most this many slots per overlaid entry, or at most
+  // kMinDenseSlots slots, which keeps the index within a few times the size of the entries.
+  constexpr size_t kMaxSlotsPerEntry = 4;
+  constexpr size_t kMinDenseSlots = 64;
+
+  const uint32_t target_count = dtohl(data_header_->target_entry_count);
+  const uint32_t inline_count = dtohl(data_header_->target_inline_entry_count);
+  if (target_count + inline_count == 0) {
+    return;
+  }
+
+  struct TypeRange {
+    uint32_t first = std::numeric_limits<uint32_t>::max();
+    uint32_t last = 0;
+    size_t count = 0;
+  };
+  std::vector<TypeRange> ranges;
+  const auto for_each_entry = [&](auto&& func) {
+    for (uint32_t i = 0; i < target_count; i++) {
+      func(convert_dev_target_id(target_entries_.target_id[i]), i);
+    }
+    for (uint32_t i = 0; i < inline_count; i++) {
+      func(convert_dev_target_id(target_inline_entries_.target_id[i]),
+           i | IdmapTypeIndex::kInlineSlot);
+    }
+  };
+  for_each_entry([&ranges](uint32_t target_id, uint32_t /* slot */) {
+    const size_t type_id = target_id >> 16U;
+    const uint32_t entry_id = target_id & 0xFFFFU;
+    if (type_id >= ranges.size()) {
+      ranges.resize(type_id + 1);
+    }
+    TypeRange& range = ranges[type_id];
+    range.first = std::min(range.first, entry_id);
+    range.last = std::max(range.last, entry_id);
+    range.count++;
+  });
+
+  type_indexes_.resize(ranges.size());
+  for (size_t type_id = 0; type_id < ranges.size(); type_id++) {
+    const TypeRange& range = ranges[type_id];
+    IdmapTypeIndex& type_index = type_indexes_[type_id];
+    if (range.count == 0) {
+      // Nothing of the type is overlaid.
+      type_index.dense = true;
+      continue;
+    }
+    const size_t slot_count = range.last - range.first + 1;
+    if (slot_count > std::max(kMinDenseSlots, range.count * kMaxSlotsPerEntry)) {
+      continue;
+    }
+    type_index.dense = true;
+    type_index.first_entry = range.first;
+    type_index.slots.assign(slot_count, IdmapTypeIndex::kEmptySlot);
+  }
+
+  for_each_entry([this](uint32_t target_id, uint32_t slot) {
+    IdmapTypeIndex& type_index = type_indexes_[target_id >> 16U];
+    if (type_index.dense) {
+      uint32_t& dense_slot = type_index.slots[(target_id & 0xFFFFU) - type_index.first_entry];
+      // The target entries come first, so like the searches, the first target entry of a resource
+      // wins over any other entry of it.
+      if (dense_slot == IdmapTypeIndex::kEmptySlot) {
+        dense_slot = slot;
+      }
+    }
+  });
 }
 
 std::unique_ptr<LoadedIdmap> LoadedIdmap::Load(StringPiece idmap_path, StringPiece idmap_data) {
@@ -19,8 +19,11 @@
 #include "androidfw/LoadedArsc.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <limits>
+#include <mutex>
 #include <optional>
 #include <android_content_res.h>
 
@@ -59,6 +62,7 @@ struct TypeSpecBuilder {
   void AddType(incfs::verified_map_ptr<ResTable_type> type) {
     TypeSpec::TypeEntry& entry = type_entries.emplace_back();
     entry.config.copyFromDtoH(type->config);
+    entry.packed_config = PackedConfig::From(entry.config);
     entry.type = type;
   }
 
@@ -76,6 +80,32 @@ struct TypeSpecBuilder {
 
 }  // namespace
 
+struct LoadedPackage::EntryNameIndex {
+  std::mutex lock;
+
+  // The entry index of each key index, per type ID.
+  std::unordered_map<uint8_t, std::unordered_map<uint32_t, uint16_t>> types;
+
+  // Kept up to date so that GetMemoryUsage() doesn't need the lock.
+  std::atomic<size_t> heap_bytes = 0;
+};
+
+struct LoadedPackage::LazyTypes {
+  // Guards the parsing of each type, indexed by type ID.
+  std::array<std::once_flag, std::numeric_limits<uint8_t>::max() + 1> parsed;
+
+  // The unverified type chunks of each type, in the order they appear in the package. These are
+  // released once the type is parsed.
+  std::array<std::vector<incfs::map_ptr<ResTable_type>>, std::numeric_limits<uint8_t>::max() + 1>
+      chunks;
+
+  // The heap used by the recorded chunks and the type entries parsed from them, kept up to date
+  // so that GetMemoryUsage() doesn't race with the parsing.
+  std::atomic<size_t> heap_bytes = 0;
+};
+
+LoadedPackage::~LoadedPackage() = default;
+
 // Precondition: The header passed in has already been verified, so reading any fields and trusting
 // the ResChunk_header is safe.
 static bool VerifyResTableType(incfs::map_ptr<ResTable_type> header) {
@@ -327,9 +357,41 @@ LoadedPackage::GetEntryFromOffset(incfs::verified_map_ptr<ResTable_type> type_ch
   return valid;
 }
 
+void LoadedPackage::ParseLazyType(uint8_t type_id) const {
+  std::call_once(lazy_types_->parsed[type_id], [&] {
+    auto type_spec = type_specs_.find(type_id);
+    if (type_spec == type_specs_.end()) {
+      return;
+    }
+    std::vector<incfs::map_ptr<ResTable_type>> chunks = std::move(lazy_types_->chunks[type_id]);
+    auto& type_entries = type_spec->second.type_entries;
+    type_entries.reserve(chunks.size());
+    for (const auto& type : chunks) {
+      if (!VerifyResTableType(type)) {
+        LOG(ERROR) << StringPrintf("Type %02x of package '%s' is corrupt, ignoring its values.",
+                                   type_id, package_name_.c_str());
+        type_entries.clear();
+        break;
+      }
+      TypeSpec::TypeEntry& entry = type_entries.emplace_back();
+      entry.config.copyFromDtoH(type->config);
+      entry.packed_config = PackedConfig::From(entry.config);
+      entry.type = type.verified();
+    }
+    type_entries.shrink_to_fit();
+    lazy_types_->heap_bytes.fetch_add(type_entries.capacity() * sizeof(TypeSpec::TypeEntry),
+                                      std::memory_order_relaxed);
+    lazy_types_->heap_bytes.fetch_sub(chunks.capacity() * sizeof(chunks[0]),
+                                      std::memory_order_relaxed);
+  });
+}
+
 base::expected<std::monostate, IOError> LoadedPackage::CollectConfigurations(
     bool exclude_mipmap, std::set<ResTable_config>* out_configs) const {
   for (const auto& type_spec : type_specs_) {
+    if (lazy_types_ != nullptr) {
+      ParseLazyType(type_spec.first);
+    }
     if (exclude_mipmap) {
       const int type_idx = type_spec.first - 1;
       const auto type_name16 = type_string_pool_.stringAt(type_idx);
@@ -365,6 +427,9 @@ base::expected<std::monostate, IOError> LoadedPackage::CollectConfigurations(
 void LoadedPackage::CollectLocales(bool canonicalize,
                                    Locales* out_locales) const {
   for (const auto& type_spec : type_specs_) {
+    if (lazy_types_ != nullptr) {
+      ParseLazyType(type_spec.first);
+    }
     for (const auto& type_entry : type_spec.second.type_entries) {
       if (type_entry.config.locale != 0) {
         char temp_locale[RESTABLE_MAX_LOCALE_LEN];
@@ -379,26 +444,12 @@ void LoadedPackage::CollectLocales(bool canonicalize,
   }
 }
 
-base::expected<uint32_t, NullOrIOError> LoadedPackage::FindEntryByName(
-    const std::u16string& type_name, const std::u16string& entry_name) const {
-  const base::expected<size_t, NullOrIOError> type_idx = type_string_pool_.indexOfString(
-      type_name.data(), type_name.size());
-  if (!type_idx.has_value()) {
-    return base::unexpected(type_idx.error());
-  }
-
-  const base::expected<size_t, NullOrIOError> key_idx = key_string_pool_.indexOfString(
-      entry_name.data(), entry_name.size());
-  if (!key_idx.has_value()) {
-    return base::unexpected(key_idx.error());
-  }
-
-  const TypeSpec* type_spec = GetTypeSpecByTypeIndex(*type_idx);
-  if (type_spec == nullptr) {
-    return base::unexpected(std::nullopt);
-  }
-
-  for (const auto& type_entry : type_spec->type_entries) {
+// Calls func with the key and the entry index of every entry of every configuration of the type,
+// until it returns true.
+template <typename Func>
+static base::expected<std::monostate, NullOrIOError> ForEachEntryKey(const TypeSpec& type_spec,
+                                                                     Func&& func) {
+  for (const auto& type_entry : type_spec.type_entries) {
     const incfs::verified_map_ptr<ResTable_type>& type = type_entry.type;
 
     const size_t entry_count = dtohl(type->entryCount);
@@ -436,15 +487,88 @@ base::expected<uint32_t, NullOrIOError> LoadedPackage::FindEntryByName(
           return base::unexpected(IOError::PAGES_MISSING);
         }
 
-        if (entry->key() == static_cast<uint32_t>(*key_idx)) {
-          // The package ID will be overridden by the caller (due to runtime assignment of package
-          // IDs for shared libraries).
-          return make_resid(0x00, *type_idx + type_id_offset_ + 1, res_idx);
+        if (func(entry->key(), res_idx)) {
+          return {};
         }
       }
     }
   }
-  return base::unexpected(std::nullopt);
+  return {};
+}
+
+base::expected<uint32_t, NullOrIOError> LoadedPackage::FindEntryByName(
+    const std::u16string& type_name, const std::u16string& entry_name) const {
+  const base::expected<size_t, NullOrIOError> type_idx = type_string_pool_.indexOfString(
+      type_name.data(), type_name.size());
+  if (!type_idx.has_value()) {
+    return base::unexpected(type_idx.error());
+  }
+
+  const base::expected<size_t, NullOrIOError> key_idx = key_string_pool_.indexOfString(
+      entry_name.data(), entry_name.size());
+  if (!key_idx.has_value()) {
+    return base::unexpected(key_idx.error());
+  }
+
+  const TypeSpec* type_spec = GetTypeSpecByTypeIndex(*type_idx);
+  if (type_spec == nullptr) {
+    return base::unexpected(std::nullopt);
+  }
+
+  // The package ID will be overridden by the caller (due to runtime assignment of package IDs for
+  // shared libraries).
+  const uint8_t type_id = *type_idx + type_id_offset_ + 1;
+  if (entry_name_index_ != nullptr) {
+    std::lock_guard<std::mutex> lock(entry_name_index_->lock);
+    auto index = entry_name_index_->types.find(type_id);
+    if (index == entry_name_index_->types.end()) {
+      std::unordered_map<uint32_t, uint16_t> entries;
+      // Keys are not unique once they are collapsed. Like the scan, the index keeps the first entry
+      // of each key.
+      const auto result = ForEachEntryKey(*type_spec, [&](uint32_t key, uint16_t res_idx) {
+        entries.try_emplace(key, res_idx);
+        return false;
+      });
+      if (!result.has_value()) {
+        return base::unexpected(result.error());
+      }
+      entry_name_index_->heap_bytes.fetch_add(
+          entries.size() * (sizeof(std::pair<uint32_t, uint16_t>) + 2 * sizeof(void*)) +
+              entries.bucket_count() * sizeof(void*),
+          std::memory_order_relaxed);
+      index = entry_name_index_->types.emplace(type_id, std::move(entries)).first;
+    }
+    auto entry = index->second.find(static_cast<uint32_t>(*key_idx));
+    if (entry == index->second.end()) {
+      return base::unexpected(std::nullopt);
+    }
+    return make_resid(0x00, type_id, entry->second);
+  }
+
+  std::optional<uint16_t> found;
+  const auto result = ForEachEntryKey(*type_spec, [&](uint32_t key, uint16_t res_idx) {
+    if (key == static_cast<uint32_t>(*key_idx)) {
+      found = res_idx;
+      return true;
+    }
+    return false;
+  });
+  if (!result.has_value()) {
+    return base::unexpected(result.error());
+  }
+  if (!found) {
+    return base::unexpected(std::nullopt);
+  }
+  return make_resid(0x00, type_id, *found);
+}
+
+MemoryUsage LoadedArsc::GetMemoryUsage() const {
+  MemoryUsage usage{.heap_bytes = sizeof(*this) + global_string_pool_->getHeapBytes() +
+                                  packages_.capacity() * sizeof(packages_[0])};
+  for (const auto& package : packages_) {
+    usage += package->GetMemoryUsage();
+  }
+  return usage;
 }
 
 const LoadedPackage* LoadedArsc::GetPackageById(uint8_t package_id) const {
@@ -456,11 +580,48 @@ const LoadedPackage* LoadedArsc::GetPackageById(uint8_t package_id) const {
   return nullptr;
 }
 
+MemoryUsage LoadedPackage::GetMemoryUsage() const {
+  // Approximates the nodes of the node-based containers by their value and two pointers.
+  constexpr size_t kNodeOverhead = 2 * sizeof(void*);
+  size_t bytes = sizeof(*this) + type_string_pool_.getHeapBytes() +
+                 key_string_pool_.getHeapBytes() + package_name_.capacity();
+  bytes += type_specs_.capacity() * sizeof(std::pair<uint8_t, TypeSpec>);
+  if (lazy_types_ != nullptr) {
+    bytes += sizeof(LazyTypes) + lazy_types_->heap_bytes.load(std::memory_order_relaxed);
+  } else {
+    for (const auto& type_spec : type_specs_) {
+      bytes += type_spec.second.type_entries.capacity() * sizeof(TypeSpec::TypeEntry);
+    }
+  }
+  if (entry_name_index_ != nullptr) {
+    bytes += sizeof(EntryNameIndex) + entry_name_index_->heap_bytes.load(std::memory_order_relaxed);
+  }
+  bytes += dynamic_package_map_.capacity() * sizeof(DynamicPackageEntry);
+  for (const auto& entry : dynamic_package_map_) {
+    bytes += entry.package_name.capacity();
+  }
+  bytes += overlayable_infos_.capacity() * sizeof(overlayable_infos_[0]);
+  for (const auto& overlayable_info : overlayable_infos_) {
+    bytes += overlayable_info.second.size() * (sizeof(uint32_t) + kNodeOverhead);
+  }
+  bytes += alias_id_map_.capacity() * sizeof(alias_id_map_[0]);
+  for (const auto& [name, actor] : overlayable_map_) {
+    bytes += 2 * sizeof(std::string) + name.capacity() + actor.capacity() + kNodeOverhead;
+  }
+  return MemoryUsage{.heap_bytes = bytes};
+}
+
 std::unique_ptr<const LoadedPackage> LoadedPackage::Load(const Chunk& chunk,
                                                          package_property_t property_flags) {
   ATRACE_NAME("LoadedPackage::Load");
   const bool optimize_name_lookups = (property_flags & PROPERTY_OPTIMIZE_NAME_LOOKUPS) != 0;
   std::unique_ptr<LoadedPackage> loaded_package(new LoadedPackage(optimize_name_lookups));
+  if ((property_flags & PROPERTY_LAZY_TYPES) != 0) {
+    loaded_package->lazy_types_ = std::make_unique<LazyTypes>();
+  }
+  if (optimize_name_lookups) {
+    loaded_package->entry_name_index_ = std::make_unique<EntryNameIndex>();
+  }
 
   // typeIdOffset was added at some point, but we still must recognize apps built before this
   // was added.
@@ -599,14 +760,23 @@ std::unique_ptr<const LoadedPackage> LoadedPackage::Load(const Chunk& chunk,
           return {};
         }
 
-        if (!VerifyResTableType(type)) {
+        if (loaded_package->lazy_types_ == nullptr && !VerifyResTableType(type)) {
           return {};
         }
 
         // Type chunks must be preceded by their TypeSpec chunks.
         auto& maybe_type_builder = type_builder_map[type->id];
         if (maybe_type_builder) {
-          maybe_type_builder->AddType(type.verified());
+          if (loaded_package->lazy_types_ != nullptr) {
+            // Defer reading anything past the chunk header until the type is accessed.
+            auto& chunks = loaded_package->lazy_types_->chunks[type->id];
+            const size_t old_capacity = chunks.capacity();
+            chunks.push_back(type);
+            loaded_package->lazy_types_->heap_bytes.fetch_add(
+                (chunks.capacity() - old_capacity) * sizeof(chunks[0]), std::memory_order_relaxed);
+          } else {
+            maybe_type_builder->AddType(type.verified());
+          }
         } else {
           LOG(ERROR) << StringPrintf(
               "RES_TABLE_TYPE_TYPE with ID %02x found without preceding RES_TABLE_TYPE_SPEC_TYPE.",
@@ -100,18 +100,8 @@ inline bool isSpecialSpanish(uint32_t language_and_region) {
     return (language_and_region == US_SPANISH || language_and_region == MEXICAN_SPANISH);
 }
 
-int localeDataCompareRegions(
-        const char* left_region, const char* right_region,
-        const char* requested_language, const char* requested_script,
-        const char* requested_region) {
-
-    if (left_region[0] == right_region[0] && left_region[1] == right_region[1]) {
-        return 0;
-    }
-    uint32_t left = packLocale(requested_language, left_region);
-    uint32_t right = packLocale(requested_language, right_region);
-    const uint32_t request = packLocale(requested_language, requested_region);
-
+static int compareRegions(uint32_t left, uint32_t right, uint32_t request,
+                          const char* requested_script) {
     // If one and only one of the two locales is a special Spanish locale, we
     // replace it with es-419. We don't do the replacement if the other locale
     // is already es-419, or both locales are special Spanish locales (when
@@ -166,6 +156,46 @@ int localeDataCompareRegions(
     return (int64_t) right - (int64_t) left;
 }
 
+// Comparing regions walks the parent chains of the request, and resolving a resource for several
+// preferred locales compares the same few regions over and over. Remember the recent results of
+// each thread in a small direct-mapped cache.
+struct CompareRegionsCacheEntry {
+    uint32_t left;
+    uint32_t right;
+    uint32_t request;
+    uint32_t script;
+    int result;
+    bool valid;
+};
+
+static constexpr size_t COMPARE_REGIONS_CACHE_SIZE = 64;
+
+int localeDataCompareRegions(
+        const char* left_region, const char* right_region,
+        const char* requested_language, const char* requested_script,
+        const char* requested_region) {
+
+    if (left_region[0] == right_region[0] && left_region[1] == right_region[1]) {
+        return 0;
+    }
+    const uint32_t left = packLocale(requested_language, left_region);
+    const uint32_t right = packLocale(requested_language, right_region);
+    const uint32_t request = packLocale(requested_language, requested_region);
+    uint32_t script;
+    memcpy(&script, requested_script, sizeof(script));
+
+    thread_local std::array<CompareRegionsCacheEntry, COMPARE_REGIONS_CACHE_SIZE> cache{};
+    const uint32_t hash = (left * 31u + right) * 31u + request + script;
+    CompareRegionsCacheEntry& entry = cache[(hash ^ (hash >> 16)) % COMPARE_REGIONS_CACHE_SIZE];
+    if (entry.valid && entry.left == left && entry.right == right && entry.request == request &&
+            entry.script == script) {
+        return entry.result;
+    }
+    const int result = compareRegions(left, right, request, requested_script);
+    entry = {left, right, request, script, result, true};
+    return result;
+}
+
 void localeDataComputeScript(char out[4], const char* language, const char* region) {
     if (language[0] == '\0') {
         memset(out, '\0', SCRIPT_LENGTH);
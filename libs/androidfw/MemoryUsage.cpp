@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "androidfw/MemoryUsage.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "android-base/stringprintf.h"
+
+namespace android {
+
+std::string MemoryUsage::ToString() const {
+  return base::StringPrintf("heap %zu KiB, mapped %zu KiB (resident %zu KiB)", heap_bytes / 1024,
+                            mapped_bytes / 1024, resident_bytes / 1024);
+}
+
+size_t GetResidentBytes(const void* data, size_t size) {
+#if defined(__linux__)
+  if (data == nullptr || size == 0) {
+    return 0;
+  }
+  const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const uintptr_t start = reinterpret_cast<uintptr_t>(data) & ~(page_size - 1);
+  const uintptr_t end = reinterpret_cast<uintptr_t>(data) + size;
+  std::vector<unsigned char> pages((end - start + page_size - 1) / page_size);
+  if (mincore(reinterpret_cast<void*>(start), end - start, pages.data()) != 0) {
+    return 0;
+  }
+  size_t resident_pages = 0;
+  for (unsigned char page : pages) {
+    resident_pages += page & 1;
+  }
+  // The first and last pages may be shared with other data, count them as a whole anyway.
+  return std::min<size_t>(resident_pages * page_size, size);
+#else
+  (void)data;
+  (void)size;
+  return 0;
+#endif
+}
+
+}  // namespace android
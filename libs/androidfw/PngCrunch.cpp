@@ -106,8 +106,24 @@ static void ReadDataFromStream(png_structp png_ptr, png_bytep buffer, png_size_t
   }
 }
 
+// The output of WritePng, and how much it may grow to.
+struct PngWriteContext {
+  OutputStream* out;
+  size_t max_size;
+  size_t size = 0;
+  bool exceeded_max_size = false;
+};
+
 static void WriteDataToStream(png_structp png_ptr, png_bytep buffer, png_size_t len) {
-  OutputStream* out = (OutputStream*)png_get_io_ptr(png_ptr);
+  PngWriteContext* context = (PngWriteContext*)png_get_io_ptr(png_ptr);
+  OutputStream* out = context->out;
+
+  context->size += len;
+  if (context->max_size != 0 && context->size > context->max_size) {
+    // Not an error, so it isn't logged.
+    context->exceeded_max_size = true;
+    png_longjmp(png_ptr, 1);
+  }
 
   void* out_buffer;
   size_t out_len;
@@ -284,6 +300,9 @@ std::unique_ptr<Image> ReadPng(InputStream* in, IDiagnostics* diag) {
 // the same PNGs encoded as RGBA.
 constexpr static const size_t kPaletteOverheadConstant = 1024u * 10u;
 
+// The number of colors that a palette can hold.
+constexpr static const size_t kMaxPaletteSize = 256u;
+
 // Pick a color type by which to encode the image, based on which color type will take
 // the least amount of disk space.
 //
@@ -472,7 +491,7 @@ static void WriteNinePatch(png_structp write_ptr, png_infop write_info_ptr,
 }
 
 bool WritePng(const Image* image, const NinePatch* nine_patch, OutputStream* out,
-              const PngOptions& options, IDiagnostics* diag, bool verbose) {
+              const PngOptions& options, IDiagnostics* diag, bool verbose, bool* out_too_large) {
   // Create and initialize the write png_struct with the default error and
   // warning handlers.
   // The header version is also passed in to ensure that this was built against the same
@@ -494,9 +513,14 @@ bool WritePng(const Image* image, const NinePatch* nine_patch, OutputStream* out
   // Automatically release PNG resources at end of scope.
   PngWriteStructDeleter png_write_deleter(write_ptr, write_info_ptr);
 
+  PngWriteContext write_context{.out = out, .max_size = options.max_size};
+
   // libpng uses longjmp to jump to error handling routines.
   // setjmp will return true only if it was jumped to, aka, there was an error.
   if (setjmp(png_jmpbuf(write_ptr))) {
+    if (write_context.exceeded_max_size && out_too_large != nullptr) {
+      *out_too_large = true;
+    }
     return false;
   }
 
@@ -504,7 +528,7 @@ bool WritePng(const Image* image, const NinePatch* nine_patch, OutputStream* out
   png_set_error_fn(write_ptr, (png_voidp)&diag, LogError, LogWarning);
 
   // Set up the write functions which write to our custom data sources.
-  png_set_write_fn(write_ptr, (png_voidp)out, WriteDataToStream, nullptr);
+  png_set_write_fn(write_ptr, (png_voidp)&write_context, WriteDataToStream, nullptr);
 
   png_set_compression_level(write_ptr, options.compression_level);
 
@@ -513,12 +537,18 @@ bool WritePng(const Image* image, const NinePatch* nine_patch, OutputStream* out
   // 1. Every pixel has R == G == B (grayscale)
   // 2. Every pixel has A == 255 (opaque)
   // 3. There are no more than 256 distinct RGBA colors (palette).
+  // Once there are more colors than a palette can hold, the palettes stop growing: past that point
+  // only whether some pixel isn't opaque matters.
   std::unordered_map<uint32_t, int> color_palette;
   std::unordered_set<uint32_t> alpha_palette;
   bool needs_to_zero_rgb_channels_of_transparent_pixels = false;
   bool grayscale = true;
   int max_gray_deviation = 0;
 
+  // Runs of the same color are common, and are only looked up in the palettes once.
+  bool has_previous_color = false;
+  uint32_t previous_color = 0;
+
   for (int32_t y = 0; y < image->height; y++) {
     const uint8_t* row = image->rows[y];
     for (int32_t x = 0; x < image->width; x++) {
@@ -537,13 +567,23 @@ bool WritePng(const Image* image, const NinePatch* nine_patch, OutputStream* out
         red = green = blue = 0;
       }
 
-      // Insert the color into the color palette.
       const uint32_t color = red << 24 | green << 16 | blue << 8 | alpha;
-      color_palette[color] = -1;
+      if (has_previous_color && color == previous_color) {
+        continue;
+      }
+      has_previous_color = true;
+      previous_color = color;
 
-      // If the pixel has non-opaque alpha, insert it into the
-      // alpha palette.
-      if (alpha != 0xff) {
+      if (color_palette.size() <= kMaxPaletteSize) {
+        // Insert the color into the color palette.
+        color_palette[color] = -1;
+
+        // If the pixel has non-opaque alpha, insert it into the
+        // alpha palette.
+        if (alpha != 0xff) {
+          alpha_palette.insert(color);
+        }
+      } else if (alpha != 0xff && alpha_palette.empty()) {
         alpha_palette.insert(color);
       }
 
@@ -564,7 +604,9 @@ bool WritePng(const Image* image, const NinePatch* nine_patch, OutputStream* out
 
   if (verbose) {
     android::DiagMessage msg;
-    msg << " paletteSize=" << color_palette.size() << " alphaPaletteSize=" << alpha_palette.size()
+    msg << " paletteSize=" << (color_palette.size() > kMaxPaletteSize ? ">" : "")
+        << std::min(color_palette.size(), kMaxPaletteSize)
+        << " alphaPaletteSize=" << alpha_palette.size()
         << " maxGrayDeviation=" << max_gray_deviation
         << " grayScale=" << (grayscale ? "true" : "false");
     diag->Note(msg);
@@ -629,6 +671,8 @@ bool WritePng(const Image* image, const NinePatch* nine_patch, OutputStream* out
     // 1 byte/pixel.
     auto out_row = std::unique_ptr<png_byte[]>(new png_byte[image->width]);
 
+    uint32_t previous_color = 0;
+    int previous_idx = -1;
     for (int32_t y = 0; y < image->height; y++) {
       png_const_bytep in_row = image->rows[y];
       for (int32_t x = 0; x < image->width; x++) {
@@ -642,9 +686,12 @@ bool WritePng(const Image* image, const NinePatch* nine_patch, OutputStream* out
         }
 
         const uint32_t color = rr << 24 | gg << 16 | bb << 8 | aa;
-        const int idx = color_palette[color];
-        CHECK(idx != -1);
-        out_row[x] = static_cast<png_byte>(idx);
+        if (previous_idx == -1 || color != previous_color) {
+          previous_color = color;
+          previous_idx = color_palette[color];
+          CHECK(previous_idx != -1);
+        }
+        out_row[x] = static_cast<png_byte>(previous_idx);
       }
       png_write_row(write_ptr, out_row.get());
     }
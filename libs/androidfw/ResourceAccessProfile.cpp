@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "androidfw/ResourceAccessProfile.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "android-base/file.h"
+#include "android-base/logging.h"
+
+namespace android {
+
+namespace {
+
+// "RAPF"; bump kProfileVersion whenever the layout changes, stale profiles are then ignored.
+constexpr uint32_t kProfileMagic = 0x46504152u;
+constexpr uint32_t kProfileVersion = 1u;
+
+// The profile is a sequence of 32-bit words in host byte order, as it never leaves the device it
+// was recorded on. Strings are stored as their length followed by their bytes.
+void WriteU32(std::string& out, uint32_t value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void WriteString(std::string& out, std::string_view str) {
+  WriteU32(out, static_cast<uint32_t>(str.size()));
+  out.append(str);
+}
+
+class Reader {
+ public:
+  explicit Reader(std::string_view data) : data_(data) {
+  }
+
+  bool ReadU32(uint32_t* out) {
+    if (data_.size() < sizeof(*out)) {
+      return false;
+    }
+    memcpy(out, data_.data(), sizeof(*out));
+    data_.remove_prefix(sizeof(*out));
+    return true;
+  }
+
+  bool ReadString(std::string* out) {
+    uint32_t size;
+    if (!ReadU32(&size) || data_.size() < size) {
+      return false;
+    }
+    out->assign(data_.data(), size);
+    data_.remove_prefix(size);
+    return true;
+  }
+
+  bool AtEnd() const {
+    return data_.empty();
+  }
+
+ private:
+  std::string_view data_;
+};
+
+}  // namespace
+
+bool ResourceAccessProfile::Add(uint32_t resid, std::string_view apk_path,
+                                std::string_view file_path) {
+  if (accesses_.size() >= kMaxAccesses || !recorded_resids_.insert(resid).second) {
+    return false;
+  }
+  // There are only a handful of ApkAssets per app, a linear search is enough.
+  auto apk_it = std::find(apk_paths_.begin(), apk_paths_.end(), apk_path);
+  if (apk_it == apk_paths_.end()) {
+    apk_it = apk_paths_.emplace(apk_paths_.end(), apk_path);
+  }
+  accesses_.push_back(Access{.resid = resid,
+                             .apk_index = static_cast<uint32_t>(apk_it - apk_paths_.begin()),
+                             .file_path = std::string(file_path)});
+  return true;
+}
+
+std::string ResourceAccessProfile::Serialize() const {
+  std::string out;
+  WriteU32(out, kProfileMagic);
+  WriteU32(out, kProfileVersion);
+  WriteU32(out, static_cast<uint32_t>(apk_paths_.size()));
+  for (const auto& apk_path : apk_paths_) {
+    WriteString(out, apk_path);
+  }
+  WriteU32(out, static_cast<uint32_t>(accesses_.size()));
+  for (const auto& access : accesses_) {
+    WriteU32(out, access.resid);
+    WriteU32(out, access.apk_index);
+    WriteString(out, access.file_path);
+  }
+  return out;
+}
+
+std::optional<ResourceAccessProfile> ResourceAccessProfile::Deserialize(std::string_view data) {
+  Reader reader(data);
+  uint32_t magic;
+  uint32_t version;
+  if (!reader.ReadU32(&magic) || magic != kProfileMagic || !reader.ReadU32(&version) ||
+      version != kProfileVersion) {
+    return {};
+  }
+
+  ResourceAccessProfile profile;
+  uint32_t apk_count;
+  if (!reader.ReadU32(&apk_count)) {
+    return {};
+  }
+  for (uint32_t i = 0; i < apk_count; i++) {
+    if (!reader.ReadString(&profile.apk_paths_.emplace_back())) {
+      return {};
+    }
+  }
+
+  uint32_t access_count;
+  if (!reader.ReadU32(&access_count) || access_count > kMaxAccesses) {
+    return {};
+  }
+  profile.accesses_.reserve(access_count);
+  for (uint32_t i = 0; i < access_count; i++) {
+    Access& access = profile.accesses_.emplace_back();
+    if (!reader.ReadU32(&access.resid) || !reader.ReadU32(&access.apk_index) ||
+        access.apk_index >= apk_count || !reader.ReadString(&access.file_path) ||
+        !profile.recorded_resids_.insert(access.resid).second) {
+      return {};
+    }
+  }
+  if (!reader.AtEnd()) {
+    return {};
+  }
+  return profile;
+}
+
+bool ResourceAccessProfile::WriteToFile(const std::string& path) const {
+  if (!base::WriteStringToFile(Serialize(), path)) {
+    PLOG(ERROR) << "Failed to write resource access profile '" << path << "'";
+    return false;
+  }
+  return true;
+}
+
+std::optional<ResourceAccessProfile> ResourceAccessProfile::ReadFromFile(const std::string& path) {
+  std::string data;
+  if (!base::ReadFileToString(path, &data)) {
+    // No profile has been recorded yet.
+    return {};
+  }
+  auto profile = Deserialize(data);
+  if (!profile) {
+    LOG(WARNING) << "Ignoring invalid resource access profile '" << path << "'";
+  }
+  return profile;
+}
+
+}  // namespace android
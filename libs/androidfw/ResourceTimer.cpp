@@ -257,6 +257,10 @@ char const *ResourceTimer::toString(ResourceTimer::Counter counter) {
       return "GetResourceValue";
     case Counter::RetrieveAttributes:
       return "RetrieveAttributes";
+    case Counter::LoadApkAssets:
+      return "LoadApkAssets";
+    case Counter::LoadIdmap:
+      return "LoadIdmap";
   };
   return "Unknown";
 }
@@ -15,6 +15,7 @@
  */
 
 #define LOG_TAG "ResourceType"
+#define ATRACE_TAG ATRACE_TAG_RESOURCES
 //#define LOG_NDEBUG 0
 
 #include <ctype.h>
@@ -25,7 +26,9 @@
 #include <string.h>
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
@@ -44,6 +47,8 @@
 #include <utils/Log.h>
 #include <utils/String16.h>
 #include <utils/String8.h>
+#include <utils/Timers.h>
+#include <utils/Trace.h>
 #include <android-base/logging.h>
 #ifdef __ANDROID__
 #include <binder/TextOutput.h>
@@ -741,6 +746,12 @@ void ResStringPool::uninit()
       mIndexLookupCache->first.clear();
       mIndexLookupCache->second.clear();
     }
+    mIndexLookupCacheComplete = false;
+    mBloomFilter.clear();
+    mLookupStats = {};
+
+    static std::atomic<uint64_t> sNextSerial = 1;
+    mSerial = sNextSerial.fetch_add(1, std::memory_order_relaxed);
 }
 
 /**
@@ -1066,6 +1077,136 @@ base::expected<incfs::map_ptr<ResStringPool_span>, NullOrIOError> ResStringPool:
     return base::unexpected(std::nullopt);
 }
 
+// FNV-1a over the raw bytes of a string, shared by the bloom filter of UTF-8 and UTF-16 pools.
+static uint64_t hashStringBytes(const void* data, size_t size) {
+    const auto bytes = reinterpret_cast<const uint8_t*>(data);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+base::expected<std::monostate, IOError> ResStringPool::buildLookupIndexLocked() const
+{
+    ATRACE_NAME("ResStringPool::buildLookupIndex");
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    const bool utf8 = (mHeader->flags & ResStringPool_header::UTF8_FLAG) != 0;
+    // Walk the pool from the back and keep the first index seen for every string, so duplicates
+    // resolve to the same index as the linear search from the back does.
+    for (ssize_t i = mHeader->stringCount - 1; i >= 0; i--) {
+        if (utf8) {
+            const base::expected<StringPiece, NullOrIOError> s = string8At(i);
+            if (UNLIKELY(IsIOError(s))) {
+                return base::unexpected(GetIOError(s.error()));
+            }
+            if (s.has_value()) {
+                mIndexLookupCache->first.insert({*s, i});
+            }
+        } else {
+            const base::expected<StringPiece16, NullOrIOError> s = stringAt(i);
+            if (UNLIKELY(IsIOError(s))) {
+                return base::unexpected(GetIOError(s.error()));
+            }
+            if (s.has_value()) {
+                mIndexLookupCache->second.insert({*s, i});
+            }
+        }
+    }
+    mIndexLookupCacheComplete = true;
+    mLookupStats.indexedStrings = mHeader->stringCount;
+    mLookupStats.buildTimeNs = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    return {};
+}
+
+bool ResStringPool::bloomFilterMayContainLocked(const void* data, size_t size) const
+{
+    // Two bits per string out of eight bits of filter per string keep false positives at a few
+    // percent, for one byte of memory per string.
+    constexpr size_t kBitsPerString = 8;
+    if (mBloomFilter.empty()) {
+        ATRACE_NAME("ResStringPool::buildBloomFilter");
+        const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        size_t bitCount = 64;
+        while (bitCount < mHeader->stringCount * kBitsPerString) {
+            bitCount *= 2;
+        }
+        std::vector<uint64_t> filter(bitCount / 64);
+        const uint64_t mask = bitCount - 1;
+        const bool utf8 = (mHeader->flags & ResStringPool_header::UTF8_FLAG) != 0;
+        for (size_t i = 0; i < mHeader->stringCount; i++) {
+            uint64_t hash;
+            if (utf8) {
+                const base::expected<StringPiece, NullOrIOError> s = string8At(i);
+                if (UNLIKELY(IsIOError(s))) {
+                    // Let the linear search report the error.
+                    return true;
+                }
+                if (!s.has_value()) {
+                    continue;
+                }
+                hash = hashStringBytes(s->data(), s->size());
+            } else {
+                const base::expected<StringPiece16, NullOrIOError> s = stringAt(i);
+                if (UNLIKELY(IsIOError(s))) {
+                    return true;
+                }
+                if (!s.has_value()) {
+                    continue;
+                }
+                hash = hashStringBytes(s->data(), s->size() * sizeof(char16_t));
+            }
+            const uint64_t bit1 = hash & mask;
+            const uint64_t bit2 = (hash >> 32) & mask;
+            filter[bit1 / 64] |= 1ULL << (bit1 % 64);
+            filter[bit2 / 64] |= 1ULL << (bit2 % 64);
+        }
+        mBloomFilter = std::move(filter);
+        mLookupStats.indexedStrings = mHeader->stringCount;
+        mLookupStats.buildTimeNs = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    }
+
+    const uint64_t mask = mBloomFilter.size() * 64 - 1;
+    const uint64_t hash = hashStringBytes(data, size);
+    const uint64_t bit1 = hash & mask;
+    const uint64_t bit2 = (hash >> 32) & mask;
+    return (mBloomFilter[bit1 / 64] & (1ULL << (bit1 % 64))) != 0 &&
+           (mBloomFilter[bit2 / 64] & (1ULL << (bit2 % 64))) != 0;
+}
+
+ResStringPool::LookupStats ResStringPool::getLookupStats() const
+{
+    AutoMutex lock(mCachesLock);
+    return mLookupStats;
+}
+
+size_t ResStringPool::getHeapBytes() const
+{
+    size_t bytes = mOwnedData != NULL ? mSize : 0;
+    AutoMutex lock(mCachesLock);
+    if (mCache != NULL) {
+        const size_t N = mHeader->stringCount;
+        bytes += N * sizeof(char16_t*);
+        for (size_t i = 0; i < N; i++) {
+            if (mCache[i] != NULL) {
+                bytes += (strlen16(mCache[i]) + 1) * sizeof(char16_t);
+            }
+        }
+    }
+    if (mIndexLookupCache) {
+        // The string views point into the pool, so only the hash table nodes count.
+        const size_t nodeBytes = sizeof(void*) + sizeof(size_t);
+        bytes += mIndexLookupCache->first.size() *
+                (sizeof(std::pair<std::string_view, int>) + nodeBytes);
+        bytes += mIndexLookupCache->second.size() *
+                (sizeof(std::pair<std::u16string_view, int>) + nodeBytes);
+        bytes += (mIndexLookupCache->first.bucket_count() +
+                mIndexLookupCache->second.bucket_count()) * sizeof(void*);
+    }
+    bytes += mBloomFilter.capacity() * sizeof(uint64_t);
+    return bytes;
+}
+
 base::expected<size_t, NullOrIOError> ResStringPool::indexOfString(const char16_t* str,
                                                                    size_t strLen) const
 {
@@ -1126,13 +1267,25 @@ base::expected<size_t, NullOrIOError> ResStringPool::indexOfString(const char16_
             // block, start searching at the back.
             String8 str8(str, strLen);
             const size_t str8Len = str8.size();
-            std::optional<AutoMutex> cacheLock;
-            if (mIndexLookupCache) {
-              cacheLock.emplace(mCachesLock);
-              if (auto it = mIndexLookupCache->first.find(std::string_view(str8));
-                  it != mIndexLookupCache->first.end()) {
-                return it->second;
-              }
+            {
+                AutoMutex cacheLock(mCachesLock);
+                if (mIndexLookupCache) {
+                    if (!mIndexLookupCacheComplete) {
+                        if (auto result = buildLookupIndexLocked(); !result.has_value()) {
+                            return base::unexpected(result.error());
+                        }
+                    }
+                    mLookupStats.fastLookups++;
+                    if (auto it = mIndexLookupCache->first.find(std::string_view(str8));
+                        it != mIndexLookupCache->first.end()) {
+                        return it->second;
+                    }
+                    return base::unexpected(std::nullopt);
+                }
+                if (!bloomFilterMayContainLocked(str8.c_str(), str8Len)) {
+                    mLookupStats.fastLookups++;
+                    return base::unexpected(std::nullopt);
+                }
             }
 
             for (int i=mHeader->stringCount-1; i>=0; i--) {
@@ -1141,9 +1294,6 @@ base::expected<size_t, NullOrIOError> ResStringPool::indexOfString(const char16_
                     return base::unexpected(s.error());
                 }
                 if (s.has_value()) {
-                  if (mIndexLookupCache) {
-                    mIndexLookupCache->first.insert({*s, i});
-                  }
                     if (kDebugStringPoolNoisy) {
                         ALOGI("Looking at %s, i=%d\n", s->data(), i);
                     }
@@ -1196,13 +1346,25 @@ base::expected<size_t, NullOrIOError> ResStringPool::indexOfString(const char16_
             // most often this happens because we want to get IDs for style
             // span tags; since those always appear at the end of the string
             // block, start searching at the back.
-            std::optional<AutoMutex> cacheLock;
-            if (mIndexLookupCache) {
-              cacheLock.emplace(mCachesLock);
-              if (auto it = mIndexLookupCache->second.find({str, strLen});
-                  it != mIndexLookupCache->second.end()) {
-                return it->second;
-              }
+            {
+                AutoMutex cacheLock(mCachesLock);
+                if (mIndexLookupCache) {
+                    if (!mIndexLookupCacheComplete) {
+                        if (auto result = buildLookupIndexLocked(); !result.has_value()) {
+                            return base::unexpected(result.error());
+                        }
+                    }
+                    mLookupStats.fastLookups++;
+                    if (auto it = mIndexLookupCache->second.find({str, strLen});
+                        it != mIndexLookupCache->second.end()) {
+                        return it->second;
+                    }
+                    return base::unexpected(std::nullopt);
+                }
+                if (!bloomFilterMayContainLocked(str, strLen * sizeof(char16_t))) {
+                    mLookupStats.fastLookups++;
+                    return base::unexpected(std::nullopt);
+                }
             }
             for (int i=mHeader->stringCount-1; i>=0; i--) {
                 const base::expected<StringPiece16, NullOrIOError> s = stringAt(i);
@@ -1213,9 +1375,6 @@ base::expected<size_t, NullOrIOError> ResStringPool::indexOfString(const char16_
                   ALOGI("Looking16 at %s, i=%d\n", String8(s->data(), s->size()).c_str(), i);
                 }
                 if (s.has_value()) {
-                  if (mIndexLookupCache) {
-                    mIndexLookupCache->second.insert({*s, i});
-                  }
                   if (strLen == s->size() && strzcmp16(s->data(), s->size(), str, strLen) == 0) {
                     if (kDebugStringPoolNoisy) {
                       ALOGI("MATCH16!");
@@ -1501,6 +1660,9 @@ const char* ResXMLParser::getAttributeName8(size_t idx, size_t* outLen) const
 
 uint32_t ResXMLParser::getAttributeNameResID(size_t idx) const
 {
+    if (const uint32_t* resIds = indexedAttributeResIds()) {
+        return idx < getAttributeCount() ? resIds[idx] : 0;
+    }
     int32_t id = getAttributeNameID(idx);
     if (id >= 0 && (size_t)id < mTree.mNumResIds) {
         uint32_t resId = dtohl(mTree.mResIds[id]);
@@ -1582,6 +1744,18 @@ int32_t ResXMLParser::getAttributeData(size_t idx) const
 
 ssize_t ResXMLParser::getAttributeValue(size_t idx, Res_value* outValue) const
 {
+    if (indexedAttributeResIds() != NULL) {
+        if (idx >= getAttributeCount()) {
+            return BAD_TYPE;
+        }
+        const Res_value& value =
+                mTree.mIndexedValues[mTree.mIndexedElements[mIndexedElement].first + idx];
+        if (value.size == 0) {
+            return BAD_TYPE;
+        }
+        *outValue = value;
+        return sizeof(Res_value);
+    }
     if (mEventCode == START_TAG) {
         const ResXMLTree_attrExt* tag = (const ResXMLTree_attrExt*)mCurExt;
         if (idx < dtohs(tag->attributeCount)) {
@@ -1696,6 +1870,62 @@ ssize_t ResXMLParser::indexOfAttribute(const char16_t* ns, size_t nsLen,
     return NAME_NOT_FOUND;
 }
 
+const uint32_t* ResXMLParser::indexedAttributeResIds() const
+{
+    if (mEventCode != START_TAG || mTree.mIndexedElements.empty()) {
+        return nullptr;
+    }
+    if (mIndexedExt != mCurExt) {
+        const auto& elements = mTree.mIndexedElements;
+        auto it = std::lower_bound(elements.begin(), elements.end(), mCurExt,
+                [](const ResXMLTree::IndexedElement& element, const void* ext) {
+                    return std::less<const void*>()(element.ext, ext);
+                });
+        if (it == elements.end() || it->ext != mCurExt) {
+            return nullptr;
+        }
+        mIndexedExt = mCurExt;
+        mIndexedElement = it - elements.begin();
+    }
+    return mTree.mIndexedResIds.data() + mTree.mIndexedElements[mIndexedElement].first;
+}
+
+ssize_t ResXMLParser::indexOfAttributeResId(uint32_t resId) const
+{
+    const size_t N = getAttributeCount();
+    if (const uint32_t* resIds = indexedAttributeResIds()) {
+        const uint16_t* order = mTree.mIndexedOrder.data()
+                + mTree.mIndexedElements[mIndexedElement].first;
+        const uint16_t* it = std::lower_bound(order, order + N, resId,
+                [resIds](uint16_t idx, uint32_t id) { return resIds[idx] < id; });
+        return it != order + N && resIds[*it] == resId ? *it : NAME_NOT_FOUND;
+    }
+    for (size_t i = 0; i < N; i++) {
+        if (getAttributeNameResID(i) == resId) {
+            return i;
+        }
+    }
+    return NAME_NOT_FOUND;
+}
+
+const uint16_t* ResXMLParser::getAttributeResIdOrder() const
+{
+    if (indexedAttributeResIds() == NULL) {
+        return NULL;
+    }
+    return mTree.mIndexedOrder.data() + mTree.mIndexedElements[mIndexedElement].first;
+}
+
+size_t ResXMLParser::getAttributeResIdsAndTypes(uint32_t* outData, size_t outDataSize) const
+{
+    const size_t N = std::min(getAttributeCount(), outDataSize / 2);
+    for (size_t i = 0; i < N; i++) {
+        outData[i * 2] = getAttributeNameResID(i);
+        outData[i * 2 + 1] = static_cast<uint32_t>(getAttributeDataType(i));
+    }
+    return N;
+}
+
 ssize_t ResXMLParser::indexOfID() const
 {
     if (mEventCode == START_TAG) {
@@ -1846,7 +2076,7 @@ ResXMLTree::~ResXMLTree()
     uninit();
 }
 
-status_t ResXMLTree::setTo(const void* data, size_t size, bool copyData)
+status_t ResXMLTree::setTo(const void* data, size_t size, bool copyData, bool indexAttributes)
 {
     const ResChunk_header* chunk = nullptr;
     const ResChunk_header* lastChunk = nullptr;
@@ -1955,11 +2185,56 @@ done:
     if (mError) {
         uninit();
     } else {
+        if (indexAttributes) {
+            buildAttributeIndex();
+        }
         restart();
     }
     return mError;
 }
 
+void ResXMLTree::buildAttributeIndex()
+{
+    ATRACE_NAME("ResXMLTree::buildAttributeIndex");
+    std::vector<IndexedElement> elements;
+    std::vector<uint32_t> resIds;
+    std::vector<uint16_t> order;
+    std::vector<Res_value> values;
+
+    ResXMLParser parser(*this);
+    parser.restart();
+    event_code_t code;
+    while ((code = parser.next()) != END_DOCUMENT && code != BAD_DOCUMENT) {
+        if (code != START_TAG) {
+            continue;
+        }
+        const uint32_t first = static_cast<uint32_t>(resIds.size());
+        const size_t N = parser.getAttributeCount();
+        elements.push_back(IndexedElement{parser.mCurExt, first});
+        for (size_t i = 0; i < N; i++) {
+            resIds.push_back(parser.getAttributeNameResID(i));
+            order.push_back(static_cast<uint16_t>(i));
+            Res_value& value = values.emplace_back();
+            if (parser.getAttributeValue(i, &value) < 0) {
+                value.size = 0;
+            }
+        }
+        // Attributes with an ID are usually sorted already, so this is mostly a check.
+        std::stable_sort(order.begin() + first, order.end(), [&](uint16_t a, uint16_t b) {
+            return resIds[first + a] < resIds[first + b];
+        });
+    }
+    if (code == BAD_DOCUMENT) {
+        // Leave the errors to the parsers that walk the document, they report them as usual.
+        return;
+    }
+
+    mIndexedElements = std::move(elements);
+    mIndexedResIds = std::move(resIds);
+    mIndexedOrder = std::move(order);
+    mIndexedValues = std::move(values);
+}
+
 status_t ResXMLTree::getError() const
 {
     return mError;
@@ -1969,6 +2244,11 @@ void ResXMLTree::uninit()
 {
     mError = NO_INIT;
     mStrings.uninit();
+    mIndexedElements.clear();
+    mIndexedResIds.clear();
+    mIndexedOrder.clear();
+    mIndexedValues.clear();
+    mIndexedExt = nullptr;
     if (mOwnedData) {
         free(mOwnedData);
         mOwnedData = NULL;
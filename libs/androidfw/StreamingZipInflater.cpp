@@ -25,6 +25,8 @@
 #include <assert.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 
 /*
  * TEMP_FAILURE_RETRY is defined by some, but not all, versions of
@@ -58,9 +60,17 @@ StreamingZipInflater::StreamingZipInflater(int fd, off64_t compDataStart,
     mOutTotalSize = uncompSize;
     mInTotalSize = compSize;
 
-    mInBufSize = StreamingZipInflater::INPUT_CHUNK_SIZE;
+    // Large assets are read in larger chunks, to make fewer read calls.
+    mInBufSize = (compSize > StreamingZipInflater::LARGE_ASSET_SIZE)
+            ? StreamingZipInflater::LARGE_INPUT_CHUNK_SIZE
+            : StreamingZipInflater::INPUT_CHUNK_SIZE;
     mInBuf = new uint8_t[mInBufSize];
 
+#if defined(__linux__)
+    // Start reading the compressed data ahead of the decompression.
+    ::posix_fadvise(fd, compDataStart, compSize, POSIX_FADV_WILLNEED);
+#endif
+
     mOutBufSize = StreamingZipInflater::OUTPUT_CHUNK_SIZE;
     mOutBuf = new uint8_t[mOutBufSize];
 
@@ -151,57 +161,80 @@ ssize_t StreamingZipInflater::read(void* outBuf, size_t count) {
 
         // need more data?  time to decode some.
         if (toRead > 0) {
-            // if we don't have any data to decode, read some in.  If we're working
-            // from mmapped data this won't happen, because the clipping to total size
-            // will prevent reading off the end of the mapped input chunk.
-            if ((mInflateState.avail_in == 0) && (mDataMap == NULL)) {
-                int err = readNextChunk();
-                if (err < 0) {
-                    ALOGE("Unable to access asset data: %d", err);
-                    if (!mStreamNeedsInit) {
-                        ::inflateEnd(&mInflateState);
-                        initInflateState();
-                    }
+            // A request at least as large as the output buffer is inflated straight into
+            // the caller's buffer, rather than copied through mOutBuf.  This is what makes
+            // reading a whole large asset (e.g. for getBuffer()) run at inflate speed.
+            if (outBuf != NULL && toRead >= mOutBufSize) {
+                ssize_t decoded = inflateNext(dest, min_of(toRead, UINT_MAX));
+                if (decoded < 0) {
                     return -1;
                 }
+                mOutDeliverable = mOutLastDecoded = 0;
+                mOutCurPosition += decoded;
+                dest += decoded;
+                bytesRead += decoded;
+                toRead -= decoded;
+                continue;
             }
+
             // we know we've drained whatever is in the out buffer now, so just
             // start from scratch there, reading all the input we have at present.
-            mInflateState.next_out = (Bytef*) mOutBuf;
-            mInflateState.avail_out = mOutBufSize;
-
-            /*
-            ALOGV("Inflating to outbuf: avail_in=%u avail_out=%u next_in=%p next_out=%p",
-                    mInflateState.avail_in, mInflateState.avail_out,
-                    mInflateState.next_in, mInflateState.next_out);
-            */
-            int result = Z_OK;
-            if (mStreamNeedsInit) {
-                ALOGV("Initializing zlib to inflate");
-                result = inflateInit2(&mInflateState, -MAX_WBITS);
-                mStreamNeedsInit = false;
+            ssize_t decoded = inflateNext(mOutBuf, mOutBufSize);
+            if (decoded < 0) {
+                return -1;
             }
-            if (result == Z_OK) result = ::inflate(&mInflateState, Z_SYNC_FLUSH);
-            if (result < 0) {
-                // Whoops, inflation failed
-                ALOGE("Error inflating asset: %d", result);
+
+            // Note how much data we got, and off we go
+            mOutDeliverable = 0;
+            mOutLastDecoded = decoded;
+        }
+    }
+    return bytesRead;
+}
+
+ssize_t StreamingZipInflater::inflateNext(uint8_t* out, size_t outSize) {
+    // if we don't have any data to decode, read some in.  If we're working
+    // from mmapped data this won't happen, because the clipping to total size
+    // will prevent reading off the end of the mapped input chunk.
+    if ((mInflateState.avail_in == 0) && (mDataMap == NULL)) {
+        int err = readNextChunk();
+        if (err < 0) {
+            ALOGE("Unable to access asset data: %d", err);
+            if (!mStreamNeedsInit) {
                 ::inflateEnd(&mInflateState);
                 initInflateState();
-                return -1;
-            } else {
-                if (result == Z_STREAM_END) {
-                    // we know we have to have reached the target size here and will
-                    // not try to read any further, so just wind things up.
-                    ::inflateEnd(&mInflateState);
-                }
-
-                // Note how much data we got, and off we go
-                mOutDeliverable = 0;
-                mOutLastDecoded = mOutBufSize - mInflateState.avail_out;
             }
+            return -1;
         }
     }
-    return bytesRead;
+    mInflateState.next_out = (Bytef*) out;
+    mInflateState.avail_out = outSize;
+
+    /*
+    ALOGV("Inflating to outbuf: avail_in=%u avail_out=%u next_in=%p next_out=%p",
+            mInflateState.avail_in, mInflateState.avail_out,
+            mInflateState.next_in, mInflateState.next_out);
+    */
+    int result = Z_OK;
+    if (mStreamNeedsInit) {
+        ALOGV("Initializing zlib to inflate");
+        result = inflateInit2(&mInflateState, -MAX_WBITS);
+        mStreamNeedsInit = false;
+    }
+    if (result == Z_OK) result = ::inflate(&mInflateState, Z_SYNC_FLUSH);
+    if (result < 0) {
+        // Whoops, inflation failed
+        ALOGE("Error inflating asset: %d", result);
+        ::inflateEnd(&mInflateState);
+        initInflateState();
+        return -1;
+    }
+    if (result == Z_STREAM_END) {
+        // we know we have to have reached the target size here and will
+        // not try to read any further, so just wind things up.
+        ::inflateEnd(&mInflateState);
+    }
+    return outSize - mInflateState.avail_out;
 }
 
 int StreamingZipInflater::readNextChunk() {
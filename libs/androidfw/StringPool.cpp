@@ -20,6 +20,8 @@
 #include <concepts>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 #include "android-base/logging.h"
 #include "androidfw/BigBuffer.h"
@@ -432,15 +434,25 @@ bool StringPool::Flatten(BigBuffer* out, const StringPool& pool, bool utf8, IDia
   const size_t before_strings_index = out->size();
   header->stringsStart = before_strings_index - start_index;
 
+  // The pool keeps the strings that have the same value in different contexts apart, for instance
+  // the translations that are the same in several locales, but their data is only written once.
+  // The indices of the copies point at it.
+  std::unordered_map<std::string_view, uint32_t> string_offsets;
+  auto encode = [&](const std::string& value) {
+    auto [iter, inserted] = string_offsets.try_emplace(value, out->size() - before_strings_index);
+    *indices++ = iter->second;
+    if (inserted && !EncodeString(value, utf8, out, diag)) {
+      no_error = false;
+    }
+  };
+
   // Styles always come first.
   for (const std::unique_ptr<StyleEntry>& entry : pool.styles_) {
-    *indices++ = out->size() - before_strings_index;
-    no_error = EncodeString(entry->value, utf8, out, diag) && no_error;
+    encode(entry->value);
   }
 
   for (const std::unique_ptr<Entry>& entry : pool.strings_) {
-    *indices++ = out->size() - before_strings_index;
-    no_error = EncodeString(entry->value, utf8, out, diag) && no_error;
+    encode(entry->value);
   }
 
   out->Align4();
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "androidfw/ZipArchiveCache.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include <android-base/logging.h>
+#include <android-base/utf8.h>
+#include <ziparchive/zip_archive.h>
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+namespace android {
+namespace {
+
+// The identity of an archive file. A file that is rewritten in place gets a new size or
+// modification time, and one that is replaced gets a new inode, so neither is confused with the
+// archive that is already open.
+struct FileKey {
+  dev_t dev;
+  ino_t ino;
+  off64_t size;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+
+  bool operator<(const FileKey& other) const {
+    return std::tie(dev, ino, size, mtime_sec, mtime_nsec) <
+           std::tie(other.dev, other.ino, other.size, other.mtime_sec, other.mtime_nsec);
+  }
+};
+
+struct Cache {
+  std::mutex lock;
+  std::map<FileKey, std::weak_ptr<ZipArchive>> archives;
+  uint64_t archive_bytes = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+};
+
+Cache& GetCache() {
+  static auto* cache = new Cache();
+  return *cache;
+}
+
+bool GetFileKey(int fd, FileKey* out_key) {
+#ifdef _WIN32
+  // Windows does not report inode numbers, so files cannot be identified reliably.
+  (void)fd;
+  (void)out_key;
+  return false;
+#else
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  *out_key = {st.st_dev, st.st_ino, st.st_size, st.st_mtim.tv_sec, st.st_mtim.tv_nsec};
+  return true;
+#endif
+}
+
+ZipArchiveCache::Archive FindLocked(Cache& cache, const FileKey& key) {
+  auto it = cache.archives.find(key);
+  return it != cache.archives.end() ? it->second.lock() : nullptr;
+}
+
+// Returns the cached archive for `key`, or adds `handle`, which the caller opened from the file
+// with that key, to the cache. If another thread opened the same file in the meantime, `handle` is
+// closed and that thread's archive is returned instead.
+ZipArchiveCache::Archive Insert(const FileKey& key, ZipArchive* handle) {
+  auto& cache = GetCache();
+  std::lock_guard<std::mutex> guard(cache.lock);
+  if (auto existing = FindLocked(cache, key)) {
+    CloseArchive(handle);
+    return existing;
+  }
+  ZipArchiveCache::Archive archive(handle, [key](ZipArchive* a) {
+    auto& cache = GetCache();
+    {
+      std::lock_guard<std::mutex> guard(cache.lock);
+      cache.archive_bytes -= key.size;
+      // The file may have been opened again since the last reference went away.
+      if (auto it = cache.archives.find(key); it != cache.archives.end() && it->second.expired()) {
+        cache.archives.erase(it);
+      }
+    }
+    CloseArchive(a);
+  });
+  cache.archives[key] = archive;
+  cache.archive_bytes += key.size;
+  return archive;
+}
+
+// Looks up the archive of the file behind `fd`, counting the lookup in the stats.
+ZipArchiveCache::Archive Lookup(int fd, FileKey* out_key, bool* out_cacheable) {
+  *out_cacheable = GetFileKey(fd, out_key);
+  if (!*out_cacheable) {
+    return nullptr;
+  }
+  auto& cache = GetCache();
+  std::lock_guard<std::mutex> guard(cache.lock);
+  if (auto archive = FindLocked(cache, *out_key)) {
+    cache.hits++;
+    return archive;
+  }
+  cache.misses++;
+  return nullptr;
+}
+
+}  // namespace
+
+ZipArchiveCache::Archive ZipArchiveCache::Open(const char* path, int32_t* out_error) {
+  // Open the file first so that the key identifies the file that is actually parsed.
+  const int fd = ::android::base::utf8::open(path, O_RDONLY | O_BINARY | O_CLOEXEC, 0);
+  if (fd < 0) {
+    // Let libziparchive report the failure in its own terms.
+    ZipArchiveHandle handle;
+    *out_error = OpenArchive(path, &handle);
+    if (*out_error == 0) {
+      return Adopt(handle);
+    }
+    CloseArchive(handle);
+    return nullptr;
+  }
+  return OpenFd(fd, path, true /* assume_ownership */, out_error);
+}
+
+ZipArchiveCache::Archive ZipArchiveCache::OpenFd(int fd, const char* debug_name,
+                                                 bool assume_ownership, int32_t* out_error) {
+  *out_error = 0;
+  FileKey key;
+  bool cacheable;
+  if (auto archive = Lookup(fd, &key, &cacheable)) {
+    if (assume_ownership) {
+      close(fd);
+    }
+    return archive;
+  }
+
+  ZipArchiveHandle handle;
+  *out_error = OpenArchiveFd(fd, debug_name, &handle, assume_ownership);
+  if (*out_error != 0) {
+    CloseArchive(handle);
+    return nullptr;
+  }
+  return cacheable && assume_ownership ? Insert(key, handle) : Adopt(handle);
+}
+
+ZipArchiveCache::Archive ZipArchiveCache::Adopt(ZipArchive* handle) {
+  return Archive(handle, [](ZipArchive* a) { CloseArchive(a); });
+}
+
+ZipArchiveCache::Stats ZipArchiveCache::GetStats() {
+  auto& cache = GetCache();
+  std::lock_guard<std::mutex> guard(cache.lock);
+  Stats stats;
+  for (auto& [key, archive] : cache.archives) {
+    if (!archive.expired()) {
+      stats.archives++;
+    }
+  }
+  stats.archive_bytes = cache.archive_bytes;
+  stats.hits = cache.hits;
+  stats.misses = cache.misses;
+  return stats;
+}
+
+}  // namespace android
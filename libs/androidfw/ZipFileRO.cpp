@@ -61,7 +61,6 @@ private:
 };
 
 ZipFileRO::~ZipFileRO() {
-    CloseArchive(mHandle);
     if (mFileName != NULL) {
         free(mFileName);
     }
@@ -73,30 +72,29 @@ ZipFileRO::~ZipFileRO() {
  */
 /* static */ ZipFileRO* ZipFileRO::open(const char* zipFileName)
 {
-    ZipArchiveHandle handle;
-    const int32_t error = OpenArchive(zipFileName, &handle);
-    if (error) {
+    int32_t error;
+    ZipArchiveCache::Archive archive = ZipArchiveCache::Open(zipFileName, &error);
+    if (archive == nullptr) {
         ALOGW("Error opening archive %s: %s", zipFileName, ErrorCodeString(error));
-        CloseArchive(handle);
         return NULL;
     }
 
-    return new ZipFileRO(handle, strdup(zipFileName));
+    return new ZipFileRO(std::move(archive), strdup(zipFileName));
 }
 
 
 /* static */ ZipFileRO* ZipFileRO::openFd(int fd, const char* debugFileName,
         bool assume_ownership)
 {
-    ZipArchiveHandle handle;
-    const int32_t error = OpenArchiveFd(fd, debugFileName, &handle, assume_ownership);
-    if (error) {
+    int32_t error;
+    ZipArchiveCache::Archive archive =
+            ZipArchiveCache::OpenFd(fd, debugFileName, assume_ownership, &error);
+    if (archive == nullptr) {
         ALOGW("Error opening archive fd %d %s: %s", fd, debugFileName, ErrorCodeString(error));
-        CloseArchive(handle);
         return NULL;
     }
 
-    return new ZipFileRO(handle, strdup(debugFileName));
+    return new ZipFileRO(std::move(archive), strdup(debugFileName));
 }
 
 ZipEntryRO ZipFileRO::findEntryByName(const char* entryName) const
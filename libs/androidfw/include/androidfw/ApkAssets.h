@@ -19,8 +19,11 @@
 
 #include <utils/RefBase.h>
 
+#include <functional>
 #include <memory>
+#include <span>
 #include <string>
+#include <vector>
 
 #include "android-base/macros.h"
 #include "android-base/unique_fd.h"
@@ -28,6 +31,7 @@
 #include "androidfw/AssetsProvider.h"
 #include "androidfw/Idmap.h"
 #include "androidfw/LoadedArsc.h"
+#include "androidfw/MemoryUsage.h"
 #include "androidfw/misc.h"
 
 namespace android {
@@ -92,6 +96,18 @@ class ApkAssets : public RefBase {
   // data.
   static ApkAssetsPtr LoadOverlay(const std::string& idmap_path, package_property_t flags = 0U);
 
+  // A single independent load, e.g. a lambda calling one of the Load() functions above.
+  using Loader = std::function<ApkAssetsPtr()>;
+
+  // Runs `loaders` on a small pool of worker threads and returns their results in the same order,
+  // so the list can be passed straight to AssetManager2::SetApkAssets(). Failed loads are returned
+  // as null pointers. `max_threads` of 0 picks a default based on the number of CPU cores.
+  //
+  // Parsing resource tables and verifying idmaps of independent APKs doesn't share any state, so
+  // this mostly helps processes that load many overlays and shared libraries at once.
+  static std::vector<ApkAssetsPtr> LoadInParallel(std::span<const Loader> loaders,
+                                                  size_t max_threads = 0);
+
   // Path to the contents of the ApkAssets on disk. The path could represent an APk, a directory,
   // or some other file type.
   std::optional<std::string_view> GetPath() const;
@@ -126,6 +142,13 @@ class ApkAssets : public RefBase {
 
   UpToDate IsUpToDate() const;
 
+  // Returns the memory used by the resources table: the resources.arsc, either mapped or read into
+  // RAM, and the LoadedArsc parsed from it.
+  MemoryUsage GetTableMemoryUsage() const;
+
+  // Returns the memory used by the idmap of an overlay and the LoadedIdmap parsed from it.
+  MemoryUsage GetIdmapMemoryUsage() const;
+
   // DANGER!
   // This is a destructive method that rips the assets provider out of ApkAssets object.
   // It is only useful when one knows this assets object can't be used anymore, and they
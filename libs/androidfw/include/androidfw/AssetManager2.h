@@ -20,17 +20,25 @@
 #include <utils/RefBase.h>
 
 #include <array>
+#include <bitset>
+#include <chrono>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <set>
 #include <span>
 #include <unordered_map>
+#include <vector>
 
 #include "android-base/function_ref.h"
 #include "android-base/macros.h"
 #include "androidfw/ApkAssets.h"
 #include "androidfw/Asset.h"
 #include "androidfw/AssetManager.h"
+#include "androidfw/ConfigMatcher.h"
+#include "androidfw/FlatHashMap.h"
+#include "androidfw/MemoryUsage.h"
+#include "androidfw/ResourceAccessProfile.h"
 #include "androidfw/ResourceTypes.h"
 #include "androidfw/Util.h"
 
@@ -99,8 +107,9 @@ class AssetManager2 {
   using ApkAssetsList = std::span<const ApkAssetsPtr>;
 
   AssetManager2();
-  explicit AssetManager2(AssetManager2&& other) = default;
+  explicit AssetManager2(AssetManager2&& other);
   AssetManager2(ApkAssetsList apk_assets, const ResTable_config& configuration);
+  ~AssetManager2();
 
   struct ScopedOperation {
     DISALLOW_COPY_AND_ASSIGN(ScopedOperation);
@@ -122,6 +131,13 @@ class AssetManager2 {
   // new resource IDs.
   bool SetApkAssets(ApkAssetsList apk_assets, bool invalidate_caches = true);
   bool SetApkAssets(std::initializer_list<ApkAssetsPtr> apk_assets, bool invalidate_caches = true);
+
+  // Creates an AssetManager with the same ApkAssets, configurations and overlay constraints as this
+  // one, but with its own, empty caches. Another thread can read resources from the copy without
+  // synchronizing with this AssetManager; the copy doesn't follow later changes to this one.
+  //
+  // Returns nullptr if some of the ApkAssets have already been released.
+  std::unique_ptr<AssetManager2> Clone() const;
   // This one is an optimization - it skips all calculations for applying the currently set
   // configuration, expecting a configuration update later with a forced refresh.
   void PresetApkAssets(ApkAssetsList apk_assets);
@@ -167,6 +183,22 @@ class AssetManager2 {
 
   void SetOverlayConstraints(int32_t display_id, int32_t device_id);
 
+  // Enables or disables the resolution table. When enabled, the best entry selected for a resource
+  // ID under the current configurations is remembered in a dense table that is built lazily per
+  // type, so that repeated lookups of the same resource skip the search through every package,
+  // overlay and filtered configuration. A configuration change only drops the entries of types
+  // that vary with the changed axes, while changing the ApkAssets drops the whole table.
+  void SetResolutionTableEnabled(bool enabled);
+
+  // Enables or disables the process-wide cache of bags resolved purely from the system framework
+  // package, such as Theme.Material and its parents. Bags in this cache are immutable and shared by
+  // every AssetManager2 in the process that has the same framework ApkAssets and configurations.
+  // When enabled and populated in the zygote, forked app processes inherit the resolved framework
+  // styles instead of rebuilding them into per-instance dirty memory during startup.
+  //
+  // Only AssetManagers without enabled overlays on the framework package use the cache.
+  static void SetSharedBagCacheEnabled(bool enabled);
+
   // Returns all configurations for which there are resources defined, or an I/O error if reading
   // resource data failed.
   //
@@ -342,6 +374,9 @@ class AssetManager2 {
   // resource data failed.
   base::expected<uint32_t, NullOrIOError> GetResourceTypeSpecFlags(uint32_t resid) const;
 
+  // Returns the resource IDs of the style `resid` and of its parents.
+  //
+  // The returned pointer is only valid until the next call that retrieves a bag.
   base::expected<const std::vector<uint32_t>*, NullOrIOError> GetBagResIdStack(
       uint32_t resid) const;
 
@@ -355,6 +390,20 @@ class AssetManager2 {
   // resolved yet.
   std::string GetLastResourceResolution() const;
 
+  // Starts recording the resources retrieved with GetResource() for the next `duration`, e.g. from
+  // the start of the process until its first frame is drawn. Restarting discards the accesses that
+  // were recorded so far.
+  void StartAccessRecording(std::chrono::milliseconds duration);
+
+  // Stops recording and returns the accesses recorded since StartAccessRecording(), so that they
+  // can be persisted for the package and replayed on its next launch.
+  ResourceAccessProfile FinishAccessRecording();
+
+  // Reads ahead the files and resolves the values listed in `profile` for the current
+  // configurations, which leaves them in the caches of this AssetManager. Accesses to ApkAssets
+  // that are not loaded are skipped. Returns the number of values that were resolved.
+  size_t ReplayAccessProfile(const ResourceAccessProfile& profile) const;
+
   // Creates a new Theme from this AssetManager.
   std::unique_ptr<Theme> NewTheme();
 
@@ -363,6 +412,24 @@ class AssetManager2 {
 
   void DumpToLog() const;
 
+  // The native heap used by the caches of this AssetManager, in bytes.
+  struct CacheMemoryUsage {
+    size_t bags = 0;
+    size_t bag_resid_stacks = 0;
+    size_t resolved_values = 0;
+    size_t resolution_tables = 0;
+
+    size_t total() const {
+      return bags + bag_resid_stacks + resolved_values + resolution_tables;
+    }
+  };
+
+  CacheMemoryUsage GetCacheMemoryUsage() const;
+
+  // Returns a report of the memory used by the caches and by each of the ApkAssets, with the heap
+  // of every package and idmap, for dumpsys meminfo and DumpToLog().
+  std::string DumpMemoryUsage() const;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(AssetManager2);
 
@@ -380,7 +447,14 @@ class AssetManager2 {
       // A mutable AssetManager-specific list of configurations that match the AssetManager's
       // current configuration. This is used as an optimization to avoid checking every single
       // candidate configuration when looking up resources.
-      ByteBucketArray<FilteredConfigGroup> filtered_configs_;
+      //
+      // For packages with lazily parsed types this is filled in per type on the first lookup, so
+      // the types are only parsed when they are used.
+      mutable ByteBucketArray<FilteredConfigGroup> filtered_configs_;
+
+      // The type indices whose filtered configurations are up to date, for packages with lazily
+      // parsed types.
+      mutable std::bitset<std::numeric_limits<uint8_t>::max() + 1> filtered_types_;
   };
 
   // Represents a Runtime Resource Overlay that overlays resources in the logical package.
@@ -450,10 +524,22 @@ class AssetManager2 {
   // bitmask `diff`.
   void InvalidateCaches(uint32_t diff);
 
+  // The resolved entries of a single type, indexed by entry ID.
+  struct ResolvedTypeTable;
+
+  // Returns the resolution table slot for the entry, creating the table for its type if needed.
+  // Returns nullptr if the entry ID is out of the range of the type.
+  std::optional<FindEntryResult>* GetResolutionTableSlot(uint8_t package_idx, uint8_t type_idx,
+                                                          uint16_t entry_idx) const;
+
   // Triggers the re-construction of lists of types that match the set configuration.
   // This should always be called when mutating the AssetManager's configuration or ApkAssets set.
   void RebuildFilterList();
 
+  // Fills in the filtered configurations of `type_spec` at `type_idx` of `package`.
+  void FilterTypeConfigs(const ConfiguredPackage& package, const TypeSpec& type_spec,
+                         uint8_t type_idx) const;
+
   using AssetsSet = std::set<ApkAssetsPtr>;
 
   // Retrieves the APK paths of overlays that overlay non-system packages.
@@ -469,12 +555,38 @@ class AssetManager2 {
   base::expected<const ResolvedBag*, NullOrIOError> GetBag(
       uint32_t resid, std::vector<uint32_t>& child_resids) const;
 
+  // The framework bags shared by all AssetManagers with the same framework ApkAssets and
+  // configurations.
+  struct SharedBagBucket;
+
+  // Returns the process-wide bag bucket matching the framework package and configurations of this
+  // AssetManager, or nullptr if the framework bags of this AssetManager cannot be shared.
+  SharedBagBucket* GetSharedBagBucket() const;
+
+  // Looks up or creates the bucket for GetSharedBagBucket() and stores it in shared_bag_bucket_.
+  SharedBagBucket* ResolveSharedBagBucket() const;
+
+  // Stores the newly resolved `bag` in the shared bucket if all of its entries come from the
+  // framework, or in the per-instance cache otherwise. `resid_stack` is the chain of styles the
+  // bag was resolved from. Returns the cached bag.
+  const ResolvedBag* CacheBag(uint32_t resid, util::unique_cptr<ResolvedBag> bag,
+                              SharedBagBucket* shared_bucket,
+                              std::span<const uint32_t> resid_stack) const;
+
+  // Returns a hash of everything that the values of a theme depend on besides its styles: the
+  // ApkAssets and the identity of their files on disk, the package groups with their overlays, and
+  // the configurations. Theme snapshots are only valid for AssetManagers with the same fingerprint.
+  uint64_t GetThemeSnapshotFingerprint() const;
+
   // Finish an operation that was running with the current asset manager, and clean up the
   // promoted apk assets when the last operation ends.
   void FinishOperation() const;
 
   bool IsAnyOverlayConstraintSatisfied(const Idmap_constraints& constraints) const;
 
+  // Adds the retrieval of `value` to the access profile while recording is running.
+  void RecordAccess(const SelectedValue& value) const;
+
   // The ordered list of ApkAssets to search. These are not owned by the AssetManager, and must
   // have a longer lifetime.
   // The second pair element is the promoted version of the assets, that is held for the duration
@@ -498,19 +610,52 @@ class AssetManager2 {
   // may need to be purged.
   std::vector<ResTable_config> configurations_;
 
+  // The matchers for each of configurations_, used when filtering the configurations of types.
+  std::vector<ConfigMatcher> configuration_matchers_;
+
   int32_t display_id_;
   int32_t device_id_;
 
   // Cached set of bags. These are cached because they can inherit keys from parent bags,
   // which involves some calculation.
-  mutable std::unordered_map<uint32_t, util::unique_cptr<ResolvedBag>> cached_bags_;
+  mutable FlatHashMap<uint32_t, util::unique_cptr<ResolvedBag>> cached_bags_;
 
   // Cached set of bag resid stacks for each bag. These are cached because they might be requested
   // a number of times for each view during View inspection.
-  mutable std::unordered_map<uint32_t, std::vector<uint32_t>> cached_bag_resid_stacks_;
+  mutable FlatHashMap<uint32_t, std::vector<uint32_t>> cached_bag_resid_stacks_;
+
+  struct CachedResolvedValue {
+    SelectedValue value;
+
+    // The configuration axes that any of the entries in the chain of references that led to
+    // `value` vary with. The value stays valid for configuration changes outside of these.
+    uint32_t config_dependencies = 0U;
+  };
 
   // Cached set of resolved resource values.
-  mutable std::unordered_map<uint32_t, SelectedValue> cached_resolved_values_;
+  mutable FlatHashMap<uint32_t, CachedResolvedValue> cached_resolved_values_;
+
+  // Whether FindEntry() results for the current configurations are recorded in
+  // resolution_tables_.
+  bool resolution_table_enabled_ = false;
+
+  // Lazily built tables of resolved entries for the current configurations, indexed by
+  // (package group index << 8 | type index). Empty until the first lookup after a reset.
+  mutable std::vector<std::unique_ptr<ResolvedTypeTable>> resolution_tables_;
+
+  // The shared framework bag bucket for the current framework assets and configurations. It is
+  // looked up lazily by GetSharedBagBucket() and reset whenever the caches are invalidated.
+  mutable std::shared_ptr<SharedBagBucket> shared_bag_bucket_;
+  mutable bool shared_bag_bucket_resolved_ = false;
+
+  struct SharedCachedBag {
+    const ResolvedBag* bag;
+    const std::vector<uint32_t>* resid_stack;
+  };
+
+  // The bags of shared_bag_bucket_ that this AssetManager has already looked up, so that repeated
+  // lookups don't take the bucket lock. The pointers are owned by shared_bag_bucket_.
+  mutable FlatHashMap<uint32_t, SharedCachedBag> shared_cached_bags_;
 
   // Tracking the number of the started operations running with the current AssetManager.
   // Finishing the last one clears all promoted apk assets.
@@ -519,6 +664,11 @@ class AssetManager2 {
   // Whether or not to save resource resolution steps
   bool resource_resolution_logging_enabled_ = false;
 
+  // The accesses recorded since StartAccessRecording(). Recording stops when the deadline passes.
+  mutable bool access_recording_enabled_ = false;
+  mutable ResourceAccessProfile access_profile_;
+  std::chrono::steady_clock::time_point access_recording_deadline_;
+
   struct Resolution {
     struct Step {
       enum class Type {
@@ -594,6 +744,23 @@ class Theme {
   // Returns an I/O error if reading resource data failed.
   base::expected<std::monostate, IOError> SetTo(const Theme& source);
 
+  // Serializes the attributes of this theme into a snapshot: a pointer-free blob of the sorted
+  // attribute records that can be written to a file once and memory-mapped later.
+  //
+  // A snapshot is only valid for AssetManagers with the same ApkAssets, overlays and
+  // configurations as the AssetManager of this theme. A fingerprint of those is stored in the
+  // snapshot and verified when it is loaded. Callers are expected to key the stored snapshots by
+  // the styles that were applied, and to drop them when the ApkAssets are updated on disk.
+  std::vector<uint8_t> WriteSnapshot() const;
+
+  // Sets this theme to the attributes stored in `snapshot`, which was produced by WriteSnapshot().
+  // The data can come straight from a memory-mapped Asset opened through an AssetsProvider, so
+  // creating a theme doesn't need to apply all of the styles of its parent chain again.
+  //
+  // Returns false and leaves the theme unchanged if the snapshot is malformed, or was written for
+  // a different state of the AssetManager.
+  bool SetToSnapshot(std::span<const uint8_t> snapshot);
+
   void Clear();
 
   // Retrieves the value of attribute ID `resid` in the theme.
@@ -603,6 +770,19 @@ class Theme {
   // function.
   std::optional<AssetManager2::SelectedValue> GetAttribute(uint32_t resid) const;
 
+  // Returns the sorted resource IDs of the attributes defined in this theme.
+  //
+  // Callers looking up many sorted attributes at once can walk these IDs in a single merge pass and
+  // retrieve the matches with GetAttributeAt(), instead of searching for every attribute with
+  // GetAttribute(). The span is invalidated by any modification of the theme.
+  std::span<const uint32_t> GetAttributeIds() const {
+    return keys_;
+  }
+
+  // Retrieves the value of the attribute at `index` of GetAttributeIds(), following attribute
+  // references the same way as GetAttribute() does.
+  std::optional<AssetManager2::SelectedValue> GetAttributeAt(size_t index) const;
+
   // This is like AssetManager2::ResolveReference(), but also takes care of resolving attribute
   // references to the theme.
   base::expected<std::monostate, NullOrIOError> ResolveAttributeReference(
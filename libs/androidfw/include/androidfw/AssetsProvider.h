@@ -17,7 +17,10 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <vector>
 
 #include "android-base/function_ref.h"
 #include "android-base/macros.h"
@@ -26,6 +29,7 @@
 #include "androidfw/Asset.h"
 #include "androidfw/Idmap.h"
 #include "androidfw/LoadedArsc.h"
+#include "androidfw/ZipArchiveCache.h"
 #include "androidfw/misc.h"
 
 struct ZipArchive;
@@ -65,6 +69,13 @@ struct AssetsProvider {
   // Returns whether the interface provides the most recent version of its files.
   WARN_UNUSED virtual UpToDate IsUpToDate() const = 0;
 
+  // Hints that the files at `paths` are about to be opened, e.g. the layouts and drawables listed
+  // in a startup profile, so their data can be read ahead in the background. Paths that don't
+  // exist are ignored. Returns the number of files whose data was requested.
+  virtual size_t Prefetch(std::span<const std::string> /* paths */) const {
+    return 0;
+  }
+
   // Creates an Asset from a file on disk.
   static std::unique_ptr<Asset> CreateAssetFromFile(const std::string& path);
 
@@ -102,6 +113,7 @@ struct ZipAssetsProvider : public AssetsProvider {
   WARN_UNUSED const std::string& GetDebugName() const override;
   WARN_UNUSED UpToDate IsUpToDate() const override;
   WARN_UNUSED std::optional<uint32_t> GetCrc(std::string_view path) const;
+  size_t Prefetch(std::span<const std::string> paths) const override;
 
   ~ZipAssetsProvider() override = default;
  protected:
@@ -118,6 +130,8 @@ struct ZipAssetsProvider : public AssetsProvider {
   // ModTime is time_t on Win32, need to change the parameter order to make it overloadable.
   ZipAssetsProvider(ZipArchive* handle, PathOrDebugName&& path, ModDate last_mod_time,
                     package_property_t flags);
+  ZipAssetsProvider(ZipArchiveCache::Archive archive, PathOrDebugName&& path,
+                    ModDate last_mod_time, package_property_t flags);
 
   struct PathOrDebugName {
     static PathOrDebugName Path(std::string value) {
@@ -140,13 +154,20 @@ struct ZipAssetsProvider : public AssetsProvider {
     bool is_path_;
   };
 
-  struct ZipCloser {
-    void operator()(ZipArchive* a) const;
-  };
-  std::unique_ptr<ZipArchive, ZipCloser> zip_handle_;
+  // Builds assets_index_ on first use. Returns false if the APK could not be iterated.
+  bool IndexAssets() const;
+
+  // Shared with the other users of the same APK in the process.
+  ZipArchiveCache::Archive zip_handle_;
   PathOrDebugName name_;
   package_property_t flags_;
   ModDate last_mod_time_;
+
+  // The sorted names of the entries under assets/, so that listing a directory there only visits
+  // its own entries.
+  mutable std::once_flag assets_index_once_;
+  mutable std::vector<std::string> assets_index_;
+  mutable bool assets_index_valid_ = false;
 };
 
 // Supplies assets from a root directory.
@@ -184,6 +205,7 @@ struct MultiAssetsProvider : public AssetsProvider {
   WARN_UNUSED std::optional<std::string_view> GetPath() const override;
   WARN_UNUSED const std::string& GetDebugName() const override;
   WARN_UNUSED UpToDate IsUpToDate() const override;
+  size_t Prefetch(std::span<const std::string> paths) const override;
 
   ~MultiAssetsProvider() override = default;
  protected:
@@ -86,7 +86,6 @@ public:
 
 private:
     explicit BackupDataWriter();
-    status_t write_padding_for(int n);
     
     int m_fd;
     status_t m_status;
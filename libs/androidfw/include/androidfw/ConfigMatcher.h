@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "androidfw/ResourceTypes.h"
+
+namespace android {
+
+// The ResTable_config fields that ResTable_config::match() compares with plain equality or
+// ordering, unpacked into fixed 16-bit lanes. Fields inside of bit masks are stored already masked.
+struct PackedConfig {
+  // Lanes where a non-zero candidate value must be equal to the device value.
+  static constexpr size_t kExactLaneCount = 16;
+  // Lanes where the candidate value must not be larger than the device value.
+  static constexpr size_t kAtMostLaneCount = 8;
+
+  std::array<uint16_t, kExactLaneCount> exact{};
+  std::array<uint16_t, kAtMostLaneCount> at_most{};
+
+  static PackedConfig From(const ResTable_config& config) {
+    PackedConfig packed;
+    packed.exact = {
+        config.mcc,
+        config.mnc,
+        config.orientation,
+        config.touchscreen,
+        config.keyboard,
+        config.navigation,
+        static_cast<uint16_t>(config.inputFlags & ResTable_config::MASK_NAVHIDDEN),
+        config.grammaticalInflection,
+        static_cast<uint16_t>(config.screenLayout & ResTable_config::MASK_LAYOUTDIR),
+        static_cast<uint16_t>(config.screenLayout & ResTable_config::MASK_SCREENLONG),
+        static_cast<uint16_t>(config.uiMode & ResTable_config::MASK_UI_MODE_TYPE),
+        static_cast<uint16_t>(config.uiMode & ResTable_config::MASK_UI_MODE_NIGHT),
+        static_cast<uint16_t>(config.screenLayout2 & ResTable_config::MASK_SCREENROUND),
+        static_cast<uint16_t>(config.colorMode & ResTable_config::MASK_HDR),
+        static_cast<uint16_t>(config.colorMode & ResTable_config::MASK_WIDE_COLOR_GAMUT),
+        0,
+    };
+    packed.at_most = {
+        static_cast<uint16_t>(config.screenLayout & ResTable_config::MASK_SCREENSIZE),
+        config.smallestScreenWidthDp,
+        config.screenWidthDp,
+        config.screenHeightDp,
+        config.screenWidth,
+        config.screenHeight,
+        config.sdkVersion,
+        0,
+    };
+    return packed;
+  }
+};
+
+// A precomputed form of a device configuration that quickly rejects most candidate configurations
+// that ResTable_config::match() would reject, so that the full comparison only runs for the few
+// candidates that pass.
+//
+// The checks are written as fixed-length loops without branches, which compilers turn into a
+// couple of NEON or SSE vector compares; other targets get the equivalent scalar code. The locale,
+// the hidden keyboard state and the minor version have special matching rules and are left to
+// match().
+class ConfigMatcher {
+ public:
+  explicit ConfigMatcher(const ResTable_config& device_config)
+      : device_(PackedConfig::From(device_config)) {
+  }
+
+  // Returns false if `candidate` can't match the device configuration. Returns true if it may
+  // match, in which case ResTable_config::match() has the final word.
+  bool MayMatch(const PackedConfig& candidate) const {
+    uint16_t mismatch = 0;
+    for (size_t i = 0; i < PackedConfig::kExactLaneCount; i++) {
+      mismatch |= static_cast<uint16_t>((candidate.exact[i] != 0) &
+                                        (candidate.exact[i] != device_.exact[i]));
+    }
+    for (size_t i = 0; i < PackedConfig::kAtMostLaneCount; i++) {
+      mismatch |= static_cast<uint16_t>(candidate.at_most[i] > device_.at_most[i]);
+    }
+    return mismatch == 0;
+  }
+
+ private:
+  PackedConfig device_;
+};
+
+}  // namespace android
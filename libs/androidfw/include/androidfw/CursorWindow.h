@@ -20,6 +20,7 @@
 #include <inttypes.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <memory>
 #include <string>
 
 #include "android-base/mapped_file.h"
@@ -49,7 +50,8 @@ namespace android {
  *                                                             mSize -+     |
  *                                                           mInflatedSize -+
  *
- * Strings are stored in UTF-8.
+ * Strings are stored in UTF-8. Short strings that repeat are only stored once, and all the
+ * fields with the same value point to the same heap allocation.
  */
 class CursorWindow {
     CursorWindow();
@@ -83,6 +85,18 @@ public:
     ~CursorWindow();
 
     static status_t create(const String8& name, size_t size, CursorWindow** outCursorWindow);
+
+    /* Counters of the process-wide pool of ashmem regions that inflated windows reuse. */
+    struct PoolStats {
+        /* The number of inflations that reused a pooled region. */
+        uint64_t hits;
+        /* The number of inflations that had to create a new region. */
+        uint64_t misses;
+        /* The total size of the regions currently in the pool. */
+        size_t pooledBytes;
+    };
+
+    static PoolStats getPoolStats();
 #ifdef __linux__
     static status_t createFromParcel(Parcel* parcel, CursorWindow** outCursorWindow);
 
@@ -144,6 +158,24 @@ public:
         return offsetToPtr(fieldSlot->data.buffer.offset, fieldSlot->data.buffer.size);
     }
 
+    /**
+     * Reads the values of a column for the rows [startRow, startRow + numRows) into outValues,
+     * converted like Cursor.getLong() does: floats are truncated, strings are parsed and nulls
+     * read as 0. This walks the field slots directly, so a whole column range costs one call
+     * instead of one per field.
+     *
+     * Returns BAD_VALUE if the range is not in the window, or BAD_TYPE if one of the fields is a
+     * blob; outValues is then only partially filled.
+     */
+    status_t getColumnLongs(uint32_t column, uint32_t startRow, uint32_t numRows,
+            int64_t* outValues);
+
+    /**
+     * Like getColumnLongs(), with the conversions of Cursor.getDouble().
+     */
+    status_t getColumnDoubles(uint32_t column, uint32_t startRow, uint32_t numRows,
+            double* outValues);
+
     inline std::string toString() const {
         return android::base::StringPrintf("CursorWindow{name=%s, fd=%d, size=%d, inflatedSize=%d, "
                 "allocOffset=%d, slotsOffset=%d, numRows=%d, numColumns=%d}", mName.c_str(),
@@ -185,6 +217,29 @@ private:
     uint32_t mNumRows = 0;
     uint32_t mNumColumns = 0;
     bool mReadOnly = false;
+    /**
+     * Whether the ashmem region was sent to another process, which may still have it mapped.
+     * Such regions can't be reused for other windows.
+     */
+    bool mShared = false;
+    /**
+     * The extent of the allocations made before the last clear(), which must be wiped before
+     * the ashmem region is reused.
+     */
+    uint32_t mDirtyAllocOffset = 0;
+    uint32_t mDirtySlotsOffset = 0;
+
+    /**
+     * A direct-mapped cache of the short strings stored in the heap, indexed by their hash, used
+     * to store repeating values only once. Allocated with the first string put into the window
+     * and forgotten on clear().
+     */
+    struct StringDictionaryEntry {
+        uint32_t hash;
+        uint32_t offset;
+        uint32_t size;
+    };
+    std::unique_ptr<StringDictionaryEntry[]> mStringDictionary;
 
     void updateSlotsData();
 
@@ -204,6 +259,13 @@ private:
 
     status_t putBlobOrString(uint32_t row, uint32_t column,
             const void* value, size_t size, int32_t type);
+
+    /**
+     * Calls convert(fieldSlot, &outValues[i]) for the field of each row in the column range.
+     */
+    template <typename T, typename Convert>
+    status_t getColumnRange(uint32_t column, uint32_t startRow, uint32_t numRows,
+            T* outValues, Convert convert);
 };
 
 }; // namespace android
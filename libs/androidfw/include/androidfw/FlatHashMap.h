@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace android {
+
+// A hash map from integer keys to values that stores all items in a single flat array and resolves
+// collisions with linear probing - basically a minimal open-addressing hash map.
+//
+// The resource caches are keyed by dense 32-bit resource IDs and are queried a lot during view
+// inflation. Compared to std::unordered_map, this map does no allocation per item, and a lookup
+// usually touches a single cache line instead of following a chain of nodes.
+//
+// Beware of the iterator and pointer stability - the array can be reallocated at any insertion, so
+// insertions invalidate all iterators and pointers, and erasures invalidate iterators and pointers
+// to the items that follow the erased one. Keys must not be modified through the iterators.
+template <std::integral K, class V>
+class FlatHashMap {
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<K, V>;
+  using size_type = size_t;
+
+ private:
+  struct Slot {
+    value_type item{};
+    bool used = false;
+  };
+
+  template <class SlotT, class ValueT>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = ValueT;
+    using difference_type = std::ptrdiff_t;
+    using pointer = ValueT*;
+    using reference = ValueT&;
+
+    Iterator() = default;
+
+    // Allows passing iterators where const iterators are expected.
+    template <class OtherSlotT, class OtherValueT>
+      requires(std::is_const_v<SlotT> && !std::is_const_v<OtherSlotT>)
+    Iterator(const Iterator<OtherSlotT, OtherValueT>& other)
+        : slot_(other.slot_), end_(other.end_) {
+    }
+
+    reference operator*() const {
+      return slot_->item;
+    }
+    pointer operator->() const {
+      return &slot_->item;
+    }
+
+    Iterator& operator++() {
+      ++slot_;
+      SkipUnused();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return slot_ == other.slot_;
+    }
+
+   private:
+    friend class FlatHashMap;
+    template <class, class>
+    friend class Iterator;
+
+    Iterator(SlotT* slot, SlotT* end) : slot_(slot), end_(end) {
+    }
+
+    void SkipUnused() {
+      while (slot_ != end_ && !slot_->used) {
+        ++slot_;
+      }
+    }
+
+    SlotT* slot_ = nullptr;
+    SlotT* end_ = nullptr;
+  };
+
+ public:
+  using iterator = Iterator<Slot, value_type>;
+  using const_iterator = Iterator<const Slot, const value_type>;
+
+  FlatHashMap() = default;
+
+  explicit FlatHashMap(size_t reserve_size) {
+    reserve(reserve_size);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  // The number of slots allocated. The map grows once size() reaches 3/4 of this.
+  size_t capacity() const {
+    return slots_.size();
+  }
+
+  iterator begin() {
+    return MakeIterator(0);
+  }
+  iterator end() {
+    return iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size());
+  }
+  const_iterator begin() const {
+    return MakeIterator(0);
+  }
+  const_iterator end() const {
+    return const_iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size());
+  }
+
+  iterator find(K key) {
+    const size_t index = FindIndex(key);
+    return index == kNotFound ? end() : MakeIterator(index);
+  }
+  const_iterator find(K key) const {
+    const size_t index = FindIndex(key);
+    return index == kNotFound ? end() : MakeIterator(index);
+  }
+
+  bool contains(K key) const {
+    return FindIndex(key) != kNotFound;
+  }
+
+  // Inserts a value constructed from `args` if `key` is not in the map yet.
+  template <class... Args>
+  std::pair<iterator, bool> try_emplace(K key, Args&&... args) {
+    if (const size_t index = FindIndex(key); index != kNotFound) {
+      return {MakeIterator(index), false};
+    }
+    if ((size_ + 1) * 4 > slots_.size() * 3) {
+      Rehash(slots_.empty() ? kMinCapacity : slots_.size() * 2);
+    }
+    const size_t index = InsertNew(key);
+    slots_[index].item.second = V(std::forward<Args>(args)...);
+    return {MakeIterator(index), true};
+  }
+
+  template <class... Args>
+  std::pair<iterator, bool> emplace(K key, Args&&... args) {
+    return try_emplace(key, std::forward<Args>(args)...);
+  }
+
+  V& operator[](K key) {
+    return try_emplace(key).first->second;
+  }
+
+  // Erases the item at `it` using backward shift deletion, so the map never accumulates
+  // tombstones that would slow down lookups.
+  void erase(const_iterator it) {
+    size_t hole = it.slot_ - slots_.data();
+    const size_t mask = slots_.size() - 1;
+    for (size_t next = (hole + 1) & mask; slots_[next].used; next = (next + 1) & mask) {
+      // An item may only move back into the hole if that doesn't put it before its home slot.
+      const size_t home = HomeIndex(slots_[next].item.first);
+      if (((next - home) & mask) >= ((next - hole) & mask)) {
+        slots_[hole].item = std::move(slots_[next].item);
+        hole = next;
+      }
+    }
+    slots_[hole] = Slot{};
+    --size_;
+  }
+
+  size_t erase(K key) {
+    const size_t index = FindIndex(key);
+    if (index == kNotFound) {
+      return 0;
+    }
+    erase(MakeIterator(index));
+    return 1;
+  }
+
+  // Erases all items for which `pred(item)` returns true. Returns the number of erased items.
+  template <class Pred>
+  size_t erase_if(Pred pred) {
+    const size_t old_size = size_;
+    for (size_t i = 0; i < slots_.size();) {
+      // Erasing may shift a following item into this slot, so only advance past kept items. Items
+      // that wrap around from the front of the array may be checked twice, which is harmless.
+      if (slots_[i].used && pred(std::as_const(slots_[i].item))) {
+        erase(MakeIterator(i));
+      } else {
+        ++i;
+      }
+    }
+    return old_size - size_;
+  }
+
+  // Removes all items but keeps the allocated slots for reuse.
+  void clear() {
+    if (size_ == 0) {
+      return;
+    }
+    for (Slot& slot : slots_) {
+      if (slot.used) {
+        slot = Slot{};
+      }
+    }
+    size_ = 0;
+  }
+
+  void reserve(size_t count) {
+    size_t capacity = kMinCapacity;
+    while (capacity * 3 < count * 4) {
+      capacity *= 2;
+    }
+    if (capacity > slots_.size()) {
+      Rehash(capacity);
+    }
+  }
+
+ private:
+  static constexpr size_t kMinCapacity = 16;
+  static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+  size_t HomeIndex(K key) const {
+    // Fibonacci hashing spreads the dense, sequential resource IDs evenly over the slots while
+    // still keeping neighbouring IDs mostly apart from each other's probe sequences.
+    const uint64_t hash = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(hash >> 32) & (slots_.size() - 1);
+  }
+
+  size_t FindIndex(K key) const {
+    if (size_ == 0) {
+      return kNotFound;
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = HomeIndex(key); slots_[i].used; i = (i + 1) & mask) {
+      if (slots_[i].item.first == key) {
+        return i;
+      }
+    }
+    return kNotFound;
+  }
+
+  // Marks the first free slot in the probe sequence of `key` as used and returns its index.
+  size_t InsertNew(K key) {
+    const size_t mask = slots_.size() - 1;
+    size_t i = HomeIndex(key);
+    while (slots_[i].used) {
+      i = (i + 1) & mask;
+    }
+    slots_[i].used = true;
+    slots_[i].item.first = key;
+    ++size_;
+    return i;
+  }
+
+  void Rehash(size_t capacity) {
+    std::vector<Slot> old_slots(capacity);
+    old_slots.swap(slots_);
+    size_ = 0;
+    for (Slot& slot : old_slots) {
+      if (slot.used) {
+        slots_[InsertNew(slot.item.first)].item.second = std::move(slot.item.second);
+      }
+    }
+  }
+
+  iterator MakeIterator(size_t index) {
+    iterator it(slots_.data() + index, slots_.data() + slots_.size());
+    it.SkipUnused();
+    return it;
+  }
+  const_iterator MakeIterator(size_t index) const {
+    const_iterator it(slots_.data() + index, slots_.data() + slots_.size());
+    it.SkipUnused();
+    return it;
+  }
+
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+};
+
+}  // namespace android
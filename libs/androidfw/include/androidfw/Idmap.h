@@ -20,10 +20,12 @@
 #include <string>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 
 #include "android-base/macros.h"
 #include "android-base/unique_fd.h"
 #include "androidfw/ConfigDescription.h"
+#include "androidfw/MemoryUsage.h"
 #include "androidfw/ResourceTypes.h"
 #include "androidfw/StringPiece.h"
 #include "androidfw/misc.h"
@@ -133,6 +135,21 @@ class OverlayDynamicRefTable : public DynamicRefTable {
   friend IdmapResMap;
 };
 
+// The target entries of an idmap that overlay the resources of one target type. When the overlaid
+// entries of the type are close together, a slot per entry id between the first and the last one
+// finds them without searching the target entries and then the inline ones.
+struct IdmapTypeIndex {
+  // A slot is the index of the target entry of the resource, or of its inline target entry with
+  // kInlineSlot set, or kEmptySlot if the resource isn't overlaid.
+  static constexpr uint32_t kInlineSlot = 0x80000000U;
+  static constexpr uint32_t kEmptySlot = 0xFFFFFFFFU;
+
+  // Whether slots covers all the overlaid entries of the type, otherwise they are searched.
+  bool dense = false;
+  uint16_t first_entry = 0;
+  std::vector<uint32_t> slots;
+};
+
 // A mapping of target resource ids to a values or resource ids that should overlay the target.
 class IdmapResMap {
  public:
@@ -190,7 +207,12 @@ class IdmapResMap {
                        Idmap_target_entries entries, Idmap_target_inline_entries inline_entries,
                        const Idmap_target_entry_inline_value* inline_entry_values,
                        const ConfigDescription* configs, uint8_t target_assigned_package_id,
-                       const OverlayDynamicRefTable* overlay_ref_table);
+                       const OverlayDynamicRefTable* overlay_ref_table,
+                       const std::vector<IdmapTypeIndex>* type_indexes);
+
+  // The results for the target entry and the inline target entry at the index.
+  Result TargetEntryResult(size_t index) const;
+  Result InlineEntryResult(size_t index) const;
 
   const Idmap_data_header* data_header_;
   Idmap_constraints constraints_;
@@ -200,6 +222,8 @@ class IdmapResMap {
   const ConfigDescription* configurations_;
   const uint8_t target_assigned_package_id_;
   const OverlayDynamicRefTable* overlay_ref_table_;
+  // Indexed by target type id, or null if the idmap has no target entries.
+  const std::vector<IdmapTypeIndex>* type_indexes_;
 
   friend LoadedIdmap;
 };
@@ -229,7 +253,7 @@ class LoadedIdmap {
                                     const OverlayDynamicRefTable* overlay_ref_table) const {
     return IdmapResMap(data_header_, constraints_, target_entries_, target_inline_entries_,
                        inline_entry_values_, configurations_, target_assigned_package_id,
-                       overlay_ref_table);
+                       overlay_ref_table, type_indexes_.empty() ? nullptr : &type_indexes_);
   }
 
   // Returns a dynamic reference table for a loaded overlay package.
@@ -245,6 +269,16 @@ class LoadedIdmap {
     return constraints_;
   }
 
+  // Returns the native heap used by the idmap. The idmap data itself belongs to the ApkAssets.
+  MemoryUsage GetMemoryUsage() const {
+    size_t heap_bytes = sizeof(*this) + (string_pool_ ? string_pool_->getHeapBytes() : 0) +
+                        type_indexes_.capacity() * sizeof(IdmapTypeIndex);
+    for (const IdmapTypeIndex& type_index : type_indexes_) {
+      heap_bytes += type_index.slots.capacity() * sizeof(uint32_t);
+    }
+    return MemoryUsage{.heap_bytes = heap_bytes};
+  }
+
  protected:
   // Exposed as protected so that tests can subclass and mock this class out.
   LoadedIdmap() = default;
@@ -258,6 +292,8 @@ class LoadedIdmap {
   const ConfigDescription* configurations_;
   const Idmap_overlay_entries overlay_entries_;
   const std::unique_ptr<ResStringPool> string_pool_;
+  // Indexed by target type id, up to the last type with target entries.
+  std::vector<IdmapTypeIndex> type_indexes_;
 
   android::base::unique_fd idmap_fd_;
   std::string_view overlay_apk_path_;
@@ -276,6 +312,8 @@ class LoadedIdmap {
                        std::unique_ptr<ResStringPool>&& string_pool,
                        std::string_view overlay_apk_path, std::string_view target_apk_path);
 
+  void BuildTypeIndexes();
+
   friend OverlayStringPool;
 };
 
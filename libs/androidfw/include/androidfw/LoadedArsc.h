@@ -30,7 +30,10 @@
 
 #include "androidfw/ByteBucketArray.h"
 #include "androidfw/Chunk.h"
+#include "androidfw/ConfigMatcher.h"
+#include "androidfw/FlatHashMap.h"
 #include "androidfw/Idmap.h"
+#include "androidfw/MemoryUsage.h"
 #include "androidfw/ResourceTypes.h"
 #include "androidfw/sorted_vector_set.h"
 #include "androidfw/Util.h"
@@ -56,6 +59,9 @@ struct TypeSpec {
     // Type configurations are accessed frequently when setting up an AssetManager and querying
     // resources. Access this cached configuration to minimize page faults.
     ResTable_config config;
+
+    // The configuration in the form that ConfigMatcher uses to reject candidates quickly.
+    PackedConfig packed_config;
   };
 
   // Pointer to the mmapped data where flags are kept. Flags denote whether the resource entry is
@@ -104,6 +110,12 @@ enum : package_property_t {
 
   // Optimize the resource lookups by name via an in-memory lookup table.
   PROPERTY_OPTIMIZE_NAME_LOOKUPS = 1U << 6U,
+
+  // Only record the locations of the RES_TABLE_TYPE_TYPE chunks when loading the package, and
+  // verify them and read their configurations the first time the type is accessed. This makes
+  // loading cost proportional to the types that are actually used instead of the table size.
+  // A corrupt type chunk then leaves its type empty instead of failing the load.
+  PROPERTY_LAZY_TYPES = 1U << 7U,
 };
 
 struct OverlayableInfo {
@@ -163,6 +175,8 @@ class LoadedPackage {
     return iterator(this, resource_ids_.size() + 1, 0);
   }
 
+  ~LoadedPackage();
+
   static std::unique_ptr<const LoadedPackage> Load(const Chunk& chunk,
                                                    package_property_t property_flags);
 
@@ -171,6 +185,8 @@ class LoadedPackage {
   // the default policy in AAPT2 is to build UTF-8 string pools, this needs to change.
   // Returns a partial resource ID, with the package ID left as 0x00. The caller is responsible
   // for patching the correct package ID to the resource ID.
+  // With PROPERTY_OPTIMIZE_NAME_LOOKUPS, the first lookup in a type indexes the keys of all of its
+  // entries, and the later ones don't scan the type chunks anymore.
   base::expected<uint32_t, NullOrIOError> FindEntryByName(const std::u16string& type_name,
                                                           const std::u16string& entry_name) const;
 
@@ -251,12 +267,31 @@ class LoadedPackage {
     if (type_spec == type_specs_.end()) {
       return nullptr;
     }
+    if (lazy_types_ != nullptr) {
+      ParseLazyType(type_spec->first);
+    }
     return &type_spec->second;
   }
 
+  // Returns true if the types of this package are parsed on first access.
+  bool HasLazyTypes() const {
+    return lazy_types_ != nullptr;
+  }
+
+  // The number of types in the package, and the number of slots allocated for them.
+  size_t GetTypeSpecCount() const {
+    return type_specs_.size();
+  }
+  size_t GetTypeSpecCapacity() const {
+    return type_specs_.capacity();
+  }
+
   template <typename Func>
   void ForEachTypeSpec(Func f) const {
     for (const auto& type_spec : type_specs_) {
+      if (lazy_types_ != nullptr) {
+        ParseLazyType(type_spec.first);
+      }
       f(type_spec.second, type_spec.first);
     }
   }
@@ -288,6 +323,9 @@ class LoadedPackage {
     return alias_id_map_;
   }
 
+  // Returns the native heap used by the package. Its chunks are mapped as part of the table.
+  MemoryUsage GetMemoryUsage() const;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(LoadedPackage);
 
@@ -295,6 +333,17 @@ class LoadedPackage {
       : type_string_pool_(optimize_name_lookups), key_string_pool_(optimize_name_lookups) {
   }
 
+  // The type chunks that have not been parsed yet, see PROPERTY_LAZY_TYPES.
+  struct LazyTypes;
+
+  // The entry index of each key of the types searched by FindEntryByName(), see
+  // PROPERTY_OPTIMIZE_NAME_LOOKUPS.
+  struct EntryNameIndex;
+
+  // Verifies the recorded type chunks of `type_id` and fills in the type entries of its TypeSpec,
+  // if that has not happened yet. This is thread-safe, as packages are shared between threads.
+  void ParseLazyType(uint8_t type_id) const;
+
   ResStringPool type_string_pool_;
   ResStringPool key_string_pool_;
   std::string package_name_;
@@ -303,7 +352,11 @@ class LoadedPackage {
   int type_id_offset_ = 0;
   package_property_t property_flags_ = 0U;
 
-  std::unordered_map<uint8_t, TypeSpec> type_specs_;
+  // The type entries of lazily parsed types are filled in on first access; the map itself is never
+  // modified after loading.
+  mutable FlatHashMap<uint8_t, TypeSpec> type_specs_;
+  std::unique_ptr<LazyTypes> lazy_types_;
+  std::unique_ptr<EntryNameIndex> entry_name_index_;
   ByteBucketArray<uint32_t> resource_ids_;
   std::vector<DynamicPackageEntry> dynamic_package_map_;
   std::vector<std::pair<OverlayableInfo, std::unordered_set<uint32_t>>> overlayable_infos_;
@@ -362,6 +415,9 @@ class LoadedArsc {
     return packages_;
   }
 
+  // Returns the native heap used by the table, including its packages.
+  MemoryUsage GetMemoryUsage() const;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(LoadedArsc);
 
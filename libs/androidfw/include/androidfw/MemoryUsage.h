@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace android {
+
+// The memory that a resources object uses, split by where it lives. The heap sizes are estimates
+// from the sizes of the containers involved and leave out the allocator overhead.
+struct MemoryUsage {
+  // Native heap allocated for the object, including data read into RAM instead of mapped.
+  size_t heap_bytes = 0;
+
+  // File-backed memory mapped for the object, e.g. a resources.arsc or an idmap.
+  size_t mapped_bytes = 0;
+
+  // The part of mapped_bytes that is currently resident in RAM.
+  size_t resident_bytes = 0;
+
+  MemoryUsage& operator+=(const MemoryUsage& other) {
+    heap_bytes += other.heap_bytes;
+    mapped_bytes += other.mapped_bytes;
+    resident_bytes += other.resident_bytes;
+    return *this;
+  }
+
+  // Returns e.g. "heap 12 KiB, mapped 340 KiB (resident 96 KiB)".
+  std::string ToString() const;
+};
+
+// Returns the number of bytes of the mapped memory [data, data + size) that is resident in RAM, or
+// 0 if the platform can't tell.
+size_t GetResidentBytes(const void* data, size_t size);
+
+}  // namespace android
@@ -33,6 +33,9 @@ struct PngOptions {
   int grayscale_tolerance = 0;
   // By default we want small files and can take the performance hit to achieve this goal.
   int compression_level = 9;
+  // When not 0, the encoding stops once the PNG gets larger than this, for instance the size of the
+  // original PNG.
+  size_t max_size = 0;
 };
 
 /**
@@ -95,8 +98,10 @@ std::unique_ptr<Image> ReadPng(InputStream* in, IDiagnostics* diag);
 
 /**
  * Writes the RGBA Image, with optional 9-patch meta-data, into the OutputStream
- * as a PNG.
+ * as a PNG. Returns false if it failed, or if it stopped because the PNG would be larger than
+ * options.max_size, in which case out_too_large is set to true and no error is logged.
  */
 bool WritePng(const Image* image, const NinePatch* nine_patch, OutputStream* out,
-              const PngOptions& options, IDiagnostics* diag, bool verbose);
+              const PngOptions& options, IDiagnostics* diag, bool verbose,
+              bool* out_too_large = nullptr);
 }  // namespace android
\ No newline at end of file
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace android {
+
+// The ordered list of resources that an app retrieved early during its startup, recorded by
+// AssetManager2::StartAccessRecording(). Replaying the profile on the next launch reads the
+// referenced files and resolves the values before they are first needed - a baseline profile for
+// resources.
+//
+// Accesses refer to their ApkAssets by path rather than by cookie, as the cookies depend on the
+// order in which the ApkAssets are added to an AssetManager.
+class ResourceAccessProfile {
+ public:
+  // The most accesses a profile holds. Later accesses are dropped.
+  static constexpr size_t kMaxAccesses = 4096;
+
+  struct Access {
+    uint32_t resid;
+
+    // Index into apk_paths() of the ApkAssets the value was found in.
+    uint32_t apk_index;
+
+    // The file inside of the ApkAssets that the value refers to, e.g. "res/layout/main.xml", or
+    // empty if the value is not a file.
+    std::string file_path;
+  };
+
+  // Appends an access to `resid` unless it has already been recorded or the profile is full.
+  // Returns whether the access was appended.
+  bool Add(uint32_t resid, std::string_view apk_path, std::string_view file_path);
+
+  const std::vector<std::string>& apk_paths() const {
+    return apk_paths_;
+  }
+  const std::vector<Access>& accesses() const {
+    return accesses_;
+  }
+  bool empty() const {
+    return accesses_.empty();
+  }
+
+  // Returns the compact binary form of the profile.
+  std::string Serialize() const;
+
+  // Parses a profile written by Serialize(). Returns std::nullopt if `data` is not a valid
+  // profile.
+  static std::optional<ResourceAccessProfile> Deserialize(std::string_view data);
+
+  // Writes the profile to `path`, e.g. in the code cache directory of the package it was recorded
+  // for. Returns false on I/O errors.
+  bool WriteToFile(const std::string& path) const;
+
+  // Reads a profile from `path`. Returns std::nullopt if the file is missing or not a valid
+  // profile.
+  static std::optional<ResourceAccessProfile> ReadFromFile(const std::string& path);
+
+ private:
+  std::vector<std::string> apk_paths_;
+  std::vector<Access> accesses_;
+  std::unordered_set<uint32_t> recorded_resids_;
+};
+
+}  // namespace android
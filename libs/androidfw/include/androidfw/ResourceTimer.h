@@ -37,8 +37,10 @@ class ResourceTimer {
   enum class Counter {
     GetResourceValue,
     RetrieveAttributes,
+    LoadApkAssets,
+    LoadIdmap,
 
-    LastCounter = RetrieveAttributes,
+    LastCounter = LoadIdmap,
   };
   static const int counterSize = static_cast<int>(Counter::LastCounter) + 1;
   static char const *toString(Counter);
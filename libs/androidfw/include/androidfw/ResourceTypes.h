@@ -44,6 +44,8 @@
 #include <string_view>
 #include <unordered_map>
 #include <utility>
+#include <variant>
+#include <vector>
 
 namespace android {
 
@@ -568,6 +570,29 @@ public:
     bool isSorted() const;
     bool isUTF8() const;
 
+    // Returns an identifier of the data this pool is currently set to. It changes whenever the pool
+    // is set to new data and is never reused within the process, so callers can cache values
+    // derived from the strings without risking stale hits after the pool is destroyed.
+    uint64_t serial() const {
+        return mSerial;
+    }
+
+    // Statistics of the structures that indexOfString() builds on first use for unsorted pools:
+    // the complete lookup index if name lookups are optimized, or a bloom filter otherwise.
+    struct LookupStats {
+        // The number of strings added to the index or the bloom filter.
+        size_t indexedStrings = 0;
+        // The time spent building the index or the bloom filter.
+        int64_t buildTimeNs = 0;
+        // The number of lookups answered without scanning the pool.
+        size_t fastLookups = 0;
+    };
+    LookupStats getLookupStats() const;
+
+    // Returns an estimate of the native heap used by the pool: the copied pool data, if any, and
+    // the caches of decoded strings and lookups.
+    size_t getHeapBytes() const;
+
 private:
     status_t                                      mError;
     void*                                         mOwnedData;
@@ -585,6 +610,20 @@ private:
     mutable std::optional<std::pair<std::unordered_map<std::string_view, int>,
                                     std::unordered_map<std::u16string_view, int>>>
         mIndexLookupCache;
+    // Whether mIndexLookupCache holds every string of the pool, so a miss means the string is absent.
+    mutable bool                                  mIndexLookupCacheComplete = false;
+    // The bits of a bloom filter over the raw bytes of all strings, for unsorted pools without a
+    // lookup index. Empty until the first lookup.
+    mutable std::vector<uint64_t>                 mBloomFilter;
+    mutable LookupStats                           mLookupStats;
+    uint64_t                                      mSerial = 0;
+
+    // Adds every string of the pool to mIndexLookupCache. Requires mCachesLock to be held.
+    base::expected<std::monostate, IOError> buildLookupIndexLocked() const;
+
+    // Returns false if the string with the given raw bytes is definitely not in the pool, building
+    // the bloom filter first if needed. Requires mCachesLock to be held.
+    bool bloomFilterMayContainLocked(const void* data, size_t size) const;
 
     base::expected<StringPiece, NullOrIOError> stringDecodeAt(
         size_t idx, incfs::map_ptr<uint8_t> str, size_t encLen) const;
@@ -851,6 +890,20 @@ public:
     ssize_t indexOfAttribute(const char16_t* ns, size_t nsLen,
                              const char16_t* attr, size_t attrLen) const;
 
+    // Returns the index of the attribute with the resource ID resId, or NAME_NOT_FOUND. This is
+    // a binary search if the tree was set up with an attribute index, and a scan otherwise.
+    ssize_t indexOfAttributeResId(uint32_t resId) const;
+
+    // Writes the resource ID and the data type of each attribute of the current element as
+    // consecutive pairs to outData, which has room for outDataSize values. Returns the number of
+    // attributes written.
+    size_t getAttributeResIdsAndTypes(uint32_t* outData, size_t outDataSize) const;
+
+    // Returns the positions of the attributes of the current element sorted by their resource
+    // IDs, or nullptr if the tree was set up without an attribute index. Attributes requested in
+    // ascending order can then be found with a single forward walk.
+    const uint16_t* getAttributeResIdOrder() const;
+
     ssize_t indexOfID() const;
     ssize_t indexOfClass() const;
     ssize_t indexOfStyle() const;
@@ -866,11 +919,19 @@ private:
     
     event_code_t nextNode();
 
+    // Returns the resource IDs of the attributes of the current element from the attribute
+    // index of the tree, or nullptr if the tree has no index.
+    const uint32_t* indexedAttributeResIds() const;
+
     const ResXMLTree&           mTree;
     event_code_t                mEventCode;
     const ResXMLTree_node*      mCurNode;
     const void*                 mCurExt;
     uint32_t                    mSourceResourceId;
+
+    // The element of the attribute index last looked up by indexedAttributeResIds().
+    mutable const void*         mIndexedExt = nullptr;
+    mutable size_t              mIndexedElement = 0;
 };
 
 static inline bool operator==(const android::ResXMLParser::ResXMLPosition& lhs,
@@ -895,7 +956,10 @@ public:
     ResXMLTree();
     ~ResXMLTree();
 
-    status_t setTo(const void* data, size_t size, bool copyData=false);
+    // If indexAttributes is true, the attributes of all elements are indexed by resource ID up
+    // front, which speeds up the lookups of attributes by resource ID during inflation.
+    status_t setTo(const void* data, size_t size, bool copyData=false,
+                   bool indexAttributes=false);
 
     status_t getError() const;
 
@@ -906,8 +970,29 @@ private:
 
     status_t validateNode(const ResXMLTree_node* node) const;
 
+    void buildAttributeIndex();
+
+    // The attributes of an element in the attribute index.
+    struct IndexedElement {
+        // The ResXMLTree_attrExt of the element.
+        const void* ext;
+        // The position of its first attribute in mIndexedResIds, mIndexedOrder and mIndexedValues.
+        uint32_t first;
+    };
+
     std::shared_ptr<const DynamicRefTable> mDynamicRefTable;
 
+    // The attribute index, empty unless setTo() was asked to build it. The elements are in
+    // document order, which is also the order of their addresses. mIndexedResIds holds the
+    // resolved resource IDs of the attributes in attribute order, and mIndexedOrder the attribute
+    // positions of each element sorted by resource ID.
+    std::vector<IndexedElement> mIndexedElements;
+    std::vector<uint32_t>       mIndexedResIds;
+    std::vector<uint16_t>       mIndexedOrder;
+    // The attribute values with their dynamic references already resolved. A size of 0 marks a
+    // value whose reference could not be resolved.
+    std::vector<Res_value>      mIndexedValues;
+
     status_t                    mError;
     void*                       mOwnedData;
     const ResXMLTree_header*    mHeader;
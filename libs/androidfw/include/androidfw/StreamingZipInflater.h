@@ -31,6 +31,9 @@ class StreamingZipInflater {
 public:
     static const size_t INPUT_CHUNK_SIZE = 64 * 1024;
     static const size_t OUTPUT_CHUNK_SIZE = 64 * 1024;
+    // Input chunk size for assets whose compressed data is larger than LARGE_ASSET_SIZE.
+    static const size_t LARGE_INPUT_CHUNK_SIZE = 256 * 1024;
+    static const size_t LARGE_ASSET_SIZE = 1024 * 1024;
 
     // Flavor that pages in the compressed data from a fd
     StreamingZipInflater(int fd, off64_t compDataStart, size_t uncompSize, size_t compSize);
@@ -52,6 +55,9 @@ public:
 private:
     void initInflateState();
     int readNextChunk();
+    // Inflate as much input as possible into 'out', reading more input first if needed.
+    // Returns the number of bytes decoded, or -1 on error.
+    ssize_t inflateNext(uint8_t* out, size_t outSize);
 
     // where to find the uncompressed data
     int mFd;
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct ZipArchive;
+
+namespace android {
+
+// A process-wide cache of open zip archives, keyed by the identity of the file (device, inode,
+// size and modification time), so that opening an APK that is already open elsewhere in the
+// process reuses the central directory libziparchive parsed the first time instead of scanning it
+// again. An archive stays in the cache for as long as any reference to it is alive.
+//
+// Cached archives are shared between their users and must only be used through the read-only
+// libziparchive APIs (FindEntry, StartIteration, ExtractToMemory, GetFileDescriptor, ...).
+class ZipArchiveCache {
+ public:
+  // A shared reference to an open archive. The archive is closed when the last reference to it
+  // is released.
+  using Archive = std::shared_ptr<ZipArchive>;
+
+  struct Stats {
+    // The number of archives currently open through the cache.
+    size_t archives = 0;
+    // The total size of the files of these archives.
+    uint64_t archive_bytes = 0;
+    // The number of opens that reused an archive, and that had to open a new one.
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+  };
+
+  // Opens the archive at `path`. Returns nullptr and sets `out_error` to the libziparchive error
+  // code if the archive cannot be opened.
+  static Archive Open(const char* path, int32_t* out_error);
+
+  // Opens the archive backed by `fd`. If `assume_ownership` is true, the fd is closed when it is
+  // no longer needed, which may be right away if the archive was already open. Archives opened
+  // from an fd that is not owned are not shared, as the caller may close the fd at any time.
+  static Archive OpenFd(int fd, const char* debug_name, bool assume_ownership,
+                        int32_t* out_error);
+
+  // Wraps an archive opened outside of the cache so that it can be used wherever an Archive is
+  // expected. The archive is not shared.
+  static Archive Adopt(ZipArchive* handle);
+
+  static Stats GetStats();
+};
+
+}  // namespace android
@@ -39,6 +39,7 @@
 
 #include <android-base/expected.h>
 
+#include <androidfw/ZipArchiveCache.h>
 #include <util/map_ptr.h>
 
 #include <utils/Compat.h>
@@ -196,11 +197,13 @@ private:
     ZipFileRO(const ZipFileRO& src);
     ZipFileRO& operator=(const ZipFileRO& src);
 
-    ZipFileRO(ZipArchiveHandle handle, char* fileName) : mHandle(handle),
-        mFileName(fileName)
+    ZipFileRO(ZipArchiveCache::Archive archive, char* fileName) : mArchive(std::move(archive)),
+        mHandle(mArchive.get()), mFileName(fileName)
     {
     }
 
+    // The archive may be shared with other users of the same file in the process.
+    const ZipArchiveCache::Archive mArchive;
     const ZipArchiveHandle mHandle;
     char* mFileName;
 };
@@ -59,6 +59,36 @@ TEST(ApkAssetsTest, LoadApkFromFd) {
   ASSERT_THAT(loaded_apk->GetAssetsProvider()->Open("res/layout/main.xml"), NotNull());
 }
 
+TEST(ApkAssetsTest, LoadInParallelKeepsOrder) {
+  const std::vector<ApkAssets::Loader> loaders = {
+      [] { return ApkAssets::Load(GetTestDataPath() + "/basic/basic.apk"); },
+      [] { return ApkAssets::Load(GetTestDataPath() + "/does/not/exist.apk"); },
+      [] { return ApkAssets::Load(GetTestDataPath() + "/appaslib/appaslib.apk"); },
+  };
+
+  const auto loaded = ApkAssets::LoadInParallel(loaders, 2 /* max_threads */);
+  ASSERT_THAT(loaded, SizeIs(3u));
+  ASSERT_THAT(loaded[0], NotNull());
+  EXPECT_THAT(loaded[0]->GetDebugName(), StrEq(GetTestDataPath() + "/basic/basic.apk"));
+  EXPECT_THAT(loaded[1], IsNull());
+  ASSERT_THAT(loaded[2], NotNull());
+  EXPECT_THAT(loaded[2]->GetDebugName(), StrEq(GetTestDataPath() + "/appaslib/appaslib.apk"));
+
+  EXPECT_THAT(ApkAssets::LoadInParallel({}), SizeIs(0u));
+}
+
+TEST(ApkAssetsTest, PrefetchSkipsMissingFiles) {
+  auto loaded_apk = ApkAssets::Load(GetTestDataPath() + "/basic/basic.apk");
+  ASSERT_THAT(loaded_apk, NotNull());
+
+  const std::vector<std::string> paths = {"res/layout/main.xml", "res/layout/missing.xml"};
+  EXPECT_EQ(1u, loaded_apk->GetAssetsProvider()->Prefetch(paths));
+  EXPECT_EQ(0u, loaded_apk->GetAssetsProvider()->Prefetch({}));
+
+  // Prefetching doesn't change what the provider returns.
+  ASSERT_THAT(loaded_apk->GetAssetsProvider()->Open("res/layout/main.xml"), NotNull());
+}
+
 TEST(ApkAssetsTest, LoadApkAsSharedLibrary) {
   auto loaded_apk = ApkAssets::Load(GetTestDataPath() + "/appaslib/appaslib.apk");
   ASSERT_THAT(loaded_apk, NotNull());
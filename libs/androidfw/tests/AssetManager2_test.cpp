@@ -39,6 +39,7 @@ namespace lib_two = com::android::lib_two;
 namespace libclient = com::android::libclient;
 
 using ::testing::Eq;
+using ::testing::HasSubstr;
 using ::testing::NotNull;
 using ::testing::StrEq;
 
@@ -166,6 +167,122 @@ TEST_F(AssetManager2Test, FindsResourceFromMultipleApkAssets) {
   EXPECT_EQ(Res_value::TYPE_STRING, value->type);
 }
 
+TEST_F(AssetManager2Test, FindsResourceFromLazilyParsedApkAssets) {
+  auto lazy_assets = ApkAssets::Load("basic/basic.apk", nullptr, PROPERTY_LAZY_TYPES);
+  ASSERT_NE(nullptr, lazy_assets);
+  auto lazy_de_fr_assets = ApkAssets::Load("basic/basic_de_fr.apk", nullptr, PROPERTY_LAZY_TYPES);
+  ASSERT_NE(nullptr, lazy_de_fr_assets);
+
+  ResTable_config desired_config;
+  memset(&desired_config, 0, sizeof(desired_config));
+  desired_config.language[0] = 'd';
+  desired_config.language[1] = 'e';
+
+  AssetManager2 assetmanager;
+  assetmanager.SetConfigurations({desired_config});
+  assetmanager.SetApkAssets({lazy_assets, lazy_de_fr_assets});
+
+  auto value = assetmanager.GetResource(basic::R::string::test1);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(1, value->cookie);
+  EXPECT_EQ('d', value->config.language[0]);
+  EXPECT_EQ('e', value->config.language[1]);
+
+  // The types filtered on demand must follow configuration changes.
+  desired_config.language[0] = 'f';
+  desired_config.language[1] = 'r';
+  assetmanager.SetConfigurations({desired_config});
+  value = assetmanager.GetResource(basic::R::string::test1);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(1, value->cookie);
+  EXPECT_EQ('f', value->config.language[0]);
+  EXPECT_EQ('r', value->config.language[1]);
+}
+
+TEST_F(AssetManager2Test, CloneReadsSameResourcesWithOwnCaches) {
+  ResTable_config desired_config;
+  memset(&desired_config, 0, sizeof(desired_config));
+  desired_config.language[0] = 'd';
+  desired_config.language[1] = 'e';
+
+  AssetManager2 assetmanager;
+  assetmanager.SetConfigurations({desired_config});
+  assetmanager.SetApkAssets({basic_assets_, basic_de_fr_assets_});
+
+  auto clone = assetmanager.Clone();
+  ASSERT_NE(nullptr, clone);
+  auto value = clone->GetResource(basic::R::string::test1);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(1, value->cookie);
+  EXPECT_EQ('d', value->config.language[0]);
+  EXPECT_EQ('e', value->config.language[1]);
+
+  // The copy keeps its configurations when the original changes.
+  desired_config.language[0] = 'f';
+  desired_config.language[1] = 'r';
+  assetmanager.SetConfigurations({desired_config});
+  value = clone->GetResource(basic::R::string::test1);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ('d', value->config.language[0]);
+  EXPECT_EQ('e', value->config.language[1]);
+}
+
+TEST_F(AssetManager2Test, RecordsAndReplaysResourceAccesses) {
+  AssetManager2 assetmanager;
+  assetmanager.SetApkAssets({basic_assets_});
+  assetmanager.StartAccessRecording(std::chrono::hours(1));
+  ASSERT_TRUE(assetmanager.GetResource(basic::R::layout::main).has_value());
+  ASSERT_TRUE(assetmanager.GetResource(basic::R::string::test1).has_value());
+  ASSERT_TRUE(assetmanager.GetResource(basic::R::layout::main).has_value());
+  const ResourceAccessProfile recorded = assetmanager.FinishAccessRecording();
+
+  // Retrievals after the recording finished are not recorded.
+  ASSERT_TRUE(assetmanager.GetResource(basic::R::string::test2).has_value());
+  EXPECT_TRUE(assetmanager.FinishAccessRecording().empty());
+
+  auto profile = ResourceAccessProfile::Deserialize(recorded.Serialize());
+  ASSERT_TRUE(profile.has_value());
+  ASSERT_EQ(1u, profile->apk_paths().size());
+  EXPECT_EQ(basic_assets_->GetPath(), profile->apk_paths()[0]);
+  ASSERT_EQ(2u, profile->accesses().size());
+  EXPECT_EQ(basic::R::layout::main, profile->accesses()[0].resid);
+  EXPECT_EQ("res/layout/main.xml", profile->accesses()[0].file_path);
+  EXPECT_EQ(basic::R::string::test1, profile->accesses()[1].resid);
+  EXPECT_EQ("", profile->accesses()[1].file_path);
+
+  EXPECT_FALSE(ResourceAccessProfile::Deserialize("not a profile").has_value());
+
+  AssetManager2 next_launch;
+  next_launch.SetApkAssets({basic_assets_});
+  EXPECT_EQ(2u, next_launch.ReplayAccessProfile(*profile));
+
+  // The accesses to ApkAssets that are not loaded are skipped.
+  AssetManager2 other_assets;
+  other_assets.SetApkAssets({style_assets_});
+  EXPECT_EQ(0u, other_assets.ReplayAccessProfile(*profile));
+}
+
+TEST_F(AssetManager2Test, ReportsMemoryUsage) {
+  AssetManager2 assetmanager;
+  assetmanager.SetApkAssets({app_assets_, overlay_assets_});
+
+  EXPECT_EQ(0u, assetmanager.GetCacheMemoryUsage().bags);
+  ASSERT_TRUE(assetmanager.GetBag(app::R::style::StyleTwo).has_value());
+  EXPECT_LT(0u, assetmanager.GetCacheMemoryUsage().bags);
+
+  const MemoryUsage table = app_assets_->GetTableMemoryUsage();
+  EXPECT_LT(0u, table.heap_bytes);
+  EXPECT_LE(table.resident_bytes, table.mapped_bytes);
+  EXPECT_EQ(0u, app_assets_->GetIdmapMemoryUsage().heap_bytes);
+  EXPECT_LT(0u, overlay_assets_->GetIdmapMemoryUsage().heap_bytes);
+
+  const std::string report = assetmanager.DumpMemoryUsage();
+  EXPECT_THAT(report, HasSubstr("cache heap"));
+  EXPECT_THAT(report, HasSubstr(app_assets_->GetDebugName()));
+  EXPECT_THAT(report, HasSubstr("    package "));
+  EXPECT_THAT(report, HasSubstr("idmap: "));
+}
+
 TEST_F(AssetManager2Test, FindsResourceFromSharedLibrary) {
   AssetManager2 assetmanager;
 
@@ -406,6 +523,33 @@ TEST_F(AssetManager2Test, MergesStylesWithParentFromSingleApkAssets) {
   EXPECT_EQ(app::R::style::StyleTwo, (*bag_two)->entries[5].style);
 }
 
+TEST_F(AssetManager2Test, SharesFrameworkBagsAcrossAssetManagers) {
+  AssetManager2::SetSharedBagCacheEnabled(true);
+
+  AssetManager2 assetmanager_one;
+  assetmanager_one.SetApkAssets({system_assets_});
+  AssetManager2 assetmanager_two;
+  assetmanager_two.SetApkAssets({system_assets_});
+
+  auto bag_one = assetmanager_one.GetBag(R::style::Theme_One);
+  ASSERT_TRUE(bag_one.has_value());
+  auto bag_two = assetmanager_two.GetBag(R::style::Theme_One);
+  ASSERT_TRUE(bag_two.has_value());
+  EXPECT_EQ(*bag_one, *bag_two);
+
+  // A different configuration must not see bags resolved for another one.
+  ResTable_config desired_config;
+  memset(&desired_config, 0, sizeof(desired_config));
+  desired_config.language[0] = 's';
+  desired_config.language[1] = 'v';
+  assetmanager_two.SetConfigurations({desired_config});
+  bag_two = assetmanager_two.GetBag(R::style::Theme_One);
+  ASSERT_TRUE(bag_two.has_value());
+  EXPECT_NE(*bag_one, *bag_two);
+
+  AssetManager2::SetSharedBagCacheEnabled(false);
+}
+
 TEST_F(AssetManager2Test, MergeStylesCircularDependency) {
   AssetManager2 assetmanager;
   assetmanager.SetApkAssets({style_assets_});
@@ -433,6 +577,43 @@ TEST_F(AssetManager2Test, ResolveReferenceToResource) {
   EXPECT_EQ(basic::R::integer::ref2, value->resid);
 }
 
+TEST_F(AssetManager2Test, KeepsCachedValuesOnlyForUnrelatedConfigChanges) {
+  ResTable_config desired_config;
+  memset(&desired_config, 0, sizeof(desired_config));
+  desired_config.language[0] = 'd';
+  desired_config.language[1] = 'e';
+
+  AssetManager2 assetmanager;
+  assetmanager.SetResolutionTableEnabled(true);
+  assetmanager.SetConfigurations({desired_config});
+  assetmanager.SetApkAssets({basic_assets_, basic_de_fr_assets_});
+
+  const auto resolve = [&] {
+    AssetManager2::SelectedValue value{};
+    value.type = Res_value::TYPE_REFERENCE;
+    value.data = basic::R::string::test1;
+    EXPECT_TRUE(assetmanager.ResolveReference(value, true /* cache_value */).has_value());
+    return value;
+  };
+  auto value = resolve();
+  EXPECT_EQ('d', value.config.language[0]);
+  EXPECT_NE(0U, value.flags & ResTable_config::CONFIG_LOCALE);
+
+  // The string doesn't vary with the orientation.
+  desired_config.orientation = ResTable_config::ORIENTATION_LAND;
+  assetmanager.SetConfigurations({desired_config});
+  value = resolve();
+  EXPECT_EQ('d', value.config.language[0]);
+
+  // But it does with the locale.
+  desired_config.language[0] = 'f';
+  desired_config.language[1] = 'r';
+  assetmanager.SetConfigurations({desired_config});
+  value = resolve();
+  EXPECT_EQ('f', value.config.language[0]);
+  EXPECT_EQ('r', value.config.language[1]);
+}
+
 TEST_F(AssetManager2Test, ResolveReferenceToBag) {
   AssetManager2 assetmanager;
   assetmanager.SetApkAssets({basic_assets_});
@@ -497,6 +678,60 @@ TEST_F(AssetManager2Test, DensityOverride) {
                                         value->data));
 }
 
+TEST_F(AssetManager2Test, ResolutionTableFollowsConfigurationChanges) {
+  ResTable_config desired_config;
+  memset(&desired_config, 0, sizeof(desired_config));
+  desired_config.language[0] = 'd';
+  desired_config.language[1] = 'e';
+
+  AssetManager2 assetmanager;
+  assetmanager.SetResolutionTableEnabled(true);
+  assetmanager.SetConfigurations({desired_config});
+  assetmanager.SetApkAssets({basic_assets_, basic_de_fr_assets_});
+
+  auto value = assetmanager.GetResource(basic::R::string::test1);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(1, value->cookie);
+  EXPECT_EQ('d', value->config.language[0]);
+
+  // The second lookup is served from the resolution table.
+  value = assetmanager.GetResource(basic::R::string::test1);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(1, value->cookie);
+  EXPECT_EQ('d', value->config.language[0]);
+
+  // Changing the configuration must discard the previously resolved entries.
+  desired_config.language[0] = 0;
+  desired_config.language[1] = 0;
+  assetmanager.SetConfigurations({desired_config});
+
+  value = assetmanager.GetResource(basic::R::string::test1);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(0, value->cookie);
+  EXPECT_EQ(0, value->config.language[0]);
+}
+
+TEST_F(AssetManager2Test, ResolutionTableIgnoresDensityOverride) {
+  AssetManager2 assetmanager;
+  assetmanager.SetResolutionTableEnabled(true);
+  assetmanager.SetApkAssets({basic_assets_, basic_xhdpi_assets_, basic_xxhdpi_assets_});
+  assetmanager.SetConfigurations({{
+    .density = ResTable_config::DENSITY_XHIGH,
+    .sdkVersion = 21,
+  }});
+
+  auto value = assetmanager.GetResource(basic::R::string::density, false /*may_be_bag*/);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ("xhdpi", GetStringFromPool(assetmanager.GetStringPoolForCookie(value->cookie),
+                                       value->data));
+
+  value = assetmanager.GetResource(basic::R::string::density, false /*may_be_bag*/,
+                                   ResTable_config::DENSITY_XXHIGH);
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ("xxhdpi", GetStringFromPool(assetmanager.GetStringPoolForCookie(value->cookie),
+                                        value->data));
+}
+
 TEST_F(AssetManager2Test, KeepLastReferenceIdUnmodifiedIfNoReferenceIsResolved) {
   AssetManager2 assetmanager;
   assetmanager.SetApkAssets({basic_assets_});
@@ -724,6 +959,23 @@ TEST_F(AssetManager2Test, OpenDir) {
   EXPECT_THAT(asset_dir->getFileType(0), Eq(FileType::kFileTypeRegular));
 }
 
+TEST_F(AssetManager2Test, OpenDirRepeatedlyAndMissing) {
+  AssetManager2 assetmanager;
+  assetmanager.SetApkAssets({system_assets_});
+
+  for (int i = 0; i < 2; i++) {
+    std::unique_ptr<AssetDir> asset_dir = assetmanager.OpenDir("subdir");
+    ASSERT_THAT(asset_dir, NotNull());
+    ASSERT_THAT(asset_dir->getFileCount(), Eq(1u));
+    EXPECT_THAT(asset_dir->getFileName(0), Eq(String8("subdir_file.txt")));
+  }
+
+  // A prefix of an existing directory name is not a directory.
+  std::unique_ptr<AssetDir> asset_dir = assetmanager.OpenDir("sub");
+  ASSERT_THAT(asset_dir, NotNull());
+  EXPECT_THAT(asset_dir->getFileCount(), Eq(0u));
+}
+
 TEST_F(AssetManager2Test, OpenDirFromManyApks) {
   AssetManager2 assetmanager;
   assetmanager.SetApkAssets({system_assets_, app_assets_});
@@ -273,5 +273,67 @@ TEST_F(AttributeResolutionXmlTest, ThemeAndXmlParser) {
   EXPECT_EQ(expected_indices, indices);
 }
 
+TEST_F(AttributeResolutionXmlTest, IndexedAttributesMatchUnindexed) {
+  std::unique_ptr<Asset> asset =
+      assetmanager_.OpenNonAsset("res/layout/layout.xml", Asset::ACCESS_BUFFER);
+  ASSERT_NE(nullptr, asset);
+
+  ResXMLTree indexed;
+  ASSERT_EQ(NO_ERROR, indexed.setTo(asset->getBuffer(true), asset->getLength(),
+                                    true /*copyData*/, true /*indexAttributes*/));
+  while (indexed.next() != ResXMLParser::START_TAG) {
+  }
+
+  const size_t count = xml_parser_.getAttributeCount();
+  ASSERT_EQ(count, indexed.getAttributeCount());
+  ASSERT_GT(count, 0u);
+
+  std::vector<uint32_t> ids_and_types(count * 2);
+  ASSERT_EQ(count, indexed.getAttributeResIdsAndTypes(ids_and_types.data(), ids_and_types.size()));
+  for (size_t i = 0; i < count; i++) {
+    const uint32_t resid = xml_parser_.getAttributeNameResID(i);
+    EXPECT_EQ(resid, indexed.getAttributeNameResID(i));
+    EXPECT_EQ(resid, ids_and_types[i * 2]);
+    EXPECT_EQ(static_cast<uint32_t>(xml_parser_.getAttributeDataType(i)), ids_and_types[i * 2 + 1]);
+    if (resid != 0) {
+      EXPECT_EQ(xml_parser_.indexOfAttributeResId(resid), indexed.indexOfAttributeResId(resid));
+    }
+  }
+  EXPECT_EQ(NAME_NOT_FOUND, indexed.indexOfAttributeResId(0x7f7f7f7fu));
+  EXPECT_EQ(NAME_NOT_FOUND, xml_parser_.indexOfAttributeResId(0x7f7f7f7fu));
+}
+
+TEST_F(AttributeResolutionXmlTest, ApplyStyleWithIndexedXmlTree) {
+  std::unique_ptr<Asset> asset =
+      assetmanager_.OpenNonAsset("res/layout/layout.xml", Asset::ACCESS_BUFFER);
+  ASSERT_NE(nullptr, asset);
+
+  ResXMLTree indexed;
+  ASSERT_EQ(NO_ERROR, indexed.setTo(asset->getBuffer(true), asset->getLength(),
+                                    true /*copyData*/, true /*indexAttributes*/));
+  while (indexed.next() != ResXMLParser::START_TAG) {
+  }
+  ASSERT_NE(nullptr, indexed.getAttributeResIdOrder());
+  ASSERT_EQ(nullptr, xml_parser_.getAttributeResIdOrder());
+
+  std::unique_ptr<Theme> theme = assetmanager_.NewTheme();
+  ASSERT_TRUE(theme->ApplyStyle(R::style::StyleTwo).has_value());
+
+  std::array<uint32_t, 6> attrs{{R::attr::attr_one, R::attr::attr_two, R::attr::attr_three,
+                                 R::attr::attr_four, R::attr::attr_five, R::attr::attr_empty}};
+  std::array<uint32_t, attrs.size() * STYLE_NUM_ENTRIES> expected_values;
+  std::array<uint32_t, attrs.size() + 1> expected_indices;
+  ASSERT_TRUE(ApplyStyle(theme.get(), &xml_parser_, 0u /*def_style_attr*/, 0u /*def_style_res*/,
+                         attrs.data(), attrs.size(), expected_values.data(),
+                         expected_indices.data()).has_value());
+
+  std::array<uint32_t, attrs.size() * STYLE_NUM_ENTRIES> values;
+  std::array<uint32_t, attrs.size() + 1> indices;
+  ASSERT_TRUE(ApplyStyle(theme.get(), &indexed, 0u /*def_style_attr*/, 0u /*def_style_res*/,
+                         attrs.data(), attrs.size(), values.data(), indices.data()).has_value());
+  EXPECT_EQ(expected_values, values);
+  EXPECT_EQ(expected_indices, indices);
+}
+
 } // namespace android
 
@@ -17,9 +17,12 @@
 #ifndef ANDROIDFW_TESTS_BENCHMARKHELPERS_H
 #define ANDROIDFW_TESTS_BENCHMARKHELPERS_H
 
+#include <unistd.h>
+
 #include <string>
 #include <vector>
 
+#include "android-base/file.h"
 #include "androidfw/ResourceTypes.h"
 #include "benchmark/benchmark.h"
 
@@ -33,6 +36,22 @@ void GetResourceBenchmarkOld(const std::vector<std::string>& paths, const ResTab
 void GetResourceBenchmark(const std::vector<std::string>& paths, const ResTable_config* config,
                           uint32_t resid, benchmark::State& state);
 
+// Changes into the test data directory for its lifetime. Idmaps refer to their overlays
+// relative to it.
+class ScopedTestDataDirectory {
+ public:
+  ScopedTestDataDirectory() : original_path_(base::GetExecutableDirectory()) {
+    chdir(GetTestDataPath().c_str());
+  }
+
+  ~ScopedTestDataDirectory() {
+    chdir(original_path_.c_str());
+  }
+
+ private:
+  std::string original_path_;
+};
+
 }  // namespace android
 
 #endif  // ANDROIDFW_TESTS_BENCHMARKHELPERS_H
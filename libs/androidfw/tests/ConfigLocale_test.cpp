@@ -791,6 +791,24 @@ TEST(ConfigLocaleTest, isLocaleBetterThan_regionComparison) {
     EXPECT_FALSE(config2.isLocaleBetterThan(config1, &request));
 }
 
+TEST(ConfigLocaleTest, isLocaleBetterThan_regionComparisonDependsOnRequest) {
+    ResTable_config config1, config2, request;
+    fillIn("en", "GB", NULL, NULL, &config1);
+    fillIn("en", "US", NULL, NULL, &config2);
+
+    // The same pair of regions compares differently for different requests, also when the
+    // comparison was made before.
+    for (int i = 0; i < 2; i++) {
+        fillIn("en", "AU", NULL, NULL, &request);
+        EXPECT_TRUE(config1.isLocaleBetterThan(config2, &request));
+        EXPECT_FALSE(config2.isLocaleBetterThan(config1, &request));
+
+        fillIn("en", "PR", NULL, NULL, &request);
+        EXPECT_FALSE(config1.isLocaleBetterThan(config2, &request));
+        EXPECT_TRUE(config2.isLocaleBetterThan(config1, &request));
+    }
+}
+
 TEST(ConfigLocaleTest, isLocaleBetterThan_numberingSystem) {
     ResTable_config config1, config2, request;
 
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "androidfw/ConfigMatcher.h"
+
+#include <string>
+#include <vector>
+
+#include "androidfw/ConfigDescription.h"
+
+#include "TestHelpers.h"
+#include "gtest/gtest.h"
+
+namespace android {
+
+static std::vector<ConfigDescription> ParseConfigs(const std::vector<std::string>& qualifiers) {
+  std::vector<ConfigDescription> configs;
+  for (const auto& qualifier : qualifiers) {
+    ConfigDescription config;
+    EXPECT_TRUE(ConfigDescription::Parse(qualifier, &config)) << qualifier;
+    configs.push_back(config);
+  }
+  return configs;
+}
+
+TEST(ConfigMatcherTest, NeverRejectsMatchingConfigs) {
+  const auto configs = ParseConfigs({
+      "",
+      "mcc310",
+      "mcc310-mnc004",
+      "en",
+      "fr-rCA",
+      "ldrtl",
+      "sw600dp",
+      "w720dp-h1024dp",
+      "small",
+      "xlarge",
+      "long",
+      "notlong",
+      "round",
+      "widecg",
+      "highdr",
+      "port",
+      "land",
+      "car",
+      "night",
+      "notnight",
+      "television-night",
+      "hdpi",
+      "xxhdpi",
+      "finger",
+      "keysexposed",
+      "keyssoft",
+      "qwerty",
+      "navhidden",
+      "dpad",
+      "feminine",
+      "v21",
+      "v34",
+      "land-night-v26",
+      "sw360dp-port-xhdpi-v31",
+  });
+
+  size_t rejected = 0;
+  for (const auto& device : configs) {
+    const ConfigMatcher matcher(device);
+    for (const auto& candidate : configs) {
+      const bool may_match = matcher.MayMatch(PackedConfig::From(candidate));
+      if (candidate.match(device)) {
+        EXPECT_TRUE(may_match) << "'" << candidate.toString() << "' matches '"
+                               << device.toString() << "'";
+      } else if (!may_match) {
+        rejected++;
+      }
+    }
+  }
+
+  // A good share of the pairs must be rejected without calling match().
+  EXPECT_GT(rejected, configs.size() * configs.size() / 3);
+}
+
+TEST(ConfigMatcherTest, RejectsConflictingQualifiers) {
+  const auto configs = ParseConfigs({"night-v8", "notnight-v8", "land", "port", "v34", "v21"});
+  const ConfigMatcher night_matcher(configs[0]);
+  EXPECT_TRUE(night_matcher.MayMatch(PackedConfig::From(configs[0])));
+  EXPECT_FALSE(night_matcher.MayMatch(PackedConfig::From(configs[1])));
+
+  const ConfigMatcher land_matcher(configs[2]);
+  EXPECT_FALSE(land_matcher.MayMatch(PackedConfig::From(configs[3])));
+
+  // Newer versions don't match older devices, but older versions do match newer ones.
+  const ConfigMatcher v21_matcher(configs[5]);
+  EXPECT_FALSE(v21_matcher.MayMatch(PackedConfig::From(configs[4])));
+  const ConfigMatcher v34_matcher(configs[4]);
+  EXPECT_TRUE(v34_matcher.MayMatch(PackedConfig::From(configs[5])));
+}
+
+}  // namespace android
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <sys/mman.h>
+
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -176,6 +179,36 @@ TEST(CursorWindowTest, StoreString) {
     ASSERT_ALIGNED(w);
 }
 
+TEST(CursorWindowTest, StoreRepeatedStringOnce) {
+    CREATE_WINDOW_1K_3X3;
+
+    ASSERT_EQ(w->putString(0, 1, "food", 5), OK);
+    const size_t freeSpace = w->freeSpace();
+    ASSERT_EQ(w->putString(1, 1, "food", 5), OK);
+    ASSERT_EQ(w->putString(2, 1, "food", 5), OK);
+    ASSERT_EQ(w->freeSpace(), freeSpace);
+
+    size_t size;
+    auto first = w->getFieldSlotValueString(w->getFieldSlot(0, 1), &size);
+    ASSERT_EQ(w->getFieldSlotValueString(w->getFieldSlot(2, 1), &size), first);
+    ASSERT_EQ(std::string(first), "food");
+    ASSERT_EQ(size, 5);
+
+    // Other strings are still stored separately.
+    ASSERT_EQ(w->putString(1, 1, "cafe", 5), OK);
+    ASSERT_LT(w->freeSpace(), freeSpace);
+    ASSERT_EQ(std::string(w->getFieldSlotValueString(w->getFieldSlot(1, 1), &size)), "cafe");
+    ASSERT_EQ(std::string(w->getFieldSlotValueString(w->getFieldSlot(2, 1), &size)), "food");
+
+    // Nothing is shared with the values from before clear().
+    ASSERT_EQ(w->clear(), OK);
+    ASSERT_EQ(w->setNumColumns(1), OK);
+    ASSERT_EQ(w->allocRow(), OK);
+    ASSERT_EQ(w->putString(0, 0, "food", 5), OK);
+    ASSERT_EQ(std::string(w->getFieldSlotValueString(w->getFieldSlot(0, 0), &size)), "food");
+    ASSERT_ALIGNED(w);
+}
+
 TEST(CursorWindowTest, StoreBounds) {
     CREATE_WINDOW_1K_3X3;
 
@@ -197,6 +230,38 @@ TEST(CursorWindowTest, StoreBounds) {
     ASSERT_ALIGNED(w);
 }
 
+TEST(CursorWindowTest, GetColumnRange) {
+    CREATE_WINDOW_1K_3X3;
+
+    ASSERT_EQ(w->putLong(0, 1, 7), OK);
+    ASSERT_EQ(w->putDouble(1, 1, 2.5), OK);
+    ASSERT_EQ(w->putString(2, 1, "42", 3), OK);
+
+    int64_t longs[3] = {-1, -1, -1};
+    ASSERT_EQ(w->getColumnLongs(1, 0, 3, longs), OK);
+    ASSERT_EQ(longs[0], 7);
+    ASSERT_EQ(longs[1], 2);
+    ASSERT_EQ(longs[2], 42);
+
+    double doubles[2] = {-1.0, -1.0};
+    ASSERT_EQ(w->getColumnDoubles(1, 1, 2, doubles), OK);
+    ASSERT_EQ(doubles[0], 2.5);
+    ASSERT_EQ(doubles[1], 42.0);
+
+    // Rows that were never written are null.
+    ASSERT_EQ(w->getColumnLongs(0, 0, 3, longs), OK);
+    ASSERT_EQ(longs[0], 0);
+    ASSERT_EQ(longs[2], 0);
+
+    // Ranges must be in the window, and blobs have no numeric value.
+    ASSERT_EQ(w->getColumnLongs(3, 0, 1, longs), BAD_VALUE);
+    ASSERT_EQ(w->getColumnLongs(0, 2, 2, longs), BAD_VALUE);
+    ASSERT_EQ(w->getColumnLongs(0, 3, 0, longs), OK);
+    ASSERT_EQ(w->putBlob(1, 2, "b", 1), OK);
+    ASSERT_EQ(w->getColumnDoubles(2, 0, 3, doubles), BAD_TYPE);
+    ASSERT_ALIGNED(w);
+}
+
 TEST(CursorWindowTest, Inflate) {
     CREATE_WINDOW_2M;
 
@@ -257,7 +322,87 @@ TEST(CursorWindowTest, Inflate) {
     ASSERT_ALIGNED(w);
 }
 
+TEST(CursorWindowTest, ReusesPooledRegions) {
+    char buf[kHalfInlineSize];
+    memset(buf, 42, kHalfInlineSize);
+
+    // Inflates a fresh window into a region of its own.
+    auto inflate = [&buf](CursorWindow** outWindow) {
+        ASSERT_EQ(CursorWindow::create(String8("test"), 1 << 21, outWindow), OK);
+        CursorWindow* w = *outWindow;
+        ASSERT_EQ(w->setNumColumns(3), OK);
+        ASSERT_EQ(w->allocRow(), OK);
+        ASSERT_EQ(w->putBlob(0, 0, buf, kHalfInlineSize), OK);
+        ASSERT_EQ(w->putBlob(0, 1, buf, kHalfInlineSize), OK);
+        ASSERT_EQ(w->size(), 1 << 21);
+    };
+
+    CursorWindow* w;
+    inflate(&w);
+    delete w;
+    const auto before = CursorWindow::getPoolStats();
+    ASSERT_GE(before.pooledBytes, 1 << 21);
+
+    inflate(&w);
+    const auto after = CursorWindow::getPoolStats();
+    ASSERT_EQ(after.hits, before.hits + 1);
+    ASSERT_EQ(after.pooledBytes, before.pooledBytes - (1 << 21));
+    delete w;
+}
+
 #ifdef __linux__
+TEST(CursorWindowTest, PooledRegionsDontExposeFreedRows) {
+    char buf[kHalfInlineSize];
+    memset(buf, 42, kHalfInlineSize);
+
+    // Inflates a fresh window with one row into a region of its own.
+    auto inflate = [&buf](CursorWindow** outWindow) {
+        ASSERT_EQ(CursorWindow::create(String8("test"), 1 << 21, outWindow), OK);
+        CursorWindow* w = *outWindow;
+        ASSERT_EQ(w->setNumColumns(2), OK);
+        ASSERT_EQ(w->allocRow(), OK);
+        ASSERT_EQ(w->putBlob(0, 0, buf, kHalfInlineSize), OK);
+        ASSERT_EQ(w->putBlob(0, 1, buf, kHalfInlineSize), OK);
+        ASSERT_EQ(w->size(), 1 << 21);
+    };
+
+    CursorWindow* w;
+    inflate(&w);
+    ASSERT_EQ(w->allocRow(), OK);
+    ASSERT_EQ(w->putLong(1, 0, -1), OK);
+    ASSERT_EQ(w->putLong(1, 1, -1), OK);
+    ASSERT_EQ(w->freeLastRow(), OK);
+    delete w;
+
+    const auto before = CursorWindow::getPoolStats();
+    inflate(&w);
+    ASSERT_EQ(CursorWindow::getPoolStats().hits, before.hits + 1);
+    const size_t slotsOffset = w->size() - w->sizeOfSlots();
+    const size_t allocOffset = slotsOffset - w->freeSpace();
+
+    // Look at the whole region, as the process the window is sent to would.
+    Parcel p;
+    ASSERT_EQ(w->writeToParcel(&p), OK);
+    p.setDataPosition(0);
+    String8 name;
+    uint32_t numRows, numColumns, size;
+    bool isAshmem;
+    ASSERT_EQ(p.readString8(&name), OK);
+    ASSERT_EQ(p.readUint32(&numRows), OK);
+    ASSERT_EQ(p.readUint32(&numColumns), OK);
+    ASSERT_EQ(p.readUint32(&size), OK);
+    ASSERT_EQ(p.readBool(&isAshmem), OK);
+    ASSERT_TRUE(isAshmem);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, p.readFileDescriptor(), 0);
+    ASSERT_NE(data, MAP_FAILED);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const size_t dirty = std::count_if(bytes + allocOffset, bytes + slotsOffset,
+                                       [](uint8_t byte) { return byte != 0; });
+    munmap(data, size);
+    ASSERT_EQ(dirty, 0U);
+    delete w;
+}
+
 TEST(CursorWindowTest, ParcelEmpty) {
     CREATE_WINDOW_2M;
 
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "androidfw/FlatHashMap.h"
+
+#include <map>
+#include <memory>
+#include <random>
+
+#include "gtest/gtest.h"
+
+namespace android {
+
+TEST(FlatHashMapTest, InsertAndFind) {
+  FlatHashMap<uint32_t, int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.end(), map.find(0x7f010000));
+
+  auto [it, inserted] = map.try_emplace(0x7f010000, 1);
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(0x7f010000u, it->first);
+  EXPECT_EQ(1, it->second);
+
+  std::tie(it, inserted) = map.try_emplace(0x7f010000, 2);
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(1, it->second);
+
+  map[0x7f010001] = 3;
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ(3, map.find(0x7f010001)->second);
+  EXPECT_TRUE(map.contains(0x7f010000));
+  EXPECT_FALSE(map.contains(0x7f010002));
+}
+
+TEST(FlatHashMapTest, ZeroIsAValidKey) {
+  FlatHashMap<uint32_t, int> map;
+  map[0] = 5;
+  ASSERT_NE(map.end(), map.find(0));
+  EXPECT_EQ(5, map.find(0)->second);
+}
+
+TEST(FlatHashMapTest, GrowsAndKeepsValues) {
+  FlatHashMap<uint32_t, std::unique_ptr<int>> map;
+  for (uint32_t i = 0; i < 1000; i++) {
+    map.try_emplace(0x7f020000 | i, std::make_unique<int>(i));
+  }
+  EXPECT_EQ(1000u, map.size());
+  EXPECT_GE(map.capacity() * 3, map.size() * 4);
+  for (uint32_t i = 0; i < 1000; i++) {
+    auto it = map.find(0x7f020000 | i);
+    ASSERT_NE(map.end(), it);
+    EXPECT_EQ(static_cast<int>(i), *it->second);
+  }
+}
+
+TEST(FlatHashMapTest, EraseKeepsOtherItemsReachable) {
+  FlatHashMap<uint32_t, uint32_t> map;
+  std::map<uint32_t, uint32_t> expected;
+  std::mt19937 random(42);
+  for (int i = 0; i < 20000; i++) {
+    const uint32_t key = 0x7f010000 + random() % 512;
+    if (random() % 2 == 0) {
+      map[key] = key;
+      expected[key] = key;
+    } else {
+      EXPECT_EQ(expected.erase(key), map.erase(key));
+    }
+    ASSERT_EQ(expected.size(), map.size());
+  }
+  for (const auto& [key, value] : expected) {
+    auto it = map.find(key);
+    ASSERT_NE(map.end(), it);
+    EXPECT_EQ(value, it->second);
+  }
+}
+
+TEST(FlatHashMapTest, EraseIf) {
+  FlatHashMap<uint32_t, uint32_t> map;
+  for (uint32_t i = 0; i < 300; i++) {
+    map[i] = i;
+  }
+  EXPECT_EQ(100u, map.erase_if([](const auto& item) { return item.second % 3 == 0; }));
+  EXPECT_EQ(200u, map.size());
+
+  size_t count = 0;
+  for (const auto& [key, value] : map) {
+    EXPECT_NE(0u, value % 3);
+    EXPECT_EQ(key, value);
+    ++count;
+  }
+  EXPECT_EQ(200u, count);
+}
+
+TEST(FlatHashMapTest, ClearKeepsCapacity) {
+  FlatHashMap<uint32_t, int> map(100);
+  const size_t capacity = map.capacity();
+  for (uint32_t i = 0; i < 50; i++) {
+    map[i] = 1;
+  }
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(capacity, map.capacity());
+  EXPECT_EQ(map.end(), map.begin());
+  EXPECT_EQ(map.end(), map.find(1));
+}
+
+}  // namespace android
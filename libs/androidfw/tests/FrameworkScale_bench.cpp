@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "androidfw/ApkAssets.h"
+#include "androidfw/AssetManager2.h"
+#include "androidfw/ResourceTypes.h"
+#include "benchmark/benchmark.h"
+
+#include "BenchmarkHelpers.h"
+#include "data/overlayable/R.h"
+
+namespace overlayable = com::android::overlayable;
+
+// Benchmarks of the lookup paths with an AssetManager2 set up the way an app's is on a device:
+// the framework, a couple of shared libraries, an app overlaid by state.range(0) overlays, and
+// several locales. Each runs a few repetitions and reports the median and tail of them.
+
+namespace android {
+
+constexpr const static char* kFrameworkPath = "/system/framework/framework-res.apk";
+constexpr const static uint32_t kStringOkId = 0x0104000au;  // android:string/ok
+constexpr const static uint32_t kStyleId = 0x01030237u;     // android:style/Theme.Material.Light
+
+static double Percentile(const std::vector<double>& values, double percentile) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  std::vector<double> sorted(values);
+  std::sort(sorted.begin(), sorted.end());
+  const size_t rank = static_cast<size_t>(percentile * (sorted.size() - 1) + 0.5);
+  return sorted[rank];
+}
+
+static void FrameworkScaleArgs(benchmark::internal::Benchmark* b) {
+  b->Arg(0)->Arg(10)->Arg(50);
+  b->Repetitions(10);
+  b->ComputeStatistics("p50", [](const std::vector<double>& v) { return Percentile(v, 0.5); });
+  b->ComputeStatistics("p90", [](const std::vector<double>& v) { return Percentile(v, 0.9); });
+  b->ComputeStatistics("p99", [](const std::vector<double>& v) { return Percentile(v, 0.99); });
+}
+
+static size_t AllocatedBytes() {
+#if defined(__BIONIC__)
+  return mallinfo().uordblks;
+#else
+  return 0;
+#endif
+}
+
+static bool LoadFrameworkScaleAssets(benchmark::State& state,
+                                     std::vector<AssetManager2::ApkAssetsPtr>* apk_assets) {
+  apk_assets->push_back(ApkAssets::Load(kFrameworkPath));
+  apk_assets->push_back(ApkAssets::Load("lib_one/lib_one.apk"));
+  apk_assets->push_back(ApkAssets::Load("lib_two/lib_two.apk"));
+  apk_assets->push_back(ApkAssets::Load("overlayable/overlayable.apk"));
+  for (int64_t i = 0; i < state.range(0); i++) {
+    apk_assets->push_back(ApkAssets::LoadOverlay("overlay/overlay.idmap"));
+  }
+  for (const auto& apk : *apk_assets) {
+    if (apk == nullptr) {
+      state.SkipWithError("Failed to load assets");
+      return false;
+    }
+  }
+  return true;
+}
+
+static std::vector<ResTable_config> MakeConfigurations(
+    const std::vector<std::pair<const char*, const char*>>& locales) {
+  std::vector<ResTable_config> configurations;
+  for (const auto& [language, country] : locales) {
+    ResTable_config config;
+    memset(&config, 0, sizeof(config));
+    memcpy(config.language, language, 2);
+    memcpy(config.country, country, 2);
+    config.sdkVersion = 35;
+    configurations.push_back(config);
+  }
+  return configurations;
+}
+
+static std::vector<ResTable_config> MultiLocaleConfigurations() {
+  return MakeConfigurations({{"fr", "FR"}, {"de", "DE"}, {"ja", "JP"}, {"en", "US"}});
+}
+
+static bool SetUpFrameworkScale(benchmark::State& state, AssetManager2* assets,
+                                std::vector<AssetManager2::ApkAssetsPtr>* apk_assets) {
+  if (!LoadFrameworkScaleAssets(state, apk_assets)) {
+    return false;
+  }
+  assets->SetApkAssets(*apk_assets);
+  assets->SetConfigurations(MultiLocaleConfigurations());
+  return true;
+}
+
+static void BM_FrameworkScaleLoadApkAssets(benchmark::State& state) {
+  ScopedTestDataDirectory test_data_directory;
+  size_t allocated = 0;
+  for (auto&& _ : state) {
+    const size_t before = AllocatedBytes();
+    std::vector<AssetManager2::ApkAssetsPtr> apk_assets;
+    if (!LoadFrameworkScaleAssets(state, &apk_assets)) {
+      return;
+    }
+    AssetManager2 assets;
+    assets.SetApkAssets(apk_assets);
+    allocated += AllocatedBytes() - before;
+  }
+  state.counters["allocated_bytes"] =
+      benchmark::Counter(allocated, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_FrameworkScaleLoadApkAssets)->Apply(FrameworkScaleArgs);
+
+static void BM_FrameworkScaleSetConfigurations(benchmark::State& state) {
+  ScopedTestDataDirectory test_data_directory;
+  AssetManager2 assets;
+  std::vector<AssetManager2::ApkAssetsPtr> apk_assets;
+  if (!SetUpFrameworkScale(state, &assets, &apk_assets)) {
+    return;
+  }
+
+  // Switch back and forth, the way a locale or orientation change does.
+  const auto configurations1 = MultiLocaleConfigurations();
+  const auto configurations2 = MakeConfigurations({{"en", "GB"}, {"es", "ES"}, {"it", "IT"}});
+  for (auto&& _ : state) {
+    assets.SetConfigurations(configurations2);
+    assets.SetConfigurations(configurations1);
+  }
+}
+BENCHMARK(BM_FrameworkScaleSetConfigurations)->Apply(FrameworkScaleArgs);
+
+static void BM_FrameworkScaleGetResource(benchmark::State& state, uint32_t resid) {
+  ScopedTestDataDirectory test_data_directory;
+  AssetManager2 assets;
+  std::vector<AssetManager2::ApkAssetsPtr> apk_assets;
+  if (!SetUpFrameworkScale(state, &assets, &apk_assets)) {
+    return;
+  }
+
+  for (auto&& _ : state) {
+    auto value = assets.GetResource(resid);
+    benchmark::DoNotOptimize(value);
+  }
+}
+BENCHMARK_CAPTURE(BM_FrameworkScaleGetResource, framework, kStringOkId)
+    ->Apply(FrameworkScaleArgs);
+BENCHMARK_CAPTURE(BM_FrameworkScaleGetResource, overlaid, overlayable::R::string::overlayable5)
+    ->Apply(FrameworkScaleArgs);
+BENCHMARK_CAPTURE(BM_FrameworkScaleGetResource, not_overlaid,
+                  overlayable::R::string::not_overlayable)
+    ->Apply(FrameworkScaleArgs);
+
+static void BM_FrameworkScaleGetBag(benchmark::State& state) {
+  ScopedTestDataDirectory test_data_directory;
+  AssetManager2 assets;
+  std::vector<AssetManager2::ApkAssetsPtr> apk_assets;
+  if (!SetUpFrameworkScale(state, &assets, &apk_assets)) {
+    return;
+  }
+
+  for (auto&& _ : state) {
+    auto bag = assets.GetBag(kStyleId);
+    benchmark::DoNotOptimize(bag);
+  }
+}
+BENCHMARK(BM_FrameworkScaleGetBag)->Apply(FrameworkScaleArgs);
+
+static void BM_FrameworkScaleApplyStyle(benchmark::State& state) {
+  ScopedTestDataDirectory test_data_directory;
+  AssetManager2 assets;
+  std::vector<AssetManager2::ApkAssetsPtr> apk_assets;
+  if (!SetUpFrameworkScale(state, &assets, &apk_assets)) {
+    return;
+  }
+
+  for (auto&& _ : state) {
+    auto theme = assets.NewTheme();
+    theme->ApplyStyle(kStyleId, false /* force */);
+  }
+}
+BENCHMARK(BM_FrameworkScaleApplyStyle)->Apply(FrameworkScaleArgs);
+
+static void BM_FrameworkScaleOpenNonAsset(benchmark::State& state) {
+  ScopedTestDataDirectory test_data_directory;
+  AssetManager2 assets;
+  std::vector<AssetManager2::ApkAssetsPtr> apk_assets;
+  if (!SetUpFrameworkScale(state, &assets, &apk_assets)) {
+    return;
+  }
+
+  // A file none of the APKs contain, so that every one of them is searched.
+  for (auto&& _ : state) {
+    auto asset = assets.OpenNonAsset("res/layout/missing.xml", Asset::ACCESS_BUFFER);
+    benchmark::DoNotOptimize(asset);
+  }
+}
+BENCHMARK(BM_FrameworkScaleOpenNonAsset)->Apply(FrameworkScaleArgs);
+
+}  // namespace android
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "android-base/file.h"
+#include "androidfw/ApkAssets.h"
+#include "androidfw/AssetManager2.h"
+#include "androidfw/Idmap.h"
+#include "benchmark/benchmark.h"
+
+#include "BenchmarkHelpers.h"
+#include "data/overlayable/R.h"
+
+namespace overlayable = com::android::overlayable;
+
+namespace android {
+
+static void BM_LoadedIdmapLoad(benchmark::State& state) {
+  ScopedTestDataDirectory test_data_directory;
+  std::string idmap_data;
+  if (!base::ReadFileToString("overlay/overlay.idmap", &idmap_data)) {
+    state.SkipWithError("Failed to read idmap");
+    return;
+  }
+
+  for (auto&& _ : state) {
+    auto idmap = LoadedIdmap::Load("overlay/overlay.idmap", idmap_data);
+    benchmark::DoNotOptimize(idmap);
+  }
+}
+BENCHMARK(BM_LoadedIdmapLoad);
+
+// Sets up the target with state.range(0) overlays, each a separate load of the same idmap, the
+// way a target is overlaid by the many overlays of a device.
+static bool SetUpOverlays(benchmark::State& state, AssetManager2* assets,
+                          std::vector<AssetManager2::ApkAssetsPtr>* apk_assets) {
+  apk_assets->push_back(ApkAssets::Load("system/system.apk"));
+  apk_assets->push_back(ApkAssets::Load("overlayable/overlayable.apk"));
+  for (int64_t i = 0; i < state.range(0); i++) {
+    apk_assets->push_back(ApkAssets::LoadOverlay("overlay/overlay.idmap"));
+  }
+  for (const auto& apk : *apk_assets) {
+    if (apk == nullptr) {
+      state.SkipWithError("Failed to load assets");
+      return false;
+    }
+  }
+  assets->SetApkAssets(*apk_assets);
+  return true;
+}
+
+static void BM_AssetManagerSetApkAssetsWithOverlays(benchmark::State& state) {
+  ScopedTestDataDirectory test_data_directory;
+  AssetManager2 assets;
+  std::vector<AssetManager2::ApkAssetsPtr> apk_assets;
+  if (!SetUpOverlays(state, &assets, &apk_assets)) {
+    return;
+  }
+
+  for (auto&& _ : state) {
+    AssetManager2 overlaid_assets;
+    overlaid_assets.SetApkAssets(apk_assets);
+  }
+}
+BENCHMARK(BM_AssetManagerSetApkAssetsWithOverlays)->Arg(1)->Arg(10)->Arg(50)->Arg(100);
+
+static void BM_AssetManagerGetOverlaidResource(benchmark::State& state, uint32_t resid) {
+  ScopedTestDataDirectory test_data_directory;
+  AssetManager2 assets;
+  std::vector<AssetManager2::ApkAssetsPtr> apk_assets;
+  if (!SetUpOverlays(state, &assets, &apk_assets)) {
+    return;
+  }
+
+  for (auto&& _ : state) {
+    auto value = assets.GetResource(resid);
+    benchmark::DoNotOptimize(value);
+  }
+}
+// Overlaid by a resource of the overlay.
+BENCHMARK_CAPTURE(BM_AssetManagerGetOverlaidResource, reference,
+                  overlayable::R::string::overlayable5)
+    ->Arg(1)->Arg(10)->Arg(50)->Arg(100);
+// Overlaid by a value inlined in the idmap.
+BENCHMARK_CAPTURE(BM_AssetManagerGetOverlaidResource, inline,
+                  overlayable::R::string::overlayable11)
+    ->Arg(1)->Arg(10)->Arg(50)->Arg(100);
+// Not overlaid, but every overlay is still looked up.
+BENCHMARK_CAPTURE(BM_AssetManagerGetOverlaidResource, not_overlaid,
+                  overlayable::R::string::not_overlayable)
+    ->Arg(1)->Arg(10)->Arg(50)->Arg(100);
+
+}  // namespace android
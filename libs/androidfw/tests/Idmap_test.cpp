@@ -133,6 +133,17 @@ TEST_F(IdmapTest, OverlayOverridesResourceValueUsingInlineString) {
   ASSERT_EQ("Hardcoded string", GetStringFromApkAssets(asset_manager, *value));
 }
 
+TEST_F(IdmapTest, ResourceNotOverlaidKeepsTargetValue) {
+  AssetManager2 asset_manager;
+  asset_manager.SetApkAssets({system_assets_, overlayable_assets_, overlay_assets_});
+
+  // Next to the overlaid strings of its type, which the idmap indexes densely.
+  auto value = asset_manager.GetResource(overlayable::R::string::not_overlayable);
+  ASSERT_TRUE(value.has_value());
+  ASSERT_EQ(value->cookie, 1U);
+  ASSERT_EQ(value->type, Res_value::TYPE_STRING);
+}
+
 TEST_F(IdmapTest, OverlayOverridesResourceValueUsingOverlayingResource) {
   AssetManager2 asset_manager;
   asset_manager.SetApkAssets({system_assets_, overlayable_assets_, overlay_assets_});
@@ -71,6 +71,65 @@ TEST(LoadedArscTest, LoadSinglePackageArsc) {
   ASSERT_TRUE(LoadedPackage::GetEntry(type.type, entry_index).has_value());
 }
 
+TEST(LoadedArscTest, LazyTypesMatchEagerlyParsedTypes) {
+  std::string contents;
+  ASSERT_TRUE(ReadFileFromZipToString(GetTestDataPath() + "/styles/styles.apk", "resources.arsc",
+                                      &contents));
+
+  auto eager_arsc = LoadedArsc::Load(contents.data(), contents.length());
+  auto lazy_arsc = LoadedArsc::Load(contents.data(), contents.length(), nullptr, nullptr,
+                                    PROPERTY_LAZY_TYPES);
+  ASSERT_THAT(eager_arsc, NotNull());
+  ASSERT_THAT(lazy_arsc, NotNull());
+
+  const uint8_t package_id = get_package_id(app::R::string::string_one);
+  const LoadedPackage* eager_package = eager_arsc->GetPackageById(package_id);
+  const LoadedPackage* lazy_package = lazy_arsc->GetPackageById(package_id);
+  ASSERT_THAT(eager_package, NotNull());
+  ASSERT_THAT(lazy_package, NotNull());
+  EXPECT_FALSE(eager_package->HasLazyTypes());
+  EXPECT_TRUE(lazy_package->HasLazyTypes());
+  ASSERT_THAT(lazy_package->GetTypeSpecCount(), Eq(eager_package->GetTypeSpecCount()));
+
+  eager_package->ForEachTypeSpec([&](const TypeSpec& eager_spec, uint8_t type_id) {
+    const TypeSpec* lazy_spec = lazy_package->GetTypeSpecByTypeIndex(type_id - 1);
+    ASSERT_THAT(lazy_spec, NotNull());
+    ASSERT_THAT(lazy_spec->type_entries, SizeIs(eager_spec.type_entries.size()));
+    for (size_t i = 0; i < eager_spec.type_entries.size(); i++) {
+      EXPECT_EQ(eager_spec.type_entries[i].type.unsafe_ptr(),
+                lazy_spec->type_entries[i].type.unsafe_ptr());
+      EXPECT_EQ(0, eager_spec.type_entries[i].config.compare(lazy_spec->type_entries[i].config));
+    }
+  });
+
+  std::set<ResTable_config> eager_configs;
+  std::set<ResTable_config> lazy_configs;
+  ASSERT_TRUE(eager_package->CollectConfigurations(false, &eager_configs).has_value());
+  ASSERT_TRUE(lazy_package->CollectConfigurations(false, &lazy_configs).has_value());
+  EXPECT_EQ(eager_configs, lazy_configs);
+}
+
+TEST(LoadedArscTest, FindEntryByNameWithOptimizedNameLookups) {
+  std::string contents;
+  ASSERT_TRUE(ReadFileFromZipToString(GetTestDataPath() + "/styles/styles.apk", "resources.arsc",
+                                      &contents));
+
+  auto loaded_arsc = LoadedArsc::Load(contents.data(), contents.length(), nullptr, nullptr,
+                                      PROPERTY_OPTIMIZE_NAME_LOOKUPS);
+  ASSERT_THAT(loaded_arsc, NotNull());
+  const LoadedPackage* package =
+      loaded_arsc->GetPackageById(get_package_id(app::R::string::string_one));
+  ASSERT_THAT(package, NotNull());
+
+  // The second lookup is answered from the index that the first one built.
+  for (int i = 0; i < 2; i++) {
+    auto id = package->FindEntryByName(u"string", u"string_one");
+    ASSERT_TRUE(id.has_value());
+    EXPECT_THAT(*id, Eq(fix_package_id(app::R::string::string_one, 0)));
+  }
+  EXPECT_FALSE(package->FindEntryByName(u"string", u"absent").has_value());
+}
+
 TEST(LoadedArscTest, LoadSharedLibrary) {
   std::string contents;
   ASSERT_TRUE(ReadFileFromZipToString(GetTestDataPath() + "/lib_one/lib_one.apk", "resources.arsc",
@@ -14,7 +14,11 @@
  * limitations under the License.
  */
 
+#include <cstring>
+#include <vector>
+
 #include "androidfw/AssetManager.h"
+#include "androidfw/LoadedArsc.h"
 #include "androidfw/ResourceTypes.h"
 #include "android-base/file.h"
 
@@ -95,4 +99,105 @@ static void BM_SparseEntryGetResourceNotSparseRuntime(benchmark::State& state, u
 BENCHMARK_CAPTURE(BM_SparseEntryGetResourceNotSparseRuntime, Small, sparse::R::integer::foo_9);
 BENCHMARK_CAPTURE(BM_SparseEntryGetResourceNotSparseRuntime, Large, sparse::R::string::foo_999);
 
+// The encodings of the entry offsets of a ResTable_type that aapt2 can pick from.
+enum class TypeEncoding { kDense, kOffset16, kSparse };
+
+// Builds a type chunk with `entry_count` entries, of which every one in `stride` is present.
+static std::vector<uint32_t> BuildTypeChunk(TypeEncoding encoding, size_t entry_count,
+                                            size_t stride) {
+  std::vector<uint16_t> present;
+  for (size_t i = 0; i < entry_count; i += stride) {
+    present.push_back(static_cast<uint16_t>(i));
+  }
+
+  const size_t offsets_size = encoding == TypeEncoding::kSparse
+                                  ? present.size() * sizeof(ResTable_sparseTypeEntry)
+                                  : entry_count * (encoding == TypeEncoding::kOffset16
+                                                       ? sizeof(uint16_t) : sizeof(uint32_t));
+  const size_t entries_start = sizeof(ResTable_type) + ((offsets_size + 3) & ~3u);
+  const size_t entry_size = sizeof(ResTable_entry) + sizeof(Res_value);
+  const size_t chunk_size = entries_start + present.size() * entry_size;
+
+  std::vector<uint32_t> storage((chunk_size + 3) / 4, 0);
+  auto data = reinterpret_cast<uint8_t*>(storage.data());
+  auto type = reinterpret_cast<ResTable_type*>(data);
+  type->header.type = htods(RES_TABLE_TYPE_TYPE);
+  type->header.headerSize = htods(sizeof(ResTable_type));
+  type->header.size = htodl(chunk_size);
+  type->id = 1;
+  type->entriesStart = htodl(entries_start);
+  if (encoding == TypeEncoding::kSparse) {
+    type->flags = ResTable_type::FLAG_SPARSE;
+    type->entryCount = htodl(present.size());
+  } else {
+    type->flags = encoding == TypeEncoding::kOffset16 ? ResTable_type::FLAG_OFFSET16 : 0;
+    type->entryCount = htodl(entry_count);
+  }
+
+  uint8_t* offsets = data + sizeof(ResTable_type);
+  if (encoding != TypeEncoding::kSparse) {
+    // Both dense encodings mark the missing entries with all bits set.
+    memset(offsets, 0xff, offsets_size);
+  }
+  for (size_t i = 0; i < present.size(); i++) {
+    const uint32_t offset = i * entry_size;
+    switch (encoding) {
+      case TypeEncoding::kDense:
+        reinterpret_cast<uint32_t*>(offsets)[present[i]] = htodl(offset);
+        break;
+      case TypeEncoding::kOffset16:
+        reinterpret_cast<uint16_t*>(offsets)[present[i]] = htods(offset / 4u);
+        break;
+      case TypeEncoding::kSparse: {
+        ResTable_sparseTypeEntry* sparse =
+            reinterpret_cast<ResTable_sparseTypeEntry*>(offsets) + i;
+        sparse->idx = htods(present[i]);
+        sparse->offset = htods(offset / 4u);
+        break;
+      }
+    }
+
+    auto entry = reinterpret_cast<ResTable_entry*>(data + entries_start + offset);
+    entry->full.size = htods(sizeof(ResTable_entry));
+    entry->full.key.index = htodl(present[i]);
+    auto value = reinterpret_cast<Res_value*>(entry + 1);
+    value->size = htods(sizeof(Res_value));
+    value->dataType = Res_value::TYPE_INT_DEC;
+    value->data = htodl(present[i]);
+  }
+  return storage;
+}
+
+// Looks up every entry of a type, present or not, as LoadedPackage does for each configuration
+// of a resource. range(0) is the number of entries, and 100 / range(1) the percentage of them
+// that are present.
+static void BM_TypeEncodingFindEntry(benchmark::State& state, TypeEncoding encoding) {
+  const size_t entry_count = state.range(0);
+  const std::vector<uint32_t> storage = BuildTypeChunk(encoding, entry_count, state.range(1));
+  const incfs::verified_map_ptr<ResTable_type> type =
+      incfs::map_ptr<ResTable_type>(reinterpret_cast<const ResTable_type*>(storage.data()))
+          .verified();
+
+  for (auto&& _ : state) {
+    for (size_t i = 0; i < entry_count; i++) {
+      auto entry = LoadedPackage::GetEntry(type, static_cast<uint16_t>(i));
+      benchmark::DoNotOptimize(entry);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * entry_count);
+}
+
+static void TypeEncodingArgs(benchmark::internal::Benchmark* b) {
+  for (int entry_count : {16, 256, 4096}) {
+    for (int stride : {1, 2, 4, 16}) {
+      b->Args({entry_count, stride});
+    }
+  }
+}
+BENCHMARK_CAPTURE(BM_TypeEncodingFindEntry, Dense, TypeEncoding::kDense)->Apply(TypeEncodingArgs);
+BENCHMARK_CAPTURE(BM_TypeEncodingFindEntry, Offset16, TypeEncoding::kOffset16)
+    ->Apply(TypeEncodingArgs);
+BENCHMARK_CAPTURE(BM_TypeEncodingFindEntry, Sparse, TypeEncoding::kSparse)
+    ->Apply(TypeEncodingArgs);
+
 }  // namespace android
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "androidfw/StreamingZipInflater.h"
+
+#include <zlib.h>
+
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "android-base/file.h"
+#include "gtest/gtest.h"
+
+namespace android {
+
+// Returns `size` bytes that compress, but not trivially.
+static std::string MakeData(size_t size) {
+  std::string data(size, '\0');
+  uint32_t state = 1;
+  for (size_t i = 0; i < size; i++) {
+    state = state * 1103515245 + 12345;
+    data[i] = "abcdefgh"[(state >> 16) % 8];
+  }
+  return data;
+}
+
+// Compresses `data` as a raw deflate stream, like in a zip entry.
+static std::string Deflate(const std::string& data) {
+  z_stream stream{};
+  EXPECT_EQ(Z_OK, deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8,
+                               Z_DEFAULT_STRATEGY));
+  std::string out(deflateBound(&stream, data.size()), '\0');
+  stream.next_in = (Bytef*)data.data();
+  stream.avail_in = data.size();
+  stream.next_out = (Bytef*)out.data();
+  stream.avail_out = out.size();
+  EXPECT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+  out.resize(stream.total_out);
+  deflateEnd(&stream);
+  return out;
+}
+
+TEST(StreamingZipInflaterTest, ReadsInSmallAndLargeChunks) {
+  // Larger than LARGE_ASSET_SIZE once compressed, to use the large input chunks.
+  const std::string data = MakeData(8 * 1024 * 1024);
+  const std::string compressed = Deflate(data);
+  ASSERT_GT(compressed.size(), StreamingZipInflater::LARGE_ASSET_SIZE);
+
+  TemporaryFile file;
+  const std::string prefix = "header";
+  ASSERT_TRUE(base::WriteStringToFd(prefix + compressed, file.fd));
+
+  StreamingZipInflater inflater(file.fd, prefix.size(), data.size(), compressed.size());
+  std::vector<uint8_t> out(data.size());
+  size_t pos = 0;
+  // Alternate between reads smaller and larger than the output chunk size.
+  const size_t sizes[] = {1, 1000, StreamingZipInflater::OUTPUT_CHUNK_SIZE, 3 * 1024 * 1024, 17};
+  for (size_t i = 0; pos < data.size(); i++) {
+    const ssize_t read = inflater.read(out.data() + pos, sizes[i % std::size(sizes)]);
+    ASSERT_GT(read, 0);
+    pos += read;
+  }
+  EXPECT_EQ(data.size(), pos);
+  EXPECT_EQ(0, memcmp(data.data(), out.data(), data.size()));
+  EXPECT_EQ(0, inflater.read(out.data(), 1));
+}
+
+TEST(StreamingZipInflaterTest, SeeksAndReadsWholeRemainder) {
+  const std::string data = MakeData(512 * 1024);
+  const std::string compressed = Deflate(data);
+
+  TemporaryFile file;
+  ASSERT_TRUE(base::WriteStringToFd(compressed, file.fd));
+
+  StreamingZipInflater inflater(file.fd, 0, data.size(), compressed.size());
+  const size_t offset = 100 * 1024 + 7;
+  EXPECT_EQ(offset, inflater.seekAbsolute(offset));
+  std::vector<uint8_t> out(data.size() - offset);
+  EXPECT_EQ((ssize_t)out.size(), inflater.read(out.data(), out.size()));
+  EXPECT_EQ(0, memcmp(data.data() + offset, out.data(), out.size()));
+
+  // Seeking back restarts from the beginning.
+  EXPECT_EQ(0, inflater.seekAbsolute(0));
+  out.resize(data.size());
+  EXPECT_EQ((ssize_t)out.size(), inflater.read(out.data(), out.size()));
+  EXPECT_EQ(0, memcmp(data.data(), out.data(), out.size()));
+}
+
+}  // namespace android
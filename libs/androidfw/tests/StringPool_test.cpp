@@ -253,6 +253,54 @@ TEST(StringPoolTest, FlattenOddCharactersUtf16) {
   EXPECT_THAT(str->data()[1], Eq(0u));
 }
 
+TEST(StringPoolTest, IndexOfStringInUnsortedPools) {
+  using namespace android;  // For NO_ERROR on Windows.
+  NoOpDiagnostics diag;
+
+  StringPool pool;
+  pool.MakeRef("layout");
+  pool.MakeRef("drawable");
+  pool.MakeRef("\u093f");
+  pool.MakeRef("string");
+
+  for (bool utf8 : {true, false}) {
+    BigBuffer buffer(1024);
+    if (utf8) {
+      StringPool::FlattenUtf8(&buffer, pool, &diag);
+    } else {
+      StringPool::FlattenUtf16(&buffer, pool, &diag);
+    }
+    std::unique_ptr<uint8_t[]> data = android::util::Copy(buffer);
+
+    // Without optimized name lookups, absent strings are rejected by the bloom filter; with them,
+    // every lookup uses the complete index.
+    for (bool optimize_name_lookups : {false, true}) {
+      ResStringPool test(optimize_name_lookups);
+      ASSERT_THAT(test.setTo(data.get(), buffer.size()), Eq(NO_ERROR));
+      ASSERT_FALSE(test.isSorted());
+
+      auto index = test.indexOfString(u"drawable", 8);
+      ASSERT_TRUE(index.has_value());
+      EXPECT_THAT(*index, Eq(1u));
+      index = test.indexOfString(u"\u093f", 1);
+      ASSERT_TRUE(index.has_value());
+      EXPECT_THAT(*index, Eq(2u));
+      index = test.indexOfString(u"string", 6);
+      ASSERT_TRUE(index.has_value());
+      EXPECT_THAT(*index, Eq(3u));
+
+      EXPECT_FALSE(test.indexOfString(u"raw", 3).has_value());
+      EXPECT_FALSE(test.indexOfString(u"strin", 5).has_value());
+
+      const ResStringPool::LookupStats stats = test.getLookupStats();
+      EXPECT_THAT(stats.indexedStrings, Eq(4u));
+      if (optimize_name_lookups) {
+        EXPECT_THAT(stats.fastLookups, Eq(5u));
+      }
+    }
+  }
+}
+
 constexpr const char* sLongString =
     "バッテリーを長持ちさせるため、バッテリーセーバーは端末のパフォーマンスを抑"
     "え、バイブレーション、位置情報サービス、大半のバックグラウンドデータを制限"
@@ -327,6 +375,40 @@ TEST(StringPoolTest, Flatten) {
   }
 }
 
+TEST(StringPoolTest, FlattenWritesStringsWithDifferentContextsOnce) {
+  using namespace android;  // For NO_ERROR on Windows.
+  NoOpDiagnostics diag;
+
+  StringPool single_pool;
+  single_pool.MakeRef(sLongString, StringPool::Context(0x81010001));
+
+  StringPool pool;
+  pool.MakeRef(sLongString, StringPool::Context(0x81010001));
+  pool.MakeRef(sLongString, StringPool::Context(0x81010002));
+  ASSERT_THAT(pool.size(), Eq(2u));
+
+  for (bool utf8 : {true, false}) {
+    BigBuffer single_buffer(1024);
+    BigBuffer buffer(1024);
+    if (utf8) {
+      StringPool::FlattenUtf8(&single_buffer, single_pool, &diag);
+      StringPool::FlattenUtf8(&buffer, pool, &diag);
+    } else {
+      StringPool::FlattenUtf16(&single_buffer, single_pool, &diag);
+      StringPool::FlattenUtf16(&buffer, pool, &diag);
+    }
+
+    // Only the index of the second string is added.
+    EXPECT_THAT(buffer.size(), Eq(single_buffer.size() + sizeof(uint32_t)));
+
+    std::unique_ptr<uint8_t[]> data = android::util::Copy(buffer);
+    ResStringPool test;
+    ASSERT_EQ(test.setTo(data.get(), buffer.size()), NO_ERROR);
+    EXPECT_THAT(android::util::GetString(test, 0), Eq(sLongString));
+    EXPECT_THAT(android::util::GetString(test, 1), Eq(sLongString));
+  }
+}
+
 TEST(StringPoolTest, ModifiedUTF8) {
   using namespace android;  // For NO_ERROR on Windows.
   NoOpDiagnostics diag;
@@ -120,6 +120,37 @@ TEST_F(ThemeTest, SingleThemeWithParent) {
   EXPECT_EQ(static_cast<uint32_t>(ResTable_typeSpec::SPEC_PUBLIC), value->flags);
 }
 
+TEST_F(ThemeTest, GetAttributeAtMatchesGetAttribute) {
+  AssetManager2 assetmanager;
+  assetmanager.SetApkAssets({style_assets_});
+
+  std::unique_ptr<Theme> theme = assetmanager.NewTheme();
+  ASSERT_TRUE(theme->ApplyStyle(app::R::style::StyleTwo).has_value());
+
+  const auto ids = theme->GetAttributeIds();
+  ASSERT_FALSE(ids.empty());
+  EXPECT_TRUE(std::is_sorted(ids.begin(), ids.end()));
+  for (size_t i = 0; i < ids.size(); i++) {
+    auto by_id = theme->GetAttribute(ids[i]);
+    auto by_index = theme->GetAttributeAt(i);
+    ASSERT_EQ(by_id.has_value(), by_index.has_value());
+    if (by_id) {
+      EXPECT_EQ(by_id->type, by_index->type);
+      EXPECT_EQ(by_id->data, by_index->data);
+      EXPECT_EQ(by_id->cookie, by_index->cookie);
+      EXPECT_EQ(by_id->flags, by_index->flags);
+    }
+  }
+
+  // attr_three points to attr_indirect, which must be followed by index as well.
+  const auto it = std::lower_bound(ids.begin(), ids.end(), app::R::attr::attr_three);
+  ASSERT_NE(ids.end(), it);
+  auto value = theme->GetAttributeAt(it - ids.begin());
+  ASSERT_TRUE(value);
+  EXPECT_EQ(Res_value::TYPE_INT_DEC, value->type);
+  EXPECT_EQ(3u, value->data);
+}
+
 TEST_F(ThemeTest, TryToUseBadResourceId) {
   AssetManager2 assetmanager;
   assetmanager.SetApkAssets({style_assets_});
@@ -251,6 +282,48 @@ TEST_F(ThemeTest, CopyThemeSameAssetManager) {
   EXPECT_EQ(static_cast<uint32_t>(ResTable_typeSpec::SPEC_PUBLIC), value->flags);
 }
 
+TEST_F(ThemeTest, RestoreThemeFromSnapshot) {
+  AssetManager2 assetmanager;
+  assetmanager.SetApkAssets({style_assets_});
+
+  std::unique_ptr<Theme> theme_one = assetmanager.NewTheme();
+  ASSERT_TRUE(theme_one->ApplyStyle(app::R::style::StyleTwo).has_value());
+  const std::vector<uint8_t> snapshot = theme_one->WriteSnapshot();
+
+  // Another AssetManager with the same state can use the snapshot.
+  AssetManager2 other_assetmanager;
+  other_assetmanager.SetApkAssets({style_assets_});
+  std::unique_ptr<Theme> theme_two = other_assetmanager.NewTheme();
+  ASSERT_TRUE(theme_two->SetToSnapshot(snapshot));
+
+  const auto ids = theme_one->GetAttributeIds();
+  ASSERT_TRUE(std::equal(ids.begin(), ids.end(), theme_two->GetAttributeIds().begin(),
+                         theme_two->GetAttributeIds().end()));
+  EXPECT_EQ(theme_one->GetChangingConfigurations(), theme_two->GetChangingConfigurations());
+  for (size_t i = 0; i < ids.size(); i++) {
+    auto expected = theme_one->GetAttributeAt(i);
+    auto actual = theme_two->GetAttributeAt(i);
+    ASSERT_EQ(expected.has_value(), actual.has_value());
+    if (expected) {
+      EXPECT_EQ(expected->type, actual->type);
+      EXPECT_EQ(expected->data, actual->data);
+      EXPECT_EQ(expected->cookie, actual->cookie);
+    }
+  }
+
+  // Truncated snapshots are rejected.
+  EXPECT_FALSE(theme_two->SetToSnapshot(std::span(snapshot).first(snapshot.size() - 1)));
+
+  // The snapshot is stale once the configurations change, and the theme stays untouched.
+  ResTable_config night{};
+  night.uiMode = ResTable_config::UI_MODE_NIGHT_YES;
+  night.version = 8u;
+  other_assetmanager.SetConfigurations({night});
+  theme_two->Clear();
+  EXPECT_FALSE(theme_two->SetToSnapshot(snapshot));
+  EXPECT_TRUE(theme_two->GetAttributeIds().empty());
+}
+
 TEST_F(ThemeTest, ThemeRebase) {
   AssetManager2 am;
   am.SetApkAssets({style_assets_});
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "androidfw/ZipArchiveCache.h"
+
+#include <fcntl.h>
+
+#include "TestHelpers.h"
+#include "ziparchive/zip_archive.h"
+
+using ::testing::IsNull;
+using ::testing::NotNull;
+
+namespace android {
+
+TEST(ZipArchiveCacheTest, SharesOpenArchives) {
+  const std::string path = GetTestDataPath() + "/basic/basic.apk";
+  const auto before = ZipArchiveCache::GetStats();
+
+  int32_t error;
+  auto first = ZipArchiveCache::Open(path.c_str(), &error);
+  ASSERT_THAT(first, NotNull());
+  auto second = ZipArchiveCache::Open(path.c_str(), &error);
+  ASSERT_THAT(second, NotNull());
+  EXPECT_EQ(first.get(), second.get());
+
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  ASSERT_GE(fd, 0);
+  auto third = ZipArchiveCache::OpenFd(fd, path.c_str(), true /* assume_ownership */, &error);
+  EXPECT_EQ(first.get(), third.get());
+
+  const auto stats = ZipArchiveCache::GetStats();
+  EXPECT_EQ(before.hits + 2, stats.hits);
+  EXPECT_EQ(before.misses + 1, stats.misses);
+  EXPECT_GT(stats.archive_bytes, before.archive_bytes);
+
+  ZipEntry entry;
+  EXPECT_EQ(0, FindEntry(second.get(), "resources.arsc", &entry));
+}
+
+TEST(ZipArchiveCacheTest, ClosesArchiveWithLastReference) {
+  const std::string path = GetTestDataPath() + "/basic/basic.apk";
+  int32_t error;
+  auto archive = ZipArchiveCache::Open(path.c_str(), &error);
+  ASSERT_THAT(archive, NotNull());
+  const auto open_stats = ZipArchiveCache::GetStats();
+
+  archive.reset();
+  const auto closed_stats = ZipArchiveCache::GetStats();
+  EXPECT_EQ(open_stats.archives - 1, closed_stats.archives);
+  EXPECT_LT(closed_stats.archive_bytes, open_stats.archive_bytes);
+
+  const auto misses = closed_stats.misses;
+  archive = ZipArchiveCache::Open(path.c_str(), &error);
+  ASSERT_THAT(archive, NotNull());
+  EXPECT_EQ(misses + 1, ZipArchiveCache::GetStats().misses);
+}
+
+TEST(ZipArchiveCacheTest, KeepsUnownedFdsOpen) {
+  const std::string path = GetTestDataPath() + "/basic/basic.apk";
+  int32_t error;
+  auto shared = ZipArchiveCache::Open(path.c_str(), &error);
+  ASSERT_THAT(shared, NotNull());
+
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  ASSERT_GE(fd, 0);
+  auto unowned = ZipArchiveCache::OpenFd(fd, path.c_str(), false /* assume_ownership */, &error);
+  EXPECT_EQ(shared.get(), unowned.get());
+  EXPECT_NE(-1, fcntl(fd, F_GETFD));
+  close(fd);
+}
+
+TEST(ZipArchiveCacheTest, ReportsErrors) {
+  int32_t error = 0;
+  EXPECT_THAT(ZipArchiveCache::Open("/does/not/exist.apk", &error), IsNull());
+  EXPECT_NE(0, error);
+}
+
+}  // namespace android
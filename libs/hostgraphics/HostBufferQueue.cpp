@@ -17,19 +17,74 @@
 #include <gui/BufferQueue.h>
 #include <system/window.h>
 
+#include <mutex>
+#include <vector>
+
 namespace android {
 
+// Host rendering tools create a short-lived queue for every layout they render, nearly always at
+// the same few sizes. Keep a handful of released buffers around so that a new queue can reuse
+// one instead of allocating a fresh one each time. May be used from many threads.
+class HostBufferPool {
+public:
+    static sp<GraphicBuffer> obtain(uint32_t w, uint32_t h) {
+        sp<GraphicBuffer> buffer;
+        {
+            std::lock_guard lock(sMutex);
+            auto& buffers = pool();
+            for (auto it = buffers.begin(); it != buffers.end(); ++it) {
+                // A buffer only held by the pool is no longer used by any queue or consumer.
+                if ((*it)->getStrongCount() == 1) {
+                    buffer = std::move(*it);
+                    buffers.erase(it);
+                    break;
+                }
+            }
+        }
+        if (buffer == nullptr) {
+            return sp<GraphicBuffer>(new GraphicBuffer(w, h));
+        }
+        // The previous render must not show through, and the buffer may have had another size.
+        buffer->reset(w, h);
+        return buffer;
+    }
+
+    static void recycle(sp<GraphicBuffer>&& buffer) {
+        if (buffer == nullptr) {
+            return;
+        }
+        std::lock_guard lock(sMutex);
+        auto& buffers = pool();
+        if (buffers.size() >= kMaxPooledBuffers) {
+            buffers.erase(buffers.begin());
+        }
+        buffers.push_back(std::move(buffer));
+    }
+
+private:
+    static constexpr size_t kMaxPooledBuffers = 4;
+
+    static std::vector<sp<GraphicBuffer>>& pool() {
+        static std::vector<sp<GraphicBuffer>>* buffers = new std::vector<sp<GraphicBuffer>>();
+        return *buffers;
+    }
+
+    static inline std::mutex sMutex;
+};
+
 class HostBufferQueue : public IGraphicBufferProducer, public IGraphicBufferConsumer {
 public:
     HostBufferQueue() : mWidth(0), mHeight(0) {}
 
+    virtual ~HostBufferQueue() { HostBufferPool::recycle(std::move(mBuffer)); }
+
     // Consumer
     virtual status_t setConsumerIsProtected(bool isProtected) {
         return OK;
     }
 
     virtual status_t detachBuffer(int slot) {
-        mBuffer.clear();
+        HostBufferPool::recycle(std::move(mBuffer));
         return OK;
     }
 
@@ -38,9 +93,13 @@ public:
     }
 
     virtual status_t setDefaultBufferSize(uint32_t w, uint32_t h) {
+        if (mBuffer != nullptr && mBuffer->getWidth() == w && mBuffer->getHeight() == h) {
+            return OK;
+        }
         mWidth = w;
         mHeight = h;
-        mBuffer = sp<GraphicBuffer>(new GraphicBuffer(mWidth, mHeight));
+        HostBufferPool::recycle(std::move(mBuffer));
+        mBuffer = HostBufferPool::obtain(mWidth, mHeight);
         return OK;
     }
 
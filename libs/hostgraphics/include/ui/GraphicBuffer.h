@@ -30,8 +30,11 @@ namespace android {
 
 class GraphicBuffer : public ANativeObjectBase<ANativeWindowBuffer, GraphicBuffer, RefBase> {
 public:
-    GraphicBuffer(uint32_t w, uint32_t h) {
-        data.resize(w * h);
+    GraphicBuffer(uint32_t w, uint32_t h) { reset(w, h); }
+
+    // Resizes the buffer to w x h and clears it, as if it had just been created.
+    void reset(uint32_t w, uint32_t h) {
+        data.assign(w * h, 0);
         reserved[0] = data.data();
         width = w;
         height = h;
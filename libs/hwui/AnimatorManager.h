@@ -62,7 +62,8 @@ public:
     // the ActivityContext is being destroyed
     void endAllActiveAnimators();
 
-    bool hasAnimators() { return mAnimators.size(); }
+    bool hasAnimators() const { return mAnimators.size(); }
+    bool hasStagingAnimators() const { return mNewAnimators.size(); }
 
 private:
     uint32_t animateCommon(TreeInfo& info);
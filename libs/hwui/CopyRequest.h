@@ -16,6 +16,11 @@
 
 #pragma once
 
+#include <SkImage.h>
+#include <SkImageInfo.h>
+
+#include <optional>
+
 #include "Rect.h"
 #include "hwui/Bitmap.h"
 
@@ -37,6 +42,23 @@ struct CopyRequest {
     virtual ~CopyRequest() {}
     virtual SkBitmap getDestinationBitmap(int srcWidth, int srcHeight) = 0;
     virtual void onCopyFinished(CopyResult result) = 0;
+
+    /**
+     * Whether the RenderThread can go on without waiting for the GPU to finish the copy. The
+     * pixels are then read back through a GPU transfer buffer, and onCopyFinished() is called on
+     * the RenderThread once the transfer completed. For continuous readback, like screen
+     * recording, which would otherwise stall the RenderThread every time.
+     */
+    virtual bool isAsync() const { return getYuvColorSpace().has_value(); }
+
+    /**
+     * Requests that want the copy as YUV 4:2:0 planes return their color space. The copy is
+     * converted on the GPU and read back asynchronously, then handed to onYuvCopyFinished()
+     * before onCopyFinished(). Only the dimensions of the destination bitmap are used, it
+     * doesn't need any pixels.
+     */
+    virtual std::optional<SkYUVColorSpace> getYuvColorSpace() const { return std::nullopt; }
+    virtual void onYuvCopyFinished(const SkImage::AsyncReadResult& planes) {}
 };
 
 }  // namespace android::uirenderer
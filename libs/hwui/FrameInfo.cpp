@@ -55,6 +55,8 @@ static_assert(static_cast<int>(FrameInfoIndex::NumIndexes) == 24,
 void FrameInfo::importUiThreadInfo(const int64_t* info) {
     memcpy(mFrameInfo.data(), info, UI_THREAD_FRAME_INFO_SIZE * sizeof(int64_t));
     mSkippedFrameReason.reset();
+    mSyncWaitDuration = 0;
+    mUiThreadUnblocked = 0;
 }
 
 const char* toString(SkippedFrameReason reason) {
@@ -148,6 +148,15 @@ public:
         set(FrameInfoIndex::SwapBuffersCompleted) = systemTime(SYSTEM_TIME_MONOTONIC);
     }
 
+    // How long the UI thread waited for the sync of the previous frame before it could queue
+    // this one, in pipelined mode.
+    void setSyncWaitDuration(nsecs_t duration) { mSyncWaitDuration = duration; }
+    nsecs_t syncWaitDuration() const { return mSyncWaitDuration; }
+
+    // When the UI thread was released after the sync of this frame.
+    void markUiThreadUnblocked() { mUiThreadUnblocked = systemTime(SYSTEM_TIME_MONOTONIC); }
+    nsecs_t uiThreadUnblocked() const { return mUiThreadUnblocked; }
+
     void markFrameCompleted() { set(FrameInfoIndex::FrameCompleted) = systemTime(SYSTEM_TIME_MONOTONIC); }
 
     void addFlag(int frameInfoFlag) {
@@ -205,6 +214,9 @@ public:
 private:
     FrameInfoBuffer mFrameInfo;
     std::optional<SkippedFrameReason> mSkippedFrameReason;
+    // Kept out of mFrameInfo, whose layout is shared with FrameMetrics.java.
+    nsecs_t mSyncWaitDuration = 0;
+    nsecs_t mUiThreadUnblocked = 0;
 };
 
 } /* namespace uirenderer */
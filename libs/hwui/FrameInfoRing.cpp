@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameInfoRing.h"
+
+#include <cutils/ashmem.h>
+#include <errno.h>
+#include <log/log.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <new>
+
+#include "Properties.h"
+
+namespace android {
+namespace uirenderer {
+
+static_assert(sizeof(FrameInfoRing::Header) == 32, "The layout of the ring is stable");
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+static constexpr uint32_t kFrameInfoSize = static_cast<uint32_t>(FrameInfoIndex::NumIndexes);
+
+static std::atomic<uint64_t>* slotSequence(void* slot) {
+    return reinterpret_cast<std::atomic<uint64_t>*>(slot);
+}
+
+FrameInfoRing* FrameInfoRing::get() {
+    static FrameInfoRing* sRing = []() -> FrameInfoRing* {
+        if (Properties::frameInfoRingSize <= 0) {
+            return nullptr;
+        }
+        return create(Properties::frameInfoRingSize).release();
+    }();
+    return sRing;
+}
+
+std::unique_ptr<FrameInfoRing> FrameInfoRing::create(uint32_t slotCount) {
+    LOG_ALWAYS_FATAL_IF(slotCount == 0, "A frame info ring needs slots");
+    const size_t size = sizeof(Header) + slotCount * slotSize(kFrameInfoSize);
+    int fd = ashmem_create_region("hwui-frame-info-ring", size);
+    if (fd < 0) {
+        ALOGW("Failed to create the frame info ring, error = %d", errno);
+        return nullptr;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        ALOGW("Failed to map the frame info ring, error = %d", errno);
+        close(fd);
+        return nullptr;
+    }
+    // Later mappings, such as those of profilers, are read-only.
+    if (ashmem_set_prot_region(fd, PROT_READ) < 0) {
+        ALOGW("Failed to make the frame info ring read-only, error = %d", errno);
+        munmap(mapping, size);
+        close(fd);
+        return nullptr;
+    }
+    return std::unique_ptr<FrameInfoRing>(new FrameInfoRing(fd, size, mapping, slotCount));
+}
+
+FrameInfoRing::FrameInfoRing(int fd, size_t size, void* mapping, uint32_t slotCount)
+        : mFd(fd), mSize(size), mHeader(new (mapping) Header()) {
+    mHeader->magic = kMagic;
+    mHeader->version = kVersion;
+    mHeader->slotCount = slotCount;
+    mHeader->frameInfoSize = kFrameInfoSize;
+    mHeader->framesWritten.store(0, std::memory_order_release);
+}
+
+FrameInfoRing::~FrameInfoRing() {
+    munmap(mHeader, mSize);
+    close(mFd);
+}
+
+void FrameInfoRing::append(const FrameInfo& frame) {
+    std::lock_guard lock(mWriteLock);
+    const uint64_t n = mHeader->framesWritten.load(std::memory_order_relaxed);
+    uint8_t* slot = reinterpret_cast<uint8_t*>(mHeader + 1) +
+                    (n % mHeader->slotCount) * slotSize(kFrameInfoSize);
+    std::atomic<uint64_t>* sequence = slotSequence(slot);
+
+    sequence->store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(slot + sizeof(uint64_t), frame.data().data(), kFrameInfoSize * sizeof(int64_t));
+    sequence->store(2 * n + 2, std::memory_order_release);
+    mHeader->framesWritten.store(n + 1, std::memory_order_release);
+}
+
+bool FrameInfoRing::readFrame(const void* mapping, size_t mappingSize, uint64_t frame,
+                              FrameInfoBuffer* outFrameInfo) {
+    if (mappingSize < sizeof(Header)) {
+        return false;
+    }
+    const Header* header = reinterpret_cast<const Header*>(mapping);
+    if (header->magic != kMagic || header->version != kVersion || header->slotCount == 0 ||
+        mappingSize < sizeof(Header) + header->slotCount * slotSize(header->frameInfoSize)) {
+        return false;
+    }
+    const uint8_t* slot = reinterpret_cast<const uint8_t*>(header + 1) +
+                          (frame % header->slotCount) * slotSize(header->frameInfoSize);
+    std::atomic<uint64_t>* sequence = slotSequence(const_cast<uint8_t*>(slot));
+
+    const uint64_t expected = 2 * frame + 2;
+    if (sequence->load(std::memory_order_acquire) != expected) {
+        return false;
+    }
+    // Frames of later versions of FrameInfoIndex are truncated, those of earlier ones padded.
+    outFrameInfo->fill(0);
+    const size_t count = std::min<size_t>(header->frameInfoSize, outFrameInfo->size());
+    memcpy(outFrameInfo->data(), slot + sizeof(uint64_t), count * sizeof(int64_t));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequence->load(std::memory_order_relaxed) == expected;
+}
+
+} /* namespace uirenderer */
+} /* namespace android */
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "FrameInfo.h"
+
+namespace android {
+namespace uirenderer {
+
+/**
+ * A ring of the FrameInfo of the last frames finished by the process, in shared memory, so that
+ * profilers can read recent frames without parsing dumpsys output or registering FrameMetrics
+ * listeners. Enabled with PROPERTY_FRAME_INFO_RING_SIZE.
+ *
+ * The ring is an ashmem region that other mappings can only read, with a stable layout of
+ * native-endian fields:
+ *
+ * - A Header, see below.
+ * - slotCount slots of (1 + frameInfoSize) * 8 bytes: a uint64_t sequence followed by the
+ *   frameInfoSize int64_t values of the frame, indexed by FrameInfoIndex.
+ *
+ * Frame n, counting from 0, is written to slot n % slotCount. While it's written the sequence of
+ * the slot is 2n + 1 and afterwards 2n + 2, then framesWritten becomes n + 1. Readers never lock:
+ * they copy the slot and check that its sequence was 2n + 2 before and after, see readFrame().
+ */
+class FrameInfoRing {
+public:
+    static constexpr uint32_t kMagic = 0x49465748;  // "HWFI"
+    static constexpr uint32_t kVersion = 1;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slotCount;
+        uint32_t frameInfoSize;
+        std::atomic<uint64_t> framesWritten;
+        uint64_t reserved;
+    };
+
+    /**
+     * Returns the ring of the process, or nullptr if it's disabled or couldn't be created.
+     */
+    static FrameInfoRing* get();
+
+    /**
+     * Creates a ring of its own, get() should be used instead outside of tests.
+     */
+    static std::unique_ptr<FrameInfoRing> create(uint32_t slotCount);
+    ~FrameInfoRing();
+
+    void append(const FrameInfo& frame);
+
+    /**
+     * The ashmem region holding the ring, for a profiler to map read-only.
+     */
+    int fd() const { return mFd; }
+    size_t size() const { return mSize; }
+
+    /**
+     * Copies frame n out of a mapping of a ring. Returns false if the mapping isn't a ring of
+     * this version, or if frame n was overwritten or not written yet.
+     */
+    static bool readFrame(const void* mapping, size_t mappingSize, uint64_t frame,
+                          FrameInfoBuffer* outFrameInfo);
+
+private:
+    FrameInfoRing(int fd, size_t size, void* mapping, uint32_t slotCount);
+
+    static constexpr size_t slotSize(uint32_t frameInfoSize) {
+        return (1 + frameInfoSize) * sizeof(int64_t);
+    }
+
+    const int mFd;
+    const size_t mSize;
+    Header* const mHeader;
+
+    // Finished frames are reported both on the RenderThread and by the callbacks of the surface
+    // stats, so writers take turns. Readers never take the lock.
+    std::mutex mWriteLock;
+};
+
+} /* namespace uirenderer */
+} /* namespace android */
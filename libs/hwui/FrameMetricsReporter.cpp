@@ -23,35 +23,30 @@ namespace uirenderer {
 
 void FrameMetricsReporter::reportFrameMetrics(const FrameInfoBuffer& stats, bool hasPresentTime,
                                               uint64_t frameNumber, int32_t surfaceControlId) {
-    FatVector<sp<FrameMetricsObserver>, 10> copy;
+    std::shared_ptr<const ObserverList> observers;
     {
         std::lock_guard lock(mObserversLock);
-        copy.reserve(mObservers.size());
-        for (size_t i = 0; i < mObservers.size(); i++) {
-            auto observer = mObservers[i];
-
-            if (CC_UNLIKELY(surfaceControlId < observer->attachedSurfaceControlId())) {
-                // Don't notify if the metrics are from a frame that was run on an old
-                // surface (one from before the observer was attached).
-                ALOGV("skipped reporting metrics from old surface %d", surfaceControlId);
-                continue;
-            } else if (CC_UNLIKELY(surfaceControlId == observer->attachedSurfaceControlId() &&
-                                   frameNumber < observer->attachedFrameNumber())) {
-                // Don't notify if the metrics are from a frame that was queued by the
-                // BufferQueueProducer on the render thread before the observer was attached.
-                ALOGV("skipped reporting metrics from old frame %ld", (long)frameNumber);
-                continue;
-            }
+        observers = mObservers;
+    }
+    for (const sp<FrameMetricsObserver>& observer : *observers) {
+        if (CC_UNLIKELY(surfaceControlId < observer->attachedSurfaceControlId())) {
+            // Don't notify if the metrics are from a frame that was run on an old
+            // surface (one from before the observer was attached).
+            ALOGV("skipped reporting metrics from old surface %d", surfaceControlId);
+            continue;
+        } else if (CC_UNLIKELY(surfaceControlId == observer->attachedSurfaceControlId() &&
+                               frameNumber < observer->attachedFrameNumber())) {
+            // Don't notify if the metrics are from a frame that was queued by the
+            // BufferQueueProducer on the render thread before the observer was attached.
+            ALOGV("skipped reporting metrics from old frame %ld", (long)frameNumber);
+            continue;
+        }
 
-            const bool wantsPresentTime = observer->waitForPresentTime();
-            if (hasPresentTime == wantsPresentTime) {
-                copy.push_back(observer);
-            }
+        const bool wantsPresentTime = observer->waitForPresentTime();
+        if (hasPresentTime == wantsPresentTime) {
+            observer->notify(stats);
         }
     }
-    for (size_t i = 0; i < copy.size(); i++) {
-        copy[i]->notify(stats);
-    }
 }
 
 }  // namespace uirenderer
@@ -20,31 +20,42 @@
 #include <utils/Log.h>
 #include <utils/RefBase.h>
 
-#include <ui/FatVector.h>
-
 #include "FrameInfo.h"
 #include "FrameMetricsObserver.h"
 
 #include <string.h>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace android {
 namespace uirenderer {
 
+/**
+ * Fans the metrics of each frame out to the observers of a CanvasContext.
+ *
+ * The observers are kept in an immutable list that addObserver() and removeObserver() replace,
+ * so that reportFrameMetrics() only holds the lock to take a reference to the current list, and
+ * neither waits for registrations nor keeps them waiting while observers are notified.
+ */
 class FrameMetricsReporter {
 public:
     FrameMetricsReporter() {}
 
     void addObserver(sp<FrameMetricsObserver>&& observer) {
         std::lock_guard lock(mObserversLock);
-        mObservers.push_back(std::move(observer));
+        auto observers = std::make_shared<ObserverList>(*mObservers);
+        observers->push_back(std::move(observer));
+        mObservers = std::move(observers);
     }
 
     bool removeObserver(const sp<FrameMetricsObserver>& observer) {
         std::lock_guard lock(mObserversLock);
-        for (size_t i = 0; i < mObservers.size(); i++) {
-            if (mObservers[i].get() == observer) {
-                mObservers.erase(mObservers.begin() + i);
+        for (size_t i = 0; i < mObservers->size(); i++) {
+            if ((*mObservers)[i].get() == observer) {
+                auto observers = std::make_shared<ObserverList>(*mObservers);
+                observers->erase(observers->begin() + i);
+                mObservers = std::move(observers);
                 return true;
             }
         }
@@ -53,7 +64,7 @@ public:
 
     bool hasObservers() {
         std::lock_guard lock(mObserversLock);
-        return mObservers.size() > 0;
+        return mObservers->size() > 0;
     }
 
     /**
@@ -73,7 +84,10 @@ public:
                             int32_t surfaceControlId);
 
 private:
-    FatVector<sp<FrameMetricsObserver>, 10> mObservers GUARDED_BY(mObserversLock);
+    using ObserverList = std::vector<sp<FrameMetricsObserver>>;
+
+    std::shared_ptr<const ObserverList> mObservers GUARDED_BY(mObserversLock) =
+            std::make_shared<const ObserverList>();
     std::mutex mObserversLock;
 };
 
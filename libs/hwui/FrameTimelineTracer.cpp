@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameTimelineTracer.h"
+
+#include <cutils/trace.h>
+#include <utils/Timers.h>
+
+#include <cstring>
+
+#include "Properties.h"
+#include "RecordingCanvas.h"
+#include "perfetto/public/te_category_macros.h"
+#include "perfetto/public/te_macros.h"
+#include "perfetto/public/track_event.h"
+#include "tracing_perfetto.h"
+
+#ifdef __ANDROID__
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#include "pipeline/skia/ShaderCache.h"
+#endif
+
+namespace android {
+namespace uirenderer {
+
+namespace {
+
+constexpr const char* kTrackName = "HWUI frame timeline";
+
+PerfettoTeCategory* timelineCategory() {
+    if (!tracing_perfetto::isTagEnabled(ATRACE_TAG_VIEW)) {
+        return nullptr;
+    }
+    return tracing_perfetto::getPerfettoCategory(ATRACE_TAG_VIEW);
+}
+
+void getShaderCacheCounters(uint64_t* hits, uint64_t* misses) {
+#ifdef __ANDROID__
+    const auto counters = skiapipeline::ShaderCache::get().getLoadCounters();
+    *hits = counters.hits;
+    *misses = counters.misses;
+#else
+    *hits = 0;
+    *misses = 0;
+#endif
+}
+
+}  // namespace
+
+#define TIMELINE_TRACK PERFETTO_TE_NAMED_TRACK(kTrackName, 0, PerfettoTeProcessTrackUuid())
+#define FRAME_STAGE_ARG(index) PERFETTO_TE_ARG_INT64(#index, frame[FrameInfoIndex::index])
+
+void FrameTimelineTracer::traceFrame(const FrameInfo& frame, int64_t frameNumber) {
+    PerfettoTeCategory* category = timelineCategory();
+    if (!category) {
+        return;
+    }
+    static_assert(static_cast<int>(FrameInfoIndex::NumIndexes) == 24,
+                  "New FrameInfoIndex values must be added to the HWUI frame event");
+    PERFETTO_TE(*category, PERFETTO_TE_INSTANT("HWUI frame"), TIMELINE_TRACK,
+                PERFETTO_TE_ARG_INT64("frame_number", frameNumber),
+                PERFETTO_TE_ARG_INT64("vsync_id", frame[FrameInfoIndex::FrameTimelineVsyncId]),
+                FRAME_STAGE_ARG(Flags), FRAME_STAGE_ARG(IntendedVsync), FRAME_STAGE_ARG(Vsync),
+                FRAME_STAGE_ARG(InputEventId), FRAME_STAGE_ARG(HandleInputStart),
+                FRAME_STAGE_ARG(AnimationStart), FRAME_STAGE_ARG(PerformTraversalsStart),
+                FRAME_STAGE_ARG(DrawStart), FRAME_STAGE_ARG(FrameDeadline),
+                FRAME_STAGE_ARG(FrameStartTime), FRAME_STAGE_ARG(FrameInterval),
+                FRAME_STAGE_ARG(WorkloadTarget), FRAME_STAGE_ARG(SyncQueued),
+                FRAME_STAGE_ARG(SyncStart), FRAME_STAGE_ARG(IssueDrawCommandsStart),
+                FRAME_STAGE_ARG(SwapBuffers), FRAME_STAGE_ARG(FrameCompleted),
+                FRAME_STAGE_ARG(DequeueBufferDuration), FRAME_STAGE_ARG(QueueBufferDuration),
+                FRAME_STAGE_ARG(GpuCompleted), FRAME_STAGE_ARG(SwapBuffersCompleted),
+                FRAME_STAGE_ARG(DisplayPresentTime), FRAME_STAGE_ARG(CommandSubmissionCompleted),
+                PERFETTO_TE_ARG_INT64("SyncWaitDuration", frame.syncWaitDuration()),
+                PERFETTO_TE_ARG_INT64("UiThreadUnblocked", frame.uiThreadUnblocked()));
+}
+
+FrameTimelineTracer::~FrameTimelineTracer() {
+    deleteQueries();
+}
+
+void FrameTimelineTracer::beginDraw() {
+    mReplayedOpsStart = DisplayListData::getReplayedOpCount();
+    getShaderCacheCounters(&mShaderCacheHitsStart, &mShaderCacheMissesStart);
+    if (!useTimerQueries()) {
+        return;
+    }
+#ifdef __ANDROID__
+    pollQueries();
+    if (mPendingQueries.size() < kMaxPendingQueries) {
+        glGenQueriesEXT(1, &mPendingBegin);
+        glQueryCounterEXT(mPendingBegin, GL_TIMESTAMP_EXT);
+    }
+#endif
+}
+
+void FrameTimelineTracer::endDraw(int64_t vsyncId) {
+#ifdef __ANDROID__
+    if (mPendingBegin && mQueryContext == eglGetCurrentContext()) {
+        GpuQuery query{.begin = mPendingBegin, .vsyncId = vsyncId};
+        glGenQueriesEXT(1, &query.end);
+        glQueryCounterEXT(query.end, GL_TIMESTAMP_EXT);
+        mPendingQueries.push_back(query);
+    }
+    mPendingBegin = 0;
+#endif
+
+    const uint64_t preparedNodes = mPreparedNodes;
+    mPreparedNodes = 0;
+    PerfettoTeCategory* category = timelineCategory();
+    if (!category) {
+        return;
+    }
+    uint64_t shaderCacheHits;
+    uint64_t shaderCacheMisses;
+    getShaderCacheCounters(&shaderCacheHits, &shaderCacheMisses);
+    PERFETTO_TE(*category, PERFETTO_TE_INSTANT("HWUI draw"), TIMELINE_TRACK,
+                PERFETTO_TE_ARG_INT64("vsync_id", vsyncId),
+                PERFETTO_TE_ARG_UINT64("prepared_nodes", preparedNodes),
+                PERFETTO_TE_ARG_UINT64("replayed_ops",
+                                       DisplayListData::getReplayedOpCount() - mReplayedOpsStart),
+                PERFETTO_TE_ARG_UINT64("shader_cache_hits",
+                                       shaderCacheHits - mShaderCacheHitsStart),
+                PERFETTO_TE_ARG_UINT64("shader_cache_misses",
+                                       shaderCacheMisses - mShaderCacheMissesStart));
+}
+
+bool FrameTimelineTracer::useTimerQueries() {
+#ifdef __ANDROID__
+    if (Properties::getRenderPipelineType() != RenderPipelineType::SkiaGL ||
+        !timelineCategory()) {
+        return false;
+    }
+    EGLContext context = eglGetCurrentContext();
+    if (context == EGL_NO_CONTEXT) {
+        return false;
+    }
+    if (context != mQueryContext) {
+        // The queries of the previous context were deleted along with it.
+        mPendingQueries.clear();
+        mPendingBegin = 0;
+        mQueryContext = context;
+        auto* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+        mHasTimerQueries = extensions && strstr(extensions, "GL_EXT_disjoint_timer_query");
+    }
+    return mHasTimerQueries;
+#else
+    return false;
+#endif
+}
+
+void FrameTimelineTracer::pollQueries() {
+#ifdef __ANDROID__
+    // Reading GL_GPU_DISJOINT_EXT also resets it, a disjoint operation invalidates the results of
+    // all the queries that are in flight.
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint) {
+        deleteQueries();
+        return;
+    }
+
+    GLint64 gpuNow = 0;
+    glGetInteger64vEXT(GL_TIMESTAMP_EXT, &gpuNow);
+    const nsecs_t cpuNow = systemTime(SYSTEM_TIME_MONOTONIC);
+    PerfettoTeCategory* category = timelineCategory();
+    while (!mPendingQueries.empty()) {
+        const GpuQuery& query = mPendingQueries.front();
+        GLuint available = 0;
+        glGetQueryObjectuivEXT(query.end, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        if (!available) {
+            // Queries complete in order.
+            break;
+        }
+        GLuint64 gpuStart = 0;
+        GLuint64 gpuEnd = 0;
+        glGetQueryObjectui64vEXT(query.begin, GL_QUERY_RESULT_EXT, &gpuStart);
+        glGetQueryObjectui64vEXT(query.end, GL_QUERY_RESULT_EXT, &gpuEnd);
+        if (category && gpuNow) {
+            const int64_t start = cpuNow - (gpuNow - static_cast<int64_t>(gpuStart));
+            const int64_t end = cpuNow - (gpuNow - static_cast<int64_t>(gpuEnd));
+            PERFETTO_TE(*category, PERFETTO_TE_INSTANT("HWUI GPU"), TIMELINE_TRACK,
+                        PERFETTO_TE_ARG_INT64("vsync_id", query.vsyncId),
+                        PERFETTO_TE_ARG_INT64("gpu_start", start),
+                        PERFETTO_TE_ARG_INT64("gpu_end", end),
+                        PERFETTO_TE_ARG_INT64("gpu_duration", end - start));
+        }
+        const GLuint ids[] = {query.begin, query.end};
+        glDeleteQueriesEXT(2, ids);
+        mPendingQueries.pop_front();
+    }
+#endif
+}
+
+void FrameTimelineTracer::deleteQueries() {
+#ifdef __ANDROID__
+    if (mQueryContext && mQueryContext == eglGetCurrentContext()) {
+        for (const GpuQuery& query : mPendingQueries) {
+            const GLuint ids[] = {query.begin, query.end};
+            glDeleteQueriesEXT(2, ids);
+        }
+        if (mPendingBegin) {
+            glDeleteQueriesEXT(1, &mPendingBegin);
+        }
+    }
+#endif
+    mPendingQueries.clear();
+    mPendingBegin = 0;
+}
+
+} /* namespace uirenderer */
+} /* namespace android */
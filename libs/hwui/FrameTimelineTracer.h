@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <deque>
+
+#include "FrameInfo.h"
+
+namespace android {
+namespace uirenderer {
+
+/**
+ * Emits the frame timeline of a CanvasContext as Perfetto track events, so that traces can
+ * attribute jank to a stage of the frame without parsing atrace slices:
+ *
+ * - "HWUI frame": every FrameInfoIndex of a finished frame, as an argument named after the index.
+ * - "HWUI draw": the number of render nodes prepared and display list ops replayed for a frame,
+ *   along with the hits and misses of the shader cache.
+ * - "HWUI GPU": the GPU start and end of the draw of a frame, measured with timer queries and
+ *   converted to CLOCK_MONOTONIC. Only emitted by the GL pipeline, when the driver supports
+ *   GL_EXT_disjoint_timer_query. The results are read a few frames later, so that the RenderThread
+ *   never waits for the GPU.
+ *
+ * All events are on the "HWUI frame timeline" track of the process, in the view category, and
+ * are joined by their vsync_id argument.
+ *
+ * Apart from traceFrame(), all methods must be called on the RenderThread.
+ */
+class FrameTimelineTracer {
+public:
+    FrameTimelineTracer() = default;
+    ~FrameTimelineTracer();
+
+    FrameTimelineTracer(const FrameTimelineTracer&) = delete;
+    FrameTimelineTracer& operator=(const FrameTimelineTracer&) = delete;
+
+    static void traceFrame(const FrameInfo& frame, int64_t frameNumber);
+
+    void setPreparedNodes(uint64_t preparedNodes) { mPreparedNodes = preparedNodes; }
+
+    /**
+     * Called around IRenderPipeline::draw() with the context of the pipeline current.
+     */
+    void beginDraw();
+    void endDraw(int64_t vsyncId);
+
+private:
+    struct GpuQuery {
+        uint32_t begin;
+        uint32_t end;
+        int64_t vsyncId;
+    };
+
+    // Queries are dropped rather than waited on if the GPU is this many frames behind.
+    static constexpr size_t kMaxPendingQueries = 8;
+
+    bool useTimerQueries();
+    // Emits the queries whose results are available, oldest first.
+    void pollQueries();
+    void deleteQueries();
+
+    uint64_t mPreparedNodes = 0;
+    uint64_t mReplayedOpsStart = 0;
+    uint64_t mShaderCacheHitsStart = 0;
+    uint64_t mShaderCacheMissesStart = 0;
+
+    // The EGL context that owns the queries, they are lost when it is destroyed.
+    void* mQueryContext = nullptr;
+    bool mHasTimerQueries = false;
+    uint32_t mPendingBegin = 0;
+    std::deque<GpuQuery> mPendingQueries;
+};
+
+} /* namespace uirenderer */
+} /* namespace android */
@@ -34,11 +34,16 @@
 #include <utils/NdkUtils.h>
 #include <utils/Trace.h>
 
+#include <atomic>
+#include <future>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include "hwui/Bitmap.h"
 #include "renderthread/EglManager.h"
 #include "renderthread/VulkanManager.h"
+#include "thread/CommonPool.h"
 #include "thread/ThreadBase.h"
 #include "utils/TimeUtils.h"
 
@@ -46,6 +51,11 @@ namespace android::uirenderer {
 
 static constexpr auto kThreadTimeout = 60000_ms;
 
+static std::atomic<uint64_t> sBufferCount = 0;
+static std::atomic<uint64_t> sSmallBufferCount = 0;
+static std::atomic<nsecs_t> sUploadDuration = 0;
+static std::atomic<nsecs_t> sSmallUploadDuration = 0;
+
 class AHBUploader;
 // This helper uploader classes allows us to upload using either EGL or Vulkan using the same
 // interface.
@@ -59,6 +69,24 @@ struct FormatInfo {
     bool valid = true;
 };
 
+struct UploadRequest {
+    SkBitmap bitmap;
+    FormatInfo format;
+    AHardwareBuffer* ahb;
+    nsecs_t startTime = 0;
+    bool succeeded = false;
+};
+
+static void recordUpload(const SkBitmap& bitmap, nsecs_t duration) {
+    sBufferCount.fetch_add(1, std::memory_order_relaxed);
+    sUploadDuration.fetch_add(duration, std::memory_order_relaxed);
+    if (bitmap.width() <= HardwareBitmapUploader::kSmallBitmapSize &&
+        bitmap.height() <= HardwareBitmapUploader::kSmallBitmapSize) {
+        sSmallBufferCount.fetch_add(1, std::memory_order_relaxed);
+        sSmallUploadDuration.fetch_add(duration, std::memory_order_relaxed);
+    }
+}
+
 class AHBUploader : public RefBase {
 public:
     virtual ~AHBUploader() {}
@@ -78,9 +106,31 @@ public:
                               AHardwareBuffer* ahb) {
         ATRACE_CALL();
         beginUpload();
-        bool result = onUploadHardwareBitmap(bitmap, format, ahb);
+        std::vector<UploadRequest> uploads{UploadRequest{bitmap, format, ahb}};
+        onUploadHardwareBitmaps(uploads);
         endUpload();
-        return result;
+        return uploads[0].succeeded;
+    }
+
+    // Returns right away and uploads the bitmap on a CommonPool thread, in a single batch with all
+    // the uploads queued until that batch starts. The returned future is ready once the pixels
+    // are in the buffer.
+    std::shared_future<void> queueHardwareBitmapUpload(const SkBitmap& bitmap,
+                                                       const FormatInfo& format,
+                                                       AHardwareBuffer* ahb, nsecs_t startTime) {
+        beginUpload();
+        // The buffer must outlive the upload, even if its bitmap is released before.
+        AHardwareBuffer_acquire(ahb);
+
+        std::lock_guard _lock{mQueueLock};
+        mQueuedUploads.push_back(UploadRequest{bitmap, format, ahb, startTime});
+        std::shared_future<void> future = mQueuedPromises.emplace_back().get_future().share();
+        if (!mFlushPending) {
+            mFlushPending = true;
+            sp<AHBUploader> self = this;
+            CommonPool::post([self]() { self->flushQueuedUploads(); });
+        }
+        return future;
     }
 
     void postIdleTimeoutCheck() {
@@ -95,10 +145,46 @@ private:
     virtual void onIdle() = 0;
     virtual void onDestroy() = 0;
 
-    virtual bool onUploadHardwareBitmap(const SkBitmap& bitmap, const FormatInfo& format,
-                                        AHardwareBuffer* ahb) = 0;
+    // Uploads all of the bitmaps and sets their succeeded flag, synchronizing with the GPU only
+    // once for the whole batch.
+    virtual void onUploadHardwareBitmaps(std::vector<UploadRequest>& uploads) = 0;
     virtual void onBeginUpload() = 0;
 
+    void flushQueuedUploads() {
+        // Uploads queued while a batch is in flight are picked up by the next iteration, so there
+        // is at most one batch in flight.
+        while (true) {
+            std::vector<UploadRequest> uploads;
+            std::vector<std::promise<void>> promises;
+            {
+                std::lock_guard _lock{mQueueLock};
+                if (mQueuedUploads.empty()) {
+                    mFlushPending = false;
+                    return;
+                }
+                uploads.swap(mQueuedUploads);
+                promises.swap(mQueuedPromises);
+            }
+
+            ATRACE_FORMAT("Upload %zu queued hardware bitmaps", uploads.size());
+            onUploadHardwareBitmaps(uploads);
+            const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+            for (size_t i = 0; i < uploads.size(); i++) {
+                const UploadRequest& upload = uploads[i];
+                if (upload.succeeded) {
+                    recordUpload(upload.bitmap, now - upload.startTime);
+                } else {
+                    // The bitmap has already been handed out, it is left with undefined content.
+                    ALOGW("Failed to upload queued hardware bitmap (%dx%d)", upload.bitmap.width(),
+                          upload.bitmap.height());
+                }
+                AHardwareBuffer_release(upload.ahb);
+                promises[i].set_value();
+                endUpload();
+            }
+        }
+    }
+
     bool shouldTimeOutLocked() {
         nsecs_t durationSince = systemTime() - mLastUpload;
         return durationSince > kThreadTimeout;
@@ -135,6 +221,11 @@ private:
 
     int mPendingUploads = 0;
     nsecs_t mLastUpload = 0;
+
+    std::mutex mQueueLock;
+    std::vector<UploadRequest> mQueuedUploads;
+    std::vector<std::promise<void>> mQueuedPromises;
+    bool mFlushPending = false;
 };
 
 #define FENCE_TIMEOUT 2000000000
@@ -166,63 +257,80 @@ private:
         return mEglManager.eglDisplay();
     }
 
-    bool onUploadHardwareBitmap(const SkBitmap& bitmap, const FormatInfo& format,
-                                AHardwareBuffer* ahb) override {
+    // Must be called on the upload thread.
+    static bool uploadToImage(EGLImageKHR image, const UploadRequest& upload) {
+        const SkBitmap& bitmap = upload.bitmap;
+        ATRACE_FORMAT("CPU -> gralloc transfer (%dx%d)", bitmap.width(), bitmap.height());
+        AutoSkiaGlTexture glTexture;
+        glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, image);
+        if (GLUtils::dumpGLErrors()) {
+            return false;
+        }
+
+        // glTexSubImage2D is synchronous in sense that it memcpy() from pointer that we
+        // provide.
+        // But asynchronous in sense that driver may upload texture onto hardware buffer
+        // when we first use it in drawing
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, bitmap.width(), bitmap.height(),
+                        upload.format.format, upload.format.type, bitmap.getPixels());
+        return !GLUtils::dumpGLErrors();
+    }
+
+    void onUploadHardwareBitmaps(std::vector<UploadRequest>& uploads) override {
         ATRACE_CALL();
 
         EGLDisplay display = getUploadEglDisplay();
 
         LOG_ALWAYS_FATAL_IF(display == EGL_NO_DISPLAY, "Failed to get EGL_DEFAULT_DISPLAY! err=%s",
                             uirenderer::renderthread::EglManager::eglErrorString());
-        // We use an EGLImage to access the content of the buffer
-        // The EGL image is later bound to a 2D texture
-        const EGLClientBuffer clientBuffer = eglGetNativeClientBufferANDROID(ahb);
-        AutoEglImage autoImage(display, clientBuffer);
-        if (autoImage.image == EGL_NO_IMAGE_KHR) {
-            ALOGW("Could not create EGL image, err =%s",
-                  uirenderer::renderthread::EglManager::eglErrorString());
-            return false;
+        // We use EGLImages to access the content of the buffers
+        // The EGL images are later bound to 2D textures
+        std::vector<std::unique_ptr<AutoEglImage>> autoImages;
+        autoImages.reserve(uploads.size());
+        for (const UploadRequest& upload : uploads) {
+            const EGLClientBuffer clientBuffer = eglGetNativeClientBufferANDROID(upload.ahb);
+            const auto& autoImage =
+                    autoImages.emplace_back(std::make_unique<AutoEglImage>(display, clientBuffer));
+            if (autoImage->image == EGL_NO_IMAGE_KHR) {
+                ALOGW("Could not create EGL image, err =%s",
+                      uirenderer::renderthread::EglManager::eglErrorString());
+            }
         }
 
-        {
-            ATRACE_FORMAT("CPU -> gralloc transfer (%dx%d)", bitmap.width(), bitmap.height());
-            EGLSyncKHR fence = mUploadThread->queue().runSync([&]() -> EGLSyncKHR {
-                AutoSkiaGlTexture glTexture;
-                glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, autoImage.image);
-                if (GLUtils::dumpGLErrors()) {
-                    return EGL_NO_SYNC_KHR;
-                }
-
-                // glTexSubImage2D is synchronous in sense that it memcpy() from pointer that we
-                // provide.
-                // But asynchronous in sense that driver may upload texture onto hardware buffer
-                // when we first use it in drawing
-                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, bitmap.width(), bitmap.height(),
-                                format.format, format.type, bitmap.getPixels());
-                if (GLUtils::dumpGLErrors()) {
-                    return EGL_NO_SYNC_KHR;
+        EGLSyncKHR fence = mUploadThread->queue().runSync([&]() -> EGLSyncKHR {
+            bool anyUploaded = false;
+            for (size_t i = 0; i < uploads.size(); i++) {
+                if (autoImages[i]->image != EGL_NO_IMAGE_KHR) {
+                    uploads[i].succeeded = uploadToImage(autoImages[i]->image, uploads[i]);
+                    anyUploaded |= uploads[i].succeeded;
                 }
+            }
+            if (!anyUploaded) {
+                return EGL_NO_SYNC_KHR;
+            }
 
-                EGLSyncKHR uploadFence =
-                        eglCreateSyncKHR(eglGetCurrentDisplay(), EGL_SYNC_FENCE_KHR, NULL);
-                if (uploadFence == EGL_NO_SYNC_KHR) {
-                    ALOGW("Could not create sync fence %#x", eglGetError());
-                };
-                glFlush();
-                GLUtils::dumpGLErrors();
-                return uploadFence;
-            });
+            // A single fence and flush covers the whole batch.
+            EGLSyncKHR uploadFence =
+                    eglCreateSyncKHR(eglGetCurrentDisplay(), EGL_SYNC_FENCE_KHR, NULL);
+            if (uploadFence == EGL_NO_SYNC_KHR) {
+                ALOGW("Could not create sync fence %#x", eglGetError());
+            };
+            glFlush();
+            GLUtils::dumpGLErrors();
+            return uploadFence;
+        });
 
-            if (fence == EGL_NO_SYNC_KHR) {
-                return false;
+        if (fence == EGL_NO_SYNC_KHR) {
+            for (UploadRequest& upload : uploads) {
+                upload.succeeded = false;
             }
-            EGLint waitStatus = eglClientWaitSyncKHR(display, fence, 0, FENCE_TIMEOUT);
-            ALOGE_IF(waitStatus != EGL_CONDITION_SATISFIED_KHR,
-                    "Failed to wait for the fence %#x", eglGetError());
-
-            eglDestroySyncKHR(display, fence);
+            return;
         }
-        return true;
+        EGLint waitStatus = eglClientWaitSyncKHR(display, fence, 0, FENCE_TIMEOUT);
+        ALOGE_IF(waitStatus != EGL_CONDITION_SATISFIED_KHR,
+                "Failed to wait for the fence %#x", eglGetError());
+
+        eglDestroySyncKHR(display, fence);
     }
 
     renderthread::EglManager mEglManager;
@@ -241,10 +349,8 @@ private:
 
     void onBeginUpload() override {}
 
-    bool onUploadHardwareBitmap(const SkBitmap& bitmap, const FormatInfo& format,
-                                AHardwareBuffer* ahb) override {
-        bool uploadSucceeded = false;
-        mUploadThread->queue().runSync([this, &uploadSucceeded, bitmap, ahb]() {
+    void onUploadHardwareBitmaps(std::vector<UploadRequest>& uploads) override {
+        mUploadThread->queue().runSync([this, &uploads]() {
           ATRACE_CALL();
           std::lock_guard _lock{mVkLock};
 
@@ -263,14 +369,18 @@ private:
               this->postIdleTimeoutCheck();
           }
 
-          sk_sp<SkImage> image =
-              SkImages::TextureFromAHardwareBufferWithData(mGrContext.get(), bitmap.pixmap(),
-                                                           ahb);
+          // The images are kept alive until the single submit of the whole batch.
+          std::vector<sk_sp<SkImage>> images;
+          images.reserve(uploads.size());
+          for (UploadRequest& upload : uploads) {
+              sk_sp<SkImage> image =
+                  SkImages::TextureFromAHardwareBufferWithData(mGrContext.get(),
+                                                               upload.bitmap.pixmap(), upload.ahb);
+              upload.succeeded = (image.get() != nullptr);
+              images.push_back(std::move(image));
+          }
           mGrContext->submit(GrSyncCpu::kYes);
-
-          uploadSucceeded = (image.get() != nullptr);
         });
-        return uploadSucceeded;
     }
 
     /* must be called on the upload thread after the vkLock has been acquired  */
@@ -427,6 +537,22 @@ static SkBitmap makeHwCompatible(const FormatInfo& format, const SkBitmap& sourc
 }
 
 
+static UniqueAHardwareBuffer allocateBufferFor(const SkBitmap& bitmap, const FormatInfo& format) {
+    AHardwareBuffer_Desc desc = {
+            .width = static_cast<uint32_t>(bitmap.width()),
+            .height = static_cast<uint32_t>(bitmap.height()),
+            .layers = 1,
+            .format = format.bufferFormat,
+            .usage = AHARDWAREBUFFER_USAGE_CPU_READ_NEVER | AHARDWAREBUFFER_USAGE_CPU_WRITE_NEVER |
+                     AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE,
+    };
+    UniqueAHardwareBuffer ahb = allocateAHardwareBuffer(desc);
+    if (!ahb) {
+        ALOGW("allocateHardwareBitmap() failed in AHardwareBuffer_allocate()");
+    }
+    return ahb;
+}
+
 static void createUploader(bool usingGL) {
     static std::mutex lock;
     std::lock_guard _lock{lock};
@@ -450,18 +576,10 @@ sk_sp<Bitmap> HardwareBitmapUploader::allocateHardwareBitmap(const SkBitmap& sou
         return nullptr;
     }
 
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
     SkBitmap bitmap = makeHwCompatible(format, sourceBitmap);
-    AHardwareBuffer_Desc desc = {
-            .width = static_cast<uint32_t>(bitmap.width()),
-            .height = static_cast<uint32_t>(bitmap.height()),
-            .layers = 1,
-            .format = format.bufferFormat,
-            .usage = AHARDWAREBUFFER_USAGE_CPU_READ_NEVER | AHARDWAREBUFFER_USAGE_CPU_WRITE_NEVER |
-                     AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE,
-    };
-    UniqueAHardwareBuffer ahb = allocateAHardwareBuffer(desc);
+    UniqueAHardwareBuffer ahb = allocateBufferFor(bitmap, format);
     if (!ahb) {
-        ALOGW("allocateHardwareBitmap() failed in AHardwareBuffer_allocate()");
         return nullptr;
     };
 
@@ -470,10 +588,111 @@ sk_sp<Bitmap> HardwareBitmapUploader::allocateHardwareBitmap(const SkBitmap& sou
     if (!sUploader->uploadHardwareBitmap(bitmap, format, ahb.get())) {
         return nullptr;
     }
+
+    recordUpload(bitmap, systemTime(SYSTEM_TIME_MONOTONIC) - start);
     return Bitmap::createFrom(ahb.get(), bitmap.colorType(), bitmap.refColorSpace(),
                               bitmap.alphaType(), Bitmap::computePalette(bitmap));
 }
 
+sk_sp<Bitmap> HardwareBitmapUploader::allocateHardwareBitmapAsync(const SkBitmap& sourceBitmap) {
+    if (!Properties::asyncBitmapUpload) {
+        return allocateHardwareBitmap(sourceBitmap);
+    }
+    ATRACE_CALL();
+
+    bool usingGL = uirenderer::Properties::getRenderPipelineType() ==
+            uirenderer::RenderPipelineType::SkiaGL;
+
+    FormatInfo format = determineFormat(sourceBitmap, usingGL);
+    if (!format.valid) {
+        return nullptr;
+    }
+
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    SkBitmap bitmap = makeHwCompatible(format, sourceBitmap);
+    UniqueAHardwareBuffer ahb = allocateBufferFor(bitmap, format);
+    if (!ahb) {
+        return nullptr;
+    }
+    sk_sp<Bitmap> hardwareBitmap =
+            Bitmap::createFrom(ahb.get(), bitmap.colorType(), bitmap.refColorSpace(),
+                               bitmap.alphaType(), Bitmap::computePalette(bitmap));
+    if (!hardwareBitmap) {
+        return nullptr;
+    }
+
+    createUploader(usingGL);
+    hardwareBitmap->setPendingUpload(
+            sUploader->queueHardwareBitmapUpload(bitmap, format, ahb.get(), start));
+    return hardwareBitmap;
+}
+
+sk_sp<Bitmap> HardwareBitmapUploader::allocateWritableHardwareBitmap(
+        const SkImageInfo& info, const PixelWriter& writePixels) {
+    if (!Properties::directHardwareDecode) {
+        return nullptr;
+    }
+    ATRACE_CALL();
+
+    bool usingGL = uirenderer::Properties::getRenderPipelineType() ==
+            uirenderer::RenderPipelineType::SkiaGL;
+
+    SkBitmap bitmap;
+    if (!bitmap.setInfo(info)) {
+        return nullptr;
+    }
+    FormatInfo format = determineFormat(bitmap, usingGL);
+    // The pixels are written as they are, the buffer must have the same layout. Gray is
+    // supported by uploading it as luminance, which a buffer can't be.
+    if (!format.valid || !format.isSupported || info.colorType() == kGray_8_SkColorType) {
+        return nullptr;
+    }
+
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    AHardwareBuffer_Desc desc = {
+            .width = static_cast<uint32_t>(info.width()),
+            .height = static_cast<uint32_t>(info.height()),
+            .layers = 1,
+            .format = format.bufferFormat,
+            .usage = AHARDWAREBUFFER_USAGE_CPU_READ_NEVER | AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN |
+                     AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE,
+    };
+    UniqueAHardwareBuffer ahb = allocateAHardwareBuffer(desc);
+    if (!ahb) {
+        ALOGW("allocateWritableHardwareBitmap() failed in AHardwareBuffer_allocate()");
+        return nullptr;
+    }
+    // Only the allocation counts as upload time, the pixels are written by the caller.
+    const nsecs_t allocationDuration = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    AHardwareBuffer_describe(ahb.get(), &desc);
+
+    void* pixels = nullptr;
+    if (AHardwareBuffer_lock(ahb.get(), AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN, -1, nullptr,
+                             &pixels) != 0) {
+        ALOGW("allocateWritableHardwareBitmap() failed in AHardwareBuffer_lock()");
+        return nullptr;
+    }
+    const bool written = writePixels(pixels, desc.stride * info.bytesPerPixel());
+    // Waits for the writes to be flushed, the bitmap may be drawn right away.
+    AHardwareBuffer_unlock(ahb.get(), nullptr);
+    if (!written) {
+        return nullptr;
+    }
+
+    recordUpload(bitmap, allocationDuration);
+    return Bitmap::createFrom(ahb.get(), info.colorType(), info.refColorSpace(), info.alphaType(),
+                              BitmapPalette::Unknown);
+}
+
+HardwareBitmapUploader::UploadStats HardwareBitmapUploader::getUploadStats() {
+    return UploadStats{
+            .bufferCount = sBufferCount.load(std::memory_order_relaxed),
+            .smallBufferCount = sSmallBufferCount.load(std::memory_order_relaxed),
+            .uploadDuration = sUploadDuration.load(std::memory_order_relaxed),
+            .smallUploadDuration = sSmallUploadDuration.load(std::memory_order_relaxed),
+    };
+}
+
 void HardwareBitmapUploader::initialize() {
     bool usingGL = uirenderer::Properties::getRenderPipelineType() ==
             uirenderer::RenderPipelineType::SkiaGL;
@@ -18,8 +18,12 @@
 
 #include <hwui/Bitmap.h>
 #include <SkRefCnt.h>
+#include <utils/Timers.h>
+
+#include <functional>
 
 class SkBitmap;
+struct SkImageInfo;
 
 namespace android::uirenderer {
 
@@ -30,6 +34,42 @@ public:
 
     static sk_sp<Bitmap> allocateHardwareBitmap(const SkBitmap& sourceBitmap);
 
+    // Allocates the buffer of the hardware bitmap and returns it right away, its pixels are
+    // uploaded in a batch with the other async uploads. The bitmap waits for its upload when its
+    // pixels are first used, see Bitmap::waitForPendingUpload(). The pixels of sourceBitmap must
+    // not be modified afterwards. The upload is synchronous unless debug.hwui.async_bitmap_upload
+    // is set.
+    static sk_sp<Bitmap> allocateHardwareBitmapAsync(const SkBitmap& sourceBitmap);
+
+    // Writes the pixels of a bitmap of info at pixels, rowBytes apart. Returns false on failure.
+    using PixelWriter = std::function<bool(void* pixels, size_t rowBytes)>;
+
+    // Allocates a CPU-writable buffer for a hardware bitmap of info and lets writePixels fill it
+    // in place, saving the copy of an upload. Returns nullptr without calling writePixels if the
+    // buffer can't hold info as is, or if debug.hwui.direct_hardware_decode isn't set.
+#ifdef __ANDROID__
+    static sk_sp<Bitmap> allocateWritableHardwareBitmap(const SkImageInfo& info,
+                                                        const PixelWriter& writePixels);
+#else
+    static sk_sp<Bitmap> allocateWritableHardwareBitmap(const SkImageInfo&, const PixelWriter&) {
+        return nullptr;
+    }
+#endif
+
+    // Bitmaps that fit into kSmallBitmapSize x kSmallBitmapSize, like icons and avatars, are
+    // counted separately, as they pay the per buffer costs for very little content.
+    static constexpr int kSmallBitmapSize = 128;
+
+    struct UploadStats {
+        uint64_t bufferCount;
+        uint64_t smallBufferCount;
+        nsecs_t uploadDuration;
+        nsecs_t smallUploadDuration;
+    };
+    // Returns the number of AHardwareBuffers allocated for hardware bitmaps and the time spent
+    // allocating and uploading them since the process started.
+    static UploadStats getUploadStats();
+
 #ifdef __ANDROID__
     static bool hasFP16Support();
     static bool has1010102Support();
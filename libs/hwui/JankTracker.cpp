@@ -29,6 +29,7 @@
 #include <sstream>
 
 #include "DeviceInfo.h"
+#include "FrameInfoRing.h"
 #include "Properties.h"
 #include "utils/TimeUtils.h"
 #include "utils/Trace.h"
@@ -169,6 +170,10 @@ void JankTracker::calculateLegacyJank(FrameInfo& frame) REQUIRES(mDataMutex) {
 
 void JankTracker::finishFrame(FrameInfo& frame, std::unique_ptr<FrameMetricsReporter>& reporter,
                               int64_t frameNumber, int32_t surfaceControlId) {
+    if (FrameInfoRing* ring = FrameInfoRing::get()) {
+        ring->append(frame);
+    }
+
     std::lock_guard lock(mDataMutex);
 
     calculateLegacyJank(frame);
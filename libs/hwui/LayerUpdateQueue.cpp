@@ -23,17 +23,17 @@ namespace uirenderer {
 
 void LayerUpdateQueue::clear() {
     mEntries.clear();
+    mEntryIndex.clear();
 }
 
 void LayerUpdateQueue::enqueueLayerWithDamage(RenderNode* renderNode, Rect damage) {
     damage.roundOut();
     damage.doIntersect(0, 0, renderNode->getWidth(), renderNode->getHeight());
     if (!damage.isEmpty()) {
-        for (Entry& entry : mEntries) {
-            if (CC_UNLIKELY(entry.renderNode == renderNode)) {
-                entry.damage.unionWith(damage);
-                return;
-            }
+        auto [it, inserted] = mEntryIndex.try_emplace(renderNode, mEntries.size());
+        if (CC_UNLIKELY(!inserted)) {
+            mEntries[it->second].damage.unionWith(damage);
+            return;
         }
         mEntries.emplace_back(renderNode, damage);
     }
@@ -48,6 +48,9 @@ public:
 
 private:
     std::vector<Entry> mEntries;
+    // Index of each node's entry, so that re-damaging a layer stays cheap when many
+    // hardware layers are queued in the same frame.
+    std::unordered_map<const RenderNode*, size_t> mEntryIndex;
 };
 
 }  // namespace uirenderer
@@ -36,6 +36,7 @@ constexpr static MemoryPolicy sPersistentOrSystemPolicy{
 constexpr static MemoryPolicy sLowRamPolicy{
         .useAlternativeUiHidden = true,
         .purgeScratchOnly = false,
+        .maxAdaptiveResourceScale = 1.0f,
 };
 constexpr static MemoryPolicy sExtremeLowRam{
         .initialMaxSurfaceAreaScale = 0.2f,
@@ -46,6 +47,9 @@ constexpr static MemoryPolicy sExtremeLowRam{
         .useAlternativeUiHidden = true,
         .purgeScratchOnly = false,
         .releaseContextOnStoppedOnly = true,
+        .minAdaptiveResourceScale = 0.25f,
+        .maxAdaptiveResourceScale = 1.0f,
+        .memoryPressureThreshold = 5.0f,
 };
 
 const MemoryPolicy& loadMemoryPolicy() {
@@ -64,6 +64,13 @@ struct MemoryPolicy {
     // EXPERIMENTAL: Whether or not to trigger releasing GPU context when all contexts are stopped
     // WARNING: Enabling this option can lead to instability, see b/266626090
     bool releaseContextOnStoppedOnly = false;
+    // The bounds of the resource cache size when it is adapted to its usage, relative to the
+    // foreground cache size. See AdaptiveCacheBudget.
+    float minAdaptiveResourceScale = 0.5f;
+    float maxAdaptiveResourceScale = 2.0f;
+    // The share of time in the last 10 seconds during which some tasks stalled on memory, in
+    // percent, above which the device is considered under memory pressure (see PSI).
+    float memoryPressureThreshold = 10.0f;
 };
 
 const MemoryPolicy& loadMemoryPolicy();
@@ -33,6 +33,75 @@ static size_t min_vcount_for_mode(SkMesh::Mode mode) {
     return 1;
 }
 
+std::shared_ptr<MeshBufferData> MeshBufferData::MakeUpdated(
+        const std::shared_ptr<MeshBufferData>& data, size_t offset, const void* bytes,
+        size_t size) {
+    auto updated = std::make_shared<MeshBufferData>(data->mVertexData, data->mVertexCount,
+                                                    data->mVertexOffset, data->mIndexData,
+                                                    data->mIndexCount, data->mIndexOffset);
+    memcpy(updated->mVertexData.data() + offset, bytes, size);
+    updated->mDirty = {offset, offset + size};
+    if (data.use_count() == 1 && data->mPrevious) {
+        // The data was never uploaded and is about to be dropped, skip it.
+        updated->mPrevious = data->mPrevious;
+        updated->mDirty = updated->mDirty.unite(data->mDirty);
+    } else {
+        updated->mPrevious = data;
+    }
+    return updated;
+}
+
+bool MeshBufferData::reuseBuffers(GrDirectContext* context,
+                                  GrDirectContext::DirectContextID currentId) const {
+    CachedSkiaBuffers& previous = mPrevious->mSkiaBuffers;
+    if (previous.fGenerationId != currentId || previous.fVertexBuffer == nullptr) {
+        return false;
+    }
+
+    sk_sp<SkMesh::VertexBuffer> vertexBuffer;
+    if (previous.fSpareVertexBuffer) {
+        // Buffer updates must be aligned to 4 bytes.
+        const ByteRange stale = mDirty.unite(previous.fSpareStale);
+        const size_t start = stale.start & ~size_t(3);
+        const size_t end = (stale.end + 3) & ~size_t(3);
+        if (!stale.isEmpty()) {
+            if (end > mVertexData.size() ||
+                !previous.fSpareVertexBuffer->update(context, mVertexData.data() + start, start,
+                                                     end - start)) {
+                return false;
+            }
+        }
+        vertexBuffer = previous.fSpareVertexBuffer;
+    } else {
+#ifdef __ANDROID__
+        vertexBuffer = SkMeshes::MakeVertexBuffer(context, mVertexData.data(), mVertexData.size());
+#else
+        vertexBuffer = SkMeshes::MakeVertexBuffer(mVertexData.data(), mVertexData.size());
+#endif
+        if (!vertexBuffer) {
+            return false;
+        }
+    }
+
+    mSkiaBuffers.fVertexBuffer = std::move(vertexBuffer);
+    mSkiaBuffers.fIndexBuffer = previous.fIndexBuffer;
+    mSkiaBuffers.fGenerationId = currentId;
+    mSkiaBuffers.fSpareVertexBuffer = previous.fVertexBuffer;
+    mSkiaBuffers.fSpareStale = mDirty;
+    // The previous data uploads its own buffers again if it's ever drawn.
+    previous = CachedSkiaBuffers();
+    return true;
+}
+
+bool Mesh::updateVertexData(size_t offset, const void* data, size_t size) {
+    const size_t vertexDataSize = mBufferData->vertexData().size();
+    if (offset > vertexDataSize || size > vertexDataSize - offset) {
+        return false;
+    }
+    mBufferData = MeshBufferData::MakeUpdated(mBufferData, offset, data, size);
+    return true;
+}
+
 // Re-implementation of SkMesh::validate to validate user side that their mesh is valid.
 std::tuple<bool, SkString> Mesh::validate() {
 #define FAIL_MESH_VALIDATE(...) return std::make_tuple(false, SkStringPrintf(__VA_ARGS__))
@@ -23,7 +23,10 @@
 #include <jni.h>
 #include <log/log.h>
 
+#include <algorithm>
+#include <memory>
 #include <utility>
+#include <vector>
 
 namespace android {
 
@@ -106,6 +109,12 @@ private:
 };
 
 // Storage for CPU and GPU copies of the vertex and index data of a mesh.
+//
+// The data is immutable once shared with the render thread. An update makes new data, which
+// takes over the GPU buffers of the data it replaces when it is uploaded, if nothing else uses
+// them by then. Two vertex buffers are kept in turn so that an update doesn't write to the
+// buffer that the previous frame read from, and only the bytes that changed since the data of
+// a buffer are uploaded to it.
 class MeshBufferData {
 public:
     MeshBufferData(std::vector<uint8_t> vertexData, int32_t vertexCount, int32_t vertexOffset,
@@ -117,14 +126,29 @@ public:
             , mVertexData(std::move(vertexData))
             , mIndexData(std::move(indexData)) {}
 
+    // Returns a copy of data with size bytes of the vertex data at offset replaced, which must be
+    // within the vertex data.
+    static std::shared_ptr<MeshBufferData> MakeUpdated(
+            const std::shared_ptr<MeshBufferData>& data, size_t offset, const void* bytes,
+            size_t size);
+
     void updateBuffers(GrDirectContext* context) const {
         GrDirectContext::DirectContextID currentId = context == nullptr
                                                              ? GrDirectContext::DirectContextID()
                                                              : context->directContextID();
         if (currentId == mSkiaBuffers.fGenerationId && mSkiaBuffers.fVertexBuffer != nullptr) {
-            // Nothing to update since the Android API does not support partial updates yet.
             return;
         }
+        if (mPrevious) {
+            // Only the render thread refers to the data being replaced if it's used by nothing
+            // but this.
+            const bool reused = mPrevious.use_count() == 1 && reuseBuffers(context, currentId);
+            mPrevious.reset();
+            if (reused) {
+                return;
+            }
+        }
+        mSkiaBuffers = CachedSkiaBuffers();
 
         mSkiaBuffers.fVertexBuffer =
 #ifdef __ANDROID__
@@ -157,13 +181,35 @@ public:
     const std::vector<uint8_t>& indexData() const { return mIndexData; }
 
 private:
+    // A range of bytes of the vertex data.
+    struct ByteRange {
+        size_t start = 0;
+        size_t end = 0;
+
+        bool isEmpty() const { return start >= end; }
+        ByteRange unite(const ByteRange& other) const {
+            if (isEmpty()) return other;
+            if (other.isEmpty()) return *this;
+            return {std::min(start, other.start), std::max(end, other.end)};
+        }
+    };
+
     struct CachedSkiaBuffers {
         sk_sp<SkMesh::VertexBuffer> fVertexBuffer;
         sk_sp<SkMesh::IndexBuffer> fIndexBuffer;
         GrDirectContext::DirectContextID fGenerationId = GrDirectContext::DirectContextID();
+        // The buffer of the data before, which differs from this data in fSpareStale.
+        sk_sp<SkMesh::VertexBuffer> fSpareVertexBuffer;
+        ByteRange fSpareStale;
     };
 
+    // Takes over the buffers of mPrevious, returns false if they can't be used.
+    bool reuseBuffers(GrDirectContext* context, GrDirectContext::DirectContextID currentId) const;
+
     mutable CachedSkiaBuffers mSkiaBuffers;
+    // The data this replaces and the bytes that differ from it, until this is uploaded.
+    mutable std::shared_ptr<const MeshBufferData> mPrevious;
+    ByteRange mDirty;
     int32_t mVertexCount = 0;
     int32_t mVertexOffset = 0;
     int32_t mIndexCount = 0;
@@ -263,6 +309,10 @@ public:
 
     MeshUniformBuilder* uniformBuilder() { return &mUniformBuilder; }
 
+    // Replaces size bytes of the vertex data at offset, for instance the vertices of the particles
+    // that moved. Returns false if the range is outside of the vertex data.
+    bool updateVertexData(size_t offset, const void* data, size_t size);
+
 private:
     sk_sp<SkMeshSpecification> mMeshSpec;
     SkMesh::Mode mMode;
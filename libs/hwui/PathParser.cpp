@@ -19,15 +19,65 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <utils/Log.h>
+#include <list>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PATH_PARSER_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PATH_PARSER_SSE2 1
+#endif
+
 namespace android {
 namespace uirenderer {
 
+#if defined(PATH_PARSER_NEON) || defined(PATH_PARSER_SSE2)
+/**
+ * Returns the index of the first path command in the 16 characters at s, or 16 if there is none.
+ * A command is any ASCII letter other than 'e' and 'E', see nextStart().
+ */
+static inline size_t findCommandIn16(const char* s) {
+#if defined(PATH_PARSER_NEON)
+    const uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t*>(s));
+    const uint8x16_t lower = vorrq_u8(chars, vdupq_n_u8(0x20));
+    const uint8x16_t isLetter =
+            vcleq_u8(vsubq_u8(lower, vdupq_n_u8('a')), vdupq_n_u8('z' - 'a'));
+    const uint8x16_t isCommand = vbicq_u8(isLetter, vceqq_u8(lower, vdupq_n_u8('e')));
+    // Narrows the mask to 4 bits per character.
+    const uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(isCommand), 4)), 0);
+    return mask ? __builtin_ctzll(mask) / 4 : 16;
+#else
+    const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+    const __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    const __m128i offset = _mm_sub_epi8(lower, _mm_set1_epi8('a'));
+    const __m128i isLetter =
+            _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8('z' - 'a')), offset);
+    const __m128i isCommand =
+            _mm_andnot_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('e')), isLetter);
+    const int mask = _mm_movemask_epi8(isCommand);
+    return mask ? __builtin_ctz(mask) : 16;
+#endif
+}
+#endif
+
 static size_t nextStart(const char* s, size_t length, size_t startIndex) {
     size_t index = startIndex;
+#if defined(PATH_PARSER_NEON) || defined(PATH_PARSER_SSE2)
+    for (; index + 16 <= length; index += 16) {
+        const size_t found = findCommandIn16(s + index);
+        if (found < 16) {
+            return index + found;
+        }
+    }
+#endif
     while (index < length) {
         char c = s[index];
         // Note that 'e' or 'E' are not valid path commands, but could be
@@ -97,8 +147,105 @@ static void extract(int* outEndPosition, bool* outEndWithNegOrDot, const char* s
     *outEndPosition = currentIndex;
 }
 
+static inline bool isDigit(char c) {
+    return static_cast<unsigned>(c - '0') < 10;
+}
+
+// The powers of ten that are exact in a float.
+static constexpr float kExactPowersOfTen[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f,
+                                              1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+static constexpr int kMaxExactPowerOfTen = 10;
+// The largest mantissa that is exact in a float.
+static constexpr uint64_t kMaxExactMantissa = 1 << 24;
+
+/**
+ * Parses the number at s the way strtof() does, for the numbers that it can round the same way
+ * without strtof(): the ones whose digits and power of ten are both exact in a float, in which
+ * case the float multiplication or division rounds correctly. That covers the numbers of path
+ * strings, which rarely have more than 7 digits. Returns false for anything else, including hex
+ * numbers, infinities and leading whitespace, which are left to strtof().
+ */
+static bool parseFloatFast(const char* s, float* outValue) {
+    const char* p = s;
+    const bool negative = *p == '-';
+    if (*p == '-' || *p == '+') {
+        p++;
+    }
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    for (; isDigit(*p); p++) {
+        hasDigits = true;
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa > kMaxExactMantissa) {
+            return false;
+        }
+    }
+    if (*p == '.') {
+        for (p++; isDigit(*p); p++) {
+            hasDigits = true;
+            // Trailing zeros of the fraction don't change the value.
+            if (*p == '0') {
+                const char* next = p + 1;
+                while (*next == '0') {
+                    next++;
+                }
+                if (!isDigit(*next)) {
+                    p = next - 1;
+                    continue;
+                }
+            }
+            mantissa = mantissa * 10 + (*p - '0');
+            exponent--;
+            if (mantissa > kMaxExactMantissa) {
+                return false;
+            }
+        }
+    }
+    if (!hasDigits) {
+        return false;
+    }
+    if (*p == 'e' || *p == 'E') {
+        const char* e = p + 1;
+        const bool negativeExponent = *e == '-';
+        if (*e == '-' || *e == '+') {
+            e++;
+        }
+        // Without digits, the 'e' isn't part of the number.
+        if (isDigit(*e)) {
+            int value = 0;
+            for (; isDigit(*e); e++) {
+                value = value * 10 + (*e - '0');
+                if (value > 2 * kMaxExactPowerOfTen) {
+                    return false;
+                }
+            }
+            exponent += negativeExponent ? -value : value;
+            p = e;
+        }
+    }
+    if (*p == 'x' || *p == 'X') {
+        return false;
+    }
+    float value = 0;
+    if (mantissa != 0) {
+        if (exponent < -kMaxExactPowerOfTen || exponent > kMaxExactPowerOfTen) {
+            return false;
+        }
+        value = static_cast<float>(mantissa);
+        value = exponent < 0 ? value / kExactPowersOfTen[-exponent]
+                             : value * kExactPowersOfTen[exponent];
+    }
+    *outValue = negative ? -value : value;
+    return true;
+}
+
 static float parseFloat(PathParser::ParseResult* result, const char* startPtr,
                         size_t expectedLength) {
+    float fastValue;
+    if (parseFloatFast(startPtr, &fastValue)) {
+        return fastValue;
+    }
     char* endPtr = NULL;
     float currentValue = strtof(startPtr, &endPtr);
     if ((currentValue == HUGE_VALF || currentValue == -HUGE_VALF) && errno == ERANGE) {
@@ -234,18 +381,20 @@ void PathParser::getPathDataFromAsciiString(PathData* data, ParseResult* result,
 
     while (end < strLen) {
         end = nextStart(pathStr, strLen, end);
-        std::vector<float> points;
-        getFloats(&points, result, pathStr, start, end);
-        validateVerbAndPoints(pathStr[start], points.size(), result);
+        // The floats go straight to the end of the points, and are removed again on failure.
+        const size_t pointsStart = data->points.size();
+        getFloats(&data->points, result, pathStr, start, end);
+        const size_t pointCount = data->points.size() - pointsStart;
+        validateVerbAndPoints(pathStr[start], pointCount, result);
         if (result->failureOccurred) {
+            data->points.resize(pointsStart);
             // If either verb or points is not valid, return immediately.
             result->failureMessage += "Failure occurred at position " + std::to_string(start) +
                                       " of path: " + pathStr;
             return;
         }
         data->verbs.push_back(pathStr[start]);
-        data->verbSizes.push_back(points.size());
-        data->points.insert(data->points.end(), points.begin(), points.end());
+        data->verbSizes.push_back(pointCount);
         start = end;
         end++;
     }
@@ -302,5 +451,118 @@ void PathParser::parseAsciiStringForSkPath(SkPath* skPath, ParseResult* result,
     return;
 }
 
+namespace {
+
+/**
+ * The path strings that were parsed last in the process, with their data and, once it was asked
+ * for, their SkPath. Screens full of icons inflate the same VectorDrawables and parse the same
+ * strings many times over.
+ */
+class PathStringCache {
+public:
+    // Longer strings are parsed every time, they are rarely reused and would hold on to a lot
+    // of memory.
+    static constexpr size_t kMaxStringLength = 4096;
+    static constexpr size_t kMaxEntries = 256;
+
+    struct Entry {
+        PathData data;
+        SkPath path;
+        bool hasPath = false;
+    };
+
+    static PathStringCache& get() {
+        static PathStringCache* sInstance = new PathStringCache();
+        return *sInstance;
+    }
+
+    // Calls function with the entry of pathStr, parsing it into the cache first if needed.
+    // Returns false if the string doesn't parse, with the failure in result.
+    template <typename Function>
+    bool use(const char* pathStr, size_t strLen, PathParser::ParseResult* result,
+             const Function& function) {
+        const std::string_view key(pathStr, strLen);
+        std::lock_guard lock(mLock);
+        auto found = mIndex.find(key);
+        if (found != mIndex.end()) {
+            mEntries.splice(mEntries.begin(), mEntries, found->second);
+            function(found->second->second);
+            return true;
+        }
+
+        Entry entry;
+        PathParser::getPathDataFromAsciiString(&entry.data, result, pathStr, strLen);
+        if (result->failureOccurred) {
+            return false;
+        }
+        mEntries.emplace_front(std::string(key), std::move(entry));
+        mIndex.emplace(mEntries.front().first, mEntries.begin());
+        if (mEntries.size() > kMaxEntries) {
+            mIndex.erase(mEntries.back().first);
+            mEntries.pop_back();
+        }
+        function(mEntries.front().second);
+        return true;
+    }
+
+    void clear() {
+        std::lock_guard lock(mLock);
+        mIndex.clear();
+        mEntries.clear();
+    }
+
+private:
+    using EntryList = std::list<std::pair<std::string, Entry>>;
+
+    std::mutex mLock;
+    // Most recently used first.
+    EntryList mEntries;
+    // Views into the strings of mEntries, which don't move.
+    std::unordered_map<std::string_view, EntryList::iterator> mIndex;
+};
+
+}  // namespace
+
+void PathParser::getPathDataFromAsciiStringCached(PathData* outData, ParseResult* result,
+                                                  const char* pathStr, size_t strLength) {
+    if (pathStr == NULL || strLength > PathStringCache::kMaxStringLength) {
+        getPathDataFromAsciiString(outData, result, pathStr, strLength);
+        return;
+    }
+    PathStringCache::get().use(pathStr, strLength, result, [&](PathStringCache::Entry& entry) {
+        const PathData& data = entry.data;
+        outData->verbs.insert(outData->verbs.end(), data.verbs.begin(), data.verbs.end());
+        outData->verbSizes.insert(outData->verbSizes.end(), data.verbSizes.begin(),
+                                  data.verbSizes.end());
+        outData->points.insert(outData->points.end(), data.points.begin(), data.points.end());
+    });
+}
+
+void PathParser::parseAsciiStringForSkPathCached(SkPath* outPath, ParseResult* result,
+                                                 const char* pathStr, size_t strLength) {
+    if (pathStr == NULL || strLength > PathStringCache::kMaxStringLength) {
+        parseAsciiStringForSkPath(outPath, result, pathStr, strLength);
+        return;
+    }
+    PathStringCache::get().use(pathStr, strLength, result, [&](PathStringCache::Entry& entry) {
+        if (entry.data.verbs.empty()) {
+            result->failureOccurred = true;
+            result->failureMessage = "No verbs found in the string for pathData: ";
+            result->failureMessage.append(pathStr, strLength);
+            return;
+        }
+        if (!entry.hasPath) {
+            VectorDrawableUtils::verbsToPath(&entry.path, entry.data);
+            entry.hasPath = true;
+        }
+        // SkPaths share their points until either of them is modified.
+        *outPath = entry.path;
+    });
+}
+
+void PathParser::clearCache() {
+    PathStringCache::get().clear();
+}
+
 }  // namespace uirenderer
 }  // namespace android
@@ -41,6 +41,15 @@ public:
                                           const char* pathStr, size_t strLength);
     static void getPathDataFromAsciiString(PathData* outData, ParseResult* result,
                                            const char* pathStr, size_t strLength);
+    /**
+     * Same as parseAsciiStringForSkPath() and getPathDataFromAsciiString(), but reuses the
+     * result for the strings that were parsed recently in the process. Thread safe.
+     */
+    static void parseAsciiStringForSkPathCached(SkPath* outPath, ParseResult* result,
+                                                const char* pathStr, size_t strLength);
+    static void getPathDataFromAsciiStringCached(PathData* outData, ParseResult* result,
+                                                 const char* pathStr, size_t strLength);
+    static void clearCache();
     static void dump(const PathData& data);
     static void validateVerbAndPoints(char verb, size_t points, ParseResult* result);
 };
@@ -110,6 +110,20 @@ float Properties::maxHdrHeadroomOn8bit = 5.f;  // TODO: Refine this number
 bool Properties::clipSurfaceViews = false;
 bool Properties::hdr10bitPlus = false;
 bool Properties::skipTelemetry = false;
+bool Properties::parallelPrepareTree = false;
+bool Properties::cpuTiledRendering = false;
+bool Properties::autoLayerCaching = false;
+bool Properties::asyncBitmapUpload = false;
+bool Properties::directHardwareDecode = false;
+bool Properties::shaderCacheWarmup = false;
+bool Properties::adaptiveCacheBudget = false;
+int Properties::backdropBlurQuality = 0;
+int Properties::vectorDrawableDirectMaxPaths = 0;
+int Properties::animatedImageDecodeThreads = 1;
+int Properties::animatedImageFramesAhead = 1;
+int Properties::animatedImageCacheBudgetKb = 16 * 1024;
+int Properties::frameInfoRingSize = 0;
+bool Properties::stagedPreload = false;
 
 int Properties::timeoutMultiplier = 1;
 
@@ -189,6 +203,23 @@ bool Properties::load() {
     timeoutMultiplier = android::base::GetIntProperty("ro.hw_timeout_multiplier", 1);
     skipTelemetry = base::GetBoolProperty(PROPERTY_SKIP_EGLMANAGER_TELEMETRY,
                                           hwui_flags::skip_eglmanager_telemetry());
+    parallelPrepareTree = base::GetBoolProperty(PROPERTY_PARALLEL_PREPARE_TREE, false);
+    cpuTiledRendering = base::GetBoolProperty(PROPERTY_CPU_TILED_RENDERING, false);
+    autoLayerCaching = base::GetBoolProperty(PROPERTY_AUTO_LAYER_CACHING, false);
+    asyncBitmapUpload = base::GetBoolProperty(PROPERTY_ASYNC_BITMAP_UPLOAD, false);
+    directHardwareDecode = base::GetBoolProperty(PROPERTY_DIRECT_HARDWARE_DECODE, false);
+    shaderCacheWarmup = base::GetBoolProperty(PROPERTY_SHADER_CACHE_WARMUP, false);
+    adaptiveCacheBudget = base::GetBoolProperty(PROPERTY_ADAPTIVE_CACHE_BUDGET, false);
+    backdropBlurQuality = base::GetIntProperty(PROPERTY_BACKDROP_BLUR_QUALITY, 0);
+    vectorDrawableDirectMaxPaths =
+            base::GetIntProperty(PROPERTY_VECTOR_DRAWABLE_DIRECT_MAX_PATHS, 0);
+    animatedImageDecodeThreads =
+            base::GetIntProperty(PROPERTY_ANIMATED_IMAGE_DECODE_THREADS, 1, 1, 8);
+    animatedImageFramesAhead = base::GetIntProperty(PROPERTY_ANIMATED_IMAGE_FRAMES_AHEAD, 1, 1, 16);
+    animatedImageCacheBudgetKb =
+            base::GetIntProperty(PROPERTY_ANIMATED_IMAGE_CACHE_BUDGET, 16 * 1024, 0);
+    frameInfoRingSize = base::GetIntProperty(PROPERTY_FRAME_INFO_RING_SIZE, 0, 0, 4096);
+    stagedPreload = base::GetBoolProperty(PROPERTY_STAGED_PRELOAD, false);
 
     return (prevDebugLayersUpdates != debugLayersUpdates) || (prevDebugOverdraw != debugOverdraw);
 }
@@ -236,6 +236,96 @@ enum DebugLevel {
 
 #define PROPERTY_SKIP_EGLMANAGER_TELEMETRY "debug.hwui.skip_eglmanager_telemetry"
 
+/**
+ * Allows independent RenderNode subtrees to be prepared on the CommonPool threads in parallel.
+ */
+#define PROPERTY_PARALLEL_PREPARE_TREE "debug.hwui.parallel_prepare_tree"
+
+/**
+ * Splits the frames of the CPU pipeline into bands that are rasterized on the CommonPool threads.
+ */
+#define PROPERTY_CPU_TILED_RENDERING "debug.hwui.cpu_tiled_rendering"
+
+/**
+ * Renders RenderNodes whose content hasn't changed for a few frames into layers automatically.
+ */
+#define PROPERTY_AUTO_LAYER_CACHING "debug.hwui.auto_layer_caching"
+
+/**
+ * Lets decoded hardware bitmaps be returned before their pixels are uploaded to their buffer.
+ */
+#define PROPERTY_ASYNC_BITMAP_UPLOAD "debug.hwui.async_bitmap_upload"
+
+/**
+ * Lets ImageDecoder decode hardware bitmaps straight into CPU-writable buffers, rather than into
+ * heap memory that is then uploaded. Sampling such buffers may be slower on some GPUs.
+ */
+#define PROPERTY_DIRECT_HARDWARE_DECODE "debug.hwui.direct_hardware_decode"
+
+/**
+ * Precompiles the shaders used in the first frames of the previous run when the app starts.
+ */
+#define PROPERTY_SHADER_CACHE_WARMUP "debug.hwui.shader_cache_warmup"
+
+/**
+ * Path of the read-only shader cache shared by all apps, see SharedShaderCache.
+ */
+#define PROPERTY_SHARED_SHADER_CACHE "ro.hwui.shared_shader_cache"
+
+/**
+ * Resizes the GPU resource cache with its usage and the memory pressure of the device, within
+ * the bounds of the memory policy. See AdaptiveCacheBudget.
+ */
+#define PROPERTY_ADAPTIVE_CACHE_BUDGET "debug.hwui.adaptive_cache_budget"
+
+/**
+ * Blurs the backdrop of RenderNodes at a fraction of its resolution, see BackdropBlur.
+ * 0 disables it, 1 favors quality and 2 favors performance.
+ */
+#define PROPERTY_BACKDROP_BLUR_QUALITY "debug.hwui.backdrop_blur_quality"
+
+/**
+ * VectorDrawables with at most this many paths are drawn as paths on the canvas of the
+ * RenderThread rather than through their bitmap cache. 0 always uses the bitmap cache.
+ */
+#define PROPERTY_VECTOR_DRAWABLE_DIRECT_MAX_PATHS "debug.hwui.vd_direct_max_paths"
+
+/**
+ * Path of the file of text measurements shared by all the processes, see
+ * SharedTextMeasureCache. Unset by default, which disables the shared cache.
+ */
+#define PROPERTY_SHARED_TEXT_CACHE "ro.hwui.shared_text_cache"
+
+/**
+ * Number of threads decoding the frames of AnimatedImageDrawables. The frames of a drawable are
+ * always decoded on the same thread.
+ */
+#define PROPERTY_ANIMATED_IMAGE_DECODE_THREADS "debug.hwui.animated_image_decode_threads"
+
+/**
+ * Number of frames that a running AnimatedImageDrawable decodes ahead of the one it shows. The
+ * frames beyond the first are only decoded within PROPERTY_ANIMATED_IMAGE_CACHE_BUDGET.
+ */
+#define PROPERTY_ANIMATED_IMAGE_FRAMES_AHEAD "debug.hwui.animated_image_frames_ahead"
+
+/**
+ * Budget in kilobytes of the frames decoded ahead by all the AnimatedImageDrawables of the
+ * process, beyond the first frame of each.
+ */
+#define PROPERTY_ANIMATED_IMAGE_CACHE_BUDGET "debug.hwui.animated_image_cache_kb"
+
+/**
+ * Number of finished frames whose FrameInfo is kept in the shared memory ring of
+ * FrameInfoRing, for profilers to read. 0, the default, disables the ring.
+ */
+#define PROPERTY_FRAME_INFO_RING_SIZE "debug.hwui.frame_info_ring_size"
+
+/**
+ * Staged preload: the driver is initialized and the shader disk cache read on a background
+ * thread at process start, before the RenderThread creates the GrDirectContext.
+ */
+#define PROPERTY_STAGED_PRELOAD "debug.hwui.staged_preload"
+
 /**
  * Property for font reading library.
  */
@@ -356,6 +446,20 @@ public:
     static bool clipSurfaceViews;
     static bool hdr10bitPlus;
     static bool skipTelemetry;
+    static bool parallelPrepareTree;
+    static bool cpuTiledRendering;
+    static bool autoLayerCaching;
+    static bool asyncBitmapUpload;
+    static bool directHardwareDecode;
+    static bool shaderCacheWarmup;
+    static bool adaptiveCacheBudget;
+    static int backdropBlurQuality;
+    static int vectorDrawableDirectMaxPaths;
+    static int animatedImageDecodeThreads;
+    static int animatedImageFramesAhead;
+    static int animatedImageCacheBudgetKb;
+    static int frameInfoRingSize;
+    static bool stagedPreload;
 
     static int timeoutMultiplier;
 
@@ -47,6 +47,7 @@
 #include "utils/Color.h"
 #include "utils/MathUtils.h"
 #include "utils/NdkUtils.h"
+#include "utils/TimeUtils.h"
 
 using namespace android::uirenderer::renderthread;
 
@@ -253,6 +254,10 @@ void Readback::copySurfaceInto(ANativeWindow* window, const std::shared_ptr<Copy
     canvas->drawImageRect(image, imageSrcRect, imageDstRect, sampling, &paint, constraint);
     canvas->restore();
 
+    if (request->isAsync()) {
+        return readPixelsAsync(tmpSurface.get(), skBitmap, request);
+    }
+
     if (!tmpSurface->readPixels(*bitmap, 0, 0)) {
         // if we fail to readback from the GPU directly (e.g. 565) then we attempt to read into
         // 8888 and then convert that into the destination format before giving up.
@@ -271,6 +276,88 @@ void Readback::copySurfaceInto(ANativeWindow* window, const std::shared_ptr<Copy
     return request->onCopyFinished(CopyResult::Success);
 }
 
+namespace {
+
+struct AsyncRead {
+    Readback* readback;
+    std::shared_ptr<CopyRequest> request;
+    SkBitmap bitmap;
+    SkImageInfo readInfo;
+};
+
+}  // namespace
+
+void Readback::readPixelsAsync(SkSurface* surface, const SkBitmap& bitmap,
+                               const std::shared_ptr<CopyRequest>& request) {
+    ATRACE_CALL();
+    GrDirectContext* grContext = mRenderThread.getGrContext();
+    if (mPendingAsyncReads >= kMaxPendingAsyncReads) {
+        ATRACE_NAME("Wait for pending async reads");
+        grContext->submit(GrSyncCpu::kYes);
+        grContext->checkAsyncWorkCompletion();
+    }
+
+    // The surface was drawn at the size of the destination, the reads don't rescale it.
+    const SkImageInfo& readInfo = surface->imageInfo();
+    const SkIRect srcRect = SkIRect::MakeSize(readInfo.dimensions());
+    auto* read = new AsyncRead{this, request, bitmap, readInfo};
+    mPendingAsyncReads++;
+    if (const auto yuvColorSpace = request->getYuvColorSpace()) {
+        surface->asyncRescaleAndReadPixelsYUV420(
+                *yuvColorSpace, readInfo.refColorSpace(), srcRect, srcRect.size(),
+                SkImage::RescaleGamma::kSrc, SkImage::RescaleMode::kNearest,
+                &Readback::onAsyncReadFinished, read);
+    } else {
+        surface->asyncRescaleAndReadPixels(readInfo, srcRect, SkImage::RescaleGamma::kSrc,
+                                           SkImage::RescaleMode::kNearest,
+                                           &Readback::onAsyncReadFinished, read);
+    }
+    grContext->flushAndSubmit();
+    scheduleAsyncReadCheck();
+}
+
+void Readback::onAsyncReadFinished(void* context,
+                                   std::unique_ptr<const SkImage::AsyncReadResult> result) {
+    std::unique_ptr<AsyncRead> read(static_cast<AsyncRead*>(context));
+    read->readback->mPendingAsyncReads--;
+    if (!result) {
+        ALOGW("Asynchronous readback failed");
+        return read->request->onCopyFinished(CopyResult::UnknownError);
+    }
+    if (read->request->getYuvColorSpace()) {
+        read->request->onYuvCopyFinished(*result);
+        return read->request->onCopyFinished(CopyResult::Success);
+    }
+    // Converts to the format of the bitmap, if the GPU couldn't read in it.
+    const SkPixmap pixels(read->readInfo, result->data(0), result->rowBytes(0));
+    if (!pixels.readPixels(read->bitmap.pixmap())) {
+        ALOGW("Unable to convert content into the provided bitmap");
+        return read->request->onCopyFinished(CopyResult::UnknownError);
+    }
+    read->bitmap.notifyPixelsChanged();
+    read->request->onCopyFinished(CopyResult::Success);
+}
+
+void Readback::scheduleAsyncReadCheck() {
+    if (mAsyncReadCheckScheduled) {
+        return;
+    }
+    mAsyncReadCheckScheduled = true;
+    // The reads complete once their fences signal, which is only checked when asked.
+    mRenderThread.queue().postDelayed(1_ms, [this]() {
+        mAsyncReadCheckScheduled = false;
+        GrDirectContext* grContext = mRenderThread.getGrContext();
+        if (!grContext) {
+            // The reads were finished, or failed, along with the context.
+            return;
+        }
+        grContext->checkAsyncWorkCompletion();
+        if (mPendingAsyncReads > 0) {
+            scheduleAsyncReadCheck();
+        }
+    });
+}
+
 CopyResult Readback::copyHWBitmapInto(Bitmap* hwBitmap, SkBitmap* bitmap) {
     LOG_ALWAYS_FATAL_IF(!hwBitmap->isHardware());
 
@@ -16,8 +16,11 @@
 
 #pragma once
 
+#include <SkImage.h>
 #include <SkRefCnt.h>
 
+#include <memory>
+
 #include "CopyRequest.h"
 #include "Matrix.h"
 #include "Rect.h"
@@ -52,10 +55,23 @@ public:
 private:
     CopyResult copyImageInto(const sk_sp<SkImage>& image, const Rect& srcRect, SkBitmap* bitmap);
 
+    // Reads surface back into bitmap, or as YUV planes, without waiting for the GPU.
+    void readPixelsAsync(SkSurface* surface, const SkBitmap& bitmap,
+                         const std::shared_ptr<CopyRequest>& request);
+    static void onAsyncReadFinished(void* context,
+                                    std::unique_ptr<const SkImage::AsyncReadResult> result);
+    void scheduleAsyncReadCheck();
+
     bool copyLayerInto(Layer* layer, const SkRect* srcRect, const SkRect* dstRect,
                        SkBitmap* bitmap);
 
     renderthread::RenderThread& mRenderThread;
+
+    // The asynchronous reads that are waiting for the GPU. Past kMaxPendingAsyncReads, the
+    // RenderThread waits for the GPU rather than let the reads pile up.
+    static constexpr int kMaxPendingAsyncReads = 3;
+    int mPendingAsyncReads = 0;
+    bool mAsyncReadCheckScheduled = false;
 };
 
 }  // namespace uirenderer
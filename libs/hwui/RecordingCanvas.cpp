@@ -24,7 +24,10 @@
 #include <include/gpu/ganesh/SkMeshGanesh.h>
 #include <log/log.h>
 
+#include <algorithm>
+#include <atomic>
 #include <experimental/type_traits>
+#include <optional>
 #include <utility>
 
 #include "FeatureFlags.h"
@@ -54,6 +57,7 @@
 #include "effects/GainmapRenderer.h"
 #include "pipeline/skia/AnimatedDrawables.h"
 #include "pipeline/skia/FunctorDrawable.h"
+#include "utils/ChunkPool.h"
 #ifdef __ANDROID__
 #include "renderthread/CanvasContext.h"
 #endif
@@ -955,6 +959,58 @@ constexpr bool hasPaintWithFill(Args&&... args) {
     return (... || doesPaintHaveFill(args));
 }
 
+// The ops that draw() may skip when their bounds are outside of the clip. Drawables, functors,
+// vector drawables and meshes update their state or upload data when drawn, so they, like all save,
+// matrix and clip ops, are always replayed.
+template <class T>
+constexpr bool kQuickRejectable = false;
+template <>
+constexpr bool kQuickRejectable<DrawPath> = true;
+template <>
+constexpr bool kQuickRejectable<DrawRect> = true;
+template <>
+constexpr bool kQuickRejectable<DrawRegion> = true;
+template <>
+constexpr bool kQuickRejectable<DrawOval> = true;
+template <>
+constexpr bool kQuickRejectable<DrawArc> = true;
+template <>
+constexpr bool kQuickRejectable<DrawRRect> = true;
+template <>
+constexpr bool kQuickRejectable<DrawDRRect> = true;
+template <>
+constexpr bool kQuickRejectable<DrawImage> = true;
+template <>
+constexpr bool kQuickRejectable<DrawImageRect> = true;
+template <>
+constexpr bool kQuickRejectable<DrawImageLattice> = true;
+template <>
+constexpr bool kQuickRejectable<DrawTextBlob> = true;
+template <>
+constexpr bool kQuickRejectable<DrawVertices> = true;
+
+// Returns the local bounds of the pixels the op may touch, including the outset of its paint, or
+// nullopt if they are unknown. This matches what SkCanvas uses for its own quick rejects.
+template <class T>
+static std::optional<SkRect> quickRejectBounds(const T& op) {
+    std::optional<SkRect> bounds;
+    if constexpr (std::is_same_v<T, DrawTextBlob>) {
+        bounds = op.blob->bounds().makeOffset(op.x, op.y);
+    } else if constexpr (std::is_same_v<T, DrawPath>) {
+        if (op.path.isInverseFillType()) {
+            return std::nullopt;
+        }
+        bounds = op.getConservativeBounds();
+    } else {
+        bounds = op.getConservativeBounds();
+    }
+    if (!bounds || !op.paint.canComputeFastBounds()) {
+        return std::nullopt;
+    }
+    SkRect storage;
+    return op.paint.computeFastBounds(bounds->makeSorted(), &storage);
+}
+
 template <typename T, typename... Args>
 void* DisplayListData::push(size_t pod, Args&&... args) {
     size_t skip = SkAlignPtr(sizeof(T) + pod);
@@ -963,17 +1019,22 @@ void* DisplayListData::push(size_t pod, Args&&... args) {
         static_assert(is_power_of_two(SKLITEDL_PAGE),
                       "This math needs updating for non-pow2.");
         // Next greater multiple of SKLITEDL_PAGE.
-        fReserved = (fUsed + skip + SKLITEDL_PAGE) & ~(SKLITEDL_PAGE - 1);
-        fBytes.realloc(fReserved);
-        LOG_ALWAYS_FATAL_IF(fBytes.get() == nullptr, "realloc(%zd) failed", fReserved);
+        reserveBytes((fUsed + skip + SKLITEDL_PAGE) & ~(SKLITEDL_PAGE - 1));
     }
     LOG_FATAL_IF((fUsed + skip) > fReserved);
     auto op = (T*)(fBytes.get() + fUsed);
     fUsed += skip;
+    mOpCount++;
     new (op) T{std::forward<Args>(args)...};
     op->type = (uint32_t)T::kType;
     op->skip = skip;
 
+    if constexpr (kQuickRejectable<T>) {
+        if (auto bounds = quickRejectBounds(*op)) {
+            this->indexOp(fUsed - skip, fUsed, *bounds);
+        }
+    }
+
     // check if this is a fill op or not, in case we need to avoid messing with it with force invert
     if constexpr (!std::is_same_v<T, DrawTextBlob>) {
         if (hasPaintWithFill(args...)) {
@@ -1191,13 +1252,114 @@ static const void_fn dtor_fns[] = {
 };
 #undef X
 
+// Runs are capped so that a single op far outside of the clip doesn't keep its neighbours from
+// being rejected.
+static constexpr uint32_t kMaxOpsPerRun = 16;
+// Checking a run costs about as much as Skia's own quick reject of a single op.
+static constexpr uint32_t kMinOpsPerRun = 2;
+// Shorter lists are drawn without consulting the index at all.
+static constexpr size_t kMinIndexedOps = 16;
+
+static std::atomic<uint64_t> sQuickRejectSkippedOps{0};
+static std::atomic<uint64_t> sQuickRejectDrawnOps{0};
+static std::atomic<uint64_t> sReplayedOps{0};
+
+void DisplayListData::indexOp(size_t begin, size_t end, const SkRect& bounds) {
+    if (!mOpRuns.empty() && mOpRuns.back().end == begin &&
+        mOpRuns.back().opCount < kMaxOpsPerRun) {
+        OpRun& run = mOpRuns.back();
+        run.end = end;
+        run.opCount++;
+        run.bounds.join(bounds);
+    } else {
+        mOpRuns.push_back({static_cast<uint32_t>(begin), static_cast<uint32_t>(end), 1, bounds});
+    }
+}
+
+void DisplayListData::finishRecording() {
+    mOpRuns.erase(std::remove_if(mOpRuns.begin(), mOpRuns.end(),
+                                 [](const OpRun& run) { return run.opCount < kMinOpsPerRun; }),
+                  mOpRuns.end());
+    size_t indexedOps = 0;
+    for (const OpRun& run : mOpRuns) {
+        indexedOps += run.opCount;
+    }
+    if (indexedOps < kMinIndexedOps) {
+        mOpRuns.clear();
+    }
+    mOpRuns.shrink_to_fit();
+}
+
+DisplayListData::QuickRejectCounters DisplayListData::getQuickRejectCounters() {
+    return {.skippedOps = sQuickRejectSkippedOps.load(std::memory_order_relaxed),
+            .drawnOps = sQuickRejectDrawnOps.load(std::memory_order_relaxed)};
+}
+
+uint64_t DisplayListData::getReplayedOpCount() {
+    return sReplayedOps.load(std::memory_order_relaxed);
+}
+
 void DisplayListData::draw(SkCanvas* canvas) const {
     SkAutoCanvasRestore acr(canvas, false);
-    this->map(draw_fns, canvas, canvas->getTotalMatrix());
+    const SkMatrix original = canvas->getTotalMatrix();
+    if (mOpRuns.empty()) {
+        this->map(draw_fns, canvas, original);
+        sReplayedOps.fetch_add(mOpCount, std::memory_order_relaxed);
+        return;
+    }
+
+    // Same as map(), except that runs of draw ops whose bounds are outside of the clip are
+    // stepped over as a whole. The clip and matrix don't change within a run, so a single quick
+    // reject covers all of its ops.
+    uint64_t skippedOps = 0;
+    uint64_t drawnOps = 0;
+    auto run = mOpRuns.begin();
+    const uint8_t* start = fBytes.get();
+    const uint8_t* end = start + fUsed;
+    for (const uint8_t* ptr = start; ptr < end;) {
+        if (run != mOpRuns.end() && ptr == start + run->begin) {
+            if (canvas->quickReject(run->bounds)) {
+                skippedOps += run->opCount;
+                ptr = start + run->end;
+                ++run;
+                continue;
+            }
+            ++run;
+        }
+        auto op = (const Op*)ptr;
+        if (auto fn = draw_fns[op->type]) {
+            fn(op, canvas, original);
+        }
+        drawnOps++;
+        ptr += op->skip;
+    }
+    sQuickRejectSkippedOps.fetch_add(skippedOps, std::memory_order_relaxed);
+    sQuickRejectDrawnOps.fetch_add(drawnOps, std::memory_order_relaxed);
+    sReplayedOps.fetch_add(drawnOps, std::memory_order_relaxed);
 }
 
 DisplayListData::~DisplayListData() {
     this->reset();
+    ChunkPool::get().release(fBytes.release(), fReserved);
+}
+
+// Buffers of up to ChunkPool::kMaxChunkSize come from the ChunkPool, so a display list that is
+// recorded to replace one of a similar size reuses the buffer of the old one.
+void DisplayListData::reserveBytes(size_t size) {
+    if (fReserved > ChunkPool::kMaxChunkSize) {
+        fReserved = size;
+        fBytes.realloc(fReserved);
+        LOG_ALWAYS_FATAL_IF(fBytes.get() == nullptr, "realloc(%zd) failed", fReserved);
+        return;
+    }
+    size_t reserved = ChunkPool::chunkSize(size);
+    auto bytes = static_cast<uint8_t*>(ChunkPool::get().acquire(reserved));
+    if (fUsed) {
+        memcpy(bytes, fBytes.get(), fUsed);
+    }
+    ChunkPool::get().release(fBytes.release(), fReserved);
+    fBytes = AutoTMalloc<uint8_t>(bytes);
+    fReserved = reserved;
 }
 
 void DisplayListData::reset() {
@@ -1205,6 +1367,8 @@ void DisplayListData::reset() {
 
     // Leave fBytes and fReserved alone.
     fUsed = 0;
+    mOpCount = 0;
+    mOpRuns.clear();
 
     // TODO(b/372558459): reset here only?
     mColorArea.reset();
@@ -123,14 +123,49 @@ public:
     bool hasText() const { return mHasText; }
     bool hasFill() const { return mHasFill; }
     size_t usedSize() const { return fUsed; }
+    size_t opCount() const { return mOpCount; }
     size_t allocatedSize() const { return fReserved; }
 
     /** Returns true if this list should count ColorAreas as Ops are recorded. */
     bool shouldCountColorAreas() const;
 
+    /**
+     * Drops the parts of the quick reject index that aren't worth checking during draw(). Called
+     * once all ops have been recorded.
+     */
+    void finishRecording();
+
+    /** The number of runs of ops that draw() may skip as a whole, see mOpRuns. */
+    size_t indexedRunCount() const { return mOpRuns.size(); }
+
+    struct QuickRejectCounters {
+        // Ops that draw() skipped because their run was outside of the clip.
+        uint64_t skippedOps = 0;
+        // Ops of indexed lists that draw() replayed into the canvas.
+        uint64_t drawnOps = 0;
+    };
+
+    /** Returns the totals of all draw() calls of the process so far. */
+    static QuickRejectCounters getQuickRejectCounters();
+
+    /** Returns the number of ops that draw() replayed into a canvas in the process so far. */
+    static uint64_t getReplayedOpCount();
+
 private:
     friend class RecordingCanvas;
 
+    // A run of consecutive draw ops with no save, matrix or clip change in between, so that
+    // they can all be quick rejected with their combined local bounds. Offsets are into fBytes.
+    struct OpRun {
+        uint32_t begin;
+        uint32_t end;
+        uint32_t opCount;
+        SkRect bounds;
+    };
+
+    // Extends the current run of ops with the op at [begin, end), or starts a new one.
+    void indexOp(size_t begin, size_t end, const SkRect& bounds);
+
     void save();
     void saveLayer(const SkRect*, const SkPaint*, const SkImageFilter*, SkCanvas::SaveLayerFlags);
     void saveBehind(const SkRect*);
@@ -188,6 +223,7 @@ private:
 
     template <typename T, typename... Args>
     void* push(size_t, Args&&...);
+    void reserveBytes(size_t size);
 
     template <typename Fn, typename... Args>
     void map(const Fn[], Args...) const;
@@ -195,11 +231,15 @@ private:
     AutoTMalloc<uint8_t> fBytes;
     size_t fUsed = 0;
     size_t fReserved = 0;
+    size_t mOpCount = 0;
 
     bool mHasText : 1;
     bool mHasFill : 1;
 
     ColorArea mColorArea;
+
+    // Sorted by offset. Empty for lists that are too short to benefit from quick rejects.
+    std::vector<OpRun> mOpRuns;
 };
 
 class RecordingCanvas final : public SkCanvasVirtualEnforcer<SkNoDrawCanvas> {
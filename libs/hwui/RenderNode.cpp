@@ -62,6 +62,12 @@ static int64_t generateId() {
     return sNextId++;
 }
 
+static std::atomic<uint64_t> sPreparedNodeCount{0};
+
+uint64_t RenderNode::getPreparedNodeCount() {
+    return sPreparedNodeCount.load(std::memory_order_relaxed);
+}
+
 RenderNode::RenderNode()
         : mUniqueId(generateId())
         , mDirtyPropertyFields(0)
@@ -168,6 +174,89 @@ void RenderNode::damageSelf(TreeInfo& info) {
     }
 }
 
+// The number of frames a node must go without damage before its content is cached in a layer.
+static constexpr uint32_t kAutoLayerStableFrames = 3;
+// The fewest ops a subtree must record before rendering it into a layer beats replaying it.
+static constexpr size_t kAutoLayerMinOps = 64;
+
+// Counts the ops recorded by the subtree of node. Returns false if the subtree can't be cached in
+// a layer because it draws outside of it or with content that is updated behind hwui's back.
+static bool countAutoLayerOps(const RenderNode& node, size_t* outOpCount) {
+    if (node.properties().getProjectBackwards()) {
+        return false;
+    }
+    const skiapipeline::SkiaDisplayList* displayList = node.getDisplayList().asSkiaDl();
+    if (!displayList) {
+        return true;
+    }
+    if (displayList->hasFunctor() || displayList->hasHolePunches()) {
+        return false;
+    }
+    *outOpCount += displayList->mDisplayList.opCount();
+    for (const auto& child : displayList->mChildNodes) {
+        if (!countAutoLayerOps(*child.getRenderNode(), outOpCount)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RenderNode::canCacheAsLayer() const {
+    // The layer clips the content to the bounds of the node, so only nodes that clip to their
+    // bounds anyway look the same when cached.
+    const auto& layerProperties = mProperties.layerProperties();
+    return layerProperties.type() == LayerType::None && mProperties.getClipToBounds() &&
+           mProperties.fitsOnLayer() && isRenderable() && !mProperties.getProjectBackwards() &&
+           !mProperties.isProjectionReceiver() && layerProperties.getStretchEffect().isEmpty() &&
+           !layerProperties.getBackdropImageFilter() && !mDisplayList.hasFunctor() &&
+           !mDisplayList.hasHolePunches() && !mDisplayList.containsProjectionReceiver();
+}
+
+/**
+ * Promotes the node to a layer once its content has been stable for a few frames, so that the
+ * following frames reuse the rendered content instead of replaying the whole subtree, as long as
+ * the layer fits into what is left of the frame's budget. Returns whether the node is cached.
+ */
+bool RenderNode::updateAutoLayerCaching(TreeInfo& info) {
+    if (CC_LIKELY(!Properties::autoLayerCaching && !mProperties.isCachedAsLayer())) {
+        return false;
+    }
+    bool cache = Properties::autoLayerCaching && mWorthCaching &&
+                 mStableFrameCount >= kAutoLayerStableFrames && canCacheAsLayer();
+    if (cache) {
+        size_t layerBytes = static_cast<size_t>(getWidth()) * getHeight() * 4;
+        cache = layerBytes <= info.autoLayerBudget;
+        if (cache) {
+            info.autoLayerBudget -= layerBytes;
+        }
+    }
+    mProperties.setCachedAsLayer(cache);
+    return cache;
+}
+
+/**
+ * Counts the frames without damage inside of the node. The damage of the node's own properties
+ * goes to its parent, so a node that only moves or fades keeps its cache.
+ */
+void RenderNode::trackAutoLayerDamage(TreeInfo& info) {
+    if (CC_LIKELY(!Properties::autoLayerCaching && !mProperties.isCachedAsLayer())) {
+        return;
+    }
+    SkRect dirty;
+    info.damageAccumulator->peekAtDirty(&dirty);
+    if (!dirty.isEmpty()) {
+        // The content changes, stop caching it. pushLayerUpdate() then destroys the layer, and
+        // the damage still reaches the parent to redraw the node without it.
+        mStableFrameCount = 0;
+        mWorthCaching = false;
+        mProperties.setCachedAsLayer(false);
+    } else if (mStableFrameCount < kAutoLayerStableFrames &&
+               ++mStableFrameCount == kAutoLayerStableFrames) {
+        size_t opCount = 0;
+        mWorthCaching = countAutoLayerOps(*this, &opCount) && opCount >= kAutoLayerMinOps;
+    }
+}
+
 void RenderNode::prepareLayer(TreeInfo& info, uint32_t dirtyMask) {
     LayerType layerType = properties().effectiveLayerType();
     if (CC_UNLIKELY(layerType == LayerType::RenderLayer)) {
@@ -226,6 +315,7 @@ void RenderNode::pushLayerUpdate(TreeInfo& info) {
  * stencil buffer may be needed. Views that use a functor to draw will be forced onto a layer.
  */
 void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer) {
+    sPreparedNodeCount.fetch_add(1, std::memory_order_relaxed);
     if (mDamageGenerationId == info.damageGenerationId && mDamageGenerationId != 0) {
         // We hit the same node a second time in the same tree. We don't know the minimal
         // damage rect anymore, so just push the biggest we can onto our parent's transform
@@ -263,6 +353,14 @@ void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool fu
         mPositionListener->onPositionUpdated(*this, info);
     }
 
+    // Layers that cache the content of a node don't nest, the children of a cached node are
+    // rendered into its layer anyway.
+    const bool cachedAsLayer = updateAutoLayerCaching(info);
+    const size_t autoLayerBudget = info.autoLayerBudget;
+    if (cachedAsLayer) {
+        info.autoLayerBudget = 0;
+    }
+
     prepareLayer(info, animatorDirtyMask);
     if (info.mode == TreeInfo::MODE_FULL) {
         pushStagingDisplayListChanges(observer, info);
@@ -282,7 +380,11 @@ void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool fu
                 [this](RenderNode* child, TreeObserver& observer, TreeInfo& info,
                        bool functorsNeedLayer) {
                     child->prepareTreeImpl(observer, info, functorsNeedLayer);
-                    mHasHolePunches |= child->hasHolePunches();
+                    // Children that are prepared in parallel never have hole punches, so this
+                    // is only written from the thread that prepares this node.
+                    if (child->hasHolePunches()) {
+                        mHasHolePunches = true;
+                    }
                 });
         if (isDirty) {
             damageSelf(info);
@@ -290,6 +392,10 @@ void RenderNode::prepareTreeImpl(TreeObserver& observer, TreeInfo& info, bool fu
     } else {
         mHasHolePunches = false;
     }
+    if (cachedAsLayer) {
+        info.autoLayerBudget = autoLayerBudget;
+    }
+    trackAutoLayerDamage(info);
     pushLayerUpdate(info);
 
     if (!mProperties.getAllowForceDark()) {
@@ -438,6 +544,51 @@ void RenderNode::gatherColorAreasForSubtree(ColorArea& target, bool isModeFull)
     }
 }
 
+// Layers, projection and backdrop filters make a node's preparation depend on nodes outside of
+// its own subtree.
+static bool propertiesAllowParallelPrepare(const RenderProperties& properties) {
+    return properties.effectiveLayerType() != LayerType::RenderLayer &&
+           !properties.getProjectBackwards() && !properties.isProjectionReceiver() &&
+           !properties.layerProperties().getBackdropImageFilter() &&
+           properties.layerProperties().getStretchEffect().isEmpty();
+}
+
+bool RenderNode::canPrepareInParallel(bool isModeFull, size_t* outNodeCount) const {
+    // A node that is shared with another parent could be prepared twice at the same time, and
+    // animators, position listeners and layers all post work to the CanvasContext or the
+    // AnimationContext, which are RenderThread only.
+    if (mParentCount != 1 || hasLayer() || mAnimatorManager.hasAnimators() ||
+        mPositionListener.get() || !propertiesAllowParallelPrepare(mProperties)) {
+        return false;
+    }
+    // Syncing a display list changes the parent counts of the nodes of the old and the new one,
+    // which may be anywhere in the tree.
+    if (isModeFull && (mNeedsDisplayListSync || mPositionListenerDirty ||
+                       mAnimatorManager.hasStagingAnimators() ||
+                       !propertiesAllowParallelPrepare(mStagingProperties))) {
+        return false;
+    }
+    (*outNodeCount)++;
+
+    const skiapipeline::SkiaDisplayList* displayList = mDisplayList.asSkiaDl();
+    if (!displayList) {
+        return true;
+    }
+    // Functors, vector drawables and images are synced or uploaded through the RenderThread.
+    if (displayList->hasFunctor() || displayList->hasVectorDrawables() ||
+        displayList->hasHolePunches() || displayList->containsProjectionReceiver() ||
+        !displayList->mMutableImages.empty() || !displayList->mMeshBufferData.empty() ||
+        !displayList->mAnimatedImages.empty()) {
+        return false;
+    }
+    for (const auto& child : displayList->mChildNodes) {
+        if (!child.getRenderNode()->canPrepareInParallel(isModeFull, outNodeCount)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void RenderNode::handleForceDark(android::uirenderer::TreeInfo* info) {
     if (CC_UNLIKELY(info && isForceInvertDark(*info))) {
         ColorTransform transform;
@@ -561,6 +712,20 @@ void RenderNode::destroyLayers() {
     }
 }
 
+void RenderNode::destroyAutoLayers() {
+    if (mProperties.isCachedAsLayer()) {
+        mProperties.setCachedAsLayer(false);
+        mStableFrameCount = 0;
+        if (hasLayer()) {
+            this->setLayerSurface(nullptr);
+        }
+    }
+
+    if (mDisplayList) {
+        mDisplayList.updateChildren([](RenderNode* child) { child->destroyAutoLayers(); });
+    }
+}
+
 void RenderNode::decParentRefCount(TreeObserver& observer, TreeInfo* info) {
     LOG_ALWAYS_FATAL_IF(!mParentCount, "already 0!");
     mParentCount--;
@@ -652,6 +817,28 @@ const SkPath* RenderNode::getClippedOutline(const SkRect& clipRect) const {
     return &mClippedOutlineCache.clippedOutline;
 }
 
+const SkPath* RenderNode::getRevealClippedOutline(const SkPath& casterPath) const {
+    const SkPath* revealClipPath = properties().getRevealClip().getPath();
+    const uint32_t casterID = casterPath.getGenerationID();
+    const uint32_t revealClipID = revealClipPath->getGenerationID();
+    SkPath& revealClippedOutline = mRevealClippedOutlineCache.revealClippedOutline;
+
+    if (casterID != mRevealClippedOutlineCache.casterID ||
+        revealClipID != mRevealClippedOutlineCache.revealClipID) {
+        // update the cache keys
+        mRevealClippedOutlineCache.casterID = casterID;
+        mRevealClippedOutlineCache.revealClipID = revealClipID;
+
+        // update the cache value by recomputing a new path
+        Op(casterPath, *revealClipPath, kIntersect_SkPathOp, &revealClippedOutline);
+        revealClippedOutline.setIsVolatile(true);
+    } else {
+        // unchanged since the last frame, so worth caching by genID
+        revealClippedOutline.setIsVolatile(false);
+    }
+    return &revealClippedOutline;
+}
+
 using StringBuffer = FatVector<char, 128>;
 
 template <typename... T>
@@ -150,8 +150,12 @@ public:
     int getHeight() const { return properties().getHeight(); }
 
     virtual void prepareTree(TreeInfo& info);
+    // The number of nodes that prepareTree() visited in the process so far.
+    static uint64_t getPreparedNodeCount();
     void destroyHardwareResources(TreeInfo* info = nullptr);
     void destroyLayers();
+    // Drops the layers that cache the content of unchanged nodes, see updateAutoLayerCaching().
+    void destroyAutoLayers();
 
     // UI thread only!
     void addAnimator(const sp<BaseRenderNodeAnimator>& animator);
@@ -228,6 +232,13 @@ public:
     /** Accumulates all the background color areas of all children into the given target */
     void gatherColorAreasForSubtree(ColorArea& target, bool isModeFull);
 
+    /**
+     * Returns true if preparing the subtree rooted at this node only touches the nodes of that
+     * subtree, so that it may run on another thread in parallel with the preparation of its
+     * siblings. Adds the number of nodes in the subtree to outNodeCount.
+     */
+    bool canPrepareInParallel(bool isModeFull, size_t* outNodeCount) const;
+
 private:
     void computeOrderingImpl(RenderNodeOp* opState,
                              std::vector<RenderNodeOp*>* compositedChildrenOfProjectionSurface,
@@ -244,6 +255,9 @@ private:
     void pushStagingDisplayListChanges(TreeObserver& observer, TreeInfo& info);
     void prepareLayer(TreeInfo& info, uint32_t dirtyMask);
     void pushLayerUpdate(TreeInfo& info);
+    bool updateAutoLayerCaching(TreeInfo& info);
+    void trackAutoLayerDamage(TreeInfo& info);
+    bool canCacheAsLayer() const;
     void deleteDisplayList(TreeObserver& observer, TreeInfo* info = nullptr);
     void damageSelf(TreeInfo& info);
 
@@ -286,6 +300,12 @@ private:
     // mDisplayList, not mStagingDisplayList.
     uint32_t mParentCount;
 
+    // The number of consecutive frames without damage inside of this node, capped once the node
+    // has been stable for long enough to be cached in a layer.
+    uint32_t mStableFrameCount = 0;
+    // Whether the subtree draws enough to be worth caching, computed when it became stable.
+    bool mWorthCaching = false;
+
     bool mPositionListenerDirty = false;
     sp<PositionListener> mStagingPositionListener;
     sp<PositionListener> mPositionListener;
@@ -382,6 +402,18 @@ public:
      */
     const SkPath* getClippedOutline(const SkRect& clipRect) const;
 
+    /**
+     * Returns the intersection of the given shadow casting path, either the outline or the
+     * result of getClippedOutline(), with the reveal clip, cached like getClippedOutline().
+     * The result is volatile in the call that computes it, so that paths of animating reveals
+     * do not fill Skia's caches, and stable from its first reuse on, so that Skia can keep the
+     * shadow tessellation for its genID across frames.
+     *
+     * The returned path is only guaranteed to be valid until this function is called
+     * again or the RenderNode's outline or reveal clip is mutated.
+     */
+    const SkPath* getRevealClippedOutline(const SkPath& casterPath) const;
+
 private:
     /**
      * If this RenderNode has been used in a previous frame then the SkiaDisplayList
@@ -424,6 +456,16 @@ private:
         SkPath clippedOutline;
     };
     mutable ClippedOutlineCache mClippedOutlineCache;
+
+    struct RevealClippedOutlineCache {
+        // keys
+        uint32_t casterID = 0;
+        uint32_t revealClipID = 0;
+
+        // value
+        SkPath revealClippedOutline;
+    };
+    mutable RevealClippedOutlineCache mRevealClippedOutlineCache;
 };  // class RenderNode
 
 class MarkAndSweepRemoved : public TreeObserver {
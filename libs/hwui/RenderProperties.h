@@ -551,12 +551,16 @@ public:
 
     bool promotedToLayer() const {
         return mLayerProperties.mType == LayerType::None && fitsOnLayer() &&
-               (mComputedFields.mNeedLayerForFunctors || mLayerProperties.mImageFilter != nullptr ||
+               (mComputedFields.mNeedLayerForFunctors || mComputedFields.mCachedAsLayer ||
+                mLayerProperties.mImageFilter != nullptr ||
                 mLayerProperties.getStretchEffect().requiresLayer() ||
                 (!MathUtils::isZero(mPrimitiveFields.mAlpha) && mPrimitiveFields.mAlpha < 1 &&
                  mPrimitiveFields.mHasOverlappingRendering));
     }
 
+    void setCachedAsLayer(bool cachedAsLayer) { mComputedFields.mCachedAsLayer = cachedAsLayer; }
+    bool isCachedAsLayer() const { return mComputedFields.mCachedAsLayer; }
+
     LayerType effectiveLayerType() const {
         return CC_UNLIKELY(promotedToLayer()) ? LayerType::RenderLayer : mLayerProperties.mType;
     }
@@ -619,6 +623,9 @@ private:
 
         // Force layer on for functors to enable render features they don't yet support (clipping)
         bool mNeedLayerForFunctors = false;
+
+        // Set by RenderNode while its unchanged content is cached in a layer
+        bool mCachedAsLayer = false;
     } mComputedFields;
 };
 
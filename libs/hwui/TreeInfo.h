@@ -109,6 +109,13 @@ public:
 
     bool forceDrawFrame = false;
 
+    // Whether independent child subtrees may be prepared on the CommonPool threads, see
+    // RenderNode::canPrepareInParallel().
+    bool parallelPrepare = false;
+
+    // The bytes that RenderNodes may still use for layers that cache their content this frame.
+    size_t autoLayerBudget = 0;
+
     struct Out {
         bool hasFunctors = false;
         // This is only updated if evaluateAnimations is true
@@ -22,6 +22,7 @@
 #include <utils/Log.h>
 
 #include "PathParser.h"
+#include "Properties.h"
 #include "SkImage.h"
 #include "SkImageInfo.h"
 #include "SkSamplingOptions.h"
@@ -36,6 +37,8 @@ namespace uirenderer {
 namespace VectorDrawable {
 
 const int Tree::MAX_CACHED_BITMAP_SIZE = 2048;
+const size_t Tree::MAX_CACHED_LAYERS = 8;
+const int64_t Tree::MAX_CACHED_LAYER_PIXELS = 1024 * 1024;
 
 void Path::dump() {
     ALOGD("Path: %s has %zu points", mName.c_str(), mProperties.getData().points.size());
@@ -45,7 +48,7 @@ void Path::dump() {
 Path::Path(const char* pathStr, size_t strLength) {
     PathParser::ParseResult result;
     Data data;
-    PathParser::getPathDataFromAsciiString(&data, &result, pathStr, strLength);
+    PathParser::getPathDataFromAsciiStringCached(&data, &result, pathStr, strLength);
     mStagingProperties.setData(data);
 }
 
@@ -288,6 +291,53 @@ void Group::draw(SkCanvas* outCanvas, bool useStagingData) {
     // Restore the previous clip and matrix information.
 }
 
+void Group::drawChild(size_t index, SkCanvas* outCanvas, bool useStagingData) {
+    SkAutoCanvasRestore saver(outCanvas, true);
+    SkMatrix stackedMatrix;
+    getLocalMatrix(&stackedMatrix, useStagingData ? mStagingProperties : mProperties);
+    outCanvas->concat(stackedMatrix);
+    mChildren[index]->draw(outCanvas, useStagingData);
+}
+
+bool Group::hasClipPathChild() const {
+    for (auto& child : mChildren) {
+        if (child->isClipPath()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Group::isRasterDirty() const {
+    if (mRasterDirty) {
+        return true;
+    }
+    for (auto& child : mChildren) {
+        if (child->isRasterDirty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Group::clearRasterDirty() {
+    mRasterDirty = false;
+    for (auto& child : mChildren) {
+        child->clearRasterDirty();
+    }
+}
+
+int Group::countPaths(int limit) const {
+    int count = 0;
+    for (auto& child : mChildren) {
+        if (count >= limit) {
+            break;
+        }
+        count += child->countPaths(limit - count);
+    }
+    return count;
+}
+
 void Group::dump() {
     ALOGD("Group %s has %zu children: ", mName.c_str(), mChildren.size());
     ALOGD("Group translateX, Y : %f, %f, scaleX, Y: %f, %f", mProperties.getTranslateX(),
@@ -485,9 +535,14 @@ void Tree::getPaintFor(Paint* outPaint, const TreeProperties& prop) const {
 Bitmap& Tree::getBitmapUpdateIfDirty() {
     bool redrawNeeded = allocateBitmapIfNeeded(mCache, mProperties.getScaledWidth(),
                                                mProperties.getScaledHeight());
+    if (redrawNeeded) {
+        mLayerCache.layers.clear();
+        mLayerCache.enabled = false;
+    }
     if (redrawNeeded || mCache.dirty) {
         updateBitmapCache(*mCache.bitmap, false);
         mCache.dirty = false;
+        mLayerCache.enabled = true;
     }
     return *mCache.bitmap;
 }
@@ -502,6 +557,11 @@ void Tree::draw(SkCanvas* canvas, const SkRect& bounds, const SkPaint& inPaint)
     SkPaint paint = inPaint;
     paint.setAlpha(mProperties.getRootAlpha() * 255);
 
+    if (canDrawDirectly()) {
+        drawDirectly(canvas, bounds, paint);
+        return;
+    }
+
     sk_sp<SkImage> cachedBitmap = getBitmapUpdateIfDirty().makeImage();
 
     // HWUI always draws VD with bilinear filtering.
@@ -512,24 +572,105 @@ void Tree::draw(SkCanvas* canvas, const SkRect& bounds, const SkPaint& inPaint)
                           sampling, &paint, SkCanvas::kFast_SrcRectConstraint);
 }
 
+bool Tree::canDrawDirectly() const {
+    const int maxPaths = Properties::vectorDrawableDirectMaxPaths;
+    return maxPaths > 0 && mProperties.getViewportWidth() > 0 &&
+           mProperties.getViewportHeight() > 0 && mRootNode->countPaths(maxPaths + 1) <= maxPaths;
+}
+
+void Tree::drawDirectly(SkCanvas* canvas, const SkRect& bounds, const SkPaint& paint) {
+    ATRACE_NAME("VectorDrawable direct draw");
+    SkAutoCanvasRestore saver(canvas, true);
+    canvas->clipRect(bounds);
+    // The root alpha and the color filter apply to the tree as a whole, like they do to the
+    // bitmap cache.
+    if (paint.getAlpha() != 0xFF || paint.getColorFilter() ||
+        paint.getBlendMode_or(SkBlendMode::kSrcOver) != SkBlendMode::kSrcOver) {
+        canvas->saveLayer(bounds, &paint);
+    }
+    canvas->translate(bounds.fLeft, bounds.fTop);
+    canvas->scale(bounds.width() / mProperties.getViewportWidth(),
+                  bounds.height() / mProperties.getViewportHeight());
+    mRootNode->draw(canvas, false);
+}
+
 void Tree::updateBitmapCache(Bitmap& bitmap, bool useStagingData) {
     SkBitmap outCache;
     bitmap.getSkBitmap(&outCache);
     int cacheWidth = outCache.width();
     int cacheHeight = outCache.height();
-    ATRACE_FORMAT("VectorDrawable repaint %dx%d", cacheWidth, cacheHeight);
-    outCache.eraseColor(SK_ColorTRANSPARENT);
-    SkCanvas outCanvas(outCache);
     float viewportWidth =
             useStagingData ? mStagingProperties.getViewportWidth() : mProperties.getViewportWidth();
     float viewportHeight = useStagingData ? mStagingProperties.getViewportHeight()
                                           : mProperties.getViewportHeight();
     float scaleX = cacheWidth / viewportWidth;
     float scaleY = cacheHeight / viewportHeight;
+    if (!useStagingData) {
+        if (mLayerCache.enabled && canUseLayers(cacheWidth, cacheHeight) &&
+            updateLayers(outCache, scaleX, scaleY)) {
+            return;
+        }
+        mLayerCache.layers.clear();
+        mRootNode->clearRasterDirty();
+    }
+    ATRACE_FORMAT("VectorDrawable repaint %dx%d", cacheWidth, cacheHeight);
+    outCache.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas outCanvas(outCache);
     outCanvas.scale(scaleX, scaleY);
     mRootNode->draw(&outCanvas, useStagingData);
 }
 
+bool Tree::canUseLayers(int width, int height) const {
+    // A clip path applies to the siblings drawn after it, which can't be drawn apart from it.
+    const size_t count = mRootNode->getChildCount();
+    return count > 1 && count <= MAX_CACHED_LAYERS &&
+           static_cast<int64_t>(width) * height * count <= MAX_CACHED_LAYER_PIXELS &&
+           !mRootNode->hasClipPathChild();
+}
+
+bool Tree::updateLayers(SkBitmap& outCache, float scaleX, float scaleY) {
+    ATRACE_FORMAT("VectorDrawable repaint %dx%d in layers", outCache.width(), outCache.height());
+    const size_t count = mRootNode->getChildCount();
+    // The matrix of the root group and the scale of the cache apply to all the layers.
+    const bool redrawAll = mLayerCache.layers.size() != count || mLayerCache.scaleX != scaleX ||
+                           mLayerCache.scaleY != scaleY || mRootNode->arePropertiesRasterDirty();
+    mLayerCache.layers.resize(count);
+    mLayerCache.scaleX = scaleX;
+    mLayerCache.scaleY = scaleY;
+
+    int repainted = 0;
+    for (size_t i = 0; i < count; i++) {
+        SkBitmap& layer = mLayerCache.layers[i];
+        bool redraw = redrawAll || mRootNode->getChild(i).isRasterDirty();
+        if (layer.info() != outCache.info()) {
+            if (!layer.tryAllocPixels(outCache.info())) {
+                return false;
+            }
+            redraw = true;
+        }
+        if (redraw) {
+            layer.eraseColor(SK_ColorTRANSPARENT);
+            SkCanvas layerCanvas(layer);
+            layerCanvas.scale(scaleX, scaleY);
+            mRootNode->drawChild(i, &layerCanvas, false);
+            repainted++;
+        }
+    }
+    mRootNode->clearRasterDirty();
+    if (repainted == 0) {
+        // Only properties of the tree changed, like its root alpha, which apply when the cache
+        // is drawn.
+        return true;
+    }
+
+    outCache.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas outCanvas(outCache);
+    for (const SkBitmap& layer : mLayerCache.layers) {
+        outCanvas.drawImage(SkImages::RasterFromPixmap(layer.pixmap(), nullptr, nullptr), 0, 0);
+    }
+    return true;
+}
+
 bool Tree::allocateBitmapIfNeeded(Cache& cache, int width, int height) {
     if (!canReuseBitmap(cache.bitmap.get(), width, height)) {
         SkImageInfo info = SkImageInfo::MakeN32(width, height, kPremul_SkAlphaType);
@@ -123,9 +123,18 @@ public:
 
     virtual void forEachFillColor(const std::function<void(SkColor)>& func) const { }
 
+    // Whether the render thread properties of this node, or of any of its children, changed since
+    // the node was last drawn into the bitmap cache of its tree. Render thread only.
+    virtual bool isRasterDirty() const { return mRasterDirty; }
+    virtual void clearRasterDirty() { mRasterDirty = false; }
+    // Returns the number of paths in this node, counting no further than limit.
+    virtual int countPaths(int limit) const { return 1; }
+    virtual bool isClipPath() const { return false; }
+
 protected:
     std::string mName;
     PropertyChangedListener* mPropertyChangedListener = nullptr;
+    bool mRasterDirty = true;
 };
 
 class Path : public Node {
@@ -177,6 +186,7 @@ public:
             }
         } else if (prop == &mProperties) {
             mSkPathDirty = true;
+            mRasterDirty = true;
             if (mPropertyChangedListener) {
                 mPropertyChangedListener->onPropertyChanged();
             }
@@ -346,6 +356,7 @@ public:
                 mPropertyChangedListener->onStagingPropertyChanged();
             }
         } else if (properties == &mProperties) {
+            mRasterDirty = true;
             if (mPropertyChangedListener) {
                 mPropertyChangedListener->onPropertyChanged();
             }
@@ -377,6 +388,7 @@ public:
     ClipPath() : Path() {}
     void draw(SkCanvas* outCanvas, bool useStagingData) override;
     virtual void setAntiAlias(bool aa) {}
+    bool isClipPath() const override { return true; }
 };
 
 class Group : public Node {
@@ -463,6 +475,8 @@ public:
 
     // Methods below could be called from either UI thread or Render Thread.
     virtual void draw(SkCanvas* outCanvas, bool useStagingData) override;
+    // Draws the child at index alone, in the local matrix of the group.
+    void drawChild(size_t index, SkCanvas* outCanvas, bool useStagingData);
     void getLocalMatrix(SkMatrix* outMatrix, const GroupProperties& properties);
     void dump() override;
     static bool isValidProperty(int propertyId);
@@ -474,12 +488,24 @@ public:
                 mPropertyChangedListener->onStagingPropertyChanged();
             }
         } else {
+            mRasterDirty = true;
             if (mPropertyChangedListener) {
                 mPropertyChangedListener->onPropertyChanged();
             }
         }
     }
 
+    size_t getChildCount() const { return mChildren.size(); }
+    const Node& getChild(size_t index) const { return *mChildren[index]; }
+    bool hasClipPathChild() const;
+    // Whether the properties of the group itself changed since it was last drawn, regardless of
+    // its children. Render thread only.
+    bool arePropertiesRasterDirty() const { return mRasterDirty; }
+
+    bool isRasterDirty() const override;
+    void clearRasterDirty() override;
+    int countPaths(int limit) const override;
+
     virtual void setAntiAlias(bool aa) {
         for (auto& child : mChildren) {
             child->setAntiAlias(aa);
@@ -661,14 +687,35 @@ private:
         bool dirty = true;
     };
 
+    // The children of the root group rasterized each in its own layer, and composited into the
+    // bitmap cache. A change to one of them then only rasterizes that child again, which is what
+    // most AnimatedVectorDrawables animate. Render thread only.
+    class LayerCache {
+    public:
+        std::vector<SkBitmap> layers;
+        float scaleX = 0;
+        float scaleY = 0;
+        // Set once the bitmap cache was drawn at its current size. A tree that is drawn once
+        // doesn't pay for the memory of its layers.
+        bool enabled = false;
+    };
+
     bool allocateBitmapIfNeeded(Cache& cache, int width, int height);
     bool canReuseBitmap(Bitmap*, int width, int height);
     void updateBitmapCache(Bitmap& outCache, bool useStagingData);
+    bool canUseLayers(int width, int height) const;
+    bool updateLayers(SkBitmap& outCache, float scaleX, float scaleY);
+    bool canDrawDirectly() const;
+    void drawDirectly(SkCanvas* canvas, const SkRect& bounds, const SkPaint& paint);
 
     // Cap the bitmap size, such that it won't hurt the performance too much
     // and it won't crash due to a very large scale.
     // The drawable will look blurry above this size.
     const static int MAX_CACHED_BITMAP_SIZE;
+    // The most children of the root group, and pixels across all their layers, that are cached
+    // in layers.
+    const static size_t MAX_CACHED_LAYERS;
+    const static int64_t MAX_CACHED_LAYER_PIXELS;
 
     bool mAllowCaching = true;
     std::unique_ptr<Group> mRootNode;
@@ -678,6 +725,7 @@ private:
 
     Cache mStagingCache;
     Cache mCache;
+    LayerCache mLayerCache;
 
     PropertyChangedListener mPropertyChangedListener =
             PropertyChangedListener(&mCache.dirty, &mStagingCache.dirty);
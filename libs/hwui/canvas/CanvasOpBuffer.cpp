@@ -17,6 +17,10 @@
 #include "CanvasOpBuffer.h"
 
 #include "CanvasOps.h"
+#include "DamageAccumulator.h"
+
+#include <ostream>
+#include <string>
 
 namespace android::uirenderer {
 
@@ -32,26 +36,68 @@ void CanvasOpBuffer::updateChildren(std::function<void(RenderNode*)> updateFn) {
 }
 
 void CanvasOpBuffer::output(std::ostream& output, uint32_t level) const {
-    LOG_ALWAYS_FATAL("TODO");
+    for_each([&]<CanvasOpType T>(const CanvasOpContainer<T>* op) {
+        output << std::string(level * 2, ' ') << "CanvasOp " << static_cast<int>(T) << " ("
+               << op->size() << " bytes)";
+        if (!op->transform().isIdentity()) {
+            output << " transformed";
+        }
+        output << std::endl;
+    });
 }
 
 bool CanvasOpBuffer::prepareListAndChildren(
             TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer,
             std::function<void(RenderNode*, TreeObserver&, TreeInfo&, bool)> childFn) {
-    LOG_ALWAYS_FATAL("TODO");
+    if (!mHas.children) {
+        return false;
+    }
+    bool hasBackwardProjectedNodesHere = false;
+    bool hasBackwardProjectedNodesSubtree = false;
+    for (auto& iter : filter<CanvasOpType::DrawRenderNode>()) {
+        RenderNode* child = iter->renderNode.get();
+        Matrix4 mat4(iter.transform());
+        info.damageAccumulator->pushTransform(&mat4);
+        info.hasBackwardProjectedNodes = false;
+        childFn(child, observer, info, functorsNeedLayer);
+        hasBackwardProjectedNodesHere |= child->properties().getProjectBackwards();
+        hasBackwardProjectedNodesSubtree |= info.hasBackwardProjectedNodes;
+        info.damageAccumulator->popTransform();
+    }
+    // Projecting onto a receiver takes a SkiaDisplayList, so the backward projected nodes are
+    // left to a receiver further up the tree.
+    info.hasBackwardProjectedNodes =
+            hasBackwardProjectedNodesSubtree || hasBackwardProjectedNodesHere;
+    // None of the ops has animated content, such as vector drawables or animated images, that
+    // would need another frame.
     return false;
 }
 
 void CanvasOpBuffer::syncContents(const WebViewSyncData& data) {
-    LOG_ALWAYS_FATAL("TODO");
+    // There are no functor, vector drawable or animated image ops to sync.
 }
 
 void CanvasOpBuffer::onRemovedFromTree() {
-    LOG_ALWAYS_FATAL("TODO");
+    // There are no functor ops to notify.
 }
 
 void CanvasOpBuffer::applyColorTransform(ColorTransform transform) {
-    LOG_ALWAYS_FATAL("TODO");
+    if (!mHas.content) {
+        return;
+    }
+    // Like DisplayListData, which also transforms the paints of recorded, const ops in place.
+    for_each([transform]<CanvasOpType T>(const CanvasOpContainer<T>* op) {
+        if constexpr (requires { op->op().paint; }) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(op->op().paint)>, SkPaint>) {
+                SkPaint* paint = const_cast<SkPaint*>(&op->op().paint);
+                if constexpr (requires { op->op().bitmap; }) {
+                    transformPaint(transform, paint, op->op().bitmap->palette());
+                } else {
+                    transformPaint(transform, paint);
+                }
+            }
+        }
+    });
 }
 
 }  // namespace android::uirenderer
@@ -19,6 +19,7 @@
 #include <SkCanvas.h>
 #include <log/log.h>
 
+#include <optional>
 #include <vector>
 
 #include "CanvasOpBuffer.h"
@@ -32,13 +33,23 @@ void rasterizeCanvasBuffer(const CanvasOpBuffer& source, SkCanvas* destination)
     std::vector<SkMatrix> globalMatrixStack;
     SkMatrix& currentGlobalTransform = globalMatrixStack.emplace_back(SkMatrix::I());
 
+    // Consecutive ops mostly share a transform, which only needs to be set once. Restoring
+    // changes the canvas matrix behind our back though.
+    std::optional<SkMatrix> appliedTransform;
+
     source.for_each([&]<CanvasOpType T>(const CanvasOpContainer<T> * op) {
         if constexpr (CanvasOpTraits::can_draw<CanvasOp<T>>) {
             // Generic OP
             // First apply the current transformation
-            destination->setMatrix(SkMatrix::Concat(currentGlobalTransform, op->transform()));
+            if (!appliedTransform || *appliedTransform != op->transform()) {
+                destination->setMatrix(SkMatrix::Concat(currentGlobalTransform, op->transform()));
+                appliedTransform = op->transform();
+            }
             // Now draw it
             (*op)->draw(destination);
+            if constexpr (T == CanvasOpType::Restore) {
+                appliedTransform.reset();
+            }
             return;
         }
         LOG_ALWAYS_FATAL("TODO, unable to rasterize %d", static_cast<int>(T));
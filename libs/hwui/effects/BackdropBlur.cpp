@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BackdropBlur.h"
+
+#include <SkPaint.h>
+#include <SkRect.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+#include "Properties.h"
+#include "utils/Trace.h"
+
+namespace android::uirenderer {
+
+// The sigma left at the smallest level for each quality setting, below which the box filtering
+// of the levels starts to show. Indexed by Properties::backdropBlurQuality, 0 disables the levels.
+static constexpr float kMinLevelSigma[] = {0.0f, 4.0f, 2.0f};
+
+std::optional<SkSize> BackdropBlur::getBlurSigma(const SkImageFilter* filter) {
+    // SkImageFilters::Blur() wraps the blur in a crop filter when it has a crop rect.
+    if (!filter || strcmp(filter->getTypeName(), "SkBlurImageFilter") != 0 ||
+        filter->countInputs() != 1 || filter->getInput(0)) {
+        return std::nullopt;
+    }
+    // The fast bounds of a blur are its source outset by 3 sigma.
+    const SkRect bounds = filter->computeFastBounds(SkRect::MakeEmpty());
+    return SkSize::Make(bounds.width() / 6.0f, bounds.height() / 6.0f);
+}
+
+int BackdropBlur::getDownsampleLevels(const SkImageFilter* filter) {
+    if (Properties::backdropBlurQuality <= 0) {
+        return 0;
+    }
+    const auto sigma = getBlurSigma(filter);
+    return sigma ? getDownsampleLevels(*sigma, Properties::backdropBlurQuality) : 0;
+}
+
+int BackdropBlur::getDownsampleLevels(SkSize sigma, int quality) {
+    if (quality <= 0) {
+        return 0;
+    }
+    const float minLevelSigma =
+            kMinLevelSigma[std::min<size_t>(quality, std::size(kMinLevelSigma) - 1)];
+    const float minSigma = std::min(sigma.width(), sigma.height());
+    if (minSigma < minLevelSigma * 2) {
+        return 0;
+    }
+    return std::min(kMaxLevels, static_cast<int>(std::log2(minSigma / minLevelSigma)));
+}
+
+SkSurface* BackdropBlur::getLevelSurface(SkCanvas* canvas, size_t index, const SkImageInfo& info) {
+    if (mLevels.size() <= index) {
+        mLevels.resize(index + 1);
+    }
+    sk_sp<SkSurface>& surface = mLevels[index];
+    if (!surface || surface->imageInfo() != info) {
+        surface = canvas->makeSurface(info);
+    }
+    return surface.get();
+}
+
+sk_sp<SkImage> BackdropBlur::blur(SkCanvas* canvas, sk_sp<SkImage> image,
+                                  const SkImageFilter* filter, int levels) {
+    ATRACE_NAME("BackdropBlur");
+    const SkSamplingOptions linear(SkFilterMode::kLinear);
+    SkPaint copyPaint;
+    copyPaint.setBlendMode(SkBlendMode::kSrc);
+
+    const SkImageInfo info = SkImageInfo::Make(image->dimensions(), image->colorType(),
+                                               kPremul_SkAlphaType, image->refColorSpace());
+    const SkISize sourceSize = image->dimensions();
+    std::vector<SkISize> sizes = {sourceSize};
+    for (int level = 1; level <= levels; level++) {
+        const SkISize& previous = sizes.back();
+        sizes.push_back({std::max(1, (previous.width() + 1) / 2),
+                         std::max(1, (previous.height() + 1) / 2)});
+        SkSurface* surface = getLevelSurface(canvas, level - 1, info.makeDimensions(sizes.back()));
+        if (!surface) {
+            return nullptr;
+        }
+        surface->getCanvas()->drawImageRect(image, SkRect::Make(sizes.back()), linear, &copyPaint);
+        image = surface->makeImageSnapshot();
+    }
+
+    // Blurs at the smallest level. The filter is in the space of the backdrop, the scale lets
+    // Skia map its sigma to the level.
+    const SkISize& smallest = sizes.back();
+    SkSurface* blurSurface = getLevelSurface(canvas, levels, info.makeDimensions(smallest));
+    if (!blurSurface) {
+        return nullptr;
+    }
+    {
+        SkCanvas* blurCanvas = blurSurface->getCanvas();
+        SkAutoCanvasRestore acr(blurCanvas, true);
+        blurCanvas->clear(SK_ColorTRANSPARENT);
+        blurCanvas->scale(smallest.width() / static_cast<float>(sourceSize.width()),
+                          smallest.height() / static_cast<float>(sourceSize.height()));
+        SkPaint blurPaint;
+        blurPaint.setImageFilter(sk_ref_sp(const_cast<SkImageFilter*>(filter)));
+        blurCanvas->drawImageRect(image, SkRect::Make(sourceSize), linear, &blurPaint);
+    }
+    image = blurSurface->makeImageSnapshot();
+
+    // Doubles the result back up, reusing the levels, up to half the size of the backdrop. The
+    // caller draws the last step.
+    for (int level = levels - 1; level >= 1; level--) {
+        SkSurface* surface = getLevelSurface(canvas, level - 1, info.makeDimensions(sizes[level]));
+        if (!surface) {
+            return nullptr;
+        }
+        surface->getCanvas()->drawImageRect(image, SkRect::Make(sizes[level]), linear, &copyPaint);
+        image = surface->makeImageSnapshot();
+    }
+    return image;
+}
+
+}  // namespace android::uirenderer
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <SkCanvas.h>
+#include <SkImage.h>
+#include <SkImageFilter.h>
+#include <SkRefCnt.h>
+#include <SkSize.h>
+#include <SkSurface.h>
+
+#include <optional>
+#include <vector>
+
+namespace android::uirenderer {
+
+/**
+ * Blurs the backdrop of a RenderNode at a fraction of its resolution.
+ *
+ * The backdrop is halved a number of times with linear filtering, which box filters it, blurred
+ * with the backdrop filter scaled to the smallest level, and doubled back up level by level. The
+ * blur itself is still the Gaussian of the filter, with its edge treatment, but runs over up to
+ * 256 times fewer pixels. The levels are kept from one frame to the next, so that a backdrop of
+ * the same size doesn't allocate any textures.
+ *
+ * Only plain blurs of the backdrop, as made by RenderEffect.createBlurEffect() without an input,
+ * take this path, see getDownsampleLevels(). Properties::backdropBlurQuality trades the quality
+ * of the result for the number of levels.
+ */
+class BackdropBlur {
+public:
+    static constexpr int kMaxLevels = 4;
+
+    /**
+     * Returns the sigma of filter if it is a plain blur of its source, or nullopt for any other
+     * filter, including blurs of an input filter or with a crop rect.
+     */
+    static std::optional<SkSize> getBlurSigma(const SkImageFilter* filter);
+
+    /**
+     * Returns how many times the backdrop can be halved before it is blurred by filter, given
+     * the quality setting. 0 means that filter must be applied as is.
+     */
+    static int getDownsampleLevels(const SkImageFilter* filter);
+    static int getDownsampleLevels(SkSize sigma, int quality);
+
+    /**
+     * Blurs image with filter, halving it levels times. The result is half the size of image,
+     * and is to be drawn scaled up to its bounds. canvas is the canvas that the result will be
+     * drawn into, the levels are made compatible with it.
+     */
+    sk_sp<SkImage> blur(SkCanvas* canvas, sk_sp<SkImage> image, const SkImageFilter* filter,
+                        int levels);
+
+private:
+    SkSurface* getLevelSurface(SkCanvas* canvas, size_t index, const SkImageInfo& info);
+
+    // The surfaces of the levels from 1/2 down to 1/2^levels, followed by the blurred level.
+    std::vector<sk_sp<SkSurface>> mLevels;
+};
+
+}  // namespace android::uirenderer
@@ -176,6 +176,11 @@ private:
     SkRuntimeShaderBuilder mBuilder{mShader};
     SkGainmapInfo mGainmapInfo;
     std::mutex mUniformGuard;
+    // The uniforms of the last build and the weight they were built for. Every target ratio at or
+    // beyond either end of the gainmap's display ratio range gives the same weight, so these are
+    // reused draw after draw unless the ratio is moving inside that range.
+    float mLastW = 0.f;
+    sk_sp<const SkData> mLastUniforms;
 
     void setupChildren(const sk_sp<const SkImage>& baseImage,
                        const sk_sp<const SkImage>& gainmapImage, SkTileMode tileModeX,
@@ -274,8 +279,15 @@ private:
             if (mGainmapInfo.fBaseImageType == SkGainmapInfo::BaseImageType::kHDR) {
                 W -= 1.f;
             }
+            if (mLastUniforms && W == mLastW) {
+                return mLastUniforms;
+            }
+            // Writing the uniform makes a copy of the uniform block if a previous build is still
+            // referenced, so avoid it when the weight did not change
             mBuilder.uniform("W") = W;
             uniforms = mBuilder.uniforms();
+            mLastW = W;
+            mLastUniforms = uniforms;
         }
         return uniforms;
     }
@@ -23,17 +23,32 @@
 #include <optional>
 
 #include "AnimatedImageThread.h"
+#include "Properties.h"
 #include "pipeline/skia/SkiaUtils.h"
 
 namespace android {
 
+using uirenderer::AnimatedImageThread;
+using uirenderer::Properties;
+
+// Spreads the drawables over the AnimatedImageThreads.
+static std::atomic<uint32_t> sNextDecodeThreadKey = 0;
+
 AnimatedImageDrawable::AnimatedImageDrawable(sk_sp<SkAnimatedImage> animatedImage, size_t bytesUsed,
                                              SkEncodedImageFormat format)
-        : mSkAnimatedImage(std::move(animatedImage)), mBytesUsed(bytesUsed), mFormat(format) {
+        : mSkAnimatedImage(std::move(animatedImage))
+        , mBytesUsed(bytesUsed)
+        , mFormat(format)
+        , mDecodeThreadKey(sNextDecodeThreadKey++) {
     mTimeToShowNextSnapshot = ms2ns(currentFrameDuration());
     setStagingBounds(mSkAnimatedImage->getBounds());
 }
 
+AnimatedImageDrawable::~AnimatedImageDrawable() {
+    // The tasks of the AnimatedImageThread hold a reference, none is left.
+    AnimatedImageThread::releaseFrames(mReservedFrames * frameBytes());
+}
+
 void AnimatedImageDrawable::syncProperties() {
     mProperties = mStagingProperties;
 }
@@ -52,6 +67,9 @@ bool AnimatedImageDrawable::start() {
 bool AnimatedImageDrawable::stop() {
     bool wasRunning = mRunning;
     mRunning = false;
+    // The animation resets when it starts again, the frames decoded ahead won't be shown.
+    std::unique_lock lock{mSwapLock};
+    dropDecodedSnapshotsLocked();
     return wasRunning;
 }
 
@@ -59,9 +77,58 @@ bool AnimatedImageDrawable::isRunning() {
     return mRunning;
 }
 
-bool AnimatedImageDrawable::nextSnapshotReady() const {
-    return mNextSnapshot.valid() &&
-           mNextSnapshot.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+size_t AnimatedImageDrawable::frameBytes() const {
+    const SkRect bounds = mSkAnimatedImage->getBounds();
+    return static_cast<size_t>(bounds.width()) * static_cast<size_t>(bounds.height()) * 4;
+}
+
+void AnimatedImageDrawable::scheduleDecodeLocked() {
+    if (mDecodePending || mDecodedFinalFrame ||
+        mDecodedSnapshots.size() >= static_cast<size_t>(Properties::animatedImageFramesAhead)) {
+        return;
+    }
+    if (!mDecodedSnapshots.empty()) {
+        // Beyond the first frame ahead, which is always decoded.
+        if (!AnimatedImageThread::reserveFrame(frameBytes())) {
+            return;
+        }
+        mReservedFrames++;
+    }
+    mDecodePending = true;
+    AnimatedImageThread::getInstance(mDecodeThreadKey)
+            .decodeNextFrame(sk_ref_sp(this), mDecodeGeneration);
+}
+
+void AnimatedImageDrawable::dropDecodedSnapshotsLocked() {
+    mDecodedSnapshots.clear();
+    mDecodePending = false;
+    mDecodedFinalFrame = false;
+    mDecodeGeneration++;
+    AnimatedImageThread::releaseFrames(mReservedFrames * frameBytes());
+    mReservedFrames = 0;
+}
+
+void AnimatedImageDrawable::popDecodedSnapshotLocked() {
+    mSnapshot = std::move(mDecodedSnapshots.front());
+    mDecodedSnapshots.pop_front();
+    if (mReservedFrames > 0) {
+        AnimatedImageThread::releaseFrames(frameBytes());
+        mReservedFrames--;
+    }
+}
+
+void AnimatedImageDrawable::addDecodedSnapshot(Snapshot&& snapshot, uint32_t generation) {
+    std::unique_lock lock{mSwapLock};
+    if (generation != mDecodeGeneration) {
+        return;
+    }
+    mDecodePending = false;
+    mDecodedFinalFrame = snapshot.mDurationMS == SkAnimatedImage::kFinished;
+    mDecodedSnapshots.push_back(std::move(snapshot));
+    if (mRunning) {
+        // Keeps decoding ahead without waiting for the next draw.
+        scheduleDecodeLocked();
+    }
 }
 
 // Only called on the RenderThread while UI thread is locked.
@@ -78,7 +145,7 @@ bool AnimatedImageDrawable::isDirty(nsecs_t* outDelay) {
     std::unique_lock lock{mSwapLock};
     mCurrentTime += currentTime - lastWallTime;
 
-    if (!mNextSnapshot.valid()) {
+    if (mDecodedSnapshots.empty() && !mDecodePending) {
         // Need to trigger onDraw in order to start decoding the next frame.
         *outDelay = mTimeToShowNextSnapshot - mCurrentTime;
         return true;
@@ -86,12 +153,11 @@ bool AnimatedImageDrawable::isDirty(nsecs_t* outDelay) {
 
     if (mTimeToShowNextSnapshot > mCurrentTime) {
         *outDelay = mTimeToShowNextSnapshot - mCurrentTime;
-    } else if (nextSnapshotReady()) {
+    } else if (!mDecodedSnapshots.empty()) {
         // We have not yet updated mTimeToShowNextSnapshot. Read frame duration
-        // directly from mSkAnimatedImage.
-        lock.unlock();
-        std::unique_lock imageLock{mImageLock};
-        *outDelay = ms2ns(currentFrameDuration());
+        // from the next snapshot.
+        const int durationMS = mDecodedSnapshots.front().mDurationMS;
+        *outDelay = durationMS == SkAnimatedImage::kFinished ? 0 : ms2ns(durationMS);
         return true;
     } else {
         // The next snapshot has not yet been decoded, but we've already passed
@@ -104,19 +170,29 @@ bool AnimatedImageDrawable::isDirty(nsecs_t* outDelay) {
 }
 
 // Only called on the AnimatedImageThread.
-AnimatedImageDrawable::Snapshot AnimatedImageDrawable::decodeNextFrame() {
+void AnimatedImageDrawable::decodeNextFrame(uint32_t generation) {
+    {
+        std::unique_lock lock{mSwapLock};
+        if (generation != mDecodeGeneration) {
+            // Dropped, and reset when it starts again.
+            return;
+        }
+    }
+    ATRACE_NAME("AnimatedImageDrawable::decodeNextFrame");
     Snapshot snap;
     {
+        // The snapshots refer to the pixels of their frames, which SkAnimatedImage doesn't
+        // reuse while they are referred to. Each snapshot decoded ahead keeps its frame.
         std::unique_lock lock{mImageLock};
         snap.mDurationMS = adjustFrameDuration(mSkAnimatedImage->decodeNextFrame());
         snap.mPic = mSkAnimatedImage->makePictureSnapshot();
     }
 
-    return snap;
+    addDecodedSnapshot(std::move(snap), generation);
 }
 
 // Only called on the AnimatedImageThread.
-AnimatedImageDrawable::Snapshot AnimatedImageDrawable::reset() {
+void AnimatedImageDrawable::reset(uint32_t generation) {
     Snapshot snap;
     {
         std::unique_lock lock{mImageLock};
@@ -125,7 +201,7 @@ AnimatedImageDrawable::Snapshot AnimatedImageDrawable::reset() {
         snap.mDurationMS = currentFrameDuration();
     }
 
-    return snap;
+    addDecodedSnapshot(std::move(snap), generation);
 }
 
 // Update the matrix to map from the intrinsic bounds of the SkAnimatedImage to
@@ -183,15 +259,18 @@ void AnimatedImageDrawable::onDraw(SkCanvas* canvas) {
     } else if (starting) {
         // The image has animated, and now is being reset. Queue up the first
         // frame, but keep showing the current frame until the first is ready.
-        auto& thread = uirenderer::AnimatedImageThread::getInstance();
-        mNextSnapshot = thread.reset(sk_ref_sp(this));
+        std::unique_lock lock{mSwapLock};
+        dropDecodedSnapshotsLocked();
+        mDecodePending = true;
+        AnimatedImageThread::getInstance(mDecodeThreadKey)
+                .reset(sk_ref_sp(this), mDecodeGeneration);
     }
 
     bool finalFrame = false;
-    if (mRunning && nextSnapshotReady()) {
+    if (mRunning) {
         std::unique_lock lock{mSwapLock};
-        if (mCurrentTime >= mTimeToShowNextSnapshot) {
-            mSnapshot = mNextSnapshot.get();
+        if (!mDecodedSnapshots.empty() && mCurrentTime >= mTimeToShowNextSnapshot) {
+            popDecodedSnapshotLocked();
             const nsecs_t timeToShowCurrentSnap = mTimeToShowNextSnapshot;
             if (mSnapshot.mDurationMS == SkAnimatedImage::kFinished) {
                 finalFrame = true;
@@ -209,9 +288,9 @@ void AnimatedImageDrawable::onDraw(SkCanvas* canvas) {
         }
     }
 
-    if (mRunning && !mNextSnapshot.valid()) {
-        auto& thread = uirenderer::AnimatedImageThread::getInstance();
-        mNextSnapshot = thread.decodeNextFrame(sk_ref_sp(this));
+    if (mRunning) {
+        std::unique_lock lock{mSwapLock};
+        scheduleDecodeLocked();
     }
 
     if (!drawDirectly) {
@@ -27,7 +27,8 @@
 #include <utils/RefBase.h>
 #include <utils/Timers.h>
 
-#include <future>
+#include <atomic>
+#include <deque>
 #include <mutex>
 
 namespace android {
@@ -50,6 +51,7 @@ public:
     // Snapshots.
     AnimatedImageDrawable(sk_sp<SkAnimatedImage> animatedImage, size_t bytesUsed,
                           SkEncodedImageFormat format);
+    ~AnimatedImageDrawable() override;
 
     /**
      * This updates the internal time and returns true if the image needs
@@ -109,9 +111,10 @@ public:
         PREVENT_COPY_AND_ASSIGN(Snapshot);
     };
 
-    // These are only called on AnimatedImageThread.
-    Snapshot decodeNextFrame();
-    Snapshot reset();
+    // These are only called on AnimatedImageThread. They add the snapshot of a decoded frame,
+    // unless the decoded frames were dropped after the task was posted, in a previous generation.
+    void decodeNextFrame(uint32_t generation);
+    void reset(uint32_t generation);
 
     size_t byteSize() const { return sizeof(*this) + mBytesUsed; }
 
@@ -123,17 +126,30 @@ private:
     const size_t mBytesUsed;
     const SkEncodedImageFormat mFormat;
 
-    bool mRunning = false;
+    // Also read on AnimatedImageThread.
+    std::atomic_bool mRunning = false;
     bool mStarting = false;
 
     // A snapshot of the current frame to draw.
     Snapshot mSnapshot;
 
-    std::future<Snapshot> mNextSnapshot;
-
-    bool nextSnapshotReady() const;
-
-    // When to switch from mSnapshot to mNextSnapshot.
+    // The frames decoded ahead of mSnapshot, in order. At most PROPERTY_ANIMATED_IMAGE_FRAMES_AHEAD
+    // of them, the ones beyond the first within the budget of AnimatedImageThread. Guarded by
+    // mSwapLock, as the fields below up to mReservedFrames.
+    std::deque<Snapshot> mDecodedSnapshots;
+    // Whether a decode or a reset is posted to the AnimatedImageThread.
+    bool mDecodePending = false;
+    // Whether the last decoded frame is the final one, there is nothing to decode after it.
+    bool mDecodedFinalFrame = false;
+    // Bumped when the decoded frames are dropped, to ignore the tasks posted before.
+    uint32_t mDecodeGeneration = 0;
+    // The number of frames reserved from the budget of AnimatedImageThread.
+    size_t mReservedFrames = 0;
+
+    // Picks the AnimatedImageThread of this drawable.
+    const uint32_t mDecodeThreadKey;
+
+    // When to switch from mSnapshot to the first of mDecodedSnapshots.
     nsecs_t mTimeToShowNextSnapshot = 0;
 
     // The current time for the drawable itself.
@@ -167,6 +183,16 @@ private:
 
     int adjustFrameDuration(int);
     int currentFrameDuration();
+
+    // The memory of a decoded frame.
+    size_t frameBytes() const;
+
+    // These are called with mSwapLock held.
+    void scheduleDecodeLocked();
+    void dropDecodedSnapshotsLocked();
+    void popDecodedSnapshotLocked();
+
+    void addDecodedSnapshot(Snapshot&& snapshot, uint32_t generation);
 };
 
 }  // namespace android
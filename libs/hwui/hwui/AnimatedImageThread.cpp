@@ -20,16 +20,26 @@
 #include <sys/resource.h>
 #endif
 
+#include <atomic>
+#include <vector>
+
+#include "Properties.h"
+
 namespace android {
 namespace uirenderer {
 
-AnimatedImageThread& AnimatedImageThread::getInstance() {
-    static sp<AnimatedImageThread> sInstance = []() {
-        sp<AnimatedImageThread> thread = sp<AnimatedImageThread>::make();
-        thread->start("AnimatedImageThread");
-        return thread;
+static std::atomic<size_t> sReservedBytes = 0;
+
+AnimatedImageThread& AnimatedImageThread::getInstance(uint32_t key) {
+    static const std::vector<sp<AnimatedImageThread>> sInstances = []() {
+        std::vector<sp<AnimatedImageThread>> threads(Properties::animatedImageDecodeThreads);
+        for (sp<AnimatedImageThread>& thread : threads) {
+            thread = sp<AnimatedImageThread>::make();
+            thread->start("AnimatedImageThread");
+        }
+        return threads;
     }();
-    return *sInstance;
+    return *sInstances[key % sInstances.size()];
 }
 
 AnimatedImageThread::AnimatedImageThread() {
@@ -38,14 +48,29 @@ AnimatedImageThread::AnimatedImageThread() {
 #endif
 }
 
-std::future<AnimatedImageDrawable::Snapshot> AnimatedImageThread::decodeNextFrame(
-        const sk_sp<AnimatedImageDrawable>& drawable) {
-    return queue().async([drawable]() { return drawable->decodeNextFrame(); });
+void AnimatedImageThread::decodeNextFrame(const sk_sp<AnimatedImageDrawable>& drawable,
+                                          uint32_t generation) {
+    queue().post([drawable, generation]() { drawable->decodeNextFrame(generation); });
+}
+
+void AnimatedImageThread::reset(const sk_sp<AnimatedImageDrawable>& drawable,
+                                uint32_t generation) {
+    queue().post([drawable, generation]() { drawable->reset(generation); });
+}
+
+bool AnimatedImageThread::reserveFrame(size_t bytes) {
+    const size_t budget = static_cast<size_t>(Properties::animatedImageCacheBudgetKb) * 1024;
+    size_t reserved = sReservedBytes.load();
+    do {
+        if (reserved + bytes > budget) {
+            return false;
+        }
+    } while (!sReservedBytes.compare_exchange_weak(reserved, reserved + bytes));
+    return true;
 }
 
-std::future<AnimatedImageDrawable::Snapshot> AnimatedImageThread::reset(
-        const sk_sp<AnimatedImageDrawable>& drawable) {
-    return queue().async([drawable]() { return drawable->reset(); });
+void AnimatedImageThread::releaseFrames(size_t bytes) {
+    sReservedBytes -= bytes;
 }
 
 }  // namespace uirenderer
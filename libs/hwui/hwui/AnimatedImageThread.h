@@ -22,6 +22,8 @@
 
 #include <SkRefCnt.h>
 
+#include <cstdint>
+
 namespace android {
 
 namespace uirenderer {
@@ -30,11 +32,21 @@ class AnimatedImageThread : private ThreadBase {
     PREVENT_COPY_AND_ASSIGN(AnimatedImageThread);
 
 public:
-    static AnimatedImageThread& getInstance();
-
-    std::future<AnimatedImageDrawable::Snapshot> decodeNextFrame(
-            const sk_sp<AnimatedImageDrawable>&);
-    std::future<AnimatedImageDrawable::Snapshot> reset(const sk_sp<AnimatedImageDrawable>&);
+    /**
+     * Returns one of the PROPERTY_ANIMATED_IMAGE_DECODE_THREADS threads, by key. All the frames of
+     * a drawable are decoded on the thread of its key so that they are decoded in order.
+     */
+    static AnimatedImageThread& getInstance(uint32_t key);
+
+    void decodeNextFrame(const sk_sp<AnimatedImageDrawable>&, uint32_t generation);
+    void reset(const sk_sp<AnimatedImageDrawable>&, uint32_t generation);
+
+    /**
+     * Reserves the memory of a frame decoded ahead from the budget shared by all the drawables,
+     * see PROPERTY_ANIMATED_IMAGE_CACHE_BUDGET. Returns false if it doesn't fit.
+     */
+    static bool reserveFrame(size_t bytes);
+    static void releaseFrames(size_t bytes);
 
 private:
     friend sp<AnimatedImageThread>;
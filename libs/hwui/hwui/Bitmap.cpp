@@ -223,6 +223,14 @@ sk_sp<Bitmap> Bitmap::allocateHardwareBitmap(const SkBitmap& bitmap) {
 #endif
 }
 
+sk_sp<Bitmap> Bitmap::allocateHardwareBitmapAsync(const SkBitmap& bitmap) {
+#ifdef __ANDROID__  // Layoutlib does not support hardware acceleration
+    return uirenderer::HardwareBitmapUploader::allocateHardwareBitmapAsync(bitmap);
+#else
+    return allocateHardwareBitmap(bitmap);
+#endif
+}
+
 sk_sp<Bitmap> Bitmap::allocateHeapBitmap(SkBitmap* bitmap) {
     return allocateBitmap(bitmap, &Bitmap::allocateHeapBitmap);
 }
@@ -470,13 +478,28 @@ void Bitmap::getBounds(SkRect* bounds) const {
 #ifdef __ANDROID__ // Layoutlib does not support hardware acceleration
 AHardwareBuffer* Bitmap::hardwareBuffer() {
     if (isHardware()) {
+        waitForPendingUpload();
         return mPixelStorage.hardware.buffer;
     }
     return nullptr;
 }
+
+void Bitmap::waitForPendingUpload() {
+    if (!mPendingUpload.valid() ||
+        mPendingUpload.wait_for(std::chrono::seconds::zero()) == std::future_status::ready) {
+        return;
+    }
+    ATRACE_CALL();
+    mPendingUpload.wait();
+}
 #endif
 
 sk_sp<SkImage> Bitmap::makeImage() {
+#ifdef __ANDROID__ // Layoutlib does not support hardware acceleration
+    if (isHardware()) {
+        waitForPendingUpload();
+    }
+#endif
     sk_sp<SkImage> image = mImage;
     if (!image) {
         SkASSERT(!isHardware());
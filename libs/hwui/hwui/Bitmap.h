@@ -30,6 +30,8 @@
 
 #ifdef __ANDROID__ // Layoutlib does not support hardware acceleration
 #include <android/hardware_buffer.h>
+
+#include <future>
 #endif
 
 class SkWStream;
@@ -80,6 +82,9 @@ public:
      */
     static sk_sp<Bitmap> allocateAshmemBitmap(SkBitmap* bitmap);
     static sk_sp<Bitmap> allocateHardwareBitmap(const SkBitmap& bitmap);
+    // Like allocateHardwareBitmap(), but may return before the pixels have been uploaded. The
+    // pixels of bitmap must not be modified afterwards.
+    static sk_sp<Bitmap> allocateHardwareBitmapAsync(const SkBitmap& bitmap);
     static sk_sp<Bitmap> allocateHeapBitmap(SkBitmap* bitmap);
     static sk_sp<Bitmap> allocateHeapBitmap(const SkImageInfo& info);
     static sk_sp<Bitmap> allocateHeapBitmap(size_t size, const SkImageInfo& i, size_t rowBytes);
@@ -150,6 +155,20 @@ public:
 
 #ifdef __ANDROID__ // Layoutlib does not support hardware acceleration
      AHardwareBuffer* hardwareBuffer();
+
+    /**
+     * Marks the pixels of this hardware bitmap as still being uploaded to its buffer, see
+     * HardwareBitmapUploader::allocateHardwareBitmapAsync. Must be called before the bitmap is
+     * shared with other threads.
+     */
+    void setPendingUpload(std::shared_future<void> upload) { mPendingUpload = std::move(upload); }
+
+    /**
+     * Blocks until the pending upload of this hardware bitmap, if any, has completed. Called by
+     * makeImage() and hardwareBuffer(), so the first consumer of the pixels only waits if the
+     * upload is still in flight.
+     */
+    void waitForPendingUpload();
 #endif
 
     /**
@@ -250,6 +269,10 @@ private:
 
     sk_sp<SkImage> mImage;  // Cache is used only for HW Bitmaps with Skia pipeline.
 
+#ifdef __ANDROID__ // Layoutlib does not support hardware acceleration
+    std::shared_future<void> mPendingUpload;
+#endif
+
     uint64_t mId;                // unique ID for this bitmap
     // source Id where this bitmap is orignated from
     uint64_t mSourceId = -1;
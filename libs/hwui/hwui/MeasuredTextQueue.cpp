@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MeasuredTextQueue.h"
+
+#include <log/log.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+
+#include "thread/CommonPool.h"
+
+namespace android {
+
+using uirenderer::CommonPool;
+
+MeasuredTextQueue::Batch::Batch(std::vector<Paragraph>&& paragraphs,
+                                std::shared_ptr<CancellationToken> token)
+        : mToken(std::move(token)) {
+    mParagraphs.resize(paragraphs.size());
+    for (size_t i = 0; i < paragraphs.size(); i++) {
+        LOG_ALWAYS_FATAL_IF(!paragraphs[i].builder, "Paragraph %zu has no builder", i);
+        mParagraphs[i].paragraph = std::move(paragraphs[i]);
+    }
+}
+
+std::shared_ptr<MeasuredTextQueue::Batch> MeasuredTextQueue::submit(
+        std::vector<Paragraph>&& paragraphs, std::shared_ptr<CancellationToken> token) {
+    std::shared_ptr<Batch> batch(new Batch(std::move(paragraphs), std::move(token)));
+    // A long batch would fill CommonPool's bounded queue and stall the caller. Post at most one
+    // task per worker instead, which keeps claiming paragraphs until none is pending.
+    const size_t taskCount = std::min<size_t>(batch->size(), CommonPool::THREAD_COUNT);
+    for (size_t i = 0; i < taskCount; i++) {
+        CommonPool::post([batch] { batch->measureNext(); });
+    }
+    return batch;
+}
+
+void MeasuredTextQueue::Batch::measureNext() {
+    Entry* entry = nullptr;
+    {
+        std::lock_guard lock(mLock);
+        for (; mNextPending < mParagraphs.size(); mNextPending++) {
+            Entry& candidate = mParagraphs[mNextPending];
+            if (candidate.state != State::Pending) {
+                continue;
+            }
+            if (isCancelled()) {
+                candidate.state = State::Cancelled;
+                candidate.paragraph = {};
+                continue;
+            }
+            candidate.state = State::Measuring;
+            entry = &candidate;
+            mNextPending++;
+            break;
+        }
+        if (!entry) {
+            // Wakes up the callers waiting for the paragraphs that were just cancelled.
+            mCondition.notify_all();
+            return;
+        }
+    }
+    measure(*entry);
+    CommonPool::post([self = shared_from_this()] { self->measureNext(); });
+}
+
+void MeasuredTextQueue::Batch::measure(Entry& entry) {
+    ATRACE_NAME("MeasuredTextQueue::measure");
+    Paragraph& paragraph = entry.paragraph;
+    const minikin::U16StringPiece text(paragraph.text.data(), paragraph.text.size());
+    std::unique_ptr<minikin::MeasuredText> result = paragraph.builder->build(
+            text, paragraph.computeHyphenation, paragraph.computeLayout, paragraph.computeBounds,
+            paragraph.fastHyphenationMode, nullptr /* hint */);
+    // The builder holds on to the fonts of its runs.
+    paragraph = {};
+
+    std::lock_guard lock(mLock);
+    entry.result = std::move(result);
+    entry.state = State::Done;
+    mCondition.notify_all();
+}
+
+std::unique_ptr<minikin::MeasuredText> MeasuredTextQueue::Batch::take(size_t index) {
+    LOG_ALWAYS_FATAL_IF(index >= mParagraphs.size(), "Paragraph %zu out of %zu", index,
+                        mParagraphs.size());
+    Entry& entry = mParagraphs[index];
+    std::unique_lock lock(mLock);
+    if (entry.state == State::Pending) {
+        if (isCancelled()) {
+            entry.state = State::Cancelled;
+            entry.paragraph = {};
+            return nullptr;
+        }
+        // There is no point in waiting for a worker.
+        entry.state = State::Measuring;
+        lock.unlock();
+        measure(entry);
+        lock.lock();
+    } else if (entry.state == State::Measuring) {
+        ATRACE_NAME("MeasuredTextQueue::wait");
+        mCondition.wait(lock, [&entry] { return entry.state != State::Measuring; });
+    }
+    return std::move(entry.result);
+}
+
+} /* namespace android */
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cutils/compiler.h>
+#include <minikin/MeasuredText.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace android {
+
+/**
+ * Measures paragraphs ahead of their use on the CommonPool workers, for instance the text of the
+ * items that a list is about to show.
+ *
+ * The paragraphs of a batch are measured one per task, so that the work that a frame waits on
+ * and that is posted in the meantime runs in between. The caller takes each result when it needs
+ * it: a paragraph that no worker has started yet is measured on the calling thread right away
+ * rather than waited for.
+ */
+class ANDROID_API MeasuredTextQueue {
+public:
+    /**
+     * Cancels the paragraphs of all the batches it was submitted with that haven't been started.
+     */
+    class CancellationToken {
+    public:
+        void cancel() { mCancelled = true; }
+        bool isCancelled() const { return mCancelled; }
+
+    private:
+        std::atomic_bool mCancelled = false;
+    };
+
+    /**
+     * The arguments of MeasuredTextBuilder::build(). The builder holds the style runs, which
+     * must not refer to anything that the caller may release before the paragraph is measured.
+     */
+    struct Paragraph {
+        std::vector<uint16_t> text;
+        std::unique_ptr<minikin::MeasuredTextBuilder> builder;
+        bool computeHyphenation = false;
+        bool computeLayout = false;
+        bool computeBounds = false;
+        bool fastHyphenationMode = false;
+    };
+
+    class Batch : public std::enable_shared_from_this<Batch> {
+    public:
+        size_t size() const { return mParagraphs.size(); }
+
+        /**
+         * Returns the measured paragraph at index, which can only be taken once. Returns nullptr
+         * if it was cancelled before being started.
+         */
+        std::unique_ptr<minikin::MeasuredText> take(size_t index);
+
+    private:
+        friend class MeasuredTextQueue;
+
+        enum class State { Pending, Measuring, Done, Cancelled };
+
+        struct Entry {
+            Paragraph paragraph;
+            State state = State::Pending;
+            std::unique_ptr<minikin::MeasuredText> result;
+        };
+
+        Batch(std::vector<Paragraph>&& paragraphs, std::shared_ptr<CancellationToken> token);
+
+        // Measures the next pending paragraph and posts the task measuring the one after.
+        void measureNext();
+        void measure(Entry& entry);
+        bool isCancelled() const { return mToken && mToken->isCancelled(); }
+
+        std::vector<Entry> mParagraphs;
+        const std::shared_ptr<CancellationToken> mToken;
+
+        std::mutex mLock;
+        std::condition_variable mCondition;
+        size_t mNextPending = 0;
+    };
+
+    /**
+     * Starts measuring paragraphs on the workers, in order. token may be null.
+     */
+    static std::shared_ptr<Batch> submit(std::vector<Paragraph>&& paragraphs,
+                                         std::shared_ptr<CancellationToken> token = nullptr);
+};
+
+} /* namespace android */
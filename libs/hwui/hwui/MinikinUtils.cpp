@@ -21,11 +21,14 @@
 #include <minikin/MeasuredText.h>
 #include <minikin/Measurement.h>
 
+#include <algorithm>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "FeatureFlags.h"
 #include "Paint.h"
+#include "SharedTextMeasureCache.h"
 #include "SkPathMeasure.h"
 #include "Typeface.h"
 
@@ -116,6 +119,42 @@ float MinikinUtils::measureText(const Paint* paint, minikin::Bidi bidiFlags,
                                                     ? paint->getRunFlag()
                                                     : minikin::RunFlag::NONE;
 
+    SharedTextMeasureCache& sharedCache = SharedTextMeasureCache::get();
+    if (CC_UNLIKELY(sharedCache.isActive())) {
+        const auto key = sharedCache.makeKey(minikinPaint, bidiFlags, startHyphen, endHyphen,
+                                             minikinRunFlag, bufSize, start, count);
+        if (key) {
+            if (const auto measurement = sharedCache.find(*key, buf, advances)) {
+                if (bounds) {
+                    *bounds = measurement->bounds;
+                }
+                if (clusterCount) {
+                    *clusterCount = measurement->clusterCount;
+                }
+                return measurement->advance;
+            }
+            if (sharedCache.isRecording()) {
+                std::vector<float> recordedAdvances(count);
+                SharedTextMeasureCache::Measurement measurement{};
+                measurement.advance = minikin::Layout::measureText(
+                        textBuf, range, bidiFlags, minikinPaint, startHyphen, endHyphen,
+                        recordedAdvances.data(), &measurement.bounds, &measurement.clusterCount,
+                        minikinRunFlag);
+                sharedCache.record(*key, buf, recordedAdvances.data(), measurement);
+                if (advances) {
+                    std::copy(recordedAdvances.begin(), recordedAdvances.end(), advances);
+                }
+                if (bounds) {
+                    *bounds = measurement.bounds;
+                }
+                if (clusterCount) {
+                    *clusterCount = measurement.clusterCount;
+                }
+                return measurement.advance;
+            }
+        }
+    }
+
     return minikin::Layout::measureText(textBuf, range, bidiFlags, minikinPaint, startHyphen,
                                         endHyphen, advances, bounds, clusterCount, minikinRunFlag);
 }
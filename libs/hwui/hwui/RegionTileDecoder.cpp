@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RegionTileDecoder.h"
+
+#include <BRDAllocator.h>
+#include <BitmapRegionDecoder.h>
+#include <SkBitmap.h>
+#include <log/log.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+
+#include "Bitmap.h"
+#include "thread/CommonPool.h"
+
+namespace android {
+
+using uirenderer::CommonPool;
+
+namespace {
+
+class TileAllocator : public skia::BRDAllocator {
+public:
+    bool allocPixelRef(SkBitmap* bitmap) override {
+        mStorage = Bitmap::allocateHeapBitmap(bitmap);
+        return !!mStorage;
+    }
+
+    SkCodec::ZeroInitialized zeroInit() const override { return SkCodec::kYes_ZeroInitialized; }
+
+    sk_sp<Bitmap> release() { return std::move(mStorage); }
+
+private:
+    sk_sp<Bitmap> mStorage;
+};
+
+}  // namespace
+
+struct RegionTileDecoder::Batch {
+    std::vector<Tile> tiles;
+    Options options;
+    Callback onDecoded;
+
+    // The indices of the tiles in the order to decode them.
+    std::vector<size_t> order;
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> remaining = 0;
+    std::promise<void> done;
+};
+
+std::shared_ptr<RegionTileDecoder> RegionTileDecoder::Make(sk_sp<SkData> data) {
+    std::unique_ptr<skia::BitmapRegionDecoder> decoder = skia::BitmapRegionDecoder::Make(data);
+    if (!decoder) {
+        return nullptr;
+    }
+    return std::shared_ptr<RegionTileDecoder>(
+            new RegionTileDecoder(std::move(data), std::move(decoder)));
+}
+
+RegionTileDecoder::RegionTileDecoder(sk_sp<SkData> data,
+                                     std::unique_ptr<skia::BitmapRegionDecoder> decoder)
+        : mData(std::move(data)), mWidth(decoder->width()), mHeight(decoder->height()) {
+    mIdleDecoders.push_back(std::move(decoder));
+}
+
+RegionTileDecoder::~RegionTileDecoder() = default;
+
+std::unique_ptr<skia::BitmapRegionDecoder> RegionTileDecoder::acquireDecoder() {
+    {
+        std::lock_guard lock(mLock);
+        if (!mIdleDecoders.empty()) {
+            std::unique_ptr<skia::BitmapRegionDecoder> decoder = std::move(mIdleDecoders.back());
+            mIdleDecoders.pop_back();
+            return decoder;
+        }
+    }
+    ATRACE_NAME("RegionTileDecoder::makeDecoder");
+    return skia::BitmapRegionDecoder::Make(mData);
+}
+
+void RegionTileDecoder::releaseDecoder(std::unique_ptr<skia::BitmapRegionDecoder> decoder) {
+    std::lock_guard lock(mLock);
+    if (decoder && mIdleDecoders.size() < CommonPool::THREAD_COUNT) {
+        mIdleDecoders.push_back(std::move(decoder));
+    }
+}
+
+std::future<void> RegionTileDecoder::decode(std::vector<Tile> tiles, const Options& options,
+                                            Callback onDecoded) {
+    auto batch = std::make_shared<Batch>();
+    batch->tiles = std::move(tiles);
+    batch->options = options;
+    batch->onDecoded = std::move(onDecoded);
+    batch->order.resize(batch->tiles.size());
+    std::iota(batch->order.begin(), batch->order.end(), 0);
+    const std::vector<Tile>& sorted = batch->tiles;
+    std::stable_sort(batch->order.begin(), batch->order.end(), [&sorted](size_t a, size_t b) {
+        const SkIRect& first = sorted[a].subset;
+        const SkIRect& second = sorted[b].subset;
+        return first.top() != second.top() ? first.top() < second.top()
+                                           : first.left() < second.left();
+    });
+    batch->remaining = batch->tiles.size();
+    std::future<void> done = batch->done.get_future();
+    if (batch->tiles.empty()) {
+        batch->done.set_value();
+        return done;
+    }
+
+    // Tiles are claimed in reading order as the workers free up, so the top of the image is
+    // decoded first and the tasks of a later batch don't queue up behind every tile of this one.
+    const size_t taskCount = std::min<size_t>(batch->tiles.size(), CommonPool::THREAD_COUNT);
+    for (size_t i = 0; i < taskCount; i++) {
+        CommonPool::post([self = shared_from_this(), batch] { self->decodeNext(batch); });
+    }
+    return done;
+}
+
+void RegionTileDecoder::decodeNext(const std::shared_ptr<Batch>& batch) {
+    const size_t next = batch->next++;
+    if (next >= batch->order.size()) {
+        return;
+    }
+    const size_t index = batch->order[next];
+    const Tile& tile = batch->tiles[index];
+    const Options& options = batch->options;
+
+    sk_sp<Bitmap> result;
+    {
+        ATRACE_NAME("RegionTileDecoder::decode");
+        std::unique_ptr<skia::BitmapRegionDecoder> decoder = acquireDecoder();
+        if (decoder) {
+            const SkColorType colorType = decoder->computeOutputColorType(options.colorType);
+            const sk_sp<SkColorSpace> colorSpace =
+                    decoder->computeOutputColorSpace(colorType, options.colorSpace);
+            TileAllocator allocator;
+            SkBitmap bitmap;
+            if (decoder->decodeRegion(&bitmap, &allocator, tile.subset, tile.sampleSize, colorType,
+                                      options.requireUnpremul, colorSpace)) {
+                result = allocator.release();
+            } else {
+                ALOGW("Failed to decode tile %zu", index);
+            }
+            releaseDecoder(std::move(decoder));
+        }
+    }
+    batch->onDecoded(index, std::move(result));
+
+    if (--batch->remaining == 0) {
+        batch->done.set_value();
+    } else if (batch->next < batch->order.size()) {
+        CommonPool::post([self = shared_from_this(), batch] { self->decodeNext(batch); });
+    }
+}
+
+} /* namespace android */
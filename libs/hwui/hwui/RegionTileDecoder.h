@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <SkColorSpace.h>
+#include <SkData.h>
+#include <SkImageInfo.h>
+#include <SkRect.h>
+#include <SkRefCnt.h>
+#include <cutils/compiler.h>
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace android {
+
+class Bitmap;
+
+namespace skia {
+class BitmapRegionDecoder;
+}  // namespace skia
+
+/**
+ * Decodes many regions of an image at once, such as the tiles that a map or photo viewer shows
+ * in a frame, on the CommonPool workers.
+ *
+ * BitmapRegionDecoder decodes one region per call with a single codec. This runs a codec per
+ * worker instead, all reading the same encoded data, which stays immutable. The tiles are
+ * decoded from the top of the image down, so that the tiles of a band of rows are decoded
+ * together.
+ */
+class ANDROID_API RegionTileDecoder : public std::enable_shared_from_this<RegionTileDecoder> {
+public:
+    static std::shared_ptr<RegionTileDecoder> Make(sk_sp<SkData> data);
+    ~RegionTileDecoder();
+
+    struct Tile {
+        SkIRect subset;
+        int sampleSize = 1;
+    };
+
+    struct Options {
+        SkColorType colorType = kN32_SkColorType;
+        bool requireUnpremul = false;
+        sk_sp<SkColorSpace> colorSpace;
+    };
+
+    /**
+     * Called on a worker as each tile is decoded, in any order, with nullptr if it failed.
+     */
+    using Callback = std::function<void(size_t index, sk_sp<Bitmap> bitmap)>;
+
+    /**
+     * Decodes the tiles into heap bitmaps. The returned future is ready once the callback was
+     * called for all of them.
+     */
+    std::future<void> decode(std::vector<Tile> tiles, const Options& options,
+                             Callback onDecoded);
+
+    int width() const { return mWidth; }
+    int height() const { return mHeight; }
+
+private:
+    struct Batch;
+
+    RegionTileDecoder(sk_sp<SkData> data, std::unique_ptr<skia::BitmapRegionDecoder> decoder);
+
+    std::unique_ptr<skia::BitmapRegionDecoder> acquireDecoder();
+    void releaseDecoder(std::unique_ptr<skia::BitmapRegionDecoder> decoder);
+
+    // Decodes the next tile of the batch and posts the task decoding the one after.
+    void decodeNext(const std::shared_ptr<Batch>& batch);
+
+    const sk_sp<SkData> mData;
+    int mWidth;
+    int mHeight;
+
+    std::mutex mLock;
+    // The codecs that no worker is using, at most one per worker.
+    std::vector<std::unique_ptr<skia::BitmapRegionDecoder>> mIdleDecoders;
+};
+
+} /* namespace android */
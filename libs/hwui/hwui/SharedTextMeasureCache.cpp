@@ -0,0 +1,460 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SharedTextMeasureCache.h"
+
+#include <android-base/file.h>
+#include <android-base/properties.h>
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
+#include <log/log.h>
+#include <minikin/Buffer.h>
+#include <minikin/FontCollection.h>
+#include <minikin/FontFamily.h>
+#include <minikin/LocaleList.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+
+#include "Properties.h"
+#include "utils/Trace.h"
+
+namespace android {
+
+namespace {
+
+constexpr char kMagic[8] = {'H', 'W', 'U', 'I', 'T', 'M', 'C', '\0'};
+constexpr uint32_t kVersion = 1;
+
+constexpr const char* kSystemFontDirs[] = {
+        "/system/fonts/",
+        "/product/fonts/",
+        "/system_ext/fonts/",
+        // Updatable fonts, installed by the system.
+        "/data/fonts/files/",
+};
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bucketCount;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t fileSize;
+    char buildFingerprint[96];
+};
+
+struct Bucket {
+    uint64_t hash;
+    // Offset of the entry from the start of the file, 0 for an empty bucket.
+    uint64_t offset;
+};
+
+// Followed by the bufSize code units of the text, and the count advances aligned to 4 bytes.
+struct EntryHeader {
+    SharedTextMeasureCache::Key key;
+    float advance;
+    float boundsLeft;
+    float boundsTop;
+    float boundsRight;
+    float boundsBottom;
+    uint32_t clusterCount;
+};
+
+static_assert(sizeof(SharedTextMeasureCache::Key) == 72, "Key must not have implicit padding");
+static_assert(sizeof(FileHeader) % 8 == 0 && sizeof(EntryHeader) % 8 == 0);
+
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ULL;
+constexpr uint64_t kFnvPrime = 0x100000001b3ULL;
+
+// FNV-1a, the hashes are written to the file so they must not change from one process to another.
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = kFnvOffset) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * kFnvPrime;
+    }
+    return hash;
+}
+
+template <typename T>
+uint64_t hashValue(const T& value, uint64_t hash) {
+    return hashBytes(&value, sizeof(value), hash);
+}
+
+uint64_t hashString(std::string_view string, uint64_t hash) {
+    hash = hashValue(string.size(), hash);
+    return hashBytes(string.data(), string.size(), hash);
+}
+
+uint64_t hashEntry(const SharedTextMeasureCache::Key& key, const uint16_t* text) {
+    return hashBytes(text, key.bufSize * sizeof(uint16_t), hashValue(key, kFnvOffset));
+}
+
+size_t textOffset(size_t entryOffset) {
+    return entryOffset + sizeof(EntryHeader);
+}
+
+size_t advancesOffset(size_t entryOffset, const SharedTextMeasureCache::Key& key) {
+    return (textOffset(entryOffset) + key.bufSize * sizeof(uint16_t) + 3) & ~size_t(3);
+}
+
+size_t entryEnd(size_t entryOffset, const SharedTextMeasureCache::Key& key) {
+    return advancesOffset(entryOffset, key) + key.count * sizeof(float);
+}
+
+bool isSystemFontPath(std::string_view path) {
+    if (path.find("/../") != std::string_view::npos) {
+        return false;
+    }
+    for (const char* dir : kSystemFontDirs) {
+        if (path.starts_with(dir)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string getBuildFingerprint() {
+    std::string fingerprint = base::GetProperty("ro.build.fingerprint", "");
+    fingerprint.resize(std::min(fingerprint.size(), sizeof(FileHeader::buildFingerprint) - 1));
+    return fingerprint;
+}
+
+}  // namespace
+
+struct SharedTextMeasureCache::Mapping {
+    const uint8_t* data;
+    size_t size;
+
+    ~Mapping() { munmap(const_cast<uint8_t*>(data), size); }
+
+    const FileHeader& header() const { return *reinterpret_cast<const FileHeader*>(data); }
+    const Bucket* buckets() const {
+        return reinterpret_cast<const Bucket*>(data + sizeof(FileHeader));
+    }
+};
+
+bool SharedTextMeasureCache::Key::operator==(const Key& other) const {
+    return memcmp(this, &other, sizeof(Key)) == 0;
+}
+
+SharedTextMeasureCache& SharedTextMeasureCache::get() {
+    static SharedTextMeasureCache sInstance;
+    return sInstance;
+}
+
+SharedTextMeasureCache::~SharedTextMeasureCache() {}
+
+bool SharedTextMeasureCache::isActive() {
+    std::call_once(mDefaultFileFlag, [this] { mapDefaultFile(); });
+    return mHasMapping || mRecording;
+}
+
+void SharedTextMeasureCache::mapDefaultFile() {
+    const std::string path = base::GetProperty(PROPERTY_SHARED_TEXT_CACHE, "");
+    if (path.empty()) {
+        return;
+    }
+    base::unique_fd fd(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd == -1) {
+        ALOGW("Failed to open the shared text cache %s: %s", path.c_str(), strerror(errno));
+        return;
+    }
+    map(fd.get());
+}
+
+std::optional<SharedTextMeasureCache::Key> SharedTextMeasureCache::makeKey(
+        const minikin::MinikinPaint& paint, minikin::Bidi bidiFlags,
+        minikin::StartHyphenEdit startHyphen, minikin::EndHyphenEdit endHyphen,
+        minikin::RunFlag runFlag, size_t bufSize, size_t start, size_t count) {
+    if (count == 0 || bufSize > kMaxTextLength || start + count > bufSize || !paint.font) {
+        return std::nullopt;
+    }
+
+    Key key{};
+    {
+        std::lock_guard lock(mIdsLock);
+        key.fontsId = getFontsIdLocked(*paint.font);
+        if (key.fontsId == 0) {
+            return std::nullopt;
+        }
+        key.localesId = getLocalesIdLocked(paint.localeListId);
+    }
+    key.fontsId = hashValue(paint.fontStyle.weight(), key.fontsId);
+    key.fontsId = hashValue(paint.fontStyle.slant(), key.fontsId);
+
+    uint64_t settingsId = kFnvOffset;
+    for (const minikin::FontFeature& feature : paint.fontFeatureSettings) {
+        settingsId = hashValue(feature.tag, settingsId);
+        settingsId = hashValue(feature.value, settingsId);
+    }
+    for (const minikin::FontVariation& variation : paint.fontVariationSettings) {
+        settingsId = hashValue(variation.axisTag, settingsId);
+        settingsId = hashValue(variation.value, settingsId);
+    }
+    key.settingsId = settingsId;
+
+    key.size = paint.size;
+    key.scaleX = paint.scaleX;
+    key.skewX = paint.skewX;
+    key.letterSpacing = paint.letterSpacing;
+    key.wordSpacing = paint.wordSpacing;
+    key.fontFlags = paint.fontFlags;
+    key.bidi = static_cast<uint8_t>(bidiFlags);
+    key.startHyphen = static_cast<uint8_t>(startHyphen);
+    key.endHyphen = static_cast<uint8_t>(endHyphen);
+    key.familyVariant = static_cast<uint8_t>(paint.familyVariant);
+    key.runFlag = static_cast<uint8_t>(runFlag);
+    key.verticalText = paint.verticalText;
+    key.bufSize = bufSize;
+    key.start = start;
+    key.count = count;
+    return key;
+}
+
+uint64_t SharedTextMeasureCache::getFontsIdLocked(const minikin::FontCollection& collection) {
+    auto found = mFontsIds.find(collection.getId());
+    if (found != mFontsIds.end()) {
+        return found->second;
+    }
+
+    uint64_t hash = kFnvOffset;
+    for (size_t i = 0; i < collection.getFamilyCount() && hash; i++) {
+        const std::shared_ptr<minikin::FontFamily>& family = collection.getFamilyAt(i);
+        hash = hashString(minikin::getLocaleString(family->localeListId()), hash);
+        hash = hashValue(family->variant(), hash);
+        for (size_t j = 0; j < family->getNumFonts(); j++) {
+            const minikin::Font* font = family->getFont(j);
+            std::string_view path;
+            int index;
+            const minikin::FontVariation* axes;
+            uint32_t axesCount;
+            // Same as Font.cpp, reads the metadata of the system fonts without loading them.
+            minikin::BufferReader reader = font->typefaceMetadataReader();
+            if (reader.current() != nullptr) {
+                path = reader.readString();
+                index = reader.read<int>();
+                std::tie(axes, axesCount) = reader.readArray<minikin::FontVariation>();
+            } else {
+                const minikin::MinikinFont* minikinFont = font->baseTypeface().get();
+                path = minikinFont->GetFontPath();
+                index = minikinFont->GetFontIndex();
+                axes = minikinFont->GetAxes().data();
+                axesCount = minikinFont->GetAxes().size();
+            }
+            if (!isSystemFontPath(path)) {
+                hash = 0;
+                break;
+            }
+            hash = hashString(path, hash);
+            hash = hashValue(index, hash);
+            hash = hashBytes(axes, axesCount * sizeof(minikin::FontVariation), hash);
+            hash = hashValue(font->style().weight(), hash);
+            hash = hashValue(font->style().slant(), hash);
+        }
+    }
+    mFontsIds[collection.getId()] = hash;
+    return hash;
+}
+
+uint64_t SharedTextMeasureCache::getLocalesIdLocked(uint32_t localeListId) {
+    auto found = mLocalesIds.find(localeListId);
+    if (found != mLocalesIds.end()) {
+        return found->second;
+    }
+    const uint64_t hash = hashString(minikin::getLocaleString(localeListId), kFnvOffset);
+    mLocalesIds[localeListId] = hash;
+    return hash;
+}
+
+std::optional<SharedTextMeasureCache::Measurement> SharedTextMeasureCache::find(
+        const Key& key, const uint16_t* text, float* advances) {
+    std::shared_lock lock(mMappingLock);
+    if (!mMapping) {
+        return std::nullopt;
+    }
+    const Mapping& mapping = *mMapping;
+    const uint32_t mask = mapping.header().bucketCount - 1;
+    const uint64_t hash = hashEntry(key, text);
+    for (uint32_t probe = 0; probe <= mask; probe++) {
+        const Bucket& bucket = mapping.buckets()[(hash + probe) & mask];
+        if (bucket.offset == 0) {
+            return std::nullopt;
+        }
+        if (bucket.hash != hash || bucket.offset % 8 ||
+            bucket.offset > mapping.size - sizeof(EntryHeader)) {
+            continue;
+        }
+        const EntryHeader& entry =
+                *reinterpret_cast<const EntryHeader*>(mapping.data + bucket.offset);
+        if (!(entry.key == key) || entryEnd(bucket.offset, key) > mapping.size ||
+            memcmp(mapping.data + textOffset(bucket.offset), text,
+                   key.bufSize * sizeof(uint16_t))) {
+            continue;
+        }
+        if (advances) {
+            memcpy(advances, mapping.data + advancesOffset(bucket.offset, key),
+                   key.count * sizeof(float));
+        }
+        return Measurement{
+                .advance = entry.advance,
+                .bounds = minikin::MinikinRect(entry.boundsLeft, entry.boundsTop,
+                                               entry.boundsRight, entry.boundsBottom),
+                .clusterCount = entry.clusterCount,
+        };
+    }
+    return std::nullopt;
+}
+
+bool SharedTextMeasureCache::map(int fd) {
+    ATRACE_CALL();
+    // An explicit mapping takes precedence over the default file.
+    std::call_once(mDefaultFileFlag, [] {});
+    unmap();
+
+    struct stat st = {};
+    if (fstat(fd, &st) == -1 || st.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        ALOGW("Invalid shared text cache");
+        return false;
+    }
+    const size_t size = st.st_size;
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        ALOGW("Failed to map the shared text cache: %s", strerror(errno));
+        return false;
+    }
+    auto mapping = std::make_unique<Mapping>();
+    mapping->data = static_cast<const uint8_t*>(data);
+    mapping->size = size;
+
+    const FileHeader& header = mapping->header();
+    const uint32_t bucketCount = header.bucketCount;
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) || header.version != kVersion ||
+        header.fileSize != size || bucketCount == 0 || (bucketCount & (bucketCount - 1)) ||
+        bucketCount > (size - sizeof(FileHeader)) / sizeof(Bucket)) {
+        ALOGW("Invalid shared text cache");
+        return false;
+    }
+    if (strncmp(header.buildFingerprint, getBuildFingerprint().c_str(),
+                sizeof(header.buildFingerprint))) {
+        ALOGW("The shared text cache was made for another build");
+        return false;
+    }
+
+    std::unique_lock lock(mMappingLock);
+    mMapping = std::move(mapping);
+    mHasMapping = true;
+    return true;
+}
+
+void SharedTextMeasureCache::unmap() {
+    std::call_once(mDefaultFileFlag, [] {});
+    std::unique_lock lock(mMappingLock);
+    mMapping.reset();
+    mHasMapping = false;
+}
+
+void SharedTextMeasureCache::setRecording(bool recording) {
+    std::lock_guard lock(mRecordLock);
+    mRecording = recording;
+}
+
+void SharedTextMeasureCache::record(const Key& key, const uint16_t* text, const float* advances,
+                                    const Measurement& measurement) {
+    if (!mRecording) {
+        return;
+    }
+    const uint64_t hash = hashEntry(key, text);
+    std::lock_guard lock(mRecordLock);
+    if (mRecorded.size() >= kMaxRecordedEntries || !mRecordedHashes.insert(hash).second) {
+        return;
+    }
+    mRecorded.push_back({
+            .key = key,
+            .text = std::vector<uint16_t>(text, text + key.bufSize),
+            .advances = std::vector<float>(advances, advances + key.count),
+            .measurement = measurement,
+    });
+}
+
+bool SharedTextMeasureCache::writeRecorded(int fd) {
+    ATRACE_CALL();
+    std::vector<Recorded> recorded;
+    {
+        std::lock_guard lock(mRecordLock);
+        recorded = std::move(mRecorded);
+        mRecorded.clear();
+        mRecordedHashes.clear();
+    }
+
+    // At most half full, so that misses stop at an empty bucket early.
+    uint32_t bucketCount = 1;
+    while (bucketCount < recorded.size() * 2) {
+        bucketCount *= 2;
+    }
+    size_t size = sizeof(FileHeader) + bucketCount * sizeof(Bucket);
+    std::vector<size_t> offsets;
+    offsets.reserve(recorded.size());
+    for (const Recorded& entry : recorded) {
+        offsets.push_back(size);
+        size = (entryEnd(size, entry.key) + 7) & ~size_t(7);
+    }
+
+    std::vector<uint8_t> data(size, 0);
+    FileHeader& header = *reinterpret_cast<FileHeader*>(data.data());
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.bucketCount = bucketCount;
+    header.entryCount = recorded.size();
+    header.fileSize = size;
+    const std::string fingerprint = getBuildFingerprint();
+    memcpy(header.buildFingerprint, fingerprint.data(), fingerprint.size());
+
+    Bucket* buckets = reinterpret_cast<Bucket*>(data.data() + sizeof(FileHeader));
+    for (size_t i = 0; i < recorded.size(); i++) {
+        const Recorded& entry = recorded[i];
+        const size_t offset = offsets[i];
+        EntryHeader& entryHeader = *reinterpret_cast<EntryHeader*>(data.data() + offset);
+        entryHeader.key = entry.key;
+        entryHeader.advance = entry.measurement.advance;
+        entryHeader.boundsLeft = entry.measurement.bounds.mLeft;
+        entryHeader.boundsTop = entry.measurement.bounds.mTop;
+        entryHeader.boundsRight = entry.measurement.bounds.mRight;
+        entryHeader.boundsBottom = entry.measurement.bounds.mBottom;
+        entryHeader.clusterCount = entry.measurement.clusterCount;
+        memcpy(data.data() + textOffset(offset), entry.text.data(),
+               entry.text.size() * sizeof(uint16_t));
+        memcpy(data.data() + advancesOffset(offset, entry.key), entry.advances.data(),
+               entry.advances.size() * sizeof(float));
+
+        const uint64_t hash = hashEntry(entry.key, entry.text.data());
+        for (uint32_t probe = 0;; probe++) {
+            Bucket& bucket = buckets[(hash + probe) & (bucketCount - 1)];
+            if (bucket.offset == 0) {
+                bucket.hash = hash;
+                bucket.offset = offset;
+                break;
+            }
+        }
+    }
+    return base::WriteFully(fd, data.data(), data.size());
+}
+
+} /* namespace android */
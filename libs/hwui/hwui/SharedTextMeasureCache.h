@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cutils/compiler.h>
+#include <minikin/Hyphenator.h>
+#include <minikin/Layout.h>
+#include <minikin/MinikinPaint.h>
+#include <minikin/MinikinRect.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace android {
+
+/**
+ * A read-mostly cache of text measurements shared by all the processes, for the system fonts.
+ *
+ * System UI, the launcher and apps measure the same strings, such as clock digits or labels, in
+ * the same fonts. The system records those measurements once and writes them to a file, which
+ * every process maps read-only, see PROPERTY_SHARED_TEXT_CACHE. MinikinUtils::measureText looks
+ * strings up in the file before shaping them. Misses are shaped by Minikin as before, with its
+ * per-process layout cache as the local overlay.
+ *
+ * Entries are keyed by the text and everything in the MinikinPaint that affects its measurement.
+ * Process-local identifiers are replaced:
+ * - the font collection by a fingerprint of the paths, indices and axes of its fonts
+ * - the locale list ID by its string.
+ * Paints whose fonts are not all installed system fonts are never looked up. Neither are texts
+ * longer than kMaxTextLength. The file is tied to ro.build.fingerprint and ignored after an
+ * update.
+ */
+class ANDROID_API SharedTextMeasureCache {
+public:
+    static constexpr size_t kMaxTextLength = 256;
+    static constexpr size_t kMaxRecordedEntries = 4096;
+
+    // Everything that affects the measurement of a text, but the text itself. Written to the file
+    // as is, so all the fields have fixed sizes and there is no implicit padding.
+    struct Key {
+        uint64_t fontsId;
+        uint64_t localesId;
+        uint64_t settingsId;
+        float size;
+        float scaleX;
+        float skewX;
+        float letterSpacing;
+        float wordSpacing;
+        uint32_t fontFlags;
+        uint8_t bidi;
+        uint8_t startHyphen;
+        uint8_t endHyphen;
+        uint8_t familyVariant;
+        uint8_t runFlag;
+        uint8_t verticalText;
+        uint16_t reserved;
+        uint32_t bufSize;
+        uint32_t start;
+        uint32_t count;
+        uint32_t reserved2;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct Measurement {
+        float advance;
+        minikin::MinikinRect bounds;
+        uint32_t clusterCount;
+    };
+
+    static SharedTextMeasureCache& get();
+
+    /**
+     * Whether a file is mapped or measurements are recorded. Nothing needs to be looked up
+     * otherwise.
+     */
+    bool isActive();
+
+    /**
+     * Returns the key of a measurement, or nullopt if it can't be shared.
+     */
+    std::optional<Key> makeKey(const minikin::MinikinPaint& paint, minikin::Bidi bidiFlags,
+                               minikin::StartHyphenEdit startHyphen,
+                               minikin::EndHyphenEdit endHyphen, minikin::RunFlag runFlag,
+                               size_t bufSize, size_t start, size_t count);
+
+    /**
+     * Looks text, of key.bufSize code units, up in the mapped file. On a hit, advances receives
+     * the key.count advances and the measurement is returned.
+     */
+    std::optional<Measurement> find(const Key& key, const uint16_t* text, float* advances);
+
+    /**
+     * Maps the file at fd, which may be closed afterwards. Returns false if it is invalid or made
+     * for another build, the previous file is unmapped either way.
+     */
+    bool map(int fd);
+    void unmap();
+
+    /**
+     * In the process populating the file, keeps every measurement of a shareable key, up to
+     * kMaxRecordedEntries, until writeRecorded() is called.
+     */
+    void setRecording(bool recording);
+    bool isRecording() const { return mRecording; }
+    void record(const Key& key, const uint16_t* text, const float* advances,
+                const Measurement& measurement);
+
+    /**
+     * Writes the recorded measurements to fd, as a file that map() accepts.
+     */
+    bool writeRecorded(int fd);
+
+private:
+    struct Mapping;
+    struct Recorded {
+        Key key;
+        std::vector<uint16_t> text;
+        std::vector<float> advances;
+        Measurement measurement;
+    };
+
+    SharedTextMeasureCache() = default;
+    ~SharedTextMeasureCache();
+
+    void mapDefaultFile();
+    // Returns the fingerprint of the fonts, 0 if they are not all system fonts.
+    uint64_t getFontsIdLocked(const minikin::FontCollection& collection);
+    uint64_t getLocalesIdLocked(uint32_t localeListId);
+
+    std::once_flag mDefaultFileFlag;
+    std::shared_mutex mMappingLock;
+    std::unique_ptr<Mapping> mMapping;
+    std::atomic_bool mHasMapping = false;
+
+    std::mutex mIdsLock;
+    // Keyed by FontCollection::getId() and the locale list ID, which are never reused.
+    std::unordered_map<uint32_t, uint64_t> mFontsIds;
+    std::unordered_map<uint32_t, uint64_t> mLocalesIds;
+
+    std::mutex mRecordLock;
+    std::atomic_bool mRecording = false;
+    std::vector<Recorded> mRecorded;
+    std::unordered_set<uint64_t> mRecordedHashes;
+};
+
+} /* namespace android */
@@ -442,7 +442,7 @@ static jobject nativeDecodeRegion(JNIEnv* env, jobject, jlong brdHandle, jint in
     }
 
     if (isHardware) {
-        sk_sp<Bitmap> hardwareBitmap = Bitmap::allocateHardwareBitmap(bitmap);
+        sk_sp<Bitmap> hardwareBitmap = Bitmap::allocateHardwareBitmapAsync(bitmap);
         if (hasGainmap) {
             auto gm = uirenderer::Gainmap::allocateHardwareGainmap(gainmap);
             if (gm) {
@@ -340,22 +340,49 @@ static jobject ImageDecoder_nDecodeBitmap(JNIEnv* env, jobject /*clazz*/, jlong
         return nullptr;
     }
 
+    // Whether the pixels are worth returning, if only as a partial image.
+    auto hasPixels = [](SkCodec::Result result) {
+        return result == SkCodec::kSuccess || result == SkCodec::kIncompleteInput ||
+               result == SkCodec::kErrorInInput;
+    };
+
     sk_sp<Bitmap> nativeBitmap;
-    if (allocator == kSharedMemory_Allocator) {
-        nativeBitmap = Bitmap::allocateAshmemBitmap(&bm);
-    } else {
-        nativeBitmap = Bitmap::allocateHeapBitmap(&bm);
-    }
-    if (!nativeBitmap) {
-        SkString msg;
-        msg.printf("OOM allocating Bitmap with dimensions %i x %i",
-                bitmapInfo.width(), bitmapInfo.height());
-        doThrowOOME(env, msg.c_str());
-        return nullptr;
+    SkCodec::Result result = SkCodec::kSuccess;
+    bool decoded = false;
+    // A hardware bitmap that isn't post-processed may be decoded straight into its buffer.
+    if (isHardware && !jpostProcess) {
+        nativeBitmap = uirenderer::HardwareBitmapUploader::allocateWritableHardwareBitmap(
+                bitmapInfo, [&](void* pixels, size_t rowBytes) {
+                    ATRACE_FORMAT("Decoding %dx%d bitmap into its buffer", bitmapInfo.width(),
+                                  bitmapInfo.height());
+                    result = decoder->decode(pixels, rowBytes);
+                    decoded = true;
+                    return hasPixels(result);
+                });
+        if (decoded && !nativeBitmap && hasPixels(result)) {
+            doThrowOOME(env, "failed to allocate hardware Bitmap!");
+            return nullptr;
+        }
     }
+    const bool decodedToHardware = nativeBitmap != nullptr;
 
-    ATRACE_FORMAT("Decoding %dx%d bitmap", bitmapInfo.width(), bitmapInfo.height());
-    SkCodec::Result result = decoder->decode(bm.getPixels(), bm.rowBytes());
+    if (!decoded) {
+        if (allocator == kSharedMemory_Allocator) {
+            nativeBitmap = Bitmap::allocateAshmemBitmap(&bm);
+        } else {
+            nativeBitmap = Bitmap::allocateHeapBitmap(&bm);
+        }
+        if (!nativeBitmap) {
+            SkString msg;
+            msg.printf("OOM allocating Bitmap with dimensions %i x %i",
+                    bitmapInfo.width(), bitmapInfo.height());
+            doThrowOOME(env, msg.c_str());
+            return nullptr;
+        }
+
+        ATRACE_FORMAT("Decoding %dx%d bitmap", bitmapInfo.width(), bitmapInfo.height());
+        result = decoder->decode(bm.getPixels(), bm.rowBytes());
+    }
     jthrowable jexception = get_and_clear_exception(env);
     int onPartialImageError = jexception ? kSourceException : 0;  // No error.
 
@@ -477,7 +504,8 @@ static jobject ImageDecoder_nDecodeBitmap(JNIEnv* env, jobject /*clazz*/, jlong
         bitmapCreateFlags |= bitmap::kBitmapCreateFlag_Mutable;
     } else {
         if (isHardware) {
-            sk_sp<Bitmap> hwBitmap = Bitmap::allocateHardwareBitmap(bm);
+            sk_sp<Bitmap> hwBitmap =
+                    decodedToHardware ? nativeBitmap : Bitmap::allocateHardwareBitmapAsync(bm);
             if (hwBitmap) {
                 hwBitmap->setImmutable();
                 if (nativeBitmap->hasGainmap()) {
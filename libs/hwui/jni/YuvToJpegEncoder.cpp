@@ -6,8 +6,19 @@
 #include <hardware/hardware.h>
 
 #include "graphics_jni_helpers.h"
+#include "thread/CommonPool.h"
 
+#include <algorithm>
 #include <csetjmp>
+#include <future>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define YUV_TO_JPEG_NEON 1
+#endif
+
+using android::uirenderer::CommonPool;
 
 extern "C" {
     // We need to include stdio.h before jpeg because jpeg does not include it, but uses FILE
@@ -97,8 +108,144 @@ skstream_destination_mgr::skstream_destination_mgr(SkWStream* stream)
     this->term_destination = sk_term_destination;
 }
 
+// Images smaller than this are encoded at once, splitting them isn't worth it.
+static constexpr int kMinParallelPixels = 1024 * 1024;
+
+int YuvToJpegEncoder::stripHeight(int width, int height) {
+    if (width * height < kMinParallelPixels) {
+        return 0;
+    }
+    const int mcusPerRow = (width + kMcuSize - 1) / kMcuSize;
+    const int mcuRows = (height + kMcuSize - 1) / kMcuSize;
+    // A strip for the calling thread and one for each worker. The restart interval, which is
+    // the number of MCUs of a strip, is a 16 bit field.
+    const int threadCount = CommonPool::THREAD_COUNT + 1;
+    const int mcuRowsPerStrip =
+            std::min((mcuRows + threadCount - 1) / threadCount, UINT16_MAX / mcusPerRow);
+    if (mcuRowsPerStrip == 0 || mcuRowsPerStrip >= mcuRows) {
+        return 0;
+    }
+    return mcuRowsPerStrip * kMcuSize;
+}
+
+// The parts of a JPEG of a single scan, as written by libjpeg.
+struct JpegLayout {
+    size_t sof = 0;   // The SOF0 segment.
+    size_t sos = 0;   // The SOS segment.
+    size_t scan = 0;  // The entropy-coded data, up to the EOI marker at the end.
+};
+
+static bool parseJpeg(const uint8_t* data, size_t size, JpegLayout* layout) {
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8 || data[size - 2] != 0xFF ||
+        data[size - 1] != 0xD9) {
+        return false;
+    }
+    size_t pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF) {
+            return false;
+        }
+        const uint8_t marker = data[pos + 1];
+        const size_t length = (data[pos + 2] << 8) | data[pos + 3];
+        if (marker == 0xC0) {
+            layout->sof = pos;
+        } else if (marker == 0xDA) {
+            layout->sos = pos;
+            layout->scan = pos + 2 + length;
+            return layout->sof != 0 && layout->scan <= size - 2;
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+// Joins JPEGs of strips of the image, encoded with the same tables, into one. The entropy-coded
+// data of each strip starts with the DC predictions reset, and ends padded to a byte, as after
+// a restart marker.
+static bool joinStrips(SkWStream* stream, const std::vector<sk_sp<SkData>>& strips, int height,
+                       int restartInterval) {
+    std::vector<JpegLayout> layouts(strips.size());
+    for (size_t i = 0; i < strips.size(); i++) {
+        if (!parseJpeg(strips[i]->bytes(), strips[i]->size(), &layouts[i])) {
+            ALOGE("Failed to parse the JPEG of strip %zu", i);
+            return false;
+        }
+    }
+
+    // The headers of the first strip, with the height of the image.
+    const uint8_t* first = strips[0]->bytes();
+    const JpegLayout& firstLayout = layouts[0];
+    std::vector<uint8_t> header(first, first + firstLayout.sos);
+    header[firstLayout.sof + 5] = height >> 8;
+    header[firstLayout.sof + 6] = height & 0xFF;
+    const uint8_t restart[] = {0xFF, 0xDD, 0x00, 0x04, static_cast<uint8_t>(restartInterval >> 8),
+                               static_cast<uint8_t>(restartInterval & 0xFF)};
+    if (!stream->write(header.data(), header.size()) ||
+        !stream->write(restart, sizeof(restart)) ||
+        !stream->write(first + firstLayout.sos, firstLayout.scan - firstLayout.sos)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < strips.size(); i++) {
+        if (i > 0) {
+            const uint8_t marker[] = {0xFF, static_cast<uint8_t>(0xD0 + (i - 1) % 8)};
+            if (!stream->write(marker, sizeof(marker))) {
+                return false;
+            }
+        }
+        const uint8_t* data = strips[i]->bytes();
+        if (!stream->write(data + layouts[i].scan, strips[i]->size() - 2 - layouts[i].scan)) {
+            return false;
+        }
+    }
+    const uint8_t end[] = {0xFF, 0xD9};
+    if (!stream->write(end, sizeof(end))) {
+        return false;
+    }
+    stream->flush();
+    return true;
+}
+
 bool YuvToJpegEncoder::encode(SkWStream* stream, void* inYuv, int width,
         int height, int* offsets, int jpegQuality) {
+    uint8_t* yuv = static_cast<uint8_t*>(inYuv);
+    const int strip = stripHeight(width, height);
+    if (strip == 0 || fNumPlanes > kMaxPlanes) {
+        return encodeImage(stream, yuv, width, height, offsets, jpegQuality);
+    }
+
+    const int stripCount = (height + strip - 1) / strip;
+    std::vector<SkDynamicMemoryWStream> outputs(stripCount);
+    auto encodeStrip = [&](int index) {
+        int stripOffsets[kMaxPlanes];
+        std::copy(offsets, offsets + fNumPlanes, stripOffsets);
+        offsetRows(stripOffsets, index * strip);
+        return encodeImage(&outputs[index], yuv, width, std::min(strip, height - index * strip),
+                           stripOffsets, jpegQuality);
+    };
+    std::vector<std::future<bool>> workers;
+    for (int i = 1; i < stripCount; i++) {
+        workers.push_back(CommonPool::async([&encodeStrip, i] { return encodeStrip(i); }));
+    }
+    bool succeeded = encodeStrip(0);
+    // The workers refer to the locals, they must all be done.
+    for (std::future<bool>& worker : workers) {
+        succeeded &= worker.get();
+    }
+    if (!succeeded) {
+        return false;
+    }
+
+    std::vector<sk_sp<SkData>> strips;
+    for (SkDynamicMemoryWStream& output : outputs) {
+        strips.push_back(output.detachAsData());
+    }
+    const int restartInterval = (strip / kMcuSize) * ((width + kMcuSize - 1) / kMcuSize);
+    return joinStrips(stream, strips, height, restartInterval);
+}
+
+bool YuvToJpegEncoder::encodeImage(SkWStream* stream, uint8_t* yuv, int width, int height,
+                                   int* offsets, int jpegQuality) {
     jpeg_compress_struct      cinfo;
     ErrorMgr                  err;
     skstream_destination_mgr  sk_wstream(stream);
@@ -118,7 +265,7 @@ bool YuvToJpegEncoder::encode(SkWStream* stream, void* inYuv, int width,
 
     jpeg_start_compress(&cinfo, TRUE);
 
-    compress(&cinfo, (uint8_t*) inYuv, offsets);
+    compress(&cinfo, yuv, offsets);
 
     jpeg_finish_compress(&cinfo);
 
@@ -196,18 +343,33 @@ void Yuv420SpToJpegEncoder::deinterleave(uint8_t* vuPlanar, uint8_t* uRows,
         uint8_t* vRows, int rowIndex, int width, int height) {
     int numRows = (height - rowIndex) / 2;
     if (numRows > 8) numRows = 8;
+    const int halfWidth = width >> 1;
     for (int row = 0; row < numRows; ++row) {
         int offset = ((rowIndex >> 1) + row) * fStrides[1];
-        uint8_t* vu = vuPlanar + offset;
-        for (int i = 0; i < (width >> 1); ++i) {
-            int index = row * (width >> 1) + i;
-            uRows[index] = vu[1];
-            vRows[index] = vu[0];
-            vu += 2;
+        const uint8_t* vu = vuPlanar + offset;
+        uint8_t* u = uRows + row * halfWidth;
+        uint8_t* v = vRows + row * halfWidth;
+        int i = 0;
+#ifdef YUV_TO_JPEG_NEON
+        for (; i + 16 <= halfWidth; i += 16) {
+            const uint8x16x2_t pairs = vld2q_u8(vu + 2 * i);
+            vst1q_u8(u + i, pairs.val[1]);
+            vst1q_u8(v + i, pairs.val[0]);
+        }
+#endif
+        for (; i < halfWidth; ++i) {
+            u[i] = vu[2 * i + 1];
+            v[i] = vu[2 * i];
         }
     }
 }
 
+void Yuv420SpToJpegEncoder::offsetRows(int* offsets, int rows) {
+    offsets[0] += rows * fStrides[0];
+    // The chroma plane is vertically subsampled, rows is a multiple of kMcuSize.
+    offsets[1] += (rows >> 1) * fStrides[1];
+}
+
 void Yuv420SpToJpegEncoder::configSamplingFactors(jpeg_compress_struct* cinfo) {
     // cb and cr are horizontally downsampled and vertically downsampled as well.
     cinfo->comp_info[0].h_samp_factor = 2;
@@ -271,20 +433,36 @@ void Yuv422IToJpegEncoder::deinterleave(uint8_t* yuv, uint8_t* yRows, uint8_t* u
         uint8_t* vRows, int rowIndex, int width, int height) {
     int numRows = height - rowIndex;
     if (numRows > 16) numRows = 16;
+    const int halfWidth = width >> 1;
     for (int row = 0; row < numRows; ++row) {
-        uint8_t* yuvSeg = yuv + (rowIndex + row) * fStrides[0];
-        for (int i = 0; i < (width >> 1); ++i) {
-            int indexY = row * width + (i << 1);
-            int indexU = row * (width >> 1) + i;
-            yRows[indexY] = yuvSeg[0];
-            yRows[indexY + 1] = yuvSeg[2];
-            uRows[indexU] = yuvSeg[1];
-            vRows[indexU] = yuvSeg[3];
-            yuvSeg += 4;
+        const uint8_t* yuvSeg = yuv + (rowIndex + row) * fStrides[0];
+        uint8_t* y = yRows + row * width;
+        uint8_t* u = uRows + row * halfWidth;
+        uint8_t* v = vRows + row * halfWidth;
+        int i = 0;
+#ifdef YUV_TO_JPEG_NEON
+        for (; i + 16 <= halfWidth; i += 16) {
+            // 16 pairs of pixels, as Y0 U Y1 V.
+            const uint8x16x4_t pixels = vld4q_u8(yuvSeg + 4 * i);
+            const uint8x16x2_t luma = {{pixels.val[0], pixels.val[2]}};
+            vst2q_u8(y + 2 * i, luma);
+            vst1q_u8(u + i, pixels.val[1]);
+            vst1q_u8(v + i, pixels.val[3]);
+        }
+#endif
+        for (; i < halfWidth; ++i) {
+            y[2 * i] = yuvSeg[4 * i];
+            y[2 * i + 1] = yuvSeg[4 * i + 2];
+            u[i] = yuvSeg[4 * i + 1];
+            v[i] = yuvSeg[4 * i + 3];
         }
     }
 }
 
+void Yuv422IToJpegEncoder::offsetRows(int* offsets, int rows) {
+    offsets[0] += rows * fStrides[0];
+}
+
 void Yuv422IToJpegEncoder::configSamplingFactors(jpeg_compress_struct* cinfo) {
     // cb and cr are horizontally downsampled and vertically downsampled as well.
     cinfo->comp_info[0].h_samp_factor = 2;
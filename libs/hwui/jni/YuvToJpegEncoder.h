@@ -25,6 +25,9 @@ public:
     explicit YuvToJpegEncoder(int* strides);
 
     /** Encode YUV data to jpeg,  which is output to a stream.
+     *
+     *  Large images are split into strips of MCU rows that are encoded in parallel, and joined
+     *  with restart markers into a single baseline JPEG.
      *
      *  @param stream The jpeg output stream.
      *  @param inYuv The input yuv data.
@@ -40,6 +43,10 @@ public:
     virtual ~YuvToJpegEncoder() {}
 
 protected:
+    // Both encoders subsample chroma vertically by at most 2, so an MCU is 16 rows high.
+    static constexpr int kMcuSize = 16;
+    static constexpr int kMaxPlanes = 2;
+
     int fNumPlanes;
     int* fStrides;
     void setJpegCompressStruct(jpeg_compress_struct* cinfo, int width,
@@ -47,6 +54,14 @@ protected:
     virtual void configSamplingFactors(jpeg_compress_struct* cinfo) = 0;
     virtual void compress(jpeg_compress_struct* cinfo,
             uint8_t* yuv, int* offsets) = 0;
+    // Moves the offsets of the planes down by rows rows of the image.
+    virtual void offsetRows(int* offsets, int rows) = 0;
+
+private:
+    bool encodeImage(SkWStream* stream, uint8_t* yuv, int width, int height, int* offsets,
+                     int jpegQuality);
+    // Returns the height of the strips to encode in parallel, or 0 to encode the image at once.
+    static int stripHeight(int width, int height);
 };
 
 class Yuv420SpToJpegEncoder : public YuvToJpegEncoder {
@@ -61,6 +76,7 @@ private:
     void deinterleave(uint8_t* vuPlanar, uint8_t* uRows, uint8_t* vRows,
             int rowIndex, int width, int height);
     void compress(jpeg_compress_struct* cinfo, uint8_t* yuv, int* offsets);
+    void offsetRows(int* offsets, int rows);
 };
 
 class Yuv422IToJpegEncoder : public YuvToJpegEncoder {
@@ -73,6 +89,7 @@ private:
     void compress(jpeg_compress_struct* cinfo, uint8_t* yuv, int* offsets);
     void deinterleave(uint8_t* yuv, uint8_t* yRows, uint8_t* uRows,
             uint8_t* vRows, int rowIndex, int width, int height);
+    void offsetRows(int* offsets, int rows);
 };
 
 class P010Yuv420ToJpegREncoder {
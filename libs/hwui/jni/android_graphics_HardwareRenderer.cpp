@@ -35,6 +35,7 @@
 #include <SkSerialProcs.h>
 #include <SkStream.h>
 #include <SkTypeface.h>
+#include <android-base/properties.h>
 #include <gui/TraceUtils.h>
 #include <include/encode/SkPngEncoder.h>
 #include <inttypes.h>
@@ -960,6 +961,8 @@ static void android_view_ThreadedRenderer_setupPersistentGraphicsCache(
     const char* skiaShaderCachePathArray = env->GetStringUTFChars(skiaShaderCachePath, NULL);
     uirenderer::skiapipeline::ShaderCache::get().setFilename(skiaShaderCachePathArray);
     env->ReleaseStringUTFChars(skiaShaderCachePath, skiaShaderCachePathArray);
+    uirenderer::skiapipeline::ShaderCache::get().setSharedFilename(
+            base::GetProperty(PROPERTY_SHARED_SHADER_CACHE, "").c_str());
 
     const char* skiaPipelineCachePathArray = env->GetStringUTFChars(skiaPipelineCachePath, NULL);
     uirenderer::skiapipeline::PersistentGraphicsCache::get().initPipelineCache(
@@ -55,15 +55,20 @@ bool HardwareRendererObserver::getNextBuffer(JNIEnv* env, jlongArray metrics, in
                         "Mismatched Java/Native FrameMetrics data format.");
 
     FrameMetricsNotification& elem = mRingBuffer[mNextInQueue];
-    if (elem.hasData.load()) {
-        env->SetLongArrayRegion(metrics, 0, kBufferSize, elem.buffer);
-        *dropCount = elem.dropCount;
-        mNextInQueue = (mNextInQueue + 1) % kRingSize;
-        elem.hasData = false;
-        return true;
+    if (!elem.hasData.load()) {
+        // The drain is over, the next notify() has to schedule another one. A notify() that
+        // happened right before this didn't schedule one, so check again.
+        mDrainScheduled = false;
+        if (!elem.hasData.load()) {
+            return false;
+        }
     }
 
-    return false;
+    env->SetLongArrayRegion(metrics, 0, kBufferSize, elem.buffer);
+    *dropCount = elem.dropCount;
+    mNextInQueue = (mNextInQueue + 1) % kRingSize;
+    elem.hasData = false;
+    return true;
 }
 
 void HardwareRendererObserver::notify(const uirenderer::FrameInfoBuffer& stats) {
@@ -79,10 +84,12 @@ void HardwareRendererObserver::notify(const uirenderer::FrameInfoBuffer& stats)
         mNextFree = (mNextFree + 1) % kRingSize;
         elem.hasData = true;
 
-        JNIEnv* env = getenv(mVm);
-        mKeepListening = env->CallStaticBooleanMethod(gHardwareRendererObserverClassInfo.clazz,
-                                                      gHardwareRendererObserverClassInfo.callback,
-                                                      mObserver);
+        if (!mDrainScheduled.exchange(true)) {
+            JNIEnv* env = getenv(mVm);
+            mKeepListening = env->CallStaticBooleanMethod(
+                    gHardwareRendererObserverClassInfo.clazz,
+                    gHardwareRendererObserverClassInfo.callback, mObserver);
+        }
     } else {
         mDroppedReports++;
     }
@@ -19,6 +19,8 @@
 #include <FrameInfo.h>
 #include <FrameMetricsObserver.h>
 
+#include <atomic>
+
 namespace android {
 
 /*
@@ -66,11 +68,19 @@ private:
     jobject mObserver;
     bool mKeepListening = true;
 
+    // mRingBuffer is a single producer, single consumer queue. notify() is the producer, and is
+    // serialized by the CanvasContext, getNextBuffer() is the consumer, on the thread of the Java
+    // observer.
     int mNextFree = 0;
     int mNextInQueue = 0;
     FrameMetricsNotification mRingBuffer[kRingSize];
 
     int mDroppedReports = 0;
+
+    // Whether the Java observer was told that data is available and hasn't found the ring
+    // buffer empty since. The Java observer drains the ring buffer when told, so that notify()
+    // only calls into Java once per drain instead of once per frame.
+    std::atomic_bool mDrainScheduled = false;
 };
 
 } // namespace android
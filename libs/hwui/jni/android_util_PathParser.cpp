@@ -32,7 +32,7 @@ static void parseStringForPath(JNIEnv* env, jobject, jlong skPathHandle, jstring
     SkPath* skPath = reinterpret_cast<SkPath*>(skPathHandle);
 
     PathParser::ParseResult result;
-    PathParser::parseAsciiStringForSkPath(skPath, &result, pathString, strLength);
+    PathParser::parseAsciiStringForSkPathCached(skPath, &result, pathString, strLength);
     env->ReleaseStringUTFChars(inputPathStr, pathString);
     if (result.failureOccurred) {
         doThrowIAE(env, result.failureMessage.c_str());
@@ -54,7 +54,7 @@ static jlong createPathDataFromStringPath(JNIEnv* env, jobject, jstring inputStr
     const char* pathString = env->GetStringUTFChars(inputStr, NULL);
     PathData* pathData = new PathData();
     PathParser::ParseResult result;
-    PathParser::getPathDataFromAsciiString(pathData, &result, pathString, strLength);
+    PathParser::getPathDataFromAsciiStringCached(pathData, &result, pathString, strLength);
     env->ReleaseStringUTFChars(inputStr, pathString);
     if (!result.failureOccurred) {
         return reinterpret_cast<jlong>(pathData);
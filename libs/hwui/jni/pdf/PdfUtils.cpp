@@ -29,10 +29,16 @@ static int sUnmatchedPdfiumInitRequestCount = 0;
 int getBlock(void* param, unsigned long position, unsigned char* outBuffer,
         unsigned long size) {
     const int fd = reinterpret_cast<intptr_t>(param);
-    const int readCount = pread(fd, outBuffer, size, position);
-    if (readCount < 0) {
-        ALOGE("Cannot read from file descriptor. Error:%d", errno);
-        return 0;
+    // pread can return less than asked for, which pdfium would take as the block being read
+    while (size > 0) {
+        const ssize_t readCount = TEMP_FAILURE_RETRY(pread(fd, outBuffer, size, position));
+        if (readCount <= 0) {
+            ALOGE("Cannot read from file descriptor. Error:%d", readCount < 0 ? errno : 0);
+            return 0;
+        }
+        outBuffer += readCount;
+        position += readCount;
+        size -= readCount;
     }
     return 1;
 }
@@ -52,6 +52,18 @@ void BackdropFilterDrawable::onDraw(SkCanvas* canvas) {
 
     auto backdropImage = surface->makeImageSnapshot(surfaceSubset.roundOut());
 
+    if (const int levels = BackdropBlur::getDownsampleLevels(backdropFilter)) {
+        if (auto blurredImage = mBlur.blur(canvas, backdropImage, backdropFilter, levels)) {
+            canvas->save();
+            canvas->resetMatrix();
+            canvas->drawImageRect(blurredImage, SkRect::Make(blurredImage->dimensions()),
+                                  surfaceSubset, SkSamplingOptions(SkFilterMode::kLinear), &paint,
+                                  SkCanvas::kFast_SrcRectConstraint);
+            canvas->restore();
+            return;
+        }
+    }
+
     SkIRect imageBounds = SkIRect::MakeWH(backdropImage->width(), backdropImage->height());
     SkIPoint offset;
     SkIRect imageSubset;
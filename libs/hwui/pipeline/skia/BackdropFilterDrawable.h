@@ -20,6 +20,8 @@
 #include <SkDrawable.h>
 #include <SkPaint.h>
 
+#include "effects/BackdropBlur.h"
+
 namespace android {
 namespace uirenderer {
 
@@ -41,6 +43,8 @@ public:
 
 private:
     RenderNode* mTargetRenderNode;
+    // Keeps the levels of the blur of the backdrop from one frame to the next.
+    BackdropBlur mBlur;
 
 protected:
     void onDraw(SkCanvas* canvas) override;
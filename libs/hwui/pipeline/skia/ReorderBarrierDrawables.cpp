@@ -191,11 +191,8 @@ void EndReorderBarrierDrawable::drawShadow(SkCanvas* canvas, RenderNodeDrawable*
     }
 
     // intersect the shadow-casting path with the reveal, if present
-    SkPath tmpPath;  // holds temporary SkPath to store the result of intersections
     if (revealClipPath) {
-        Op(*casterPath, *revealClipPath, kIntersect_SkPathOp, &tmpPath);
-        tmpPath.setIsVolatile(true);
-        casterPath = &tmpPath;
+        casterPath = caster->getRenderNode()->getRevealClippedOutline(*casterPath);
     }
 
     const Vector3 lightPos = LightingInfo::getLightCenter();
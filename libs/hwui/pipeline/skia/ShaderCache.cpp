@@ -20,15 +20,18 @@
 #include <gui/TraceUtils.h>
 #include <include/gpu/ganesh/GrDirectContext.h>
 #include <log/log.h>
+#include <fcntl.h>
 #include <openssl/sha.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include <mutex>
-#include <thread>
 
 #include "FileBlobCache.h"
 #include "Properties.h"
+#include "thread/CommonPool.h"
 
 namespace android {
 namespace uirenderer {
@@ -91,6 +94,9 @@ void ShaderCache::initShaderDiskCache(const void* identity, ssize_t size) {
     if (!Properties::runningInEmulator && mFilename.length() > 0) {
         mBlobCache.reset(new FileBlobCache(maxKeySize, maxValueSize, maxTotalSize, mFilename));
         validateCache(identity, size);
+        mSharedCache = mSharedFilename.empty()
+                ? nullptr
+                : SharedShaderCache::open(mSharedFilename, mIDHash);
         mInitialized = true;
         if (identity != nullptr && size > 0 && mIDHash.size()) {
             set(&sIDKey, sizeof(sIDKey), mIDHash.data(), mIDHash.size());
@@ -103,13 +109,80 @@ void ShaderCache::setFilename(const char* filename) {
     mFilename = filename;
 }
 
+void ShaderCache::setSharedFilename(const char* filename) {
+    std::lock_guard lock(mMutex);
+    mSharedFilename = filename;
+}
+
+static void prefetchFile(const std::string& filename) {
+    if (filename.empty()) {
+        return;
+    }
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+}
+
+void ShaderCache::prefetchDiskCache() {
+    ATRACE_NAME("prefetchShaderDiskCache");
+    std::string filename;
+    std::string sharedFilename;
+    {
+        std::lock_guard lock(mMutex);
+        if (Properties::runningInEmulator || mInitialized) {
+            return;
+        }
+        filename = mFilename;
+        sharedFilename = mSharedFilename;
+    }
+    prefetchFile(filename);
+    prefetchFile(sharedFilename);
+}
+
+void ShaderCache::startSharedCacheExport() {
+    std::lock_guard lock(mMutex);
+    mSharedCacheBuilder = std::make_unique<SharedShaderCache::Builder>();
+}
+
+bool ShaderCache::exportSharedCache(const std::string& path) {
+    std::lock_guard lock(mMutex);
+    if (!mSharedCacheBuilder) {
+        return false;
+    }
+    bool written = mSharedCacheBuilder->write(path, mIDHash);
+    mSharedCacheBuilder.reset();
+    return written;
+}
+
 sk_sp<SkData> ShaderCache::load(const SkData& key) {
     ATRACE_NAME("ShaderCache::load");
-    size_t keySize = key.size();
     std::lock_guard lock(mMutex);
     if (!mInitialized) {
         return nullptr;
     }
+    recordWarmupKeyLocked(key);
+    sk_sp<SkData> data = loadLocked(key);
+    (data ? mLoadHits : mLoadMisses).fetch_add(1, std::memory_order_relaxed);
+    if (data && mSharedCacheBuilder) {
+        mSharedCacheBuilder->add(key, *data);
+    }
+    return data;
+}
+
+sk_sp<SkData> ShaderCache::loadLocked(const SkData& key) {
+    // Shaders of the shared cache are never compiled again, so they don't take space in the
+    // cache of the app.
+    if (mSharedCache) {
+        if (sk_sp<SkData> data = mSharedCache->find(key)) {
+            mSharedCacheHits.fetch_add(1, std::memory_order_relaxed);
+            return data;
+        }
+    }
+
+    size_t keySize = key.size();
 
     // mObservedBlobValueSize is reasonably big to avoid memory reallocation
     // Allocate a buffer with malloc. SkData takes ownership of that allocation and will call free.
@@ -218,6 +291,9 @@ void ShaderCache::store(const SkData& key, const SkData& data, const SkString& /
         }
         mNewPipelineCacheSize = valueSize;
     } else {
+        if (mSharedCacheBuilder) {
+            mSharedCacheBuilder->add(key, data);
+        }
         mCacheDirty = true;
         // If there are new shaders compiled, we probably have new pipeline state too.
         // Store pipeline cache on the next flush.
@@ -225,11 +301,14 @@ void ShaderCache::store(const SkData& key, const SkData& data, const SkString& /
         mTryToStorePipelineCache = true;
     }
     set(key.data(), keySize, value, valueSize);
+    scheduleSaveLocked();
+}
 
+void ShaderCache::scheduleSaveLocked() {
     if (!mSavePending && mDeferredSaveDelayMs > 0) {
         mSavePending = true;
-        std::thread deferredSaveThread([this]() {
-            usleep(mDeferredSaveDelayMs * 1000);  // milliseconds to microseconds
+        // Writing the cache can take a while, it's left to a background task of the pool.
+        CommonPool::postBackground([this]() {
             std::lock_guard lock(mMutex);
             // Store file on disk if there a new shader or Vulkan pipeline cache size changed.
             if (mCacheDirty || mNewPipelineCacheSize != mOldPipelineCacheSize) {
@@ -239,9 +318,93 @@ void ShaderCache::store(const SkData& key, const SkData& data, const SkString& /
                 mCacheDirty = false;
             }
             mSavePending = false;
-        });
-        deferredSaveThread.detach();
+        }, ms2ns(mDeferredSaveDelayMs));
+    }
+}
+
+void ShaderCache::recordWarmupKeyLocked(const SkData& key) {
+    if (mCompletedFrames >= kWarmupFrameCount || mWarmupKeys.size() >= kMaxWarmupKeys ||
+        key.size() > maxKeySize) {
+        return;
+    }
+    // Skia loads each program once per context, so duplicates only come from a context that was
+    // destroyed and recreated during the first frames.
+    for (const auto& warmupKey : mWarmupKeys) {
+        if (warmupKey->equals(&key)) {
+            return;
+        }
+    }
+    mWarmupKeys.push_back(SkData::MakeWithCopy(key.data(), key.size()));
+}
+
+void ShaderCache::onFrameCompleted() {
+    if (mCompletedFrames >= kWarmupFrameCount) {
+        return;
+    }
+    std::lock_guard lock(mMutex);
+    if (++mCompletedFrames < kWarmupFrameCount || !mInitialized || mWarmupKeys.empty()) {
+        return;
+    }
+
+    // The keys are stored as their size followed by their bytes.
+    std::string warmupKeys;
+    for (const auto& key : mWarmupKeys) {
+        const uint32_t keySize = key->size();
+        warmupKeys.append(reinterpret_cast<const char*>(&keySize), sizeof(keySize));
+        warmupKeys.append(static_cast<const char*>(key->data()), keySize);
+    }
+    mWarmupKeys.clear();
+    if (warmupKeys == mSavedWarmupKeys) {
+        return;
+    }
+    ATRACE_FORMAT("ShaderCache: saving %zu bytes of warmup keys", warmupKeys.size());
+    set(&sWarmupKey, sizeof(sWarmupKey), warmupKeys.data(), warmupKeys.size());
+    mSavedWarmupKeys = std::move(warmupKeys);
+    mCacheDirty = true;
+    scheduleSaveLocked();
+}
+
+std::vector<sk_sp<SkData>> ShaderCache::getWarmupKeys() {
+    std::lock_guard lock(mMutex);
+    if (!mInitialized) {
+        return {};
+    }
+    auto key = sWarmupKey;
+    std::string warmupKeys(mBlobCache->get(&key, sizeof(key), nullptr, 0), '\0');
+    if (warmupKeys.empty() ||
+        mBlobCache->get(&key, sizeof(key), warmupKeys.data(), warmupKeys.size()) !=
+                warmupKeys.size()) {
+        return {};
+    }
+
+    std::vector<sk_sp<SkData>> keys;
+    size_t offset = 0;
+    while (offset + sizeof(uint32_t) <= warmupKeys.size()) {
+        uint32_t keySize;
+        memcpy(&keySize, warmupKeys.data() + offset, sizeof(keySize));
+        offset += sizeof(keySize);
+        if (keySize > warmupKeys.size() - offset) {
+            break;
+        }
+        keys.push_back(SkData::MakeWithCopy(warmupKeys.data() + offset, keySize));
+        offset += keySize;
+    }
+    mSavedWarmupKeys = std::move(warmupKeys);
+    return keys;
+}
+
+bool ShaderCache::precompile(GrDirectContext* context, const SkData& key) {
+    ATRACE_NAME("ShaderCache::precompile");
+    sk_sp<SkData> data;
+    {
+        std::lock_guard lock(mMutex);
+        if (!mInitialized || !(data = loadLocked(key))) {
+            return false;
+        }
+        // Skia won't load the precompiled program again, so record it here for the next run.
+        recordWarmupKeyLocked(key);
     }
+    return context->precompileShader(key, *data);
 }
 
 void ShaderCache::onVkFrameFlushed(GrDirectContext* context) {
@@ -23,10 +23,13 @@
 #include <include/gpu/ganesh/GrContextOptions.h>
 #include <utils/Mutex.h>
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "SharedShaderCache.h"
+
 class GrDirectContext;
 class SkData;
 
@@ -69,6 +72,28 @@ public:
      */
     virtual void setFilename(const char* filename);
 
+    /**
+     * "setSharedFilename" sets the name of the read-only shared cache that is mapped by
+     * "initShaderDiskCache" and consulted before the cache of the app. The shared cache is only
+     * used if it was built for the same identity and build, see "exportSharedCache".
+     */
+    void setSharedFilename(const char* filename);
+
+    /**
+     * "prefetchDiskCache" reads the files of the cache into the page cache, so that
+     * "initShaderDiskCache" doesn't wait on the disk. It can be called from any thread, before
+     * the identity of the GPU is known.
+     */
+    void prefetchDiskCache();
+
+    /**
+     * "startSharedCacheExport" starts collecting the shaders that are loaded or stored from then
+     * on, and "exportSharedCache" writes them to a shared cache at path. This is meant for the
+     * system process that builds the shared cache once per build, by drawing the framework UI.
+     */
+    void startSharedCacheExport();
+    bool exportSharedCache(const std::string& path);
+
     /**
      * "load" attempts to retrieve the value blob associated with a given key
      * blob from cache.  This will be called by Skia, when it needs to compile a new SKSL shader.
@@ -88,6 +113,48 @@ public:
      */
     void onVkFrameFlushed(GrDirectContext* context);
 
+    /**
+     * "onFrameCompleted" counts the frames drawn by the process. The keys loaded during the first
+     * kWarmupFrameCount frames are saved with the cache, in the order they were first used, so
+     * that the next run of the app can precompile them before its first frame.
+     */
+    void onFrameCompleted();
+
+    /**
+     * "getWarmupKeys" returns the keys that were saved by the previous run of the app, in the
+     * order they were first used.
+     */
+    std::vector<sk_sp<SkData>> getWarmupKeys();
+
+    /**
+     * "precompile" compiles the program of a warmup key ahead of its first use, if it is still
+     * in the cache. Must be called on the thread that owns the context.
+     */
+    bool precompile(GrDirectContext* context, const SkData& key);
+
+    /**
+     * Number of frames during which the loaded keys are recorded for the warmup of the next run,
+     * and the maximum number of keys recorded.
+     */
+    static constexpr int kWarmupFrameCount = 10;
+    static constexpr size_t kMaxWarmupKeys = 128;
+
+    /**
+     * "getLoadCounters" returns the number of "load" calls that found their key in the cache,
+     * and of the ones that didn't and made Skia compile the shader, since the process started.
+     * "sharedHits" are the hits that were served by the shared cache.
+     */
+    struct LoadCounters {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t sharedHits = 0;
+    };
+    LoadCounters getLoadCounters() const {
+        return {.hits = mLoadHits.load(std::memory_order_relaxed),
+                .misses = mLoadMisses.load(std::memory_order_relaxed),
+                .sharedHits = mSharedCacheHits.load(std::memory_order_relaxed)};
+    }
+
 private:
     // Creation and (the lack of) destruction is handled internally.
     ShaderCache();
@@ -115,6 +182,22 @@ private:
      */
     void saveToDiskLocked() REQUIRES(mMutex);
 
+    /**
+     * "scheduleSaveLocked" starts a deferred save if one is not already pending.
+     */
+    void scheduleSaveLocked() REQUIRES(mMutex);
+
+    /**
+     * "loadLocked" retrieves the value blob of key, or nullptr if it is not in the cache.
+     */
+    sk_sp<SkData> loadLocked(const SkData& key) REQUIRES(mMutex);
+
+    /**
+     * "recordWarmupKeyLocked" appends key to the warmup keys of the next run, if the first
+     * frames haven't been drawn yet.
+     */
+    void recordWarmupKeyLocked(const SkData& key) REQUIRES(mMutex);
+
     /**
      * "mInitialized" indicates whether the ShaderCache is in the initialized
      * state.  It is initialized to false at construction time, and gets set to
@@ -141,6 +224,15 @@ private:
      */
     std::string mFilename GUARDED_BY(mMutex);
 
+    /**
+     * "mSharedFilename" is the name of the shared cache file, "mSharedCache" the shared cache
+     * mapped from it if it was valid, and "mSharedCacheBuilder" collects the shaders of the
+     * shared cache that is being exported, if any.
+     */
+    std::string mSharedFilename GUARDED_BY(mMutex);
+    std::unique_ptr<SharedShaderCache> mSharedCache GUARDED_BY(mMutex);
+    std::unique_ptr<SharedShaderCache::Builder> mSharedCacheBuilder GUARDED_BY(mMutex);
+
     /**
      * "mIDHash" is the current identity hash for the cache validation. It is
      * initialized to an empty vector at construction time, and its content is
@@ -222,6 +314,24 @@ private:
      */
     int mNumShadersCachedInRam GUARDED_BY(mMutex) = 0;
 
+    /**
+     * "sWarmupKey" is the cache key of the serialized warmup keys.
+     */
+    static constexpr uint8_t sWarmupKey = 1;
+
+    /**
+     * "mCompletedFrames" counts the frames drawn up to kWarmupFrameCount, "mWarmupKeys" are the
+     * keys loaded until then, and "mSavedWarmupKeys" is the serialized list found in the cache,
+     * which is only written again if it changed.
+     */
+    std::atomic<int> mCompletedFrames = 0;
+    std::vector<sk_sp<SkData>> mWarmupKeys GUARDED_BY(mMutex);
+    std::string mSavedWarmupKeys GUARDED_BY(mMutex);
+
+    std::atomic<uint64_t> mLoadHits = 0;
+    std::atomic<uint64_t> mLoadMisses = 0;
+    std::atomic<uint64_t> mSharedCacheHits = 0;
+
     friend class ShaderCacheTestUtils;  // used for unit testing
 };
 
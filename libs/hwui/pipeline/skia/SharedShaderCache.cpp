@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SharedShaderCache.h"
+
+#include <android-base/file.h>
+#include <android-base/properties.h>
+#include <errno.h>
+#include <log/log.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace android {
+namespace uirenderer {
+namespace skiapipeline {
+
+namespace {
+
+// "HSSC"; bump kVersion whenever the layout changes, stale caches are then ignored.
+constexpr uint32_t kMagic = 0x43535348u;
+constexpr uint32_t kVersion = 1u;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t idHashSize;
+    uint32_t fingerprintSize;
+    uint32_t entryCount;
+};
+
+size_t align4(size_t size) {
+    return (size + 3) & ~size_t(3);
+}
+
+std::string buildFingerprint() {
+    return base::GetProperty("ro.build.fingerprint", "");
+}
+
+std::string_view toStringView(const void* data, size_t size) {
+    return std::string_view(static_cast<const char*>(data), size);
+}
+
+}  // namespace
+
+SharedShaderCache::~SharedShaderCache() {
+    release(mMemory);
+}
+
+std::unique_ptr<SharedShaderCache> SharedShaderCache::open(const std::string& path,
+                                                           const std::vector<uint8_t>& idHash) {
+    ATRACE_NAME("SharedShaderCache::open");
+    Memory memory;
+    auto result = acquire(path, memory);
+    if (result.outcome != AcquireResult::Success) {
+        // A missing file is a normal case, the shared cache hasn't been built yet.
+        ALOGW_IF(result.outcome != AcquireResult::OpenFailed || result.errnoValue != ENOENT,
+                 "SharedShaderCache::open: could not map %s; outcome=%d, errnoValue=%d",
+                 path.c_str(), result.outcome, result.errnoValue);
+        return nullptr;
+    }
+
+    const auto* data = static_cast<const uint8_t*>(memory.data);
+    Header header;
+    if (memory.size < sizeof(header)) {
+        release(memory);
+        return nullptr;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion) {
+        ALOGW("SharedShaderCache::open: ignoring %s, invalid header", path.c_str());
+        release(memory);
+        return nullptr;
+    }
+
+    // 64-bit arithmetic, 32-bit sizes can't overflow it.
+    const uint64_t idHashOffset = sizeof(header);
+    const uint64_t fingerprintOffset = idHashOffset + header.idHashSize;
+    const uint64_t entriesOffset = align4(fingerprintOffset + header.fingerprintSize);
+    const uint64_t entriesEnd = entriesOffset + uint64_t(header.entryCount) * sizeof(Entry);
+    if (entriesEnd > memory.size) {
+        ALOGW("SharedShaderCache::open: ignoring %s, truncated", path.c_str());
+        release(memory);
+        return nullptr;
+    }
+
+    const std::string fingerprint = buildFingerprint();
+    if (toStringView(data + idHashOffset, header.idHashSize) !=
+                toStringView(idHash.data(), idHash.size()) ||
+        toStringView(data + fingerprintOffset, header.fingerprintSize) != fingerprint) {
+        // The shared cache was built for another GPU driver or build, and will be rebuilt.
+        release(memory);
+        return nullptr;
+    }
+
+    // mmap returns page aligned memory and entriesOffset is a multiple of 4.
+    const auto* entries = reinterpret_cast<const Entry*>(data + entriesOffset);
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        const Entry& entry = entries[i];
+        if (uint64_t(entry.keyOffset) + entry.keySize > memory.size ||
+            uint64_t(entry.valueOffset) + entry.valueSize > memory.size) {
+            ALOGW("SharedShaderCache::open: ignoring %s, invalid entry", path.c_str());
+            release(memory);
+            return nullptr;
+        }
+    }
+    return std::unique_ptr<SharedShaderCache>(
+            new SharedShaderCache(memory, entries, header.entryCount));
+}
+
+sk_sp<SkData> SharedShaderCache::find(const SkData& key) const {
+    const auto* data = static_cast<const uint8_t*>(mMemory.data);
+    const std::string_view keyView = toStringView(key.data(), key.size());
+    const Entry* end = mEntries + mEntryCount;
+    const Entry* entry =
+            std::lower_bound(mEntries, end, keyView, [data](const Entry& e, std::string_view k) {
+                return toStringView(data + e.keyOffset, e.keySize) < k;
+            });
+    if (entry == end || toStringView(data + entry->keyOffset, entry->keySize) != keyView) {
+        return nullptr;
+    }
+    // Skia may keep the value longer than the mapping lives, so it gets its own copy.
+    return SkData::MakeWithCopy(data + entry->valueOffset, entry->valueSize);
+}
+
+void SharedShaderCache::Builder::add(const SkData& key, const SkData& value) {
+    mEntries[std::string(toStringView(key.data(), key.size()))] =
+            std::string(toStringView(value.data(), value.size()));
+}
+
+bool SharedShaderCache::Builder::write(const std::string& path,
+                                       const std::vector<uint8_t>& idHash) const {
+    ATRACE_NAME("SharedShaderCache::Builder::write");
+    const std::string fingerprint = buildFingerprint();
+    const Header header{
+            .magic = kMagic,
+            .version = kVersion,
+            .idHashSize = static_cast<uint32_t>(idHash.size()),
+            .fingerprintSize = static_cast<uint32_t>(fingerprint.size()),
+            .entryCount = static_cast<uint32_t>(mEntries.size()),
+    };
+
+    std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.append(toStringView(idHash.data(), idHash.size()));
+    out.append(fingerprint);
+    out.resize(align4(out.size()), '\0');
+
+    const size_t entriesOffset = out.size();
+    size_t dataOffset = entriesOffset + mEntries.size() * sizeof(Entry);
+    std::string entryData;
+    for (const auto& [key, value] : mEntries) {
+        const Entry entry{
+                .keyOffset = static_cast<uint32_t>(dataOffset),
+                .keySize = static_cast<uint32_t>(key.size()),
+                .valueOffset = static_cast<uint32_t>(dataOffset + key.size()),
+                .valueSize = static_cast<uint32_t>(value.size()),
+        };
+        out.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        entryData.append(key);
+        entryData.append(value);
+        dataOffset += key.size() + value.size();
+    }
+    out.append(entryData);
+    if (out.size() > UINT32_MAX) {
+        ALOGE("SharedShaderCache::Builder::write: %zu bytes is too big", out.size());
+        return false;
+    }
+
+    // Every app maps the shared cache.
+    const std::string tmpPath = path + ".tmp";
+    if (!base::WriteStringToFile(out, tmpPath, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH, getuid(),
+                                 getgid())) {
+        ALOGE("SharedShaderCache::Builder::write: could not write %s (errno = %d)",
+              tmpPath.c_str(), errno);
+        return false;
+    }
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ALOGE("SharedShaderCache::Builder::write: could not rename %s (errno = %d)",
+              tmpPath.c_str(), errno);
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+} /* namespace skiapipeline */
+} /* namespace uirenderer */
+} /* namespace android */
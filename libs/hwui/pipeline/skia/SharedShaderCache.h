@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <SkData.h>
+#include <SkRefCnt.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PipelineCache.h"
+
+namespace android {
+namespace uirenderer {
+namespace skiapipeline {
+
+/**
+ * A read-only cache of the shaders that every app compiles, like the ones of ripples, shadows and
+ * the standard text and image draws. It is built once per device and build by a system process,
+ * and mapped by each app's ShaderCache, which consults it before its own cache.
+ *
+ * The file starts with a header, followed by the identity hash of the cache and the build
+ * fingerprint, a table of entries sorted by key, and the keys and values themselves. All the
+ * integers are 32-bit words in host byte order, as the file never leaves the device.
+ */
+class SharedShaderCache {
+public:
+    ~SharedShaderCache();
+
+    SharedShaderCache(const SharedShaderCache&) = delete;
+    SharedShaderCache& operator=(const SharedShaderCache&) = delete;
+
+    /**
+     * Maps the shared cache at path. Returns nullptr if there is no such file, or if it is
+     * invalid or was built for another identity hash or build.
+     */
+    static std::unique_ptr<SharedShaderCache> open(const std::string& path,
+                                                   const std::vector<uint8_t>& idHash);
+
+    /**
+     * Returns a copy of the value of key, or nullptr if the shared cache doesn't contain it.
+     */
+    sk_sp<SkData> find(const SkData& key) const;
+
+    size_t entryCount() const { return mEntryCount; }
+
+    class Builder {
+    public:
+        void add(const SkData& key, const SkData& value);
+
+        size_t entryCount() const { return mEntries.size(); }
+
+        /**
+         * Writes the shared cache to a temporary file next to path and renames it to path, so
+         * that apps never map a partially written cache.
+         */
+        bool write(const std::string& path, const std::vector<uint8_t>& idHash) const;
+
+    private:
+        // Sorted by key, as SharedShaderCache::find() does a binary search.
+        std::map<std::string, std::string> mEntries;
+    };
+
+private:
+    struct Entry {
+        uint32_t keyOffset;
+        uint32_t keySize;
+        uint32_t valueOffset;
+        uint32_t valueSize;
+    };
+
+    SharedShaderCache(Memory memory, const Entry* entries, uint32_t entryCount)
+            : mMemory(memory), mEntries(entries), mEntryCount(entryCount) {}
+
+    Memory mMemory;
+    const Entry* mEntries;
+    uint32_t mEntryCount;
+};
+
+} /* namespace skiapipeline */
+} /* namespace uirenderer */
+} /* namespace android */
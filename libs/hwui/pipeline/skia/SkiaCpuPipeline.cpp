@@ -16,11 +16,20 @@
 
 #include "pipeline/skia/SkiaCpuPipeline.h"
 
+#include <SkBBHFactory.h>
+#include <SkPicture.h>
+#include <SkPictureRecorder.h>
+#include <gui/TraceUtils.h>
 #include <system/window.h>
 
+#include <future>
+#include <vector>
+
 #include "DeviceInfo.h"
 #include "LightingInfo.h"
+#include "Properties.h"
 #include "renderthread/Frame.h"
+#include "thread/CommonPool.h"
 #include "utils/Color.h"
 
 using namespace android::uirenderer::renderthread;
@@ -103,11 +112,77 @@ IRenderPipeline::DrawResult SkiaCpuPipeline::draw(
         const std::vector<sp<RenderNode>>& renderNodes, FrameInfoVisualizer* profiler,
         const HardwareBufferRenderParams& bufferParams, std::mutex& profilerLock) {
     LightingInfo::updateLighting(lightGeometry, lightInfo);
-    renderFrame(*layerUpdateQueue, dirty, renderNodes, opaque, contentDrawBounds, mSurface,
-                SkMatrix::I());
+    if (!renderFrameTiled(*layerUpdateQueue, dirty, renderNodes, opaque, contentDrawBounds)) {
+        renderFrame(*layerUpdateQueue, dirty, renderNodes, opaque, contentDrawBounds, mSurface,
+                    SkMatrix::I());
+    }
     return {true, IRenderPipeline::DrawResult::kUnknownTime, android::base::unique_fd{}};
 }
 
+// Bands shorter than this don't make up for the cost of recording the frame and waking up a
+// worker thread.
+static constexpr int kMinTileHeight = 64;
+
+bool SkiaCpuPipeline::renderFrameTiled(const LayerUpdateQueue& layers, const SkRect& clip,
+                                       const std::vector<sp<RenderNode>>& nodes, bool opaque,
+                                       const Rect& contentDrawBounds) {
+    if (!Properties::cpuTiledRendering || Properties::skpCaptureEnabled || isCapturingSkp() ||
+        CC_UNLIKELY(Properties::debugOverdraw)) {
+        return false;
+    }
+    SkPixmap pixels;
+    if (!mSurface->peekPixels(&pixels)) {
+        return false;
+    }
+    SkIRect bounds = clip.roundOut();
+    if (!bounds.intersect(pixels.bounds())) {
+        return false;
+    }
+    const int tileCount = std::min(CommonPool::THREAD_COUNT + 1, bounds.height() / kMinTileHeight);
+    if (tileCount < 2) {
+        return false;
+    }
+
+    ATRACE_FORMAT("SkiaCpuPipeline::renderFrameTiled %d tiles", tileCount);
+    renderLayersImpl(layers, opaque);
+
+    // Drawing the RenderNodes updates their state, so the tree is drawn once on this thread. The
+    // R-tree of the picture lets each band skip the ops that fall outside of it.
+    SkPictureRecorder recorder;
+    SkRTreeFactory rtreeFactory;
+    SkCanvas* recordingCanvas =
+            recorder.beginRecording(SkRect::Make(pixels.bounds()), &rtreeFactory);
+    renderFrameImpl(clip, nodes, opaque, contentDrawBounds, recordingCanvas, SkMatrix::I());
+    sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+
+    // The bands cover disjoint rows of the surface, so their canvases can write to the pixels
+    // concurrently.
+    const SkSurfaceProps props = mSurface->props();
+    auto drawTile = [&pixels, &bounds, &props, &picture, tileCount](int index) {
+        const SkIRect tile = SkIRect::MakeLTRB(
+                bounds.fLeft, bounds.fTop + bounds.height() * index / tileCount, bounds.fRight,
+                bounds.fTop + bounds.height() * (index + 1) / tileCount);
+        SkPixmap tilePixels;
+        if (!pixels.extractSubset(&tilePixels, tile)) {
+            return;
+        }
+        std::unique_ptr<SkCanvas> canvas = SkCanvas::MakeRasterDirect(
+                tilePixels.info(), tilePixels.writable_addr(), tilePixels.rowBytes(), &props);
+        canvas->translate(-tile.fLeft, -tile.fTop);
+        picture->playback(canvas.get());
+    };
+    std::vector<std::future<void>> pending;
+    pending.reserve(tileCount - 1);
+    for (int i = 1; i < tileCount; i++) {
+        pending.push_back(CommonPool::async([&drawTile, i] { drawTile(i); }));
+    }
+    drawTile(0);
+    for (auto& future : pending) {
+        future.get();
+    }
+    return true;
+}
+
 bool SkiaCpuPipeline::setSurface(ANativeWindow* surface, SwapBehavior swapBehavior) {
     if (surface) {
         ANativeWindowBuffer* buffer;
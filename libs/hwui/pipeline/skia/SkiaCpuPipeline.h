@@ -69,6 +69,13 @@ public:
     }
 
 private:
+    // Records the frame into an SkPicture and rasterizes it in horizontal bands on the
+    // CommonPool threads. Returns false without drawing anything if the frame is too small to
+    // be worth splitting, or if a capture or debug overlay needs the regular path.
+    bool renderFrameTiled(const LayerUpdateQueue& layers, const SkRect& clip,
+                          const std::vector<sp<RenderNode>>& nodes, bool opaque,
+                          const Rect& contentDrawBounds);
+
     sk_sp<SkSurface> mSurface;
 };
 
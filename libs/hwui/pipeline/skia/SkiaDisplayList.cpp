@@ -18,15 +18,22 @@
 
 #include <SkImagePriv.h>
 #include <SkPathOps.h>
+#include <gui/TraceUtils.h>
+
+#include <future>
+#include <memory>
+#include <vector>
 
 // clang-format off
 #include "FunctorDrawable.h" // Must be included before DumpOpsCanvas.h
 #include "DumpOpsCanvas.h"
 // clang-format on
+#include "DamageAccumulator.h"
 #include "SkiaPipeline.h"
 #include "TreeInfo.h"
 #include "VectorDrawable.h"
 #include "renderthread/CanvasContext.h"
+#include "thread/CommonPool.h"
 
 namespace android {
 namespace uirenderer {
@@ -91,6 +98,105 @@ static bool intersects(const SkISize screenSize, const Matrix4& mat, const SkRec
     return SkRect::Make(screenSize).intersects(SkRect::MakeLTRB(minX, minY, maxX, maxY));
 }
 
+// Handing subtrees to the CommonPool costs a couple of thread wake ups, which only pays off for
+// display lists with many nodes below them.
+static constexpr size_t kMinParallelPrepareChildren = 4;
+static constexpr size_t kMinParallelPrepareNodes = 64;
+
+namespace {
+
+struct ParallelChild {
+    RenderNodeDrawable* drawable;
+    size_t nodeCount;
+};
+
+// A share of the children of a display list that is prepared on one thread. The damage is
+// accumulated relative to the display list and merged back on the RenderThread.
+struct PrepareBatch {
+    explicit PrepareBatch(const TreeInfo& parent) : info(parent.mode, parent.canvasContext) {
+        info.prepareTextures = false;
+        info.runAnimations = parent.runAnimations;
+        info.damageAccumulator = &damageAccumulator;
+        info.damageGenerationId = parent.damageGenerationId;
+        info.colorArea = parent.colorArea;
+        info.layerUpdateQueue = parent.layerUpdateQueue;
+        info.errorHandler = parent.errorHandler;
+        info.updateWindowPositions = parent.updateWindowPositions;
+        info.disableForceDark = parent.disableForceDark;
+        info.forceDarkType = parent.forceDarkType;
+        info.stretchEffectCount = parent.stretchEffectCount;
+        info.forceDrawFrame = parent.forceDrawFrame;
+    }
+
+    DamageAccumulator damageAccumulator;
+    TreeInfo info;
+    std::vector<RenderNodeDrawable*> children;
+    size_t nodeCount = 0;
+};
+
+}  // namespace
+
+// Prepares children for which RenderNode::canPrepareInParallel() returned true on the CommonPool
+// and the calling thread. The batches are merged in order, so the damage and the output flags are
+// the same as if the children had been prepared one after the other.
+static void prepareChildrenInParallel(
+        const std::vector<ParallelChild>& children, TreeObserver& observer, TreeInfo& info,
+        bool functorsNeedLayer,
+        const std::function<void(RenderNode*, TreeObserver&, TreeInfo&, bool)>& childFn) {
+    ATRACE_FORMAT("prepareChildrenInParallel %zu", children.size());
+    const size_t batchCount = std::min(children.size(), size_t(CommonPool::THREAD_COUNT + 1));
+    std::vector<std::unique_ptr<PrepareBatch>> batches;
+    batches.reserve(batchCount);
+    for (size_t i = 0; i < batchCount; i++) {
+        batches.push_back(std::make_unique<PrepareBatch>(info));
+    }
+    for (const ParallelChild& child : children) {
+        PrepareBatch* lightest = batches[0].get();
+        for (const auto& batch : batches) {
+            if (batch->nodeCount < lightest->nodeCount) lightest = batch.get();
+        }
+        lightest->children.push_back(child.drawable);
+        lightest->nodeCount += child.nodeCount;
+    }
+
+    auto prepareBatch = [&observer, functorsNeedLayer, &childFn](PrepareBatch* batch) {
+        for (RenderNodeDrawable* child : batch->children) {
+            Matrix4 mat4(child->getRecordedMatrix());
+            batch->damageAccumulator.pushTransform(&mat4);
+            childFn(child->getRenderNode(), observer, batch->info, functorsNeedLayer);
+            batch->damageAccumulator.popTransform();
+        }
+    };
+    std::vector<std::future<void>> pending;
+    pending.reserve(batchCount - 1);
+    for (size_t i = 1; i < batchCount; i++) {
+        PrepareBatch* batch = batches[i].get();
+        pending.push_back(CommonPool::async([&prepareBatch, batch] { prepareBatch(batch); }));
+    }
+    prepareBatch(batches[0].get());
+    for (auto& future : pending) {
+        future.get();
+    }
+
+    for (const auto& batch : batches) {
+        SkRect dirty;
+        batch->damageAccumulator.peekAtDirty(&dirty);
+        if (!dirty.isEmpty()) {
+            info.damageAccumulator->dirty(dirty.fLeft, dirty.fTop, dirty.fRight, dirty.fBottom);
+        }
+        const TreeInfo::Out& out = batch->info.out;
+        info.out.hasFunctors |= out.hasFunctors;
+        info.out.hasAnimations |= out.hasAnimations;
+        info.out.requiresUiRedraw |= out.requiresUiRedraw;
+        info.out.solelyTextureViewUpdates &= out.solelyTextureViewUpdates;
+        if (out.animatedImageDelay != TreeInfo::Out::kNoAnimatedImageDelay &&
+            (info.out.animatedImageDelay == TreeInfo::Out::kNoAnimatedImageDelay ||
+             out.animatedImageDelay < info.out.animatedImageDelay)) {
+            info.out.animatedImageDelay = out.animatedImageDelay;
+        }
+    }
+}
+
 bool SkiaDisplayList::prepareListAndChildren(
         TreeObserver& observer, TreeInfo& info, bool functorsNeedLayer,
         std::function<void(RenderNode*, TreeObserver&, TreeInfo&, bool)> childFn) {
@@ -115,7 +221,7 @@ bool SkiaDisplayList::prepareListAndChildren(
     bool hasBackwardProjectedNodesHere = false;
     bool hasBackwardProjectedNodesSubtree = false;
 
-    for (auto& child : mChildNodes) {
+    auto prepareChild = [&](RenderNodeDrawable& child) {
         RenderNode* childNode = child.getRenderNode();
         Matrix4 mat4(child.getRecordedMatrix());
         info.damageAccumulator->pushTransform(&mat4);
@@ -124,6 +230,51 @@ bool SkiaDisplayList::prepareListAndChildren(
         hasBackwardProjectedNodesHere |= child.getNodeProperties().getProjectBackwards();
         hasBackwardProjectedNodesSubtree |= info.hasBackwardProjectedNodes;
         info.damageAccumulator->popTransform();
+    };
+
+    // Children that can be prepared in parallel are gathered while the others are prepared right
+    // away. Subtrees that can be prepared in parallel have no backward projected nodes, so
+    // deferring them doesn't change the projection bookkeeping below.
+    const bool isModeFull = info.mode == TreeInfo::MODE_FULL;
+    const bool tryParallel =
+            info.parallelPrepare && mChildNodes.size() >= kMinParallelPrepareChildren;
+    std::vector<ParallelChild> parallelChildren;
+    size_t parallelNodeCount = 0;
+    bool preparedAfterGathering = false;
+    for (auto& child : mChildNodes) {
+        size_t nodeCount = 0;
+        if (tryParallel && child.getRenderNode()->canPrepareInParallel(isModeFull, &nodeCount)) {
+            parallelChildren.push_back({&child, nodeCount});
+            parallelNodeCount += nodeCount;
+        } else {
+            prepareChild(child);
+            preparedAfterGathering |= !parallelChildren.empty();
+        }
+    }
+
+    if (!parallelChildren.empty() && isModeFull && preparedAfterGathering) {
+        // Syncing the display lists of the children prepared above may have changed the parent
+        // counts of the gathered nodes.
+        std::vector<ParallelChild> stillParallel;
+        parallelNodeCount = 0;
+        for (const ParallelChild& child : parallelChildren) {
+            size_t nodeCount = 0;
+            if (child.drawable->getRenderNode()->canPrepareInParallel(isModeFull, &nodeCount)) {
+                stillParallel.push_back({child.drawable, nodeCount});
+                parallelNodeCount += nodeCount;
+            } else {
+                prepareChild(*child.drawable);
+            }
+        }
+        parallelChildren = std::move(stillParallel);
+    }
+
+    if (parallelChildren.size() > 1 && parallelNodeCount >= kMinParallelPrepareNodes) {
+        prepareChildrenInParallel(parallelChildren, observer, info, functorsNeedLayer, childFn);
+    } else {
+        for (const ParallelChild& child : parallelChildren) {
+            prepareChild(*child.drawable);
+        }
     }
 
     // The purpose of next block of code is to reset projected display list if there are no
@@ -192,7 +192,7 @@ public:
         mHasHolePunches = hasHolePunches;
     }
 
-    bool hasHolePunches() {
+    bool hasHolePunches() const {
         return mHasHolePunches;
     }
 
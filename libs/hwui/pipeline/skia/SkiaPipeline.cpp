@@ -111,7 +111,7 @@ bool SkiaPipeline::renderLayerImpl(RenderNode* layerNode, const Rect& layerDamag
 }
 
 static void savePictureAsync(const sk_sp<SkData>& data, const std::string& filename) {
-    CommonPool::post([data, filename] {
+    CommonPool::postBackground([data, filename] {
         if (0 == access(filename.c_str(), F_OK)) {
             return;
         }
@@ -301,7 +301,7 @@ void SkiaPipeline::endCapture(SkSurface* surface) {
             // to a bare pointer because keeping it in a smart pointer makes the lambda
             // non-copyable. The lambda is only called once, so this is safe.
             SkFILEWStream* stream = mOpenMultiPicStream.release();
-            CommonPool::post([doc = std::move(mMultiPic), stream]{
+            CommonPool::postBackground([doc = std::move(mMultiPic), stream]{
                 ALOGD("Finalizing multi frame SKP");
                 doc->close();
                 delete stream;
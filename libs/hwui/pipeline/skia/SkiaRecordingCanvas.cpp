@@ -99,6 +99,7 @@ std::unique_ptr<SkiaDisplayList> SkiaRecordingCanvas::finishRecording() {
     // close any existing chunks if necessary
     enableZ(false);
     mRecorder.restoreToCount(1);
+    mDisplayList->mDisplayList.finishRecording();
     return std::move(mDisplayList);
 }
 
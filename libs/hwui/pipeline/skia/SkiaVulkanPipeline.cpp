@@ -162,7 +162,9 @@ void SkiaVulkanPipeline::onStop() {}
 }
 
 // We can safely ignore the swap behavior because VkManager will always operate
-// in a mode equivalent to EGLManager::SwapBehavior::kBufferAge
+// in a mode equivalent to EGLManager::SwapBehavior::kBufferAge, unless partial updates
+// are disabled: VulkanSurface tracks the age of its buffers, and the damage is passed
+// to the window when presenting them.
 bool SkiaVulkanPipeline::setSurface(ANativeWindow* surface, SwapBehavior /*swapBehavior*/) {
     mNativeWindow = surface;
 
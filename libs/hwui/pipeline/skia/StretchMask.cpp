@@ -59,11 +59,14 @@ void StretchMask::draw(GrRecordingContext*,
         displayList->mParentMatrix = previousMatrix;
     }
 
-    sk_sp<SkImage> maskImage = mMaskSurface->makeImageSnapshot();
-    sk_sp<SkShader> maskStretchShader = stretch.getShader(width, height, maskImage, nullptr);
+    if (mIsDirty || mMaskShader == nullptr || !(mMaskShaderStretch == stretch)) {
+        sk_sp<SkImage> maskImage = mMaskSurface->makeImageSnapshot();
+        mMaskShader = stretch.getShader(width, height, maskImage, nullptr);
+        mMaskShaderStretch = stretch;
+    }
 
     SkPaint maskPaint;
-    maskPaint.setShader(maskStretchShader);
+    maskPaint.setShader(mMaskShader);
     maskPaint.setBlendMode(SkBlendMode::kDstOut);
     canvas->drawRect(bounds, maskPaint);
 
@@ -34,6 +34,7 @@ class StretchMask {
    */
   void clear() {
       mMaskSurface = nullptr;
+      mMaskShader = nullptr;
   }
 
   /**
@@ -58,6 +59,10 @@ class StretchMask {
 private:
   sk_sp<SkSurface> mMaskSurface;
   bool mIsDirty = true;
+  // The stretched mask shader from the last draw. It only depends on the mask contents and the
+  // stretch, so it is reused while neither changes.
+  sk_sp<SkShader> mMaskShader;
+  StretchEffect mMaskShaderStretch;
 };
 
 }
@@ -30,6 +30,8 @@
 #include <thread>
 
 #include "renderthread/EglManager.h"
+#include "renderthread/RenderThread.h"
+#include "renderthread/VulkanManager.h"
 #include "thread/ThreadBase.h"
 #include "utils/TimeUtils.h"
 #include "effects/GainmapRenderer.h"
@@ -37,6 +39,8 @@
 #include <SkBlendMode.h>
 #include <SkImage.h>
 #include <SkImageAndroid.h>
+#include <android-base/unique_fd.h>
+#include <include/gpu/ganesh/GrDirectContext.h>
 
 namespace android {
 namespace uirenderer {
@@ -163,19 +167,30 @@ void VkInteropFunctorDrawable::onDraw(SkCanvas* canvas) {
 
         mWebViewHandle->drawGl(info);
 
-        EGLSyncKHR glDrawFinishedFence =
-                eglCreateSyncKHR(eglGetCurrentDisplay(), EGL_SYNC_FENCE_KHR, NULL);
-        LOG_ALWAYS_FATAL_IF(glDrawFinishedFence == EGL_NO_SYNC_KHR,
-                            "Could not create sync fence %#x", eglGetError());
-        glFlush();
-        // TODO: export EGLSyncKHR in file descr
-        // TODO: import file desc in Vulkan Semaphore
-        // TODO: instead block the GPU: probably by using external Vulkan semaphore.
-        // Block the CPU until the glFlush finish.
-        EGLint waitStatus = eglClientWaitSyncKHR(display, glDrawFinishedFence, 0, FENCE_TIMEOUT);
-        LOG_ALWAYS_FATAL_IF(waitStatus != EGL_CONDITION_SATISFIED_KHR,
-                            "Failed to wait for the fence %#x", eglGetError());
-        eglDestroySyncKHR(display, glDrawFinishedFence);
+        // Export the end of the WebView draw as a native fence and make Vulkan wait on it, so
+        // that the GPU rather than the render thread waits for WebView to finish.
+        EGLSyncKHR unusedFence = EGL_NO_SYNC_KHR;
+        int nativeFence = -1;
+        sEglManager.createReleaseFence(false, &unusedFence, &nativeFence);
+        base::unique_fd glDrawFinishedFd(nativeFence);
+        GrDirectContext* directContext = canvas->recordingContext()->asDirectContext();
+        const bool gpuWaits =
+                glDrawFinishedFd.ok() && directContext &&
+                renderthread::RenderThread::getInstance().vulkanManager().fenceWait(
+                        glDrawFinishedFd.get(), directContext) == OK;
+        if (!gpuWaits) {
+            EGLSyncKHR glDrawFinishedFence =
+                    eglCreateSyncKHR(eglGetCurrentDisplay(), EGL_SYNC_FENCE_KHR, NULL);
+            LOG_ALWAYS_FATAL_IF(glDrawFinishedFence == EGL_NO_SYNC_KHR,
+                                "Could not create sync fence %#x", eglGetError());
+            glFlush();
+            // Block the CPU until the glFlush finish.
+            EGLint waitStatus =
+                    eglClientWaitSyncKHR(display, glDrawFinishedFence, 0, FENCE_TIMEOUT);
+            LOG_ALWAYS_FATAL_IF(waitStatus != EGL_CONDITION_SATISFIED_KHR,
+                                "Failed to wait for the fence %#x", eglGetError());
+            eglDestroySyncKHR(display, glDrawFinishedFence);
+        }
     }
 
     SkPaint paint;
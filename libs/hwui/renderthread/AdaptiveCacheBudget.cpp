@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AdaptiveCacheBudget.h"
+
+#include <algorithm>
+
+namespace android {
+namespace uirenderer {
+namespace renderthread {
+
+// The cache counts as full when its usage is this close to the limit.
+static constexpr float kSaturatedUsage = 0.95f;
+
+static const char* toString(AdaptiveCacheBudget::Decision decision) {
+    switch (decision) {
+        case AdaptiveCacheBudget::Decision::None:
+            return "none";
+        case AdaptiveCacheBudget::Decision::Grow:
+            return "grow";
+        case AdaptiveCacheBudget::Decision::Shrink:
+            return "shrink";
+        case AdaptiveCacheBudget::Decision::MemoryPressure:
+            return "memory pressure";
+    }
+}
+
+void AdaptiveCacheBudget::reset(size_t baseBytes, const MemoryPolicy& policy) {
+    mMinLimit = baseBytes * policy.minAdaptiveResourceScale;
+    mMaxLimit = std::max(mMinLimit,
+                         static_cast<size_t>(baseBytes * policy.maxAdaptiveResourceScale));
+    mLimit = std::clamp(baseBytes, mMinLimit, mMaxLimit);
+    mWindowFrames = 0;
+    mSaturatedFrames = 0;
+    mPeakUsage = 0;
+    mUnderMemoryPressure = false;
+}
+
+bool AdaptiveCacheBudget::onFrameCompleted(size_t usedBytes) {
+    if (usedBytes >= mLimit * kSaturatedUsage) {
+        mSaturatedFrames++;
+    }
+    mPeakUsage = std::max(mPeakUsage, usedBytes);
+    return ++mWindowFrames >= kWindowFrames;
+}
+
+bool AdaptiveCacheBudget::update(bool underMemoryPressure) {
+    const int saturatedFrames = mSaturatedFrames;
+    const size_t peakUsage = mPeakUsage;
+    mWindowFrames = 0;
+    mSaturatedFrames = 0;
+    mPeakUsage = 0;
+
+    if (underMemoryPressure) {
+        return onMemoryPressure();
+    }
+    mUnderMemoryPressure = false;
+    if (saturatedFrames * 4 > kWindowFrames) {
+        return setLimit(mLimit * kGrowFactor, Decision::Grow);
+    }
+    if (peakUsage * 2 < mLimit) {
+        return setLimit(peakUsage * kShrinkHeadroom, Decision::Shrink);
+    }
+    return false;
+}
+
+bool AdaptiveCacheBudget::onMemoryPressure() {
+    mUnderMemoryPressure = true;
+    return setLimit(mMinLimit, Decision::MemoryPressure);
+}
+
+bool AdaptiveCacheBudget::setLimit(size_t limit, Decision decision) {
+    limit = std::clamp(limit, mMinLimit, mMaxLimit);
+    if (limit == mLimit) {
+        return false;
+    }
+    mLimit = limit;
+    mLastDecision = decision;
+    switch (decision) {
+        case Decision::Grow:
+            mGrowCount++;
+            break;
+        case Decision::Shrink:
+            mShrinkCount++;
+            break;
+        case Decision::MemoryPressure:
+            mPressureCount++;
+            break;
+        case Decision::None:
+            break;
+    }
+    return true;
+}
+
+void AdaptiveCacheBudget::dump(String8& log) const {
+    log.appendFormat("Adaptive resource budget: %.2fMB (%.2fMB - %.2fMB)\n", mLimit / 1000000.f,
+                     mMinLimit / 1000000.f, mMaxLimit / 1000000.f);
+    log.appendFormat("  Decisions: %u grow, %u shrink, %u memory pressure (last = %s)\n",
+                     mGrowCount, mShrinkCount, mPressureCount, toString(mLastDecision));
+}
+
+} /* namespace renderthread */
+} /* namespace uirenderer */
+} /* namespace android */
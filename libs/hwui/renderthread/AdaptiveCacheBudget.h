@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utils/String8.h>
+
+#include "MemoryPolicy.h"
+
+namespace android {
+namespace uirenderer {
+namespace renderthread {
+
+/**
+ * Adapts the size limit of the GPU resource cache to how much of it the frames actually use.
+ *
+ * The static limit of CacheManager is derived from the surface area, which is too much for apps
+ * that draw little, and too little for apps that keep many textures and layers alive, like the
+ * ones spanning several displays. Once per window of kWindowFrames frames:
+ * - the limit grows by kGrowFactor if the cache was full for more than a quarter of the frames,
+ *   which means that Skia had to evict resources that frames went on to recreate.
+ * - the limit shrinks to kShrinkHeadroom times the peak usage if that is less than half of it.
+ * - under memory pressure, the limit never grows and drops to its lower bound.
+ * The limit always stays within the bounds of the MemoryPolicy.
+ */
+class AdaptiveCacheBudget {
+public:
+    static constexpr int kWindowFrames = 60;
+    static constexpr float kGrowFactor = 1.25f;
+    static constexpr float kShrinkHeadroom = 1.5f;
+
+    enum class Decision {
+        None,
+        Grow,
+        Shrink,
+        MemoryPressure,
+    };
+
+    /**
+     * Starts over from baseBytes, the static limit of the cache.
+     */
+    void reset(size_t baseBytes, const MemoryPolicy& policy);
+
+    size_t limit() const { return mLimit; }
+
+    /** Whether the last update() or onMemoryPressure() saw the device under memory pressure. */
+    bool isUnderMemoryPressure() const { return mUnderMemoryPressure; }
+
+    /**
+     * Accounts for a completed frame, with usedBytes in the cache at the end of it. Returns true
+     * once the window is complete, update() must then be called.
+     */
+    bool onFrameCompleted(size_t usedBytes);
+
+    /**
+     * Decides on the limit for the next window, and returns whether it changed.
+     */
+    bool update(bool underMemoryPressure);
+
+    /**
+     * Drops the limit to its lower bound right away, for trim signals.
+     */
+    bool onMemoryPressure();
+
+    void dump(String8& log) const;
+
+private:
+    bool setLimit(size_t limit, Decision decision);
+
+    size_t mMinLimit = 0;
+    size_t mMaxLimit = 0;
+    size_t mLimit = 0;
+
+    int mWindowFrames = 0;
+    int mSaturatedFrames = 0;
+    size_t mPeakUsage = 0;
+    bool mUnderMemoryPressure = false;
+
+    Decision mLastDecision = Decision::None;
+    uint32_t mGrowCount = 0;
+    uint32_t mShrinkCount = 0;
+    uint32_t mPressureCount = 0;
+};
+
+} /* namespace renderthread */
+} /* namespace uirenderer */
+} /* namespace android */
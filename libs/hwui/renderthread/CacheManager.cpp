@@ -18,17 +18,21 @@
 
 #include <SkExecutor.h>
 #include <SkGraphics.h>
+#include <android-base/file.h>
 #include <include/gpu/ganesh/GrContextOptions.h>
 #include <include/gpu/ganesh/GrTypes.h>
 #include <math.h>
+#include <stdio.h>
 #include <utils/Trace.h>
 
 #include <set>
 
 #include "CanvasContext.h"
 #include "DeviceInfo.h"
+#include "HardwareBitmapUploader.h"
 #include "Layer.h"
 #include "Properties.h"
+#include "RecordingCanvas.h"
 #include "RenderThread.h"
 #include "VulkanManager.h"
 #include "pipeline/skia/ATraceMemoryDump.h"
@@ -37,6 +41,7 @@
 #include "pipeline/skia/SkiaMemoryTracer.h"
 #include "renderstate/RenderState.h"
 #include "thread/CommonPool.h"
+#include "utils/ChunkPool.h"
 
 namespace android {
 namespace uirenderer {
@@ -72,8 +77,33 @@ void CacheManager::setupCacheLimits() {
     mBackgroundCpuFontCacheBytes = mMaxCpuFontCacheBytes * mMemoryPolicy.backgroundRetentionPercent;
 
     SkGraphics::SetFontCacheLimit(mMaxCpuFontCacheBytes);
+    mAdaptiveBudget.reset(mMaxResourceBytes, mMemoryPolicy);
     if (mGrContext) {
-        mGrContext->setResourceCacheLimit(mMaxResourceBytes);
+        mGrContext->setResourceCacheLimit(resourceCacheLimit());
+    }
+}
+
+size_t CacheManager::resourceCacheLimit() const {
+    return Properties::adaptiveCacheBudget ? mAdaptiveBudget.limit() : mMaxResourceBytes;
+}
+
+// Whether some tasks stalled on memory for more than threshold percent of the last 10 seconds,
+// according to the pressure stall information of the kernel.
+static bool isUnderMemoryPressure(float threshold) {
+    std::string pressure;
+    if (!base::ReadFileToString("/proc/pressure/memory", &pressure)) {
+        return false;
+    }
+    float someAvg10 = 0;
+    return sscanf(pressure.c_str(), "some avg10=%f", &someAvg10) == 1 && someAvg10 > threshold;
+}
+
+void CacheManager::updateAdaptiveBudget() {
+    ATRACE_CALL();
+    const bool underMemoryPressure = isUnderMemoryPressure(mMemoryPolicy.memoryPressureThreshold);
+    if (mAdaptiveBudget.update(underMemoryPressure)) {
+        mGrContext->setResourceCacheLimit(mAdaptiveBudget.limit());
+        ATRACE_INT("HWUI resource budget", mAdaptiveBudget.limit());
     }
 }
 
@@ -84,7 +114,7 @@ void CacheManager::reset(sk_sp<GrDirectContext> context) {
 
     if (context) {
         mGrContext = std::move(context);
-        mGrContext->setResourceCacheLimit(mMaxResourceBytes);
+        mGrContext->setResourceCacheLimit(resourceCacheLimit());
         mLastDeferredCleanup = systemTime(CLOCK_MONOTONIC);
     }
 }
@@ -120,6 +150,16 @@ static GrPurgeResourceOptions toSkiaEnum(bool scratchOnly) {
 }
 
 void CacheManager::trimMemory(TrimLevel mode) {
+    if (mode >= TrimLevel::UI_HIDDEN) {
+        ChunkPool::get().trim();
+    }
+
+    // The running levels mean that the device is low on memory while the app is in use.
+    if (Properties::adaptiveCacheBudget && mode >= TrimLevel::RUNNING_LOW &&
+        mode < TrimLevel::UI_HIDDEN && mAdaptiveBudget.onMemoryPressure() && mGrContext) {
+        mGrContext->setResourceCacheLimit(mAdaptiveBudget.limit());
+    }
+
     if (!mGrContext) {
         return;
     }
@@ -127,6 +167,13 @@ void CacheManager::trimMemory(TrimLevel mode) {
     // flush and submit all work to the gpu and wait for it to finish
     mGrContext->flushAndSubmit(GrSyncCpu::kYes);
 
+    // The layers that cache unchanged RenderNodes only save time, they are the first to go.
+    if (mode >= TrimLevel::RUNNING_CRITICAL) {
+        for (auto context : mCanvasContexts) {
+            context->destroyAutoLayers();
+        }
+    }
+
     if (mode >= TrimLevel::BACKGROUND) {
         mGrContext->freeGpuResources();
         SkGraphics::PurgeAllCaches();
@@ -138,7 +185,7 @@ void CacheManager::trimMemory(TrimLevel mode) {
         mGrContext->setResourceCacheLimit(mBackgroundResourceBytes);
         SkGraphics::SetFontCacheLimit(mBackgroundCpuFontCacheBytes);
         mGrContext->purgeUnlockedResources(toSkiaEnum(mMemoryPolicy.purgeScratchOnly));
-        mGrContext->setResourceCacheLimit(mMaxResourceBytes);
+        mGrContext->setResourceCacheLimit(resourceCacheLimit());
         SkGraphics::SetFontCacheLimit(mMaxCpuFontCacheBytes);
     }
 }
@@ -167,8 +214,12 @@ void CacheManager::trimStaleResources() {
         return;
     }
     mGrContext->flushAndSubmit();
-    mGrContext->performDeferredCleanup(std::chrono::seconds(30),
-                                       GrPurgeResourceOptions::kAllResources);
+    // Resources are released sooner while the device is short on memory.
+    const std::chrono::milliseconds staleTimeout =
+            Properties::adaptiveCacheBudget && mAdaptiveBudget.isUnderMemoryPressure()
+                    ? std::chrono::milliseconds(ns2ms(mMemoryPolicy.minimumResourceRetention))
+                    : std::chrono::seconds(30);
+    mGrContext->performDeferredCleanup(staleTimeout, GrPurgeResourceOptions::kAllResources);
 }
 
 void CacheManager::getMemoryUsage(size_t* cpuUsage, size_t* gpuUsage) {
@@ -201,11 +252,30 @@ void CacheManager::dumpMemoryUsage(String8& log, const RenderState* renderState)
         log.appendFormat("  IsSystemOrPersistent\n");
     }
     log.appendFormat("  GPU Context timeout: %" PRIu64 "\n", ns2s(mMemoryPolicy.contextTimeout));
+    if (Properties::adaptiveCacheBudget) {
+        mAdaptiveBudget.dump(log);
+    }
     size_t stoppedContexts = 0;
     for (auto context : mCanvasContexts) {
         if (context->isStopped()) stoppedContexts++;
     }
     log.appendFormat("Contexts: %zu (stopped = %zu)\n", mCanvasContexts.size(), stoppedContexts);
+    const auto quickRejects = DisplayListData::getQuickRejectCounters();
+    log.appendFormat("Display list ops: %" PRIu64 " skipped by quick reject, %" PRIu64 " drawn\n",
+                     quickRejects.skippedOps, quickRejects.drawnOps);
+#ifdef __ANDROID__
+    const auto uploads = HardwareBitmapUploader::getUploadStats();
+    log.appendFormat("Hardware bitmaps: %" PRIu64 " buffers in %.2fms, %" PRIu64
+                     " up to %dx%d in %.2fms\n",
+                     uploads.bufferCount, uploads.uploadDuration / 1000000.0,
+                     uploads.smallBufferCount, HardwareBitmapUploader::kSmallBitmapSize,
+                     HardwareBitmapUploader::kSmallBitmapSize,
+                     uploads.smallUploadDuration / 1000000.0);
+#endif
+    const auto chunkPool = ChunkPool::get().getStats();
+    log.appendFormat("Recording buffers: %zu bytes cached, %" PRIu64 " recycled, %" PRIu64
+                     " allocated\n",
+                     chunkPool.cachedBytes, chunkPool.recycledChunks, chunkPool.allocatedChunks);
 
     auto vkInstance = VulkanManager::peekInstance();
     if (!mGrContext) {
@@ -266,6 +336,14 @@ void CacheManager::dumpMemoryUsage(String8& log, const RenderState* renderState)
 void CacheManager::onFrameCompleted() {
     cancelDestroyContext();
     mFrameCompletions.next() = systemTime(CLOCK_MONOTONIC);
+    skiapipeline::ShaderCache::get().onFrameCompleted();
+    if (Properties::adaptiveCacheBudget && mGrContext) {
+        size_t usedBytes;
+        mGrContext->getResourceCacheUsage(nullptr, &usedBytes);
+        if (mAdaptiveBudget.onFrameCompleted(usedBytes)) {
+            updateAdaptiveBudget();
+        }
+    }
     if (ATRACE_ENABLED()) {
         ATRACE_NAME("dumpingMemoryStatistics");
         static skiapipeline::ATraceMemoryDump tracer;
@@ -278,6 +356,31 @@ void CacheManager::onFrameCompleted() {
     }
 }
 
+void CacheManager::warmupShaderCache() {
+    if (!Properties::shaderCacheWarmup || !mGrContext) {
+        return;
+    }
+    auto keys = std::make_shared<const std::vector<sk_sp<SkData>>>(
+            skiapipeline::ShaderCache::get().getWarmupKeys());
+    ATRACE_INT("HWUI shader warmup keys", keys->size());
+    postShaderWarmup(std::move(keys), 0);
+}
+
+void CacheManager::postShaderWarmup(std::shared_ptr<const std::vector<sk_sp<SkData>>> keys,
+                                    size_t index) {
+    if (index >= keys->size()) {
+        return;
+    }
+    // Work that is queued meanwhile, like the first frame, runs between two of the tasks.
+    mRenderThread.queue().post([this, keys = std::move(keys), index]() mutable {
+        if (!mGrContext) {
+            return;
+        }
+        skiapipeline::ShaderCache::get().precompile(mGrContext.get(), *(*keys)[index]);
+        postShaderWarmup(std::move(keys), index + 1);
+    });
+}
+
 void CacheManager::onThreadIdle() {
     if (!mGrContext || mFrameCompletions.size() == 0) return;
 
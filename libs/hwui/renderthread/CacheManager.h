@@ -23,8 +23,10 @@
 #include <SkSurface.h>
 #include <utils/String8.h>
 
+#include <memory>
 #include <vector>
 
+#include "AdaptiveCacheBudget.h"
 #include "MemoryPolicy.h"
 #include "utils/RingBuffer.h"
 #include "utils/TimeUtils.h"
@@ -55,8 +57,15 @@ public:
 
     size_t getCacheSize() const { return mMaxResourceBytes; }
     size_t getBackgroundCacheSize() const { return mBackgroundResourceBytes; }
+    // The bytes that layers caching the content of unchanged RenderNodes may use per frame.
+    size_t getAutoLayerBudget() const { return mMaxResourceBytes / 4; }
     void onFrameCompleted();
     void notifyNextFrameSize(int width, int height);
+#ifdef __ANDROID__ // Layoutlib does not support hardware acceleration
+    // Precompiles the programs used in the first frames of the previous run of the app, one per
+    // RenderThread task and in the order they were first used.
+    void warmupShaderCache();
+#endif
 
     void onThreadIdle();
 
@@ -71,12 +80,16 @@ private:
 
     explicit CacheManager(RenderThread& thread);
     void setupCacheLimits();
+    // The limit of the GPU resource cache, mMaxResourceBytes unless it is adaptive.
+    size_t resourceCacheLimit() const;
+    void updateAdaptiveBudget();
     void checkUiHidden();
     void scheduleDestroyContext();
     void cancelDestroyContext();
 
 #ifdef __ANDROID__ // Layoutlib does not support hardware acceleration
     void reset(sk_sp<GrDirectContext> grContext);
+    void postShaderWarmup(std::shared_ptr<const std::vector<sk_sp<SkData>>> keys, size_t index);
 #endif
     void destroy();
 
@@ -95,6 +108,8 @@ private:
     size_t mMaxCpuFontCacheBytes = 0;
     size_t mBackgroundCpuFontCacheBytes = 0;
 
+    AdaptiveCacheBudget mAdaptiveBudget;
+
     std::vector<CanvasContext*> mCanvasContexts;
     RingBuffer<uint64_t, 100> mFrameCompletions;
 
@@ -481,6 +481,9 @@ void CanvasContext::prepareTree(TreeInfo& info, int64_t* uiFrameInfo, int64_t sy
     info.colorArea = &mColorArea;
     info.layerUpdateQueue = &mLayerUpdateQueue;
     info.damageGenerationId = mDamageId++;
+    info.parallelPrepare = Properties::parallelPrepareTree;
+    info.autoLayerBudget =
+            Properties::autoLayerCaching ? mRenderThread.cacheManager().getAutoLayerBudget() : 0;
     info.out.skippedFrameReason = std::nullopt;
 
     mAnimationContext->startFrame(info.mode);
@@ -489,6 +492,7 @@ void CanvasContext::prepareTree(TreeInfo& info, int64_t* uiFrameInfo, int64_t sy
         determineColors(target);
     }
 
+    const uint64_t preparedNodesStart = RenderNode::getPreparedNodeCount();
     for (const sp<RenderNode>& node : mRenderNodes) {
         // Only the primary target node will be drawn full - all other nodes would get drawn in
         // real time mode. In case of a window, the primary node is the window content and the other
@@ -497,6 +501,8 @@ void CanvasContext::prepareTree(TreeInfo& info, int64_t* uiFrameInfo, int64_t sy
         node->prepareTree(info);
         GL_CHECKPOINT(MODERATE);
     }
+    mFrameTimelineTracer.setPreparedNodes(RenderNode::getPreparedNodeCount() -
+                                          preparedNodesStart);
     mAnimationContext->runRemainingAnimations(info);
     GL_CHECKPOINT(MODERATE);
 
@@ -671,9 +677,12 @@ void CanvasContext::draw(bool solelyTextureViewUpdates) {
     {
         // FrameInfoVisualizer accesses the frame events, which cannot be mutated mid-draw
         // or it can lead to memory corruption.
+        mFrameTimelineTracer.beginDraw();
         drawResult = mRenderPipeline->draw(
                 frame, windowDirty, dirty, mLightGeometry, &mLayerUpdateQueue, mContentDrawBounds,
                 mOpaque, mLightInfo, mRenderNodes, &(profiler()), mBufferParams, profilerLock());
+        mFrameTimelineTracer.endDraw(
+                mCurrentFrameInfo->get(FrameInfoIndex::FrameTimelineVsyncId));
     }
 
     uint64_t frameCompleteNr = getFrameNumber();
@@ -809,6 +818,7 @@ void CanvasContext::draw(bool solelyTextureViewUpdates) {
             std::scoped_lock lock(mFrameInfoMutex);
             mJankTracker.finishFrame(*mCurrentFrameInfo, mFrameMetricsReporter, frameCompleteNr,
                                      mSurfaceControlGenerationId);
+            FrameTimelineTracer::traceFrame(*mCurrentFrameInfo, frameCompleteNr);
         }
     }
 
@@ -947,6 +957,7 @@ void CanvasContext::onSurfaceStatsAvailable(void* context, int32_t surfaceContro
                 gpuCompleteTime, frameInfo->get(FrameInfoIndex::CommandSubmissionCompleted));
         instance->mJankTracker.finishFrame(*frameInfo, instance->mFrameMetricsReporter, frameNumber,
                                            surfaceControlId);
+        FrameTimelineTracer::traceFrame(*frameInfo, frameNumber);
     }
 #endif
 }
@@ -1054,6 +1065,12 @@ void CanvasContext::destroyHardwareResources() {
     }
 }
 
+void CanvasContext::destroyAutoLayers() {
+    for (const sp<RenderNode>& node : mRenderNodes) {
+        node->destroyAutoLayers();
+    }
+}
+
 void CanvasContext::onContextDestroyed() {
     // We don't want to destroyHardwareResources as that will invalidate display lists which
     // the client may not be expecting. Instead just purge all scratch resources
@@ -1214,6 +1231,13 @@ void CanvasContext::setSyncDelayDuration(nsecs_t duration) {
     mSyncDelayDuration = duration;
 }
 
+void CanvasContext::markUiThreadUnblocked(nsecs_t syncWaitDuration) {
+    if (mCurrentFrameInfo) {
+        mCurrentFrameInfo->setSyncWaitDuration(syncWaitDuration);
+        mCurrentFrameInfo->markUiThreadUnblocked();
+    }
+}
+
 void CanvasContext::startHintSession() {
     mHintSessionWrapper->init();
 }
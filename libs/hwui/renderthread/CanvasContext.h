@@ -36,6 +36,7 @@
 #include "FrameInfo.h"
 #include "FrameInfoVisualizer.h"
 #include "FrameMetricsReporter.h"
+#include "FrameTimelineTracer.h"
 #include "HintSessionWrapper.h"
 #include "IContextFactory.h"
 #include "IRenderPipeline.h"
@@ -162,6 +163,7 @@ public:
     void markLayerInUse(RenderNode* node);
 
     void destroyHardwareResources();
+    void destroyAutoLayers();
     void onContextDestroyed() override;
 
     DeferredLayerUpdater* createTextureLayer();
@@ -243,6 +245,7 @@ public:
     void sendGpuLoadIncreaseHint();
 
     void setSyncDelayDuration(nsecs_t duration);
+    void markUiThreadUnblocked(nsecs_t syncWaitDuration);
 
     void startHintSession();
 
@@ -355,6 +358,7 @@ private:
 
     std::string mName;
     JankTracker mJankTracker;
+    FrameTimelineTracer mFrameTimelineTracer;
     FrameInfoVisualizer mProfiler;
     std::unique_ptr<FrameMetricsReporter> mFrameMetricsReporter GUARDED_BY(mFrameInfoMutex);
     std::mutex mFrameInfoMutex;
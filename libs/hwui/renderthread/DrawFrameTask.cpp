@@ -20,6 +20,7 @@
 #include <utils/Log.h>
 
 #include <algorithm>
+#include <cstring>
 
 #include "../DeferredLayerUpdater.h"
 #include "../DisplayList.h"
@@ -34,15 +35,16 @@ namespace uirenderer {
 namespace renderthread {
 
 DrawFrameTask::DrawFrameTask()
-        : mRenderThread(nullptr)
-        , mContext(nullptr)
-        , mContentDrawBounds(0, 0, 0, 0)
-        , mSyncResult(SyncResult::OK) {}
+        : mRenderThread(nullptr), mContext(nullptr), mSyncResult(SyncResult::OK) {
+    mUiState.contentDrawBounds.set(0, 0, 0, 0);
+}
 
 DrawFrameTask::~DrawFrameTask() {}
 
 void DrawFrameTask::setContext(RenderThread* thread, CanvasContext* context,
                                RenderNode* targetNode) {
+    // A pipelined frame may still be syncing with the previous context.
+    waitForPendingSync();
     mRenderThread = thread;
     mContext = context;
     mTargetNode = targetNode;
@@ -52,18 +54,20 @@ void DrawFrameTask::pushLayerUpdate(DeferredLayerUpdater* layer) {
     LOG_ALWAYS_FATAL_IF(!mContext,
                         "Lifecycle violation, there's no context to pushLayerUpdate with!");
 
-    for (size_t i = 0; i < mLayers.size(); i++) {
-        if (mLayers[i].get() == layer) {
+    auto& layers = mUiState.layers;
+    for (size_t i = 0; i < layers.size(); i++) {
+        if (layers[i].get() == layer) {
             return;
         }
     }
-    mLayers.push_back(layer);
+    layers.push_back(layer);
 }
 
 void DrawFrameTask::removeLayerUpdate(DeferredLayerUpdater* layer) {
-    for (size_t i = 0; i < mLayers.size(); i++) {
-        if (mLayers[i].get() == layer) {
-            mLayers.erase(mLayers.begin() + i);
+    auto& layers = mUiState.layers;
+    for (size_t i = 0; i < layers.size(); i++) {
+        if (layers[i].get() == layer) {
+            layers.erase(layers.begin() + i);
             return;
         }
     }
@@ -72,28 +76,87 @@ void DrawFrameTask::removeLayerUpdate(DeferredLayerUpdater* layer) {
 int DrawFrameTask::drawFrame() {
     LOG_ALWAYS_FATAL_IF(!mContext, "Cannot drawFrame with no CanvasContext!");
 
+    if (!mPipelined) {
+        // The previous frame may have been pipelined if the mode was just switched off.
+        int pendingSyncResult = waitForPendingSync();
+        queueFrameState();
+        mSyncWaitDuration = 0;
+        postAndWait();
+        return mSyncResult | pendingSyncResult;
+    }
+
+    // Only a single frame may be in flight, so this waits for the previous one to sync. That
+    // usually happened already while the UI thread recorded this frame.
+    nsecs_t waitStart = systemTime(SYSTEM_TIME_MONOTONIC);
+    int syncResult = waitForPendingSync();
+    mSyncWaitDuration = systemTime(SYSTEM_TIME_MONOTONIC) - waitStart;
+    queueFrameState();
+
+    AutoMutex _lock(mLock);
+    mSyncInFlight = true;
+    mHasPendingSyncResult = true;
+    mRenderThread->queue().post([this]() { run(); });
+    return syncResult;
+}
+
+int DrawFrameTask::waitForPendingSync() {
+    AutoMutex _lock(mLock);
+    if (mSyncInFlight) {
+        ATRACE_NAME("waitForPendingSync");
+        while (mSyncInFlight) {
+            mSignal.wait(mLock);
+        }
+    }
+    if (!mHasPendingSyncResult) {
+        return SyncResult::OK;
+    }
+    mHasPendingSyncResult = false;
+    return mSyncResult;
+}
+
+// Hands the frame the UI thread has filled in over to the RenderThread. Must only be called while
+// no sync is in flight.
+void DrawFrameTask::queueFrameState() {
     mSyncResult = SyncResult::OK;
     mSyncQueued = systemTime(SYSTEM_TIME_MONOTONIC);
-    postAndWait();
 
-    return mSyncResult;
+    mSyncState.contentDrawBounds = mUiState.contentDrawBounds;
+    mSyncState.renderSdrHdrRatio = mUiState.renderSdrHdrRatio;
+    mSyncState.hardwareBufferParams = mUiState.hardwareBufferParams;
+    memcpy(mSyncState.frameInfo, mUiState.frameInfo, sizeof(mUiState.frameInfo));
+
+    // The rest only applies to a single frame.
+    mSyncState.layers = std::move(mUiState.layers);
+    mUiState.layers.clear();
+    mSyncState.frameCallback = std::move(mUiState.frameCallback);
+    mUiState.frameCallback = nullptr;
+    mSyncState.frameCommitCallback = std::move(mUiState.frameCommitCallback);
+    mUiState.frameCommitCallback = nullptr;
+    mSyncState.frameCompleteCallback = std::move(mUiState.frameCompleteCallback);
+    mUiState.frameCompleteCallback = nullptr;
+    mSyncState.forceDrawFrame = mUiState.forceDrawFrame;
+    mUiState.forceDrawFrame = false;
 }
 
 void DrawFrameTask::postAndWait() {
     ATRACE_CALL();
     AutoMutex _lock(mLock);
+    mSyncInFlight = true;
     mRenderThread->queue().post([this]() { run(); });
-    mSignal.wait(mLock);
+    while (mSyncInFlight) {
+        mSignal.wait(mLock);
+    }
 }
 
 void DrawFrameTask::run() {
-    const int64_t vsyncId = mFrameInfo[static_cast<int>(FrameInfoIndex::FrameTimelineVsyncId)];
+    const int64_t vsyncId =
+            mSyncState.frameInfo[static_cast<int>(FrameInfoIndex::FrameTimelineVsyncId)];
     ATRACE_FORMAT("DrawFrames %" PRId64, vsyncId);
 
     mContext->setSyncDelayDuration(systemTime(SYSTEM_TIME_MONOTONIC) - mSyncQueued);
-    mContext->setTargetSdrHdrRatio(mRenderSdrHdrRatio);
+    mContext->setTargetSdrHdrRatio(mSyncState.renderSdrHdrRatio);
 
-    auto hardwareBufferParams = mHardwareBufferParams;
+    auto hardwareBufferParams = mSyncState.hardwareBufferParams;
     mContext->setHardwareBufferRenderParams(hardwareBufferParams);
     IRenderPipeline* pipeline = mContext->getRenderPipeline();
     bool canUnblockUiThread;
@@ -101,34 +164,36 @@ void DrawFrameTask::run() {
     bool solelyTextureViewUpdates;
     {
         TreeInfo info(TreeInfo::MODE_FULL, *mContext);
-        info.forceDrawFrame = mForceDrawFrame;
-        mForceDrawFrame = false;
+        info.forceDrawFrame = mSyncState.forceDrawFrame;
         canUnblockUiThread = syncFrameState(info);
         canDrawThisFrame = !info.out.skippedFrameReason.has_value();
         solelyTextureViewUpdates = info.out.solelyTextureViewUpdates;
 
-        if (mFrameCommitCallback) {
-            mContext->addFrameCommitListener(std::move(mFrameCommitCallback));
-            mFrameCommitCallback = nullptr;
+        if (mSyncState.frameCommitCallback) {
+            mContext->addFrameCommitListener(std::move(mSyncState.frameCommitCallback));
+            mSyncState.frameCommitCallback = nullptr;
         }
     }
 
     // Grab a copy of everything we need
     CanvasContext* context = mContext;
     std::function<std::function<void(bool)>(int32_t, int64_t)> frameCallback =
-            std::move(mFrameCallback);
-    std::function<void()> frameCompleteCallback = std::move(mFrameCompleteCallback);
-    mFrameCallback = nullptr;
-    mFrameCompleteCallback = nullptr;
+            std::move(mSyncState.frameCallback);
+    std::function<void()> frameCompleteCallback = std::move(mSyncState.frameCompleteCallback);
+    mSyncState.frameCallback = nullptr;
+    mSyncState.frameCompleteCallback = nullptr;
+    const int syncResult = mSyncResult;
+    const nsecs_t syncWaitDuration = mSyncWaitDuration;
 
     // From this point on anything in "this" is *UNSAFE TO ACCESS*
     if (canUnblockUiThread) {
+        context->markUiThreadUnblocked(syncWaitDuration);
         unblockUiThread();
     }
 
     // Even if we aren't drawing this vsync pulse the next frame number will still be accurate
     if (CC_UNLIKELY(frameCallback)) {
-        context->enqueueFrameWork([frameCallback, context, syncResult = mSyncResult,
+        context->enqueueFrameWork([frameCallback, context, syncResult,
                                    frameNr = context->getFrameNumber()]() {
             auto frameCommitCallback = frameCallback(syncResult, frameNr);
             if (frameCommitCallback) {
@@ -157,6 +222,7 @@ void DrawFrameTask::run() {
     }
 
     if (!canUnblockUiThread) {
+        context->markUiThreadUnblocked(syncWaitDuration);
         unblockUiThread();
     }
 
@@ -168,27 +234,28 @@ void DrawFrameTask::run() {
 
 bool DrawFrameTask::syncFrameState(TreeInfo& info) {
     ATRACE_CALL();
-    int64_t vsync = mFrameInfo[static_cast<int>(FrameInfoIndex::Vsync)];
-    int64_t intendedVsync = mFrameInfo[static_cast<int>(FrameInfoIndex::IntendedVsync)];
-    int64_t vsyncId = mFrameInfo[static_cast<int>(FrameInfoIndex::FrameTimelineVsyncId)];
-    int64_t frameDeadline = mFrameInfo[static_cast<int>(FrameInfoIndex::FrameDeadline)];
-    int64_t frameInterval = mFrameInfo[static_cast<int>(FrameInfoIndex::FrameInterval)];
+    const int64_t* frameInfo = mSyncState.frameInfo;
+    int64_t vsync = frameInfo[static_cast<int>(FrameInfoIndex::Vsync)];
+    int64_t intendedVsync = frameInfo[static_cast<int>(FrameInfoIndex::IntendedVsync)];
+    int64_t vsyncId = frameInfo[static_cast<int>(FrameInfoIndex::FrameTimelineVsyncId)];
+    int64_t frameDeadline = frameInfo[static_cast<int>(FrameInfoIndex::FrameDeadline)];
+    int64_t frameInterval = frameInfo[static_cast<int>(FrameInfoIndex::FrameInterval)];
     mRenderThread->timeLord().vsyncReceived(vsync, intendedVsync, vsyncId, frameDeadline,
             frameInterval);
     bool canDraw = mContext->makeCurrent();
     mContext->unpinImages();
 
 #ifdef __ANDROID__
-    for (size_t i = 0; i < mLayers.size(); i++) {
-        if (mLayers[i]) {
-            mLayers[i]->apply();
+    for (size_t i = 0; i < mSyncState.layers.size(); i++) {
+        if (mSyncState.layers[i]) {
+            mSyncState.layers[i]->apply();
         }
     }
 #endif
 
-    mLayers.clear();
-    mContext->setContentDrawBounds(mContentDrawBounds);
-    mContext->prepareTree(info, mFrameInfo, mSyncQueued, mTargetNode);
+    mSyncState.layers.clear();
+    mContext->setContentDrawBounds(mSyncState.contentDrawBounds);
+    mContext->prepareTree(info, frameInfo, mSyncQueued, mTargetNode);
 
     // This is after the prepareTree so that any pending operations
     // (RenderNode tree state, prefetched layers, etc...) will be flushed.
@@ -218,6 +285,7 @@ bool DrawFrameTask::syncFrameState(TreeInfo& info) {
 
 void DrawFrameTask::unblockUiThread() {
     AutoMutex _lock(mLock);
+    mSyncInFlight = false;
     mSignal.signal();
 }
 
@@ -62,6 +62,11 @@ enum {
  * and contains state (such as layer updaters & new DisplayLists) that is
  * tracked across many frames not just a single frame.
  * It is the sync-state task, and will kick off the post-sync draw
+ *
+ * In pipelined mode drawFrame() returns as soon as the frame is queued instead
+ * of waiting for the RenderThread to sync it, so the UI thread can go on while
+ * the RenderThread is still drawing the previous frame. The UI thread then has
+ * to call waitForPendingSync() before it touches any RenderNode again.
  */
 class DrawFrameTask {
 public:
@@ -70,7 +75,7 @@ public:
 
     void setContext(RenderThread* thread, CanvasContext* context, RenderNode* targetNode);
     void setContentDrawBounds(int left, int top, int right, int bottom) {
-        mContentDrawBounds.set(left, top, right, bottom);
+        mUiState.contentDrawBounds.set(left, top, right, bottom);
     }
 
     void pushLayerUpdate(DeferredLayerUpdater* layer);
@@ -78,60 +83,82 @@ public:
 
     int drawFrame();
 
-    int64_t* frameInfo() { return mFrameInfo; }
+    void setPipelined(bool pipelined) { mPipelined = pipelined; }
+
+    // Blocks until the RenderThread synced the frame queued by the last pipelined drawFrame().
+    // Returns the SyncResult of that frame, or SyncResult::OK if it was returned already.
+    int waitForPendingSync();
+
+    int64_t* frameInfo() { return mUiState.frameInfo; }
 
     void run();
 
     void setFrameCallback(std::function<std::function<void(bool)>(int32_t, int64_t)>&& callback) {
-        mFrameCallback = std::move(callback);
+        mUiState.frameCallback = std::move(callback);
     }
 
     void setFrameCommitCallback(std::function<void(bool)>&& callback) {
-        mFrameCommitCallback = std::move(callback);
+        mUiState.frameCommitCallback = std::move(callback);
     }
 
     void setFrameCompleteCallback(std::function<void()>&& callback) {
-        mFrameCompleteCallback = std::move(callback);
+        mUiState.frameCompleteCallback = std::move(callback);
     }
 
-    void forceDrawNextFrame() { mForceDrawFrame = true; }
+    void forceDrawNextFrame() { mUiState.forceDrawFrame = true; }
 
     void setHardwareBufferRenderParams(const HardwareBufferRenderParams& params) {
-        mHardwareBufferParams = params;
+        mUiState.hardwareBufferParams = params;
     }
 
-    void setRenderSdrHdrRatio(float ratio) { mRenderSdrHdrRatio = ratio; }
+    void setRenderSdrHdrRatio(float ratio) { mUiState.renderSdrHdrRatio = ratio; }
 
 private:
+    /*********************************************
+     *  Single frame data
+     *********************************************/
+    struct FrameState {
+        Rect contentDrawBounds;
+        float renderSdrHdrRatio = 1.f;
+
+        std::vector<sp<DeferredLayerUpdater> > layers;
+
+        int64_t frameInfo[UI_THREAD_FRAME_INFO_SIZE];
+
+        HardwareBufferRenderParams hardwareBufferParams;
+        std::function<std::function<void(bool)>(int32_t, int64_t)> frameCallback;
+        std::function<void(bool)> frameCommitCallback;
+        std::function<void()> frameCompleteCallback;
+
+        bool forceDrawFrame = false;
+    };
+
+    void queueFrameState();
     void postAndWait();
     bool syncFrameState(TreeInfo& info);
     void unblockUiThread();
 
     Mutex mLock;
     Condition mSignal;
+    // Set from when a frame is posted until the RenderThread unblocks the UI thread.
+    bool mSyncInFlight = false;
+    // Set while the SyncResult of a pipelined frame hasn't been returned to the UI thread.
+    bool mHasPendingSyncResult = false;
+    bool mPipelined = false;
 
     RenderThread* mRenderThread;
     CanvasContext* mContext;
     RenderNode* mTargetNode = nullptr;
-    Rect mContentDrawBounds;
-    float mRenderSdrHdrRatio = 1.f;
 
-    /*********************************************
-     *  Single frame data
-     *********************************************/
-    std::vector<sp<DeferredLayerUpdater> > mLayers;
+    // Filled in by the UI thread for the next frame.
+    FrameState mUiState;
+    // The frame that the RenderThread syncs. It's only written while no sync is in flight, which
+    // lets the UI thread fill in mUiState while the RenderThread syncs.
+    FrameState mSyncState;
 
     int mSyncResult;
     int64_t mSyncQueued;
-
-    int64_t mFrameInfo[UI_THREAD_FRAME_INFO_SIZE];
-
-    HardwareBufferRenderParams mHardwareBufferParams;
-    std::function<std::function<void(bool)>(int32_t, int64_t)> mFrameCallback;
-    std::function<void(bool)> mFrameCommitCallback;
-    std::function<void()> mFrameCompleteCallback;
-
-    bool mForceDrawFrame = false;
+    nsecs_t mSyncWaitDuration = 0;
 };
 
 } /* namespace renderthread */
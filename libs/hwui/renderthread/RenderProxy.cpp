@@ -183,6 +183,14 @@ int RenderProxy::syncAndDrawFrame() {
     return mDrawFrameTask.drawFrame();
 }
 
+void RenderProxy::setPipelinedDrawFrame(bool pipelined) {
+    mDrawFrameTask.setPipelined(pipelined);
+}
+
+int RenderProxy::waitForPendingSync() {
+    return mDrawFrameTask.waitForPendingSync();
+}
+
 void RenderProxy::destroy() {
     // destroyCanvasAndSurface() needs a fence as when it returns the
     // underlying BufferQueue is going to be released from under
@@ -93,6 +93,12 @@ public:
     int64_t* frameInfo();
     void forceDrawNextFrame();
     int syncAndDrawFrame();
+    // In pipelined mode syncAndDrawFrame() doesn't wait for the RenderThread to sync the frame,
+    // it returns the SyncResult of the previous frame instead. Before changing any RenderNode
+    // again, the UI thread must call waitForPendingSync(), which returns the SyncResult of the
+    // frame it waited for.
+    void setPipelinedDrawFrame(bool pipelined);
+    int waitForPendingSync();
     void destroy();
 
     static void destroyFunctor(int functor);
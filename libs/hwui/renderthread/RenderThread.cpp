@@ -42,6 +42,7 @@
 #include "RenderProxy.h"
 #include "VulkanManager.h"
 #include "hwui/Bitmap.h"
+#include "pipeline/skia/ShaderCache.h"
 #include "pipeline/skia/SkiaOpenGLPipeline.h"
 #include "pipeline/skia/SkiaVulkanPipeline.h"
 #include "renderstate/RenderState.h"
@@ -302,6 +303,11 @@ void RenderThread::dumpGraphicsMemory(int fd, bool includeProfileData) {
     String8 cachesOutput;
     mCacheManager->dumpMemoryUsage(cachesOutput, mRenderState);
     dprintf(fd, "\nPipeline=%s\n%s", pipelineToString(), cachesOutput.c_str());
+    if (Properties::stagedPreload) {
+        dprintf(fd, "Preload: driver %.2fms, disk cache %.2fms, context %.2fms\n",
+                mPreloadTimings.driver / 1000000.0, mPreloadTimings.diskCache / 1000000.0,
+                mPreloadTimings.context / 1000000.0);
+    }
     for (auto&& context : mCacheManager->mCanvasContexts) {
         context->visitAllRenderNodes([&](const RenderNode& node) {
             if (node.isTextureView()) {
@@ -457,15 +463,72 @@ bool RenderThread::isCurrent() {
     return gettid() == getInstance().getTid();
 }
 
+void RenderThread::preloadStaged() {
+    const bool useGl = Properties::getRenderPipelineType() == RenderPipelineType::SkiaGL;
+    // The driver and the disk cache are loaded on a thread of their own, as they don't need the
+    // RenderThread. Only the context is created on the RenderThread, which draws the first frame
+    // right away if it comes first: the driver then finishes initializing on the RenderThread.
+    std::thread([this, useGl] {
+        setpriority(PRIO_PROCESS, 0, PRIORITY_BACKGROUND);
+        pthread_setname_np(pthread_self(), "hwuiPreload");
+
+        nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        EGLDisplay display = EGL_NO_DISPLAY;
+        {
+            ATRACE_NAME("preloadDriver");
+            if (useGl) {
+                display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+                if (display != EGL_NO_DISPLAY &&
+                    eglInitialize(display, nullptr, nullptr) == EGL_FALSE) {
+                    display = EGL_NO_DISPLAY;
+                }
+                eglReleaseThread();
+            } else {
+                mVkManager->initialize();
+            }
+        }
+        nsecs_t end = systemTime(SYSTEM_TIME_MONOTONIC);
+        mPreloadTimings.driver = end - start;
+
+        start = end;
+        skiapipeline::ShaderCache::get().prefetchDiskCache();
+        end = systemTime(SYSTEM_TIME_MONOTONIC);
+        mPreloadTimings.diskCache = end - start;
+
+        queue().post([this, useGl, display] {
+            ATRACE_NAME("preloadContext");
+            const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+            if (useGl) {
+                requireGlContext();
+                // libEGL counts the initializations of a display, the EglManager holds its own.
+                if (display != EGL_NO_DISPLAY) {
+                    eglTerminate(display);
+                }
+            } else {
+                requireVkContext();
+            }
+            cacheManager().warmupShaderCache();
+            mPreloadTimings.context = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+        });
+    }).detach();
+}
+
 void RenderThread::preload() {
+    if (Properties::stagedPreload) {
+        preloadStaged();
+        HardwareBitmapUploader::initialize();
+        return;
+    }
     // EGL driver is always preloaded only if HWUI renders with GL.
     if (Properties::getRenderPipelineType() == RenderPipelineType::SkiaGL) {
         queue().post([this]() {
             ATRACE_NAME("earlyPreloadGlContext");
             requireGlContext();
+            cacheManager().warmupShaderCache();
         });
     } else {
         requireVkContext();
+        cacheManager().warmupShaderCache();
     }
     HardwareBitmapUploader::initialize();
 }
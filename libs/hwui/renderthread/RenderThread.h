@@ -23,6 +23,7 @@
 #include <surface_control_private.h>
 #include <utils/Thread.h>
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -123,6 +124,16 @@ public:
 
     void preload();
 
+    /**
+     * The durations of the stages of the staged preload, see PROPERTY_STAGED_PRELOAD. Each is 0
+     * until its stage completes.
+     */
+    struct PreloadTimings {
+        std::atomic<nsecs_t> driver = 0;
+        std::atomic<nsecs_t> diskCache = 0;
+        std::atomic<nsecs_t> context = 0;
+    };
+
     void trimMemory(TrimLevel level);
     void trimCaches(CacheTrimLevel level);
 
@@ -160,6 +171,8 @@ private:
     void initThreadLocals();
     void initializeChoreographer();
     void setupFrameInterval();
+    // Loads the driver and the shader disk cache in the background, then creates the context.
+    void preloadStaged();
     // Callbacks for choreographer events:
     // choreographerCallback will call AChoreograper_handleEvent to call the
     // corresponding callbacks for each display event type
@@ -195,6 +208,7 @@ private:
 
     sk_sp<GrDirectContext> mGrContext;
     CacheManager* mCacheManager;
+    PreloadTimings mPreloadTimings;
     sp<VulkanManager> mVkManager;
 
     std::mutex mJankDataMutex;
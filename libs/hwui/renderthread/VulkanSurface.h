@@ -71,6 +71,8 @@ private:
 
     NativeBufferInfo* dequeueNativeBuffer();
     NativeBufferInfo* getCurrentBufferInfo() { return mCurrentBufferInfo; }
+    // Queues the current buffer with dirtyRect as its surface damage, which is what
+    // VK_KHR_incremental_present maps to for a swapchain. An empty dirtyRect damages all of it.
     bool presentCurrentBuffer(const SkRect& dirtyRect, int semaphoreFd);
 
     // The width and height are are the logical width and height for when submitting draws to the
@@ -78,6 +80,8 @@ private:
     // height swapped.
     int logicalWidth() const { return mWindowInfo.size.width(); }
     int logicalHeight() const { return mWindowInfo.size.height(); }
+    // The number of frames since the current buffer was last presented, as EGL_EXT_buffer_age,
+    // or 0 if its contents are undefined.
     int getCurrentBuffersAge();
 
 private:
@@ -19,7 +19,9 @@
 #include <android/util/ProtoOutputStream.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
 #include <inttypes.h>
 #include <log/log.h>
 #include <stats_annotations.h>
@@ -384,6 +386,10 @@ public:
     protos::GraphicsStatsServiceDumpProto& proto() { return mProto; }
     void mergeStat(const protos::GraphicsStatsProto& stat);
     void updateProto();
+    // Streams stat to the dump fd as one more entry of the repeated stats field. Concatenated
+    // entries parse as a single GraphicsStatsServiceDumpProto, so the dump never has to hold the
+    // stats of every package at once.
+    void writeStat(const protos::GraphicsStatsProto& stat);
 
 private:
     // use package name and app version for a key
@@ -432,6 +438,22 @@ void GraphicsStatsService::Dump::mergeStat(const protos::GraphicsStatsProto& sta
     }
 }
 
+void GraphicsStatsService::Dump::writeStat(const protos::GraphicsStatsProto& stat) {
+    FileOutputStreamLite stream(mFd);
+    {
+        io::CodedOutputStream output(&stream);
+        output.WriteTag(internal::WireFormatLite::MakeTag(
+                protos::GraphicsStatsServiceDumpProto::kStatsFieldNumber,
+                internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+        output.WriteVarint32(static_cast<uint32_t>(stat.ByteSizeLong()));
+        stat.SerializeWithCachedSizes(&output);
+    }
+    if (!stream.Flush() || stream.GetErrno() != 0) {
+        ALOGW("Error writing stats of '%s' to fd=%d err=%d (%s)", stat.package_name().c_str(), mFd,
+              stream.GetErrno(), strerror(stream.GetErrno()));
+    }
+}
+
 void GraphicsStatsService::Dump::updateProto() {
     for (auto& stat : mStats) {
         mProto.add_stats()->CopyFrom(stat.second);
@@ -461,7 +483,7 @@ void GraphicsStatsService::addToDump(Dump* dump, const std::string& path, uid_t
     if (dump->type() == DumpType::ProtobufStatsd) {
         dump->mergeStat(statsProto);
     } else if (dump->type() == DumpType::Protobuf) {
-        dump->proto().add_stats()->CopyFrom(statsProto);
+        dump->writeStat(statsProto);
     } else {
         dumpAsTextToFd(&statsProto, dump->fd());
     }
@@ -475,17 +497,14 @@ void GraphicsStatsService::addToDump(Dump* dump, const std::string& path) {
     if (dump->type() == DumpType::ProtobufStatsd) {
         dump->mergeStat(statsProto);
     } else if (dump->type() == DumpType::Protobuf) {
-        dump->proto().add_stats()->CopyFrom(statsProto);
+        dump->writeStat(statsProto);
     } else {
         dumpAsTextToFd(&statsProto, dump->fd());
     }
 }
 
 void GraphicsStatsService::finishDump(Dump* dump) {
-    if (dump->type() == DumpType::Protobuf) {
-        FileOutputStreamLite stream(dump->fd());
-        dump->proto().SerializeToZeroCopyStream(&stream);
-    }
+    // Protobuf dumps are streamed by addToDump()
     delete dump;
 }
 
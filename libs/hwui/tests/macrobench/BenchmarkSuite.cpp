@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BenchmarkSuite.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <sstream>
+
+namespace android {
+namespace uirenderer {
+namespace test {
+
+namespace {
+
+struct Stage {
+    const char* name;
+    FrameInfoIndex start;
+    FrameInfoIndex end;
+};
+
+// The stages of a frame, mostly as in the profile bars. The UI thread of hwuimacro doesn't handle
+// input nor run animations, so its whole frame is one stage.
+constexpr std::array<Stage, 6> kStages{{
+        {"ui_thread", FrameInfoIndex::IntendedVsync, FrameInfoIndex::SyncQueued},
+        {"sync_queued", FrameInfoIndex::SyncQueued, FrameInfoIndex::SyncStart},
+        {"sync", FrameInfoIndex::SyncStart, FrameInfoIndex::IssueDrawCommandsStart},
+        {"issue_draw_commands", FrameInfoIndex::IssueDrawCommandsStart,
+         FrameInfoIndex::SwapBuffers},
+        {"swap_buffers", FrameInfoIndex::SwapBuffers, FrameInfoIndex::SwapBuffersCompleted},
+        {"total", FrameInfoIndex::IntendedVsync, FrameInfoIndex::FrameCompleted},
+}};
+
+// Stages that are recorded as durations rather than timestamps.
+constexpr std::array<std::pair<const char*, FrameInfoIndex>, 2> kDurations{{
+        {"dequeue_buffer", FrameInfoIndex::DequeueBufferDuration},
+        {"queue_buffer", FrameInfoIndex::QueueBufferDuration},
+}};
+
+constexpr std::array<std::pair<const char*, int>, 4> kPercentiles{{
+        {"p50", 50},
+        {"p90", 90},
+        {"p95", 95},
+        {"p99", 99},
+}};
+
+// The percentiles that are gated against the baseline. The higher ones are too noisy over a
+// few hundred frames.
+constexpr std::array<const char*, 2> kGatedPercentiles{{"p50", "p90"}};
+
+int64_t get(const FrameInfoBuffer& frame, FrameInfoIndex index) {
+    return frame[static_cast<int>(index)];
+}
+
+// Mirrors FrameInfo::duration(), the time a frame spent stalled before its sync started is
+// accounted to the previous frame.
+int64_t duration(const FrameInfoBuffer& frame, FrameInfoIndex start, FrameInfoIndex end) {
+    const int64_t startTime = get(frame, start);
+    if (startTime <= 0) {
+        return 0;
+    }
+    int64_t gap = get(frame, end) - startTime;
+    if (end > FrameInfoIndex::SyncQueued && start < FrameInfoIndex::SyncQueued) {
+        const int64_t stall =
+                get(frame, FrameInfoIndex::SyncStart) - get(frame, FrameInfoIndex::SyncQueued);
+        if (stall > 0) {
+            gap -= stall;
+        }
+    }
+    return std::max<int64_t>(gap, 0);
+}
+
+Json::Value percentiles(std::vector<int64_t> values) {
+    Json::Value result(Json::objectValue);
+    if (values.empty()) {
+        return result;
+    }
+    std::sort(values.begin(), values.end());
+    for (const auto& [name, percentile] : kPercentiles) {
+        // Nearest rank.
+        const size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * values.size()));
+        result[name] = Json::Int64(values[std::max<size_t>(rank, 1) - 1]);
+    }
+    result["max"] = Json::Int64(values.back());
+    return result;
+}
+
+std::string resultKey(const Json::Value& result) {
+    return result["scene"].asString() + " (" + result["renderer"].asString() + ")";
+}
+
+bool isRegression(int64_t value, int64_t baseline, float thresholdPercent, int64_t minRegression) {
+    return value - baseline > minRegression &&
+           value > baseline * (1.0 + thresholdPercent / 100.0);
+}
+
+}  // namespace
+
+void FrameStatsCollector::notify(const FrameInfoBuffer& buffer) {
+    std::lock_guard lock(mLock);
+    mFrames.push_back(buffer);
+}
+
+void FrameStatsCollector::setMemoryUsage(size_t cpuBytes, size_t gpuBytes) {
+    mCpuBytes = cpuBytes;
+    mGpuBytes = gpuBytes;
+}
+
+std::vector<FrameInfoBuffer> FrameStatsCollector::frames() const {
+    std::lock_guard lock(mLock);
+    return mFrames;
+}
+
+Json::Value BenchmarkSuite::makeResult(const std::string& scene, const std::string& renderer,
+                                       const FrameStatsCollector& stats) {
+    const std::vector<FrameInfoBuffer> frames = stats.frames();
+    Json::Value result(Json::objectValue);
+    result["scene"] = scene;
+    result["renderer"] = renderer;
+    result["frames"] = Json::UInt64(frames.size());
+
+    Json::Value& stages = result["stages"] = Json::Value(Json::objectValue);
+    std::vector<int64_t> values;
+    values.reserve(frames.size());
+    for (const Stage& stage : kStages) {
+        values.clear();
+        for (const FrameInfoBuffer& frame : frames) {
+            values.push_back(duration(frame, stage.start, stage.end));
+        }
+        stages[stage.name] = percentiles(values);
+    }
+    for (const auto& [name, index] : kDurations) {
+        values.clear();
+        for (const FrameInfoBuffer& frame : frames) {
+            values.push_back(std::max<int64_t>(get(frame, index), 0));
+        }
+        stages[name] = percentiles(values);
+    }
+    // As FrameInfo::gpuDrawTime(), the GPU work is assumed to start at swap. Frames for which the
+    // GPU completion isn't known are left out.
+    values.clear();
+    for (const FrameInfoBuffer& frame : frames) {
+        const int64_t gpuCompleted = get(frame, FrameInfoIndex::GpuCompleted);
+        if (gpuCompleted > 0) {
+            values.push_back(std::max<int64_t>(
+                    gpuCompleted - get(frame, FrameInfoIndex::SwapBuffers), 0));
+        }
+    }
+    stages["gpu"] = percentiles(values);
+
+    Json::Value& memory = result["memory"] = Json::Value(Json::objectValue);
+    memory["cpu_bytes"] = Json::UInt64(stats.cpuBytes());
+    memory["gpu_bytes"] = Json::UInt64(stats.gpuBytes());
+    return result;
+}
+
+Json::Value BenchmarkSuite::makeReport(const Json::Value& results, int frameCount) {
+    Json::Value report(Json::objectValue);
+    report["version"] = kVersion;
+    report["frame_count"] = frameCount;
+    report["results"] = results;
+    return report;
+}
+
+int BenchmarkSuite::compareToBaseline(const Json::Value& report, const Json::Value& baseline,
+                                      float thresholdPercent, FILE* log) {
+    if (baseline["version"].asInt() != kVersion) {
+        // Fails the run rather than letting it pass unchecked.
+        fprintf(log, "Baseline version %d doesn't match %d, it must be recorded again\n",
+                baseline["version"].asInt(), kVersion);
+        return 1;
+    }
+    if (baseline["frame_count"].asInt() != report["frame_count"].asInt()) {
+        fprintf(log, "Warning: the baseline was recorded over %d frames, not %d\n",
+                baseline["frame_count"].asInt(), report["frame_count"].asInt());
+    }
+
+    std::map<std::string, const Json::Value*> baselineResults;
+    for (const Json::Value& result : baseline["results"]) {
+        baselineResults[resultKey(result)] = &result;
+    }
+
+    int regressions = 0;
+    for (const Json::Value& result : report["results"]) {
+        const std::string key = resultKey(result);
+        auto found = baselineResults.find(key);
+        if (found == baselineResults.end()) {
+            fprintf(log, "%s: not in the baseline\n", key.c_str());
+            continue;
+        }
+        const Json::Value& expected = *found->second;
+        baselineResults.erase(found);
+
+        for (const std::string& stage : result["stages"].getMemberNames()) {
+            const Json::Value& expectedStage = expected["stages"][stage];
+            for (const char* percentile : kGatedPercentiles) {
+                if (!expectedStage.isMember(percentile)) {
+                    continue;
+                }
+                const int64_t value = result["stages"][stage][percentile].asInt64();
+                const int64_t expectedValue = expectedStage[percentile].asInt64();
+                if (isRegression(value, expectedValue, thresholdPercent,
+                                 kMinStageRegressionNs)) {
+                    fprintf(log, "%s: %s %s regressed from %.3fms to %.3fms\n", key.c_str(),
+                            stage.c_str(), percentile, expectedValue / 1000000.0,
+                            value / 1000000.0);
+                    regressions++;
+                }
+            }
+        }
+
+        const int64_t memory = result["memory"]["cpu_bytes"].asInt64() +
+                               result["memory"]["gpu_bytes"].asInt64();
+        const int64_t expectedMemory = expected["memory"]["cpu_bytes"].asInt64() +
+                                       expected["memory"]["gpu_bytes"].asInt64();
+        if (isRegression(memory, expectedMemory, thresholdPercent, kMinMemoryRegressionBytes)) {
+            fprintf(log, "%s: memory regressed from %.2fMB to %.2fMB\n", key.c_str(),
+                    expectedMemory / 1000000.0, memory / 1000000.0);
+            regressions++;
+        }
+    }
+    for (const auto& [key, result] : baselineResults) {
+        fprintf(log, "%s: in the baseline but didn't run\n", key.c_str());
+    }
+    return regressions;
+}
+
+std::string BenchmarkSuite::toString(const Json::Value& value) {
+    Json::StreamWriterBuilder builder;
+    builder["indentation"] = "  ";
+    std::ostringstream stream;
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    writer->write(value, &stream);
+    stream << '\n';
+    return stream.str();
+}
+
+bool BenchmarkSuite::parse(const std::string& json, Json::Value* value, std::string* errors) {
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    return reader->parse(json.data(), json.data() + json.size(), value, errors);
+}
+
+}  // namespace test
+}  // namespace uirenderer
+}  // namespace android
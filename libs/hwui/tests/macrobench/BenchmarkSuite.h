@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <json/json.h>
+#include <stdio.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "FrameInfo.h"
+#include "FrameMetricsObserver.h"
+
+namespace android {
+namespace uirenderer {
+namespace test {
+
+/**
+ * Keeps the FrameInfo of every frame drawn while it is attached to a RenderProxy, along with the
+ * memory used by the caches once the scene is done.
+ */
+class FrameStatsCollector : public FrameMetricsObserver {
+public:
+    FrameStatsCollector() : FrameMetricsObserver(false /* waitForPresentTime */) {}
+
+    void notify(const FrameInfoBuffer& buffer) override;
+
+    void setMemoryUsage(size_t cpuBytes, size_t gpuBytes);
+
+    std::vector<FrameInfoBuffer> frames() const;
+    size_t cpuBytes() const { return mCpuBytes; }
+    size_t gpuBytes() const { return mGpuBytes; }
+
+private:
+    mutable std::mutex mLock;
+    std::vector<FrameInfoBuffer> mFrames;
+    size_t mCpuBytes = 0;
+    size_t mGpuBytes = 0;
+};
+
+/**
+ * The machine-readable side of hwuimacro --suite.
+ *
+ * A report holds one result per scene and render pipeline, with the percentiles of the duration
+ * of each stage of the frames in nanoseconds, and the memory used by the caches in bytes. A report
+ * saved from a known good build serves as the baseline of the next runs: a stage percentile or
+ * the memory usage that grows by more than the threshold over the baseline is a regression.
+ */
+class BenchmarkSuite {
+public:
+    static constexpr int kVersion = 1;
+
+    // Stage regressions smaller than this are noise, whatever the threshold.
+    static constexpr int64_t kMinStageRegressionNs = 100000;
+    // Same for the memory usage.
+    static constexpr int64_t kMinMemoryRegressionBytes = 1024 * 1024;
+
+    static Json::Value makeResult(const std::string& scene, const std::string& renderer,
+                                  const FrameStatsCollector& stats);
+
+    static Json::Value makeReport(const Json::Value& results, int frameCount);
+
+    /**
+     * Compares the results of report to the ones of baseline, and logs every regression by more
+     * than thresholdPercent. Returns the number of regressions.
+     */
+    static int compareToBaseline(const Json::Value& report, const Json::Value& baseline,
+                                 float thresholdPercent, FILE* log);
+
+    static std::string toString(const Json::Value& value);
+    static bool parse(const std::string& json, Json::Value* value, std::string* errors);
+};
+
+}  // namespace test
+}  // namespace uirenderer
+}  // namespace android
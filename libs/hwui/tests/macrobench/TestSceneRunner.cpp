@@ -22,6 +22,7 @@
 #include "tests/common/TestContext.h"
 #include "tests/common/TestScene.h"
 #include "tests/common/scenes/TestSceneBase.h"
+#include "tests/macrobench/BenchmarkSuite.h"
 
 #include <benchmark/benchmark.h>
 #include <gui/Surface.h>
@@ -99,7 +100,7 @@ void outputBenchmarkReport(const TestScene::Info& info, const TestScene::Options
 }
 
 static void doRun(const TestScene::Info& info, const TestScene::Options& opts, int repetitionIndex,
-                  BenchmarkResults* reports) {
+                  BenchmarkResults* reports, FrameStatsCollector* stats = nullptr) {
     if (opts.reportGpuMemoryUsage) {
         // If we're reporting GPU memory usage we need to first start with a clean slate
         RenderProxy::purgeCaches();
@@ -129,6 +130,7 @@ static void doRun(const TestScene::Info& info, const TestScene::Options& opts, i
     float lightX = width / 2.0;
     proxy->setLightAlpha(255 * 0.075, 255 * 0.15);
     proxy->setLightGeometry((Vector3){lightX, dp(-200.0f), dp(800.0f)}, dp(800.0f));
+    proxy->setPipelinedDrawFrame(opts.pipelinedDrawFrame);
 
     // Do a few cold runs then reset the stats so that the caches are all hot
     int warmupFrameCount = 5;
@@ -149,6 +151,9 @@ static void doRun(const TestScene::Info& info, const TestScene::Options& opts, i
 
     proxy->resetProfileInfo();
     proxy->fence();
+    if (stats) {
+        proxy->addFrameMetricsObserver(sp<FrameMetricsObserver>(stats));
+    }
 
     ModifiedMovingAverage<double> avgMs(opts.reportFrametimeWeight);
 
@@ -158,6 +163,7 @@ static void doRun(const TestScene::Info& info, const TestScene::Options& opts, i
         nsecs_t vsync = systemTime(SYSTEM_TIME_MONOTONIC);
         {
             ATRACE_NAME("UI-Draw Frame");
+            proxy->waitForPendingSync();
             UiFrameInfoBuilder(proxy->frameInfo())
                 .setVsync(vsync, vsync, UiFrameInfoBuilder::INVALID_VSYNC_ID,
                           UiFrameInfoBuilder::UNKNOWN_DEADLINE,
@@ -178,7 +184,13 @@ static void doRun(const TestScene::Info& info, const TestScene::Options& opts, i
     proxy->fence();
     nsecs_t end = systemTime(SYSTEM_TIME_MONOTONIC);
 
-    if (reports) {
+    if (stats) {
+        proxy->removeFrameMetricsObserver(sp<FrameMetricsObserver>(stats));
+        proxy->fence();
+        size_t cpuUsage, gpuUsage;
+        RenderProxy::getMemoryUsage(&cpuUsage, &gpuUsage);
+        stats->setMemoryUsage(cpuUsage, gpuUsage);
+    } else if (reports) {
         outputBenchmarkReport(info, opts, (end - start) / (double)s2ns(1), repetitionIndex,
                               reports);
     } else {
@@ -213,3 +225,10 @@ void run(const TestScene::Info& info, const TestScene::Options& opts,
         RenderProxy::dumpGraphicsMemory(STDOUT_FILENO, false);
     }
 }
+
+void runForStats(const TestScene::Info& info, const TestScene::Options& opts,
+                 FrameStatsCollector* stats) {
+    for (int i = 0; i < opts.repeatCount; i++) {
+        doRun(info, opts, i, nullptr, stats);
+    }
+}
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <android-base/file.h>
 #include <android-base/parsebool.h>
 #include <benchmark/benchmark.h>
 #include <errno.h>
@@ -24,6 +25,7 @@
 #include <stdio.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include <regex>
@@ -37,6 +39,7 @@
 #include "renderthread/RenderProxy.h"
 #include "tests/common/LeakChecker.h"
 #include "tests/common/TestScene.h"
+#include "tests/macrobench/BenchmarkSuite.h"
 
 using namespace android;
 using namespace android::base;
@@ -47,9 +50,16 @@ static std::vector<TestScene::Info> gRunTests;
 static TestScene::Options gOpts;
 static bool gRunLeakCheck = true;
 std::unique_ptr<benchmark::BenchmarkReporter> gBenchmarkReporter;
+static const char* gRenderer = nullptr;
+static bool gRunSuite = false;
+static std::string gSuiteOutput;
+static std::string gBaselinePath;
+static float gRegressionThreshold = 10;
 
 void run(const TestScene::Info& info, const TestScene::Options& opts,
          benchmark::BenchmarkReporter* reporter);
+void runForStats(const TestScene::Info& info, const TestScene::Options& opts,
+                 FrameStatsCollector* stats);
 
 static void printHelp() {
     printf(R"(
@@ -77,6 +87,13 @@ OPTIONS:
   --renderer=TYPE      Sets the render pipeline to use. May be skiagl or skiavk
   --skip-leak-check    Skips the memory leak check
   --report-gpu-memory[=verbose]  Dumps the GPU memory usage after each test run
+  --pipelined          Records the next frame while the RenderThread still draws the previous one
+  --suite[=FILE]       Runs the tests offscreen once per render pipeline, or only for --renderer,
+                       and writes the percentiles of each frame stage and the memory usage as JSON
+                       to FILE, or to stdout
+  --baseline=FILE      With --suite, compares the results to the ones of an earlier --suite run and
+                       exits with an error if any regressed
+  --regression-threshold=PERCENT  How much worse than the baseline a result may be, default 10
 )");
 }
 
@@ -203,6 +220,10 @@ enum {
     Renderer,
     SkipLeakCheck,
     ReportGpuMemory,
+    Pipelined,
+    Suite,
+    Baseline,
+    RegressionThreshold,
 };
 }
 
@@ -222,6 +243,10 @@ static const struct option LONG_OPTIONS[] = {
         {"renderer", required_argument, nullptr, LongOpts::Renderer},
         {"skip-leak-check", no_argument, nullptr, LongOpts::SkipLeakCheck},
         {"report-gpu-memory", optional_argument, nullptr, LongOpts::ReportGpuMemory},
+        {"pipelined", no_argument, nullptr, LongOpts::Pipelined},
+        {"suite", optional_argument, nullptr, LongOpts::Suite},
+        {"baseline", required_argument, nullptr, LongOpts::Baseline},
+        {"regression-threshold", required_argument, nullptr, LongOpts::RegressionThreshold},
         {0, 0, 0, 0}};
 
 static const char* SHORT_OPTIONS = "c:r:h";
@@ -329,6 +354,7 @@ void parseOptions(int argc, char* argv[]) {
                 if (!setRenderer(optarg)) {
                     error = true;
                 }
+                gRenderer = optarg;
                 break;
 
             case LongOpts::Onscreen:
@@ -339,6 +365,33 @@ void parseOptions(int argc, char* argv[]) {
                 gOpts.renderOffscreen = true;
                 break;
 
+            case LongOpts::Pipelined:
+                gOpts.pipelinedDrawFrame = true;
+                break;
+
+            case LongOpts::Suite:
+                gRunSuite = true;
+                if (optarg) {
+                    gSuiteOutput = optarg;
+                }
+                break;
+
+            case LongOpts::Baseline:
+                if (!optarg) {
+                    error = true;
+                    break;
+                }
+                gBaselinePath = optarg;
+                break;
+
+            case LongOpts::RegressionThreshold:
+                gRegressionThreshold = atof(optarg);
+                if (gRegressionThreshold <= 0) {
+                    fprintf(stderr, "Invalid regression threshold '%s'\n", optarg);
+                    error = true;
+                }
+                break;
+
             case LongOpts::SkipLeakCheck:
                 gRunLeakCheck = false;
                 break;
@@ -369,6 +422,11 @@ void parseOptions(int argc, char* argv[]) {
         }
     }
 
+    if (!gBaselinePath.empty() && !gRunSuite) {
+        fprintf(stderr, "--baseline requires --suite\n");
+        error = true;
+    }
+
     if (error) {
         fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
         exit(EXIT_FAILURE);
@@ -409,10 +467,122 @@ void parseOptions(int argc, char* argv[]) {
     }
 }
 
+// Runs the tests with one render pipeline and appends their results. This happens in a child
+// process, as the pipeline can't change once it has been set.
+static bool runSuiteWithRenderer(const char* renderer, Json::Value* results) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC)) {
+        fprintf(stderr, "Failed to create a pipe, errno=%d\n", errno);
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid == -1) {
+        fprintf(stderr, "Failed to fork, errno=%d\n", errno);
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        setRenderer(renderer);
+        Json::Value rendererResults(Json::arrayValue);
+        for (auto&& test : gRunTests) {
+            auto stats = sp<FrameStatsCollector>::make();
+            runForStats(test, gOpts, stats.get());
+            rendererResults.append(BenchmarkSuite::makeResult(test.name, renderer, *stats));
+        }
+        bool written = WriteStringToFd(BenchmarkSuite::toString(rendererResults), fds[1]);
+        close(fds[1]);
+
+        renderthread::RenderProxy::trimMemory(100);
+        HardwareBitmapUploader::terminate();
+        if (gRunLeakCheck) {
+            LeakChecker::checkForLeaks();
+        }
+        _exit(written ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+    std::string json;
+    bool read = ReadFdToString(fds[0], &json);
+    close(fds[0]);
+    int status = 0;
+    if (TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)) != pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != EXIT_SUCCESS || !read) {
+        fprintf(stderr, "The %s run failed\n", renderer);
+        return false;
+    }
+    Json::Value rendererResults;
+    std::string errors;
+    if (!BenchmarkSuite::parse(json, &rendererResults, &errors)) {
+        fprintf(stderr, "Invalid results of the %s run: %s\n", renderer, errors.c_str());
+        return false;
+    }
+    for (const Json::Value& result : rendererResults) {
+        results->append(result);
+    }
+    return true;
+}
+
+static int runSuite() {
+    gOpts.renderOffscreen = true;
+    gOpts.reportGpuMemoryUsage = true;
+    gOpts.reportFrametimeWeight = 0;
+    if (gSuiteOutput.empty()) {
+        // Same as for the JSON benchmark format, the leak check would break the JSON on stdout.
+        gRunLeakCheck = false;
+    }
+
+    std::vector<const char*> renderers = {"skiagl", "skiavk"};
+    if (gRenderer) {
+        renderers = {gRenderer};
+    }
+    Json::Value results(Json::arrayValue);
+    for (const char* renderer : renderers) {
+        if (!runSuiteWithRenderer(renderer, &results)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    const Json::Value report = BenchmarkSuite::makeReport(results, gOpts.frameCount);
+    const std::string json = BenchmarkSuite::toString(report);
+    if (gSuiteOutput.empty()) {
+        fputs(json.c_str(), stdout);
+    } else if (!WriteStringToFile(json, gSuiteOutput)) {
+        fprintf(stderr, "Failed to write '%s', errno=%d\n", gSuiteOutput.c_str(), errno);
+        return EXIT_FAILURE;
+    }
+
+    if (gBaselinePath.empty()) {
+        return EXIT_SUCCESS;
+    }
+    std::string baselineJson;
+    if (!ReadFileToString(gBaselinePath, &baselineJson)) {
+        fprintf(stderr, "Failed to read '%s', errno=%d\n", gBaselinePath.c_str(), errno);
+        return EXIT_FAILURE;
+    }
+    Json::Value baseline;
+    std::string errors;
+    if (!BenchmarkSuite::parse(baselineJson, &baseline, &errors)) {
+        fprintf(stderr, "Invalid baseline '%s': %s\n", gBaselinePath.c_str(), errors.c_str());
+        return EXIT_FAILURE;
+    }
+    int regressions =
+            BenchmarkSuite::compareToBaseline(report, baseline, gRegressionThreshold, stderr);
+    if (regressions) {
+        fprintf(stderr, "%d regression(s) over the baseline\n", regressions);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char* argv[]) {
     Typeface::setRobotoTypefaceForTest();
 
     parseOptions(argc, argv);
+    if (gRunSuite) {
+        return runSuite();
+    }
     if (!gBenchmarkReporter && gOpts.renderOffscreen) {
         gBenchmarkReporter.reset(new benchmark::ConsoleReporter());
     }
@@ -20,6 +20,7 @@
 #include "hwui/Paint.h"
 #include "canvas/CanvasOpBuffer.h"
 #include "canvas/CanvasFrontend.h"
+#include "canvas/CanvasOpRasterizer.h"
 #include "tests/common/TestUtils.h"
 
 using namespace android;
@@ -95,3 +96,36 @@ void BM_CanvasOpBuffer_record_simpleBitmapView(benchmark::State& benchState) {
     }
 }
 BENCHMARK(BM_CanvasOpBuffer_record_simpleBitmapView);
+
+void BM_CanvasOpBuffer_replay_simpleBitmapView(benchmark::State& benchState) {
+    CanvasFrontend<CanvasOpBuffer> canvas(100, 100);
+
+    Paint rectPaint;
+    sk_sp<Bitmap> iconBitmap(TestUtils::createBitmap(80, 80));
+    canvas.save(SaveFlags::MatrixClip);
+    canvas.draw(CanvasOp<CanvasOpType::DrawRect> {
+            .rect = SkRect::MakeWH(100, 100),
+            .paint = rectPaint,
+    });
+    canvas.restore();
+    canvas.save(SaveFlags::MatrixClip);
+    canvas.translate(10, 10);
+    canvas.draw(CanvasOp<CanvasOpType::DrawImage> {
+            iconBitmap,
+            0,
+            0,
+            SkFilterMode::kNearest,
+            SkPaint{}
+    });
+    canvas.restore();
+    CanvasOpBuffer buffer = canvas.finish();
+
+    SkBitmap target;
+    target.allocN32Pixels(100, 100);
+    SkCanvas skCanvas(target);
+    while (benchState.KeepRunning()) {
+        rasterizeCanvasBuffer(buffer, &skCanvas);
+        benchmark::DoNotOptimize(&skCanvas);
+    }
+}
+BENCHMARK(BM_CanvasOpBuffer_replay_simpleBitmapView);
@@ -119,6 +119,30 @@ void BM_SkiaDisplayListCanvas_record_simpleBitmapView(benchmark::State& benchSta
 }
 BENCHMARK(BM_SkiaDisplayListCanvas_record_simpleBitmapView);
 
+void BM_SkiaDisplayListCanvas_replay_simpleBitmapView(benchmark::State& benchState) {
+    auto canvas = std::make_unique<SkiaRecordingCanvas>(nullptr, 100, 100);
+
+    Paint rectPaint;
+    sk_sp<Bitmap> iconBitmap(TestUtils::createBitmap(80, 80));
+    canvas->save(SaveFlags::MatrixClip);
+    canvas->drawRect(0, 0, 100, 100, rectPaint);
+    canvas->restore();
+    canvas->save(SaveFlags::MatrixClip);
+    canvas->translate(10, 10);
+    canvas->drawBitmap(*iconBitmap, 0, 0, nullptr);
+    canvas->restore();
+    std::unique_ptr<SkiaDisplayList> displayList = canvas->finishRecording();
+
+    SkBitmap target;
+    target.allocN32Pixels(100, 100);
+    SkCanvas skCanvas(target);
+    while (benchState.KeepRunning()) {
+        displayList->draw(&skCanvas);
+        benchmark::DoNotOptimize(&skCanvas);
+    }
+}
+BENCHMARK(BM_SkiaDisplayListCanvas_replay_simpleBitmapView);
+
 void BM_SkiaDisplayListCanvas_basicViewGroupDraw(benchmark::State& benchState) {
     sp<RenderNode> child = TestUtils::createNode(50, 50, 100, 100, [](auto& props, auto& canvas) {
         canvas.drawColor(0xFFFFFFFF, SkBlendMode::kSrcOver);
@@ -16,8 +16,10 @@
 
 #include <benchmark/benchmark.h>
 
+#include "utils/ChunkPool.h"
 #include "utils/LinearAllocator.h"
 
+#include <memory>
 #include <vector>
 
 using namespace android;
@@ -46,3 +48,48 @@ static void BM_LinearStdAllocator_vector(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_LinearStdAllocator_vector);
+
+// Records state.range(0) ops into a fresh allocator every iteration, like a view that re-records
+// its display list every frame. The pages of the previous iteration are recycled.
+static void BM_LinearAllocator_rerecord(benchmark::State& state) {
+    const int opCount = state.range(0);
+    while (state.KeepRunning()) {
+        LinearAllocator la;
+        for (int j = 0; j < opCount; j++) {
+            benchmark::DoNotOptimize(la.alloc<char>(48));
+        }
+    }
+}
+BENCHMARK(BM_LinearAllocator_rerecord)->Arg(10)->Arg(100)->Arg(1000);
+
+// Same as BM_LinearAllocator_rerecord, but every page is malloc'ed and freed again.
+static void BM_LinearAllocator_rerecord_noRecycling(benchmark::State& state) {
+    const int opCount = state.range(0);
+    while (state.KeepRunning()) {
+        {
+            LinearAllocator la;
+            for (int j = 0; j < opCount; j++) {
+                benchmark::DoNotOptimize(la.alloc<char>(48));
+            }
+        }
+        ChunkPool::get().trim();
+    }
+}
+BENCHMARK(BM_LinearAllocator_rerecord_noRecycling)->Arg(10)->Arg(100)->Arg(1000);
+
+// Re-records into a few allocators that are alive at the same time, like a screen full of
+// animating views.
+static void BM_LinearAllocator_rerecordMany(benchmark::State& state) {
+    constexpr int kViewCount = 16;
+    std::vector<std::unique_ptr<LinearAllocator>> allocators(kViewCount);
+    int next = 0;
+    while (state.KeepRunning()) {
+        auto la = std::make_unique<LinearAllocator>();
+        for (int j = 0; j < 200; j++) {
+            benchmark::DoNotOptimize(la->alloc<char>(48));
+        }
+        allocators[next] = std::move(la);
+        next = (next + 1) % kViewCount;
+    }
+}
+BENCHMARK(BM_LinearAllocator_rerecordMany);
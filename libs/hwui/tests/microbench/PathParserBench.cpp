@@ -28,6 +28,12 @@ static const char* sPathString =
         "M 1 1 m 2 2, l 3 3 L 3 3 H 4 h4 V5 v5, Q6 6 6 6 q 6 6 6 6t 7 7 T 7 7 C 8 8 8 8 8 8 c 8 8 "
         "8 8 8 8 S 9 9 9 9 s 9 9 9 9 A 10 10 0 1 1 10 10 a 10 10 0 1 1 10 10";
 
+// A path of a typical material icon, with decimal numbers and few separators.
+static const char* sIconPathString =
+        "M12,21.35l-1.45,-1.32C5.4,15.36 2,12.28 2,8.5 2,5.42 4.42,3 7.5,3c1.74,0 3.41,0.81 "
+        "4.5,2.09C13.09,3.81 14.76,3 16.5,3 19.58,3 22,5.42 22,8.5c0,3.78 -3.4,6.86 -8.55,"
+        "11.54L12,21.35z";
+
 void BM_PathParser_parseStringPathForSkPath(benchmark::State& state) {
     SkPath skPath;
     size_t length = strlen(sPathString);
@@ -51,3 +57,55 @@ void BM_PathParser_parseStringPathForPathData(benchmark::State& state) {
     }
 }
 BENCHMARK(BM_PathParser_parseStringPathForPathData);
+
+void BM_PathParser_parseIconPathForPathData(benchmark::State& state) {
+    size_t length = strlen(sIconPathString);
+    while (state.KeepRunning()) {
+        PathData outData;
+        PathParser::ParseResult result;
+        PathParser::getPathDataFromAsciiString(&outData, &result, sIconPathString, length);
+        benchmark::DoNotOptimize(&result);
+        benchmark::DoNotOptimize(&outData);
+    }
+}
+BENCHMARK(BM_PathParser_parseIconPathForPathData);
+
+void BM_PathParser_parseIconPathForPathDataCached(benchmark::State& state) {
+    size_t length = strlen(sIconPathString);
+    PathParser::clearCache();
+    while (state.KeepRunning()) {
+        PathData outData;
+        PathParser::ParseResult result;
+        PathParser::getPathDataFromAsciiStringCached(&outData, &result, sIconPathString, length);
+        benchmark::DoNotOptimize(&result);
+        benchmark::DoNotOptimize(&outData);
+    }
+    PathParser::clearCache();
+}
+BENCHMARK(BM_PathParser_parseIconPathForPathDataCached);
+
+void BM_PathParser_parseIconPathForSkPath(benchmark::State& state) {
+    SkPath skPath;
+    size_t length = strlen(sIconPathString);
+    PathParser::ParseResult result;
+    while (state.KeepRunning()) {
+        PathParser::parseAsciiStringForSkPath(&skPath, &result, sIconPathString, length);
+        benchmark::DoNotOptimize(&result);
+        benchmark::DoNotOptimize(&skPath);
+    }
+}
+BENCHMARK(BM_PathParser_parseIconPathForSkPath);
+
+void BM_PathParser_parseIconPathForSkPathCached(benchmark::State& state) {
+    SkPath skPath;
+    size_t length = strlen(sIconPathString);
+    PathParser::ParseResult result;
+    PathParser::clearCache();
+    while (state.KeepRunning()) {
+        PathParser::parseAsciiStringForSkPathCached(&skPath, &result, sIconPathString, length);
+        benchmark::DoNotOptimize(&result);
+        benchmark::DoNotOptimize(&skPath);
+    }
+    PathParser::clearCache();
+}
+BENCHMARK(BM_PathParser_parseIconPathForSkPathCached);
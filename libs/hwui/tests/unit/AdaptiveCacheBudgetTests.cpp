@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "renderthread/AdaptiveCacheBudget.h"
+
+using namespace android;
+using namespace android::uirenderer;
+using namespace android::uirenderer::renderthread;
+
+static constexpr size_t kBaseBytes = 1000000;
+
+// Completes a window of frames that all use usedBytes, and returns whether the limit changed.
+static bool runWindow(AdaptiveCacheBudget& budget, size_t usedBytes, bool underPressure = false) {
+    for (int i = 0; i < AdaptiveCacheBudget::kWindowFrames - 1; i++) {
+        EXPECT_FALSE(budget.onFrameCompleted(usedBytes));
+    }
+    EXPECT_TRUE(budget.onFrameCompleted(usedBytes));
+    return budget.update(underPressure);
+}
+
+TEST(AdaptiveCacheBudget, growsWhenFull) {
+    AdaptiveCacheBudget budget;
+    budget.reset(kBaseBytes, MemoryPolicy{});
+    EXPECT_EQ(kBaseBytes, budget.limit());
+
+    EXPECT_TRUE(runWindow(budget, kBaseBytes));
+    EXPECT_EQ(kBaseBytes * AdaptiveCacheBudget::kGrowFactor, budget.limit());
+
+    // The limit never grows beyond the bounds of the policy.
+    for (int i = 0; i < 10; i++) {
+        runWindow(budget, budget.limit());
+    }
+    EXPECT_EQ(kBaseBytes * MemoryPolicy{}.maxAdaptiveResourceScale, budget.limit());
+}
+
+TEST(AdaptiveCacheBudget, shrinksWhenMostlyUnused) {
+    AdaptiveCacheBudget budget;
+    budget.reset(kBaseBytes, MemoryPolicy{});
+
+    // Usage between half and all of the limit keeps it as is.
+    EXPECT_FALSE(runWindow(budget, kBaseBytes * 0.6f));
+    EXPECT_EQ(kBaseBytes, budget.limit());
+
+    EXPECT_TRUE(runWindow(budget, kBaseBytes * 0.4f));
+    EXPECT_EQ(kBaseBytes * 0.4f * AdaptiveCacheBudget::kShrinkHeadroom, budget.limit());
+
+    EXPECT_TRUE(runWindow(budget, 0));
+    EXPECT_EQ(kBaseBytes * MemoryPolicy{}.minAdaptiveResourceScale, budget.limit());
+}
+
+TEST(AdaptiveCacheBudget, memoryPressure) {
+    AdaptiveCacheBudget budget;
+    budget.reset(kBaseBytes, MemoryPolicy{});
+
+    // A full cache doesn't grow under memory pressure.
+    EXPECT_TRUE(runWindow(budget, kBaseBytes, true /* underPressure */));
+    EXPECT_TRUE(budget.isUnderMemoryPressure());
+    EXPECT_EQ(kBaseBytes * MemoryPolicy{}.minAdaptiveResourceScale, budget.limit());
+
+    EXPECT_TRUE(runWindow(budget, budget.limit()));
+    EXPECT_FALSE(budget.isUnderMemoryPressure());
+
+    EXPECT_TRUE(budget.onMemoryPressure());
+    EXPECT_FALSE(budget.onMemoryPressure());
+    EXPECT_EQ(kBaseBytes * MemoryPolicy{}.minAdaptiveResourceScale, budget.limit());
+}
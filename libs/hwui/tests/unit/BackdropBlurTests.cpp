@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SkColorFilter.h>
+#include <SkImageFilters.h>
+#include <SkSurface.h>
+#include <gtest/gtest.h>
+
+#include "effects/BackdropBlur.h"
+
+using namespace android;
+using namespace android::uirenderer;
+
+TEST(BackdropBlur, getBlurSigma) {
+    auto sigma = BackdropBlur::getBlurSigma(SkImageFilters::Blur(3, 5, nullptr).get());
+    ASSERT_TRUE(sigma.has_value());
+    EXPECT_FLOAT_EQ(3, sigma->width());
+    EXPECT_FLOAT_EQ(5, sigma->height());
+
+    // Only plain blurs of the source qualify.
+    auto input = SkImageFilters::Offset(10, 10, nullptr);
+    EXPECT_FALSE(BackdropBlur::getBlurSigma(SkImageFilters::Blur(3, 3, input).get()));
+    EXPECT_FALSE(BackdropBlur::getBlurSigma(
+            SkImageFilters::Blur(3, 3, nullptr, SkIRect::MakeWH(10, 10)).get()));
+    EXPECT_FALSE(BackdropBlur::getBlurSigma(input.get()));
+    EXPECT_FALSE(BackdropBlur::getBlurSigma(nullptr));
+}
+
+TEST(BackdropBlur, getDownsampleLevels) {
+    EXPECT_EQ(0, BackdropBlur::getDownsampleLevels(SkSize::Make(32, 32), 0));
+    EXPECT_EQ(0, BackdropBlur::getDownsampleLevels(SkSize::Make(7, 7), 1));
+    EXPECT_EQ(1, BackdropBlur::getDownsampleLevels(SkSize::Make(8, 8), 1));
+    EXPECT_EQ(2, BackdropBlur::getDownsampleLevels(SkSize::Make(16, 16), 1));
+    EXPECT_EQ(3, BackdropBlur::getDownsampleLevels(SkSize::Make(16, 16), 2));
+    // The smallest sigma decides.
+    EXPECT_EQ(1, BackdropBlur::getDownsampleLevels(SkSize::Make(64, 8), 1));
+    EXPECT_EQ(BackdropBlur::kMaxLevels,
+              BackdropBlur::getDownsampleLevels(SkSize::Make(1000, 1000), 2));
+}
+
+TEST(BackdropBlur, blur) {
+    auto surface = SkSurfaces::Raster(SkImageInfo::MakeN32Premul(101, 64));
+    surface->getCanvas()->clear(SK_ColorRED);
+    auto backdrop = surface->makeImageSnapshot();
+
+    BackdropBlur blur;
+    auto filter = SkImageFilters::Blur(16, 16, SkTileMode::kClamp, nullptr);
+    auto result = blur.blur(surface->getCanvas(), backdrop, filter.get(), 3);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(SkISize::Make(51, 32), result->dimensions());
+
+    // A uniform backdrop with clamped edges stays the same color.
+    SkBitmap bitmap;
+    ASSERT_TRUE(bitmap.tryAllocPixels(result->imageInfo()));
+    ASSERT_TRUE(result->readPixels(bitmap.pixmap(), 0, 0));
+    EXPECT_EQ(SK_ColorRED, bitmap.getColor(25, 16));
+
+    // The levels are reused for a backdrop of the same size.
+    auto again = blur.blur(surface->getCanvas(), backdrop, filter.get(), 3);
+    ASSERT_TRUE(again);
+    EXPECT_EQ(result->dimensions(), again->dimensions());
+}
@@ -647,3 +647,24 @@ TEST(CanvasOp, frontendSaveCount) {
     EXPECT_EQ(1, receiver[Op::Save]);
     EXPECT_EQ(1, receiver[Op::Restore]);
 }
+
+TEST(CanvasOp, applyColorTransform) {
+    CanvasOpBuffer buffer;
+    SkPaint paint;
+    paint.setColor(SK_ColorWHITE);
+    buffer.push<Op::DrawPaint>({.paint = paint});
+    buffer.push<Op::DrawColor>({
+            .color = SkColors::kWhite,
+            .mode = SkBlendMode::kSrcOver,
+    });
+
+    buffer.applyColorTransform(ColorTransform::Invert);
+    int paintCount = 0;
+    buffer.for_each([&]<Op T>(const CanvasOpContainer<T>* op) {
+        if constexpr (T == Op::DrawPaint) {
+            EXPECT_NE(SK_ColorWHITE, op->op().paint.getColor());
+            paintCount++;
+        }
+    });
+    EXPECT_EQ(1, paintCount);
+}
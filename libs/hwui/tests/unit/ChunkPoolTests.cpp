@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <utils/ChunkPool.h>
+#include <utils/LinearAllocator.h>
+
+using namespace android;
+using namespace android::uirenderer;
+
+TEST(ChunkPool, chunkSize) {
+    EXPECT_EQ(512u, ChunkPool::chunkSize(1));
+    EXPECT_EQ(512u, ChunkPool::chunkSize(512));
+    EXPECT_EQ(8192u, ChunkPool::chunkSize(4097));
+    EXPECT_EQ(ChunkPool::kMaxChunkSize, ChunkPool::chunkSize(ChunkPool::kMaxChunkSize));
+    EXPECT_EQ(ChunkPool::kMaxChunkSize + 1, ChunkPool::chunkSize(ChunkPool::kMaxChunkSize + 1));
+}
+
+TEST(ChunkPool, recyclesReleasedChunks) {
+    ChunkPool& pool = ChunkPool::get();
+    pool.trim();
+
+    void* chunk = pool.acquire(ChunkPool::kMaxChunkSize);
+    pool.release(chunk, ChunkPool::kMaxChunkSize);
+    EXPECT_EQ(ChunkPool::kMaxChunkSize, pool.getStats().cachedBytes);
+    EXPECT_EQ(chunk, pool.acquire(ChunkPool::kMaxChunkSize));
+    EXPECT_EQ(0u, pool.getStats().cachedBytes);
+
+    // Chunks that aren't the size of a size class are freed right away.
+    pool.release(chunk, ChunkPool::kMaxChunkSize);
+    pool.release(pool.acquire(1000), 1000);
+    pool.release(pool.acquire(ChunkPool::kMaxChunkSize * 2), ChunkPool::kMaxChunkSize * 2);
+    EXPECT_EQ(ChunkPool::kMaxChunkSize, pool.getStats().cachedBytes);
+
+    pool.trim();
+    EXPECT_EQ(0u, pool.getStats().cachedBytes);
+}
+
+TEST(ChunkPool, limitsCachedBytes) {
+    ChunkPool& pool = ChunkPool::get();
+    pool.trim();
+
+    constexpr size_t kChunkCount = ChunkPool::kMaxCachedBytes / ChunkPool::kMaxChunkSize + 1;
+    void* chunks[kChunkCount];
+    for (auto& chunk : chunks) {
+        chunk = pool.acquire(ChunkPool::kMaxChunkSize);
+    }
+    for (auto chunk : chunks) {
+        pool.release(chunk, ChunkPool::kMaxChunkSize);
+    }
+    EXPECT_EQ(ChunkPool::kMaxCachedBytes, pool.getStats().cachedBytes);
+    pool.trim();
+}
+
+TEST(ChunkPool, recyclesLinearAllocatorPages) {
+    ChunkPool& pool = ChunkPool::get();
+    pool.trim();
+    {
+        LinearAllocator la;
+        la.alloc<char>(64);
+    }
+    const size_t cachedBytes = pool.getStats().cachedBytes;
+    EXPECT_LT(0u, cachedBytes);
+    {
+        LinearAllocator la;
+        la.alloc<char>(64);
+        EXPECT_GT(cachedBytes, pool.getStats().cachedBytes);
+    }
+    EXPECT_EQ(cachedBytes, pool.getStats().cachedBytes);
+    pool.trim();
+}
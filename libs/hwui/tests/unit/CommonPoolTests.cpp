@@ -36,6 +36,62 @@ TEST(CommonPool, post) {
     EXPECT_TRUE(ran) << "Failed to flip atomic after 1 second";
 }
 
+TEST(CommonPool, postBackground) {
+    std::atomic_bool ran(false);
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    std::atomic<nsecs_t> ranAt(0);
+    CommonPool::postBackground(
+            [&] {
+                ranAt = systemTime(SYSTEM_TIME_MONOTONIC);
+                ran = true;
+            },
+            ms2ns(10));
+    for (int i = 0; !ran && i < 1000; i++) {
+        usleep(1000);
+    }
+    ASSERT_TRUE(ran) << "Failed to flip atomic after 1 second";
+    EXPECT_GE(ranAt - start, ms2ns(10));
+    CommonPool::waitForIdle();
+}
+
+TEST(CommonPool, backgroundTaskDoesNotBlockPost) {
+    std::mutex mutex;
+    std::condition_variable fence;
+    bool backgroundStarted = false;
+    bool releaseBackground = false;
+    std::atomic_int backgroundRuns(0);
+    for (int i = 0; i < 2; i++) {
+        CommonPool::postBackground([&] {
+            std::unique_lock lock{mutex};
+            backgroundRuns++;
+            backgroundStarted = true;
+            fence.notify_all();
+            while (!releaseBackground) {
+                fence.wait(lock);
+            }
+        });
+    }
+    {
+        std::unique_lock lock{mutex};
+        while (!backgroundStarted) {
+            fence.wait(lock);
+        }
+    }
+
+    // A worker is left for the work of frames, and the second background task waits for the
+    // first one to finish.
+    EXPECT_NE(gettid(), CommonPool::async([] { return gettid(); }).get());
+    EXPECT_EQ(1, backgroundRuns.load());
+
+    {
+        std::unique_lock lock{mutex};
+        releaseBackground = true;
+        fence.notify_all();
+    }
+    CommonPool::waitForIdle();
+    EXPECT_EQ(2, backgroundRuns.load());
+}
+
 // test currently relies on timings, which
 // makes it flaky. Disable for now
 TEST(DISABLED_CommonPool, threadCount) {
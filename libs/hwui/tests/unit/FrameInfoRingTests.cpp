@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+
+#include <vector>
+
+#include "FrameInfoRing.h"
+
+using namespace android;
+using namespace android::uirenderer;
+
+TEST(FrameInfoRing, readsLastFrames) {
+    std::unique_ptr<FrameInfoRing> ring = FrameInfoRing::create(4);
+    ASSERT_NE(nullptr, ring);
+    void* mapping = mmap(nullptr, ring->size(), PROT_READ, MAP_SHARED, ring->fd(), 0);
+    ASSERT_NE(MAP_FAILED, mapping);
+
+    for (int i = 0; i < 6; i++) {
+        FrameInfo frame{};
+        frame.set(FrameInfoIndex::IntendedVsync) = 1000 + i;
+        frame.set(FrameInfoIndex::FrameCompleted) = 2000 + i;
+        ring->append(frame);
+    }
+
+    FrameInfoBuffer frameInfo;
+    // Overwritten by frames 4 and 5.
+    EXPECT_FALSE(FrameInfoRing::readFrame(mapping, ring->size(), 0, &frameInfo));
+    EXPECT_FALSE(FrameInfoRing::readFrame(mapping, ring->size(), 1, &frameInfo));
+    for (int i = 2; i < 6; i++) {
+        ASSERT_TRUE(FrameInfoRing::readFrame(mapping, ring->size(), i, &frameInfo));
+        EXPECT_EQ(1000 + i, frameInfo[static_cast<int>(FrameInfoIndex::IntendedVsync)]);
+        EXPECT_EQ(2000 + i, frameInfo[static_cast<int>(FrameInfoIndex::FrameCompleted)]);
+    }
+    EXPECT_FALSE(FrameInfoRing::readFrame(mapping, ring->size(), 6, &frameInfo));
+
+    const auto* header = reinterpret_cast<const FrameInfoRing::Header*>(mapping);
+    EXPECT_EQ(FrameInfoRing::kMagic, header->magic);
+    EXPECT_EQ(6u, header->framesWritten.load());
+    munmap(mapping, ring->size());
+}
+
+TEST(FrameInfoRing, rejectsOtherMappings) {
+    std::vector<uint8_t> garbage(4096, 0xAB);
+    FrameInfoBuffer frameInfo;
+    EXPECT_FALSE(FrameInfoRing::readFrame(garbage.data(), garbage.size(), 0, &frameInfo));
+    EXPECT_FALSE(FrameInfoRing::readFrame(garbage.data(), 8, 0, &frameInfo));
+}
@@ -210,3 +210,30 @@ TEST(FrameMetricsReporter, canSupportMultipleObservers) {
     EXPECT_CALL(*observer2, notify).Times(1);
     reporter->reportFrameMetrics(stats, hasPresentTime, frameNumber + 10, surfaceControlId + 1);
 }
+
+TEST(FrameMetricsReporter, observerCanRemoveItselfWhenNotified) {
+    FrameInfoBuffer stats;
+    bool hasPresentTime = false;
+    uint64_t frameNumber = 3;
+    int32_t surfaceControlId = 0;
+
+    auto reporter = std::make_shared<FrameMetricsReporter>();
+
+    auto observer1 = sp<TestFrameMetricsObserver>::make(hasPresentTime /*waitForPresentTime*/);
+    auto observer2 = sp<TestFrameMetricsObserver>::make(hasPresentTime /*waitForPresentTime*/);
+    observer1->reportMetricsFrom(frameNumber, surfaceControlId);
+    observer2->reportMetricsFrom(frameNumber, surfaceControlId);
+    reporter->addObserver(observer1.get());
+    reporter->addObserver(observer2.get());
+
+    // The frame being reported still goes to all the observers it started with.
+    EXPECT_CALL(*observer1, notify).WillOnce([&](const FrameInfoBuffer&) {
+        EXPECT_TRUE(reporter->removeObserver(observer1.get()));
+    });
+    EXPECT_CALL(*observer2, notify).Times(1);
+    reporter->reportFrameMetrics(stats, hasPresentTime, frameNumber, surfaceControlId);
+
+    EXPECT_CALL(*observer1, notify).Times(0);
+    EXPECT_CALL(*observer2, notify).Times(1);
+    reporter->reportFrameMetrics(stats, hasPresentTime, frameNumber, surfaceControlId);
+}
@@ -15,6 +15,7 @@
  */
 
 #include <android-base/macros.h>
+#include <fcntl.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <stdio.h>
@@ -168,3 +169,33 @@ TEST(GraphicsStats, merge) {
         EXPECT_EQ(expectedBucket, loadedProto.histogram().Get(i).render_millis());
     }
 }
+
+TEST(GraphicsStats, protobufDumpStreamsEachStat) {
+    std::string path = findRootPath() + "/test_protobufDump";
+    int fd = open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0660);
+    ASSERT_GE(fd, 0);
+    MockProfileData mockData;
+    mockData.editTotalFrameCount() = 10;
+
+    auto dump = GraphicsStatsService::createDump(fd, GraphicsStatsService::DumpType::Protobuf);
+    GraphicsStatsService::addToDump(dump, "", 1, "com.test.first", 1, 1000, 2000, &mockData);
+    GraphicsStatsService::addToDump(dump, "", 2, "com.test.second", 2, 1000, 2000, &mockData);
+    GraphicsStatsService::finishDump(dump);
+
+    std::string contents;
+    ASSERT_EQ(0, lseek(fd, 0, SEEK_SET));
+    char buffer[4096];
+    ssize_t r;
+    while ((r = read(fd, buffer, sizeof(buffer))) > 0) {
+        contents.append(buffer, r);
+    }
+    close(fd);
+    unlink(path.c_str());
+
+    protos::GraphicsStatsServiceDumpProto dumpProto;
+    ASSERT_TRUE(dumpProto.ParseFromString(contents));
+    ASSERT_EQ(2, dumpProto.stats_size());
+    EXPECT_EQ("com.test.first", dumpProto.stats(0).package_name());
+    EXPECT_EQ("com.test.second", dumpProto.stats(1).package_name());
+    EXPECT_EQ(10, dumpProto.stats(1).summary().total_frames());
+}
@@ -69,6 +69,31 @@ TEST(LayerUpdateQueue, enqueueUnion) {
     EXPECT_EQ(Rect(10, 10, 40, 40), queue.entries()[0].damage);
 }
 
+TEST(LayerUpdateQueue, enqueueUnionManyLayers) {
+    std::vector<sp<RenderNode>> nodes;
+    LayerUpdateQueue queue;
+    for (int i = 0; i < 20; i++) {
+        nodes.push_back(createSyncedNode(100, 100));
+        queue.enqueueLayerWithDamage(nodes.back().get(), Rect(i, i, i + 1, i + 1));
+    }
+    for (int i = 0; i < 20; i++) {
+        queue.enqueueLayerWithDamage(nodes[i].get(), Rect(50, 50, 60, 60));
+    }
+
+    ASSERT_EQ(20u, queue.entries().size());
+    for (int i = 0; i < 20; i++) {
+        EXPECT_EQ(nodes[i].get(), queue.entries()[i].renderNode.get());
+        EXPECT_EQ(Rect(i, i, 60, 60), queue.entries()[i].damage);
+    }
+
+    // A cleared queue must not union into stale entries.
+    queue.clear();
+    queue.enqueueLayerWithDamage(nodes[5].get(), Rect(10, 10));
+    ASSERT_EQ(1u, queue.entries().size());
+    EXPECT_EQ(nodes[5].get(), queue.entries()[0].renderNode.get());
+    EXPECT_EQ(Rect(10, 10), queue.entries()[0].damage);
+}
+
 TEST(LayerUpdateQueue, clear) {
     sp<RenderNode> a = createSyncedNode(100, 100);
 
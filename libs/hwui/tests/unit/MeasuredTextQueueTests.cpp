@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "hwui/MeasuredTextQueue.h"
+#include "hwui/MinikinUtils.h"
+#include "hwui/Paint.h"
+#include "thread/CommonPool.h"
+
+using namespace android;
+using namespace android::uirenderer;
+
+namespace {
+
+MeasuredTextQueue::Paragraph makeParagraph(const std::string& string) {
+    MeasuredTextQueue::Paragraph paragraph;
+    paragraph.text.assign(string.begin(), string.end());
+    paragraph.builder = std::make_unique<minikin::MeasuredTextBuilder>();
+    Paint paint;
+    paint.getSkFont().setSize(20);
+    paragraph.builder->addStyleRun(0, paragraph.text.size(),
+                                   MinikinUtils::prepareMinikinPaint(&paint, nullptr),
+                                   0 /* lbStyle */, 0 /* lbWordStyle */, false /* hyphenation */,
+                                   false /* isRtl */);
+    return paragraph;
+}
+
+std::vector<MeasuredTextQueue::Paragraph> makeParagraphs(size_t count) {
+    std::vector<MeasuredTextQueue::Paragraph> paragraphs;
+    for (size_t i = 0; i < count; i++) {
+        paragraphs.push_back(makeParagraph("Paragraph " + std::to_string(i)));
+    }
+    return paragraphs;
+}
+
+std::vector<float> measureSync(const std::string& string) {
+    MeasuredTextQueue::Paragraph paragraph = makeParagraph(string);
+    const minikin::U16StringPiece text(paragraph.text.data(), paragraph.text.size());
+    return paragraph.builder->build(text, false, false, false, false, nullptr)->widths;
+}
+
+}  // namespace
+
+TEST(MeasuredTextQueue, measuresLikeBuild) {
+    auto batch = MeasuredTextQueue::submit(makeParagraphs(20));
+    ASSERT_EQ(20u, batch->size());
+    // Out of order, some of them are measured by the test thread.
+    for (size_t i = batch->size(); i-- > 0;) {
+        auto measured = batch->take(i);
+        ASSERT_NE(nullptr, measured);
+        EXPECT_EQ(measureSync("Paragraph " + std::to_string(i)), measured->widths);
+    }
+    CommonPool::waitForIdle();
+}
+
+TEST(MeasuredTextQueue, cancel) {
+    auto token = std::make_shared<MeasuredTextQueue::CancellationToken>();
+    token->cancel();
+    auto batch = MeasuredTextQueue::submit(makeParagraphs(5), token);
+    CommonPool::waitForIdle();
+    for (size_t i = 0; i < batch->size(); i++) {
+        EXPECT_EQ(nullptr, batch->take(i));
+    }
+}
+
+TEST(MeasuredTextQueue, cancelAfterTake) {
+    auto token = std::make_shared<MeasuredTextQueue::CancellationToken>();
+    auto batch = MeasuredTextQueue::submit(makeParagraphs(5), token);
+    auto first = batch->take(0);
+    token->cancel();
+    CommonPool::waitForIdle();
+    ASSERT_NE(nullptr, first);
+    EXPECT_FALSE(first->widths.empty());
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SkBitmap.h>
+#include <SkPngEncoder.h>
+#include <SkStream.h>
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <vector>
+
+#include "hwui/Bitmap.h"
+#include "hwui/RegionTileDecoder.h"
+
+using namespace android;
+
+namespace {
+
+// A 64x64 image whose pixels encode their position.
+sk_sp<SkData> makeImage() {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(64, 64);
+    for (int y = 0; y < 64; y++) {
+        for (int x = 0; x < 64; x++) {
+            *bitmap.getAddr32(x, y) = SkPackARGB32(0xFF, x * 4, y * 4, 0);
+        }
+    }
+    SkDynamicMemoryWStream stream;
+    EXPECT_TRUE(SkPngEncoder::Encode(&stream, bitmap.pixmap(), {}));
+    return stream.detachAsData();
+}
+
+}  // namespace
+
+TEST(RegionTileDecoder, decodesTiles) {
+    auto decoder = RegionTileDecoder::Make(makeImage());
+    ASSERT_NE(nullptr, decoder);
+    EXPECT_EQ(64, decoder->width());
+    EXPECT_EQ(64, decoder->height());
+
+    std::vector<RegionTileDecoder::Tile> tiles;
+    for (int y = 0; y < 64; y += 16) {
+        for (int x = 0; x < 64; x += 16) {
+            tiles.push_back({SkIRect::MakeXYWH(x, y, 16, 16)});
+        }
+    }
+    std::mutex lock;
+    std::vector<sk_sp<Bitmap>> results(tiles.size());
+    decoder->decode(tiles, {},
+                    [&](size_t index, sk_sp<Bitmap> bitmap) {
+                        std::lock_guard guard(lock);
+                        results[index] = std::move(bitmap);
+                    })
+            .wait();
+
+    for (size_t i = 0; i < tiles.size(); i++) {
+        ASSERT_NE(nullptr, results[i]) << "tile " << i;
+        EXPECT_EQ(16, results[i]->width());
+        EXPECT_EQ(16, results[i]->height());
+        SkBitmap bitmap;
+        results[i]->getSkBitmap(&bitmap);
+        const SkIRect& subset = tiles[i].subset;
+        EXPECT_EQ(SkPackARGB32(0xFF, subset.left() * 4, subset.top() * 4, 0),
+                  *bitmap.getAddr32(0, 0));
+    }
+}
+
+TEST(RegionTileDecoder, noTiles) {
+    auto decoder = RegionTileDecoder::Make(makeImage());
+    ASSERT_NE(nullptr, decoder);
+    auto done = decoder->decode({}, {}, [](size_t, sk_sp<Bitmap>) { FAIL(); });
+    EXPECT_EQ(std::future_status::ready, done.wait_for(std::chrono::seconds(0)));
+}
+
+TEST(RegionTileDecoder, rejectsInvalidData) {
+    EXPECT_EQ(nullptr, RegionTileDecoder::Make(SkData::MakeWithCString("not an image")));
+}
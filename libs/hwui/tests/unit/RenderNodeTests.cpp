@@ -301,6 +301,122 @@ RENDERTHREAD_TEST(RenderNode, prepareTree_nullableDisplayList) {
     canvasContext->destroy();
 }
 
+RENDERTHREAD_TEST(RenderNode, prepareTree_parallelMatchesSerial) {
+    auto createTree = [](std::vector<sp<RenderNode>>* children) {
+        for (int i = 0; i < 8; i++) {
+            children->push_back(TestUtils::createNode(
+                    i * 20, i * 10, i * 20 + 50, i * 10 + 80,
+                    [](RenderProperties& props, Canvas& canvas) {
+                        for (int j = 0; j < 10; j++) {
+                            auto grandChild = TestUtils::createNode(
+                                    j, j * 2, j + 10, j * 2 + 10,
+                                    [](RenderProperties&, Canvas& grandChildCanvas) {
+                                        grandChildCanvas.drawColor(Color::Red_500,
+                                                                   SkBlendMode::kSrcOver);
+                                    });
+                            canvas.drawRenderNode(grandChild.get());
+                        }
+                    }));
+        }
+        auto root = TestUtils::createNode(0, 0, 400, 400,
+                                          [children](RenderProperties& props, Canvas& canvas) {
+                                              for (auto& child : *children) {
+                                                  canvas.drawRenderNode(child.get());
+                                              }
+                                          });
+        TestUtils::syncHierarchyPropertiesAndDisplayList(root);
+        return root;
+    };
+
+    auto contextRoot = TestUtils::createNode(0, 0, 400, 400, nullptr);
+    ContextFactory contextFactory;
+    std::unique_ptr<CanvasContext> canvasContext(
+            CanvasContext::create(renderThread, false, contextRoot.get(), &contextFactory, 0, 0));
+    auto prepare = [&canvasContext](sp<RenderNode>& root, bool parallel) {
+        TreeInfo info(TreeInfo::MODE_FULL, *canvasContext.get());
+        DamageAccumulator damageAccumulator;
+        info.damageAccumulator = &damageAccumulator;
+        info.parallelPrepare = parallel;
+        root->prepareTree(info);
+        SkRect dirty;
+        damageAccumulator.peekAtDirty(&dirty);
+        return dirty;
+    };
+
+    std::vector<sp<RenderNode>> serialChildren;
+    auto serialRoot = createTree(&serialChildren);
+    std::vector<sp<RenderNode>> parallelChildren;
+    auto parallelRoot = createTree(&parallelChildren);
+
+    size_t nodeCount = 0;
+    EXPECT_TRUE(parallelChildren[0]->canPrepareInParallel(true, &nodeCount));
+    EXPECT_EQ(11u, nodeCount);
+
+    SkRect serialDirty = prepare(serialRoot, false);
+    EXPECT_FALSE(serialDirty.isEmpty());
+    EXPECT_EQ(serialDirty, prepare(parallelRoot, true));
+
+    // A node with a second parent may not be prepared in parallel.
+    auto otherParent = TestUtils::createNode(
+            0, 0, 100, 100, [&parallelChildren](RenderProperties& props, Canvas& canvas) {
+                canvas.drawRenderNode(parallelChildren[0].get());
+            });
+    TestUtils::syncHierarchyPropertiesAndDisplayList(otherParent);
+    nodeCount = 0;
+    EXPECT_FALSE(parallelChildren[0]->canPrepareInParallel(true, &nodeCount));
+
+    canvasContext->destroy();
+}
+
+RENDERTHREAD_TEST(RenderNode, prepareTree_cachesUnchangedNodeAsLayer) {
+    auto node = TestUtils::createNode(0, 0, 200, 200, [](RenderProperties& props, Canvas& canvas) {
+        SkPaint paint;
+        for (int i = 0; i < 100; i++) {
+            canvas.drawRect(i, i, i + 50, i + 50, paint);
+        }
+    });
+    TestUtils::syncHierarchyPropertiesAndDisplayList(node);
+
+    ContextFactory contextFactory;
+    std::unique_ptr<CanvasContext> canvasContext(
+            CanvasContext::create(renderThread, false, node.get(), &contextFactory, 0, 0));
+    LayerUpdateQueue layerUpdateQueue;
+    auto prepare = [&](size_t budget) {
+        TreeInfo info(TreeInfo::MODE_RT_ONLY, *canvasContext.get());
+        DamageAccumulator damageAccumulator;
+        info.damageAccumulator = &damageAccumulator;
+        info.layerUpdateQueue = &layerUpdateQueue;
+        info.autoLayerBudget = budget;
+        node->prepareTree(info);
+        layerUpdateQueue.clear();
+    };
+
+    const bool autoLayerCaching = Properties::autoLayerCaching;
+    Properties::autoLayerCaching = true;
+
+    // The node is cached once it went a few frames without damage.
+    for (int i = 0; i < 3; i++) {
+        prepare(SIZE_MAX);
+        EXPECT_EQ(LayerType::None, node->properties().effectiveLayerType());
+    }
+    prepare(SIZE_MAX);
+    EXPECT_TRUE(node->properties().isCachedAsLayer());
+    EXPECT_EQ(LayerType::RenderLayer, node->properties().effectiveLayerType());
+
+    node->destroyAutoLayers();
+    EXPECT_FALSE(node->hasLayer());
+    EXPECT_EQ(LayerType::None, node->properties().effectiveLayerType());
+
+    // A layer that doesn't fit into the budget is never created.
+    for (int i = 0; i < 5; i++) {
+        prepare(200 * 200 * 4 - 1);
+        EXPECT_FALSE(node->properties().isCachedAsLayer());
+    }
+
+    Properties::autoLayerCaching = autoLayerCaching;
+    canvasContext->destroy();
+}
+
 // TODO: Is this supposed to work in SkiaGL/SkiaVK?
 RENDERTHREAD_TEST(DISABLED_RenderNode, prepareTree_HwLayer_AVD_enqueueDamage) {
     VectorDrawable::Group* group = new VectorDrawable::Group();
@@ -362,3 +478,29 @@ TEST(RenderNode, hasFill) {
     EXPECT_TRUE(rootNode.get()->getDisplayList().hasFill());
     EXPECT_FALSE(rootNode.get()->getDisplayList().hasText());
 }
+
+TEST(RenderNode, getRevealClippedOutline_reusedUntilRevealChanges) {
+    auto node = TestUtils::createNode(0, 0, 200, 200, [](RenderProperties& props, Canvas&) {
+        props.mutableOutline().setRoundRect(0, 0, 200, 200, 10, 1.0f);
+        props.mutableRevealClip().set(true, 100, 100, 50);
+    });
+    TestUtils::syncHierarchyPropertiesAndDisplayList(node);
+    const SkPath& outline = *node->properties().getOutline().getPath();
+
+    const SkPath* first = node->getRevealClippedOutline(outline);
+    const uint32_t firstID = first->getGenerationID();
+    EXPECT_TRUE(first->isVolatile());
+    EXPECT_FALSE(first->isEmpty());
+
+    const SkPath* second = node->getRevealClippedOutline(outline);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(firstID, second->getGenerationID());
+    EXPECT_FALSE(second->isVolatile());
+
+    node->mutateStagingProperties().mutableRevealClip().set(true, 100, 100, 25);
+    TestUtils::syncHierarchyPropertiesAndDisplayList(node);
+    const SkPath* changed = node->getRevealClippedOutline(outline);
+    EXPECT_NE(firstID, changed->getGenerationID());
+    EXPECT_TRUE(changed->isVolatile());
+    EXPECT_FALSE(changed->isEmpty());
+}
@@ -54,6 +54,9 @@ public:
         cache.mInitialized = newCache.mInitialized;
         cache.mBlobCache.reset(nullptr);
         cache.mFilename = newCache.mFilename;
+        cache.mSharedFilename = newCache.mSharedFilename;
+        cache.mSharedCache.reset(nullptr);
+        cache.mSharedCacheBuilder.reset(nullptr);
         cache.mIDHash.clear();
         cache.mSavePending = newCache.mSavePending;
         cache.mObservedBlobValueSize = newCache.mObservedBlobValueSize;
@@ -64,6 +67,9 @@ public:
         cache.mOldPipelineCacheSize = newCache.mOldPipelineCacheSize;
         cache.mCacheDirty = newCache.mCacheDirty;
         cache.mNumShadersCachedInRam = newCache.mNumShadersCachedInRam;
+        cache.mCompletedFrames = newCache.mCompletedFrames.load();
+        cache.mWarmupKeys.clear();
+        cache.mSavedWarmupKeys.clear();
     }
 
     /**
@@ -119,7 +125,7 @@ public:
                 FAIL() << "Timed out after waiting " << timeoutMs << " ms for a pending save";
             }
             // This small (0.1 ms) delay is to avoid working too much while waiting for
-            // deferredSaveThread to take the mutex and start the disk write.
+            // the background save task to take the mutex and start the disk write.
             const int delayMicroseconds = 100;
             usleep(delayMicroseconds);
             elapsedMilliseconds += (float)delayMicroseconds / 1000;
@@ -276,6 +282,102 @@ TEST(ShaderCacheTest, testWriteAndRead) {
     ASSERT_NO_FATAL_FAILURE(deleteFileAssertSuccess(cacheFile2));
 }
 
+TEST(ShaderCacheTest, testWarmupKeys) {
+    if (!folderExist(getExternalStorageFolder())) {
+        // don't run the test if external storage folder is not available
+        return;
+    }
+    std::string cacheFile = getExternalStorageFolder() + "/shaderCacheTestWarmup";
+    ASSERT_NO_FATAL_FAILURE(deleteFileAssertSuccess(cacheFile));
+
+    ShaderCacheTestUtils::reinitializeAllFields(ShaderCache::get());
+    ShaderCache::get().setFilename(cacheFile.c_str());
+    ShaderCacheTestUtils::setSaveDelayMs(ShaderCache::get(), 0);  // disable deferred save
+    ShaderCache::get().initShaderDiskCache();
+    ASSERT_TRUE(ShaderCache::get().getWarmupKeys().empty());
+
+    // keys loaded in the first frames are recorded in first use order, once
+    ShaderCache::get().load(GrProgramDescTest(2));
+    ShaderCache::get().load(GrProgramDescTest(1));
+    ShaderCache::get().load(GrProgramDescTest(2));
+    for (int i = 0; i < ShaderCache::kWarmupFrameCount; i++) {
+        ShaderCache::get().onFrameCompleted();
+    }
+    // keys loaded later are not
+    ShaderCache::get().load(GrProgramDescTest(3));
+    ShaderCache::get().onFrameCompleted();
+
+    ShaderCacheTestUtils::terminate(ShaderCache::get(), true);
+    ShaderCacheTestUtils::reinitializeAllFields(ShaderCache::get());
+    ShaderCache::get().setFilename(cacheFile.c_str());
+    ShaderCacheTestUtils::setSaveDelayMs(ShaderCache::get(), 0);
+    ShaderCache::get().initShaderDiskCache();
+    auto keys = ShaderCache::get().getWarmupKeys();
+    ASSERT_EQ(2u, keys.size());
+    ASSERT_TRUE(keys[0]->equals(&GrProgramDescTest(2)));
+    ASSERT_TRUE(keys[1]->equals(&GrProgramDescTest(1)));
+
+    ShaderCacheTestUtils::terminate(ShaderCache::get(), false);
+    ShaderCacheTestUtils::reinitializeAllFields(ShaderCache::get());
+    ASSERT_NO_FATAL_FAILURE(deleteFileAssertSuccess(cacheFile));
+}
+
+TEST(ShaderCacheTest, testSharedCache) {
+    if (!folderExist(getExternalStorageFolder())) {
+        // don't run the test if external storage folder is not available
+        return;
+    }
+    std::string cacheFile = getExternalStorageFolder() + "/shaderCacheTestApp";
+    std::string sharedCacheFile = getExternalStorageFolder() + "/shaderCacheTestShared";
+    ASSERT_NO_FATAL_FAILURE(deleteFileAssertSuccess(cacheFile));
+    ASSERT_NO_FATAL_FAILURE(deleteFileAssertSuccess(sharedCacheFile));
+
+    // export the shaders stored by a first process to a shared cache
+    ShaderCacheTestUtils::reinitializeAllFields(ShaderCache::get());
+    ShaderCache::get().setFilename(cacheFile.c_str());
+    ShaderCacheTestUtils::setSaveDelayMs(ShaderCache::get(), 0);  // disable deferred save
+    ShaderCache::get().initShaderDiskCache();
+    ShaderCache::get().startSharedCacheExport();
+    sk_sp<SkData> inVS;
+    setShader(inVS, "ripple");
+    ShaderCache::get().store(GrProgramDescTest(1), *inVS.get(), SkString());
+    setShader(inVS, "shadow");
+    ShaderCache::get().store(GrProgramDescTest(2), *inVS.get(), SkString());
+    ASSERT_TRUE(ShaderCache::get().exportSharedCache(sharedCacheFile));
+    ShaderCacheTestUtils::terminate(ShaderCache::get(), false);
+    ASSERT_NO_FATAL_FAILURE(deleteFileAssertSuccess(cacheFile));
+
+    // a second process with an empty cache finds them in the shared cache
+    ShaderCacheTestUtils::reinitializeAllFields(ShaderCache::get());
+    ShaderCache::get().setFilename(cacheFile.c_str());
+    ShaderCache::get().setSharedFilename(sharedCacheFile.c_str());
+    ShaderCacheTestUtils::setSaveDelayMs(ShaderCache::get(), 0);
+    ShaderCache::get().initShaderDiskCache();
+    const uint64_t sharedHits = ShaderCache::get().getLoadCounters().sharedHits;
+    sk_sp<SkData> outVS;
+    ASSERT_NE((outVS = ShaderCache::get().load(GrProgramDescTest(1))), sk_sp<SkData>());
+    ASSERT_TRUE(checkShader(outVS, "ripple"));
+    ASSERT_NE((outVS = ShaderCache::get().load(GrProgramDescTest(2))), sk_sp<SkData>());
+    ASSERT_TRUE(checkShader(outVS, "shadow"));
+    ASSERT_EQ(ShaderCache::get().load(GrProgramDescTest(3)), sk_sp<SkData>());
+    ASSERT_EQ(ShaderCache::get().getLoadCounters().sharedHits, sharedHits + 2);
+    ShaderCacheTestUtils::terminate(ShaderCache::get(), false);
+
+    // the shared cache is ignored if it was built for another identity
+    ShaderCacheTestUtils::reinitializeAllFields(ShaderCache::get());
+    ShaderCache::get().setFilename(cacheFile.c_str());
+    ShaderCache::get().setSharedFilename(sharedCacheFile.c_str());
+    ShaderCacheTestUtils::setSaveDelayMs(ShaderCache::get(), 0);
+    std::vector<uint8_t> identity{1, 2, 3};
+    ShaderCache::get().initShaderDiskCache(identity.data(), identity.size());
+    ASSERT_EQ(ShaderCache::get().load(GrProgramDescTest(1)), sk_sp<SkData>());
+
+    ShaderCacheTestUtils::terminate(ShaderCache::get(), false);
+    ShaderCacheTestUtils::reinitializeAllFields(ShaderCache::get());
+    ASSERT_NO_FATAL_FAILURE(deleteFileAssertSuccess(cacheFile));
+    ASSERT_NO_FATAL_FAILURE(deleteFileAssertSuccess(sharedCacheFile));
+}
+
 TEST(ShaderCacheTest, testCacheValidation) {
     if (!folderExist(getExternalStorageFolder())) {
         // don't run the test if external storage folder is not available
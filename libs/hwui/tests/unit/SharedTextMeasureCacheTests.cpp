@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "hwui/MinikinUtils.h"
+#include "hwui/Paint.h"
+#include "hwui/SharedTextMeasureCache.h"
+
+using namespace android;
+
+namespace {
+
+const std::vector<uint16_t> kText = {'1', '2', ':', '3', '4'};
+
+std::optional<SharedTextMeasureCache::Key> makeKey(const Paint& paint, size_t bufSize) {
+    return SharedTextMeasureCache::get().makeKey(
+            MinikinUtils::prepareMinikinPaint(&paint, nullptr), minikin::Bidi::LTR,
+            minikin::StartHyphenEdit::NO_EDIT, minikin::EndHyphenEdit::NO_EDIT,
+            minikin::RunFlag::NONE, bufSize, 0, bufSize);
+}
+
+float measure(const Paint& paint, std::vector<float>* advances) {
+    advances->resize(kText.size());
+    return MinikinUtils::measureText(&paint, minikin::Bidi::LTR, nullptr, kText.data(), 0,
+                                     kText.size(), kText.size(), advances->data(), nullptr,
+                                     nullptr);
+}
+
+}  // namespace
+
+TEST(SharedTextMeasureCache, makeKey) {
+    Paint paint;
+    paint.getSkFont().setSize(42);
+    auto key = makeKey(paint, kText.size());
+    ASSERT_TRUE(key.has_value());
+    EXPECT_TRUE(*key == *makeKey(paint, kText.size()));
+
+    Paint bigger;
+    bigger.getSkFont().setSize(43);
+    EXPECT_FALSE(*key == *makeKey(bigger, kText.size()));
+
+    EXPECT_FALSE(makeKey(paint, SharedTextMeasureCache::kMaxTextLength + 1).has_value());
+}
+
+TEST(SharedTextMeasureCache, recordAndMap) {
+    SharedTextMeasureCache& cache = SharedTextMeasureCache::get();
+    Paint paint;
+    paint.getSkFont().setSize(42);
+
+    std::vector<float> expectedAdvances;
+    cache.setRecording(true);
+    const float expected = measure(paint, &expectedAdvances);
+    cache.setRecording(false);
+
+    TemporaryFile file;
+    ASSERT_TRUE(cache.writeRecorded(file.fd));
+    ASSERT_TRUE(cache.map(file.fd));
+
+    auto key = makeKey(paint, kText.size());
+    ASSERT_TRUE(key.has_value());
+    std::vector<float> advances(kText.size());
+    auto measurement = cache.find(*key, kText.data(), advances.data());
+    ASSERT_TRUE(measurement.has_value());
+    EXPECT_EQ(expected, measurement->advance);
+    EXPECT_EQ(expectedAdvances, advances);
+
+    // Served from the file.
+    EXPECT_EQ(expected, measure(paint, &advances));
+    EXPECT_EQ(expectedAdvances, advances);
+
+    const std::vector<uint16_t> otherText = {'1', '2', ':', '3', '5'};
+    EXPECT_FALSE(cache.find(*key, otherText.data(), advances.data()).has_value());
+
+    cache.unmap();
+    EXPECT_FALSE(cache.find(*key, kText.data(), advances.data()).has_value());
+}
+
+TEST(SharedTextMeasureCache, rejectsInvalidFile) {
+    SharedTextMeasureCache& cache = SharedTextMeasureCache::get();
+    TemporaryFile file;
+    ASSERT_TRUE(base::WriteStringToFd(std::string(1024, 'x'), file.fd));
+    EXPECT_FALSE(cache.map(file.fd));
+    EXPECT_FALSE(cache.isActive());
+}
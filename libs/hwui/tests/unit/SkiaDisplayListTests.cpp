@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <SkSurface.h>
 #include <VectorDrawable.h>
 #include <gtest/gtest.h>
 
@@ -95,6 +96,45 @@ TEST(SkiaDisplayList, reuseDisplayList) {
     ASSERT_EQ(availableList.get(), nullptr);
 }
 
+TEST(SkiaDisplayList, quickRejectRunsOutsideOfClip) {
+    std::unique_ptr<SkiaDisplayList> skiaDL;
+    {
+        SkiaRecordingCanvas canvas{nullptr, 200, 400};
+        Paint paint;
+        for (int i = 0; i < 40; i++) {
+            canvas.drawRect(0, i * 10, 200, i * 10 + 10, paint);
+        }
+        skiaDL = canvas.finishRecording();
+    }
+    // 40 ops form runs of 16, 16 and 8 ops.
+    ASSERT_EQ(3u, skiaDL->mDisplayList.indexedRunCount());
+
+    auto surface = SkSurfaces::Raster(SkImageInfo::MakeN32Premul(200, 400));
+    surface->getCanvas()->clipRect(SkRect::MakeWH(200, 20));
+    const auto before = DisplayListData::getQuickRejectCounters();
+    const uint64_t replayedBefore = DisplayListData::getReplayedOpCount();
+    skiaDL->draw(surface->getCanvas());
+    const auto after = DisplayListData::getQuickRejectCounters();
+
+    // Only the first run intersects the clip.
+    EXPECT_EQ(24u, after.skippedOps - before.skippedOps);
+    EXPECT_LE(16u, after.drawnOps - before.drawnOps);
+    EXPECT_EQ(after.drawnOps - before.drawnOps,
+              DisplayListData::getReplayedOpCount() - replayedBefore);
+
+    // A list that is too short isn't indexed at all, all of its ops are replayed.
+    SkiaRecordingCanvas shortCanvas{nullptr, 200, 400};
+    Paint paint;
+    shortCanvas.drawRect(0, 0, 10, 10, paint);
+    shortCanvas.drawRect(0, 20, 10, 30, paint);
+    auto shortDL = shortCanvas.finishRecording();
+    EXPECT_EQ(0u, shortDL->mDisplayList.indexedRunCount());
+    const uint64_t shortReplayedBefore = DisplayListData::getReplayedOpCount();
+    shortDL->draw(surface->getCanvas());
+    EXPECT_EQ(shortDL->mDisplayList.opCount(),
+              DisplayListData::getReplayedOpCount() - shortReplayedBefore);
+}
+
 TEST(SkiaDisplayList, syncContexts) {
     SkiaDisplayList skiaDL;
 
@@ -28,6 +28,7 @@
 #include <SkShader.h>
 
 #include <functional>
+#include <string>
 
 namespace android {
 namespace uirenderer {
@@ -312,6 +313,77 @@ TEST(PathParser, parseAsciiStringForSkPath) {
     }
 }
 
+TEST(PathParser, parseFloatsLikeStrtof) {
+    // Numbers on both sides of the fast path, which must round exactly like strtof().
+    static const char* sNumbers[] = {
+            "0",        "-0",         "1",          "0.1",      "-.5",     "3.14159",
+            "16777216", "16777217",   "123456.789", "1e10",     "1e11",    "1.5e-10",
+            "2.5E-3",   "0.00000001", "1.000000",   "100.0100", "7e+2",    "1.",
+            "+2",       "0.3",        "0.7",        "1e-45",    "3.4e38",  "-1234567",
+    };
+    for (const char* number : sNumbers) {
+        const std::string path = std::string("M") + number + " " + number;
+        PathParser::ParseResult result;
+        PathData pathData;
+        PathParser::getPathDataFromAsciiString(&pathData, &result, path.c_str(), path.size());
+        ASSERT_FALSE(result.failureOccurred) << number;
+        ASSERT_EQ(2u, pathData.points.size()) << number;
+        const float expected = strtof(number, nullptr);
+        EXPECT_EQ(0, memcmp(&expected, &pathData.points[0], sizeof(float))) << number;
+        EXPECT_EQ(0, memcmp(&expected, &pathData.points[1], sizeof(float))) << number;
+    }
+}
+
+TEST(PathParser, parseLongString) {
+    // Long enough for the commands to be searched 16 characters at a time.
+    static const char* sPath = "M 10.5 20.25 L 30.125 40.0625 L 50 60 e 1 Z m 1e2 2E-1 h 100 z";
+    PathParser::ParseResult result;
+    PathData pathData;
+    PathParser::getPathDataFromAsciiString(&pathData, &result, sPath, strlen(sPath));
+    EXPECT_TRUE(result.failureOccurred);
+
+    static const char* sValidPath = "M 10.5 20.25 L 30.125 40.0625 L 50 60 Z m 1e2 2E-1 h 100 z";
+    result = PathParser::ParseResult();
+    PathParser::getPathDataFromAsciiString(&pathData, &result, sValidPath, strlen(sValidPath));
+    ASSERT_FALSE(result.failureOccurred);
+    EXPECT_EQ((std::vector<char>{'M', 'L', 'L', 'Z', 'm', 'h', 'z'}), pathData.verbs);
+    EXPECT_EQ((std::vector<size_t>{2, 2, 2, 0, 2, 1, 0}), pathData.verbSizes);
+    EXPECT_EQ((std::vector<float>{10.5, 20.25, 30.125, 40.0625, 50, 60, 100, 0.2f, 100}),
+              pathData.points);
+}
+
+TEST(PathParser, cache) {
+    PathParser::clearCache();
+    for (int i = 0; i < 2; i++) {
+        for (const TestData& testData : sTestDataSet) {
+            PathParser::ParseResult result;
+            size_t length = strlen(testData.pathString);
+            PathData pathData;
+            PathParser::getPathDataFromAsciiStringCached(&pathData, &result, testData.pathString,
+                                                         length);
+            EXPECT_EQ(testData.pathData, pathData);
+
+            PathParser::ParseResult pathResult;
+            SkPath actualPath;
+            SkPath expectedPath;
+            testData.skPathLamda(&expectedPath);
+            PathParser::parseAsciiStringForSkPathCached(&actualPath, &pathResult,
+                                                        testData.pathString, length);
+            EXPECT_EQ(expectedPath, actualPath);
+        }
+
+        // Failures aren't cached.
+        for (StringPath stringPath : sStringPaths) {
+            PathParser::ParseResult result;
+            SkPath skPath;
+            PathParser::parseAsciiStringForSkPathCached(&skPath, &result, stringPath.stringPath,
+                                                        strlen(stringPath.stringPath));
+            EXPECT_EQ(stringPath.isValid, !result.failureOccurred);
+        }
+    }
+    PathParser::clearCache();
+}
+
 TEST(VectorDrawableUtils, morphPathData) {
     for (const TestData& fromData : sTestDataSet) {
         for (const TestData& toData : sTestDataSet) {
@@ -415,5 +487,72 @@ TEST(VectorDrawable, drawPathWithoutIncrementingShaderRefCount) {
     EXPECT_TRUE(shader->unique());
 }
 
+TEST(VectorDrawable, rasterDirty) {
+    VectorDrawable::Group* group = new VectorDrawable::Group();
+    VectorDrawable::FullPath* first = new VectorDrawable::FullPath("M0 0h5v10h-5z", 13);
+    VectorDrawable::FullPath* second = new VectorDrawable::FullPath("M5 0h5v10h-5z", 13);
+    group->addChild(first);
+    group->addChild(second);
+    EXPECT_EQ(2, group->countPaths(10));
+    EXPECT_EQ(1, group->countPaths(1));
+
+    // Nodes are dirty until they are first drawn.
+    EXPECT_TRUE(group->isRasterDirty());
+    group->syncProperties();
+    group->clearRasterDirty();
+    EXPECT_FALSE(group->isRasterDirty());
+
+    // Staging properties only affect the rasterization once they are synced.
+    first->mutateStagingProperties()->setFillColor(SK_ColorRED);
+    EXPECT_FALSE(group->isRasterDirty());
+    group->syncProperties();
+    EXPECT_TRUE(group->isRasterDirty());
+    EXPECT_FALSE(group->arePropertiesRasterDirty());
+    EXPECT_TRUE(first->isRasterDirty());
+    EXPECT_FALSE(second->isRasterDirty());
+
+    group->clearRasterDirty();
+    group->mutateProperties()->setRotation(90);
+    EXPECT_TRUE(group->arePropertiesRasterDirty());
+    EXPECT_FALSE(first->isRasterDirty());
+}
+
+TEST(VectorDrawable, updateLayers) {
+    VectorDrawable::Group* group = new VectorDrawable::Group();
+    VectorDrawable::FullPath* left = new VectorDrawable::FullPath("M0 0h5v10h-5z", 13);
+    VectorDrawable::FullPath* right = new VectorDrawable::FullPath("M5 0h5v10h-5z", 13);
+    left->mutateStagingProperties()->setFillColor(SK_ColorRED);
+    right->mutateStagingProperties()->setFillColor(SK_ColorBLUE);
+    group->addChild(left);
+    group->addChild(right);
+    sp<VectorDrawableRoot> tree(new VectorDrawableRoot(group));
+    tree->mutateStagingProperties()->setViewportSize(10, 10);
+    tree->mutateStagingProperties()->setScaledSize(10, 10);
+    tree->syncProperties();
+
+    SkBitmap bitmap;
+    tree->getBitmapUpdateIfDirty().getSkBitmap(&bitmap);
+    EXPECT_EQ(SK_ColorRED, bitmap.getColor(2, 5));
+    EXPECT_EQ(SK_ColorBLUE, bitmap.getColor(7, 5));
+
+    // Animating one path rasterizes it in a layer of its own, composited with the other.
+    left->mutateProperties()->setFillColor(SK_ColorGREEN);
+    EXPECT_TRUE(tree->isDirty());
+    tree->getBitmapUpdateIfDirty().getSkBitmap(&bitmap);
+    EXPECT_EQ(SK_ColorGREEN, bitmap.getColor(2, 5));
+    EXPECT_EQ(SK_ColorBLUE, bitmap.getColor(7, 5));
+
+    right->mutateProperties()->setFillAlpha(0);
+    tree->getBitmapUpdateIfDirty().getSkBitmap(&bitmap);
+    EXPECT_EQ(SK_ColorGREEN, bitmap.getColor(2, 5));
+    EXPECT_EQ(SK_ColorTRANSPARENT, bitmap.getColor(7, 5));
+
+    // The matrix of the root group applies to all the layers.
+    group->mutateProperties()->setTranslateX(5);
+    tree->getBitmapUpdateIfDirty().getSkBitmap(&bitmap);
+    EXPECT_EQ(SK_ColorTRANSPARENT, bitmap.getColor(2, 5));
+    EXPECT_EQ(SK_ColorGREEN, bitmap.getColor(7, 5));
+}
+
 }  // namespace uirenderer
 }  // namespace android
@@ -18,6 +18,7 @@
 
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <array>
 
 namespace android {
@@ -65,6 +66,10 @@ void CommonPool::post(Task&& task) {
     instance().enqueue(std::move(task));
 }
 
+void CommonPool::postBackground(Task&& task, nsecs_t delay) {
+    instance().enqueueBackground(std::move(task), delay);
+}
+
 std::vector<int> CommonPool::getThreadIds() {
     return instance().mWorkerThreadIds;
 }
@@ -77,7 +82,20 @@ void CommonPool::enqueue(Task&& task) {
         lock.lock();
     }
     mWorkQueue.push(std::move(task));
-    if (mWaitingThreads == THREAD_COUNT || (mWaitingThreads > 0 && mWorkQueue.size() > 1)) {
+    // The busy worker picks the work up once it's done, unless it's busy with a background task
+    // which could take a while.
+    if (mWaitingThreads == THREAD_COUNT ||
+        (mWaitingThreads > 0 && (mWorkQueue.size() > 1 || mRunningBackgroundTask))) {
+        mCondition.notify_one();
+    }
+}
+
+void CommonPool::enqueueBackground(Task&& task, nsecs_t delay) {
+    std::unique_lock lock(mLock);
+    mBackgroundQueue.push_back({Clock::now() + std::chrono::nanoseconds(delay), std::move(task)});
+    std::push_heap(mBackgroundQueue.begin(), mBackgroundQueue.end());
+    // The waiting workers may be waiting for a later background task.
+    if (mWaitingThreads > 0) {
         mCondition.notify_one();
     }
 }
@@ -85,11 +103,6 @@ void CommonPool::enqueue(Task&& task) {
 void CommonPool::workerLoop() {
     std::unique_lock lock(mLock);
     while (true) {
-        if (!mWorkQueue.hasWork()) {
-            mWaitingThreads++;
-            mCondition.wait(lock);
-            mWaitingThreads--;
-        }
         // Need to double-check that work is still available now that we have the lock
         // It may have already been grabbed by a different thread
         while (mWorkQueue.hasWork()) {
@@ -98,6 +111,33 @@ void CommonPool::workerLoop() {
             work();
             lock.lock();
         }
+        const bool canRunBackgroundTask = !mRunningBackgroundTask && !mBackgroundQueue.empty();
+        if (canRunBackgroundTask && mBackgroundQueue.front().runAt <= Clock::now()) {
+            std::pop_heap(mBackgroundQueue.begin(), mBackgroundQueue.end());
+            Task work = std::move(mBackgroundQueue.back().task);
+            mBackgroundQueue.pop_back();
+            mRunningBackgroundTask = true;
+            lock.unlock();
+            work();
+            // Releases what the task holds on to before it counts as done.
+            work = nullptr;
+            lock.lock();
+            mRunningBackgroundTask = false;
+            if (!mBackgroundQueue.empty() && mWaitingThreads > 0) {
+                // The other workers may have been waiting for this one to finish.
+                mCondition.notify_one();
+            }
+            continue;
+        }
+        mWaitingThreads++;
+        if (canRunBackgroundTask) {
+            // The heap may change while waiting.
+            const Clock::time_point runAt = mBackgroundQueue.front().runAt;
+            mCondition.wait_until(lock, runAt);
+        } else {
+            mCondition.wait(lock);
+        }
+        mWaitingThreads--;
     }
 }
 
@@ -18,7 +18,9 @@
 #define FRAMEWORKS_BASE_COMMONPOOL_H
 
 #include <log/log.h>
+#include <utils/Timers.h>
 
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <future>
@@ -84,6 +86,13 @@ public:
 
     static void post(Task&& func);
 
+    /**
+     * Runs func on a worker after delay, once there is no work posted with post() left. At most
+     * one worker runs these tasks at a time, so that they never hold up the work that a frame is
+     * waiting on. For work that nothing waits on, like writing caches to disk.
+     */
+    static void postBackground(Task&& func, nsecs_t delay = 0);
+
     template <class F>
     static auto async(F&& func) -> std::future<decltype(func())> {
         typedef std::packaged_task<decltype(func())()> task_t;
@@ -110,7 +119,17 @@ private:
     CommonPool();
     ~CommonPool();
 
+    using Clock = std::chrono::steady_clock;
+
+    struct BackgroundTask {
+        Clock::time_point runAt;
+        Task task;
+        // Orders the heap of background tasks by their time, earliest first.
+        bool operator<(const BackgroundTask& other) const { return runAt > other.runAt; }
+    };
+
     void enqueue(Task&&);
+    void enqueueBackground(Task&&, nsecs_t delay);
     void doWaitForIdle();
 
     void workerLoop();
@@ -121,6 +140,9 @@ private:
     std::condition_variable mCondition;
     int mWaitingThreads = 0;
     ArrayQueue<Task, QUEUE_SIZE> mWorkQueue;
+    // A heap, see BackgroundTask::operator<.
+    std::vector<BackgroundTask> mBackgroundQueue;
+    bool mRunningBackgroundTask = false;
 };
 
 }  // namespace uirenderer
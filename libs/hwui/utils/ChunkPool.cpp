@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utils/ChunkPool.h"
+
+#include <log/log.h>
+#include <stdlib.h>
+
+#include <new>
+
+namespace android {
+namespace uirenderer {
+
+ChunkPool& ChunkPool::get() {
+    // Never destroyed, display lists may still be released during static destruction.
+    static ChunkPool* sPool = new ChunkPool();
+    return *sPool;
+}
+
+size_t ChunkPool::chunkSize(size_t size) {
+    if (size > kMaxChunkSize) {
+        return size;
+    }
+    size_t chunkSize = kMinChunkSize;
+    while (chunkSize < size) {
+        chunkSize <<= 1;
+    }
+    return chunkSize;
+}
+
+int ChunkPool::sizeClass(size_t size) {
+    if (size < kMinChunkSize || size > kMaxChunkSize || (size & (size - 1))) {
+        return -1;
+    }
+    int sizeClass = 0;
+    for (size_t chunkSize = kMinChunkSize; chunkSize < size; chunkSize <<= 1) {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+void* ChunkPool::acquire(size_t size) {
+    const int index = sizeClass(size);
+    if (index >= 0) {
+        std::lock_guard lock(mLock);
+        if (FreeChunk* chunk = mFreeChunks[index]) {
+            mFreeChunks[index] = chunk->next;
+            mCachedBytes -= size;
+            mRecycledChunks++;
+            return chunk;
+        }
+        mAllocatedChunks++;
+    }
+    void* chunk = malloc(size);
+    LOG_ALWAYS_FATAL_IF(chunk == nullptr, "malloc(%zu) failed", size);
+    return chunk;
+}
+
+void ChunkPool::release(void* chunk, size_t size) {
+    if (!chunk) {
+        return;
+    }
+    const int index = sizeClass(size);
+    if (index >= 0) {
+        std::lock_guard lock(mLock);
+        if (mCachedBytes + size <= kMaxCachedBytes) {
+            auto freeChunk = new (chunk) FreeChunk{mFreeChunks[index]};
+            mFreeChunks[index] = freeChunk;
+            mCachedBytes += size;
+            return;
+        }
+    }
+    free(chunk);
+}
+
+void ChunkPool::trim() {
+    std::array<FreeChunk*, kClassCount> freeChunks;
+    {
+        std::lock_guard lock(mLock);
+        freeChunks = mFreeChunks;
+        mFreeChunks.fill(nullptr);
+        mCachedBytes = 0;
+    }
+    for (FreeChunk* chunk : freeChunks) {
+        while (chunk) {
+            FreeChunk* next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+    }
+}
+
+ChunkPool::Stats ChunkPool::getStats() {
+    std::lock_guard lock(mLock);
+    return Stats{mCachedBytes, mRecycledChunks, mAllocatedChunks};
+}
+
+}  // namespace uirenderer
+}  // namespace android
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <mutex>
+
+namespace android {
+namespace uirenderer {
+
+/**
+ * A pool of recycled memory chunks for the recording buffers of display lists, i.e. the op
+ * buffer of DisplayListData and the pages of LinearAllocator. Views that record a new display
+ * list every frame then reuse the chunks of the display list they replace instead of going through
+ * malloc every frame.
+ *
+ * Chunks come in power of two size classes between kMinChunkSize and kMaxChunkSize. Other sizes
+ * and chunks beyond kMaxCachedBytes go straight to malloc and free. Display lists are recorded on
+ * the UI thread and mostly destroyed on the RenderThread, so there is a single, locked pool per
+ * process, shared with its RenderThread.
+ */
+class ChunkPool {
+public:
+    static constexpr size_t kMinChunkSize = 512;
+    static constexpr size_t kMaxChunkSize = 128 * 1024;
+    static constexpr size_t kMaxCachedBytes = 2 * 1024 * 1024;
+
+    static ChunkPool& get();
+
+    /**
+     * Returns the size of the chunk that should be acquired to hold at least size bytes, which is
+     * size rounded up to its size class, or size itself if it is larger than kMaxChunkSize.
+     */
+    static size_t chunkSize(size_t size);
+
+    /**
+     * Returns a chunk of size bytes that was either recycled or newly allocated with malloc. It
+     * must be returned with release() and the same size, or with free().
+     */
+    void* acquire(size_t size);
+
+    void release(void* chunk, size_t size);
+
+    /**
+     * Frees all cached chunks.
+     */
+    void trim();
+
+    struct Stats {
+        size_t cachedBytes;
+        uint64_t recycledChunks;
+        uint64_t allocatedChunks;
+    };
+    Stats getStats();
+
+private:
+    static constexpr size_t kClassCount = 9;  // 512b to 128kb
+    static_assert(kMinChunkSize << (kClassCount - 1) == kMaxChunkSize);
+
+    struct FreeChunk {
+        FreeChunk* next;
+    };
+
+    ChunkPool() = default;
+
+    // Returns the size class of size, or -1 if chunks of that size aren't pooled.
+    static int sizeClass(size_t size);
+
+    std::mutex mLock;
+    std::array<FreeChunk*, kClassCount> mFreeChunks{};
+    size_t mCachedBytes = 0;
+    uint64_t mRecycledChunks = 0;
+    uint64_t mAllocatedChunks = 0;
+};
+
+}  // namespace uirenderer
+}  // namespace android
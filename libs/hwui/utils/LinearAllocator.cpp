@@ -31,6 +31,8 @@
 #include <utils/Log.h>
 #include <utils/Macros.h>
 
+#include "utils/ChunkPool.h"
+
 // The maximum amount of wasted space we can have per page
 // Allocations exceeding this will have their own dedicated page
 // If this is too low, we will malloc too much
@@ -80,7 +82,7 @@ public:
     Page* next() { return mNextPage; }
     void setNext(Page* next) { mNextPage = next; }
 
-    Page() : mNextPage(0) {}
+    explicit Page(size_t size) : mNextPage(0), mSize(size) {}
 
     void* operator new(size_t /*size*/, void* buf) { return buf; }
 
@@ -88,9 +90,13 @@ public:
 
     void* end(int pageSize) { return (void*)(((size_t)start()) + pageSize); }
 
+    // The size of the whole page including this header, which it is returned to the pool with.
+    size_t size() const { return mSize; }
+
 private:
     Page(const Page& /*other*/) {}
     Page* mNextPage;
+    size_t mSize;
 };
 
 LinearAllocator::LinearAllocator()
@@ -113,8 +119,9 @@ LinearAllocator::~LinearAllocator(void) {
     Page* p = mPages;
     while (p) {
         Page* next = p->next();
+        size_t size = p->size();
         p->~Page();
-        free(p);
+        ChunkPool::get().release(p, size);
         RM_ALLOCATION();
         p = next;
     }
@@ -157,7 +164,7 @@ void* LinearAllocator::allocImpl(size_t size) {
     if (size > mMaxAllocSize && !fitsInCurrentPage(size)) {
         ALOGV("Exceeded max size %zu > %zu", size, mMaxAllocSize);
         // Allocation is too large, create a dedicated page for the allocation
-        Page* page = newPage(size);
+        Page* page = newPage(size + sizeof(Page));
         mDedicatedPageCount++;
         page->setNext(mPages);
         mPages = page;
@@ -216,13 +223,16 @@ void LinearAllocator::rewindIfLastAlloc(void* ptr, size_t allocSize) {
     }
 }
 
+// pageSize includes the Page header. The pages between kInitialPageSize and kMaxPageSize are
+// exactly the size of a ChunkPool size class, so they are recycled when this allocator is
+// destroyed.
 LinearAllocator::Page* LinearAllocator::newPage(size_t pageSize) {
-    pageSize = ALIGN(pageSize + sizeof(LinearAllocator::Page));
+    pageSize = ALIGN(pageSize);
     ADD_ALLOCATION();
     mTotalAllocated += pageSize;
     mPageCount++;
-    void* buf = malloc(pageSize);
-    return new (buf) Page();
+    void* buf = ChunkPool::get().acquire(pageSize);
+    return new (buf) Page(pageSize);
 }
 
 static const char* toSize(size_t value, float& result) {
@@ -136,9 +136,12 @@ void SpriteController::doUpdateSprites() {
         }
     }
 
-    // Resize and/or reparent sprites if needed.
+    // Resize and/or reparent sprites if needed.  All the changes go into a single transaction,
+    // which is only applied ahead of the redraw if a resized surface had to be hidden first.
+    // Otherwise the reparenting goes out with the property changes below.
     SurfaceComposerClient::Transaction t;
     bool needApplyTransaction = false;
+    bool needApplyBeforeDraw = false;
     for (size_t i = 0; i < numSprites; i++) {
         SpriteUpdate& update = updates.editItemAt(i);
         if (update.state.surfaceControl == nullptr) {
@@ -151,8 +154,6 @@ void SpriteController::doUpdateSprites() {
             // TODO(b/331260947): investigate using a larger surface width with smaller sprites.
             if (update.state.surfaceWidth != desiredWidth ||
                 update.state.surfaceHeight != desiredHeight) {
-                needApplyTransaction = true;
-
                 update.state.surfaceControl->updateDefaultBufferSize(desiredWidth, desiredHeight);
                 update.state.surfaceWidth = desiredWidth;
                 update.state.surfaceHeight = desiredHeight;
@@ -162,6 +163,7 @@ void SpriteController::doUpdateSprites() {
                 if (update.state.surfaceVisible) {
                     t.hide(update.state.surfaceControl);
                     update.state.surfaceVisible = false;
+                    needApplyTransaction = needApplyBeforeDraw = true;
                 }
             }
         }
@@ -172,8 +174,9 @@ void SpriteController::doUpdateSprites() {
             needApplyTransaction = true;
         }
     }
-    if (needApplyTransaction) {
+    if (needApplyBeforeDraw) {
         t.apply();
+        needApplyTransaction = false;
     }
 
     // Redraw sprites if needed.
@@ -195,7 +198,6 @@ void SpriteController::doUpdateSprites() {
         }
     }
 
-    needApplyTransaction = false;
     for (size_t i = 0; i < numSprites; i++) {
         SpriteUpdate& update = updates.editItemAt(i);
 
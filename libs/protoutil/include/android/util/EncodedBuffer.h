@@ -69,9 +69,34 @@ public:
 
     /**
      * Clears the buffer by rewinding its write pointer to avoid de/allocate buffers in heap.
+     * It keeps its first chunk, the others go back to the chunk pool.
      */
     void clear();
 
+    /**
+     * The chunks that EncodedBuffers release are kept in a process wide pool, one list per
+     * chunk size, up to a capacity, so that the next buffers don't have to map new ones.
+     */
+    struct PoolStats {
+        size_t pooledBytes;     // The size of the chunks in the pool.
+        size_t capacity;        // How many bytes of chunks the pool may hold.
+        uint64_t reused;        // How many chunks were taken from the pool.
+        uint64_t mapped;        // How many chunks were mapped because the pool had none.
+        uint64_t unmapped;      // How many chunks were unmapped because the pool was full.
+    };
+
+    static PoolStats getPoolStats();
+
+    /**
+     * Sets how many bytes of chunks the pool may hold, unmapping the ones over it.
+     */
+    static void setPoolCapacity(size_t capacity);
+
+    /**
+     * Unmaps all of the chunks in the pool, for instance once a burst of work is done.
+     */
+    static void trimPool();
+
     /******************************** Write APIs ************************************************/
 
     /**
@@ -172,6 +197,11 @@ public:
      */
     void editRawFixed32(size_t pos, uint32_t val);
 
+    /**
+     * Edit 5 bytes starting at pos with val as a varint padded to that width.
+     */
+    void editRawPaddedVarint32(size_t pos, uint32_t val);
+
     /**
      * Copy _size_ bytes of data starting at __srcPos__ to wp, srcPos must be larger than wp.pos().
      */
@@ -26,6 +26,9 @@ namespace util {
 
 /**
  * A ProtoReader on top of a file descriptor.
+ *
+ * The rest of a regular file is mapped rather than read in chunks when it is larger than
+ * a chunk, so the whole of it is a single buffer and moving over data costs nothing.
  */
 class ProtoFileReader : public ProtoReader
 {
@@ -36,7 +39,7 @@ public:
     ProtoFileReader(int fd);
 
     /**
-     * Does NOT close the file.
+     * Does NOT close the file. Unmaps it if it was mapped.
      */
     virtual ~ProtoFileReader();
 
@@ -55,12 +58,20 @@ private:
     int mFd;                // File descriptor for input.
     status_t mStatus;       // Any errors encountered during read.
     ssize_t mSize;          // How much total data there is, or -1 if we can't tell.
-    size_t mPos;            // How much data has been read so far.
+    size_t mPos;            // How much data was in the buffers before the current one.
     size_t mOffset;         // Offset in current buffer.
-    size_t mMaxOffset;      // How much data is left to read in mBuffer.
+    size_t mMaxOffset;      // How much data is left to read in mData.
     const int mChunkSize;   // Size of mBuffer.
+    uint8_t const* mData;   // The current buffer, either mBuffer or in mMap.
+    void* mMap;             // The mapping of the file, or NULL if it is read in chunks.
+    size_t mMapSize;        // Size of mMap.
     uint8_t mBuffer[32*1024];
 
+    /**
+     * Maps the rest of the file in mData. Leaves it to be read in chunks if it can't.
+     */
+    void map_file();
+
     /**
      * If there is currently more data to read in the buffer, returns true.
      * If there is not more, then tries to read.  If more data can be read,
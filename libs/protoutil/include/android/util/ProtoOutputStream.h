@@ -105,6 +105,18 @@ public:
     bool write(uint64_t fieldId, std::string_view val);
     bool write(uint64_t fieldId, const char* val, size_t size);
 
+    /**
+     * Write APIs for the writers that protoc-gen-cppstream generates with its typed_writers
+     * option. key is the encoded tag of the field, (id << 3) | wire type, which the generator
+     * works out so that these don't switch on the field type. Returns true if the write succeeds.
+     */
+    bool writeVarintField(uint32_t key, uint64_t val);
+    bool writeFixed32Field(uint32_t key, uint32_t val);
+    bool writeFixed64Field(uint32_t key, uint64_t val);
+    bool writeFloatField(uint32_t key, float val);
+    bool writeDoubleField(uint32_t key, double val);
+    bool writeLengthDelimitedField(uint32_t key, const char* val, size_t size);
+
     /**
      * Starts a sub-message write session.
      * Returns a token of this write session.
@@ -131,13 +143,23 @@ public:
 
     /**
      * Clears the ProtoOutputStream so the buffer can be reused instead of deallocation/allocation again.
+     * The length encoding set by setReservedLengths is kept.
      */
     void clear();
 
+    /**
+     * Reserves a 5 byte varint for the length of each sub-message in start and fills it in on
+     * end, so the data never goes through a compaction pass. The output is valid protobuf but
+     * not canonical: the lengths are padded, which costs up to 4 bytes per sub-message.
+     * Must be called before anything is written. Returns false otherwise.
+     */
+    bool setReservedLengths(bool reserved);
+
     // Please don't use the following functions to dump protos unless you are familiar with protobuf encoding.
     void writeRawVarint(uint64_t varint);
     void writeLengthDelimitedHeader(uint32_t id, size_t size);
     void writeRawByte(uint8_t byte);
+    void writeRaw(uint8_t const* buf, size_t size);
 
 private:
     sp<EncodedBuffer> mBuffer;
@@ -146,6 +168,10 @@ private:
     uint32_t mDepth;
     uint32_t mObjectId;
     uint64_t mExpectedObjectToken;
+    bool mReservedLengths;
+    // The tokens of the enclosing objects when the lengths are reserved, since they can't be
+    // pushed into the buffer as placeholders.
+    std::vector<uint64_t> mTokenStack;
 
     inline void writeDoubleImpl(uint32_t id, double val);
     inline void writeFloatImpl(uint32_t id, float val);
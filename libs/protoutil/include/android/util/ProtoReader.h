@@ -70,6 +70,13 @@ public:
      * Advance the read pointer.
      */
     virtual void move(size_t amt) = 0;
+
+    /**
+     * Points span to the contiguous bytes at the read pointer, at most maxSize of them, and
+     * advances past them. Returns how many there are, 0 if it reaches end of buffer.
+     * The span stays valid until the next call on the reader.
+     */
+    size_t readSpan(size_t maxSize, uint8_t const** span);
 };
 
 } // util
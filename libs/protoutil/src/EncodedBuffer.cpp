@@ -19,6 +19,9 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include <map>
+#include <mutex>
+
 #include <android/util/EncodedBuffer.h>
 #include <android/util/protobuf.h>
 #include <cutils/log.h>
@@ -27,8 +30,108 @@ namespace android {
 namespace util {
 
 constexpr size_t BUFFER_SIZE = 8 * 1024; // 8 KB
+constexpr size_t DEFAULT_POOL_CAPACITY = 1024 * 1024; // 1 MB
 const size_t kPageSize = getpagesize();
 
+// ===========================================================
+namespace {
+
+struct ChunkPool {
+    std::mutex lock;
+    std::map<size_t, std::vector<uint8_t*>> chunks; // by chunk size
+    EncodedBuffer::PoolStats stats = {0, DEFAULT_POOL_CAPACITY, 0, 0, 0};
+};
+
+ChunkPool& chunk_pool()
+{
+    // Never destroyed, buffers may be released during exit.
+    static ChunkPool* pool = new ChunkPool();
+    return *pool;
+}
+
+uint8_t* obtain_chunk(size_t chunkSize)
+{
+    ChunkPool& pool = chunk_pool();
+    {
+        std::lock_guard<std::mutex> lock(pool.lock);
+        auto it = pool.chunks.find(chunkSize);
+        if (it != pool.chunks.end() && !it->second.empty()) {
+            uint8_t* chunk = it->second.back();
+            it->second.pop_back();
+            pool.stats.pooledBytes -= chunkSize;
+            pool.stats.reused++;
+            return chunk;
+        }
+        pool.stats.mapped++;
+    }
+    // Use mmap instead of malloc to ensure memory alignment i.e. no fragmentation so that
+    // the mem region can be immediately reused by the allocator after calling munmap()
+    void* chunk = mmap(NULL, chunkSize, PROT_READ | PROT_WRITE, MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
+    return chunk == MAP_FAILED ? NULL : (uint8_t*)chunk;
+}
+
+void release_chunk(uint8_t* chunk, size_t chunkSize)
+{
+    ChunkPool& pool = chunk_pool();
+    {
+        std::lock_guard<std::mutex> lock(pool.lock);
+        if (pool.stats.pooledBytes + chunkSize <= pool.stats.capacity) {
+            pool.chunks[chunkSize].push_back(chunk);
+            pool.stats.pooledBytes += chunkSize;
+            return;
+        }
+        pool.stats.unmapped++;
+    }
+    munmap(chunk, chunkSize);
+}
+
+// Unmaps chunks until the pool holds no more than capacity bytes.
+void trim_chunk_pool(size_t capacity)
+{
+    ChunkPool& pool = chunk_pool();
+    std::vector<std::pair<uint8_t*, size_t>> unmap;
+    {
+        std::lock_guard<std::mutex> lock(pool.lock);
+        for (auto& entry : pool.chunks) {
+            while (pool.stats.pooledBytes > capacity && !entry.second.empty()) {
+                unmap.emplace_back(entry.second.back(), entry.first);
+                entry.second.pop_back();
+                pool.stats.pooledBytes -= entry.first;
+            }
+        }
+    }
+    for (const auto& chunk : unmap) {
+        munmap(chunk.first, chunk.second);
+    }
+}
+
+} // namespace
+
+EncodedBuffer::PoolStats
+EncodedBuffer::getPoolStats()
+{
+    ChunkPool& pool = chunk_pool();
+    std::lock_guard<std::mutex> lock(pool.lock);
+    return pool.stats;
+}
+
+void
+EncodedBuffer::setPoolCapacity(size_t capacity)
+{
+    {
+        ChunkPool& pool = chunk_pool();
+        std::lock_guard<std::mutex> lock(pool.lock);
+        pool.stats.capacity = capacity;
+    }
+    trim_chunk_pool(capacity);
+}
+
+void
+EncodedBuffer::trimPool()
+{
+    trim_chunk_pool(0);
+}
+
 EncodedBuffer::Pointer::Pointer() : Pointer(BUFFER_SIZE)
 {
 }
@@ -102,8 +205,7 @@ EncodedBuffer::EncodedBuffer(size_t chunkSize)
 EncodedBuffer::~EncodedBuffer()
 {
     for (size_t i=0; i<mBuffers.size(); i++) {
-        uint8_t* buf = mBuffers[i];
-        munmap(buf, mChunkSize);
+        release_chunk(mBuffers[i], mChunkSize);
     }
 }
 
@@ -118,6 +220,10 @@ EncodedBuffer::clear()
 {
     mWp.rewind();
     mEp.rewind();
+    while (mBuffers.size() > 1) {
+        release_chunk(mBuffers.back(), mChunkSize);
+        mBuffers.pop_back();
+    }
 }
 
 /******************************** Write APIs ************************************************/
@@ -140,10 +246,7 @@ EncodedBuffer::writeBuffer()
     if (mWp.index() > mBuffers.size()) return NULL;
     uint8_t* buf = NULL;
     if (mWp.index() == mBuffers.size()) {
-        // Use mmap instead of malloc to ensure memory alignment i.e. no fragmentation so that
-        // the mem region can be immediately reused by the allocator after calling munmap()
-        buf = (uint8_t*)mmap(NULL, mChunkSize, PROT_READ | PROT_WRITE,
-                MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
+        buf = obtain_chunk(mChunkSize);
 
         if (buf == NULL) return NULL; // This indicates NO_MEMORY
 
@@ -334,6 +437,20 @@ EncodedBuffer::editRawFixed32(size_t pos, uint32_t val)
     mEp.rewind()->move(oldPos);
 }
 
+void
+EncodedBuffer::editRawPaddedVarint32(size_t pos, uint32_t val)
+{
+    size_t oldPos = mEp.pos();
+    mEp.rewind()->move(pos);
+    for (auto i=0; i<4; i++) {
+        *at(mEp) = (uint8_t) ((val & 0x7F) | 0x80);
+        mEp.move();
+        val >>= 7;
+    }
+    *at(mEp) = (uint8_t) val;
+    mEp.rewind()->move(oldPos);
+}
+
 void
 EncodedBuffer::copy(size_t srcPos, size_t size)
 {
@@ -21,6 +21,9 @@
 #include <cinttypes>
 #include <type_traits>
 
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 namespace android {
@@ -56,10 +59,19 @@ ProtoFileReader::ProtoFileReader(int fd)
          mPos(0),
          mOffset(0),
          mMaxOffset(0),
-         mChunkSize(sizeof(mBuffer)) {
+         mChunkSize(sizeof(mBuffer)),
+         mData(mBuffer),
+         mMap(NULL),
+         mMapSize(0) {
+    if (mSize > mChunkSize) {
+        map_file();
+    }
 }
 
 ProtoFileReader::~ProtoFileReader() {
+    if (mMap != NULL) {
+        munmap(mMap, mMapSize);
+    }
 }
 
 ssize_t
@@ -71,13 +83,13 @@ ProtoFileReader::size() const
 size_t
 ProtoFileReader::bytesRead() const
 {
-    return mPos;
+    return mPos + mOffset;
 }
 
 uint8_t const*
 ProtoFileReader::readBuffer()
 {
-    return hasNext() ? mBuffer + mOffset : NULL;
+    return hasNext() ? mData + mOffset : NULL;
 }
 
 size_t
@@ -99,7 +111,7 @@ ProtoFileReader::next()
         // Shouldn't get to here.  Always call hasNext() before calling next().
         return 0;
     }
-    return mBuffer[mOffset++];
+    return mData[mOffset++];
 }
 
 uint64_t
@@ -147,6 +159,10 @@ ProtoFileReader::ensure_data() {
     if (mOffset < mMaxOffset) {
         return true;
     }
+    if (mMap != NULL) {
+        // the whole file is in the one buffer.
+        return false;
+    }
     ssize_t amt = TEMP_FAILURE_RETRY(read(mFd, mBuffer, mChunkSize));
     if (amt == 0) {
         return false;
@@ -154,12 +170,43 @@ ProtoFileReader::ensure_data() {
         mStatus = -errno;
         return false;
     } else {
+        mPos += mMaxOffset;
         mOffset = 0;
         mMaxOffset = amt;
         return true;
     }
 }
 
+void
+ProtoFileReader::map_file() {
+    struct stat st;
+    if (fstat(mFd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return;
+    }
+    off_t current = lseek(mFd, 0, SEEK_CUR);
+    if (current < 0) {
+        return;
+    }
+    // mmap needs the offset to be aligned to a page.
+    off_t pageOffset = current % sysconf(_SC_PAGE_SIZE);
+    size_t mapSize = mSize + pageOffset;
+    void* map = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, mFd, current - pageOffset);
+    if (map == MAP_FAILED) {
+        ALOGW("ProtoFileReader can't map %zu bytes, reading them instead: %s", mapSize,
+                strerror(errno));
+        return;
+    }
+    madvise(map, mapSize, MADV_SEQUENTIAL);
+    // leave the file where a reader going through all of it would have.
+    lseek(mFd, mSize, SEEK_CUR);
+
+    mMap = map;
+    mMapSize = mapSize;
+    mData = static_cast<uint8_t const*>(map) + pageOffset;
+    mOffset = 0;
+    mMaxOffset = mSize;
+}
+
 
 } // util
 } // android
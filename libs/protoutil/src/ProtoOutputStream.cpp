@@ -36,7 +36,8 @@ ProtoOutputStream::ProtoOutputStream(sp<EncodedBuffer> buffer)
          mCompact(false),
          mDepth(0),
          mObjectId(0),
-         mExpectedObjectToken(UINT64_C(-1))
+         mExpectedObjectToken(UINT64_C(-1)),
+         mReservedLengths(false)
 {
 }
 
@@ -54,6 +55,18 @@ ProtoOutputStream::clear()
     mDepth = 0;
     mObjectId = 0;
     mExpectedObjectToken = UINT64_C(-1);
+    mTokenStack.clear();
+}
+
+bool
+ProtoOutputStream::setReservedLengths(bool reserved)
+{
+    if (mBuffer->size() != 0) {
+        ALOGE("Can't change the length encoding after writing %zu bytes.", mBuffer->size());
+        return false;
+    }
+    mReservedLengths = reserved;
+    return true;
 }
 
 template<typename T>
@@ -206,6 +219,60 @@ ProtoOutputStream::write(uint64_t fieldId, const char* val, size_t size)
     }
 }
 
+bool
+ProtoOutputStream::writeVarintField(uint32_t key, uint64_t val)
+{
+    if (mCompact) return false;
+    mBuffer->writeRawVarint32(key);
+    mBuffer->writeRawVarint64(val);
+    return true;
+}
+
+bool
+ProtoOutputStream::writeFixed32Field(uint32_t key, uint32_t val)
+{
+    if (mCompact) return false;
+    mBuffer->writeRawVarint32(key);
+    mBuffer->writeRawFixed32(val);
+    return true;
+}
+
+bool
+ProtoOutputStream::writeFixed64Field(uint32_t key, uint64_t val)
+{
+    if (mCompact) return false;
+    mBuffer->writeRawVarint32(key);
+    mBuffer->writeRawFixed64(val);
+    return true;
+}
+
+bool
+ProtoOutputStream::writeFloatField(uint32_t key, float val)
+{
+    if (mCompact) return false;
+    writeFloatImpl(key >> FIELD_ID_SHIFT, val);
+    return true;
+}
+
+bool
+ProtoOutputStream::writeDoubleField(uint32_t key, double val)
+{
+    if (mCompact) return false;
+    writeDoubleImpl(key >> FIELD_ID_SHIFT, val);
+    return true;
+}
+
+bool
+ProtoOutputStream::writeLengthDelimitedField(uint32_t key, const char* val, size_t size)
+{
+    if (mCompact) return false;
+    writeUtf8StringImpl(key >> FIELD_ID_SHIFT, val, size);
+    return true;
+}
+
+// The width of the varint reserved for the length of a sub-message, enough for any 32 bit size.
+static const size_t RESERVED_LENGTH_SIZE = 5;
+
 /**
  * Make a token.
  *  Bits 61-63 - tag size (So we can go backwards later if the object had not data)
@@ -264,7 +331,14 @@ ProtoOutputStream::start(uint64_t fieldId)
 
     mDepth++;
     mObjectId++;
-    mBuffer->writeRawFixed64(mExpectedObjectToken); // push previous token into stack.
+    if (mReservedLengths) {
+        mTokenStack.push_back(mExpectedObjectToken);
+        for (size_t i=0; i<RESERVED_LENGTH_SIZE; i++) {
+            mBuffer->writeRawByte(0); // filled in by end.
+        }
+    } else {
+        mBuffer->writeRawFixed64(mExpectedObjectToken); // push previous token into stack.
+    }
 
     mExpectedObjectToken = makeToken(sizePos - prevPos,
         (bool)(fieldId & FIELD_COUNT_REPEATED), mDepth, mObjectId, sizePos);
@@ -289,6 +363,19 @@ ProtoOutputStream::end(uint64_t token)
     mDepth--;
 
     uint32_t sizePos = getSizePosFromToken(token);
+    if (mReservedLengths) {
+        mExpectedObjectToken = mTokenStack.back();
+        mTokenStack.pop_back();
+
+        size_t childSize = mBuffer->wp()->pos() - sizePos - RESERVED_LENGTH_SIZE;
+        if (childSize > 0) {
+            mBuffer->editRawPaddedVarint32(sizePos, childSize);
+        } else {
+            mBuffer->wp()->rewind()->move(sizePos - getTagSizeFromToken(token));
+        }
+        return;
+    }
+
     // number of bytes written in this start-end session.
     int childRawSize = mBuffer->wp()->pos() - sizePos - 8;
 
@@ -319,6 +406,11 @@ ProtoOutputStream::compact() {
         ALOGE("Can't compact when depth(%" PRIu32 ") is not zero. Missing or extra calls to end.", mDepth);
         return false;
     }
+    if (mReservedLengths) {
+        // the lengths were all filled in by end.
+        mCompact = true;
+        return true;
+    }
     // record the size of the original buffer.
     size_t rawBufferSize = mBuffer->size();
     if (rawBufferSize == 0) return true; // nothing to do if the buffer is empty;
@@ -533,6 +625,10 @@ void
 ProtoOutputStream::writeLengthDelimitedHeader(uint32_t id, size_t size)
 {
     mBuffer->writeHeader(id, WIRE_TYPE_LENGTH_DELIMITED);
+    if (mReservedLengths) {
+        mBuffer->writeRawVarint32(size);
+        return;
+    }
     // reserves 64 bits for length delimited fields, if first field is negative, compact it.
     mBuffer->writeRawFixed32(size);
     mBuffer->writeRawFixed32(size);
@@ -544,6 +640,12 @@ ProtoOutputStream::writeRawByte(uint8_t byte)
     mBuffer->writeRawByte(byte);
 }
 
+void
+ProtoOutputStream::writeRaw(uint8_t const* buf, size_t size)
+{
+    mBuffer->writeRaw(buf, size);
+}
+
 
 // =========================================================================
 // Private functions
@@ -661,9 +763,7 @@ ProtoOutputStream::writeUtf8StringImpl(uint32_t id, const char* val, size_t size
 {
     if (val == NULL) return;
     writeLengthDelimitedHeader(id, size);
-    for (size_t i=0; i<size; i++) {
-        mBuffer->writeRawByte((uint8_t)val[i]);
-    }
+    mBuffer->writeRaw(reinterpret_cast<uint8_t const*>(val), size);
 }
 
 inline void
@@ -671,9 +771,7 @@ ProtoOutputStream::writeMessageBytesImpl(uint32_t id, const char* val, size_t si
 {
     if (val == NULL) return;
     writeLengthDelimitedHeader(id, size);
-    for (size_t i=0; i<size; i++) {
-        mBuffer->writeRawByte(val[i]);
-    }
+    mBuffer->writeRaw(reinterpret_cast<uint8_t const*>(val), size);
 }
 
 } // util
@@ -26,5 +26,21 @@ ProtoReader::ProtoReader() {
 ProtoReader::~ProtoReader() {
 }
 
+size_t
+ProtoReader::readSpan(size_t maxSize, uint8_t const** span)
+{
+    uint8_t const* buf = readBuffer();
+    if (buf == NULL) {
+        return 0;
+    }
+    size_t amt = currentToRead();
+    if (amt > maxSize) {
+        amt = maxSize;
+    }
+    move(amt);
+    *span = buf;
+    return amt;
+}
+
 } // util
 } // android
@@ -154,3 +154,57 @@ TEST(EncodedBufferTest, ReadVarint) {
     EXPECT_EQ(reader->size(), len);
     EXPECT_EQ(reader->readRawVarint(), val);
 }
+
+TEST(EncodedBufferTest, ReusesPooledChunks) {
+    EncodedBuffer::trimPool();
+    {
+        sp<EncodedBuffer> buffer = new EncodedBuffer(TEST_CHUNK_SIZE);
+        for (size_t i = 0; i < TEST_CHUNK_3X_SIZE; i++) {
+            buffer->writeRawByte(i);
+        }
+        // The buffer keeps one chunk to write into again.
+        buffer->clear();
+        EXPECT_EQ(EncodedBuffer::getPoolStats().pooledBytes, 2 * TEST_CHUNK_SIZE);
+    }
+    EXPECT_EQ(EncodedBuffer::getPoolStats().pooledBytes, TEST_CHUNK_3X_SIZE);
+
+    EncodedBuffer::PoolStats before = EncodedBuffer::getPoolStats();
+    sp<EncodedBuffer> buffer = new EncodedBuffer(TEST_CHUNK_SIZE);
+    for (size_t i = 0; i < TEST_CHUNK_HALF_SIZE; i++) {
+        buffer->writeRawByte(i);
+    }
+    EncodedBuffer::PoolStats after = EncodedBuffer::getPoolStats();
+    EXPECT_EQ(after.reused, before.reused + 1);
+    EXPECT_EQ(after.mapped, before.mapped);
+    EXPECT_EQ(after.pooledBytes, 2 * TEST_CHUNK_SIZE);
+
+    sp<ProtoReader> reader = buffer->read();
+    uint8_t val = 0;
+    while (reader->hasNext()) {
+        EXPECT_EQ(reader->next(), val);
+        val++;
+    }
+    EXPECT_EQ(reader->bytesRead(), TEST_CHUNK_HALF_SIZE);
+
+    EncodedBuffer::trimPool();
+    EXPECT_EQ(EncodedBuffer::getPoolStats().pooledBytes, 0UL);
+}
+
+TEST(EncodedBufferTest, PoolCapacity) {
+    EncodedBuffer::trimPool();
+    const size_t capacity = EncodedBuffer::getPoolStats().capacity;
+    EncodedBuffer::setPoolCapacity(TEST_CHUNK_SIZE);
+    {
+        sp<EncodedBuffer> buffer = new EncodedBuffer(TEST_CHUNK_SIZE);
+        for (size_t i = 0; i < TEST_CHUNK_3X_SIZE; i++) {
+            buffer->writeRawByte(i);
+        }
+    }
+    EncodedBuffer::PoolStats stats = EncodedBuffer::getPoolStats();
+    EXPECT_EQ(stats.pooledBytes, TEST_CHUNK_SIZE);
+    EXPECT_EQ(stats.capacity, TEST_CHUNK_SIZE);
+
+    EncodedBuffer::setPoolCapacity(0);
+    EXPECT_EQ(EncodedBuffer::getPoolStats().pooledBytes, 0UL);
+    EncodedBuffer::setPoolCapacity(capacity);
+}
@@ -316,6 +316,95 @@ TEST(ProtoOutputStreamTest, AdvancedEncoding) {
     EXPECT_FALSE(log2.has_data());
 }
 
+TEST(ProtoOutputStreamTest, ReservedLengths) {
+    // long enough for its length to take more than one byte.
+    std::string name(300, 'x');
+
+    ProtoOutputStream proto;
+    EXPECT_TRUE(proto.setReservedLengths(true));
+    EXPECT_TRUE(proto.write(FIELD_TYPE_INT32 | ComplexProto::kIntsFieldNumber, 23));
+    uint64_t token1 = proto.start(FIELD_TYPE_MESSAGE | ComplexProto::kLogsFieldNumber);
+    EXPECT_TRUE(proto.write(FIELD_TYPE_INT32 | ComplexProto::Log::kIdFieldNumber, 12));
+    EXPECT_TRUE(proto.write(FIELD_TYPE_STRING | ComplexProto::Log::kNameFieldNumber, name));
+    proto.end(token1);
+    // an empty message is erased.
+    uint64_t token2 = proto.start(FIELD_TYPE_MESSAGE | ComplexProto::kLogsFieldNumber);
+    proto.end(token2);
+    proto.writeLengthDelimitedHeader(ComplexProto::kLogsFieldNumber, 2);
+    proto.writeRawByte((ComplexProto::Log::kIdFieldNumber << FIELD_ID_SHIFT) + WIRE_TYPE_VARINT);
+    proto.writeRawByte(98);
+    EXPECT_FALSE(proto.setReservedLengths(false));
+
+    // 2 bytes of ints, 1 + 5 + 2 + 3 + 300 bytes of the first log and 1 + 1 + 2 of the last.
+    EXPECT_EQ(proto.bytesWritten(), 317);
+    EXPECT_EQ(proto.size(), 317);
+
+    ComplexProto complex;
+    ASSERT_TRUE(complex.ParseFromString(flushToString(&proto)));
+    EXPECT_EQ(complex.ints_size(), 1);
+    EXPECT_EQ(complex.ints(0), 23);
+    EXPECT_EQ(complex.logs_size(), 2);
+    EXPECT_EQ(complex.logs(0).id(), 12);
+    EXPECT_EQ(complex.logs(0).name(), name);
+    EXPECT_EQ(complex.logs(1).id(), 98);
+    EXPECT_FALSE(complex.logs(1).has_name());
+
+    // clear keeps the length encoding.
+    proto.clear();
+    uint64_t token3 = proto.start(FIELD_TYPE_MESSAGE | ComplexProto::kLogsFieldNumber);
+    EXPECT_TRUE(proto.write(FIELD_TYPE_INT32 | ComplexProto::Log::kIdFieldNumber, 7));
+    proto.end(token3);
+    EXPECT_EQ(proto.bytesWritten(), 8);
+
+    ComplexProto afterClear;
+    ASSERT_TRUE(afterClear.ParseFromString(iterateToString(&proto)));
+    EXPECT_EQ(afterClear.logs_size(), 1);
+    EXPECT_EQ(afterClear.logs(0).id(), 7);
+}
+
+TEST(ProtoOutputStreamTest, KeyedFieldWriters) {
+    std::string s = "hello";
+    const char b[5] = { 'a', 'p', 'p', 'l', 'e' };
+    auto key = [](uint32_t id, uint8_t wireType) { return (id << FIELD_ID_SHIFT) | wireType; };
+
+    ProtoOutputStream typed;
+    EXPECT_TRUE(typed.writeDoubleField(
+            key(PrimitiveProto::kValDoubleFieldNumber, WIRE_TYPE_FIXED64), -1.2));
+    EXPECT_TRUE(typed.writeFloatField(
+            key(PrimitiveProto::kValFloatFieldNumber, WIRE_TYPE_FIXED32), 3.4f));
+    EXPECT_TRUE(typed.writeVarintField(
+            key(PrimitiveProto::kValInt32FieldNumber, WIRE_TYPE_VARINT), (uint32_t)-789));
+    EXPECT_TRUE(typed.writeVarintField(
+            key(PrimitiveProto::kValInt64FieldNumber, WIRE_TYPE_VARINT), (uint64_t)-123));
+    EXPECT_TRUE(typed.writeFixed32Field(
+            key(PrimitiveProto::kValFixed32FieldNumber, WIRE_TYPE_FIXED32), 678));
+    EXPECT_TRUE(typed.writeFixed64Field(
+            key(PrimitiveProto::kValFixed64FieldNumber, WIRE_TYPE_FIXED64), 95));
+    EXPECT_TRUE(typed.writeLengthDelimitedField(
+            key(PrimitiveProto::kValStringFieldNumber, WIRE_TYPE_LENGTH_DELIMITED),
+            s.data(), s.size()));
+    EXPECT_TRUE(typed.writeLengthDelimitedField(
+            key(PrimitiveProto::kValBytesFieldNumber, WIRE_TYPE_LENGTH_DELIMITED), b, 5));
+
+    ProtoOutputStream proto;
+    EXPECT_TRUE(proto.write(FIELD_TYPE_DOUBLE | PrimitiveProto::kValDoubleFieldNumber, -1.2));
+    EXPECT_TRUE(proto.write(FIELD_TYPE_FLOAT | PrimitiveProto::kValFloatFieldNumber, 3.4f));
+    EXPECT_TRUE(proto.write(FIELD_TYPE_INT32 | PrimitiveProto::kValInt32FieldNumber, -789));
+    EXPECT_TRUE(proto.write(FIELD_TYPE_INT64 | PrimitiveProto::kValInt64FieldNumber, -123LL));
+    EXPECT_TRUE(proto.write(FIELD_TYPE_FIXED32 | PrimitiveProto::kValFixed32FieldNumber, 678));
+    EXPECT_TRUE(proto.write(FIELD_TYPE_FIXED64 | PrimitiveProto::kValFixed64FieldNumber, 95LL));
+    EXPECT_TRUE(proto.write(FIELD_TYPE_STRING | PrimitiveProto::kValStringFieldNumber, s));
+    EXPECT_TRUE(proto.write(FIELD_TYPE_BYTES | PrimitiveProto::kValBytesFieldNumber, b, 5));
+
+    std::string serialized;
+    ASSERT_TRUE(typed.serializeToString(&serialized));
+    EXPECT_EQ(serialized, flushToString(&proto));
+
+    // Can't write to proto after compact
+    EXPECT_FALSE(typed.writeVarintField(
+            key(PrimitiveProto::kValInt32FieldNumber, WIRE_TYPE_VARINT), 1));
+}
+
 TEST(ProtoOutputStreamTest, InvalidTypes) {
     ProtoOutputStream proto;
     EXPECT_FALSE(proto.write(FIELD_TYPE_UNKNOWN | PrimitiveProto::kValInt32FieldNumber, 790));
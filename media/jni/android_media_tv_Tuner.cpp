@@ -4488,29 +4488,37 @@ static jint android_media_tv_Tuner_flush_filter(JNIEnv *env, jobject filter) {
     return (jint)filterClient->flush();
 }
 
+static sp<FilterClient> getFilterClientForRead(JNIEnv *env, jobject filter) {
+    static jclass sharedFilterClass = static_cast<jclass>(env->NewGlobalRef(
+            env->FindClass("android/media/tv/tuner/filter/SharedFilter")));
+    if (env->IsInstanceOf(filter, sharedFilterClass)) {
+        return getSharedFilterClient(env, filter);
+    }
+    return getFilterClient(env, filter);
+}
+
 static jint android_media_tv_Tuner_read_filter_fmq(
         JNIEnv *env, jobject filter, jbyteArray buffer, jlong offset, jlong size) {
-    sp<FilterClient> filterClient = nullptr;
-    if (env->IsInstanceOf(filter, env->FindClass("android/media/tv/tuner/filter/SharedFilter"))) {
-        filterClient = getSharedFilterClient(env, filter);
-    } else {
-        filterClient = getFilterClient(env, filter);
-    }
+    sp<FilterClient> filterClient = getFilterClientForRead(env, filter);
     if (filterClient == nullptr) {
         jniThrowException(env, "java/lang/IllegalStateException",
                 "Failed to read filter FMQ: filter client not found");
         return -1;
     }
-
-    jboolean isCopy;
-    jbyte *dst = env->GetByteArrayElements(buffer, &isCopy);
-    ALOGV("copyData, isCopy=%d", isCopy);
-    if (dst == nullptr) {
-        jniThrowRuntimeException(env, "Failed to GetByteArrayElements");
+    const jsize length = env->GetArrayLength(buffer);
+    if (offset < 0 || size < 0 || offset > length || size > length - offset) {
+        jniThrowException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                "Failed to read filter FMQ: offset and size out of the buffer");
         return -1;
     }
-    int realReadSize = filterClient->read(reinterpret_cast<int8_t *>(dst) + offset, size);
-    env->ReleaseByteArrayElements(buffer, dst, 0);
+
+    // Copy straight from the queue into the requested range of the array, rather than taking
+    // (and writing back) the elements of the whole array.
+    jsize dst = static_cast<jsize>(offset);
+    int realReadSize = filterClient->read(size, [&](const int8_t *data, size_t dataLength) {
+        env->SetByteArrayRegion(buffer, dst, dataLength, reinterpret_cast<const jbyte *>(data));
+        dst += dataLength;
+    });
     return (jint)realReadSize;
 }
 
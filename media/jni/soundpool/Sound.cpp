@@ -23,12 +23,120 @@
 #include <media/NdkMediaCodec.h>
 #include <media/NdkMediaExtractor.h>
 #include <media/NdkMediaFormat.h>
+#include <sys/stat.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <tuple>
 
 namespace android::soundpool {
 
 constexpr uint32_t kMaxSampleRate = 192000;
 constexpr size_t   kDefaultHeapSize = 1024 * 1024; // 1MB (compatible with low mem devices)
 
+namespace {
+
+/**
+ * DecodedKey identifies the encoded data a Sound is decoded from: the file, its size and
+ * modification time, and the range within it.
+ */
+struct DecodedKey {
+    dev_t   dev;
+    ino_t   ino;
+    int64_t fileSize;
+    int64_t mtimeNs;
+    int64_t offset;
+    int64_t length;
+
+    bool operator<(const DecodedKey& other) const {
+        return std::tie(dev, ino, fileSize, mtimeNs, offset, length)
+                < std::tie(other.dev, other.ino, other.fileSize, other.mtimeNs,
+                        other.offset, other.length);
+    }
+};
+
+std::optional<DecodedKey> makeDecodedKey(int fd, int64_t offset, int64_t length) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return std::nullopt; // only regular files have a stable identity.
+    }
+    return DecodedKey{st.st_dev, st.st_ino, (int64_t)st.st_size,
+            (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec, offset, length};
+}
+
+/**
+ * DecodedCache shares the decoded PCM of a file across all the Sounds of the process,
+ * including those of other SoundPool instances, so that loading the same asset again does
+ * not decode it again.  The cache only holds weak references: the decoded memory is
+ * released when the last Sound using it is unloaded.
+ */
+class DecodedCache {
+public:
+    struct Entry {
+        wp<IMemory>          data;
+        uint32_t             sampleRate;
+        int32_t              channelCount;
+        audio_format_t       format;
+        audio_channel_mask_t channelMask;
+    };
+
+    // Returns the decoded memory for the key, filling in entry, or nullptr if the caller
+    // should decode it.  On nullptr, the caller must call put() or abandon() for the key.
+    // If another thread is decoding the same key, this waits for it to finish.
+    sp<IMemory> acquire(const DecodedKey& key, Entry* entry) NO_THREAD_SAFETY_ANALYSIS {
+        std::unique_lock lock(mLock);
+        mDecodeFinished.wait(lock, [&] { return mDecoding.count(key) == 0; });
+        auto it = mEntries.find(key);
+        if (it != mEntries.end()) {
+            sp<IMemory> data = it->second.data.promote();
+            if (data != nullptr) {
+                *entry = it->second;
+                return data;
+            }
+            mEntries.erase(it);
+        }
+        mDecoding.insert(key);
+        return nullptr;
+    }
+
+    void put(const DecodedKey& key, const Entry& entry) {
+        std::lock_guard lock(mLock);
+        // Drop the entries whose sounds have all been unloaded.
+        for (auto it = mEntries.begin(); it != mEntries.end(); ) {
+            if (it->second.data.promote() == nullptr) {
+                it = mEntries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        mEntries[key] = entry;
+        mDecoding.erase(key);
+        mDecodeFinished.notify_all();
+    }
+
+    void abandon(const DecodedKey& key) {
+        std::lock_guard lock(mLock);
+        mDecoding.erase(key);
+        mDecodeFinished.notify_all();
+    }
+
+private:
+    std::mutex                         mLock;
+    std::condition_variable            mDecodeFinished GUARDED_BY(mLock);
+    std::map<DecodedKey, Entry>        mEntries GUARDED_BY(mLock);
+    std::set<DecodedKey>               mDecoding GUARDED_BY(mLock);
+};
+
+DecodedCache& decodedCache() {
+    static DecodedCache* const cache = new DecodedCache(); // never deleted, process lifetime.
+    return *cache;
+}
+
+} // namespace
+
 Sound::Sound(int32_t soundID, int fd, int64_t offset, int64_t length)
     : mSoundID(soundID)
     , mFd(fcntl(fd, F_DUPFD_CLOEXEC, (int)0 /* arg */)) // dup(fd) + close on exec to prevent leaks.
@@ -200,6 +308,24 @@ status_t Sound::doLoad()
     ALOGV("%s()", __func__);
     status_t status = NO_INIT;
     if (mFd.get() != -1) {
+        const std::optional<DecodedKey> key = makeDecodedKey(mFd.get(), mOffset, mLength);
+        if (key.has_value()) {
+            DecodedCache::Entry entry;
+            sp<IMemory> data = decodedCache().acquire(*key, &entry);
+            if (data != nullptr) {
+                ALOGV("%s: sharing decoded data %p", __func__, data->unsecurePointer());
+                mFd.reset();  // close
+                mData = std::move(data);
+                mSizeInBytes = mData->size();
+                mSampleRate = entry.sampleRate;
+                mChannelCount = entry.channelCount;
+                mFormat = entry.format;
+                mChannelMask = entry.channelMask;
+                mState = READY;  // this should be last, as it is an atomic sync point
+                return NO_ERROR;
+            }
+        }
+
         mHeap = new MemoryHeapBase(kDefaultHeapSize);
 
         ALOGV("%s: start decode", __func__);
@@ -229,9 +355,15 @@ status_t Sound::doLoad()
             mChannelCount = channelCount;
             mFormat = format;
             mChannelMask = channelMask;
+            if (key.has_value()) {
+                decodedCache().put(*key, {mData, sampleRate, channelCount, format, channelMask});
+            }
             mState = READY;  // this should be last, as it is an atomic sync point
             return NO_ERROR;
         }
+        if (key.has_value()) {
+            decodedCache().abandon(*key);
+        }
     } else {
         ALOGE("%s: uninitialized fd, dup failed", __func__);
     }
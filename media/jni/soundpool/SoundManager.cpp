@@ -20,13 +20,16 @@
 
 #include "SoundManager.h"
 
+#include <algorithm>
 #include <thread>
 
 #include "SoundDecoder.h"
 
 namespace android::soundpool {
 
-static const size_t kDecoderThreads = std::thread::hardware_concurrency() >= 4 ? 2 : 1;
+// The most decoder threads a SoundManager may run.  Threads are only launched while the load
+// queue is deeper than the active thread count, and exit once the queue has been idle.
+static const size_t kDecoderThreads = std::max(1u, std::thread::hardware_concurrency() / 2);
 
 SoundManager::SoundManager()
     : mDecoder{std::make_unique<SoundDecoder>(this, kDecoderThreads, ANDROID_PRIORITY_NORMAL)}
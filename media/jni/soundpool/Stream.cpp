@@ -224,6 +224,13 @@ void Stream::clearAudioTrack()
     mAudioTrack.clear();
 }
 
+bool Stream::canReuseAudioTrack(int32_t soundID, float rate) const
+{
+    std::lock_guard lock(mLock);
+    // A changed rate may not be settable on a fast track, which then has to be recreated.
+    return mAudioTrack != nullptr && mSoundID == soundID && mRate == rate;
+}
+
 Stream* Stream::getPairStream() const
 {
    return mStreamManager->getPairStream(this);
@@ -122,6 +122,10 @@ public:
 
     bool hasSound() const NO_THREAD_SAFETY_ANALYSIS { return mSound.get() != nullptr; }
 
+    // Returns true if the Stream holds an AudioTrack that play() can restart for the
+    // soundID and rate without creating a new one.  (monitor locked by mLock)
+    bool canReuseAudioTrack(int32_t soundID, float rate) const;
+
     // This never changes.  See top of header.
     Stream* getPairStream() const;
 
@@ -61,6 +61,35 @@ int64_t FilterClient::read(int8_t* buffer, int64_t size) {
     return copyData(buffer, size);
 }
 
+int64_t FilterClient::read(int64_t size,
+                           const function<void(const int8_t* data, size_t length)>& consume) {
+    Result res = getFilterMq();
+    if (res != Result::SUCCESS || mFilterMQ == nullptr || mFilterMQEventFlag == nullptr) {
+        return -1;
+    }
+
+    size = min(size, static_cast<int64_t>(mFilterMQ->availableToRead()));
+    if (size <= 0) {
+        return 0;
+    }
+    AidlMQ::MemTransaction tx;
+    if (!mFilterMQ->beginRead(size, &tx)) {
+        return -1;
+    }
+    // The data may wrap around the end of the queue.
+    const auto& first = tx.getFirstRegion();
+    const auto& second = tx.getSecondRegion();
+    consume(first.getAddress(), first.getLength());
+    if (second.getLength() > 0) {
+        consume(second.getAddress(), second.getLength());
+    }
+    if (!mFilterMQ->commitRead(size)) {
+        return -1;
+    }
+    mFilterMQEventFlag->wake(static_cast<uint32_t>(DemuxQueueNotifyBits::DATA_CONSUMED));
+    return size;
+}
+
 SharedHandleInfo FilterClient::getAvSharedHandleInfo() {
     handleAvShareMemory();
     SharedHandleInfo info{
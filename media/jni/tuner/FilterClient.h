@@ -23,6 +23,8 @@
 #include <fmq/AidlMessageQueue.h>
 #include <utils/Mutex.h>
 
+#include <functional>
+
 #include "ClientHelper.h"
 #include "FilterClientCallback.h"
 
@@ -75,6 +77,15 @@ public:
      */
     int64_t read(int8_t* buffer, int64_t size);
 
+    /**
+     * Read size of data from filter FMQ without copying it out of the queue first. The
+     * contiguous regions of the queue holding the data are passed to consume in order, and
+     * the data is released back to the queue once consume returns.
+     *
+     * @return the actual reading size. -1 if failed to read.
+     */
+    int64_t read(int64_t size, const function<void(const int8_t* data, size_t length)>& consume);
+
     /**
      * Get the a/v shared memory handle information
      */
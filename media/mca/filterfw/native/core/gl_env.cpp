@@ -24,6 +24,7 @@
 #include <gui/IGraphicBufferProducer.h>
 #include <gui/Surface.h>
 
+#include <iterator>
 #include <map>
 #include <string>
 
@@ -43,10 +44,19 @@ GLEnv::GLEnv()
     max_surface_id_(0),
     created_context_(false),
     created_surface_(false),
-    initialized_(false) {
+    initialized_(false),
+    pool_lifetime_(std::make_shared<int>(0)) {
 }
 
+// The maximum number of texture and FBO pairs kept around for reuse.
+static const size_t kMaxPooledFramebuffers = 16;
+
 GLEnv::~GLEnv() {
+  // Delete pooled GL objects while the context is still alive, and keep frames
+  // that outlive us from returning theirs.
+  pool_lifetime_.reset();
+  ReleasePooledFramebuffers();
+
   // Destroy surfaces
   for (std::map<int, SurfaceWindowPair>::iterator it = surfaces_.begin();
        it != surfaces_.end();
@@ -411,5 +421,41 @@ VertexFrame* GLEnv::VertexFrameWithKey(int key) {
   return FindPtrOrNull(attached_vframes_, key);
 }
 
+bool GLEnv::TakePooledFramebuffer(int width, int height, GLuint* texture_id, GLuint* fbo_id) {
+  // Prefer the most recently returned pair, which is the most likely to still be resident.
+  for (std::vector<PooledFramebuffer>::reverse_iterator it = pooled_framebuffers_.rbegin();
+       it != pooled_framebuffers_.rend();
+       ++it) {
+    if (it->width == width && it->height == height) {
+      *texture_id = it->texture_id;
+      *fbo_id = it->fbo_id;
+      pooled_framebuffers_.erase(std::next(it).base());
+      return true;
+    }
+  }
+  return false;
+}
+
+void GLEnv::ReturnPooledFramebuffer(int width, int height, GLuint texture_id, GLuint fbo_id) {
+  if (pooled_framebuffers_.size() >= kMaxPooledFramebuffers) {
+    const PooledFramebuffer& oldest = pooled_framebuffers_.front();
+    glDeleteTextures(1, &oldest.texture_id);
+    glDeleteFramebuffers(1, &oldest.fbo_id);
+    pooled_framebuffers_.erase(pooled_framebuffers_.begin());
+  }
+  PooledFramebuffer pooled = { width, height, texture_id, fbo_id };
+  pooled_framebuffers_.push_back(pooled);
+}
+
+void GLEnv::ReleasePooledFramebuffers() {
+  for (std::vector<PooledFramebuffer>::iterator it = pooled_framebuffers_.begin();
+       it != pooled_framebuffers_.end();
+       ++it) {
+    glDeleteTextures(1, &it->texture_id);
+    glDeleteFramebuffers(1, &it->fbo_id);
+  }
+  pooled_framebuffers_.clear();
+}
+
 } // namespace filterfw
 } // namespace android
@@ -20,6 +20,8 @@
 #include <string>
 #include <utility>
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/utilities.h"
@@ -191,6 +193,26 @@ class GLEnv {
     // such frame attached to this environment.
     VertexFrame* VertexFrameWithKey(int key);
 
+    // Pooling frame buffers ///////////////////////////////////////////////////
+
+    // Take a pooled RGBA texture of the given size, together with the FBO it
+    // is attached to. Returns false if there is no such pair in the pool. The
+    // caller takes ownership of both objects.
+    bool TakePooledFramebuffer(int width, int height, GLuint* texture_id, GLuint* fbo_id);
+
+    // Return a texture and the FBO it is attached to to the pool, so that a
+    // later frame of the same size can reuse them instead of allocating new
+    // ones. The environment takes ownership of both objects.
+    void ReturnPooledFramebuffer(int width, int height, GLuint texture_id, GLuint fbo_id);
+
+    // Deletes all pooled textures and FBOs.
+    void ReleasePooledFramebuffers();
+
+    // Returns a reference that expires when the environment is destroyed.
+    // Frames that outlive their environment use it to delete their texture and
+    // FBO themselves rather than returning them to a pool that is gone.
+    std::weak_ptr<void> PoolLifetime() const { return pool_lifetime_; }
+
     // Static methods //////////////////////////////////////////////////////////
     // These operate on the currently active environment!
 
@@ -217,6 +239,13 @@ class GLEnv {
   private:
     typedef std::pair<EGLSurface, WindowHandle*> SurfaceWindowPair;
 
+    struct PooledFramebuffer {
+      int width;
+      int height;
+      GLuint texture_id;
+      GLuint fbo_id;
+    };
+
     // Initializes a new GL environment.
     bool Init();
 
@@ -256,6 +285,12 @@ class GLEnv {
     std::map<int, ShaderProgram*> attached_shaders_;
     std::map<int, VertexFrame*> attached_vframes_;
 
+    // Textures and FBOs released by frames, oldest first.
+    std::vector<PooledFramebuffer> pooled_framebuffers_;
+
+    // Expires when the environment is destroyed, see PoolLifetime().
+    std::shared_ptr<void> pool_lifetime_;
+
     GLEnv(const GLEnv&) = delete;
     GLEnv& operator=(const GLEnv&) = delete;
 };
@@ -37,6 +37,7 @@ static const int kIdentityShaderKey = 1;
 
 GLFrame::GLFrame(GLEnv* gl_env)
   : gl_env_(gl_env),
+    gl_env_pool_lifetime_(gl_env->PoolLifetime()),
     width_(0),
     height_(0),
     vp_x_(0),
@@ -92,6 +93,16 @@ void GLFrame::InitDimensions(int width, int height) {
 }
 
 GLFrame::~GLFrame() {
+  // Hand a complete texture and FBO pair back to the environment, so that the next frame of the
+  // same size does not have to allocate them again.
+  if (owns_texture_ && owns_fbo_ &&
+      texture_state_ == kStateComplete && fbo_state_ == kStateComplete &&
+      texture_target_ == GL_TEXTURE_2D && width_ > 0 && height_ > 0 &&
+      !gl_env_pool_lifetime_.expired()) {
+    gl_env_->ReturnPooledFramebuffer(width_, height_, texture_id_, fbo_id_);
+    return;
+  }
+
   // Delete texture
   if (owns_texture_) {
     // Bind FBO so that texture is unbound from it during deletion
@@ -280,8 +291,36 @@ bool GLFrame::FocusTexture() {
   return !GLEnv::CheckGLError("Texture Binding");
 }
 
+bool GLFrame::TakePooledFramebuffer() {
+  if (texture_target_ != GL_TEXTURE_2D || fbo_state_ != kStateUninitialized ||
+      width_ <= 0 || height_ <= 0 ||
+      !gl_env_->TakePooledFramebuffer(width_, height_, &texture_id_, &fbo_id_)) {
+    return false;
+  }
+  LOG_FRAME("GLFrame: Reusing pooled tex %d and fbo %d", texture_id_, fbo_id_);
+  texture_state_ = kStateComplete;
+  fbo_state_ = kStateComplete;
+  owns_texture_ = true;
+  owns_fbo_ = true;
+
+  // Do not hand out what the previous owner drew. Shader programs set their
+  // own clear color, so it is not restored.
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  if (GLEnv::CheckGLError("Clearing pooled framebuffer"))
+    return false;
+
+  // The previous owner may have changed the texture parameters.
+  glBindTexture(GL_TEXTURE_2D, texture_id_);
+  return UpdateTexParameters();
+}
+
 bool GLFrame::GenerateTextureName() {
   if (texture_state_ == kStateUninitialized) {
+    if (TakePooledFramebuffer())
+      return true;
+
     // Make sure texture not in use already
     if (glIsTexture(texture_id_)) {
       ALOGE("GLFrame: Cannot generate texture id %d, as it is in use already!", texture_id_);
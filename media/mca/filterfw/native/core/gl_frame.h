@@ -18,6 +18,7 @@
 #define ANDROID_FILTERFW_CORE_GL_FRAME_H
 
 #include <map>
+#include <memory>
 
 #include <GLES2/gl2.h>
 
@@ -129,6 +130,10 @@ class GLFrame : public GLBufferHandle {
     // Sets the frame and viewport dimensions.
     void InitDimensions(int width, int height);
 
+    // Takes a texture and FBO of the frame's size from the environment's pool.
+    // Returns false if there is none to reuse.
+    bool TakePooledFramebuffer();
+
     // Generates the internal texture name.
     bool GenerateTextureName();
 
@@ -182,6 +187,9 @@ class GLFrame : public GLBufferHandle {
     // The GL environment this frame belongs to
     GLEnv* gl_env_;
 
+    // Expires with gl_env_, after which the pool must not be used.
+    std::weak_ptr<void> gl_env_pool_lifetime_;
+
     // The width, height and format of the frame
     int width_;
     int height_;
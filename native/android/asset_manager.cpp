@@ -17,6 +17,7 @@
 #define LOG_TAG "NAsset"
 #include <utils/Log.h>
 
+#include <android/asset_manager_batch.h>
 #include <android/asset_manager_jni.h>
 #include <android_runtime/android_util_AssetManager.h>
 #include <androidfw/Asset.h>
@@ -63,23 +64,30 @@ AAssetManager* AAssetManager_fromJava(JNIEnv* env, jobject assetManager)
     return (AAssetManager*) env->GetLongField(assetManager, gAssetManagerOffsets.mObject);
 }
 
-AAsset* AAssetManager_open(AAssetManager* amgr, const char* filename, int mode)
+static bool toAccessMode(int mode, Asset::AccessMode* outMode)
 {
-    Asset::AccessMode amMode;
     switch (mode) {
     case AASSET_MODE_UNKNOWN:
-        amMode = Asset::ACCESS_UNKNOWN;
-        break;
+        *outMode = Asset::ACCESS_UNKNOWN;
+        return true;
     case AASSET_MODE_RANDOM:
-        amMode = Asset::ACCESS_RANDOM;
-        break;
+        *outMode = Asset::ACCESS_RANDOM;
+        return true;
     case AASSET_MODE_STREAMING:
-        amMode = Asset::ACCESS_STREAMING;
-        break;
+        *outMode = Asset::ACCESS_STREAMING;
+        return true;
     case AASSET_MODE_BUFFER:
-        amMode = Asset::ACCESS_BUFFER;
-        break;
+        *outMode = Asset::ACCESS_BUFFER;
+        return true;
     default:
+        return false;
+    }
+}
+
+AAsset* AAssetManager_open(AAssetManager* amgr, const char* filename, int mode)
+{
+    Asset::AccessMode amMode;
+    if (!toAccessMode(mode, &amMode)) {
         return NULL;
     }
 
@@ -91,6 +99,51 @@ AAsset* AAssetManager_open(AAssetManager* amgr, const char* filename, int mode)
     return new AAsset(std::move(asset));
 }
 
+int AAssetManager_openBatch(AAssetManager* amgr, const char* const* filenames, size_t count,
+                            int mode, AAsset** outAssets)
+{
+    Asset::AccessMode amMode;
+    if (!toAccessMode(mode, &amMode)) {
+        return -1;
+    }
+
+    int opened = 0;
+    ScopedLock<AssetManager2> locked_mgr(*AssetManagerForNdkAssetManager(amgr));
+    for (size_t i = 0; i < count; i++) {
+        std::unique_ptr<Asset> asset = locked_mgr->Open(filenames[i], amMode);
+        if (asset == nullptr) {
+            outAssets[i] = nullptr;
+            continue;
+        }
+        outAssets[i] = new AAsset(std::move(asset));
+        opened++;
+    }
+    return opened;
+}
+
+int AAssetManager_openFileDescriptorBatch(AAssetManager* amgr, const char* const* filenames,
+                                          size_t count, int* outFds, off64_t* outStarts,
+                                          off64_t* outLengths)
+{
+    int opened = 0;
+    ScopedLock<AssetManager2> locked_mgr(*AssetManagerForNdkAssetManager(amgr));
+    for (size_t i = 0; i < count; i++) {
+        outFds[i] = -1;
+        outStarts[i] = 0;
+        outLengths[i] = 0;
+        // Random access keeps a stored entry mapped lazily rather than reading it in.
+        std::unique_ptr<Asset> asset = locked_mgr->Open(filenames[i], Asset::ACCESS_RANDOM);
+        if (asset == nullptr) {
+            continue;
+        }
+        outFds[i] = asset->openFileDescriptor(&outStarts[i], &outLengths[i]);
+        if (outFds[i] >= 0) {
+            opened++;
+        }
+    }
+    return opened;
+}
+
 AAssetDir* AAssetManager_openDir(AAssetManager* amgr, const char* dirName)
 {
     ScopedLock<AssetManager2> locked_mgr(*AssetManagerForNdkAssetManager(amgr));
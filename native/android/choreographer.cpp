@@ -14,7 +14,15 @@
  * limitations under the License.
  */
 
+#include <android/choreographer_fanout.h>
 #include <private/android/choreographer.h>
+#include <utils/Timers.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 using namespace android;
 
@@ -79,3 +87,175 @@ int64_t AChoreographerFrameCallbackData_getFrameTimelineDeadlineNanos(
         const AChoreographerFrameCallbackData* data, size_t index) {
     return AChoreographerFrameCallbackData_routeGetFrameTimelineDeadlineNanos(data, index);
 }
+
+struct AChoreographerFanout {
+    struct Subscriber {
+        int32_t id;
+        AChoreographer_vsyncCallback callback;
+        void* data;
+        // Set on removal, so that a dispatch already holding the subscriber skips it.
+        std::atomic<bool> removed = false;
+    };
+    using Subscribers = std::vector<std::shared_ptr<Subscriber>>;
+
+    explicit AChoreographerFanout(AChoreographer* choreographer) : choreographer(choreographer) {}
+
+    static void onVsync(const AChoreographerFrameCallbackData* data, void* self);
+    void dispatch(const Subscribers& subscribers, const AChoreographerFrameCallbackData* data);
+    void postLocked();
+
+    AChoreographer* const choreographer;
+
+    std::mutex lock;
+    // Replaced, never modified, on each change so that dispatch can iterate over it unlocked.
+    std::shared_ptr<const Subscribers> subscribers = std::make_shared<const Subscribers>();
+    int32_t nextId = 1;
+    // Whether onVsync() is registered with the choreographer. A destroyed fanout is deleted by
+    // that pending callback.
+    bool posted = false;
+    bool destroyed = false;
+
+    // Only written on the choreographer's thread.
+    std::atomic<uint64_t> frames = 0;
+    std::atomic<uint64_t> callbacks = 0;
+    std::atomic<uint64_t> missedDeadlines = 0;
+    std::atomic<int64_t> totalDispatchLatency = 0;
+    std::atomic<int64_t> maxDispatchLatency = 0;
+    std::atomic<int64_t> totalDispatchDuration = 0;
+    std::atomic<int64_t> maxDispatchDuration = 0;
+};
+
+namespace {
+
+void addSample(std::atomic<int64_t>* total, std::atomic<int64_t>* max, int64_t sample) {
+    total->store(total->load(std::memory_order_relaxed) + sample, std::memory_order_relaxed);
+    if (sample > max->load(std::memory_order_relaxed)) {
+        max->store(sample, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+void AChoreographerFanout::postLocked() {
+    if (!posted) {
+        posted = true;
+        AChoreographer_postVsyncCallback(choreographer, onVsync, this);
+    }
+}
+
+void AChoreographerFanout::onVsync(const AChoreographerFrameCallbackData* data, void* self) {
+    auto fanout = static_cast<AChoreographerFanout*>(self);
+    std::shared_ptr<const Subscribers> subscribers;
+    {
+        std::lock_guard<std::mutex> guard(fanout->lock);
+        fanout->posted = false;
+        if (!fanout->destroyed) {
+            subscribers = fanout->subscribers;
+            // Register for the next frame before dispatching, so that the fanout stays alive
+            // through the dispatch even if a subscriber destroys it.
+            if (!subscribers->empty()) {
+                fanout->postLocked();
+            }
+        }
+    }
+    if (!subscribers) {
+        delete fanout;
+        return;
+    }
+    if (!subscribers->empty()) {
+        fanout->dispatch(*subscribers, data);
+    }
+}
+
+void AChoreographerFanout::dispatch(const Subscribers& subscribers,
+                                    const AChoreographerFrameCallbackData* data) {
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    uint64_t called = 0;
+    for (const auto& subscriber : subscribers) {
+        if (!subscriber->removed.load(std::memory_order_acquire)) {
+            subscriber->callback(data, subscriber->data);
+            ++called;
+        }
+    }
+    const nsecs_t end = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    const size_t preferred = AChoreographerFrameCallbackData_getPreferredFrameTimelineIndex(data);
+    const int64_t deadline = AChoreographerFrameCallbackData_getFrameTimelineDeadlineNanos(data,
+                                                                                       preferred);
+    frames.fetch_add(1, std::memory_order_relaxed);
+    callbacks.fetch_add(called, std::memory_order_relaxed);
+    if (end > deadline) {
+        missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+    }
+    addSample(&totalDispatchLatency, &maxDispatchLatency,
+              std::max<int64_t>(0, start - AChoreographerFrameCallbackData_getFrameTimeNanos(data)));
+    addSample(&totalDispatchDuration, &maxDispatchDuration, end - start);
+}
+
+AChoreographerFanout* AChoreographerFanout_create(AChoreographer* choreographer) {
+    return new AChoreographerFanout(choreographer);
+}
+
+void AChoreographerFanout_destroy(AChoreographerFanout* fanout) {
+    if (fanout == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(fanout->lock);
+        for (const auto& subscriber : *fanout->subscribers) {
+            subscriber->removed.store(true, std::memory_order_release);
+        }
+        if (fanout->posted) {
+            fanout->destroyed = true;
+            return;
+        }
+    }
+    delete fanout;
+}
+
+int32_t AChoreographerFanout_addSubscriber(AChoreographerFanout* fanout,
+                                           AChoreographer_vsyncCallback callback, void* data) {
+    auto subscriber = std::make_shared<AChoreographerFanout::Subscriber>();
+    subscriber->callback = callback;
+    subscriber->data = data;
+
+    std::lock_guard<std::mutex> guard(fanout->lock);
+    subscriber->id = fanout->nextId++;
+    auto subscribers = std::make_shared<AChoreographerFanout::Subscribers>(*fanout->subscribers);
+    subscribers->push_back(std::move(subscriber));
+    const int32_t id = subscribers->back()->id;
+    fanout->subscribers = std::move(subscribers);
+    fanout->postLocked();
+    return id;
+}
+
+void AChoreographerFanout_removeSubscriber(AChoreographerFanout* fanout, int32_t subscriberId) {
+    std::lock_guard<std::mutex> guard(fanout->lock);
+    const auto& current = *fanout->subscribers;
+    auto it = std::find_if(current.begin(), current.end(),
+                           [&](const auto& subscriber) { return subscriber->id == subscriberId; });
+    if (it == current.end()) {
+        return;
+    }
+    (*it)->removed.store(true, std::memory_order_release);
+    auto subscribers = std::make_shared<AChoreographerFanout::Subscribers>();
+    subscribers->reserve(current.size() - 1);
+    std::copy_if(current.begin(), current.end(), std::back_inserter(*subscribers),
+                 [&](const auto& subscriber) { return subscriber->id != subscriberId; });
+    // The pending vsync callback, if any, lapses once the last subscriber is gone.
+    fanout->subscribers = std::move(subscribers);
+}
+
+void AChoreographerFanout_getStats(const AChoreographerFanout* fanout,
+                                   AChoreographerFanoutStats* outStats) {
+    outStats->frames = fanout->frames.load(std::memory_order_relaxed);
+    outStats->callbacks = fanout->callbacks.load(std::memory_order_relaxed);
+    outStats->missedDeadlines = fanout->missedDeadlines.load(std::memory_order_relaxed);
+    outStats->totalDispatchLatencyNanos =
+            fanout->totalDispatchLatency.load(std::memory_order_relaxed);
+    outStats->maxDispatchLatencyNanos = fanout->maxDispatchLatency.load(std::memory_order_relaxed);
+    outStats->totalDispatchDurationNanos =
+            fanout->totalDispatchDuration.load(std::memory_order_relaxed);
+    outStats->maxDispatchDurationNanos =
+            fanout->maxDispatchDuration.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __AASSETMANAGER_BATCH_H__
+#define __AASSETMANAGER_BATCH_H__
+
+#include <android/asset_manager.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+/**
+ * Open many assets at once, with a single acquisition of the asset manager lock. This is
+ * equivalent to, but cheaper than, calling AAssetManager_open() for each of the names.
+ *
+ * For each name, outAssets receives the opened asset, or NULL if it could not be opened. Every
+ * non-NULL asset must be closed with AAsset_close().
+ *
+ * Returns the number of assets that were opened, or -1 if mode is not a valid AASSET_MODE_* value.
+ *
+ * Introduced in API 37.
+ */
+int AAssetManager_openBatch(AAssetManager* _Nonnull mgr,
+                            const char* _Nonnull const* _Nonnull filenames, size_t count,
+                            int mode, AAsset* _Nullable* _Nonnull outAssets) __INTRODUCED_IN(37);
+
+/**
+ * Open the file descriptors backing many assets at once, with a single acquisition of the asset
+ * manager lock, so that the assets can be memory mapped directly. This only succeeds for assets
+ * that are stored uncompressed, like AAsset_openFileDescriptor64().
+ *
+ * For each name, outFds receives an open file descriptor that the caller must close, and
+ * outStarts and outLengths receive the offset and the length of the asset in that file. If the
+ * asset cannot be opened or is compressed, its file descriptor is -1.
+ *
+ * Returns the number of file descriptors that were opened.
+ *
+ * Introduced in API 37.
+ */
+int AAssetManager_openFileDescriptorBatch(AAssetManager* _Nonnull mgr,
+                                          const char* _Nonnull const* _Nonnull filenames,
+                                          size_t count, int* _Nonnull outFds,
+                                          off64_t* _Nonnull outStarts,
+                                          off64_t* _Nonnull outLengths) __INTRODUCED_IN(37);
+
+__END_DECLS
+
+#endif  // __AASSETMANAGER_BATCH_H__
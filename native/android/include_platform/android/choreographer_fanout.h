@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ACHOREOGRAPHER_FANOUT_H__
+#define __ACHOREOGRAPHER_FANOUT_H__
+
+#include <android/choreographer.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+__BEGIN_DECLS
+
+/**
+ * Dispatches every frame to a set of subscribers through a single vsync callback registration
+ * with the choreographer, so that the frame timeline is built once per frame rather than once per
+ * subscriber. Subscribers stay registered until they are removed, unlike callbacks posted with
+ * AChoreographer_postVsyncCallback().
+ *
+ * Subscribers are called on the choreographer's thread, in the order they were added, with the
+ * same AChoreographerFrameCallbackData. Subscribers are called without any lock held, and can be
+ * added and removed from any thread, including from within a subscriber.
+ */
+typedef struct AChoreographerFanout AChoreographerFanout;
+
+/**
+ * Dispatch statistics of an AChoreographerFanout.
+ */
+typedef struct AChoreographerFanoutStats {
+    /** Number of frames dispatched. */
+    uint64_t frames;
+    /** Number of subscriber calls made. */
+    uint64_t callbacks;
+    /** Frames whose dispatch finished after the preferred frame timeline deadline. */
+    uint64_t missedDeadlines;
+    /** Sum and maximum of the time between the vsync and the start of dispatch. */
+    int64_t totalDispatchLatencyNanos;
+    int64_t maxDispatchLatencyNanos;
+    /** Sum and maximum of the time spent calling all the subscribers of a frame. */
+    int64_t totalDispatchDurationNanos;
+    int64_t maxDispatchDurationNanos;
+} AChoreographerFanoutStats;
+
+/**
+ * Creates a fanout for the given choreographer, which must outlive it.
+ *
+ * Introduced in API 37.
+ */
+AChoreographerFanout* _Nonnull AChoreographerFanout_create(AChoreographer* _Nonnull choreographer)
+        __INTRODUCED_IN(37);
+
+/**
+ * Destroys the fanout. No subscriber is called after this returns, if it is called on the
+ * choreographer's thread.
+ *
+ * Introduced in API 37.
+ */
+void AChoreographerFanout_destroy(AChoreographerFanout* _Nullable fanout) __INTRODUCED_IN(37);
+
+/**
+ * Adds a subscriber that is called on every frame, starting with the next one.
+ *
+ * Returns an id for AChoreographerFanout_removeSubscriber(), which is always positive.
+ *
+ * Introduced in API 37.
+ */
+int32_t AChoreographerFanout_addSubscriber(AChoreographerFanout* _Nonnull fanout,
+                                           AChoreographer_vsyncCallback _Nonnull callback,
+                                           void* _Nullable data) __INTRODUCED_IN(37);
+
+/**
+ * Removes a subscriber. Once this returns, the subscriber is not called again, unless it is
+ * being called concurrently on the choreographer's thread.
+ *
+ * Introduced in API 37.
+ */
+void AChoreographerFanout_removeSubscriber(AChoreographerFanout* _Nonnull fanout,
+                                           int32_t subscriberId) __INTRODUCED_IN(37);
+
+/**
+ * Copies the dispatch statistics of the fanout into outStats.
+ *
+ * Introduced in API 37.
+ */
+void AChoreographerFanout_getStats(const AChoreographerFanout* _Nonnull fanout,
+                                   AChoreographerFanoutStats* _Nonnull outStats)
+        __INTRODUCED_IN(37);
+
+__END_DECLS
+
+#endif  // __ACHOREOGRAPHER_FANOUT_H__
@@ -150,8 +150,11 @@ private:
     ndk::SpAIBinder mToken = nullptr;
     // Used to track if operating on the fmq consistently fails
     bool mCorrupted = false;
-    // Used to keep a persistent transaction open with FMQ to reduce latency a bit
+    // Used to keep a persistent transaction open with FMQ to reduce latency a bit. Messages are
+    // written into consecutive slots of the transaction until it runs out, so that a report is
+    // a plain memory write plus a commit rather than a new reservation each time.
     size_t mAvailableSlots GUARDED_BY(sHintMutex) = 0;
+    size_t mUsedSlots GUARDED_BY(sHintMutex) = 0;
     bool mHalSupported = true;
     HalMessageQueue::MemTransaction mFmqTransaction GUARDED_BY(sHintMutex);
     std::future<bool> mChannelCreationFinished;
@@ -965,7 +968,7 @@ void FMQWrapper::stopChannel(IHintManager* manager) {
 template <HalChannelMessageContents::Tag T, class C>
 void FMQWrapper::writeBuffer(C* message, hal::SessionConfig& config, size_t count, int64_t now) {
     for (size_t i = 0; i < count; ++i) {
-        new (mFmqTransaction.getSlot(i)) hal::ChannelMessage{
+        new (mFmqTransaction.getSlot(mUsedSlots + i)) hal::ChannelMessage{
                 .sessionID = static_cast<int32_t>(config.id),
                 .timeStampNanos = now,
                 .data = HalChannelMessageContents::make<T, C>(std::move(*(message + i))),
@@ -979,7 +982,7 @@ void FMQWrapper::writeBuffer<HalChannelMessageContents::workDuration>(hal::WorkD
                                                                       size_t count, int64_t now) {
     for (size_t i = 0; i < count; ++i) {
         hal::WorkDuration& message = messages[i];
-        new (mFmqTransaction.getSlot(i)) hal::ChannelMessage{
+        new (mFmqTransaction.getSlot(mUsedSlots + i)) hal::ChannelMessage{
                 .sessionID = static_cast<int32_t>(config.id),
                 .timeStampNanos = (i == count - 1) ? now : message.timeStampNanos,
                 .data = HalChannelMessageContents::make<HalChannelMessageContents::workDuration,
@@ -999,8 +1002,9 @@ bool FMQWrapper::sendMessages(std::optional<hal::SessionConfig>& config, C* mess
     if (!isActiveLocked() || !config.has_value() || mCorrupted) {
         return false;
     }
-    // If we didn't reserve enough space, try re-creating the transaction
-    if (count > mAvailableSlots) {
+    // If the rest of the transaction is too small, try re-creating it, which also picks up the
+    // slots the reader has freed since
+    if (count > mAvailableSlots - mUsedSlots) {
         if (!updatePersistentTransaction()) {
             return false;
         }
@@ -1010,10 +1014,13 @@ bool FMQWrapper::sendMessages(std::optional<hal::SessionConfig>& config, C* mess
         }
     }
     writeBuffer<T, C>(message, *config, count, now);
+    // The slots after the committed ones stay reserved for us, as the reader can never get past
+    // the write pointer
     mQueue->commitWrite(count);
-    mEventFlag->wake(mWriteMask);
-    // Re-create the persistent transaction after writing
-    updatePersistentTransaction();
+    mUsedSlots += count;
+    if (mEventFlag != nullptr) {
+        mEventFlag->wake(mWriteMask);
+    }
     return true;
 }
 
@@ -1022,6 +1029,7 @@ void FMQWrapper::setToken(ndk::SpAIBinder& token) {
 }
 
 bool FMQWrapper::updatePersistentTransaction() {
+    mUsedSlots = 0;
     mAvailableSlots = mQueue->availableToWrite();
     if (mAvailableSlots > 0 && !mQueue->beginWrite(mAvailableSlots, &mFmqTransaction)) {
         ALOGE("ADPF FMQ became corrupted, falling back to binder calls!");
@@ -86,14 +86,7 @@ struct FontHasher {
 
 struct ASystemFontIterator {
     std::vector<AFont> fonts;
-    uint32_t index;
-
-    XmlDocUniquePtr mXmlDoc;
-
-    ParserState state;
-
-    // The OEM customization XML.
-    XmlDocUniquePtr mCustomizationXmlDoc;
+    uint32_t index = 0;
 };
 
 struct AFontMatcher {
@@ -236,6 +229,42 @@ bool findFirstFontNode(const XmlDocUniquePtr& doc, ParserState* state) {
 
 }  // namespace
 
+bool findNextFontNode(const XmlDocUniquePtr& xmlDoc, ParserState* state);
+
+namespace {
+
+// Appends the fonts listed in the given font configuration file whose files exist.
+void collectConfiguredFonts(const char* xmlPath, const std::string& pathPrefix,
+                            std::vector<AFont>* out) {
+    XmlDocUniquePtr xmlDoc(xmlReadFile(xmlPath, nullptr, 0));
+    if (!xmlDoc) {
+        return;
+    }
+    ParserState state;
+    while (findNextFontNode(xmlDoc, &state)) {
+        AFont font;
+        copyFont(xmlDoc, state, &font, pathPrefix);
+        if (isFontFileAvailable(font.mFilePath)) {
+            out->push_back(std::move(font));
+        }
+    }
+}
+
+// The fonts of the font configuration files, for processes that did not receive the system font
+// map. The files do not change while the process runs, so they are only parsed once.
+const std::vector<AFont>& getConfiguredFonts() {
+    static const std::vector<AFont>* fonts = [] {
+        auto* fonts = new std::vector<AFont>();
+        collectConfiguredFonts("/system/etc/fonts.xml", "/system/fonts/", fonts);
+        // TODO: Filter only customizationType="new-named-family"
+        collectConfiguredFonts("/product/etc/fonts_customization.xml", "/product/fonts/", fonts);
+        return fonts;
+    }();
+    return *fonts;
+}
+
+}  // namespace
+
 ASystemFontIterator* ASystemFontIterator_open() {
     std::unique_ptr<ASystemFontIterator> ite(new ASystemFontIterator());
 
@@ -262,11 +291,8 @@ ASystemFontIterator* ASystemFontIterator_open() {
             });
 
     if (fonts.empty()) {
-        ite->mXmlDoc.reset(xmlReadFile("/system/etc/fonts.xml", nullptr, 0));
-        ite->mCustomizationXmlDoc.reset(
-                xmlReadFile("/product/etc/fonts_customization.xml", nullptr, 0));
+        ite->fonts = getConfiguredFonts();
     } else {
-        ite->index = 0;
         ite->fonts.assign(fonts.begin(), fonts.end());
     }
     return ite.release();
@@ -363,42 +389,10 @@ bool findNextFontNode(const XmlDocUniquePtr& xmlDoc, ParserState* state) {
 
 AFont* ASystemFontIterator_next(ASystemFontIterator* ite) {
     LOG_ALWAYS_FATAL_IF(ite == nullptr, "nullptr has passed as iterator argument");
-    if (!ite->fonts.empty()) {
-        if (ite->index >= ite->fonts.size()) {
-            return nullptr;
-        }
-        return new AFont(ite->fonts[ite->index++]);
+    if (ite->index >= ite->fonts.size()) {
+        return nullptr;
     }
-
-    if (ite->mXmlDoc) {
-        if (!findNextFontNode(ite->mXmlDoc, &ite->state)) {
-            // Reached end of the XML file. Continue OEM customization.
-            ite->mXmlDoc.reset();
-        } else {
-            std::unique_ptr<AFont> font = std::make_unique<AFont>();
-            copyFont(ite->mXmlDoc, ite->state, font.get(), "/system/fonts/");
-            if (!isFontFileAvailable(font->mFilePath)) {
-                return ASystemFontIterator_next(ite);
-            }
-            return font.release();
-        }
-    }
-    if (ite->mCustomizationXmlDoc) {
-        // TODO: Filter only customizationType="new-named-family"
-        if (!findNextFontNode(ite->mCustomizationXmlDoc, &ite->state)) {
-            // Reached end of the XML file. Finishing
-            ite->mCustomizationXmlDoc.reset();
-            return nullptr;
-        } else {
-            std::unique_ptr<AFont> font = std::make_unique<AFont>();
-            copyFont(ite->mCustomizationXmlDoc, ite->state, font.get(), "/product/fonts/");
-            if (!isFontFileAvailable(font->mFilePath)) {
-                return ASystemFontIterator_next(ite);
-            }
-            return font.release();
-        }
-    }
-    return nullptr;
+    return new AFont(ite->fonts[ite->index++]);
 }
 
 void AFont_close(AFont* font) {
@@ -24,8 +24,10 @@
 #include <android-base/stringprintf.h>
 #include <android-base/unique_fd.h>
 #include <android_runtime/AndroidRuntime.h>
+#include <ctype.h>
 #include <cutils/compiler.h>
 #include <dirent.h>
+#include <inttypes.h>
 #include <jni.h>
 #include <linux/errno.h>
 #include <linux/time.h>
@@ -36,6 +38,8 @@
 #include <processgroup/processgroup.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <sys/pidfd.h>
 #include <sys/stat.h>
@@ -48,6 +52,7 @@
 
 #include <algorithm>
 #include <optional>
+#include <unordered_map>
 
 using android::base::StringPrintf;
 using android::base::WriteStringToFile;
@@ -59,6 +64,14 @@ static const size_t kPageMask = ~(kPageSize - 1);
 
 #define COMPACT_ACTION_FILE_FLAG 1
 #define COMPACT_ACTION_ANON_FLAG 2
+// Only page out VMAs that were mostly not referenced since the previous
+// compaction, see isWorkingSetVma.
+#define COMPACT_ACTION_WORKING_SET_FLAG 4
+
+// A VMA is considered part of the working set when at least this share
+// of its resident memory was referenced since the previous compaction.
+#define WORKING_SET_REFERENCED_PERCENT 25
+#define COMPACT_ACTION_MEMCG_FLAGS (COMPACT_ACTION_FILE_FLAG | COMPACT_ACTION_ANON_FLAG)
 
 using VmaToAdviseFunc = std::function<int(const Vma&)>;
 using android::base::unique_fd;
@@ -340,19 +353,115 @@ static int getAnyPageAdvice(const Vma& vma) {
     return MADV_COLD;
 }
 
+// Resident and referenced kB of each VMA of a process, by start address.
+struct VmaReferences {
+    uint64_t rssKb;
+    uint64_t referencedKb;
+};
+using ReferencedVmas = std::unordered_map<uint64_t, VmaReferences>;
+
+static uint64_t parseKb(const char* field) {
+    return strtoull(field + strcspn(field, "0123456789"), nullptr, 10);
+}
+
+// Reads how much of each VMA was referenced since the referenced bits
+// were last cleared through /proc/<pid>/clear_refs.
+static bool readReferencedVmas(int pid, ReferencedVmas* out) {
+    static std::string smaps;
+    smaps.clear();
+    if (!android::base::ReadFileToString(StringPrintf("/proc/%d/smaps", pid), &smaps)) {
+        return false;
+    }
+    VmaReferences* current = nullptr;
+    for (const char* line = smaps.c_str(); *line != '\0';) {
+        const char* end = strchrnul(line, '\n');
+        // VMA header lines start with the lowercase hex start address,
+        // field lines with a capitalized field name.
+        if (isdigit(*line) || (*line >= 'a' && *line <= 'f')) {
+            current = &(*out)[strtoull(line, nullptr, 16)];
+        } else if (current != nullptr) {
+            if (!strncmp(line, "Rss:", 4)) {
+                current->rssKb = parseKb(line);
+            } else if (!strncmp(line, "Referenced:", 11)) {
+                current->referencedKb = parseKb(line);
+            }
+        }
+        line = *end == '\0' ? end : end + 1;
+    }
+    return true;
+}
+
+static bool isWorkingSetVma(const ReferencedVmas& referenced, const Vma& vma) {
+    auto it = referenced.find(vma.start);
+    return it != referenced.end() && it->second.rssKb > 0 &&
+            it->second.referencedKb * 100 >= it->second.rssKb * WORKING_SET_REFERENCED_PERCENT;
+}
+
+static std::optional<uint64_t> readSwapKb(int pid) {
+    std::string rollup;
+    if (!android::base::ReadFileToString(StringPrintf("/proc/%d/smaps_rollup", pid), &rollup)) {
+        return {};
+    }
+    const size_t pos = rollup.find("\nSwap:");
+    if (pos == std::string::npos) {
+        return {};
+    }
+    return parseKb(rollup.c_str() + pos + 1);
+}
+
+// Swap usage of each process right after its last working set aware
+// compaction, in kB. Traced against the swap usage at the start of the
+// next one, to see how much of what was paged out was faulted back in.
+static std::unordered_map<int, uint64_t> swapAfterCompactionKb;
+
+static void traceSwapRefaulted(int pid) {
+    auto it = swapAfterCompactionKb.find(pid);
+    if (it == swapAfterCompactionKb.end()) return;
+    const uint64_t swapAfterKb = it->second;
+    swapAfterCompactionKb.erase(it);
+    std::optional<uint64_t> swapKb = readSwapKb(pid);
+    if (!swapKb || !ATRACE_ENABLED()) return;
+    const uint64_t refaultedKb = swapAfterKb > *swapKb ? swapAfterKb - *swapKb : 0;
+    ATRACE_INSTANT_FOR_TRACK(ATRACE_COMPACTION_TRACK,
+                             StringPrintf("Swap refaulted pid=%d: %" PRIu64 " kB", pid,
+                                          refaultedKb)
+                                     .c_str());
+}
+
 // Perform a full process compaction using process_madvise syscall
 // using the madvise behavior defined by vmaToAdviseFunc per VMA.
 //
 // Currently supported behaviors are MADV_COLD and MADV_PAGEOUT.
 //
+// With workingSetAware, VMAs that were largely referenced since the
+// previous compaction are only deactivated instead of paged out, so the
+// pages the app touches right after it is thawed stay resident. The
+// referenced bits are cleared afterwards to sample the next interval.
+//
 // Returns the total number of bytes compacted on success. On error
 // returns process_madvise errno code or if compaction was cancelled
 // it returns ERROR_COMPACTION_CANCELLED.
 //
 // Not thread safe. We reuse vectors so we assume this is called only
 // on one thread at most.
-static int64_t compactProcess(int pid, VmaToAdviseFunc vmaToAdviseFunc) {
+static int64_t compactProcess(int pid, VmaToAdviseFunc vmaToAdviseFunc, bool workingSetAware) {
     cancelRunningCompaction.store(false);
+    ReferencedVmas referenced;
+    if (workingSetAware) {
+        ATRACE_NAME("CollectReferencedVmas");
+        traceSwapRefaulted(pid);
+        if (readReferencedVmas(pid, &referenced)) {
+            vmaToAdviseFunc = [base = std::move(vmaToAdviseFunc), &referenced](const Vma& vma) {
+                int advice = base(vma);
+                if (advice == MADV_PAGEOUT && isWorkingSetVma(referenced, vma)) {
+                    return MADV_COLD;
+                }
+                return advice;
+            };
+        } else {
+            workingSetAware = false;
+        }
+    }
     static std::string mapsBuffer;
     ATRACE_BEGIN("CollectVmas");
     ProcMemInfo meminfo(pid);
@@ -405,6 +514,12 @@ static int64_t compactProcess(int pid, VmaToAdviseFunc vmaToAdviseFunc) {
         return coldBytes;
     }
 
+    if (workingSetAware) {
+        WriteStringToFile("1", StringPrintf("/proc/%d/clear_refs", pid));
+        if (std::optional<uint64_t> swapKb = readSwapKb(pid)) {
+            swapAfterCompactionKb[pid] = *swapKb;
+        }
+    }
     return pageoutBytes + coldBytes;
 }
 
@@ -427,7 +542,7 @@ static void compactProcess(int pid, int compactionFlags) {
         vmaToAdviseFunc = getFilePageAdvice;
     }
 
-    compactProcess(pid, vmaToAdviseFunc);
+    compactProcess(pid, vmaToAdviseFunc, compactionFlags & COMPACT_ACTION_WORKING_SET_FLAG);
 }
 
 static std::string profileFromCompactionFlags(int compactionFlags) {
@@ -447,6 +562,12 @@ static std::string profileFromCompactionFlags(int compactionFlags) {
 }
 
 static void compactMemcg(int uid, int pid, int compactionFlags) {
+    if (compactionFlags & COMPACT_ACTION_WORKING_SET_FLAG) {
+        // The memcg reclaim profiles have no notion of a working set, so
+        // fall back to compacting the process VMAs directly.
+        compactProcess(pid, compactionFlags);
+        return;
+    }
     if (std::string profile = profileFromCompactionFlags(compactionFlags); !profile.empty()) {
         SetProcessProfiles(uid, pid, {profile});
     }
@@ -536,12 +657,16 @@ static void com_android_server_am_CachedAppOptimizer_compactNativeProcess(JNIEnv
 
 static jboolean com_android_server_am_CachedAppOptimizer_compactionFlagsValidForMemcg(
         JNIEnv* env, jobject, jint compactionFlags) {
-    static std::array<std::optional<bool>, 3> valid;
+    static std::array<std::optional<bool>, COMPACT_ACTION_MEMCG_FLAGS + 1> valid;
 
-    if (compactionFlags >= valid.size() || compactionFlags < 0) {
+    if ((compactionFlags & ~(COMPACT_ACTION_MEMCG_FLAGS | COMPACT_ACTION_WORKING_SET_FLAG)) != 0) {
         jniThrowException(env, "java/lang/IllegalArgumentException", "Invalid compaction flags");
         return false;
     }
+    // Memcg compaction can't tell the working set apart, see compactMemcg.
+    if (compactionFlags & COMPACT_ACTION_WORKING_SET_FLAG) {
+        return false;
+    }
 
     if (!valid[compactionFlags]) {
         std::string profile = profileFromCompactionFlags(compactionFlags);
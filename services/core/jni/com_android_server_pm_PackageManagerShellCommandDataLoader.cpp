@@ -31,7 +31,10 @@
 
 #include <charconv>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <optional>
 #include <span>
 #include <string>
 #include <thread>
@@ -62,6 +65,8 @@ using MagicType = uint32_t;
 
 static constexpr int BUFFER_SIZE = 256 * 1024;
 static constexpr int BLOCKS_COUNT = BUFFER_SIZE / INCFS_DATA_FILE_BLOCK_SIZE;
+// How many buffers copyToIncFs reads ahead of the one it is writing.
+static constexpr int READ_AHEAD_BUFFERS = 3;
 
 static constexpr int COMMAND_SIZE = 4 + 2 + 2 + 4; // bytes
 static constexpr int HEADER_SIZE = 2 + 1 + 1 + 4 + 2; // bytes
@@ -358,6 +363,38 @@ static OnTraceChanged& onTraceChanged() {
     return *instance;
 }
 
+// Hands the buffers between the thread that reads the input and the one that writes it to IncFS.
+class BufferQueue {
+public:
+    void push(std::vector<char>&& buffer) {
+        std::lock_guard lock(mLock);
+        mBuffers.push_back(std::move(buffer));
+        mCondition.notify_one();
+    }
+    // Waits for a buffer. Returns nullopt once the queue is closed and empty.
+    std::optional<std::vector<char>> pop() {
+        std::unique_lock lock(mLock);
+        mCondition.wait(lock, [this] { return !mBuffers.empty() || mClosed; });
+        if (mBuffers.empty()) {
+            return {};
+        }
+        auto buffer = std::move(mBuffers.front());
+        mBuffers.pop_front();
+        return buffer;
+    }
+    void close() {
+        std::lock_guard lock(mLock);
+        mClosed = true;
+        mCondition.notify_all();
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    std::deque<std::vector<char>> mBuffers;
+    bool mClosed = false;
+};
+
 class PMSCDataLoader : public android::dataloader::DataLoader {
 public:
     PMSCDataLoader(JavaVM* jvm) : mJvm(jvm) { CHECK(mJvm); }
@@ -414,8 +451,10 @@ private:
                                                            jni.pmscdLookupShellCommand,
                                                            env->NewStringUTF(mArgs.c_str()));
 
-        std::vector<char> buffer;
-        buffer.reserve(BUFFER_SIZE);
+        std::vector<std::vector<char>> buffers(READ_AHEAD_BUFFERS + 1);
+        for (auto&& buffer : buffers) {
+            buffer.reserve(BUFFER_SIZE);
+        }
 
         std::vector<IncFsDataBlock> blocks;
         blocks.reserve(BLOCKS_COUNT);
@@ -446,7 +485,7 @@ private:
                     streamingMode = input.mode;
                 }
                 if (!copyToIncFs(incfsFd, input.size, input.kind, input.fd, input.waitOnEof,
-                                 &buffer, &blocks)) {
+                                 &buffers, &blocks)) {
                     ALOGE("Failed to copy data to IncFS file for metadata: %.*s, final file name "
                           "is: %s. "
                           "Error %d",
@@ -465,46 +504,86 @@ private:
         return true;
     }
 
+    // Reads the input on a separate thread, so that the next buffers are read while the
+    // current one is written to IncFS.
     bool copyToIncFs(borrowed_fd incfsFd, IncFsSize size, IncFsBlockKind kind,
-                     borrowed_fd incomingFd, bool waitOnEof, std::vector<char>* buffer,
+                     borrowed_fd incomingFd, bool waitOnEof, std::vector<std::vector<char>>* buffers,
                      std::vector<IncFsDataBlock>* blocks) {
-        IncFsSize remaining = size;
+        BufferQueue emptyBuffers;
+        BufferQueue fullBuffers;
+        for (auto&& buffer : *buffers) {
+            emptyBuffers.push(std::move(buffer));
+        }
+        buffers->clear();
+
+        bool readOk = true;
+        std::atomic<bool> writeFailed = false;
+        std::thread reader([&] {
+            readOk = readInput(size, incomingFd, waitOnEof, writeFailed, &emptyBuffers,
+                               &fullBuffers);
+            fullBuffers.close();
+        });
+
         IncFsBlockIndex blockIdx = 0;
-        while (remaining > 0) {
-            constexpr auto capacity = BUFFER_SIZE;
-            auto size = buffer->size();
-            if (capacity - size < INCFS_DATA_FILE_BLOCK_SIZE) {
-                if (!flashToIncFs(incfsFd, kind, false, &blockIdx, buffer, blocks)) {
-                    return false;
-                }
-                continue;
+        while (auto buffer = fullBuffers.pop()) {
+            // Every buffer but the last one is a whole number of blocks.
+            if (!writeFailed && !buffer->empty() &&
+                !flashToIncFs(incfsFd, kind, true, &blockIdx, &*buffer, blocks)) {
+                writeFailed = true;
             }
+            buffer->clear();
+            emptyBuffers.push(std::move(*buffer));
+        }
+        reader.join();
 
-            auto toRead = std::min<IncFsSize>(remaining, capacity - size);
-            buffer->resize(size + toRead);
-            auto read = ::read(incomingFd.get(), buffer->data() + size, toRead);
-            if (read == 0) {
-                if (waitOnEof) {
-                    // eof of stdin, waiting...
-                    if (doWaitOnEof()) {
-                        continue;
-                    } else {
-                        return false;
-                    }
-                }
+        emptyBuffers.close();
+        while (auto buffer = emptyBuffers.pop()) {
+            buffers->push_back(std::move(*buffer));
+        }
+        return readOk && !writeFailed;
+    }
+
+    // Fills the buffers of emptyBuffers with the input, in order, and passes them on to
+    // fullBuffers. Stops at the end of the input or once the writes failed.
+    bool readInput(IncFsSize size, borrowed_fd incomingFd, bool waitOnEof,
+                   const std::atomic<bool>& writeFailed, BufferQueue* emptyBuffers,
+                   BufferQueue* fullBuffers) {
+        IncFsSize remaining = size;
+        bool eof = false;
+        while (remaining > 0 && !eof && !writeFailed) {
+            auto buffer = emptyBuffers->pop();
+            if (!buffer) {
                 break;
             }
-            resetWaitOnEof();
+            constexpr auto capacity = BUFFER_SIZE;
+            while (remaining > 0 && buffer->size() < capacity) {
+                auto size = buffer->size();
+                auto toRead = std::min<IncFsSize>(remaining, capacity - size);
+                buffer->resize(size + toRead);
+                auto read = ::read(incomingFd.get(), buffer->data() + size, toRead);
+                if (read == 0) {
+                    buffer->resize(size);
+                    if (waitOnEof) {
+                        // eof of stdin, waiting...
+                        if (doWaitOnEof()) {
+                            continue;
+                        } else {
+                            return false;
+                        }
+                    }
+                    eof = true;
+                    break;
+                }
+                resetWaitOnEof();
 
-            if (read < 0) {
-                return false;
-            }
+                if (read < 0) {
+                    return false;
+                }
 
-            buffer->resize(size + read);
-            remaining -= read;
-        }
-        if (!buffer->empty() && !flashToIncFs(incfsFd, kind, true, &blockIdx, buffer, blocks)) {
-            return false;
+                buffer->resize(size + read);
+                remaining -= read;
+            }
+            fullBuffers->push(std::move(*buffer));
         }
         return true;
     }
@@ -37,7 +37,6 @@ static AStatsManager_PullAtomCallbackReturn onSurfaceFlingerPullCallback(int32_t
 
 static void initializeNativePullers(JNIEnv* env, jobject javaObject) {
     // Surface flinger layer & global info.
-    gSurfaceFlingerPuller = server::stats::SurfaceFlingerPuller();
     AStatsManager_setPullAtomCallback(android::surfaceflinger::stats::
                                               SURFACEFLINGER_STATS_GLOBAL_INFO,
                                       /* metadata= */ nullptr, onSurfaceFlingerPullCallback,
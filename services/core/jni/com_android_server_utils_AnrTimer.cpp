@@ -23,6 +23,8 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <iterator>
+#include <limits>
 #include <list>
 #include <map>
 #include <memory>
@@ -748,7 +750,7 @@ class AnrTimerService {
     AnrTimerService(const AnrTimerService&) = delete;
 
     // Insert a timer into the running list.  The lock must be held by the caller.
-    void insertLocked(const Timer&);
+    void insertLocked(Timer);
 
     // Remove a timer from the lists and return it. The lock must be held by the caller.
     Timer removeLocked(timer_id_t timerId);
@@ -884,6 +886,9 @@ class AnrTimerService::Timer {
     // The action to be taken at the scheduled timeout.
     SplitAction action;
 
+    // The handle of the timer in the Ticker while it is running.
+    uint32_t tickerHandle;
+
     // The token associated with the scheduled timeout.
     int32_t token;
 
@@ -915,6 +920,7 @@ class AnrTimerService::Timer {
             status(Invalid),
             scheduled(0),
             action(SplitAction::None),
+            tickerHandle(UINT32_MAX),
             token(0),
             extended(false),
             traced(false) {}
@@ -933,6 +939,7 @@ class AnrTimerService::Timer {
             status(Running),
             scheduled(0),
             action(SplitAction::None),
+            tickerHandle(UINT32_MAX),
             token(0),
             extended(false),
             traced(trace.enabled()) {
@@ -1109,20 +1116,42 @@ std::atomic<AnrTimerService::timer_id_t> AnrTimerService::Timer::idGen(1);
 
 /**
  * Manage a set of timers and notify clients when there is a timeout.
+ *
+ * Timers are kept in a hierarchical timing wheel.  Starting and canceling timers is by far the
+ * common case, and most timers are canceled long before they expire, so both are O(1) and do not
+ * allocate once the entry pool has grown to the working size.  Only the monitor thread pays for
+ * keeping the wheel ordered as time advances.
+ *
+ * Time is divided into ticks of 2^kTickShift ns (about 1ms).  Each level of the wheel has kSlots
+ * slots.  A timer sits on the lowest level L at which its tick and the current tick agree on
+ * every digit above L, in the slot given by its own digit L.  Within a level, a higher slot is
+ * therefore strictly later, and every timer on a lower level is earlier than every timer on a
+ * higher one.  When the current tick enters a new window of level L, the timers in the slot for
+ * that window move down.  Timers beyond the top level wait in an overflow list.  Expiration is
+ * still exact: a timer expires when the clock reaches its scheduled time, not its tick.
  */
 class AnrTimerService::Ticker {
+  public:
+    // A handle to a timer in the ticker.  It is returned by insert() and passed to remove().
+    using handle_t = uint32_t;
+    static constexpr handle_t NOHANDLE = UINT32_MAX;
+
   private:
+    static constexpr int kTickShift = 20;
+    static constexpr int kSlotBits = 6;
+    static constexpr int kSlots = 1 << kSlotBits;
+    static constexpr int kLevels = 4;
+    // The index of the overflow list, after the kLevels * kSlots slot lists.
+    static constexpr int kOverflow = kLevels * kSlots;
+
     struct Entry {
-        const nsecs_t scheduled;
-        const timer_id_t id;
+        nsecs_t scheduled;
+        timer_id_t id;
         AnrTimerService* service;
-
-        Entry(nsecs_t scheduled, timer_id_t id, AnrTimerService* service) :
-                scheduled(scheduled), id(id), service(service) {};
-
-        bool operator<(const Entry& r) const {
-            return scheduled == r.scheduled ? id < r.id : scheduled < r.scheduled;
-        }
+        // The list that holds the entry, or -1 if the entry is free.
+        int list;
+        handle_t prev;
+        handle_t next;
     };
 
   public:
@@ -1130,6 +1159,7 @@ class AnrTimerService::Ticker {
     // Construct the ticker.  This creates the timerfd file descriptor and starts the monitor
     // thread.  The monitor thread is given a unique name.
     Ticker(std::unique_ptr<Clock> clock) : clock_(std::move(clock)), id_(idGen_.fetch_add(1)) {
+        std::fill(std::begin(heads_), std::end(heads_), NOHANDLE);
         if (pthread_create(&watcher_, 0, run, this) != 0) {
             ALOGE("failed to start thread: %s", strerror(errno));
             watcher_ = 0;
@@ -1157,35 +1187,46 @@ class AnrTimerService::Ticker {
     }
 
     // Insert a timer.  Unless canceled, the timer will expire at the scheduled time.  If it
-    // expires, the service will be notified with the id.
-    void insert(nsecs_t scheduled, timer_id_t id, AnrTimerService *service) {
-        Entry e(scheduled, id, service);
+    // expires, the service will be notified with the id.  The returned handle identifies the
+    // timer to remove().
+    handle_t insert(nsecs_t scheduled, timer_id_t id, AnrTimerService *service) {
         AutoMutex _l(lock_);
-        timer_id_t front = headTimerId();
-        running_.insert(e);
-        if (front != headTimerId()) restartLocked();
-        maxRunning_ = std::max(maxRunning_, running_.size());
-    }
-
-    // Remove a timer.  The timer is identified by its scheduled timeout and id.  Technically,
-    // the id is sufficient (because timer IDs are unique) but using the timeout is more
-    // efficient.
-    void remove(nsecs_t scheduled, timer_id_t id) {
-        Entry key(scheduled, id, 0);
+        if (count_ == 0) {
+            // Nothing is on the wheel, so it can jump to the present without any work.
+            currentTick_ = std::max(currentTick_, tickOf(now()));
+        }
+        handle_t h = allocLocked();
+        entries_[h] = Entry{scheduled, id, service, -1, NOHANDLE, NOHANDLE};
+        linkLocked(h);
+        count_++;
+        // The clock only needs to be reprogrammed if this timer expires before the time the
+        // clock is armed for.  Canceling timers never reprograms the clock.
+        if (count_ == 1 || scheduled < armed_) restartLocked();
+        maxRunning_ = std::max(maxRunning_, count_);
+        return h;
+    }
+
+    // Remove a timer.  The timer is identified by its handle and id.  A handle whose timer has
+    // already expired may have been reused, so the id must match for the removal to happen.
+    void remove(handle_t handle, timer_id_t id) {
         AutoMutex _l(lock_);
-        auto found = running_.find(key);
-        if (found != running_.end()) running_.erase(found);
-        if (running_.empty()) drained_++;
+        if (handle < entries_.size() && entries_[handle].list >= 0 &&
+            entries_[handle].id == id) {
+            unlinkLocked(handle);
+            releaseLocked(handle);
+            count_--;
+        }
+        if (count_ == 0) drained_++;
     }
 
     // Remove every timer associated with the service.
     void remove(const AnrTimerService* service) {
         AutoMutex _l(lock_);
-        for (auto i = running_.begin(); i != running_.end(); ) {
-            if (i->service == service) {
-                i = running_.erase(i);
-            } else {
-                i++;
+        for (handle_t h = 0; h < entries_.size(); h++) {
+            if (entries_[h].list >= 0 && entries_[h].service == service) {
+                unlinkLocked(h);
+                releaseLocked(h);
+                count_--;
             }
         }
     }
@@ -1198,7 +1239,7 @@ class AnrTimerService::Ticker {
     // Return the number of timers still running.
     size_t running() const {
         AutoMutex _l(lock_);
-        return running_.size();
+        return count_;
     }
 
     // Return the high-water mark of timers running.
@@ -1215,9 +1256,149 @@ class AnrTimerService::Ticker {
 
   private:
 
-    // Return the head of the running list.  The lock must be held by the caller.
-    timer_id_t headTimerId() {
-        return running_.empty() ? NOTIMER : running_.cbegin()->id;
+    static uint64_t tickOf(nsecs_t t) {
+        return t <= 0 ? 0 : static_cast<uint64_t>(t) >> kTickShift;
+    }
+
+    static int digit(uint64_t tick, int level) {
+        return (tick >> (kSlotBits * level)) & (kSlots - 1);
+    }
+
+    // Return the list for a timer at the given tick.  Timers that are already due go in the
+    // current slot.  The lock must be held by the caller.
+    int listForLocked(uint64_t tick) const {
+        if (tick <= currentTick_) return digit(currentTick_, 0);
+        for (int level = 0; level < kLevels; level++) {
+            const int shift = kSlotBits * (level + 1);
+            if ((tick >> shift) == (currentTick_ >> shift)) {
+                return level * kSlots + digit(tick, level);
+            }
+        }
+        return kOverflow;
+    }
+
+    // The lock must be held by the caller for all of the list operations.
+    void linkLocked(handle_t h) {
+        Entry& e = entries_[h];
+        e.list = listForLocked(tickOf(e.scheduled));
+        e.prev = NOHANDLE;
+        e.next = heads_[e.list];
+        if (e.next != NOHANDLE) entries_[e.next].prev = h;
+        heads_[e.list] = h;
+        if (e.list != kOverflow) occupied_[e.list / kSlots] |= uint64_t(1) << (e.list % kSlots);
+    }
+
+    void unlinkLocked(handle_t h) {
+        Entry& e = entries_[h];
+        if (e.prev != NOHANDLE) {
+            entries_[e.prev].next = e.next;
+        } else {
+            heads_[e.list] = e.next;
+        }
+        if (e.next != NOHANDLE) entries_[e.next].prev = e.prev;
+        if (heads_[e.list] == NOHANDLE && e.list != kOverflow) {
+            occupied_[e.list / kSlots] &= ~(uint64_t(1) << (e.list % kSlots));
+        }
+    }
+
+    handle_t allocLocked() {
+        if (free_ == NOHANDLE) {
+            entries_.emplace_back();
+            return entries_.size() - 1;
+        }
+        handle_t h = free_;
+        free_ = entries_[h].next;
+        return h;
+    }
+
+    void releaseLocked(handle_t h) {
+        entries_[h].list = -1;
+        entries_[h].next = free_;
+        free_ = h;
+    }
+
+    // Move every timer on a list to the list it belongs on now.
+    void cascadeLocked(int list) {
+        handle_t h = heads_[list];
+        heads_[list] = NOHANDLE;
+        if (list != kOverflow) occupied_[list / kSlots] &= ~(uint64_t(1) << (list % kSlots));
+        while (h != NOHANDLE) {
+            const handle_t next = entries_[h].next;
+            linkLocked(h);
+            h = next;
+        }
+    }
+
+    // The current tick has just entered a new level 0 window.  Move the timers of every level
+    // whose window begins here down, starting with the highest.
+    void enterWindowLocked() {
+        int top = 1;
+        while (top < kLevels &&
+               (currentTick_ & ((uint64_t(1) << (kSlotBits * (top + 1))) - 1)) == 0) {
+            top++;
+        }
+        if (top == kLevels) {
+            cascadeLocked(kOverflow);
+            top = kLevels - 1;
+        }
+        for (int level = top; level >= 1; level--) {
+            cascadeLocked(level * kSlots + digit(currentTick_, level));
+        }
+    }
+
+    // Move the timers in the current slot that are due at 'current' into 'ready'.
+    void collectLocked(nsecs_t current, std::vector<Entry>* ready) {
+        handle_t h = heads_[digit(currentTick_, 0)];
+        while (h != NOHANDLE) {
+            const handle_t next = entries_[h].next;
+            if (entries_[h].scheduled <= current) {
+                ready->push_back(entries_[h]);
+                unlinkLocked(h);
+                releaseLocked(h);
+                count_--;
+            }
+            h = next;
+        }
+    }
+
+    // Advance the wheel to 'current' and move every timer that is due into 'ready'.
+    void advanceLocked(nsecs_t current, std::vector<Entry>* ready) {
+        const uint64_t target = tickOf(current);
+        if (count_ == 0) {
+            currentTick_ = std::max(currentTick_, target);
+            return;
+        }
+        while (true) {
+            collectLocked(current, ready);
+            if (currentTick_ >= target) break;
+            // Skip to the next occupied slot in this level 0 window or, if there is none, to the
+            // start of the next window.
+            const int d = digit(currentTick_, 0);
+            const uint64_t later = d == kSlots - 1 ? 0 : occupied_[0] & (~uint64_t(0) << (d + 1));
+            const uint64_t next = later != 0
+                    ? (currentTick_ & ~uint64_t(kSlots - 1)) + __builtin_ctzll(later)
+                    : (currentTick_ | (kSlots - 1)) + 1;
+            currentTick_ = std::min(next, target);
+            if (digit(currentTick_, 0) == 0) enterWindowLocked();
+        }
+    }
+
+    // Return the earliest scheduled time of any timer.  There must be at least one timer.
+    nsecs_t earliestLocked() const {
+        // Slots below the current position are always empty, so the lowest occupied slot of
+        // the lowest occupied level holds the earliest timers.
+        int list = kOverflow;
+        for (int level = 0; level < kLevels; level++) {
+            if (occupied_[level] != 0) {
+                list = level * kSlots + __builtin_ctzll(occupied_[level]);
+                break;
+            }
+        }
+        nsecs_t earliest = std::numeric_limits<nsecs_t>::max();
+        for (handle_t h = heads_[list]; h != NOHANDLE; h = entries_[h].next) {
+            earliest = std::min(earliest, entries_[h].scheduled);
+        }
+        return earliest;
     }
 
     // A simple wrapper that meets the requirements of pthread_create.
@@ -1231,30 +1412,26 @@ class AnrTimerService::Ticker {
     // enclosing Ticker is being deleted and the thread has been canceled.  The thread must
     // exit.
     void monitor() {
+        std::vector<Entry> ready;
         while (clock_->waitForTimer()) {
             // Move expired timers into the local ready list.  This is done inside
             // the lock.  Then, outside the lock, expire them.
             nsecs_t current = now();
-            std::vector<Entry> ready;
+            ready.clear();
             {
                 AutoMutex _l(lock_);
-                while (!running_.empty()) {
-                    Entry timer = *(running_.begin());
-                    if (timer.scheduled <= current) {
-                        ready.push_back(timer);
-                        running_.erase(running_.cbegin());
-                    } else {
-                        break;
-                    }
-                }
+                advanceLocked(current, &ready);
                 restartLocked();
             }
+            // Slots are not sorted, so order the batch to expire timers in scheduled order.
+            std::sort(ready.begin(), ready.end(), [](const Entry& l, const Entry& r) {
+                return l.scheduled == r.scheduled ? l.id < r.id : l.scheduled < r.scheduled;
+            });
 
             // Call the notifiers outside the lock.  Calling the notifiers with the lock held
             // can lead to deadlock, if the Java-side handler also takes a lock.  Note that the
             // timerfd is already running.
-            for (auto i = ready.begin(); i != ready.end(); i++) {
-                Entry e = *i;
+            for (const Entry& e : ready) {
                 e.service->expire(e.id);
             }
         }
@@ -1263,13 +1440,13 @@ class AnrTimerService::Ticker {
     }
 
     // Restart the ticker.  The caller must be holding the lock.  This method updates the
-    // timerFd_ to expire at the time of the first Entry in the running list.  This method does
-    // not check to see if the currently programmed expiration time is different from the
-    // scheduled expiration time of the first entry.
+    // timerFd_ to expire at the time of the earliest timer.  This method does not check to see
+    // if the currently programmed expiration time is different from the scheduled expiration
+    // time of the earliest timer.
     void restartLocked() {
-        if (!running_.empty()) {
-            const Entry x = *(running_.cbegin());
-            nsecs_t delay = x.scheduled - now();
+        if (count_ > 0) {
+            armed_ = earliestLocked();
+            nsecs_t delay = armed_ - now();
             // Force a minimum timeout of 10ns.
             if (delay < 10) delay = 10;
             clock_->setTimer(delay);
@@ -1303,9 +1480,24 @@ class AnrTimerService::Ticker {
     // The highwater mark of timers that are running.
     size_t maxRunning_ = 0;
 
-    // The list of timers that are scheduled.  This set is sorted by timeout and then by timer
-    // ID.  A set is sufficient (as opposed to a multiset) because timer IDs are unique.
-    std::set<Entry> running_;
+    // The number of timers that are scheduled.
+    size_t count_ = 0;
+
+    // The scheduled time the clock was last armed for.  No running timer is earlier.
+    nsecs_t armed_ = 0;
+
+    // The tick the wheel has advanced to.  Every timer due before it has been expired.
+    uint64_t currentTick_ = 0;
+
+    // The entry pool.  Handles are indices into it, and free entries are chained through next.
+    std::vector<Entry> entries_;
+    handle_t free_ = NOHANDLE;
+
+    // The head of every slot list and of the overflow list.
+    handle_t heads_[kOverflow + 1];
+
+    // One bit per non-empty slot, for every level.
+    uint64_t occupied_[kLevels] = {};
 
     // A unique ID assigned to this instance.
     const size_t id_;
@@ -1450,12 +1642,14 @@ void AnrTimerService::expire(timer_id_t timerId) {
     }
 }
 
-void AnrTimerService::insertLocked(const Timer& t) {
-    running_.insert(t);
+void AnrTimerService::insertLocked(Timer t) {
     if (t.status == Running) {
         // Only forward running timers to the ticker.  Expired timers are handled separately.
-        ticker_->insert(t.scheduled, t.id, this);
+        t.tickerHandle = ticker_->insert(t.scheduled, t.id, this);
+    } else {
+        t.tickerHandle = UINT32_MAX;
     }
+    running_.insert(t);
     maxRunning_ = std::max(maxRunning_, running_.size());
 }
 
@@ -1465,7 +1659,7 @@ AnrTimerService::Timer AnrTimerService::removeLocked(timer_id_t timerId) {
     if (found != running_.end()) {
         Timer result = *found;
         running_.erase(found);
-        ticker_->remove(result.scheduled, result.id);
+        ticker_->remove(result.tickerHandle, result.id);
         if (running_.size() == 0) counters_.drained++;
         return result;
     }
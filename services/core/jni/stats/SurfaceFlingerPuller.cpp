@@ -23,6 +23,7 @@
 #include <statslog_surfaceflinger.h>
 #include <timestatsatomsproto/TimeStatsAtomsProtoHeader.h>
 
+#include <cstdlib>
 #include <vector>
 
 namespace android {
@@ -33,6 +34,12 @@ using android::surfaceflinger::stats::BytesField;
 using std::optional;
 
 namespace {
+constexpr int32_t kGlobalInfo = android::surfaceflinger::stats::SURFACEFLINGER_STATS_GLOBAL_INFO;
+constexpr int32_t kLayerInfo = android::surfaceflinger::stats::SURFACEFLINGER_STATS_LAYER_INFO;
+
+// Pulls of the two atoms this close together are taken to be in the same round.
+constexpr nsecs_t kPullRoundNs = 10'000'000'000;
+
 optional<BytesField> getBytes(const google::protobuf::MessageLite& proto, std::string& data) {
     if (!proto.SerializeToString(&data)) {
         ALOGW("Unable to serialize surface flinger bytes field");
@@ -42,30 +49,105 @@ optional<BytesField> getBytes(const google::protobuf::MessageLite& proto, std::s
 }
 } // namespace
 
-AStatsManager_PullAtomCallbackReturn SurfaceFlingerPuller::pull(int32_t atomTag,
-                                                                AStatsEventList* data) {
-    // Don't need mutexes here, since there is no global state.
-    // SurfaceComposerClient is thread safe, and surfaceflinger is internally thread safe.
-
+bool SurfaceFlingerPuller::fetch(int32_t atomTag, std::string* proto) {
     bool success = false;
-    std::string pullDataProto;
-    status_t err = SurfaceComposerClient::onPullAtom(atomTag, &pullDataProto, &success);
+    status_t err = SurfaceComposerClient::onPullAtom(atomTag, proto, &success);
     if (!success || err != NO_ERROR) {
         ALOGW("Failed to pull atom %" PRId32
               " from surfaceflinger. Success is %d, binder status is %s",
               atomTag, (int)success, binder::Status::exceptionToString(err).c_str());
+        return false;
+    }
+    return true;
+}
+
+SurfaceFlingerPuller::~SurfaceFlingerPuller() {
+    std::lock_guard threadLock(mPrefetchThreadLock);
+    if (mPrefetchThread.joinable()) mPrefetchThread.join();
+}
+
+bool SurfaceFlingerPuller::takePrefetched(int32_t atomTag, nsecs_t now, std::string* proto,
+                                          bool* stale) {
+    std::unique_lock lock(mLock);
+    auto found = mPrefetch.find(atomTag);
+    if (found == mPrefetch.end()) return false;
+    mPrefetchDone.wait(lock, [&found] { return !found->second.inFlight; });
+    const bool ready = found->second.ready;
+    if (ready) {
+        proto->swap(found->second.proto);
+        *stale = now - found->second.fetchedAt > kPullRoundNs;
+    }
+    mPrefetch.erase(found);
+    return ready;
+}
+
+void SurfaceFlingerPuller::maybePrefetchPartner(int32_t atomTag, nsecs_t now) {
+    const int32_t partner = atomTag == kGlobalInfo ? kLayerInfo : kGlobalInfo;
+    {
+        std::lock_guard lock(mLock);
+        // Only prefetch if the two atoms were pulled together in the previous round.
+        auto last = mLastPull.find(atomTag);
+        auto partnerLast = mLastPull.find(partner);
+        const bool paired = last != mLastPull.end() && partnerLast != mLastPull.end() &&
+                std::abs(last->second - partnerLast->second) <= kPullRoundNs;
+        mLastPull[atomTag] = now;
+        if (!paired || mPrefetch.count(partner) != 0) return;
+        mPrefetch[partner].inFlight = true;
+    }
+
+    // Only one prefetch runs at a time; wait for the previous one to finish before starting.
+    std::lock_guard threadLock(mPrefetchThreadLock);
+    if (mPrefetchThread.joinable()) mPrefetchThread.join();
+    mPrefetchThread = std::thread([this, partner] {
+        std::string proto;
+        const bool ready = fetch(partner, &proto);
+        std::lock_guard lock(mLock);
+        Prefetch& prefetch = mPrefetch[partner];
+        prefetch.inFlight = false;
+        prefetch.ready = ready;
+        prefetch.fetchedAt = systemTime(SYSTEM_TIME_MONOTONIC);
+        prefetch.proto = std::move(proto);
+        mPrefetchDone.notify_all();
+    });
+}
+
+AStatsManager_PullAtomCallbackReturn SurfaceFlingerPuller::pull(int32_t atomTag,
+                                                                AStatsEventList* data) {
+    // SurfaceComposerClient is thread safe, and surfaceflinger is internally thread safe.  The
+    // lock only guards the prefetched results.
+    if (atomTag != kGlobalInfo && atomTag != kLayerInfo) {
+        ALOGW("Invalid atom id for surfaceflinger pullers: %" PRId32, atomTag);
         return AStatsManager_PULL_SKIP;
     }
 
-    switch (atomTag) {
-        case android::surfaceflinger::stats::SURFACEFLINGER_STATS_GLOBAL_INFO:
-            return parseGlobalInfoPull(pullDataProto, data);
-        case android::surfaceflinger::stats::SURFACEFLINGER_STATS_LAYER_INFO:
-            return parseLayerInfoPull(pullDataProto, data);
-        default:
-            ALOGW("Invalid atom id for surfaceflinger pullers: %" PRId32, atomTag);
+    const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    std::string pullDataProto;
+    bool stale = false;
+    if (!takePrefetched(atomTag, now, &pullDataProto, &stale)) {
+        // Nothing was prefetched for this round, so this is the first pull of the round.
+        maybePrefetchPartner(atomTag, now);
+        if (!fetch(atomTag, &pullDataProto)) {
             return AStatsManager_PULL_SKIP;
+        }
+    } else {
+        std::lock_guard lock(mLock);
+        mLastPull[atomTag] = now;
+    }
+
+    auto parse = [this, atomTag, data](const std::string& proto) {
+        return atomTag == kGlobalInfo ? parseGlobalInfoPull(proto, data)
+                                      : parseLayerInfoPull(proto, data);
+    };
+    AStatsManager_PullAtomCallbackReturn result = parse(pullDataProto);
+    if (stale && result == AStatsManager_PULL_SUCCESS) {
+        // The prefetch was not taken in its own round. Surfaceflinger has counted since, so
+        // the rest of this pull's interval has to be fetched too.
+        std::string restProto;
+        if (fetch(atomTag, &restProto)) {
+            result = parse(restProto);
+        }
     }
+    return result;
 }
 
 AStatsManager_PullAtomCallbackReturn SurfaceFlingerPuller::parseGlobalInfoPull(
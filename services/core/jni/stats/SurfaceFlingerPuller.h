@@ -19,6 +19,13 @@
 #include <stats_event.h>
 #include <stats_pull_atom_callback.h>
 #include <utils/String16.h>
+#include <utils/Timers.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
 
 namespace android {
 namespace server {
@@ -27,12 +34,46 @@ namespace stats {
 /**
  * Pulls data from surfaceflinger.
  * The indirection is needed because surfaceflinger is a bootstrap process.
+ *
+ * The global and layer atoms are separate binder calls to surfaceflinger.  When statsd pulls
+ * both in the same round, the pull of one fetches the other concurrently, and the result is
+ * handed to the next pull of that atom.  Surfaceflinger resets its counters on every pull, so a
+ * prefetched result is used exactly once and never shared between pulls.  A prefetched result
+ * that is older than a round only covers the start of the interval being pulled, so the rest is
+ * fetched as well and both are reported by that pull.
  */
 class SurfaceFlingerPuller {
 public:
+    ~SurfaceFlingerPuller();
+
     AStatsManager_PullAtomCallbackReturn pull(int32_t atomTag, AStatsEventList* data);
 
 private:
+    struct Prefetch {
+        bool inFlight = false;
+        bool ready = false;
+        nsecs_t fetchedAt = 0;
+        std::string proto;
+    };
+
+    // Fetch the serialized atoms from surfaceflinger.
+    static bool fetch(int32_t atomTag, std::string* proto);
+    // Take the prefetched result for the atom, waiting for it if it is still being fetched.
+    // Sets stale if the result was fetched longer than a round before now.
+    bool takePrefetched(int32_t atomTag, nsecs_t now, std::string* proto, bool* stale);
+    // Start fetching the partner of the atom if both are being pulled in the same round.
+    void maybePrefetchPartner(int32_t atomTag, nsecs_t now);
+
+    std::mutex mLock;
+    std::condition_variable mPrefetchDone;
+    std::map<int32_t, Prefetch> mPrefetch;
+    std::map<int32_t, nsecs_t> mLastPull;
+
+    // The thread of the latest prefetch, joined before the next one starts and on destruction.
+    // Guarded by its own lock, as the thread itself takes mLock.
+    std::mutex mPrefetchThreadLock;
+    std::thread mPrefetchThread;
+
     AStatsManager_PullAtomCallbackReturn parseGlobalInfoPull(const std::string& protoData,
                                                              AStatsEventList* data);
     AStatsManager_PullAtomCallbackReturn parseLayerInfoPull(const std::string& protoData,
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "IncrementalService"
+
+#include "AccessProfile.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Metadata.pb.h"
+
+namespace android::incremental {
+
+static std::string toKey(const incfs::FileId& fileId) {
+    return {fileId.data, sizeof(fileId.data)};
+}
+
+bool AccessProfile::record(const incfs::FileId& fileId, incfs::BlockIndex block) {
+    if (full()) {
+        return false;
+    }
+    if (block < 0 || !mSeen[toKey(fileId)].insert(block).second) {
+        return true;
+    }
+    ++mBlocks;
+    if (!mRanges.empty()) {
+        auto& last = mRanges.back();
+        if (last.end == block && !memcmp(last.fileId.data, fileId.data, sizeof(fileId.data))) {
+            ++last.end;
+            return true;
+        }
+    }
+    mRanges.push_back({fileId, block, block + 1});
+    return true;
+}
+
+std::string AccessProfile::serialize() const {
+    metadata::AccessProfile profile;
+    for (auto&& range : mRanges) {
+        auto* message = profile.add_ranges();
+        message->set_file_id(toKey(range.fileId));
+        message->set_begin(range.begin);
+        message->set_end(range.end);
+    }
+    return profile.SerializeAsString();
+}
+
+std::optional<AccessProfile> AccessProfile::parse(std::string_view data, size_t maxBlocks) {
+    metadata::AccessProfile profile;
+    if (!profile.ParseFromArray(data.data(), data.size())) {
+        return {};
+    }
+    AccessProfile result(maxBlocks);
+    for (auto&& range : profile.ranges()) {
+        incfs::FileId fileId;
+        if (range.file_id().size() != sizeof(fileId.data) || range.begin() < 0 ||
+            range.begin() >= range.end()) {
+            return {};
+        }
+        memcpy(fileId.data, range.file_id().data(), sizeof(fileId.data));
+        for (auto block = range.begin(); block < range.end(); ++block) {
+            if (!result.record(fileId, block)) {
+                return result;
+            }
+        }
+    }
+    return result;
+}
+
+bool AccessProfile::save(const std::string& path) const {
+    // Never leave a partially written profile behind.
+    const auto tmpPath = path + ".tmp";
+    if (!base::WriteStringToFile(serialize(), tmpPath)) {
+        PLOG(ERROR) << "Failed to write access profile " << tmpPath;
+        return false;
+    }
+    if (::rename(tmpPath.c_str(), path.c_str())) {
+        PLOG(ERROR) << "Failed to rename access profile to " << path;
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::optional<AccessProfile> AccessProfile::load(const std::string& path) {
+    std::string data;
+    if (!base::ReadFileToString(path, &data)) {
+        return {};
+    }
+    return parse(data);
+}
+
+} // namespace android::incremental
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "incfs.h"
+
+namespace android::incremental {
+
+// The order in which an app read the blocks of its files the first time it ran, as seen in the
+// IncFS page read logs. Each block is recorded once, on its first read, and consecutive blocks of
+// the same file are merged into a range, so that a data loader can stream the files in the same
+// order on the next install instead of serving the reads as they miss.
+class AccessProfile {
+public:
+    // Blocks [begin, end) of the file.
+    struct Range {
+        incfs::FileId fileId;
+        incfs::BlockIndex begin;
+        incfs::BlockIndex end;
+    };
+
+    // 256MB worth of 4K blocks.
+    static constexpr size_t kDefaultMaxBlocks = 64 * 1024;
+
+    explicit AccessProfile(size_t maxBlocks = kDefaultMaxBlocks) : mMaxBlocks(maxBlocks) {}
+
+    // Returns false if the profile is full.
+    bool record(const incfs::FileId& fileId, incfs::BlockIndex block);
+
+    bool full() const { return mBlocks >= mMaxBlocks; }
+    bool empty() const { return mRanges.empty(); }
+    size_t blocks() const { return mBlocks; }
+    const std::vector<Range>& ranges() const { return mRanges; }
+
+    std::string serialize() const;
+    static std::optional<AccessProfile> parse(std::string_view data,
+                                              size_t maxBlocks = kDefaultMaxBlocks);
+
+    bool save(const std::string& path) const;
+    static std::optional<AccessProfile> load(const std::string& path);
+
+private:
+    size_t mMaxBlocks;
+    size_t mBlocks = 0;
+    std::vector<Range> mRanges;
+    // The blocks read so far, by raw file id.
+    std::unordered_map<std::string, std::unordered_set<incfs::BlockIndex>> mSeen;
+};
+
+} // namespace android::incremental
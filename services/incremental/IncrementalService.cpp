@@ -61,6 +61,7 @@ struct Constants {
     static constexpr auto mountpointMdPrefix = ".mountpoint."sv;
     static constexpr auto infoMdName = ".info"sv;
     static constexpr auto readLogsDisabledMarkerName = ".readlogs_disabled"sv;
+    static constexpr auto accessProfileName = ".access_profile"sv;
     static constexpr auto libDir = "lib"sv;
     static constexpr auto libSuffix = ".so"sv;
     static constexpr auto blockSize = 4096;
@@ -90,6 +91,13 @@ struct Constants {
     // Max interval after system invoked the DL when readlog collection can be enabled.
     static constexpr auto readLogsMaxInterval = 2h;
 
+    // For how long after readlogs got enabled the page reads go into the access profile.
+    static constexpr auto accessProfileWindow = 1min;
+    static constexpr auto maxPageReadsBatches = 16;
+
+    // Threads extracting native libraries at the same time, each holding a library in memory.
+    static constexpr size_t maxJobThreads = 4;
+
     // How long should we wait till dataLoader reports destroyed.
     static constexpr auto destroyTimeout = 10s;
 
@@ -332,6 +340,7 @@ static int rmDirContent(const char* path) {
 }
 
 void IncrementalService::IncFsMount::cleanupFilesystem(std::string_view root) {
+    ::unlink(path::join(root, constants().accessProfileName).c_str());
     rmDirContent(path::join(root, constants().backing).c_str());
     ::rmdir(path::join(root, constants().backing).c_str());
     ::rmdir(path::join(root, constants().mount).c_str());
@@ -435,7 +444,7 @@ void IncrementalService::onDump(int fd) {
     dprintf(fd, "IncFs features: 0x%x\n", int(mIncFs->features()));
     dprintf(fd, "Incremental dir: %s\n", mIncrementalDir.c_str());
 
-    std::unique_lock l(mLock);
+    std::shared_lock l(mLock);
 
     dprintf(fd, "Mounts (%d): {\n", int(mMounts.size()));
     for (auto&& [id, ifs] : mMounts) {
@@ -554,7 +563,7 @@ void IncrementalService::onSystemReady() {
 
     std::vector<IfsMountPtr> mounts;
     {
-        std::lock_guard l(mLock);
+        std::shared_lock l(mLock);
         mounts.reserve(mMounts.size());
         for (auto&& [id, ifs] : mMounts) {
             std::unique_lock ll(ifs->lock);
@@ -883,7 +892,7 @@ IncrementalService::BindPathMap::const_iterator IncrementalService::findStorageL
 }
 
 StorageId IncrementalService::findStorageId(std::string_view path) const {
-    std::lock_guard l(mLock);
+    std::shared_lock l(mLock);
     auto it = findStorageLocked(path);
     if (it == mBindsByPath.end()) {
         return kInvalidStorageId;
@@ -925,6 +934,7 @@ int IncrementalService::setStorageParams(StorageId storageId, bool enableReadLog
     }
 
     std::string packageName;
+    bool wasEnabled = false;
 
     {
         std::unique_lock l(ifs->lock);
@@ -980,6 +990,7 @@ int IncrementalService::setStorageParams(StorageId storageId, bool enableReadLog
         if (!ifs->readLogsRequested()) {
             return 0;
         }
+        wasEnabled = ifs->readLogsEnabled();
         if (auto status = applyStorageParamsLocked(*ifs); status != 0) {
             return status;
         }
@@ -987,6 +998,10 @@ int IncrementalService::setStorageParams(StorageId storageId, bool enableReadLog
 
     registerAppOpsCallback(packageName);
 
+    if (!wasEnabled) {
+        recordAccessProfile(storageId);
+    }
+
     return 0;
 }
 
@@ -1061,7 +1076,7 @@ StorageId IncrementalService::openStorage(std::string_view pathInMount) {
 }
 
 IncrementalService::IfsMountPtr IncrementalService::getIfs(StorageId storage) const {
-    std::lock_guard l(mLock);
+    std::shared_lock l(mLock);
     return getIfsLocked(storage);
 }
 
@@ -1254,7 +1269,7 @@ int IncrementalService::makeDirs(const IncFsMount& ifs, StorageId storageId, std
 
 int IncrementalService::link(StorageId sourceStorageId, std::string_view oldPath,
                              StorageId destStorageId, std::string_view newPath) {
-    std::unique_lock l(mLock);
+    std::shared_lock l(mLock);
     auto ifsSrc = getIfsLocked(sourceStorageId);
     if (!ifsSrc) {
         return -EINVAL;
@@ -1288,7 +1303,7 @@ int IncrementalService::unlink(StorageId storage, std::string_view path) {
 int IncrementalService::addBindMount(IncFsMount& ifs, StorageId storage,
                                      std::string_view storageRoot, std::string&& source,
                                      std::string&& target, BindKind kind,
-                                     std::unique_lock<std::mutex>& mainLock) {
+                                     std::unique_lock<std::shared_mutex>& mainLock) {
     if (!isValidMountTarget(target)) {
         LOG(ERROR) << __func__ << ": invalid mount target " << target;
         return -EINVAL;
@@ -1325,7 +1340,7 @@ int IncrementalService::addBindMount(IncFsMount& ifs, StorageId storage,
 int IncrementalService::addBindMountWithMd(IncrementalService::IncFsMount& ifs, StorageId storage,
                                            std::string&& metadataName, std::string&& source,
                                            std::string&& target, BindKind kind,
-                                           std::unique_lock<std::mutex>& mainLock) {
+                                           std::unique_lock<std::shared_mutex>& mainLock) {
     {
         std::lock_guard l(mMountOperationLock);
         const auto status = mVold->bindMount(source, target);
@@ -1933,7 +1948,8 @@ bool IncrementalService::configureNativeBinaries(StorageId storage, std::string_
         }
     }
 
-    std::vector<Job> jobQueue;
+    // Inflating takes the longest for the largest libraries: start with those.
+    std::vector<std::pair<uint32_t, Job>> extractionJobs;
     ZipEntry entry;
     std::string_view fileName;
     while (!Next(cookie, &entry, &fileName)) {
@@ -2022,11 +2038,13 @@ bool IncrementalService::configureNativeBinaries(StorageId storage, std::string_
             continue;
         }
 
-        jobQueue.emplace_back([this, zipFile, entry, ifs = std::weak_ptr<IncFsMount>(ifs),
-                               libFileId, libPath = std::move(targetLibPath),
-                               makeFileTs]() mutable {
-            extractZipFile(ifs.lock(), zipFile.get(), entry, libFileId, libPath, makeFileTs);
-        });
+        extractionJobs.emplace_back(entry.uncompressed_length,
+                                    [this, zipFile, entry, ifs = std::weak_ptr<IncFsMount>(ifs),
+                                     libFileId, libPath = std::move(targetLibPath),
+                                     makeFileTs]() mutable {
+                                        extractZipFile(ifs.lock(), zipFile.get(), entry, libFileId,
+                                                       libPath, makeFileTs);
+                                    });
 
         if (perfLoggingEnabled()) {
             auto prepareJobTs = Clock::now();
@@ -2039,6 +2057,14 @@ bool IncrementalService::configureNativeBinaries(StorageId storage, std::string_
 
     auto processedTs = Clock::now();
 
+    std::stable_sort(extractionJobs.begin(), extractionJobs.end(),
+                     [](const auto& l, const auto& r) { return l.first > r.first; });
+    std::vector<Job> jobQueue;
+    jobQueue.reserve(extractionJobs.size());
+    for (auto&& [_, job] : extractionJobs) {
+        jobQueue.push_back(std::move(job));
+    }
+
     if (!jobQueue.empty()) {
         {
             std::lock_guard lock(mJobMutex);
@@ -2184,7 +2210,7 @@ int IncrementalService::setFileContent(const IfsMountPtr& ifs, const incfs::File
 
 incfs::LoadingState IncrementalService::isFileFullyLoaded(StorageId storage,
                                                           std::string_view filePath) const {
-    std::unique_lock l(mLock);
+    std::shared_lock l(mLock);
     const auto ifs = getIfsLocked(storage);
     if (!ifs) {
         LOG(ERROR) << "isFileFullyLoaded failed, invalid storageId: " << storage;
@@ -2210,7 +2236,7 @@ incfs::LoadingState IncrementalService::isMountFullyLoaded(StorageId storage) co
 
 IncrementalService::LoadingProgress IncrementalService::getLoadingProgress(
         StorageId storage) const {
-    std::unique_lock l(mLock);
+    std::shared_lock l(mLock);
     const auto ifs = getIfsLocked(storage);
     if (!ifs) {
         LOG(ERROR) << "getLoadingProgress failed, invalid storageId: " << storage;
@@ -2299,9 +2325,7 @@ void IncrementalService::runJobProcessing() {
         mJobQueue.erase(it);
         lock.unlock();
 
-        for (auto&& job : queue) {
-            job();
-        }
+        runJobsInParallel(queue);
 
         lock.lock();
         mPendingJobsMount = kInvalidStorageId;
@@ -2310,6 +2334,30 @@ void IncrementalService::runJobProcessing() {
     }
 }
 
+void IncrementalService::runJobsInParallel(std::vector<Job>& jobs) {
+    // The jobs of a mount extract different zip entries into different files, and the zip archive
+    // only does positional reads: they are safe to run concurrently.
+    const auto threadCount =
+            std::min<size_t>({jobs.size(), Constants::maxJobThreads,
+                              std::max(1u, std::thread::hardware_concurrency())});
+    std::atomic<size_t> next = 0;
+    const auto runJobs = [&jobs, &next]() {
+        for (auto i = next++; i < jobs.size(); i = next++) {
+            jobs[i]();
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    helpers.reserve(threadCount > 0 ? threadCount - 1 : 0);
+    for (size_t i = 1; i < threadCount; ++i) {
+        helpers.emplace_back(runJobs);
+    }
+    runJobs();
+    for (auto&& helper : helpers) {
+        helper.join();
+    }
+}
+
 void IncrementalService::registerAppOpsCallback(const std::string& packageName) {
     sp<IAppOpsCallback> listener;
     {
@@ -2349,7 +2397,7 @@ void IncrementalService::onAppOpChanged(const std::string& packageName) {
 
     std::vector<IfsMountPtr> affected;
     {
-        std::lock_guard l(mLock);
+        std::shared_lock l(mLock);
         affected.reserve(mMounts.size());
         for (auto&& [id, ifs] : mMounts) {
             std::unique_lock ll(ifs->lock);
@@ -2484,6 +2532,73 @@ void IncrementalService::removeIfsStateCallbacks(StorageId storageId) {
     mIfsStateCallbacks.erase(storageId);
 }
 
+std::optional<AccessProfile> IncrementalService::getAccessProfile(StorageId storageId) const {
+    const auto ifs = getIfs(storageId);
+    if (!ifs) {
+        return {};
+    }
+    return AccessProfile::load(path::join(ifs->root, constants().accessProfileName));
+}
+
+void IncrementalService::recordAccessProfile(StorageId storageId) {
+    auto recording = std::make_shared<AccessProfileRecording>();
+    recording->deadline = mClock->now() + Constants::accessProfileWindow;
+    // Piggybacks on the periodic IfsState check instead of adding a job of its own.
+    addIfsStateCallback(storageId, [this, recording](StorageId storageId, IfsState) -> bool {
+        return recordPageReads(storageId, *recording);
+    });
+}
+
+bool IncrementalService::recordPageReads(StorageId storageId, AccessProfileRecording& recording) {
+    const auto ifs = getIfs(storageId);
+    if (!ifs) {
+        return false;
+    }
+    bool readLogsEnabled;
+    {
+        std::unique_lock l(ifs->lock);
+        readLogsEnabled = ifs->readLogsEnabled();
+        if (readLogsEnabled && recording.control.logs() < 0) {
+            // The logs of our own control keep their own read position, so the data loader
+            // still gets to see every read.
+            recording.control = mIncFs->openMount(path::join(ifs->root, constants().mount));
+            if (recording.control.logs() < 0) {
+                LOG(WARNING) << "Failed to open the read logs of storageId: " << storageId
+                             << ", not recording its access profile";
+                return false;
+            }
+        }
+    }
+
+    if (readLogsEnabled) {
+        // The logs are a ring buffer: drain them, but never spin on a log that keeps filling up.
+        for (int i = 0; i < Constants::maxPageReadsBatches && !recording.profile.full(); ++i) {
+            recording.pageReads.clear();
+            if (mIncFs->waitForPageReads(recording.control, 0ms, &recording.pageReads) !=
+                        android::incfs::WaitResult::HaveData ||
+                recording.pageReads.empty()) {
+                break;
+            }
+            for (auto&& read : recording.pageReads) {
+                if (!recording.profile.record(read.id, read.block)) {
+                    break;
+                }
+            }
+        }
+        if (!recording.profile.full() && mClock->now() < recording.deadline) {
+            return true;
+        }
+    }
+
+    if (!recording.profile.empty() &&
+        recording.profile.save(path::join(ifs->root, constants().accessProfileName))) {
+        LOG(INFO) << "Saved the access profile of storageId: " << storageId << ": "
+                  << recording.profile.ranges().size() << " ranges, "
+                  << recording.profile.blocks() << " blocks";
+    }
+    return false;
+}
+
 void IncrementalService::getMetrics(StorageId storageId, android::os::PersistableBundle* result) {
     const auto ifs = getIfs(storageId);
     if (!ifs) {
@@ -39,7 +39,9 @@
 #include <limits>
 #include <map>
 #include <mutex>
+#include <optional>
 #include <set>
+#include <shared_mutex>
 #include <span>
 #include <string>
 #include <string_view>
@@ -49,6 +51,7 @@
 #include <utility>
 #include <vector>
 
+#include "AccessProfile.h"
 #include "ServiceWrappers.h"
 #include "incfs.h"
 #include "path.h"
@@ -200,6 +203,10 @@ public:
 
     void getMetrics(int32_t storageId, android::os::PersistableBundle* _aidl_return);
 
+    // The order in which the app installed in this storage read its files, recorded from the read
+    // logs right after the data loader enabled them.
+    std::optional<AccessProfile> getAccessProfile(StorageId storageId) const;
+
     class AppOpsListener : public com::android::internal::app::BnAppOpsCallback {
     public:
         AppOpsListener(IncrementalService& incrementalService, std::string packageName, int32_t op)
@@ -419,11 +426,11 @@ private:
     const IfsMountPtr& getIfsLocked(StorageId storage) const;
     int addBindMount(IncFsMount& ifs, StorageId storage, std::string_view storageRoot,
                      std::string&& source, std::string&& target, BindKind kind,
-                     std::unique_lock<std::mutex>& mainLock);
+                     std::unique_lock<std::shared_mutex>& mainLock);
 
     int addBindMountWithMd(IncFsMount& ifs, StorageId storage, std::string&& metadataName,
                            std::string&& source, std::string&& target, BindKind kind,
-                           std::unique_lock<std::mutex>& mainLock);
+                           std::unique_lock<std::shared_mutex>& mainLock);
 
     void addBindMountRecordLocked(IncFsMount& ifs, StorageId storage, std::string&& metadataName,
                                   std::string&& source, std::string&& target, BindKind kind);
@@ -461,6 +468,7 @@ private:
     void onAppOpChanged(const std::string& packageName);
 
     void runJobProcessing();
+    void runJobsInParallel(std::vector<Job>& jobs);
     void extractZipFile(const IfsMountPtr& ifs, ZipArchiveHandle zipFile, ZipEntry& entry,
                         const incfs::FileId& libFileId, std::string_view debugLibPath,
                         Clock::time_point scheduledTs);
@@ -478,6 +486,17 @@ private:
     bool updateLoadingProgress(int32_t storageId,
                                StorageLoadingProgressListener&& progressListener);
 
+    struct AccessProfileRecording {
+        TimePoint deadline;
+        incfs::UniqueControl control;
+        AccessProfile profile;
+        std::vector<incfs::ReadInfoWithUid> pageReads;
+    };
+
+    void recordAccessProfile(StorageId storageId);
+    // Returns true if wants to be called again.
+    bool recordPageReads(StorageId storageId, AccessProfileRecording& recording);
+
     void trimReservedSpaceV1(const IncFsMount& ifs);
     int64_t elapsedUsSinceMonoTs(uint64_t monoTsUs);
 
@@ -494,7 +513,9 @@ private:
     const std::unique_ptr<ClockWrapper> mClock;
     const std::string mIncrementalDir;
 
-    mutable std::mutex mLock;
+    // Guards the maps, not the mounts: lookups share it, only adding or removing a mount or a
+    // bind point takes it exclusively.
+    mutable std::shared_mutex mLock;
     mutable std::mutex mMountOperationLock;
     MountMap mMounts;
     BindPathMap mBindsByPath;
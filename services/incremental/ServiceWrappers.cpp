@@ -241,6 +241,10 @@ public:
             std::vector<incfs::ReadInfoWithUid>* pendingReadsBuffer) const final {
         return incfs::waitForPendingReads(control, timeout, pendingReadsBuffer);
     }
+    WaitResult waitForPageReads(const Control& control, std::chrono::milliseconds timeout,
+                                std::vector<incfs::ReadInfoWithUid>* pageReadsBuffer) const final {
+        return incfs::waitForPageReads(control, timeout, pageReadsBuffer);
+    }
     ErrorCode setUidReadTimeouts(const Control& control,
                                  const std::vector<android::os::incremental::PerUidReadTimeouts>&
                                          perUidReadTimeouts) const final {
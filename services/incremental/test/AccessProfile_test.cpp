@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../AccessProfile.h"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace android::incremental {
+
+static incfs::FileId fileId(char c) {
+    incfs::FileId id;
+    memset(id.data, c, sizeof(id.data));
+    return id;
+}
+
+static bool sameFile(const incfs::FileId& l, const incfs::FileId& r) {
+    return !memcmp(l.data, r.data, sizeof(l.data));
+}
+
+TEST(AccessProfile, MergesAdjacentBlocksInFirstAccessOrder) {
+    AccessProfile profile;
+    const auto a = fileId('a');
+    const auto b = fileId('b');
+    for (auto block : {5, 6, 7}) {
+        EXPECT_TRUE(profile.record(a, block));
+    }
+    EXPECT_TRUE(profile.record(b, 0));
+    // Already recorded.
+    EXPECT_TRUE(profile.record(a, 6));
+    EXPECT_TRUE(profile.record(a, 8));
+    EXPECT_TRUE(profile.record(a, 9));
+
+    EXPECT_EQ(6u, profile.blocks());
+    const auto& ranges = profile.ranges();
+    ASSERT_EQ(3u, ranges.size());
+    EXPECT_TRUE(sameFile(a, ranges[0].fileId));
+    EXPECT_EQ(5, ranges[0].begin);
+    EXPECT_EQ(8, ranges[0].end);
+    EXPECT_TRUE(sameFile(b, ranges[1].fileId));
+    EXPECT_EQ(0, ranges[1].begin);
+    EXPECT_EQ(1, ranges[1].end);
+    EXPECT_TRUE(sameFile(a, ranges[2].fileId));
+    EXPECT_EQ(8, ranges[2].begin);
+    EXPECT_EQ(10, ranges[2].end);
+}
+
+TEST(AccessProfile, StopsWhenFull) {
+    AccessProfile profile(2);
+    const auto a = fileId('a');
+    EXPECT_TRUE(profile.record(a, 0));
+    EXPECT_TRUE(profile.record(a, 1));
+    EXPECT_TRUE(profile.full());
+    EXPECT_FALSE(profile.record(a, 2));
+    EXPECT_EQ(2u, profile.blocks());
+}
+
+TEST(AccessProfile, SavesAndLoads) {
+    AccessProfile profile;
+    profile.record(fileId('a'), 3);
+    profile.record(fileId('a'), 4);
+    profile.record(fileId('b'), 1);
+
+    TemporaryDir dir;
+    const auto path = std::string(dir.path) + "/profile";
+    ASSERT_TRUE(profile.save(path));
+    const auto loaded = AccessProfile::load(path);
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(profile.blocks(), loaded->blocks());
+    ASSERT_EQ(profile.ranges().size(), loaded->ranges().size());
+    for (size_t i = 0; i < profile.ranges().size(); ++i) {
+        EXPECT_TRUE(sameFile(profile.ranges()[i].fileId, loaded->ranges()[i].fileId));
+        EXPECT_EQ(profile.ranges()[i].begin, loaded->ranges()[i].begin);
+        EXPECT_EQ(profile.ranges()[i].end, loaded->ranges()[i].end);
+    }
+
+    EXPECT_FALSE(AccessProfile::load(std::string(dir.path) + "/missing"));
+    EXPECT_FALSE(AccessProfile::parse("\xff\xff\xff"));
+}
+
+} // namespace android::incremental
@@ -19,6 +19,8 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "android-base/macros.h"
 #include "androidfw/IDiagnostics.h"
@@ -64,6 +66,30 @@ class StdErrDiagnostics : public android::IDiagnostics {
   DISALLOW_COPY_AND_ASSIGN(StdErrDiagnostics);
 };
 
+// Keeps the messages logged to it, to log them to other diagnostics later on. Used to log the
+// messages of work done on several threads in a deterministic order.
+class BufferedDiagnostics : public android::IDiagnostics {
+ public:
+  BufferedDiagnostics() = default;
+
+  void Log(Level level, android::DiagMessageActual& actual_msg) override {
+    messages_.emplace_back(level, actual_msg);
+  }
+
+  // Logs the messages to diag, in order, and forgets them.
+  void FlushTo(android::IDiagnostics* diag) {
+    for (auto& [level, message] : messages_) {
+      diag->Log(level, message);
+    }
+    messages_.clear();
+  }
+
+ private:
+  std::vector<std::pair<Level, android::DiagMessageActual>> messages_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferedDiagnostics);
+};
+
 }  // namespace aapt
 
 #endif /* AAPT_DIAGNOSTICS_H_ */
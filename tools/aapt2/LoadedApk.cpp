@@ -24,6 +24,7 @@
 #include "format/binary/XmlFlattener.h"
 #include "format/proto/ProtoDeserialize.h"
 #include "format/proto/ProtoSerialize.h"
+#include "google/protobuf/arena.h"
 #include "io/Util.h"
 #include "xml/XmlDom.h"
 
@@ -73,7 +74,8 @@ static ApkFormat DetermineApkFormat(io::IFileCollection* apk) {
 }
 
 std::unique_ptr<LoadedApk> LoadedApk::LoadApkFromPath(StringPiece path,
-                                                      android::IDiagnostics* diag) {
+                                                      android::IDiagnostics* diag,
+                                                      TableLoading table_loading) {
   android::Source source(path);
   std::string error;
   std::unique_ptr<io::ZipFileCollection> apk = io::ZipFileCollection::Create(path, &error);
@@ -85,42 +87,77 @@ std::unique_ptr<LoadedApk> LoadedApk::LoadApkFromPath(StringPiece path,
   ApkFormat apkFormat = DetermineApkFormat(apk.get());
   switch (apkFormat) {
     case ApkFormat::kBinary:
-      return LoadBinaryApkFromFileCollection(source, std::move(apk), diag);
+      return LoadBinaryApkFromFileCollection(source, std::move(apk), diag, table_loading);
     case ApkFormat::kProto:
-      return LoadProtoApkFromFileCollection(source, std::move(apk), diag);
+      return LoadProtoApkFromFileCollection(source, std::move(apk), diag, table_loading);
     default:
       diag->Error(android::DiagMessage(path) << "could not identify format of APK");
       return {};
   }
 }
 
-std::unique_ptr<LoadedApk> LoadedApk::LoadProtoApkFromFileCollection(
-    const android::Source& source, unique_ptr<io::IFileCollection> collection,
-    android::IDiagnostics* diag) {
-  std::unique_ptr<ResourceTable> table;
-
+static bool LoadProtoTable(const android::Source& source, io::IFileCollection* collection,
+                           android::IDiagnostics* diag, std::unique_ptr<ResourceTable>* out_table) {
   io::IFile* table_file = collection->FindFile(kProtoResourceTablePath);
-  if (table_file != nullptr) {
-    pb::ResourceTable pb_table;
-    std::unique_ptr<android::InputStream> in = table_file->OpenInputStream();
-    if (in == nullptr) {
-      diag->Error(android::DiagMessage(source) << "failed to open " << kProtoResourceTablePath);
-      return {};
-    }
+  if (table_file == nullptr) {
+    return true;
+  }
 
-    io::ProtoInputStreamReader proto_reader(in.get());
-    if (!proto_reader.ReadMessage(&pb_table)) {
-      diag->Error(android::DiagMessage(source) << "failed to read " << kProtoResourceTablePath);
-      return {};
-    }
+  // The messages are only needed until the table is deserialized.
+  google::protobuf::Arena arena;
+  pb::ResourceTable* pb_table = google::protobuf::Arena::Create<pb::ResourceTable>(&arena);
+  std::unique_ptr<android::InputStream> in = table_file->OpenInputStream();
+  if (in == nullptr) {
+    diag->Error(android::DiagMessage(source) << "failed to open " << kProtoResourceTablePath);
+    return false;
+  }
 
-    std::string error;
-    table = util::make_unique<ResourceTable>(ResourceTable::Validation::kDisabled);
-    if (!DeserializeTableFromPb(pb_table, collection.get(), table.get(), &error)) {
-      diag->Error(android::DiagMessage(source)
-                  << "failed to deserialize " << kProtoResourceTablePath << ": " << error);
-      return {};
-    }
+  io::ProtoInputStreamReader proto_reader(in.get());
+  if (!proto_reader.ReadMessage(pb_table)) {
+    diag->Error(android::DiagMessage(source) << "failed to read " << kProtoResourceTablePath);
+    return false;
+  }
+
+  std::string error;
+  auto table = util::make_unique<ResourceTable>(ResourceTable::Validation::kDisabled);
+  if (!DeserializeTableFromPb(*pb_table, collection, table.get(), &error)) {
+    diag->Error(android::DiagMessage(source)
+                << "failed to deserialize " << kProtoResourceTablePath << ": " << error);
+    return false;
+  }
+  *out_table = std::move(table);
+  return true;
+}
+
+static bool LoadBinaryTable(const android::Source& source, io::IFileCollection* collection,
+                            android::IDiagnostics* diag,
+                            std::unique_ptr<ResourceTable>* out_table) {
+  io::IFile* table_file = collection->FindFile(kApkResourceTablePath);
+  if (table_file == nullptr) {
+    return true;
+  }
+
+  auto table = util::make_unique<ResourceTable>(ResourceTable::Validation::kDisabled);
+  std::unique_ptr<io::IData> data = table_file->OpenAsData();
+  if (data == nullptr) {
+    diag->Error(android::DiagMessage(source) << "failed to open " << kApkResourceTablePath);
+    return false;
+  }
+  BinaryResourceParser parser(diag, table.get(), source, data->data(), data->size(), collection);
+  if (!parser.Parse()) {
+    return false;
+  }
+  *out_table = std::move(table);
+  return true;
+}
+
+std::unique_ptr<LoadedApk> LoadedApk::LoadProtoApkFromFileCollection(
+    const android::Source& source, unique_ptr<io::IFileCollection> collection,
+    android::IDiagnostics* diag, TableLoading table_loading) {
+  std::unique_ptr<ResourceTable> table;
+  if (table_loading == TableLoading::kEager &&
+      !LoadProtoTable(source, collection.get(), diag, &table)) {
+    return {};
   }
 
   io::IFile* manifest_file = collection->FindFile(kAndroidManifestPath);
@@ -149,28 +186,24 @@ std::unique_ptr<LoadedApk> LoadedApk::LoadProtoApkFromFileCollection(
                 << "failed to deserialize proto " << kAndroidManifestPath << ": " << error);
     return {};
   }
-  return util::make_unique<LoadedApk>(source, std::move(collection), std::move(table),
-                                      std::move(manifest), ApkFormat::kProto);
+  io::IFileCollection* files = collection.get();
+  auto apk = util::make_unique<LoadedApk>(source, std::move(collection), std::move(table),
+                                          std::move(manifest), ApkFormat::kProto);
+  if (table_loading == TableLoading::kOnFirstUse) {
+    apk->table_loader_ = [source, files, diag](std::unique_ptr<ResourceTable>* out_table) {
+      return LoadProtoTable(source, files, diag, out_table);
+    };
+  }
+  return apk;
 }
 
 std::unique_ptr<LoadedApk> LoadedApk::LoadBinaryApkFromFileCollection(
     const android::Source& source, unique_ptr<io::IFileCollection> collection,
-    android::IDiagnostics* diag) {
+    android::IDiagnostics* diag, TableLoading table_loading) {
   std::unique_ptr<ResourceTable> table;
-
-  io::IFile* table_file = collection->FindFile(kApkResourceTablePath);
-  if (table_file != nullptr) {
-    table = util::make_unique<ResourceTable>(ResourceTable::Validation::kDisabled);
-    std::unique_ptr<io::IData> data = table_file->OpenAsData();
-    if (data == nullptr) {
-      diag->Error(android::DiagMessage(source) << "failed to open " << kApkResourceTablePath);
-      return {};
-    }
-    BinaryResourceParser parser(diag, table.get(), source, data->data(), data->size(),
-                                collection.get());
-    if (!parser.Parse()) {
-      return {};
-    }
+  if (table_loading == TableLoading::kEager &&
+      !LoadBinaryTable(source, collection.get(), diag, &table)) {
+    return {};
   }
 
   io::IFile* manifest_file = collection->FindFile(kAndroidManifestPath);
@@ -193,8 +226,26 @@ std::unique_ptr<LoadedApk> LoadedApk::LoadBinaryApkFromFileCollection(
                 << "failed to parse binary " << kAndroidManifestPath << ": " << error);
     return {};
   }
-  return util::make_unique<LoadedApk>(source, std::move(collection), std::move(table),
-                                      std::move(manifest), ApkFormat::kBinary);
+  io::IFileCollection* files = collection.get();
+  auto apk = util::make_unique<LoadedApk>(source, std::move(collection), std::move(table),
+                                          std::move(manifest), ApkFormat::kBinary);
+  if (table_loading == TableLoading::kOnFirstUse) {
+    apk->table_loader_ = [source, files, diag](std::unique_ptr<ResourceTable>* out_table) {
+      return LoadBinaryTable(source, files, diag, out_table);
+    };
+  }
+  return apk;
+}
+
+void LoadedApk::LoadTableIfNeeded() const {
+  if (!table_loader_) {
+    return;
+  }
+  // The loader is only run once, even if it fails, in which case it left table_ null and reported
+  // why.
+  TableLoader loader = std::move(table_loader_);
+  table_loader_ = nullptr;
+  loader(&table_);
 }
 
 bool LoadedApk::WriteToArchive(IAaptContext* context, const TableFlattenerOptions& options,
@@ -17,6 +17,8 @@
 #ifndef AAPT_LOADEDAPK_H
 #define AAPT_LOADEDAPK_H
 
+#include <functional>
+
 #include "androidfw/StringPiece.h"
 
 #include "ResourceTable.h"
@@ -42,19 +44,30 @@ enum ApkFormat {
 // Info about an APK loaded in memory.
 class LoadedApk final {
  public:
+  // When the resource table of an APK is parsed.
+  enum class TableLoading {
+    // While loading the APK, which fails if the table is malformed.
+    kEager,
+    // On the first call to GetResourceTable(), which reports the errors to the diagnostics the
+    // APK was loaded with and returns nullptr if the table is malformed. This spares the commands
+    // that only look at the manifest or the XML files from parsing the whole table.
+    kOnFirstUse,
+  };
+
   // Loads both binary and proto APKs from disk.
-  static std::unique_ptr<LoadedApk> LoadApkFromPath(android::StringPiece path,
-                                                    android::IDiagnostics* diag);
+  static std::unique_ptr<LoadedApk> LoadApkFromPath(
+      android::StringPiece path, android::IDiagnostics* diag,
+      TableLoading table_loading = TableLoading::kEager);
 
   // Loads a proto APK from the given file collection.
   static std::unique_ptr<LoadedApk> LoadProtoApkFromFileCollection(
       const android::Source& source, std::unique_ptr<io::IFileCollection> collection,
-      android::IDiagnostics* diag);
+      android::IDiagnostics* diag, TableLoading table_loading = TableLoading::kEager);
 
   // Loads a binary APK from the given file collection.
   static std::unique_ptr<LoadedApk> LoadBinaryApkFromFileCollection(
       const android::Source& source, std::unique_ptr<io::IFileCollection> collection,
-      android::IDiagnostics* diag);
+      android::IDiagnostics* diag, TableLoading table_loading = TableLoading::kEager);
 
   LoadedApk(const android::Source& source, std::unique_ptr<io::IFileCollection> apk,
             std::unique_ptr<ResourceTable> table, std::unique_ptr<xml::XmlResource> manifest,
@@ -75,10 +88,12 @@ class LoadedApk final {
   }
 
   const ResourceTable* GetResourceTable() const {
+    LoadTableIfNeeded();
     return table_.get();
   }
 
   ResourceTable* GetResourceTable() {
+    LoadTableIfNeeded();
     return table_.get();
   }
 
@@ -117,9 +132,16 @@ class LoadedApk final {
  private:
   DISALLOW_COPY_AND_ASSIGN(LoadedApk);
 
+  using TableLoader = std::function<bool(std::unique_ptr<ResourceTable>* out_table)>;
+
+  void LoadTableIfNeeded() const;
+
   android::Source source_;
   std::unique_ptr<io::IFileCollection> apk_;
-  std::unique_ptr<ResourceTable> table_;
+  // Both are only written once, by the first call to GetResourceTable() when the table is loaded
+  // on first use, which is not thread-safe.
+  mutable std::unique_ptr<ResourceTable> table_;
+  mutable TableLoader table_loader_;
   std::unique_ptr<xml::XmlResource> manifest_;
   ApkFormat format_;
 };
@@ -38,6 +38,7 @@
 #include "cmd/Dump.h"
 #include "cmd/Link.h"
 #include "cmd/Optimize.h"
+#include "process/SymbolTable.h"
 #include "trace/TraceBuffer.h"
 #include "util/Files.h"
 #include "util/Util.h"
@@ -110,6 +111,8 @@ class DaemonCommand : public Command {
   int Action(const std::vector<std::string>& arguments) override {
     TRACE_FLUSH_ARGS(trace_folder_ ? trace_folder_.value() : "", "daemon", arguments);
     text::Printer printer(out_);
+    // The framework and library includes are mostly the same from one link to the next.
+    ApkAssetsCache::Get().SetEnabled(true);
     std::cout << "Ready" << std::endl;
 
     while (true) {
@@ -132,6 +135,9 @@ class DaemonCommand : public Command {
         break;
       }
 
+      // Don't keep the includes that the previous builds replaced alive for the rest of the daemon.
+      ApkAssetsCache::Get().EvictStale();
+
       std::vector<StringPiece> args;
       args.insert(args.end(), raw_args.begin(), raw_args.end());
       int result = MainCommand(&printer, diagnostics_).Execute(args, &std::cerr);
@@ -141,6 +147,7 @@ class DaemonCommand : public Command {
       }
       std::cerr << "Done" << std::endl;
     }
+    ApkAssetsCache::Get().SetEnabled(false);
     std::cout << "Exiting daemon" << std::endl;
 
     return 0;
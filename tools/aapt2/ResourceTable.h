@@ -34,6 +34,7 @@
 #include "androidfw/StringPiece.h"
 #include "androidfw/StringPool.h"
 #include "io/File.h"
+#include "util/SmallObjectPool.h"
 
 using PolicyFlags = android::ResTable_overlayable_policy_header::PolicyFlags;
 
@@ -95,6 +96,8 @@ struct OverlayableItem {
 
 class ResourceConfigValue {
  public:
+  AAPT_SMALL_OBJECT_POOL_ALLOCATED();
+
   // The configuration for which this value is defined.
   const android::ConfigDescription config;
 
@@ -118,6 +121,8 @@ class ResourceConfigValue {
 // Represents a resource entry, which may have varying values for each defined configuration.
 class ResourceEntry {
  public:
+  AAPT_SMALL_OBJECT_POOL_ALLOCATED();
+
   // The name of the resource. Immutable, as this determines the order of this resource
   // when doing lookups.
   const std::string name;
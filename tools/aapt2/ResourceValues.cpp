@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <functional>
 #include <limits>
 #include <set>
 #include <sstream>
@@ -86,6 +87,10 @@ bool RawString::Equals(const Value* value) const {
   return *this->value == *other->value;
 }
 
+size_t RawString::Hash() const {
+  return std::hash<std::string>()(*value);
+}
+
 bool RawString::Flatten(android::Res_value* out_value) const {
   out_value->dataType = android::Res_value::TYPE_STRING;
   out_value->data = android::util::HostToDevice32(static_cast<uint32_t>(value.index()));
@@ -116,6 +121,16 @@ bool Reference::Equals(const Value* value) const {
          id == other->id && name == other->name && type_flags == other->type_flags;
 }
 
+size_t Reference::Hash() const {
+  android::hash_t h = static_cast<uint32_t>(reference_type);
+  h = android::JenkinsHashMix(h, private_reference);
+  h = android::JenkinsHashMix(h, id ? id.value().id : 0);
+  h = android::JenkinsHashMix(h,
+                             name ? static_cast<uint32_t>(std::hash<ResourceName>()(*name)) : 0);
+  h = android::JenkinsHashMix(h, type_flags.value_or(0));
+  return static_cast<size_t>(h);
+}
+
 bool Reference::Flatten(android::Res_value* out_value) const {
   if (name && name.value().type.type == ResourceType::kMacro) {
     return false;
@@ -215,6 +230,10 @@ bool Id::Equals(const Value* value) const {
   return ValueCast<Id>(value) != nullptr;
 }
 
+size_t Id::Hash() const {
+  return 0;
+}
+
 bool Id::Flatten(android::Res_value* out) const {
   out->dataType = android::Res_value::TYPE_INT_BOOLEAN;
   out->data = android::util::HostToDevice32(0);
@@ -252,6 +271,12 @@ bool String::Equals(const Value* value) const {
   return true;
 }
 
+size_t String::Hash() const {
+  android::hash_t h = static_cast<uint32_t>(std::hash<std::string>()(*value));
+  h = android::JenkinsHashMix(h, static_cast<uint32_t>(untranslatable_sections.size()));
+  return static_cast<size_t>(h);
+}
+
 bool String::Flatten(android::Res_value* out_value) const {
   // Verify that our StringPool index is within encode-able limits.
   if (value.index() > std::numeric_limits<uint32_t>::max()) {
@@ -300,6 +325,13 @@ bool StyledString::Equals(const Value* value) const {
   return true;
 }
 
+size_t StyledString::Hash() const {
+  android::hash_t h = static_cast<uint32_t>(std::hash<std::string>()(value->value));
+  h = android::JenkinsHashMix(h, static_cast<uint32_t>(value->spans.size()));
+  h = android::JenkinsHashMix(h, static_cast<uint32_t>(untranslatable_sections.size()));
+  return static_cast<size_t>(h);
+}
+
 bool StyledString::Flatten(android::Res_value* out_value) const {
   if (value.index() > std::numeric_limits<uint32_t>::max()) {
     return false;
@@ -328,6 +360,10 @@ bool FileReference::Equals(const Value* value) const {
   return path == other->path;
 }
 
+size_t FileReference::Hash() const {
+  return std::hash<std::string>()(*path);
+}
+
 bool FileReference::Flatten(android::Res_value* out_value) const {
   if (path.index() > std::numeric_limits<uint32_t>::max()) {
     return false;
@@ -372,6 +408,10 @@ bool BinaryPrimitive::Equals(const Value* value) const {
          this->value.data == other->value.data;
 }
 
+size_t BinaryPrimitive::Hash() const {
+  return static_cast<size_t>(android::JenkinsHashMix(value.dataType, value.data));
+}
+
 bool BinaryPrimitive::Flatten(::android::Res_value* out_value) const {
   out_value->dataType = value.dataType;
   out_value->data = android::util::HostToDevice32(value.data);
@@ -558,6 +598,15 @@ bool Attribute::Equals(const Value* value) const {
                     });
 }
 
+size_t Attribute::Hash() const {
+  // The symbols are compared regardless of their order.
+  android::hash_t h = type_mask;
+  h = android::JenkinsHashMix(h, static_cast<uint32_t>(min_int));
+  h = android::JenkinsHashMix(h, static_cast<uint32_t>(max_int));
+  h = android::JenkinsHashMix(h, static_cast<uint32_t>(symbols.size()));
+  return static_cast<size_t>(h);
+}
+
 bool Attribute::IsCompatibleWith(const Attribute& attr) const {
   // If the high bits are set on any of these attribute type masks, then they are incompatible.
   // We don't check that flags and enums are identical.
@@ -878,6 +927,19 @@ bool Style::Equals(const Value* value) const {
                     });
 }
 
+size_t Style::Hash() const {
+  android::hash_t h = parent ? static_cast<uint32_t>(parent.value().Hash()) : 0;
+  h = android::JenkinsHashMix(h, static_cast<uint32_t>(entries.size()));
+  // The entries are compared regardless of their order, so their hashes are summed.
+  uint32_t entries_hash = 0;
+  for (const Entry& entry : entries) {
+    entries_hash += android::JenkinsHashMix(static_cast<uint32_t>(entry.key.Hash()),
+                                            static_cast<uint32_t>(entry.value->Hash()));
+  }
+  h = android::JenkinsHashMix(h, entries_hash);
+  return static_cast<size_t>(h);
+}
+
 void Style::Print(std::ostream* out) const {
   *out << "(style) ";
   if (parent && parent.value().name) {
@@ -967,6 +1029,14 @@ bool Array::Equals(const Value* value) const {
                     });
 }
 
+size_t Array::Hash() const {
+  android::hash_t h = static_cast<uint32_t>(elements.size());
+  for (const std::unique_ptr<Item>& element : elements) {
+    h = android::JenkinsHashMix(h, static_cast<uint32_t>(element->Hash()));
+  }
+  return static_cast<size_t>(h);
+}
+
 void Array::Print(std::ostream* out) const {
   *out << "(array) [" << util::Joiner(elements, ", ") << "]";
 }
@@ -1004,6 +1074,14 @@ bool Plural::Equals(const Value* value) const {
   return true;
 }
 
+size_t Plural::Hash() const {
+  android::hash_t h = 0;
+  for (const std::unique_ptr<Item>& item : values) {
+    h = android::JenkinsHashMix(h, item != nullptr ? static_cast<uint32_t>(item->Hash()) : 0);
+  }
+  return static_cast<size_t>(h);
+}
+
 void Plural::Print(std::ostream* out) const {
   *out << "(plural)";
   if (values[Zero]) {
@@ -1047,6 +1125,14 @@ bool Styleable::Equals(const Value* value) const {
                     });
 }
 
+size_t Styleable::Hash() const {
+  android::hash_t h = static_cast<uint32_t>(entries.size());
+  for (const Reference& entry : entries) {
+    h = android::JenkinsHashMix(h, static_cast<uint32_t>(entry.Hash()));
+  }
+  return static_cast<size_t>(h);
+}
+
 void Styleable::Print(std::ostream* out) const {
   *out << "(styleable) "
        << " [" << util::Joiner(entries, ", ") << "]";
@@ -1063,6 +1149,10 @@ bool Macro::Equals(const Value* value) const {
          other->alias_namespaces == alias_namespaces;
 }
 
+size_t Macro::Hash() const {
+  return std::hash<std::string>()(raw_value);
+}
+
 void Macro::Print(std::ostream* out) const {
   *out << "(macro) ";
 }
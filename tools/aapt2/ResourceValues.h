@@ -30,6 +30,7 @@
 #include "androidfw/StringPool.h"
 #include "io/File.h"
 #include "text/Printer.h"
+#include "util/SmallObjectPool.h"
 
 namespace aapt {
 
@@ -43,6 +44,8 @@ class ConstValueVisitor;
 // but it is the simplest strategy.
 class Value {
  public:
+  AAPT_SMALL_OBJECT_POOL_ALLOCATED();
+
   virtual ~Value() = default;
 
   // Whether this value is weak and can be overridden without warning or error. Default is false.
@@ -112,6 +115,10 @@ class Value {
 
   virtual bool Equals(const Value* value) const = 0;
 
+  // Returns a hash of what Equals() compares, so that two values with different hashes are never
+  // equal. Comparing the hashes first is much cheaper when most values differ.
+  virtual size_t Hash() const = 0;
+
   // Calls the appropriate overload of ValueVisitor.
   virtual void Accept(ValueVisitor* visitor) = 0;
 
@@ -196,6 +203,7 @@ struct Reference : public TransformableItem<Reference, BaseItem<Reference>> {
   Reference(const ResourceNameRef& n, const ResourceId& i);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   void Print(std::ostream* out) const override;
   void PrettyPrint(text::Printer* printer) const override;
@@ -214,6 +222,7 @@ struct Id : public TransformableItem<Id, BaseItem<Id>> {
   }
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out) const override;
   void Print(std::ostream* out) const override;
 };
@@ -226,6 +235,7 @@ struct RawString : public TransformableItem<RawString, BaseItem<RawString>> {
   explicit RawString(const android::StringPool::Ref& ref);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   void Print(std::ostream* out) const override;
 };
@@ -259,6 +269,7 @@ struct String : public TransformableItem<String, BaseItem<String>> {
   explicit String(const android::StringPool::Ref& ref);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   void Print(std::ostream* out) const override;
   void PrettyPrint(text::Printer* printer) const override;
@@ -275,6 +286,7 @@ struct StyledString : public TransformableItem<StyledString, BaseItem<StyledStri
   explicit StyledString(const android::StringPool::StyleRef& ref);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   void Print(std::ostream* out) const override;
 };
@@ -294,6 +306,7 @@ struct FileReference : public TransformableItem<FileReference, BaseItem<FileRefe
   explicit FileReference(const android::StringPool::Ref& path);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   void Print(std::ostream* out) const override;
 };
@@ -307,6 +320,7 @@ struct BinaryPrimitive : public TransformableItem<BinaryPrimitive, BaseItem<Bina
   BinaryPrimitive(uint8_t dataType, uint32_t data);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   bool Flatten(android::Res_value* out_value) const override;
   void Print(std::ostream* out) const override;
   static const char* DecideFormat(float f);
@@ -330,6 +344,7 @@ struct Attribute : public TransformableValue<Attribute, BaseValue<Attribute>> {
   explicit Attribute(uint32_t t = 0u);
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
 
   // Returns true if this Attribute's format is compatible with the given Attribute. The basic
   // rule is that TYPE_REFERENCE can be ignored for both of the Attributes, and TYPE_FLAGS and
@@ -359,6 +374,7 @@ struct Style : public TransformableValue<Style, BaseValue<Style>> {
   std::vector<Entry> entries;
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   void Print(std::ostream* out) const override;
 
   // Merges `style` into this Style. All identical attributes of `style` take precedence, including
@@ -370,6 +386,7 @@ struct Array : public TransformableValue<Array, BaseValue<Array>> {
   std::vector<std::unique_ptr<Item>> elements;
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   void Print(std::ostream* out) const override;
   void RemoveFlagDisabledElements() override;
 };
@@ -380,6 +397,7 @@ struct Plural : public TransformableValue<Plural, BaseValue<Plural>> {
   std::array<std::unique_ptr<Item>, Count> values;
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   void Print(std::ostream* out) const override;
 };
 
@@ -387,6 +405,7 @@ struct Styleable : public TransformableValue<Styleable, BaseValue<Styleable>> {
   std::vector<Reference> entries;
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   void Print(std::ostream* out) const override;
   void MergeWith(Styleable* styleable);
 };
@@ -410,6 +429,7 @@ struct Macro : public TransformableValue<Macro, BaseValue<Macro>> {
   std::vector<Namespace> alias_namespaces;
 
   bool Equals(const Value* value) const override;
+  size_t Hash() const override;
   void Print(std::ostream* out) const override;
 };
 
@@ -213,6 +213,43 @@ TEST(ResourcesValuesTest, StyledStringEquals) {
   EXPECT_FALSE(ss.Equals(&ss6));
 }
 
+TEST(ResourceValuesTest, EqualValuesHaveEqualHashes) {
+  android::StringPool pool;
+
+  String str(pool.MakeRef("hello", android::StringPool::Context(test::ParseConfigOrDie("en"))));
+  String str2(pool.MakeRef("hello"));
+  EXPECT_THAT(str.Hash(), Eq(str2.Hash()));
+
+  StyledString ss(pool.MakeRef(android::StyleString{"hello", {{"b", 0, 1}}}));
+  StyledString ss2(pool.MakeRef(android::StyleString{"hello", {{"b", 0, 1}}}));
+  EXPECT_THAT(ss.Hash(), Eq(ss2.Hash()));
+
+  // The entries of a style are compared regardless of their order.
+  std::unique_ptr<Style> style = test::StyleBuilder()
+      .SetParent("android:style/Parent")
+      .AddItem("android:attr/foo", ResourceUtils::TryParseInt("1"))
+      .AddItem("android:attr/bar", ResourceUtils::TryParseInt("2"))
+      .Build();
+  std::unique_ptr<Style> style2 = test::StyleBuilder()
+      .SetParent("android:style/Parent")
+      .AddItem("android:attr/bar", ResourceUtils::TryParseInt("2"))
+      .AddItem("android:attr/foo", ResourceUtils::TryParseInt("1"))
+      .Build();
+  ASSERT_TRUE(style->Equals(style2.get()));
+  EXPECT_THAT(style->Hash(), Eq(style2->Hash()));
+
+  CloningValueTransformer cloner(&pool);
+  std::unique_ptr<Style> clone(style->Transform(cloner));
+  EXPECT_THAT(style->Hash(), Eq(clone->Hash()));
+
+  std::unique_ptr<Style> other_style = test::StyleBuilder()
+      .SetParent("android:style/Parent")
+      .AddItem("android:attr/foo", ResourceUtils::TryParseInt("1"))
+      .AddItem("android:attr/bar", ResourceUtils::TryParseInt("3"))
+      .Build();
+  EXPECT_NE(style->Hash(), other_style->Hash());
+}
+
 TEST(ResourceValuesTest, StyleMerges) {
   android::StringPool pool_a;
   android::StringPool pool_b;
@@ -241,6 +241,10 @@ int Command::Execute(std::vector<StringPiece>& args, std::ostream* out_error) {
   std::vector<std::string> file_args;
 
   parseFlagsFromEnvironment(args);
+  command_line_.clear();
+  for (StringPiece arg : args) {
+    command_line_.emplace_back(arg);
+  }
 
   for (size_t i = 0; i < args.size(); i++) {
     StringPiece arg = args[i];
@@ -94,6 +94,12 @@ class Command {
   // The action to preform when the command is executed.
   virtual int Action(const std::vector<std::string>& args) = 0;
 
+ protected:
+  // The arguments that the command is executed with, flags included.
+  const std::vector<std::string>& GetCommandLine() const {
+    return command_line_;
+  }
+
  private:
   struct Flag {
     explicit Flag(android::StringPiece name, android::StringPiece description, bool is_required,
@@ -129,6 +135,7 @@ class Command {
   // in memory - we add them to the vector of string views so the pointers may not change,
   // with or without short string buffer utilization in std::string.
   std::deque<std::string> environment_args_;
+  std::vector<std::string> command_line_;
 };
 
 }  // namespace aapt
@@ -18,8 +18,14 @@
 
 #include <dirent.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "Diagnostics.h"
 #include "ResourceParser.h"
 #include "ResourceTable.h"
 #include "android-base/errors.h"
@@ -32,6 +38,7 @@
 #include "androidfw/Image.h"
 #include "androidfw/Png.h"
 #include "androidfw/StringPiece.h"
+#include "cmd/CompileCache.h"
 #include "cmd/Util.h"
 #include "compile/IdAssigner.h"
 #include "compile/InlineXmlFormatParser.h"
@@ -615,7 +622,9 @@ static bool CompilePng(IAaptContext* context, const CompileOptions& options,
     const StringPiece content(reinterpret_cast<const char*>(data->data()), data->size());
     android::PngChunkFilter png_chunk_filter(content);
     android::SourcePathDiagnostics source_diag(path_data.source, context->GetDiagnostics());
+    BeginTrace("ReadPng");
     auto image = android::ReadPng(&png_chunk_filter, &source_diag);
+    EndTrace("ReadPng");
     if (!image) {
       return false;
     }
@@ -647,15 +656,25 @@ static bool CompilePng(IAaptContext* context, const CompileOptions& options,
       }
     }
 
-    // Write the crunched PNG.
-    if (!android::WritePng(image.get(), nine_patch.get(), &crunched_png_buffer_out,
-                           {.compression_level = options.png_compression_level_int}, &source_diag,
-                           context->IsVerbose())) {
+    // Write the crunched PNG. Unless it is a 9-patch, the encoding stops as soon as the crunched
+    // PNG is larger than the original, which is used then.
+    const android::PngOptions png_options = {
+        .compression_level = options.png_compression_level_int,
+        .max_size = nine_patch != nullptr ? 0 : png_chunk_filter.ByteCount(),
+    };
+    bool crunched_png_too_large = false;
+    BeginTrace("WritePng");
+    const bool crunched =
+        android::WritePng(image.get(), nine_patch.get(), &crunched_png_buffer_out, png_options,
+                          &source_diag, context->IsVerbose(), &crunched_png_too_large);
+    EndTrace("WritePng");
+    if (!crunched && !crunched_png_too_large) {
       return false;
     }
 
     if (nine_patch != nullptr ||
-        crunched_png_buffer_out.ByteCount() <= png_chunk_filter.ByteCount()) {
+        (!crunched_png_too_large &&
+         crunched_png_buffer_out.ByteCount() <= png_chunk_filter.ByteCount())) {
       // No matter what, we must use the re-encoded PNG, even if it is larger.
       // 9-patch images must be re-encoded since their borders are stripped.
       buffer.AppendBuffer(std::move(crunched_png_buffer));
@@ -674,6 +693,8 @@ static bool CompilePng(IAaptContext* context, const CompileOptions& options,
       io::Copy(&filtered_png_buffer_out, &png_chunk_filter);
       buffer.AppendBuffer(std::move(filtered_png_buffer));
     }
+    TraceCounter("PNG bytes read", data->size());
+    TraceCounter("PNG bytes written", buffer.size());
 
     if (context->IsVerbose()) {
       // For debugging only, use the legacy PNG cruncher and compare the resulting file sizes.
@@ -780,86 +801,245 @@ class CompileContext : public IAaptContext {
   bool verbose_ = false;
 };
 
-int Compile(IAaptContext* context, io::IFileCollection* inputs, IArchiveWriter* output_writer,
-             CompileOptions& options) {
-  TRACE_CALL();
-  bool error = false;
+using CompileFunc = bool (*)(IAaptContext* context, const CompileOptions& options,
+                             const ResourcePathData& path_data, io::IFile* file,
+                             IArchiveWriter* writer, const std::string& output_path);
 
-  // Iterate over the input files in a stable, platform-independent manner
-  auto file_iterator  = inputs->Iterator();
-  while (file_iterator->HasNext()) {
-    auto file = file_iterator->Next();
-    const std::string& path = file->GetSource().path;
+// Adds the entries of a compiled file to the writer.
+static bool WriteBufferedEntries(IAaptContext* context, const BufferedArchiveWriter& entries,
+                                 IArchiveWriter* writer) {
+  if (!entries.WriteTo(writer)) {
+    context->GetDiagnostics()->Error(android::DiagMessage()
+                                     << "failed to write: " << writer->GetError());
+    return false;
+  }
+  return true;
+}
 
-    // Skip hidden input files
-    if (file::IsHidden(path)) {
-      continue;
+// Compiles a single input file into the writer. Returns false if the file is not a valid resource
+// file or failed to compile.
+static bool CompileInputFile(IAaptContext* context, const CompileOptions& options,
+                             io::IFile* file, char dir_separator, IArchiveWriter* output_writer) {
+  const std::string& path = file->GetSource().path;
+  if (!options.res_zip && !IsValidFile(context, path)) {
+    return false;
+  }
+
+  // Extract resource type information from the full path
+  std::string err_str;
+  ResourcePathData path_data;
+  if (auto maybe_path_data = ExtractResourcePathData(path, dir_separator, &err_str, options)) {
+    path_data = std::move(maybe_path_data.value());
+  } else {
+    context->GetDiagnostics()->Error(android::DiagMessage(file->GetSource()) << err_str);
+    return false;
+  }
+
+  if (path_data.config.minorVersion != 0 && path_data.config.sdkVersion < SDK_BAKLAVA) {
+    context->GetDiagnostics()->Error(
+        android::DiagMessage(file->GetSource())
+        << "SDK version in '" << path_data.config
+        << "' is not valid: minor versions are only available since v" << SDK_BAKLAVA);
+    return false;
+  }
+
+  // Determine how to compile the file based on its type.
+  CompileFunc compile_func = &CompileFile;
+  if (path_data.resource_dir == "values" && path_data.extension == "xml") {
+    compile_func = &CompileTable;
+    // We use a different extension (not necessary anymore, but avoids altering the existing
+    // build system logic).
+    path_data.extension = "arsc";
+  } else if (const ResourceType* type = ParseResourceType(path_data.resource_dir)) {
+    if (*type != ResourceType::kRaw) {
+      if (*type == ResourceType::kXml || path_data.extension == "xml") {
+        compile_func = &CompileXml;
+      } else if ((!options.no_png_crunch && path_data.extension == "png")
+                 || path_data.extension == "9.png") {
+        compile_func = &CompilePng;
+      }
     }
+  } else {
+    context->GetDiagnostics()->Error(android::DiagMessage()
+                                     << "invalid file path '" << path_data.source << "'");
+    return false;
+  }
 
-    if (!options.res_zip && !IsValidFile(context, path)) {
-      error = true;
-      continue;
+  // Treat periods as a reserved character that should not be present in a file name
+  // Legacy support for AAPT which did not reserve periods
+  if (compile_func != &CompileFile && !options.legacy_mode && path_data.name.contains('.')) {
+    context->GetDiagnostics()->Error(android::DiagMessage(file->GetSource())
+                                     << "file name cannot contain '.' other than for"
+                                     << " specifying the extension");
+    return false;
+  }
+
+  // Every file writes the text symbols to the same path, which the cache doesn't keep.
+  std::string cache_key;
+  if (options.cache_dir && !options.generate_text_symbols_path) {
+    cache_key = CompileCache::ComputeKey(file, options);
+  }
+  std::optional<CompileCache> cache;
+  BufferedArchiveWriter cache_writer;
+  IArchiveWriter* writer = output_writer;
+  if (!cache_key.empty()) {
+    cache.emplace(options.cache_dir.value());
+    std::vector<CompileCache::Entry> entries;
+    if (cache->Find(cache_key, &entries)) {
+      if (context->IsVerbose()) {
+        context->GetDiagnostics()->Note(android::DiagMessage(file->GetSource())
+                                        << "using the compiled file from the cache");
+      }
+      return WriteBufferedEntries(context, BufferedArchiveWriter(std::move(entries)),
+                                  output_writer);
     }
+    writer = &cache_writer;
+  }
 
-    // Extract resource type information from the full path
-    std::string err_str;
-    ResourcePathData path_data;
-    if (auto maybe_path_data = ExtractResourcePathData(
-        path, inputs->GetDirSeparator(), &err_str, options)) {
-      path_data = std::move(maybe_path_data.value());
-    } else {
-      context->GetDiagnostics()->Error(android::DiagMessage(file->GetSource()) << err_str);
-      error = true;
-      continue;
+  const std::string out_path = BuildIntermediateContainerFilename(path_data);
+  if (!compile_func(context, options, path_data, file, writer, out_path)) {
+    context->GetDiagnostics()->Error(android::DiagMessage(file->GetSource())
+                                     << "file failed to compile");
+    return false;
+  }
+
+  if (cache) {
+    if (!cache->Store(cache_key, cache_writer.GetEntries())) {
+      context->GetDiagnostics()->Warn(android::DiagMessage(options.cache_dir.value())
+                                      << "failed to cache '" << out_path << "'");
     }
+    return WriteBufferedEntries(context, cache_writer, output_writer);
+  }
+  return true;
+}
 
-    if (path_data.config.minorVersion != 0 && path_data.config.sdkVersion < SDK_BAKLAVA) {
-      context->GetDiagnostics()->Error(
-          android::DiagMessage(file->GetSource())
-          << "SDK version in '" << path_data.config
-          << "' is not valid: minor versions are only available since v" << SDK_BAKLAVA);
-      error = true;
-      continue;
+namespace {
+
+// Opens a file of a zip under a lock, since its entries are all read through the same handle.
+class SerializedFile : public io::IFile {
+ public:
+  SerializedFile(io::IFile* file, std::mutex* lock) : file_(file), lock_(lock) {
+  }
+
+  std::unique_ptr<io::IData> OpenAsData() override {
+    std::lock_guard guard(*lock_);
+    return file_->OpenAsData();
+  }
+
+  std::unique_ptr<android::InputStream> OpenInputStream() override {
+    std::lock_guard guard(*lock_);
+    return file_->OpenInputStream();
+  }
+
+  const android::Source& GetSource() const override {
+    return file_->GetSource();
+  }
+
+  bool WasCompressed() override {
+    return file_->WasCompressed();
+  }
+
+  bool GetModificationTime(struct tm* buf) const override {
+    return file_->GetModificationTime(buf);
+  }
+
+ private:
+  io::IFile* file_;
+  std::mutex* lock_;
+};
+
+}  // namespace
+
+// Compiles the files on options.jobs threads. The diagnostics and the entries of each file are
+// buffered, then passed on in the order of the files, so the result is the same as compiling them
+// one after the other.
+static bool CompileInParallel(IAaptContext* context, const CompileOptions& options,
+                              const std::vector<io::IFile*>& files, char dir_separator,
+                              IArchiveWriter* output_writer) {
+  struct Result {
+    BufferedDiagnostics diagnostics;
+    BufferedArchiveWriter writer;
+    bool compiled = false;
+    bool done = false;
+  };
+  std::vector<Result> results(files.size());
+  std::mutex results_lock;
+  std::condition_variable result_done;
+  std::mutex read_lock;
+  std::atomic<size_t> next_file = 0;
+
+  const bool verbose = context->GetDiagnostics()->IsVerbose();
+  auto compile_files = [&]() {
+    for (size_t i = next_file++; i < files.size(); i = next_file++) {
+      Result& result = results[i];
+      result.diagnostics.SetVerbose(verbose);
+      JobContext job_context(context, &result.diagnostics);
+      SerializedFile serialized_file(files[i], &read_lock);
+      io::IFile* file = options.res_zip ? &serialized_file : files[i];
+      result.compiled = CompileInputFile(&job_context, options, file, dir_separator,
+                                         &result.writer);
+
+      std::lock_guard guard(results_lock);
+      result.done = true;
+      result_done.notify_all();
     }
+  };
 
-    // Determine how to compile the file based on its type.
-    auto compile_func = &CompileFile;
-    if (path_data.resource_dir == "values" && path_data.extension == "xml") {
-      compile_func = &CompileTable;
-      // We use a different extension (not necessary anymore, but avoids altering the existing
-      // build system logic).
-      path_data.extension = "arsc";
-    } else if (const ResourceType* type = ParseResourceType(path_data.resource_dir)) {
-      if (*type != ResourceType::kRaw) {
-        if (*type == ResourceType::kXml || path_data.extension == "xml") {
-          compile_func = &CompileXml;
-        } else if ((!options.no_png_crunch && path_data.extension == "png")
-                   || path_data.extension == "9.png") {
-          compile_func = &CompilePng;
-        }
-      }
-    } else {
-      context->GetDiagnostics()->Error(android::DiagMessage()
-                                       << "invalid file path '" << path_data.source << "'");
+  const size_t thread_count = std::min<size_t>(options.jobs, files.size());
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; i++) {
+    threads.emplace_back(compile_files);
+  }
+
+  bool error = false;
+  for (size_t i = 0; i < files.size(); i++) {
+    Result& result = results[i];
+    {
+      std::unique_lock guard(results_lock);
+      result_done.wait(guard, [&result] { return result.done; });
+    }
+    result.diagnostics.FlushTo(context->GetDiagnostics());
+    if (!WriteBufferedEntries(context, result.writer, output_writer)) {
       error = true;
-      continue;
     }
-
-    // Treat periods as a reserved character that should not be present in a file name
-    // Legacy support for AAPT which did not reserve periods
-    if (compile_func != &CompileFile && !options.legacy_mode && path_data.name.contains('.')) {
+    if (!result.compiled) {
       error = true;
-      context->GetDiagnostics()->Error(android::DiagMessage(file->GetSource())
-                                       << "file name cannot contain '.' other than for"
-                                       << " specifying the extension");
+    }
+  }
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return !error;
+}
+
+int Compile(IAaptContext* context, io::IFileCollection* inputs, IArchiveWriter* output_writer,
+             CompileOptions& options) {
+  TRACE_CALL();
+  bool error = false;
+
+  // Iterate over the input files in a stable, platform-independent manner
+  std::vector<io::IFile*> files;
+  auto file_iterator  = inputs->Iterator();
+  while (file_iterator->HasNext()) {
+    auto file = file_iterator->Next();
+
+    // Skip hidden input files
+    if (file::IsHidden(file->GetSource().path)) {
       continue;
     }
+    files.push_back(file);
+  }
 
-    const std::string out_path = BuildIntermediateContainerFilename(path_data);
-    if (!compile_func(context, options, path_data, file, output_writer, out_path)) {
-      context->GetDiagnostics()->Error(android::DiagMessage(file->GetSource())
-                                       << "file failed to compile");
-      error = true;
+  // Every file writes the text symbols to the same path, so they must be compiled in order.
+  if (options.jobs > 1 && files.size() > 1 && !options.generate_text_symbols_path) {
+    error = !CompileInParallel(context, options, files, inputs->GetDirSeparator(), output_writer);
+  } else {
+    for (io::IFile* file : files) {
+      if (!CompileInputFile(context, options, file, inputs->GetDirSeparator(), output_writer)) {
+        error = true;
+      }
     }
   }
 
@@ -868,6 +1048,7 @@ int Compile(IAaptContext* context, io::IFileCollection* inputs, IArchiveWriter*
 
 int CompileCommand::Action(const std::vector<std::string>& args) {
   TRACE_FLUSH(trace_folder_? trace_folder_.value() : "", "CompileCommand::Action");
+  TRACE_PERF_REPORT(perf_report_path_.value_or(""));
   CompileContext context(diagnostic_);
   context.SetVerbose(options_.verbose);
 
@@ -988,6 +1169,10 @@ int CompileCommand::Action(const std::vector<std::string>& args) {
     options_.png_compression_level_int = options_.png_compression_level->front() - '0';
   }
 
+  if (jobs_ && !ParseJobsParameter(jobs_.value(), context.GetDiagnostics(), &options_.jobs)) {
+    return 1;
+  }
+
   return Compile(&context, file_collection.get(), archive_writer.get(), options_);
 }
 
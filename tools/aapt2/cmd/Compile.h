@@ -49,6 +49,10 @@ struct CompileOptions {
   FeatureFlagValues feature_flag_values;
   std::optional<std::string> png_compression_level;
   int png_compression_level_int = 9;
+  // The number of files compiled at once. The output and the diagnostics are the same in any case.
+  int jobs = 1;
+  // The directory of the CompileCache, if any.
+  std::optional<std::string> cache_dir;
 };
 
 /** Parses flags and compiles resources to be used in linking.  */
@@ -81,8 +85,21 @@ class CompileCommand : public Command {
         "Sets the visibility of the compiled resources to the specified\n"
             "level. Accepted levels: public, private, default", &visibility_);
     AddOptionalSwitch("-v", "Enables verbose logging", &options_.verbose);
+    AddOptionalFlag("-j",
+                    "Number of files to compile in parallel, 1 by default. The output and the\n"
+                    "diagnostics are in the same order as with a single job.",
+                    &jobs_);
+    AddOptionalFlag("--cache-dir",
+                    "Directory to cache the compiled files in. A file that was compiled before\n"
+                    "with the same contents, path, options and version of aapt2 is copied from\n"
+                    "the cache instead of being compiled again.",
+                    &options_.cache_dir, Command::kPath);
     AddOptionalFlag("--trace-folder", "Generate systrace json trace fragment to specified folder.",
                     &trace_folder_);
+    AddOptionalFlag("--perf-report",
+                    "Write a summary of the wall time, CPU time and peak memory growth of each\n"
+                    "traced step, and of the items and bytes they processed, to the given file.",
+                    &perf_report_path_);
     AddOptionalFlag("--source-path",
                       "Sets the compiled resource file source file path to the given string.",
                       &options_.source_path);
@@ -114,6 +131,8 @@ class CompileCommand : public Command {
   CompileOptions options_;
   std::optional<std::string> visibility_;
   std::optional<std::string> trace_folder_;
+  std::optional<std::string> perf_report_path_;
+  std::optional<std::string> jobs_;
   std::vector<std::string> feature_flags_args_;
 };
 
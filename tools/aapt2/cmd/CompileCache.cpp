@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cmd/CompileCache.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#include "android-base/file.h"
+#include "android-base/stringprintf.h"
+#include "android-base/utf8.h"
+#include "build/version.h"
+#include "cmd/Compile.h"
+#include "util/Files.h"
+#include "util/Sha256.h"
+#include "util/Util.h"
+
+using ::android::StringPiece;
+
+namespace aapt {
+
+namespace {
+
+constexpr char kMagic[] = "AAPTCC01";
+constexpr size_t kMagicSize = sizeof(kMagic) - 1;
+
+template <typename T>
+void AppendValue(T value, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool ReadValue(StringPiece* in, T* out_value) {
+  if (in->size() < sizeof(T)) {
+    return false;
+  }
+  memcpy(out_value, in->data(), sizeof(T));
+  in->remove_prefix(sizeof(T));
+  return true;
+}
+
+bool ReadString(StringPiece* in, size_t size, std::string* out_str) {
+  if (in->size() < size) {
+    return false;
+  }
+  out_str->assign(in->data(), size);
+  in->remove_prefix(size);
+  return true;
+}
+
+}  // namespace
+
+std::string CompileCache::ComputeKey(io::IFile* file, const CompileOptions& options) {
+  std::unique_ptr<io::IData> data = file->OpenAsData();
+  if (!data) {
+    return {};
+  }
+
+  util::Sha256 hasher;
+  hasher.Add(util::GetToolFingerprint());
+  // The fingerprint of a local build only has the month it was built in.
+  hasher.Add(android::build::GetBuildNumber());
+
+  // The path ends up in the compiled file, and decides how the file is compiled.
+  hasher.Add(file->GetSource().path);
+  hasher.AddBytes(data->data(), data->size());
+
+  hasher.Add(options.source_path);
+  hasher.Add(options.pseudo_localize_gender_values);
+  hasher.Add(options.pseudo_localize_gender_ratio);
+  hasher.Add(static_cast<uint64_t>(options.visibility.has_value()
+                                       ? static_cast<int>(options.visibility.value()) + 1
+                                       : 0));
+  hasher.Add(static_cast<uint64_t>(options.pseudolocalize));
+  hasher.Add(static_cast<uint64_t>(options.no_png_crunch));
+  hasher.Add(static_cast<uint64_t>(options.legacy_mode));
+  hasher.Add(static_cast<uint64_t>(options.preserve_visibility_of_styleables));
+  hasher.Add(options.product_);
+  hasher.Add(static_cast<uint64_t>(options.png_compression_level_int));
+  hasher.Add(static_cast<uint64_t>(options.feature_flag_values.size()));
+  for (const auto& [name, properties] : options.feature_flag_values) {
+    hasher.Add(StringPiece(name));
+    hasher.Add(static_cast<uint64_t>(properties.read_only));
+    hasher.Add(static_cast<uint64_t>(properties.enabled.has_value()
+                                         ? static_cast<int>(properties.enabled.value()) + 1
+                                         : 0));
+  }
+  return hasher.Finish();
+}
+
+std::string CompileCache::GetPath(const std::string& key) const {
+  // Spreads the entries over 256 directories.
+  return file::BuildPath({dir_, key.substr(0, 2), key});
+}
+
+bool CompileCache::Find(const std::string& key, std::vector<Entry>* out_entries) const {
+  std::string contents;
+  if (!android::base::ReadFileToString(GetPath(key), &contents)) {
+    return false;
+  }
+
+  StringPiece in(contents);
+  uint32_t entry_count = 0;
+  if (!util::StartsWith(in, StringPiece(kMagic, kMagicSize))) {
+    return false;
+  }
+  in.remove_prefix(kMagicSize);
+  if (!ReadValue(&in, &entry_count)) {
+    return false;
+  }
+
+  std::vector<Entry> entries(entry_count);
+  for (Entry& entry : entries) {
+    uint32_t path_size = 0;
+    uint64_t data_size = 0;
+    if (!ReadValue(&in, &path_size) || !ReadString(&in, path_size, &entry.path) ||
+        !ReadValue(&in, &entry.flags) || !ReadValue(&in, &data_size) ||
+        !ReadString(&in, data_size, &entry.data)) {
+      return false;
+    }
+  }
+  if (!in.empty()) {
+    return false;
+  }
+  *out_entries = std::move(entries);
+  return true;
+}
+
+bool CompileCache::Store(const std::string& key, const std::vector<Entry>& entries) const {
+  std::string contents(kMagic, kMagicSize);
+  AppendValue(static_cast<uint32_t>(entries.size()), &contents);
+  for (const Entry& entry : entries) {
+    AppendValue(static_cast<uint32_t>(entry.path.size()), &contents);
+    contents.append(entry.path);
+    AppendValue(entry.flags, &contents);
+    AppendValue(static_cast<uint64_t>(entry.data.size()), &contents);
+    contents.append(entry.data);
+  }
+
+  const std::string path = GetPath(key);
+  if (!file::mkdirs(file::BuildPath({dir_, key.substr(0, 2)}))) {
+    return false;
+  }
+
+  // Other threads or processes may be storing the same entry: write it to a file of our own and
+  // move it into place, so that no one ever reads a partial entry.
+  static std::atomic<uint32_t> next_temp_id = 0;
+  const std::string temp_path =
+      android::base::StringPrintf("%s.%d.%u.tmp", path.c_str(), getpid(), next_temp_id++);
+  if (!android::base::WriteStringToFile(contents, temp_path)) {
+    android::base::utf8::unlink(temp_path.c_str());
+    return false;
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    // On Windows, renaming fails if another run stored the entry first.
+    android::base::utf8::unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace aapt
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAPT2_COMPILECACHE_H
+#define AAPT2_COMPILECACHE_H
+
+#include <string>
+#include <vector>
+
+#include "format/Archive.h"
+#include "io/File.h"
+
+namespace aapt {
+
+struct CompileOptions;
+
+// A directory of the outputs of 'aapt2 compile', named after a digest of everything that they
+// depend on: the contents and the path of the input file, the options that change the output and
+// the version of aapt2. A build that compiles a file that it already compiled copies the output
+// from the cache instead.
+//
+// The cache is never pruned, and can be shared between runs on different threads or processes.
+class CompileCache {
+ public:
+  // An entry that compiling a file writes to the output archive.
+  using Entry = BufferedArchiveWriter::Entry;
+
+  explicit CompileCache(std::string dir) : dir_(std::move(dir)) {
+  }
+
+  // Returns the digest of compiling the file with the options, as hex, or an empty string if the
+  // file can't be read.
+  static std::string ComputeKey(io::IFile* file, const CompileOptions& options);
+
+  // Reads the entries cached for the key. Returns false if there are none.
+  bool Find(const std::string& key, std::vector<Entry>* out_entries) const;
+
+  // Caches the entries for the key. Failing is harmless, the file is compiled again next time.
+  bool Store(const std::string& key, const std::vector<Entry>& entries) const;
+
+ private:
+  std::string GetPath(const std::string& key) const;
+
+  const std::string dir_;
+};
+
+}  // namespace aapt
+
+#endif  // AAPT2_COMPILECACHE_H
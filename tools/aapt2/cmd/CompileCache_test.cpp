@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CompileCache.h"
+
+#include "android-base/file.h"
+#include "cmd/Compile.h"
+#include "io/FileSystem.h"
+#include "test/Test.h"
+#include "util/Files.h"
+
+namespace aapt {
+
+TEST(CompileCacheTest, KeyDependsOnContentsAndOptions) {
+  TemporaryFile input;
+  ASSERT_TRUE(android::base::WriteStringToFd("<resources/>", input.fd));
+  io::RegularFile file(android::Source(input.path));
+
+  CompileOptions options;
+  const std::string key = CompileCache::ComputeKey(&file, options);
+  ASSERT_FALSE(key.empty());
+  EXPECT_EQ(key, CompileCache::ComputeKey(&file, options));
+
+  CompileOptions pseudolocalize;
+  pseudolocalize.pseudolocalize = true;
+  EXPECT_NE(key, CompileCache::ComputeKey(&file, pseudolocalize));
+
+  // Doesn't change the output.
+  CompileOptions verbose;
+  verbose.verbose = true;
+  EXPECT_EQ(key, CompileCache::ComputeKey(&file, verbose));
+
+  ASSERT_TRUE(android::base::WriteStringToFile("<resources></resources>", input.path));
+  EXPECT_NE(key, CompileCache::ComputeKey(&file, options));
+}
+
+TEST(CompileCacheTest, StoreAndFind) {
+  TemporaryDir dir;
+  CompileCache cache(dir.path);
+  const std::string key(64, 'a');
+
+  std::vector<CompileCache::Entry> entries;
+  EXPECT_FALSE(cache.Find(key, &entries));
+
+  ASSERT_TRUE(cache.Store(key, {{"values_values.arsc.flat", 0, std::string("\0\1\2", 3)},
+                                {"values_values.arsc.flat.txt", 1, ""}}));
+  ASSERT_TRUE(cache.Find(key, &entries));
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].path, "values_values.arsc.flat");
+  EXPECT_EQ(entries[0].flags, 0u);
+  EXPECT_EQ(entries[0].data, std::string("\0\1\2", 3));
+  EXPECT_EQ(entries[1].path, "values_values.arsc.flat.txt");
+  EXPECT_EQ(entries[1].flags, 1u);
+  EXPECT_EQ(entries[1].data, "");
+}
+
+TEST(CompileCacheTest, IgnoresTruncatedEntries) {
+  TemporaryDir dir;
+  CompileCache cache(dir.path);
+  const std::string key(64, 'b');
+  ASSERT_TRUE(cache.Store(key, {{"layout_main.xml.flat", 0, std::string(100, 'x')}}));
+
+  const std::string path = file::BuildPath({dir.path, "bb", key});
+  std::string contents;
+  ASSERT_TRUE(android::base::ReadFileToString(path, &contents));
+  ASSERT_TRUE(android::base::WriteStringToFile(contents.substr(0, contents.size() - 1), path));
+
+  std::vector<CompileCache::Entry> entries;
+  EXPECT_FALSE(cache.Find(key, &entries));
+}
+
+}  // namespace aapt
@@ -175,6 +175,51 @@ TEST_F(CompilerTest, DirInput) {
   ASSERT_EQ(::android::base::utf8::unlink(kOutputFlata.c_str()), 0);
 }
 
+TEST_F(CompilerTest, DirInputInParallel) {
+  StdErrDiagnostics diag;
+  const std::string kResDir = BuildPath({android::base::Dirname(android::base::GetExecutablePath()),
+                                         "integration-tests", "CompileTest", "DirInput", "res"});
+  const std::string kSerialFlata = BuildPath({testing::TempDir(), "compiled_serial.flata"});
+  const std::string kParallelFlata = BuildPath({testing::TempDir(), "compiled_parallel.flata"});
+  ::android::base::utf8::unlink(kSerialFlata.c_str());
+  ::android::base::utf8::unlink(kParallelFlata.c_str());
+
+  ASSERT_EQ(CompileCommand(&diag).Execute({"--dir", kResDir, "-o", kSerialFlata}, &std::cerr), 0);
+  ASSERT_EQ(CompileCommand(&diag).Execute({"--dir", kResDir, "-o", kParallelFlata, "-j", "4"},
+                                          &std::cerr),
+            0);
+
+  {
+    // The entries are written in the same order and with the same contents.
+    std::string err;
+    std::unique_ptr<io::ZipFileCollection> serial =
+        io::ZipFileCollection::Create(kSerialFlata, &err);
+    ASSERT_NE(serial, nullptr) << err;
+    std::unique_ptr<io::ZipFileCollection> parallel =
+        io::ZipFileCollection::Create(kParallelFlata, &err);
+    ASSERT_NE(parallel, nullptr) << err;
+
+    auto serial_files = serial->Iterator();
+    auto parallel_files = parallel->Iterator();
+    while (serial_files->HasNext()) {
+      ASSERT_TRUE(parallel_files->HasNext());
+      io::IFile* serial_file = serial_files->Next();
+      io::IFile* parallel_file = parallel_files->Next();
+      ASSERT_EQ(serial_file->GetSource().path, parallel_file->GetSource().path);
+
+      std::unique_ptr<io::IData> serial_data = serial_file->OpenAsData();
+      std::unique_ptr<io::IData> parallel_data = parallel_file->OpenAsData();
+      ASSERT_NE(serial_data, nullptr);
+      ASSERT_NE(parallel_data, nullptr);
+      ASSERT_EQ(serial_data->size(), parallel_data->size());
+      EXPECT_EQ(memcmp(serial_data->data(), parallel_data->data(), serial_data->size()), 0);
+    }
+    EXPECT_FALSE(parallel_files->HasNext());
+  }
+  ASSERT_EQ(::android::base::utf8::unlink(kSerialFlata.c_str()), 0);
+  ASSERT_EQ(::android::base::utf8::unlink(kParallelFlata.c_str()), 0);
+}
+
 TEST_F(CompilerTest, ZipInput) {
   StdErrDiagnostics diag;
   std::unique_ptr<IAaptContext> context = test::ContextBuilder().Build();
@@ -34,6 +34,7 @@
 #include "io/Util.h"
 #include "process/IResourceTableConsumer.h"
 #include "process/SymbolTable.h"
+#include "trace/TraceBuffer.h"
 #include "util/Util.h"
 
 using ::android::StringPiece;
@@ -273,6 +274,7 @@ class Context : public IAaptContext {
 int Convert(IAaptContext* context, LoadedApk* apk, IArchiveWriter* output_writer,
             ApkFormat output_format, TableFlattenerOptions table_flattener_options,
             XmlFlattenerOptions xml_flattener_options) {
+  TRACE_CALL();
   unique_ptr<IApkSerializer> serializer;
   if (output_format == ApkFormat::kBinary) {
     serializer.reset(new BinaryApkSerializer(context, apk->GetSource(), table_flattener_options,
@@ -390,6 +392,8 @@ int ConvertCommand::Action(const std::vector<std::string>& args) {
     Usage(&std::cerr);
     return 1;
   }
+  TRACE_FLUSH(trace_folder_.value_or(""), "ConvertCommand::Action");
+  TRACE_PERF_REPORT(perf_report_path_.value_or(""));
 
   Context context;
   context.SetVerbose(verbose_);
@@ -428,6 +432,9 @@ int ConvertCommand::Action(const std::vector<std::string>& args) {
   if (enable_sparse_encoding_) {
     table_flattener_options_.sparse_entries = SparseEntriesMode::Enabled;
   }
+  if (auto_sparse_encoding_) {
+    table_flattener_options_.sparse_entries = SparseEntriesMode::Auto;
+  }
   if (force_sparse_encoding_) {
     table_flattener_options_.sparse_entries = SparseEntriesMode::Forced;
   }
@@ -40,6 +40,11 @@ class ConvertCommand : public Command {
         "This decreases APK size at the cost of resource retrieval performance.\n"
         "Only applies sparse encoding if minSdk of the APK is >= 32",
         &enable_sparse_encoding_);
+    AddOptionalSwitch(
+        "--auto-sparse-encoding",
+        "Like --enable-sparse-encoding, but only sparse encodes the types that it makes smaller\n"
+        "and that have few enough entries for their lookups to stay fast.",
+        &auto_sparse_encoding_);
     AddOptionalSwitch(
         "--force-sparse-encoding",
         "Enables encoding sparse entries using a binary search tree.\n"
@@ -73,6 +78,12 @@ class ConvertCommand : public Command {
         "store the same resource value only once in resource table which decreases APK size.\n"
         "Has no effect on APKs where resource names are kept.",
         &table_flattener_options_.deduplicate_entry_values);
+    AddOptionalFlag("--trace-folder", "Generate systrace json trace fragment to specified folder.",
+                    &trace_folder_);
+    AddOptionalFlag("--perf-report",
+                    "Write a summary of the wall time, CPU time and peak memory growth of each\n"
+                    "traced step, and of the items and bytes they processed, to the given file.",
+                    &perf_report_path_);
     AddOptionalSwitch("-v", "Enables verbose logging", &verbose_);
   }
 
@@ -88,9 +99,12 @@ class ConvertCommand : public Command {
   std::optional<std::string> output_format_;
   bool verbose_ = false;
   bool enable_sparse_encoding_ = false;
+  bool auto_sparse_encoding_ = false;
   bool force_sparse_encoding_ = false;
   bool enable_compact_entries_ = false;
   std::optional<std::string> resources_config_path_;
+  std::optional<std::string> trace_folder_;
+  std::optional<std::string> perf_report_path_;
 };
 
 int Convert(IAaptContext* context, LoadedApk* input, IArchiveWriter* output_writer,
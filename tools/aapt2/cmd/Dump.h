@@ -65,6 +65,14 @@ class DumpApkCommand : public Command {
   /** Perform the dump operation on the apk. */
   virtual int Dump(LoadedApk* apk) = 0;
 
+  /**
+   * When the resource table of the apk is parsed. By default only once Dump() asks for it, so that
+   * the commands that print the manifest or an XML file never parse it.
+   */
+  virtual LoadedApk::TableLoading GetTableLoading() const {
+    return LoadedApk::TableLoading::kOnFirstUse;
+  }
+
   int Action(const std::vector<std::string>& args) final {
     if (args.size() < 1) {
       diag_->Error(android::DiagMessage() << "No dump apk specified.");
@@ -73,7 +81,7 @@ class DumpApkCommand : public Command {
 
     bool error = false;
     for (auto apk : args) {
-      auto loaded_apk = LoadedApk::LoadApkFromPath(apk, diag_);
+      auto loaded_apk = LoadedApk::LoadApkFromPath(apk, diag_, GetTableLoading());
       if (!loaded_apk) {
         error = true;
         continue;
@@ -144,6 +152,11 @@ class DumpBadgingCommand : public DumpApkCommand {
     return DumpManifest(apk, options_, GetPrinter(), GetDiagnostics());
   }
 
+  // Badging carries on without the table, so a malformed one must fail the loading.
+  LoadedApk::TableLoading GetTableLoading() const override {
+    return LoadedApk::TableLoading::kEager;
+  }
+
  private:
   DumpManifestOptions options_;
 };
@@ -180,6 +193,10 @@ class DumpPermissionsCommand : public DumpApkCommand {
     options.only_permissions = true;
     return DumpManifest(apk, options, GetPrinter(), GetDiagnostics());
   }
+
+  LoadedApk::TableLoading GetTableLoading() const override {
+    return LoadedApk::TableLoading::kEager;
+  }
 };
 
 class DumpStringsCommand : public DumpApkCommand {
@@ -125,4 +125,23 @@ TEST_F(DumpTest, DumpBadgingApkBuiltWithAaptAndTagsInWrongPlace) {
   ASSERT_EQ(output, expected);
 }
 
+TEST_F(DumpTest, ResourceTableLoadedOnFirstUse) {
+  auto apk_path = file::BuildPath(
+      {android::base::GetExecutableDirectory(), "integration-tests", "DumpTest", "components.apk"});
+  auto eager_apk = LoadedApk::LoadApkFromPath(apk_path, &noop_diag);
+  auto lazy_apk = LoadedApk::LoadApkFromPath(apk_path, &noop_diag,
+                                             LoadedApk::TableLoading::kOnFirstUse);
+  ASSERT_THAT(eager_apk, Ne(nullptr));
+  ASSERT_THAT(lazy_apk, Ne(nullptr));
+  ASSERT_THAT(lazy_apk->GetResourceTable(), Ne(nullptr));
+  EXPECT_THAT(lazy_apk->GetResourceTable()->packages.size(),
+              Eq(eager_apk->GetResourceTable()->packages.size()));
+
+  std::string eager_output;
+  DumpBadgingToString(eager_apk.get(), &eager_output);
+  std::string lazy_output;
+  DumpBadgingToString(lazy_apk.get(), &lazy_output);
+  EXPECT_THAT(lazy_output, Eq(eager_output));
+}
+
 }  // namespace aapt
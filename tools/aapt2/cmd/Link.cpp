@@ -17,15 +17,23 @@
 #include "Link.h"
 
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
+#include <climits>
+#include <functional>
+#include <mutex>
 #include <queue>
+#include <set>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include "AppInfo.h"
 #include "Debug.h"
+#include "Diagnostics.h"
 #include "LoadedApk.h"
 #include "NameMangler.h"
 #include "ResourceUtils.h"
@@ -40,6 +48,8 @@
 #include "androidfw/IDiagnostics.h"
 #include "androidfw/Locale.h"
 #include "androidfw/StringPiece.h"
+#include "build/version.h"
+#include "cmd/LinkState.h"
 #include "cmd/Util.h"
 #include "compile/IdAssigner.h"
 #include "compile/XmlIdCollector.h"
@@ -50,6 +60,7 @@
 #include "format/binary/XmlFlattener.h"
 #include "format/proto/ProtoDeserialize.h"
 #include "format/proto/ProtoSerialize.h"
+#include "google/protobuf/arena.h"
 #include "io/FileSystem.h"
 #include "io/Util.h"
 #include "io/ZipArchive.h"
@@ -74,6 +85,7 @@
 #include "split/TableSplitter.h"
 #include "trace/TraceBuffer.h"
 #include "util/Files.h"
+#include "util/Sha256.h"
 #include "xml/XmlDom.h"
 
 using ::android::ConfigDescription;
@@ -308,6 +320,7 @@ struct ResourceFileFlattenerOptions {
   std::unordered_set<std::string> extensions_to_not_compress;
   std::optional<std::regex> regex_to_not_compress;
   FeatureFlagValues feature_flag_values;
+  int jobs = 1;
 };
 
 // A sampling of public framework resource IDs.
@@ -376,12 +389,30 @@ class ResourceFileFlattener {
     std::string dst_path;
   };
 
-  std::vector<std::unique_ptr<xml::XmlResource>> LinkAndVersionXmlFile(ResourceTable* table,
+  // What linking and flattening an XML file produces, on any thread.
+  struct XmlFileResult {
+    BufferedDiagnostics diagnostics;
+    BufferedArchiveWriter writer;
+
+    // The auto-versioned copies of the file, which are yet to be added to the table.
+    std::vector<ResourceFile> versioned_files;
+
+    bool linked = false;
+  };
+
+  std::vector<std::unique_ptr<xml::XmlResource>> LinkAndVersionXmlFile(IAaptContext* context,
+                                                                       ResourceTable* table,
                                                                        FileOperation* file_op);
 
+  // Links, versions and flattens an XML file. Only reads the table, so that several files can be
+  // processed at once.
+  bool LinkAndFlattenXmlFile(IAaptContext* context, ResourceTable* table, FileOperation* file_op,
+                             XmlFileResult* result);
+
   ResourceFileFlattenerOptions options_;
   IAaptContext* context_;
   proguard::KeepSet* keep_set_;
+  std::mutex keep_set_lock_;
   XmlCompatVersioner::Rules rules_;
 };
 
@@ -456,13 +487,13 @@ std::vector<T> make_singleton_vec(T&& val) {
 }
 
 std::vector<std::unique_ptr<xml::XmlResource>> ResourceFileFlattener::LinkAndVersionXmlFile(
-    ResourceTable* table, FileOperation* file_op) {
+    IAaptContext* context, ResourceTable* table, FileOperation* file_op) {
   TRACE_CALL();
   xml::XmlResource* doc = file_op->xml_to_flatten.get();
   const android::Source& src = doc->file.source;
 
-  if (context_->IsVerbose()) {
-    context_->GetDiagnostics()->Note(android::DiagMessage()
+  if (context->IsVerbose()) {
+    context->GetDiagnostics()->Note(android::DiagMessage()
                                      << "linking " << src.path << " (" << doc->file.name << ")");
   }
 
@@ -471,17 +502,20 @@ std::vector<std::unique_ptr<xml::XmlResource>> ResourceFileFlattener::LinkAndVer
   xml::StripAndroidStudioAttributes(doc->root.get());
 
   XmlReferenceLinker xml_linker(table);
-  if (!options_.do_not_fail_on_missing_resources && !xml_linker.Consume(context_, doc)) {
+  if (!options_.do_not_fail_on_missing_resources && !xml_linker.Consume(context, doc)) {
     return {};
   }
 
-  if (options_.update_proguard_spec && !proguard::CollectProguardRules(context_, doc, keep_set_)) {
-    return {};
+  if (options_.update_proguard_spec) {
+    std::lock_guard<std::mutex> guard(keep_set_lock_);
+    if (!proguard::CollectProguardRules(context, doc, keep_set_)) {
+      return {};
+    }
   }
 
   if (options_.no_xml_namespaces) {
     XmlNamespaceRemover namespace_remover;
-    if (!namespace_remover.Consume(context_, doc)) {
+    if (!namespace_remover.Consume(context, doc)) {
       return {};
     }
   }
@@ -504,15 +538,23 @@ std::vector<std::unique_ptr<xml::XmlResource>> ResourceFileFlattener::LinkAndVer
   const ConfigDescription& config = file_op->config;
   ResourceEntry* entry = file_op->entry;
 
-  FlaggedXmlVersioner flagged_xml_versioner;
-  auto flag_split_resources = flagged_xml_versioner.Process(context_, doc);
-
-  std::vector<std::unique_ptr<xml::XmlResource>> final_resources;
   XmlCompatVersioner xml_compat_versioner(&rules_);
   const util::Range<ApiVersion> api_range{config.sdkVersion,
                                           FindNextApiVersionForConfig(entry, config)};
+
+  // Most documents have neither read/write flags nor attributes to version, in which case the
+  // versioners would only copy them.
+  if (!doc->file.uses_readwrite_feature_flags &&
+      !xml_compat_versioner.NeedsVersioning(context, *doc, api_range)) {
+    return make_singleton_vec(std::move(file_op->xml_to_flatten));
+  }
+
+  FlaggedXmlVersioner flagged_xml_versioner;
+  auto flag_split_resources = flagged_xml_versioner.Process(context, doc);
+
+  std::vector<std::unique_ptr<xml::XmlResource>> final_resources;
   for (auto& split_res : flag_split_resources) {
-    auto inner_resources = xml_compat_versioner.Process(context_, split_res.get(), api_range);
+    auto inner_resources = xml_compat_versioner.Process(context, split_res.get(), api_range);
     final_resources.insert(final_resources.end(), std::make_move_iterator(inner_resources.begin()),
                            std::make_move_iterator(inner_resources.end()));
   }
@@ -534,6 +576,82 @@ static auto kDrawableVersions = std::map<std::string, ApiVersion>{
     { "adaptive-icon" , SDK_O },
 };
 
+bool ResourceFileFlattener::LinkAndFlattenXmlFile(IAaptContext* context, ResourceTable* table,
+                                                  FileOperation* file_op,
+                                                  XmlFileResult* result) {
+  TRACE_CALL();
+  const ConfigDescription& config = file_op->config;
+
+  // Check minimum sdk versions supported for drawables
+  auto drawable_entry = kDrawableVersions.find(file_op->xml_to_flatten->root->name);
+  if (drawable_entry != kDrawableVersions.end()) {
+    if (drawable_entry->second > context->GetMinSdkVersion()
+        && drawable_entry->second > config.sdkVersion) {
+      context->GetDiagnostics()->Error(
+          android::DiagMessage(file_op->xml_to_flatten->file.source)
+          << "<" << drawable_entry->first << "> elements "
+          << "require a sdk version of at least " << (int16_t)drawable_entry->second);
+      return false;
+    }
+  }
+
+  FeatureFlagsFilterOptions flags_filter_options;
+  // Don't fail on unrecognized flags or flags without values as these flags might be
+  // defined and have a value by the time they are evaluated at runtime.
+  flags_filter_options.fail_on_unrecognized_flags = false;
+  flags_filter_options.flags_must_have_value = false;
+  flags_filter_options.remove_disabled_elements = true;
+  FeatureFlagsFilter flags_filter(options_.feature_flag_values, flags_filter_options);
+  if (!flags_filter.Consume(context, file_op->xml_to_flatten.get())) {
+    return false;
+  }
+
+  std::vector<std::unique_ptr<xml::XmlResource>> versioned_docs =
+      LinkAndVersionXmlFile(context, table, file_op);
+  if (versioned_docs.empty()) {
+    return false;
+  }
+
+  bool error = false;
+  for (std::unique_ptr<xml::XmlResource>& doc : versioned_docs) {
+    std::string dst_path = file_op->dst_path;
+    if (doc->file.config != file_op->config) {
+      // Only add the new versioned configurations.
+      if (context->IsVerbose()) {
+        context->GetDiagnostics()->Note(android::DiagMessage(doc->file.source)
+                                        << "auto-versioning resource from config '" << config
+                                        << "' -> '" << doc->file.config << "'");
+      }
+
+      dst_path = ResourceUtils::BuildResourceFileName(doc->file, context->GetNameMangler());
+      result->versioned_files.push_back(doc->file);
+    }
+
+    error |= !FlattenXml(context, *doc, dst_path, options_.keep_raw_values, false /*utf16*/,
+                         options_.output_format, &result->writer);
+  }
+  return !error;
+}
+
+// Calls work(i) for every i in [0, count), on up to `jobs` threads including the calling one.
+static void ParallelFor(size_t count, int jobs, const std::function<void(size_t)>& work) {
+  std::atomic<size_t> next = 0;
+  auto run = [&]() {
+    for (size_t i = next++; i < count; i = next++) {
+      work(i);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min<size_t>(jobs, count); i++) {
+    threads.emplace_back(run);
+  }
+  run();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
 bool ResourceFileFlattener::Flatten(ResourceTable* table, IArchiveWriter* archive_writer) {
   TRACE_CALL();
   bool error = false;
@@ -629,79 +747,65 @@ bool ResourceFileFlattener::Flatten(ResourceTable* table, IArchiveWriter* archiv
         }
       }
 
-      // Now flatten the sorted values.
+      // Link and flatten the XML files first. This only reads the table, so it can be done on
+      // several threads; the files are then written and the table updated in order.
+      std::vector<FileOperation*> xml_file_ops;
       for (auto& map_entry : config_sorted_files) {
-        const ConfigDescription& config = map_entry.first.first;
-        FileOperation& file_op = map_entry.second;
-
-        if (file_op.xml_to_flatten) {
-          // Check minimum sdk versions supported for drawables
-          auto drawable_entry = kDrawableVersions.find(file_op.xml_to_flatten->root->name);
-          if (drawable_entry != kDrawableVersions.end()) {
-            if (drawable_entry->second > context_->GetMinSdkVersion()
-                && drawable_entry->second > config.sdkVersion) {
-              context_->GetDiagnostics()->Error(
-                  android::DiagMessage(file_op.xml_to_flatten->file.source)
-                  << "<" << drawable_entry->first << "> elements "
-                  << "require a sdk version of at least " << (int16_t)drawable_entry->second);
-              error = true;
-              continue;
-            }
-          }
+        if (map_entry.second.xml_to_flatten) {
+          xml_file_ops.push_back(&map_entry.second);
+        }
+      }
 
-          FeatureFlagsFilterOptions flags_filter_options;
-          // Don't fail on unrecognized flags or flags without values as these flags might be
-          // defined and have a value by the time they are evaluated at runtime.
-          flags_filter_options.fail_on_unrecognized_flags = false;
-          flags_filter_options.flags_must_have_value = false;
-          flags_filter_options.remove_disabled_elements = true;
-          FeatureFlagsFilter flags_filter(options_.feature_flag_values, flags_filter_options);
-          if (!flags_filter.Consume(context_, file_op.xml_to_flatten.get())) {
-            return 1;
-          }
+      std::vector<XmlFileResult> xml_results(xml_file_ops.size());
+      const bool verbose = context_->GetDiagnostics()->IsVerbose();
+      ParallelFor(xml_file_ops.size(), options_.jobs, [&](size_t i) {
+        XmlFileResult& result = xml_results[i];
+        result.diagnostics.SetVerbose(verbose);
+        JobContext job_context(context_, &result.diagnostics);
+        result.linked = LinkAndFlattenXmlFile(&job_context, table, xml_file_ops[i], &result);
+      });
+      // The worker threads are gone, their last symbols needn't outlive them.
+      context_->GetExternalSymbols()->ReleasePinnedSymbols();
 
-          std::vector<std::unique_ptr<xml::XmlResource>> versioned_docs =
-              LinkAndVersionXmlFile(table, &file_op);
-          if (versioned_docs.empty()) {
-            error = true;
-            continue;
-          }
+      // Now flatten the sorted values.
+      size_t next_xml_result = 0;
+      for (auto& map_entry : config_sorted_files) {
+        FileOperation& file_op = map_entry.second;
 
-          for (std::unique_ptr<xml::XmlResource>& doc : versioned_docs) {
-            std::string dst_path = file_op.dst_path;
-            if (doc->file.config != file_op.config) {
-              // Only add the new versioned configurations.
-              if (context_->IsVerbose()) {
-                context_->GetDiagnostics()->Note(android::DiagMessage(doc->file.source)
-                                                 << "auto-versioning resource from config '"
-                                                 << config << "' -> '" << doc->file.config << "'");
-              }
+        if (next_xml_result < xml_file_ops.size() && xml_file_ops[next_xml_result] == &file_op) {
+          XmlFileResult& result = xml_results[next_xml_result++];
+          result.diagnostics.FlushTo(context_->GetDiagnostics());
 
-              const ResourceFile& file = doc->file;
-              dst_path = ResourceUtils::BuildResourceFileName(file, context_->GetNameMangler());
+          for (const ResourceFile& file : result.versioned_files) {
+            const std::string dst_path =
+                ResourceUtils::BuildResourceFileName(file, context_->GetNameMangler());
 
-              auto file_ref =
-                  util::make_unique<FileReference>(table->string_pool.MakeRef(dst_path));
-              file_ref->SetSource(doc->file.source);
+            auto file_ref =
+                util::make_unique<FileReference>(table->string_pool.MakeRef(dst_path));
+            file_ref->SetSource(file.source);
 
-              // Update the output format of this XML file.
-              file_ref->type = XmlFileTypeForOutputFormat(options_.output_format);
+            // Update the output format of this XML file.
+            file_ref->type = XmlFileTypeForOutputFormat(options_.output_format);
 
-              bool result = table->AddResource(
-                  NewResourceBuilder(file.name)
-                      .SetValue(std::move(file_ref), file.config)
-                      .SetAllowMangled(true)
-                      .SetUsesReadWriteFeatureFlags(doc->file.uses_readwrite_feature_flags)
-                      .Build(),
-                  context_->GetDiagnostics());
-              if (!result) {
-                return false;
-              }
+            bool added = table->AddResource(
+                NewResourceBuilder(file.name)
+                    .SetValue(std::move(file_ref), file.config)
+                    .SetAllowMangled(true)
+                    .SetUsesReadWriteFeatureFlags(file.uses_readwrite_feature_flags)
+                    .Build(),
+                context_->GetDiagnostics());
+            if (!added) {
+              return false;
             }
+          }
 
-            error |= !FlattenXml(context_, *doc, dst_path, options_.keep_raw_values,
-                                 false /*utf16*/, options_.output_format, archive_writer);
+          if (!result.writer.WriteTo(archive_writer)) {
+            context_->GetDiagnostics()->Error(android::DiagMessage(file_op.dst_path)
+                                              << "failed to write: "
+                                              << archive_writer->GetError());
+            error = true;
           }
+          error |= !result.linked;
         } else {
           error |= !io::CopyFileToArchive(context_, file_op.file_to_copy, file_op.dst_path,
                                           GetCompressionFlags(file_op.dst_path, options_),
@@ -1210,7 +1314,7 @@ class Linker {
     if (options_.output_to_directory) {
       return CreateDirectoryArchiveWriter(context_->GetDiagnostics(), out);
     } else {
-      return CreateZipFileArchiveWriter(context_->GetDiagnostics(), out);
+      return CreateZipFileArchiveWriter(context_->GetDiagnostics(), out, options_.jobs);
     }
   }
 
@@ -1242,6 +1346,56 @@ class Linker {
     return false;
   }
 
+  // Opens the R.java file of a package in the --java directory.
+  std::unique_ptr<android::FileOutputStream> OpenJavaFile(StringPiece out_package,
+                                                          std::string* out_path) {
+    *out_path = options_.generate_java_class_path.value();
+    file::AppendPath(out_path, file::PackageToPath(out_package));
+    if (!file::mkdirs(*out_path)) {
+      context_->GetDiagnostics()->Error(android::DiagMessage()
+                                        << "failed to create directory '" << *out_path << "'");
+      return {};
+    }
+
+    file::AppendPath(out_path, "R.java");
+
+    auto fout = util::make_unique<android::FileOutputStream>(*out_path);
+    if (fout->HadError()) {
+      context_->GetDiagnostics()->Error(android::DiagMessage()
+                                        << "failed writing to '" << *out_path
+                                        << "': " << fout->GetError());
+      return {};
+    }
+    return fout;
+  }
+
+  // Writes the same R class to the R.java files of several packages, building it only once.
+  bool WriteJavaFiles(ResourceTable* table, StringPiece package_name_to_generate,
+                      const std::vector<std::string>& out_packages,
+                      const JavaClassGeneratorOptions& java_options) {
+    if (!options_.generate_java_class_path || out_packages.empty()) {
+      return true;
+    }
+
+    bool open_failed = false;
+    auto open_file = [&](StringPiece out_package) -> std::unique_ptr<android::OutputStream> {
+      std::string out_path;
+      std::unique_ptr<android::FileOutputStream> fout = OpenJavaFile(out_package, &out_path);
+      open_failed = !fout;
+      return fout;
+    };
+
+    JavaClassGenerator generator(context_, table, java_options);
+    if (!generator.Generate(package_name_to_generate, out_packages, open_file)) {
+      // OpenJavaFile() already logged why the file couldn't be opened.
+      if (!open_failed) {
+        context_->GetDiagnostics()->Error(android::DiagMessage() << generator.GetError());
+      }
+      return false;
+    }
+    return true;
+  }
+
   bool WriteJavaFile(ResourceTable* table, StringPiece package_name_to_generate,
                      StringPiece out_package, const JavaClassGeneratorOptions& java_options,
                      const std::optional<std::string>& out_text_symbols_path = {}) {
@@ -1252,21 +1406,8 @@ class Linker {
     std::string out_path;
     std::unique_ptr<android::FileOutputStream> fout;
     if (options_.generate_java_class_path) {
-      out_path = options_.generate_java_class_path.value();
-      file::AppendPath(&out_path, file::PackageToPath(out_package));
-      if (!file::mkdirs(out_path)) {
-        context_->GetDiagnostics()->Error(android::DiagMessage()
-                                          << "failed to create directory '" << out_path << "'");
-        return false;
-      }
-
-      file::AppendPath(&out_path, "R.java");
-
-      fout = util::make_unique<android::FileOutputStream>(out_path);
-      if (fout->HadError()) {
-        context_->GetDiagnostics()->Error(android::DiagMessage()
-                                          << "failed writing to '" << out_path
-                                          << "': " << fout->GetError());
+      fout = OpenJavaFile(out_package, &out_path);
+      if (!fout) {
         return false;
       }
     }
@@ -1331,13 +1472,17 @@ class Linker {
     }
 
     // Generate copies of the original package R class but with different package names.
-    // This is to support non-namespaced builds.
-    for (const std::string& extra_package : options_.extra_java_packages) {
-      packages_to_callback.push_back(extra_package);
+    // This is to support non-namespaced builds. The copies only differ by their package, so the
+    // class is built once for all of them.
+    {
+      std::vector<std::string> extra_packages(options_.extra_java_packages.begin(),
+                                              options_.extra_java_packages.end());
+      packages_to_callback.insert(packages_to_callback.end(), extra_packages.begin(),
+                                  extra_packages.end());
 
       JavaClassGeneratorOptions options = template_options;
       options.types = JavaClassGeneratorOptions::SymbolTypes::kAll;
-      if (!WriteJavaFile(&final_table_, actual_package, extra_package, options)) {
+      if (!WriteJavaFiles(&final_table_, actual_package, extra_packages, options)) {
         return false;
       }
     }
@@ -1633,7 +1778,9 @@ class Linker {
       }
     }
 
-    std::unique_ptr<android::InputStream> input_stream = file->OpenInputStream();
+    // Compiled files are mapped rather than read, so that the container is parsed straight from
+    // the page cache.
+    std::unique_ptr<io::IData> input_stream = file->OpenAsData();
     if (input_stream == nullptr) {
       context_->GetDiagnostics()->Error(android::DiagMessage(src) << "failed to open file");
       return false;
@@ -1657,8 +1804,11 @@ class Linker {
     while ((entry = reader.Next()) != nullptr) {
       if (entry->Type() == ContainerEntryType::kResTable) {
         TRACE_NAME(std::string("Process ResTable:") + file->GetSource().path);
-        pb::ResourceTable pb_table;
-        if (!entry->GetResTable(&pb_table)) {
+        // The messages of the table are allocated from an arena, and freed at once as soon as the
+        // table is deserialized.
+        google::protobuf::Arena arena;
+        pb::ResourceTable* pb_table = google::protobuf::Arena::Create<pb::ResourceTable>(&arena);
+        if (!entry->GetResTable(pb_table)) {
           context_->GetDiagnostics()->Error(
               android::DiagMessage(src) << "failed to read resource table: " << entry->GetError());
           return false;
@@ -1666,7 +1816,7 @@ class Linker {
 
         ResourceTable table;
         std::string error;
-        if (!DeserializeTableFromPb(pb_table, nullptr /*files*/, &table, &error)) {
+        if (!DeserializeTableFromPb(*pb_table, nullptr /*files*/, &table, &error)) {
           context_->GetDiagnostics()->Error(android::DiagMessage(src)
                                             << "failed to deserialize resource table: " << error);
           return false;
@@ -1957,6 +2107,7 @@ class Linker {
     file_flattener_options.output_format = options_.output_format;
     file_flattener_options.do_not_fail_on_missing_resources = options_.merge_only;
     file_flattener_options.feature_flag_values = options_.feature_flag_values;
+    file_flattener_options.jobs = options_.jobs;
 
     ResourceFileFlattener file_flattener(file_flattener_options, context_, keep_set);
     if (!file_flattener.Flatten(table, writer)) {
@@ -2147,6 +2298,10 @@ class Linker {
         return 1;
       }
 
+      if (!options_.previous_ids.empty()) {
+        KeepPreviousIds();
+      }
+
       // Assign IDs if we are building a regular app.
       IdAssigner id_assigner(&options_.stable_id_map);
       if (!id_assigner.Consume(context_, &final_table_)) {
@@ -2155,18 +2310,22 @@ class Linker {
       }
 
       // Now grab each ID and emit it as a file.
-      if (options_.resource_id_map_path) {
+      if (options_.resource_id_map_path || options_.incremental_state_path) {
         for (auto& package : final_table_.packages) {
           for (auto& type : package->types) {
             for (auto& entry : type->entries) {
               ResourceName name(package->name, type->named_type, entry->name);
               // The IDs are guaranteed to exist.
+              if (options_.incremental_state_path) {
+                assigned_ids_[name] = entry->id.value();
+              }
               options_.stable_id_map[std::move(name)] = entry->id.value();
             }
           }
         }
 
-        if (!WriteStableIdMapToPath(context_->GetDiagnostics(), options_.stable_id_map,
+        if (options_.resource_id_map_path &&
+            !WriteStableIdMapToPath(context_->GetDiagnostics(), options_.stable_id_map,
                                     options_.resource_id_map_path.value())) {
           return 1;
         }
@@ -2434,7 +2593,67 @@ class Linker {
     return 0;
   }
 
+  // The IDs of the linked resources, if the link keeps an incremental state.
+  const std::map<ResourceName, ResourceId>& GetAssignedIds() const {
+    return assigned_ids_;
+  }
+
  private:
+  // Adds the IDs of the previous link to the stable IDs, for the resources that have none. An ID
+  // is only kept if no other resource has it, and if no other type has its type ID.
+  void KeepPreviousIds() {
+    std::set<ResourceId> used_ids;
+    std::map<uint8_t, ResourceType> type_of_type_id;
+    std::map<ResourceType, uint8_t> type_id_of_type;
+    const auto use_id = [&](const ResourceName& name, ResourceId id) {
+      used_ids.insert(id);
+      type_of_type_id.emplace(id.type_id(), name.type.type);
+      type_id_of_type.emplace(name.type.type, id.type_id());
+    };
+
+    for (const auto& [name, id] : options_.stable_id_map) {
+      use_id(name, id);
+    }
+    for (auto& package : final_table_.packages) {
+      for (auto& type : package->types) {
+        for (auto& entry : type->entries) {
+          const ResourceName name(package->name, type->named_type, entry->name);
+          if (entry->id) {
+            use_id(name, entry->id.value());
+          }
+          if (entry->staged_id) {
+            use_id(name, entry->staged_id.value().id);
+          }
+        }
+      }
+    }
+
+    for (auto& package : final_table_.packages) {
+      for (auto& type : package->types) {
+        for (auto& entry : type->entries) {
+          ResourceName name(package->name, type->named_type, entry->name);
+          if (entry->id || entry->staged_id || options_.stable_id_map.count(name)) {
+            continue;
+          }
+          const auto previous = options_.previous_ids.find(name);
+          if (previous == options_.previous_ids.end()) {
+            continue;
+          }
+          const ResourceId id = previous->second;
+          const auto type_of_id = type_of_type_id.find(id.type_id());
+          const auto id_of_type = type_id_of_type.find(name.type.type);
+          if (id.package_id() != context_->GetPackageId() || used_ids.count(id) ||
+              (type_of_id != type_of_type_id.end() && type_of_id->second != name.type.type) ||
+              (id_of_type != type_id_of_type.end() && id_of_type->second != id.type_id())) {
+            continue;
+          }
+          use_id(name, id);
+          options_.stable_id_map[std::move(name)] = id;
+        }
+      }
+    }
+  }
+
   LinkOptions options_;
   LinkContext* context_;
   ResourceTable final_table_;
@@ -2461,10 +2680,13 @@ class Linker {
 
   // The package name of the base application, if it is included.
   std::optional<std::string> included_feature_base_;
+
+  std::map<ResourceName, ResourceId> assigned_ids_;
 };
 
 int LinkCommand::Action(const std::vector<std::string>& args) {
   TRACE_FLUSH(trace_folder_ ? trace_folder_.value() : "", "LinkCommand::Action");
+  TRACE_PERF_REPORT(perf_report_path_.value_or(""));
   LinkContext context(diag_);
 
   // Expand all argument-files passed into the command line. These start with '@'.
@@ -2526,6 +2748,9 @@ int LinkCommand::Action(const std::vector<std::string>& args) {
   if (options_.use_sparse_encoding) {
     options_.table_flattener_options.sparse_entries = SparseEntriesMode::Enabled;
   }
+  if (options_.use_auto_sparse_encoding) {
+    options_.table_flattener_options.sparse_entries = SparseEntriesMode::Auto;
+  }
 
   // The default build type.
   context.SetPackageType(PackageType::kApp);
@@ -2541,6 +2766,10 @@ int LinkCommand::Action(const std::vector<std::string>& args) {
     options_.output_format = OutputFormat::kProto;
   }
 
+  if (jobs_ && !ParseJobsParameter(jobs_.value(), context.GetDiagnostics(), &options_.jobs)) {
+    return 1;
+  }
+
   if (package_id_) {
     if (context.GetPackageType() != PackageType::kApp) {
       context.GetDiagnostics()->Error(
@@ -2678,8 +2907,102 @@ int LinkCommand::Action(const std::vector<std::string>& args) {
     options_.no_version_transitions = true;
   }
 
+  if (!options_.incremental_state_path) {
+    Linker cmd(&context, options_);
+    return cmd.Run(arg_list);
+  }
+
+  util::Sha256 sha;
+  sha.Add(util::GetToolFingerprint());
+  sha.Add(android::build::GetBuildNumber());
+  // The paths on the command line may be relative.
+  if (char cwd[PATH_MAX]; getcwd(cwd, sizeof(cwd)) != nullptr) {
+    sha.Add(StringPiece(cwd));
+  }
+  for (const std::string& arg : GetCommandLine()) {
+    sha.Add(arg);
+  }
+  const std::string fingerprint = sha.Finish();
+
+  // An input that can't be read fails the link below, which doesn't use the previous state then.
+  LinkState::Digests inputs;
+  const bool has_inputs = LinkState::ComputeDigests(GetInputPaths(args, arg_list), &inputs);
+  std::optional<LinkState> previous_state =
+      LinkState::Load(options_.incremental_state_path.value());
+  if (has_inputs && previous_state) {
+    if (previous_state->IsUpToDate(fingerprint, inputs)) {
+      if (context.IsVerbose()) {
+        context.GetDiagnostics()->Note(android::DiagMessage()
+                                       << "outputs are up to date, nothing to link");
+      }
+      return 0;
+    }
+
+    // Keeping the previous IDs makes them depend on the history of the builds, so only do it when
+    // they are written to --emit-ids, from where a clean link can take them with --stable-ids.
+    if (options_.resource_id_map_path) {
+      options_.previous_ids = std::move(previous_state->ids);
+    }
+  }
+
   Linker cmd(&context, options_);
-  return cmd.Run(arg_list);
+  if (int result = cmd.Run(arg_list); result != 0) {
+    return result;
+  }
+
+  LinkState state;
+  state.fingerprint = fingerprint;
+  state.inputs = std::move(inputs);
+  state.ids = cmd.GetAssignedIds();
+  if (!has_inputs || !LinkState::ComputeDigests(GetOutputPaths(), &state.outputs)) {
+    context.GetDiagnostics()->Warn(android::DiagMessage(options_.incremental_state_path.value())
+                                   << "failed reading the inputs or the outputs of the link, "
+                                   << "not keeping the incremental state");
+    return 0;
+  }
+  state.Save(options_.incremental_state_path.value(), context.GetDiagnostics());
+  return 0;
+}
+
+std::vector<std::string> LinkCommand::GetInputPaths(
+    const std::vector<std::string>& args, const std::vector<std::string>& input_files) const {
+  std::vector<std::string> paths = {options_.manifest_path};
+  paths.insert(paths.end(), options_.include_paths.begin(), options_.include_paths.end());
+  paths.insert(paths.end(), options_.assets_dirs.begin(), options_.assets_dirs.end());
+  paths.insert(paths.end(), input_files.begin(), input_files.end());
+  paths.insert(paths.end(), options_.overlay_files.begin(), options_.overlay_files.end());
+  if (stable_id_file_path_) {
+    paths.push_back(stable_id_file_path_.value());
+  }
+
+  // The argument-files.
+  std::vector<std::string> args_with_files = args;
+  args_with_files.insert(args_with_files.end(), overlay_arg_list_.begin(), overlay_arg_list_.end());
+  args_with_files.insert(args_with_files.end(), feature_flags_args_.begin(),
+                         feature_flags_args_.end());
+  if (no_compress_regex) {
+    args_with_files.push_back(no_compress_regex.value());
+  }
+  for (const std::string& arg : args_with_files) {
+    if (util::StartsWith(arg, "@")) {
+      paths.push_back(arg.substr(1));
+    }
+  }
+  return paths;
+}
+
+std::vector<std::string> LinkCommand::GetOutputPaths() const {
+  std::vector<std::string> paths = {options_.output_path};
+  paths.insert(paths.end(), options_.split_paths.begin(), options_.split_paths.end());
+  for (const std::optional<std::string>& path :
+       {options_.generate_java_class_path, options_.generate_proguard_rules_path,
+        options_.generate_main_dex_proguard_rules_path, options_.resource_id_map_path,
+        options_.generate_text_symbols_path}) {
+    if (path) {
+      paths.push_back(path.value());
+    }
+  }
+  return paths;
 }
 
 }  // namespace aapt
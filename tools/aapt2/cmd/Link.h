@@ -17,6 +17,7 @@
 #ifndef AAPT2_LINK_H
 #define AAPT2_LINK_H
 
+#include <map>
 #include <optional>
 #include <regex>
 #include <string>
@@ -76,6 +77,7 @@ struct LinkOptions {
   bool no_xml_namespaces = false;
   bool do_not_compress_anything = false;
   bool use_sparse_encoding = false;
+  bool use_auto_sparse_encoding = false;
   std::unordered_set<std::string> extensions_to_not_compress;
   std::optional<std::regex> regex_to_not_compress;
   bool no_compress_fonts = false;
@@ -108,6 +110,13 @@ struct LinkOptions {
   std::unordered_map<ResourceName, ResourceId> stable_id_map;
   std::optional<std::string> resource_id_map_path;
 
+  // The file in which the inputs, the outputs, and the IDs of a link are kept for the next one.
+  std::optional<std::string> incremental_state_path;
+  // The IDs that the previous link assigned, if it kept an incremental state and this link emits
+  // its IDs. They are kept where they don't conflict with the stable IDs or the IDs that the
+  // resources declare.
+  std::map<ResourceName, ResourceId> previous_ids;
+
   // When 'true', allow reserved package IDs to be used for applications. Pre-O, the platform
   // treats negative resource IDs [those with a package ID of 0x80 or higher] as invalid.
   // In order to work around this limitation, we allow the use of traditionally reserved
@@ -116,6 +125,10 @@ struct LinkOptions {
 
   // Whether we should fail on definitions of a resource with conflicting visibility.
   bool strict_visibility = false;
+
+  // The number of XML files linked and flattened at once. The output and the diagnostics are the
+  // same in any case.
+  int jobs = 1;
 };
 
 class LinkCommand : public Command {
@@ -170,6 +183,11 @@ class LinkCommand : public Command {
         "This decreases APK size at the cost of resource retrieval performance.\n"
         "Only applies sparse encoding if minSdk of the APK is >= 32",
         &options_.use_sparse_encoding);
+    AddOptionalSwitch(
+        "--auto-sparse-encoding",
+        "Like --enable-sparse-encoding, but only sparse encodes the types that it makes smaller\n"
+        "and that have few enough entries for their lookups to stay fast.",
+        &options_.use_auto_sparse_encoding);
     AddOptionalSwitch("--enable-compact-entries",
         "This decreases APK size by using compact resource entries for simple data types.",
         &options_.table_flattener_options.use_compact_entries);
@@ -337,11 +355,27 @@ class LinkCommand : public Command {
     AddOptionalFlag("--trace-folder",
         "Generate systrace json trace fragment to specified folder.",
         &trace_folder_);
+    AddOptionalFlag("--perf-report",
+        "Write a summary of the wall time, CPU time and peak memory growth of each\n"
+            "traced step, and of the items and bytes they processed, to the given file.",
+        &perf_report_path_);
     AddOptionalSwitch("--merge-only",
         "Only merge the resources, without verifying resource references. This flag\n"
             "should only be used together with the --static-lib flag.",
         &options_.merge_only);
     AddOptionalSwitch("-v", "Enables verbose logging.", &verbose_);
+    AddOptionalFlag("-j",
+                    "Number of XML files to link and flatten in parallel, 1 by default. The\n"
+                    "output and the diagnostics are in the same order as with a single job.",
+                    &jobs_);
+    AddOptionalFlag("--incremental-state",
+                    "File in which to keep what the link read and wrote. A link with the same\n"
+                    "command line and inputs as the previous one leaves its outputs as they are.\n"
+                    "With --emit-ids, the resources that the previous link assigned IDs to keep\n"
+                    "them, and the file written by --emit-ids makes a clean link with\n"
+                    "--stable-ids assign the same IDs. Without --emit-ids, IDs are assigned as\n"
+                    "in a clean link.",
+                    &options_.incremental_state_path, Command::kPath);
     AddOptionalFlagList("--feature-flags",
                         "Specify the values of feature flags. The pairs in the argument\n"
                         "are separated by ',' the name is separated from the value by '='.\n"
@@ -358,6 +392,11 @@ class LinkCommand : public Command {
   int Action(const std::vector<std::string>& args) override;
 
  private:
+  // Returns the files that the link reads, and the files and directories that it writes.
+  std::vector<std::string> GetInputPaths(const std::vector<std::string>& args,
+                                         const std::vector<std::string>& input_files) const;
+  std::vector<std::string> GetOutputPaths() const;
+
   android::IDiagnostics* diag_;
   LinkOptions options_;
 
@@ -377,6 +416,8 @@ class LinkCommand : public Command {
   std::optional<std::string> stable_id_file_path_;
   std::vector<std::string> split_args_;
   std::optional<std::string> trace_folder_;
+  std::optional<std::string> perf_report_path_;
+  std::optional<std::string> jobs_;
   std::vector<std::string> feature_flags_args_;
 };
 
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cmd/LinkState.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "ResourceUtils.h"
+#include "android-base/file.h"
+#include "util/Files.h"
+#include "util/Sha256.h"
+#include "util/Util.h"
+
+using ::android::StringPiece;
+
+namespace aapt {
+
+namespace {
+
+constexpr char kHeader[] = "aapt2-link-state 1";
+
+bool AddFileContents(const std::string& path, util::Sha256* sha) {
+  std::string contents;
+  if (!android::base::ReadFileToString(path, &contents, true /*follow_symlinks*/)) {
+    return false;
+  }
+  sha->Add(contents);
+  return true;
+}
+
+std::optional<std::string> ComputeDigest(const std::string& path) {
+  util::Sha256 sha;
+  switch (file::GetFileType(path)) {
+    case file::FileType::kRegular:
+    case file::FileType::kSymlink:
+      if (!AddFileContents(path, &sha)) {
+        return {};
+      }
+      break;
+
+    case file::FileType::kDirectory: {
+      android::NoOpDiagnostics diag;
+      std::optional<std::vector<std::string>> files = file::FindFiles(path, &diag);
+      if (!files) {
+        return {};
+      }
+      std::sort(files->begin(), files->end());
+      for (const std::string& file : files.value()) {
+        sha.Add(file);
+        if (!AddFileContents(file::BuildPath({path, file}), &sha)) {
+          return {};
+        }
+      }
+      break;
+    }
+
+    default:
+      return {};
+  }
+  return sha.Finish();
+}
+
+// Splits "<first> <rest>" in two.
+bool SplitField(StringPiece line, StringPiece* out_first, StringPiece* out_rest) {
+  const size_t space = line.find(' ');
+  if (space == StringPiece::npos) {
+    return false;
+  }
+  *out_first = line.substr(0, space);
+  *out_rest = line.substr(space + 1);
+  return !out_first->empty() && !out_rest->empty();
+}
+
+}  // namespace
+
+std::optional<LinkState> LinkState::Load(const std::string& path) {
+  std::string contents;
+  if (!android::base::ReadFileToString(path, &contents)) {
+    return {};
+  }
+
+  LinkState state;
+  bool has_header = false;
+  for (StringPiece line : util::Tokenize(contents, '\n')) {
+    if (line.empty()) {
+      continue;
+    }
+    if (!has_header) {
+      if (line != kHeader) {
+        return {};
+      }
+      has_header = true;
+      continue;
+    }
+
+    StringPiece kind;
+    StringPiece rest;
+    if (!SplitField(line, &kind, &rest)) {
+      return {};
+    }
+
+    if (kind == "fingerprint") {
+      state.fingerprint = std::string(rest);
+    } else if (kind == "input" || kind == "output") {
+      StringPiece digest;
+      StringPiece file_path;
+      if (!SplitField(rest, &digest, &file_path)) {
+        return {};
+      }
+      Digests& digests = kind == "input" ? state.inputs : state.outputs;
+      digests[std::string(file_path)] = std::string(digest);
+    } else if (kind == "id") {
+      StringPiece id_str;
+      StringPiece name_str;
+      ResourceNameRef name;
+      if (!SplitField(rest, &id_str, &name_str) ||
+          !ResourceUtils::ParseResourceName(name_str, &name)) {
+        return {};
+      }
+      std::optional<ResourceId> id = ResourceUtils::ParseResourceId(id_str);
+      if (!id) {
+        return {};
+      }
+      state.ids[name.ToResourceName()] = id.value();
+    } else {
+      return {};
+    }
+  }
+
+  if (!has_header || state.fingerprint.empty()) {
+    return {};
+  }
+  return state;
+}
+
+bool LinkState::Save(const std::string& path, android::IDiagnostics* diag) const {
+  std::ostringstream out;
+  out << kHeader << "\n";
+  out << "fingerprint " << fingerprint << "\n";
+  for (const auto& [file_path, digest] : inputs) {
+    out << "input " << digest << " " << file_path << "\n";
+  }
+  for (const auto& [file_path, digest] : outputs) {
+    out << "output " << digest << " " << file_path << "\n";
+  }
+  for (const auto& [name, id] : ids) {
+    out << "id " << id.to_string() << " " << name.to_string() << "\n";
+  }
+
+  if (!android::base::WriteStringToFile(out.str(), path)) {
+    diag->Error(android::DiagMessage(path) << "failed writing incremental state");
+    return false;
+  }
+  return true;
+}
+
+bool LinkState::ComputeDigests(const std::vector<std::string>& paths, Digests* out_digests) {
+  for (const std::string& path : paths) {
+    if (out_digests->count(path)) {
+      continue;
+    }
+    std::optional<std::string> digest = ComputeDigest(path);
+    if (!digest) {
+      return false;
+    }
+    (*out_digests)[path] = std::move(digest.value());
+  }
+  return true;
+}
+
+bool LinkState::IsUpToDate(const std::string& current_fingerprint,
+                           const Digests& current_inputs) const {
+  if (fingerprint != current_fingerprint || inputs != current_inputs || outputs.empty()) {
+    return false;
+  }
+  for (const auto& [file_path, digest] : outputs) {
+    std::optional<std::string> current_digest = ComputeDigest(file_path);
+    if (!current_digest || current_digest.value() != digest) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace aapt
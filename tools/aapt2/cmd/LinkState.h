@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAPT2_LINKSTATE_H
+#define AAPT2_LINKSTATE_H
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Resource.h"
+#include "androidfw/IDiagnostics.h"
+
+namespace aapt {
+
+// What a previous 'aapt2 link' read and wrote, kept in the file given to --incremental-state.
+// A link whose inputs are the same as the previous one's, and whose outputs are still as it left
+// them, has nothing to do. Otherwise the IDs that the previous link assigned are kept for the
+// resources that still exist, so that the outputs that depend on them change as little as
+// possible.
+class LinkState {
+ public:
+  // The SHA-256 digests of files by path, as hex. The digest of a directory covers the names and
+  // the contents of all the files under it.
+  using Digests = std::map<std::string, std::string>;
+
+  // Reads the state written by Save(). Returns nullopt if there is none or it can't be parsed.
+  static std::optional<LinkState> Load(const std::string& path);
+
+  bool Save(const std::string& path, android::IDiagnostics* diag) const;
+
+  // Computes the digests of the files or directories. Returns false if one can't be read.
+  static bool ComputeDigests(const std::vector<std::string>& paths, Digests* out_digests);
+
+  // Returns true if a link with the fingerprint and the inputs would write the outputs of this
+  // state, and they are all still there, unchanged.
+  bool IsUpToDate(const std::string& fingerprint, const Digests& inputs) const;
+
+  // The digest of the command line and the version of aapt2.
+  std::string fingerprint;
+
+  Digests inputs;
+  Digests outputs;
+
+  // The IDs assigned to the resources.
+  std::map<ResourceName, ResourceId> ids;
+};
+
+}  // namespace aapt
+
+#endif  // AAPT2_LINKSTATE_H
@@ -20,6 +20,7 @@
 #include "LoadedApk.h"
 #include "android-base/file.h"
 #include "android-base/stringprintf.h"
+#include "cmd/LinkState.h"
 #include "test/Test.h"
 
 using testing::Eq;
@@ -90,6 +91,143 @@ TEST_F(LinkTest, KeepRawXmlStrings) {
               Eq("007"));
 }
 
+TEST_F(LinkTest, LinkXmlFilesInParallel) {
+  StdErrDiagnostics diag;
+  const std::string compiled_files_dir = GetTestPath("compiled");
+  ASSERT_TRUE(CompileFile(GetTestPath("res/values/values.xml"),
+                          R"(<resources>
+                               <attr name="label" format="string"/>
+                               <string name="label">Label</string>
+                             </resources>)",
+                          compiled_files_dir, &diag));
+  for (int i = 0; i < 8; i++) {
+    ASSERT_TRUE(CompileFile(
+        GetTestPath(android::base::StringPrintf("res/layout/layout%d.xml", i)),
+        R"(<View xmlns:app="http://schemas.android.com/apk/res-auto"
+                 app:label="@string/label"/>)",
+        compiled_files_dir, &diag));
+  }
+
+  const std::string serial_apk = GetTestPath("serial.apk");
+  ASSERT_TRUE(Link({"--manifest", GetDefaultManifest(), "-o", serial_apk}, compiled_files_dir,
+                   &diag));
+  const std::string parallel_apk = GetTestPath("parallel.apk");
+  ASSERT_TRUE(Link({"--manifest", GetDefaultManifest(), "-o", parallel_apk, "-j", "4"},
+                   compiled_files_dir, &diag));
+
+  // The entries are written in the same order and with the same contents.
+  std::unique_ptr<LoadedApk> serial = LoadedApk::LoadApkFromPath(serial_apk, &diag);
+  ASSERT_THAT(serial, Ne(nullptr));
+  std::unique_ptr<LoadedApk> parallel = LoadedApk::LoadApkFromPath(parallel_apk, &diag);
+  ASSERT_THAT(parallel, Ne(nullptr));
+
+  auto serial_files = serial->GetFileCollection()->Iterator();
+  auto parallel_files = parallel->GetFileCollection()->Iterator();
+  while (serial_files->HasNext()) {
+    ASSERT_TRUE(parallel_files->HasNext());
+    io::IFile* serial_file = serial_files->Next();
+    io::IFile* parallel_file = parallel_files->Next();
+    ASSERT_EQ(serial_file->GetSource().path, parallel_file->GetSource().path);
+
+    std::unique_ptr<io::IData> serial_data = serial_file->OpenAsData();
+    std::unique_ptr<io::IData> parallel_data = parallel_file->OpenAsData();
+    ASSERT_THAT(serial_data, Ne(nullptr));
+    ASSERT_THAT(parallel_data, Ne(nullptr));
+    ASSERT_EQ(serial_data->size(), parallel_data->size());
+    EXPECT_EQ(memcmp(serial_data->data(), parallel_data->data(), serial_data->size()), 0)
+        << serial_file->GetSource().path;
+  }
+  EXPECT_FALSE(parallel_files->HasNext());
+}
+
+TEST_F(LinkTest, IncrementalStateKeepsIds) {
+  StdErrDiagnostics diag;
+  const std::string compiled_files_dir = GetTestPath("compiled");
+  const std::string values_path = GetTestPath("res/values/values.xml");
+  ASSERT_TRUE(CompileFile(values_path, R"(<resources>
+                                           <string name="b">B</string>
+                                           <string name="c">C</string>
+                                         </resources>)",
+                          compiled_files_dir, &diag));
+
+  const std::string state_path = GetTestPath("link.state");
+  const std::string ids_path = GetTestPath("ids.txt");
+  const std::vector<std::string> link_args = {
+      "--manifest", GetDefaultManifest(),
+      "-o", GetTestPath("out.apk"),
+      "--incremental-state", state_path,
+      "--emit-ids", ids_path,
+  };
+  ASSERT_TRUE(Link(link_args, compiled_files_dir, &diag));
+
+  const ResourceName b = test::ParseNameOrDie("com.aapt.command.test:string/b");
+  const ResourceName c = test::ParseNameOrDie("com.aapt.command.test:string/c");
+  std::optional<LinkState> state = LinkState::Load(state_path);
+  ASSERT_TRUE(state);
+  EXPECT_THAT(state->ids[b], Eq(ResourceId(0x7f010000)));
+  EXPECT_THAT(state->ids[c], Eq(ResourceId(0x7f010001)));
+  EXPECT_FALSE(state->outputs.empty());
+
+  // A new resource that sorts first doesn't renumber the others.
+  ASSERT_TRUE(CompileFile(values_path, R"(<resources>
+                                           <string name="a">A</string>
+                                           <string name="b">B</string>
+                                           <string name="c">C</string>
+                                         </resources>)",
+                          compiled_files_dir, &diag));
+  ASSERT_TRUE(Link(link_args, compiled_files_dir, &diag));
+
+  state = LinkState::Load(state_path);
+  ASSERT_TRUE(state);
+  EXPECT_THAT(state->ids[test::ParseNameOrDie("com.aapt.command.test:string/a")],
+              Eq(ResourceId(0x7f010002)));
+  EXPECT_THAT(state->ids[b], Eq(ResourceId(0x7f010000)));
+  EXPECT_THAT(state->ids[c], Eq(ResourceId(0x7f010001)));
+
+  // A clean link with the emitted IDs as stable IDs assigns the same ones.
+  const std::string clean_state_path = GetTestPath("clean.state");
+  ASSERT_TRUE(Link({"--manifest", GetDefaultManifest(),
+                    "-o", GetTestPath("clean.apk"),
+                    "--incremental-state", clean_state_path,
+                    "--stable-ids", ids_path},
+                   compiled_files_dir, &diag));
+  std::optional<LinkState> clean_state = LinkState::Load(clean_state_path);
+  ASSERT_TRUE(clean_state);
+  EXPECT_THAT(clean_state->ids, Eq(state->ids));
+}
+
+TEST_F(LinkTest, IncrementalStateWithoutEmittedIdsAssignsCleanIds) {
+  StdErrDiagnostics diag;
+  const std::string compiled_files_dir = GetTestPath("compiled");
+  const std::string values_path = GetTestPath("res/values/values.xml");
+  ASSERT_TRUE(CompileFile(values_path, R"(<resources>
+                                           <string name="b">B</string>
+                                         </resources>)",
+                          compiled_files_dir, &diag));
+
+  const std::string state_path = GetTestPath("link.state");
+  const std::vector<std::string> link_args = {
+      "--manifest", GetDefaultManifest(),
+      "-o", GetTestPath("out.apk"),
+      "--incremental-state", state_path,
+  };
+  ASSERT_TRUE(Link(link_args, compiled_files_dir, &diag));
+
+  ASSERT_TRUE(CompileFile(values_path, R"(<resources>
+                                           <string name="a">A</string>
+                                           <string name="b">B</string>
+                                         </resources>)",
+                          compiled_files_dir, &diag));
+  ASSERT_TRUE(Link(link_args, compiled_files_dir, &diag));
+
+  std::optional<LinkState> state = LinkState::Load(state_path);
+  ASSERT_TRUE(state);
+  EXPECT_THAT(state->ids[test::ParseNameOrDie("com.aapt.command.test:string/a")],
+              Eq(ResourceId(0x7f010000)));
+  EXPECT_THAT(state->ids[test::ParseNameOrDie("com.aapt.command.test:string/b")],
+              Eq(ResourceId(0x7f010001)));
+}
+
 TEST_F(LinkTest, NoCompressAssets) {
   StdErrDiagnostics diag;
   std::string content(500, 'a');
@@ -47,6 +47,7 @@
 #include "optimize/ResourceFilter.h"
 #include "optimize/VersionCollapser.h"
 #include "split/TableSplitter.h"
+#include "trace/TraceBuffer.h"
 #include "util/Files.h"
 #include "util/Util.h"
 
@@ -133,6 +134,7 @@ class Optimizer {
   }
 
   int Run(std::unique_ptr<LoadedApk> apk) {
+    TRACE_CALL();
     if (context_->IsVerbose()) {
       context_->GetDiagnostics()->Note(android::DiagMessage() << "Optimizing APK...");
     }
@@ -224,15 +226,15 @@ class Optimizer {
       MultiApkGenerator generator{apk.get(), context_};
       MultiApkGeneratorOptions generator_options = {
           options_.output_dir.value(), options_.apk_artifacts.value(),
-          options_.table_flattener_options, options_.kept_artifacts};
+          options_.table_flattener_options, options_.kept_artifacts, options_.jobs};
       if (!generator.FromBaseApk(generator_options)) {
         return 1;
       }
     }
 
     if (options_.output_path) {
-      std::unique_ptr<IArchiveWriter> writer =
-          CreateZipFileArchiveWriter(context_->GetDiagnostics(), options_.output_path.value());
+      std::unique_ptr<IArchiveWriter> writer = CreateZipFileArchiveWriter(
+          context_->GetDiagnostics(), options_.output_path.value(), options_.jobs);
       if (!apk->WriteToArchive(context_, options_.table_flattener_options, writer.get())) {
         return 1;
       }
@@ -243,6 +245,7 @@ class Optimizer {
 
  private:
   bool WriteSplitApk(ResourceTable* table, xml::XmlResource* manifest, IArchiveWriter* writer) {
+    TRACE_CALL();
     android::BigBuffer manifest_buffer(4096);
     XmlFlattener xml_flattener(&manifest_buffer, {});
     if (!xml_flattener.Consume(context_, manifest)) {
@@ -352,12 +355,18 @@ int OptimizeCommand::Action(const std::vector<std::string>& args) {
     Usage(&std::cerr);
     return 1;
   }
+  TRACE_FLUSH(trace_folder_.value_or(""), "OptimizeCommand::Action");
+  TRACE_PERF_REPORT(perf_report_path_.value_or(""));
 
   const std::string& apk_path = args[0];
   OptimizeContext context;
   context.SetVerbose(verbose_);
   android::IDiagnostics* diag = context.GetDiagnostics();
 
+  if (jobs_ && !ParseJobsParameter(jobs_.value(), diag, &options_.jobs)) {
+    return 1;
+  }
+
   if (config_path_) {
     std::string& path = config_path_.value();
     std::optional<ConfigurationParser> for_path = ConfigurationParser::ForPath(path);
@@ -409,6 +418,9 @@ int OptimizeCommand::Action(const std::vector<std::string>& args) {
   if (options_.enable_sparse_encoding) {
     options_.table_flattener_options.sparse_entries = SparseEntriesMode::Enabled;
   }
+  if (options_.auto_sparse_encoding) {
+    options_.table_flattener_options.sparse_entries = SparseEntriesMode::Auto;
+  }
   if (options_.force_sparse_encoding) {
     options_.table_flattener_options.sparse_entries = SparseEntriesMode::Forced;
   }
@@ -64,11 +64,18 @@ struct OptimizeOptions {
   // Whether sparse encoding should be used for O+ resources.
   bool enable_sparse_encoding = false;
 
+  // Whether sparse encoding should be used for O+ resources, where it pays off.
+  bool auto_sparse_encoding = false;
+
   // Whether sparse encoding should be used for all resources.
   bool force_sparse_encoding = false;
 
   // Path to the output map of original resource paths/names to obfuscated paths/names.
   std::optional<std::string> obfuscation_map_path;
+
+  // The number of split artifacts to generate at the same time, and of threads compressing the
+  // entries of the output APK.
+  int jobs = 1;
 };
 
 class OptimizeCommand : public Command {
@@ -110,6 +117,11 @@ class OptimizeCommand : public Command {
         "This decreases APK size at the cost of resource retrieval performance.\n"
         "Only applies sparse encoding if minSdk of the APK is >= 32",
         &options_.enable_sparse_encoding);
+    AddOptionalSwitch(
+        "--auto-sparse-encoding",
+        "Like --enable-sparse-encoding, but only sparse encodes the types that it makes smaller\n"
+        "and that have few enough entries for their lookups to stay fast.",
+        &options_.auto_sparse_encoding);
     AddOptionalSwitch(
         "--force-sparse-encoding",
         "Enables encoding sparse entries using a binary search tree.\n"
@@ -144,6 +156,17 @@ class OptimizeCommand : public Command {
         "store the same resource value only once in resource table which decreases APK size.\n"
         "Has no effect on APKs where resource names are kept.",
         &options_.table_flattener_options.deduplicate_entry_values);
+    AddOptionalFlag("-j",
+                    "Number of split artifacts to generate in parallel, and of threads compressing\n"
+                    "the output APK, 1 by default. The diagnostics are in the same order as with\n"
+                    "a single job.",
+                    &jobs_);
+    AddOptionalFlag("--trace-folder", "Generate systrace json trace fragment to specified folder.",
+                    &trace_folder_);
+    AddOptionalFlag("--perf-report",
+                    "Write a summary of the wall time, CPU time and peak memory growth of each\n"
+                    "traced step, and of the items and bytes they processed, to the given file.",
+                    &perf_report_path_);
     AddOptionalSwitch("-v", "Enables verbose logging", &verbose_);
   }
 
@@ -158,6 +181,9 @@ class OptimizeCommand : public Command {
   std::optional<std::string> config_path_;
   std::optional<std::string> resources_config_path_;
   std::optional<std::string> target_densities_;
+  std::optional<std::string> jobs_;
+  std::optional<std::string> trace_folder_;
+  std::optional<std::string> perf_report_path_;
   std::vector<std::string> configs_;
   std::vector<std::string> split_args_;
   std::unordered_set<std::string> kept_artifacts_;
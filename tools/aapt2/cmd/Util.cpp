@@ -150,6 +150,17 @@ std::unique_ptr<IConfigFilter> ParseConfigFilterParameters(const std::vector<std
   return std::move(filter);
 }
 
+bool ParseJobsParameter(StringPiece arg, android::IDiagnostics* diag, int* out_jobs) {
+  const std::optional<uint32_t> jobs = ResourceUtils::ParseInt(arg);
+  if (!jobs || jobs.value() < 1 || jobs.value() > 256) {
+    diag->Error(android::DiagMessage()
+                << "number of jobs '" << arg << "' should be a number in [1..256] range");
+    return false;
+  }
+  *out_jobs = static_cast<int>(jobs.value());
+  return true;
+}
+
 bool ParseFeatureFlagsParameter(StringPiece arg, android::IDiagnostics* diag,
                                 FeatureFlagValues* out_feature_flag_values) {
   if (arg.empty()) {
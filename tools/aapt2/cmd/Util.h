@@ -28,6 +28,7 @@
 
 #include "AppInfo.h"
 #include "SdkConstants.h"
+#include "android-base/macros.h"
 #include "androidfw/IDiagnostics.h"
 #include "androidfw/StringPiece.h"
 #include "filter/ConfigFilter.h"
@@ -114,6 +115,61 @@ bool ParseResourceConfig(const std::string& content, IAaptContext* context,
                          std::set<ResourceName>& out_name_collapse_exemptions,
                          std::set<ResourceName>& out_path_shorten_exemptions);
 
+// Parses the argument of -j, the number of threads to run a command on, in [1..256].
+// Returns false and logs a human friendly error message if the argument was not legal.
+bool ParseJobsParameter(android::StringPiece arg, android::IDiagnostics* diag, int* out_jobs);
+
+// The context of the work that a command does on a worker thread: the same as the context of the
+// command, but with diagnostics of its own.
+class JobContext : public IAaptContext {
+ public:
+  JobContext(IAaptContext* context, android::IDiagnostics* diagnostics)
+      : context_(context), diagnostics_(diagnostics) {
+  }
+
+  PackageType GetPackageType() override {
+    return context_->GetPackageType();
+  }
+
+  SymbolTable* GetExternalSymbols() override {
+    return context_->GetExternalSymbols();
+  }
+
+  android::IDiagnostics* GetDiagnostics() override {
+    return diagnostics_;
+  }
+
+  const std::string& GetCompilationPackage() override {
+    return context_->GetCompilationPackage();
+  }
+
+  uint8_t GetPackageId() override {
+    return context_->GetPackageId();
+  }
+
+  NameMangler* GetNameMangler() override {
+    return context_->GetNameMangler();
+  }
+
+  bool IsVerbose() override {
+    return context_->IsVerbose();
+  }
+
+  int GetMinSdkVersion() override {
+    return context_->GetMinSdkVersion();
+  }
+
+  const std::set<std::string>& GetSplitNameDependencies() override {
+    return context_->GetSplitNameDependencies();
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(JobContext);
+
+  IAaptContext* context_;
+  android::IDiagnostics* diagnostics_;
+};
+
 }  // namespace aapt
 
 #endif /* AAPT_SPLIT_UTIL_H */
@@ -16,15 +16,22 @@
 
 #include "format/Archive.h"
 
+#include <zlib.h>
+
+#include <condition_variable>
 #include <cstdio>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "android-base/errors.h"
 #include "android-base/macros.h"
 #include "android-base/utf8.h"
 #include "androidfw/StringPiece.h"
+#include "trace/TraceBuffer.h"
 #include "util/Files.h"
 #include "util/Util.h"
 #include "ziparchive/zip_writer.h"
@@ -179,6 +186,7 @@ class ZipFileWriter : public IArchiveWriter {
       error_ = ZipWriter::ErrorCodeString(result);
       return false;
     }
+    entry_count_++;
     return true;
   }
 
@@ -223,6 +231,7 @@ class ZipFileWriter : public IArchiveWriter {
             error_ = ZipWriter::ErrorCodeString(result);
             return false;
           }
+          entry_count_--;
           flags &= ~ArchiveEntry::kCompress;
 
           continue;
@@ -242,7 +251,10 @@ class ZipFileWriter : public IArchiveWriter {
 
   virtual ~ZipFileWriter() {
     if (writer_) {
+      TRACE_NAME("ZipFileWriter::Finish");
       writer_->Finish();
+      TraceCounter("Archive entries written", entry_count_);
+      TraceCounter("Archive bytes written", ftell(file_.get()));
     }
   }
 
@@ -252,10 +264,410 @@ class ZipFileWriter : public IArchiveWriter {
   std::unique_ptr<FILE, decltype(fclose)*> file_ = {nullptr, fclose};
   std::unique_ptr<ZipWriter> writer_;
   std::string error_;
+  size_t entry_count_ = 0;
+};
+
+// Writes a zip file whose entries are compressed by a pool of threads. The entries are written in
+// the order they were added, as soon as the ones before them are, and laid out like those of
+// ZipFileWriter: no data descriptors, the same timestamp for all, and the data of the aligned
+// entries on a 32-bit boundary.
+class ParallelZipFileWriter : public IArchiveWriter {
+ public:
+  explicit ParallelZipFileWriter(int jobs) : jobs_(jobs) {
+  }
+
+  bool Open(StringPiece path) {
+    file_ = {::android::base::utf8::fopen(path.data(), "w+b"), fclose};
+    if (!file_) {
+      error_ = SystemErrorCodeToString(errno);
+      return false;
+    }
+    for (int i = 0; i < jobs_; i++) {
+      workers_.emplace_back([this] { CompressEntries(); });
+    }
+    return true;
+  }
+
+  bool StartEntry(StringPiece path, uint32_t flags) override {
+    if (!file_ || current_entry_) {
+      return false;
+    }
+    current_entry_ = std::make_shared<Entry>();
+    current_entry_->path = std::string(path);
+    current_entry_->flags = flags;
+    return true;
+  }
+
+  bool Write(const void* data, int len) override {
+    if (!current_entry_) {
+      return false;
+    }
+    current_entry_->data.append(static_cast<const char*>(data), len);
+    return true;
+  }
+
+  bool FinishEntry() override {
+    if (!current_entry_) {
+      return false;
+    }
+    std::shared_ptr<Entry> entry = std::move(current_entry_);
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      pending_size_ += entry->data.size();
+      written_entries_.push_back(entry);
+      queued_entries_.push_back(entry);
+    }
+    work_available_.notify_one();
+    return WriteCompressedEntries(false /* wait */);
+  }
+
+  bool WriteFile(StringPiece path, uint32_t flags, android::InputStream* in) override {
+    if (!StartEntry(path, flags)) {
+      return false;
+    }
+
+    const void* data = nullptr;
+    size_t len = 0;
+    while (in->Next(&data, &len)) {
+      Write(data, static_cast<int>(len));
+    }
+
+    if (in->HadError()) {
+      error_ = in->GetError();
+      current_entry_.reset();
+      return false;
+    }
+
+    // Like ZipFileWriter, store the file if it doesn't compress well enough. This is preserving
+    // behavior of AAPT.
+    current_entry_->store_if_incompressible = in->CanRewind();
+    return FinishEntry();
+  }
+
+  bool HadError() const override {
+    return !error_.empty();
+  }
+
+  std::string GetError() const override {
+    return error_;
+  }
+
+  virtual ~ParallelZipFileWriter() {
+    if (file_) {
+      TRACE_NAME("ParallelZipFileWriter::Finish");
+      if (WriteCompressedEntries(true /* wait */)) {
+        WriteCentralDirectory();
+      }
+      TraceCounter("Archive entries written", central_directory_.size());
+      TraceCounter("Archive bytes written", ftell(file_.get()));
+    }
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ParallelZipFileWriter);
+
+  // Past this much data buffered for the entries that aren't written yet, adding an entry waits.
+  static constexpr size_t kMaxPendingSize = 128 * 1024 * 1024;
+
+  // The timestamp of all the entries: 1980-01-01 00:00:00, in MS-DOS format.
+  static constexpr uint16_t kDosTime = 0;
+  static constexpr uint16_t kDosDate = (0 << 9) | (1 << 5) | 1;
+
+  struct Entry {
+    std::string path;
+    uint32_t flags = 0;
+    bool store_if_incompressible = false;
+
+    // The uncompressed data, replaced by the data to write once compressed.
+    std::string data;
+    bool compressed = false;
+    uint16_t method = 0;
+    uint32_t crc32 = 0;
+    uint64_t uncompressed_size = 0;
+
+    // Where the local header was written, and the size of the data that follows it.
+    uint64_t offset = 0;
+    uint64_t compressed_size = 0;
+  };
+
+  void CompressEntries() {
+    while (true) {
+      std::shared_ptr<Entry> entry;
+      {
+        std::unique_lock<std::mutex> lock(lock_);
+        work_available_.wait(lock, [this] { return stopping_ || !queued_entries_.empty(); });
+        if (queued_entries_.empty()) {
+          return;
+        }
+        entry = std::move(queued_entries_.front());
+        queued_entries_.pop_front();
+      }
+
+      Compress(entry.get());
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        entry->compressed = true;
+      }
+      entry_compressed_.notify_all();
+    }
+  }
+
+  static void Compress(Entry* entry) {
+    TRACE_NAME("ParallelZipFileWriter::Compress");
+    const Bytef* data = reinterpret_cast<const Bytef*>(entry->data.data());
+    entry->uncompressed_size = entry->data.size();
+    entry->crc32 = static_cast<uint32_t>(
+        ::crc32_z(::crc32_z(0L, Z_NULL, 0), data, entry->data.size()));
+    if ((entry->flags & ArchiveEntry::kCompress) == 0) {
+      return;
+    }
+
+    z_stream stream = {};
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      return;
+    }
+    std::string deflated(deflateBound(&stream, entry->data.size()), '\0');
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = static_cast<uInt>(entry->data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(deflated.data());
+    stream.avail_out = static_cast<uInt>(deflated.size());
+    const int result = deflate(&stream, Z_FINISH);
+    deflated.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+      return;
+    }
+    if (entry->store_if_incompressible &&
+        deflated.size() + (deflated.size() / 10) > entry->data.size()) {
+      return;
+    }
+    entry->data = std::move(deflated);
+    entry->method = Z_DEFLATED;
+  }
+
+  // Writes the entries at the front of the queue that are compressed. If wait is true, or if the
+  // entries waiting take too much memory, waits for them to be compressed.
+  bool WriteCompressedEntries(bool wait) {
+    while (next_entry_to_write_ < written_entries_.size()) {
+      std::shared_ptr<Entry> entry = written_entries_[next_entry_to_write_];
+      {
+        std::unique_lock<std::mutex> lock(lock_);
+        if (!entry->compressed) {
+          if (!wait && pending_size_ <= kMaxPendingSize) {
+            return !HadError();
+          }
+          entry_compressed_.wait(lock, [&entry] { return entry->compressed; });
+        }
+        pending_size_ -= entry->uncompressed_size;
+      }
+      written_entries_[next_entry_to_write_++].reset();
+      if (!HadError() && !WriteLocalEntry(entry.get())) {
+        return false;
+      }
+      central_directory_.push_back(std::move(*entry));
+      central_directory_.back().data.clear();
+    }
+    return !HadError();
+  }
+
+  static void Append16(uint16_t value, std::string* out) {
+    out->push_back(static_cast<char>(value & 0xff));
+    out->push_back(static_cast<char>(value >> 8));
+  }
+
+  static void Append32(uint32_t value, std::string* out) {
+    Append16(static_cast<uint16_t>(value & 0xffff), out);
+    Append16(static_cast<uint16_t>(value >> 16), out);
+  }
+
+  bool WriteBytes(const std::string& bytes) {
+    if (fwrite(bytes.data(), 1, bytes.size(), file_.get()) != bytes.size()) {
+      error_ = SystemErrorCodeToString(errno);
+      return false;
+    }
+    offset_ += bytes.size();
+    return true;
+  }
+
+  bool CheckLimits(const Entry& entry) {
+    if (offset_ + entry.data.size() + entry.path.size() + 64 > UINT32_MAX ||
+        entry.path.size() > UINT16_MAX || central_directory_.size() >= UINT16_MAX) {
+      error_ = "archive is too large for a zip file without zip64 extensions";
+      return false;
+    }
+    return true;
+  }
+
+  bool WriteLocalEntry(Entry* entry) {
+    if (!CheckLimits(*entry)) {
+      return false;
+    }
+    entry->offset = offset_;
+    entry->compressed_size = entry->data.size();
+
+    constexpr size_t kLocalHeaderSize = 30;
+    size_t padding = 0;
+    if (entry->flags & ArchiveEntry::kAlign) {
+      padding = (4 - (offset_ + kLocalHeaderSize + entry->path.size()) % 4) % 4;
+    }
+
+    std::string header;
+    Append32(0x04034b50, &header);
+    Append16(20, &header);  // The version needed to extract.
+    Append16(0, &header);   // The flags.
+    Append16(entry->method, &header);
+    Append16(kDosTime, &header);
+    Append16(kDosDate, &header);
+    Append32(entry->crc32, &header);
+    Append32(static_cast<uint32_t>(entry->data.size()), &header);
+    Append32(static_cast<uint32_t>(entry->uncompressed_size), &header);
+    Append16(static_cast<uint16_t>(entry->path.size()), &header);
+    Append16(static_cast<uint16_t>(padding), &header);
+    header.append(entry->path);
+    header.append(padding, '\0');
+    return WriteBytes(header) && WriteBytes(entry->data);
+  }
+
+  bool WriteCentralDirectory() {
+    const uint64_t central_directory_offset = offset_;
+    std::string directory;
+    for (const Entry& entry : central_directory_) {
+      Append32(0x02014b50, &directory);
+      Append16(20, &directory);  // The version made by.
+      Append16(20, &directory);  // The version needed to extract.
+      Append16(0, &directory);   // The flags.
+      Append16(entry.method, &directory);
+      Append16(kDosTime, &directory);
+      Append16(kDosDate, &directory);
+      Append32(entry.crc32, &directory);
+      Append32(static_cast<uint32_t>(entry.compressed_size), &directory);
+      Append32(static_cast<uint32_t>(entry.uncompressed_size), &directory);
+      Append16(static_cast<uint16_t>(entry.path.size()), &directory);
+      Append16(0, &directory);  // The extra field length.
+      Append16(0, &directory);  // The comment length.
+      Append16(0, &directory);  // The disk number.
+      Append16(0, &directory);  // The internal attributes.
+      Append32(0, &directory);  // The external attributes.
+      Append32(static_cast<uint32_t>(entry.offset), &directory);
+      directory.append(entry.path);
+    }
+
+    const size_t directory_size = directory.size();
+    if (central_directory_offset + directory_size > UINT32_MAX) {
+      error_ = "archive is too large for a zip file without zip64 extensions";
+      return false;
+    }
+    const uint16_t entry_count = static_cast<uint16_t>(central_directory_.size());
+    Append32(0x06054b50, &directory);
+    Append16(0, &directory);  // The disk number.
+    Append16(0, &directory);  // The disk of the central directory.
+    Append16(entry_count, &directory);
+    Append16(entry_count, &directory);
+    Append32(static_cast<uint32_t>(directory_size), &directory);
+    Append32(static_cast<uint32_t>(central_directory_offset), &directory);
+    Append16(0, &directory);  // The comment length.
+    return WriteBytes(directory) && fflush(file_.get()) == 0;
+  }
+
+  const int jobs_;
+  std::unique_ptr<FILE, decltype(fclose)*> file_ = {nullptr, fclose};
+  std::string error_;
+  std::shared_ptr<Entry> current_entry_;
+
+  // Only used by the writing thread.
+  std::vector<std::shared_ptr<Entry>> written_entries_;
+  size_t next_entry_to_write_ = 0;
+  uint64_t offset_ = 0;
+  std::vector<Entry> central_directory_;
+
+  // Guards the queue, the sizes and whether the entries are compressed.
+  std::mutex lock_;
+  std::condition_variable work_available_;
+  std::condition_variable entry_compressed_;
+  std::deque<std::shared_ptr<Entry>> queued_entries_;
+  size_t pending_size_ = 0;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
 };
 
 }  // namespace
 
+bool BufferedArchiveWriter::WriteFile(StringPiece path, uint32_t flags, android::InputStream* in) {
+  if (!StartEntry(path, flags)) {
+    return false;
+  }
+
+  const void* data = nullptr;
+  size_t len = 0;
+  while (in->Next(&data, &len)) {
+    Write(data, static_cast<int>(len));
+  }
+
+  if (in->HadError()) {
+    error_ = in->GetError();
+    entries_.pop_back();
+    writing_ = false;
+    return false;
+  }
+  return FinishEntry();
+}
+
+bool BufferedArchiveWriter::StartEntry(StringPiece path, uint32_t flags) {
+  if (writing_) {
+    error_ = "an entry is already being written";
+    return false;
+  }
+  entries_.push_back(Entry{std::string(path), flags, {}});
+  writing_ = true;
+  return true;
+}
+
+bool BufferedArchiveWriter::FinishEntry() {
+  if (!writing_) {
+    error_ = "no entry is being written";
+    return false;
+  }
+  writing_ = false;
+  return true;
+}
+
+bool BufferedArchiveWriter::Write(const void* buffer, int size) {
+  if (!writing_) {
+    error_ = "no entry is being written";
+    return false;
+  }
+  entries_.back().data.append(static_cast<const char*>(buffer), size);
+  return true;
+}
+
+bool BufferedArchiveWriter::HadError() const {
+  return !error_.empty();
+}
+
+std::string BufferedArchiveWriter::GetError() const {
+  return error_;
+}
+
+bool BufferedArchiveWriter::WriteTo(IArchiveWriter* writer) const {
+  for (const Entry& entry : entries_) {
+    if (!writer->StartEntry(entry.path, entry.flags) ||
+        !writer->Write(entry.data.data(), static_cast<int>(entry.data.size())) ||
+        !writer->FinishEntry()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 std::unique_ptr<IArchiveWriter> CreateDirectoryArchiveWriter(android::IDiagnostics* diag,
                                                              StringPiece path) {
   std::unique_ptr<DirectoryWriter> writer = util::make_unique<DirectoryWriter>();
@@ -267,7 +679,16 @@ std::unique_ptr<IArchiveWriter> CreateDirectoryArchiveWriter(android::IDiagnosti
 }
 
 std::unique_ptr<IArchiveWriter> CreateZipFileArchiveWriter(android::IDiagnostics* diag,
-                                                           StringPiece path) {
+                                                           StringPiece path, int jobs) {
+  if (jobs > 1) {
+    std::unique_ptr<ParallelZipFileWriter> writer = util::make_unique<ParallelZipFileWriter>(jobs);
+    if (!writer->Open(path)) {
+      diag->Error(android::DiagMessage(path) << writer->GetError());
+      return {};
+    }
+    return std::move(writer);
+  }
+
   std::unique_ptr<ZipFileWriter> writer = util::make_unique<ZipFileWriter>();
   if (!writer->Open(path)) {
     diag->Error(android::DiagMessage(path) << writer->GetError());
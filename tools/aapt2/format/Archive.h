@@ -22,6 +22,7 @@
 #include <string>
 #include <vector>
 
+#include "android-base/macros.h"
 #include "androidfw/BigBuffer.h"
 #include "androidfw/IDiagnostics.h"
 #include "androidfw/Streams.h"
@@ -69,11 +70,50 @@ class IArchiveWriter : public ::google::protobuf::io::CopyingOutputStream {
   virtual std::string GetError() const = 0;
 };
 
+// Keeps the entries written to it in memory, to add them to another archive later on. Used to
+// write the output of work done on several threads in a deterministic order.
+class BufferedArchiveWriter : public IArchiveWriter {
+ public:
+  struct Entry {
+    std::string path;
+    uint32_t flags = 0;
+    std::string data;
+  };
+
+  BufferedArchiveWriter() = default;
+  explicit BufferedArchiveWriter(std::vector<Entry> entries) : entries_(std::move(entries)) {
+  }
+
+  bool WriteFile(android::StringPiece path, uint32_t flags, android::InputStream* in) override;
+  bool StartEntry(android::StringPiece path, uint32_t flags) override;
+  bool FinishEntry() override;
+  bool Write(const void* buffer, int size) override;
+  bool HadError() const override;
+  std::string GetError() const override;
+
+  const std::vector<Entry>& GetEntries() const {
+    return entries_;
+  }
+
+  // Adds the entries to the writer, in the order they were written.
+  bool WriteTo(IArchiveWriter* writer) const;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BufferedArchiveWriter);
+
+  std::vector<Entry> entries_;
+  bool writing_ = false;
+  std::string error_;
+};
+
 std::unique_ptr<IArchiveWriter> CreateDirectoryArchiveWriter(android::IDiagnostics* diag,
                                                              android::StringPiece path);
 
+// With more than one job, the entries are compressed on that many threads. They are still written
+// in order, and the archive is the same but for the layout of its headers.
 std::unique_ptr<IArchiveWriter> CreateZipFileArchiveWriter(android::IDiagnostics* diag,
-                                                           android::StringPiece path);
+                                                           android::StringPiece path,
+                                                           int jobs = 1);
 
 }  // namespace aapt
 
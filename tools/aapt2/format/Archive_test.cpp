@@ -74,12 +74,12 @@ std::unique_ptr<IArchiveWriter> MakeDirectoryWriter(const std::string& output_pa
   return CreateDirectoryArchiveWriter(&diag, output_path);
 }
 
-std::unique_ptr<IArchiveWriter> MakeZipFileWriter(const std::string& output_path) {
+std::unique_ptr<IArchiveWriter> MakeZipFileWriter(const std::string& output_path, int jobs = 1) {
   file::mkdirs(std::string(file::GetStem(output_path)));
   std::remove(output_path.c_str());
 
   StdErrDiagnostics diag;
-  return CreateZipFileArchiveWriter(&diag, output_path);
+  return CreateZipFileArchiveWriter(&diag, output_path, jobs);
 }
 
 void VerifyDirectory(const std::string& path, const std::string& file, const uint8_t array[]) {
@@ -247,6 +247,38 @@ TEST_F(ArchiveTest, ZipFileWriteFileError) {
   ASSERT_EQ("ZipFileWriteFileError", writer->GetError());
 }
 
+TEST_F(ArchiveTest, ParallelZipFileWriteEntriesSuccess) {
+  std::string output_path = GetTestPath("output.apk");
+  std::unique_ptr<IArchiveWriter> writer = MakeZipFileWriter(output_path, 4);
+  std::unique_ptr<uint8_t[]> data1 = MakeTestArray();
+  std::unique_ptr<uint8_t[]> data2 = MakeTestArray();
+  auto data3 = std::make_unique<uint8_t[]>(kTestDataLength);
+  std::fill(data3.get(), data3.get() + kTestDataLength, 'a');
+
+  ASSERT_TRUE(writer->StartEntry("test1", ArchiveEntry::kCompress));
+  ASSERT_TRUE(writer->Write(static_cast<const void*>(data1.get()), kTestDataLength));
+  ASSERT_TRUE(writer->FinishEntry());
+  ASSERT_FALSE(writer->HadError());
+
+  ASSERT_TRUE(writer->StartEntry("test2", ArchiveEntry::kAlign));
+  ASSERT_TRUE(writer->Write(static_cast<const void*>(data2.get()), kTestDataLength));
+  ASSERT_TRUE(writer->FinishEntry());
+  ASSERT_FALSE(writer->HadError());
+
+  auto data3_copy = std::make_unique<uint8_t[]>(kTestDataLength);
+  std::copy(data3.get(), data3.get() + kTestDataLength, data3_copy.get());
+  auto input3 = std::make_unique<TestData>(data3_copy, kTestDataLength);
+  ASSERT_TRUE(writer->WriteFile("test3", ArchiveEntry::kCompress, input3.get()));
+  ASSERT_FALSE(writer->HadError());
+
+  writer.reset();
+
+  VerifyZipFile(output_path, "test1", data1.get());
+  VerifyZipFile(output_path, "test2", data2.get());
+  VerifyZipFile(output_path, "test3", data3.get());
+  VerifyZipFileTimestamps(output_path);
+}
+
 TEST_F(ArchiveTest, ZipFileTimeZoneUTC) {
   TzSetter tz("UTC0");
   std::string output_path = GetTestPath("output.apk");
@@ -197,8 +197,7 @@ class PackageFlattener {
     // whether the offsets can be represented in 2 bytes
     bool short_offsets = (values_buffer.size() / 4u) < std::numeric_limits<uint16_t>::max();
 
-    bool sparse_encode = sparse_entries_ == SparseEntriesMode::Enabled ||
-                         sparse_entries_ == SparseEntriesMode::Forced;
+    bool sparse_encode = sparse_entries_ != SparseEntriesMode::Disabled;
 
     // Only sparse encode if the entries will be read on platforms S_V2+. Sparse encoding
     // is not supported on older platforms (b/197642721, b/197976367).
@@ -219,6 +218,15 @@ class PackageFlattener {
     sparse_encode =
         sparse_encode && ((100 * entries->size()) / num_total_entries) < kSparseEncodingThreshold;
 
+    // In auto mode, only sparse encode if it makes the offsets smaller than the dense ones, and
+    // the binary search over the entries is short.
+    if (sparse_encode && sparse_entries_ == SparseEntriesMode::Auto) {
+      const size_t dense_size =
+          num_total_entries * (compact_entry ? sizeof(uint16_t) : sizeof(uint32_t));
+      sparse_encode = entries->size() * sizeof(ResTable_sparseTypeEntry) < dense_size &&
+                      entries->size() <= kAutoSparseEncodingMaxEntries;
+    }
+
     if (sparse_encode) {
       type_header->entryCount = android::util::HostToDevice32(entries->size());
       type_header->flags |= ResTable_type::FLAG_SPARSE;
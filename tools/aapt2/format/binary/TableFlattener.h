@@ -34,6 +34,12 @@ namespace aapt {
 // preferred.
 constexpr const size_t kSparseEncodingThreshold = 60;
 
+// The most entries a type may have to be sparse encoded in SparseEntriesMode::Auto. Looking up an
+// entry of a sparse type is a binary search over its entries, which past this many takes more
+// than twice as long as indexing the dense offsets (see BM_TypeEncodingFindEntry in
+// libs/androidfw/tests/SparseEntry_bench.cpp).
+constexpr const size_t kAutoSparseEncodingMaxEntries = 256;
+
 enum class SparseEntriesMode {
   // Disables sparse encoding for entries.
   Disabled,
@@ -42,6 +48,10 @@ enum class SparseEntriesMode {
   Enabled,
   // Enables sparse encoding for all entries regardless of minSdk.
   Forced,
+  // Like Enabled, but only sparse encodes a type when its sparse offsets are smaller than the
+  // dense ones it would otherwise use, including the 16-bit offsets of compact entries, and it has
+  // few enough entries for its lookups to stay fast.
+  Auto,
 };
 
 struct TableFlattenerOptions {
@@ -397,6 +397,59 @@ TEST_F(TableFlattenerTest, FlattenSparseEntryWithMinSdkSV2AndForced) {
   CheckSparseEntries(context.get(), sparse_config, sparse_contents);
 }
 
+TEST_F(TableFlattenerTest, FlattenSparseEntryWithAutoMode) {
+  std::unique_ptr<IAaptContext> context = test::ContextBuilder()
+                                              .SetCompilationPackage("android")
+                                              .SetPackageId(0x01)
+                                              .SetMinSdkVersion(SDK_S_V2)
+                                              .Build();
+
+  const ConfigDescription sparse_config = test::ParseConfigOrDie("en-rGB");
+  auto table_in = BuildTableWithSparseEntries(context.get(), sparse_config, 0.25f);
+
+  TableFlattenerOptions options;
+  options.sparse_entries = SparseEntriesMode::Auto;
+
+  std::string no_sparse_contents;
+  ASSERT_TRUE(Flatten(context.get(), {}, table_in.get(), &no_sparse_contents));
+
+  std::string sparse_contents;
+  ASSERT_TRUE(Flatten(context.get(), options, table_in.get(), &sparse_contents));
+
+  EXPECT_GT(no_sparse_contents.size(), sparse_contents.size());
+
+  CheckSparseEntries(context.get(), sparse_config, sparse_contents);
+}
+
+TEST_F(TableFlattenerTest, DoNotFlattenSparseEntryWithAutoModeWhenOffset16IsAsSmall) {
+  std::unique_ptr<IAaptContext> context = test::ContextBuilder()
+                                              .SetCompilationPackage("android")
+                                              .SetPackageId(0x01)
+                                              .SetMinSdkVersion(SDK_UPSIDE_DOWN_CAKE)
+                                              .Build();
+
+  const ConfigDescription sparse_config = test::ParseConfigOrDie("en-rGB");
+  auto table_in = BuildTableWithSparseEntries(context.get(), sparse_config, 0.5f);
+
+  // Half of the entries take as many bytes as sparse entries as all of them as 16-bit offsets.
+  TableFlattenerOptions compact_options;
+  compact_options.use_compact_entries = true;
+  TableFlattenerOptions auto_options = compact_options;
+  auto_options.sparse_entries = SparseEntriesMode::Auto;
+  TableFlattenerOptions sparse_options = compact_options;
+  sparse_options.sparse_entries = SparseEntriesMode::Enabled;
+
+  std::string compact_contents;
+  ASSERT_TRUE(Flatten(context.get(), compact_options, table_in.get(), &compact_contents));
+  std::string auto_contents;
+  ASSERT_TRUE(Flatten(context.get(), auto_options, table_in.get(), &auto_contents));
+  std::string sparse_contents;
+  ASSERT_TRUE(Flatten(context.get(), sparse_options, table_in.get(), &sparse_contents));
+
+  EXPECT_EQ(compact_contents, auto_contents);
+  EXPECT_NE(compact_contents, sparse_contents);
+}
+
 TEST_F(TableFlattenerTest, FlattenSparseEntryWithMinSdkBeforeSV2) {
   std::unique_ptr<IAaptContext> context = test::ContextBuilder()
                                               .SetCompilationPackage("android")
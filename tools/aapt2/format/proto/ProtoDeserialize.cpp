@@ -26,6 +26,7 @@
 #include "androidfw/Locale.h"
 #include "androidfw/ResourceTypes.h"
 #include "androidfw/Util.h"
+#include "trace/TraceBuffer.h"
 
 using ::android::ConfigDescription;
 using ::android::LocaleValue;
@@ -603,6 +604,7 @@ static bool DeserializePackageFromPb(const pb::Package& pb_package, const ResStr
 
 bool DeserializeTableFromPb(const pb::ResourceTable& pb_table, io::IFileCollection* files,
                             ResourceTable* out_table, std::string* out_error) {
+  TRACE_CALL();
   // We import the android namespace because on Windows NO_ERROR is a macro, not an enum, which
   // causes errors when qualifying it with android::
   using namespace android;
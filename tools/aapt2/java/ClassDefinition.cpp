@@ -17,6 +17,8 @@
 #include "java/ClassDefinition.h"
 
 #include "androidfw/StringPiece.h"
+#include "io/StringStream.h"
+#include "io/Util.h"
 
 using ::aapt::text::Printer;
 using ::android::StringPiece;
@@ -118,4 +120,29 @@ void ClassDefinition::WriteJavaFile(const ClassDefinition* def, StringPiece pack
   def->Print(final, &printer, strip_api_annotations);
 }
 
+bool ClassDefinition::WriteJavaFiles(const ClassDefinition* def,
+                                     const std::vector<std::string>& packages,
+                                     const OpenJavaFileFunc& open_file, bool final,
+                                     bool strip_api_annotations) {
+  std::string body;
+  {
+    io::StringOutputStream body_out(&body);
+    Printer body_printer(&body_out);
+    def->Print(final, &body_printer, strip_api_annotations);
+  }
+
+  // The files are written one after the other, so that only one of them is open at a time.
+  for (const std::string& package : packages) {
+    std::unique_ptr<android::OutputStream> out = open_file(package);
+    if (out == nullptr) {
+      return false;
+    }
+    Printer printer(out.get());
+    printer.Print(sWarningHeader).Print("package ").Print(package).Println(";");
+    printer.Println();
+    io::Copy(out.get(), body);
+  }
+  return true;
+}
+
 }  // namespace aapt
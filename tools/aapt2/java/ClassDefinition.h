@@ -17,6 +17,8 @@
 #ifndef AAPT_JAVA_CLASSDEFINITION_H
 #define AAPT_JAVA_CLASSDEFINITION_H
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -243,6 +245,16 @@ class ClassDefinition : public ClassMember {
   static void WriteJavaFile(const ClassDefinition* def, android::StringPiece package, bool final,
                             bool strip_api_annotations, android::OutputStream* out);
 
+  // Opens the Java file of a package, or returns nullptr if it can't.
+  using OpenJavaFileFunc =
+      std::function<std::unique_ptr<android::OutputStream>(android::StringPiece package)>;
+
+  // Like WriteJavaFile(), once for each package, to the file that open_file returns for it. The
+  // class is only printed once. Returns false if a file couldn't be opened.
+  static bool WriteJavaFiles(const ClassDefinition* def, const std::vector<std::string>& packages,
+                             const OpenJavaFileFunc& open_file, bool final,
+                             bool strip_api_annotations);
+
   ClassDefinition(android::StringPiece name, ClassQualifier qualifier, bool createIfEmpty)
       : name_(name), qualifier_(qualifier), create_if_empty_(createIfEmpty) {
   }
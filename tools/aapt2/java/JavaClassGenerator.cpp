@@ -593,18 +593,12 @@ static void AppendJavaDocAnnotations(const std::vector<std::string>& annotations
   }
 }
 
-bool JavaClassGenerator::Generate(StringPiece package_name_to_generate,
-                                  StringPiece out_package_name, OutputStream* out,
-                                  OutputStream* out_r_txt) {
-  ClassDefinition r_class("R", ClassQualifier::kNone, true);
+bool JavaClassGenerator::BuildRClass(StringPiece package_name_to_generate,
+                                     ClassDefinition* r_class, Printer* r_txt_printer) {
   std::unique_ptr<MethodDefinition> rewrite_method;
 
-  std::unique_ptr<Printer> r_txt_printer;
-  if (out_r_txt != nullptr) {
-    r_txt_printer = util::make_unique<Printer>(out_r_txt);
-  }
   // Generate an onResourcesLoaded() callback if requested.
-  if (out != nullptr && options_.rewrite_callback_options) {
+  if (r_class != nullptr && options_.rewrite_callback_options) {
     rewrite_method =
         util::make_unique<MethodDefinition>("public static void onResourcesLoaded(int p)");
     for (const std::string& package_to_callback :
@@ -630,13 +624,13 @@ bool JavaClassGenerator::Generate(StringPiece package_name_to_generate,
       const bool force_creation_if_empty = is_public;
 
       std::unique_ptr<ClassDefinition> class_def;
-      if (out != nullptr) {
+      if (r_class != nullptr) {
         class_def = util::make_unique<ClassDefinition>(
             to_string(type->named_type.type), ClassQualifier::kStatic, force_creation_if_empty);
       }
 
       if (!ProcessType(package_name_to_generate, *package, *type, class_def.get(),
-                       rewrite_method.get(), r_txt_printer.get())) {
+                       rewrite_method.get(), r_txt_printer)) {
         return false;
       }
 
@@ -645,34 +639,74 @@ bool JavaClassGenerator::Generate(StringPiece package_name_to_generate,
         if (const ResourceTableType* priv_type =
                 package->FindTypeWithDefaultName(ResourceType::kAttrPrivate)) {
           if (!ProcessType(package_name_to_generate, *package, *priv_type, class_def.get(),
-                           rewrite_method.get(), r_txt_printer.get())) {
+                           rewrite_method.get(), r_txt_printer)) {
             return false;
           }
         }
       }
 
-      if (out != nullptr && type->named_type.type == ResourceType::kStyleable && is_public) {
+      if (r_class != nullptr && type->named_type.type == ResourceType::kStyleable && is_public) {
         // When generating a public R class, we don't want Styleable to be part
         // of the API. It is only emitted for documentation purposes.
         class_def->GetCommentBuilder()->AppendComment("@doconly");
       }
 
-      if (out != nullptr) {
+      if (r_class != nullptr) {
         AppendJavaDocAnnotations(options_.javadoc_annotations, class_def->GetCommentBuilder());
-        r_class.AddMember(std::move(class_def));
+        r_class->AddMember(std::move(class_def));
       }
     }
   }
 
   if (rewrite_method != nullptr) {
-    r_class.AddMember(std::move(rewrite_method));
+    r_class->AddMember(std::move(rewrite_method));
+  }
+
+  if (r_class != nullptr) {
+    AppendJavaDocAnnotations(options_.javadoc_annotations, r_class->GetCommentBuilder());
+  }
+  return true;
+}
+
+bool JavaClassGenerator::Generate(StringPiece package_name_to_generate,
+                                  StringPiece out_package_name, OutputStream* out,
+                                  OutputStream* out_r_txt) {
+  ClassDefinition r_class("R", ClassQualifier::kNone, true);
+  std::unique_ptr<Printer> r_txt_printer;
+  if (out_r_txt != nullptr) {
+    r_txt_printer = util::make_unique<Printer>(out_r_txt);
+  }
+  if (!BuildRClass(package_name_to_generate, out != nullptr ? &r_class : nullptr,
+                   r_txt_printer.get())) {
+    return false;
   }
 
   if (out != nullptr) {
-    AppendJavaDocAnnotations(options_.javadoc_annotations, r_class.GetCommentBuilder());
+    const bool is_public = (options_.types == JavaClassGeneratorOptions::SymbolTypes::kPublic);
     ClassDefinition::WriteJavaFile(&r_class, out_package_name, options_.use_final, !is_public, out);
   }
   return true;
 }
 
+bool JavaClassGenerator::Generate(StringPiece package_name_to_generate,
+                                  const std::vector<std::string>& output_package_names,
+                                  const ClassDefinition::OpenJavaFileFunc& open_file) {
+  if (output_package_names.empty()) {
+    return true;
+  }
+
+  ClassDefinition r_class("R", ClassQualifier::kNone, true);
+  if (!BuildRClass(package_name_to_generate, &r_class, nullptr)) {
+    return false;
+  }
+
+  const bool is_public = (options_.types == JavaClassGeneratorOptions::SymbolTypes::kPublic);
+  if (!ClassDefinition::WriteJavaFiles(&r_class, output_package_names, open_file,
+                                       options_.use_final, !is_public)) {
+    error_ = "failed to open R.java file";
+    return false;
+  }
+  return true;
+}
+
 }  // namespace aapt
@@ -18,11 +18,13 @@
 #define AAPT_JAVA_CLASS_GENERATOR_H
 
 #include <string>
+#include <vector>
 
 #include "ResourceTable.h"
 #include "ResourceValues.h"
 #include "androidfw/Streams.h"
 #include "androidfw/StringPiece.h"
+#include "java/ClassDefinition.h"
 #include "process/IResourceTableConsumer.h"
 #include "process/SymbolTable.h"
 #include "text/Printer.h"
@@ -30,7 +32,6 @@
 namespace aapt {
 
 class AnnotationProcessor;
-class ClassDefinition;
 class MethodDefinition;
 
 // Options for generating onResourcesLoaded callback in R.java.
@@ -76,11 +77,23 @@ class JavaClassGenerator {
                 android::StringPiece output_package_name, android::OutputStream* out,
                 android::OutputStream* out_r_txt = nullptr);
 
+  // Writes the same R.java file for each of `output_package_names`, to the file that open_file
+  // returns for it. The R class is only built and printed once, which makes copies of an R class
+  // in many packages about as cheap as one.
+  bool Generate(android::StringPiece package_name_to_generate,
+                const std::vector<std::string>& output_package_names,
+                const ClassDefinition::OpenJavaFileFunc& open_file);
+
   const std::string& GetError() const;
 
   static std::string TransformToFieldName(android::StringPiece symbol);
 
  private:
+  // Builds the R class into `r_class` if it isn't null, and writes the R.txt lines to
+  // `r_txt_printer` if it isn't null.
+  bool BuildRClass(android::StringPiece package_name_to_generate, ClassDefinition* r_class,
+                   text::Printer* r_txt_printer);
+
   bool SkipSymbol(Visibility::Level state);
   bool SkipSymbol(const std::optional<SymbolTable::Symbol>& symbol);
 
@@ -16,6 +16,7 @@
 
 #include "java/JavaClassGenerator.h"
 
+#include <map>
 #include <string>
 
 #include "io/StringStream.h"
@@ -104,6 +105,43 @@ TEST(JavaClassGeneratorTest, CorrectPackageNameIsUsed) {
   EXPECT_THAT(output, Not(HasSubstr("com_foo$two")));
 }
 
+TEST(JavaClassGeneratorTest, SameClassIsWrittenToSeveralPackages) {
+  std::unique_ptr<ResourceTable> table =
+      test::ResourceTableBuilder()
+          .AddSimple("android:id/one", ResourceId(0x01020000))
+          .AddSimple("android:id/com.foo$two", ResourceId(0x01020001))
+          .Build();
+
+  std::unique_ptr<IAaptContext> context =
+      test::ContextBuilder()
+          .AddSymbolSource(util::make_unique<ResourceTableSymbolSource>(table.get()))
+          .SetNameManglerPolicy(NameManglerPolicy{"android"})
+          .Build();
+  JavaClassGenerator generator(context.get(), table.get(), {});
+
+  std::string expected;
+  {
+    StringOutputStream out(&expected);
+    ASSERT_TRUE(generator.Generate("android", "com.foo", &out));
+  }
+
+  std::map<std::string, std::string> outputs;
+  auto open_file = [&](StringPiece package) -> std::unique_ptr<android::OutputStream> {
+    return util::make_unique<StringOutputStream>(&outputs[std::string(package)]);
+  };
+  ASSERT_TRUE(generator.Generate("android", {"com.foo", "com.bar"}, open_file));
+
+  ASSERT_EQ(2u, outputs.size());
+  EXPECT_EQ(expected, outputs["com.foo"]);
+  EXPECT_THAT(outputs["com.bar"], HasSubstr("package com.bar;"));
+  EXPECT_THAT(outputs["com.bar"], HasSubstr("public static final int one=0x01020000;"));
+
+  auto fail_to_open = [](StringPiece) -> std::unique_ptr<android::OutputStream> {
+    return {};
+  };
+  EXPECT_FALSE(generator.Generate("android", {"com.foo"}, fail_to_open));
+}
+
 TEST(JavaClassGeneratorTest, StyleableAttributesWithDifferentPackageName) {
   std::unique_ptr<ResourceTable> table =
       test::ResourceTableBuilder()
@@ -19,6 +19,7 @@
 #include <algorithm>
 
 #include "ResourceTable.h"
+#include "trace/TraceBuffer.h"
 
 using android::ConfigDescription;
 
@@ -48,6 +49,7 @@ static bool KeepResourceEntry(const std::unique_ptr<ResourceEntry>& entry) {
 }
 
 bool FlagNotEnabledResourceRemover::Consume(IAaptContext* context, ResourceTable* table) {
+  TRACE_NAME("FlagNotEnabledResourceRemover::Consume");
   for (auto& pkg : table->packages) {
     for (auto& type : pkg->types) {
       const auto end_iter = type->entries.end();
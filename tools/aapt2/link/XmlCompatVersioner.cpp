@@ -101,6 +101,63 @@ void XmlCompatVersioner::ProcessRule(const xml::Element& src_el, const xml::Attr
 XmlCompatVersioner::XmlCompatVersioner(const Rules* rules) : rules_(rules) {
 }
 
+// Adjusts the API range so that it falls after the document and after minSdkVersion.
+static util::Range<ApiVersion> AdjustApiRange(IAaptContext* context, const xml::XmlResource& doc,
+                                              util::Range<ApiVersion> api_range) {
+  api_range.start = std::max(api_range.start, context->GetMinSdkVersion());
+  api_range.start = std::max(api_range.start, static_cast<ApiVersion>(doc.file.config.sdkVersion));
+  return api_range;
+}
+
+namespace {
+
+// Looks for a compiled attribute added after an API version.
+class NewerAttributeFinder : public xml::ConstVisitor {
+ public:
+  using xml::ConstVisitor::Visit;
+
+  explicit NewerAttributeFinder(ApiVersion api) : api_(api) {
+  }
+
+  void Visit(const xml::Element* el) override {
+    for (const xml::Attribute& attr : el->attributes) {
+      if (!attr.compiled_attribute) {
+        continue;
+      }
+      const std::optional<ResourceId>& id = attr.compiled_attribute.value().id;
+      if (!id || FindAttributeSdkLevel(id.value()) > api_) {
+        found_ = true;
+        return;
+      }
+    }
+    if (!found_) {
+      VisitChildren(el);
+    }
+  }
+
+  bool Found() const {
+    return found_;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(NewerAttributeFinder);
+
+  ApiVersion api_;
+  bool found_ = false;
+};
+
+}  // namespace
+
+bool XmlCompatVersioner::NeedsVersioning(IAaptContext* context, const xml::XmlResource& doc,
+                                         util::Range<ApiVersion> api_range) const {
+  if (doc.root == nullptr) {
+    return true;
+  }
+  NewerAttributeFinder finder(AdjustApiRange(context, doc, api_range).start);
+  doc.root->Accept(&finder);
+  return finder.Found();
+}
+
 std::unique_ptr<xml::XmlResource> XmlCompatVersioner::ProcessDoc(
     ApiVersion target_api, ApiVersion max_api, xml::XmlResource* doc,
     std::set<ApiVersion>* out_apis_referenced) {
@@ -132,9 +189,7 @@ std::unique_ptr<xml::XmlResource> XmlCompatVersioner::ProcessDoc(
 
 std::vector<std::unique_ptr<xml::XmlResource>> XmlCompatVersioner::Process(
     IAaptContext* context, xml::XmlResource* doc, util::Range<ApiVersion> api_range) {
-  // Adjust the API range so that it falls after this document and after minSdkVersion.
-  api_range.start = std::max(api_range.start, context->GetMinSdkVersion());
-  api_range.start = std::max(api_range.start, static_cast<ApiVersion>(doc->file.config.sdkVersion));
+  api_range = AdjustApiRange(context, *doc, api_range);
 
   std::vector<std::unique_ptr<xml::XmlResource>> versioned_docs;
   std::set<ApiVersion> apis_referenced;
@@ -61,6 +61,11 @@ class XmlCompatVersioner {
                                                          xml::XmlResource* doc,
                                                          util::Range<ApiVersion> api_range);
 
+  // Returns false if Process() would only return a copy of the document, because none of its
+  // attributes is newer than the API range, in which case the document can be used as it is.
+  bool NeedsVersioning(IAaptContext* context, const xml::XmlResource& doc,
+                       util::Range<ApiVersion> api_range) const;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(XmlCompatVersioner);
 
@@ -16,8 +16,11 @@
 
 #include "link/XmlCompatVersioner.h"
 
+#include "Debug.h"
 #include "Linkers.h"
+#include "io/StringStream.h"
 #include "test/Test.h"
+#include "text/Printer.h"
 
 using ::aapt::test::ValueEq;
 using ::testing::Eq;
@@ -113,6 +116,69 @@ TEST_F(XmlCompatVersionerTest, NoRulesOnlyStripsAndCopies) {
   EXPECT_THAT(el->FindAttribute({}, "foo"), NotNull());
 }
 
+TEST_F(XmlCompatVersionerTest, NeedsVersioningOnlyForAttributesNewerThanRange) {
+  auto doc = test::BuildXmlDomForPackageName(context_.get(), R"(
+      <View xmlns:android="http://schemas.android.com/apk/res/android"
+          xmlns:app="http://schemas.android.com/apk/res-auto"
+          android:paddingLeft="16dp"
+          app:foo="16dp">
+        <View android:paddingHorizontal="24dp" />
+      </View>)");
+
+  XmlReferenceLinker linker(nullptr);
+  ASSERT_TRUE(linker.Consume(context_.get(), doc.get()));
+
+  XmlCompatVersioner::Rules rules;
+  XmlCompatVersioner versioner(&rules);
+  EXPECT_TRUE(versioner.NeedsVersioning(context_.get(), *doc, {SDK_GINGERBREAD, SDK_O + 1}));
+  EXPECT_FALSE(versioner.NeedsVersioning(context_.get(), *doc, {SDK_O, SDK_O + 1}));
+
+  auto old_doc = test::BuildXmlDomForPackageName(context_.get(), R"(
+      <View xmlns:android="http://schemas.android.com/apk/res/android"
+          android:paddingLeft="16dp"
+          android:paddingRight="16dp"/>)");
+  ASSERT_TRUE(linker.Consume(context_.get(), old_doc.get()));
+  EXPECT_FALSE(versioner.NeedsVersioning(context_.get(), *old_doc, {SDK_GINGERBREAD, SDK_O + 1}));
+}
+
+static std::string DumpXml(const xml::XmlResource& doc) {
+  std::string out_str;
+  io::StringOutputStream out(&out_str);
+  text::Printer printer(&out);
+  Debug::DumpXml(doc, &printer);
+  out.Flush();
+  return out_str;
+}
+
+// The linker skips Process() for the documents that don't need versioning, and flattens the
+// document itself instead of the single copy that Process() would return.
+TEST_F(XmlCompatVersionerTest, DocumentNotNeedingVersioningIsProcessedIntoAnEqualCopy) {
+  auto doc = test::BuildXmlDomForPackageName(context_.get(), R"(
+      <View xmlns:android="http://schemas.android.com/apk/res/android"
+          xmlns:app="http://schemas.android.com/apk/res-auto"
+          android:paddingLeft="16dp"
+          android:paddingStart="16dp"
+          app:foo="16dp"
+          bar="text">
+        <View android:paddingRight="24dp" />
+      </View>)");
+  doc->file.config.sdkVersion = SDK_JELLY_BEAN_MR1;
+
+  XmlReferenceLinker linker(nullptr);
+  ASSERT_TRUE(linker.Consume(context_.get(), doc.get()));
+
+  XmlCompatVersioner::Rules rules;
+  XmlCompatVersioner versioner(&rules);
+  const util::Range<ApiVersion> api_range{SDK_JELLY_BEAN_MR1, SDK_O + 1};
+  ASSERT_FALSE(versioner.NeedsVersioning(context_.get(), *doc, api_range));
+
+  std::vector<std::unique_ptr<xml::XmlResource>> versioned_docs =
+      versioner.Process(context_.get(), doc.get(), api_range);
+  ASSERT_THAT(versioned_docs, SizeIs(1u));
+  EXPECT_THAT(versioned_docs[0]->file.config, Eq(doc->file.config));
+  EXPECT_THAT(DumpXml(*versioned_docs[0]), Eq(DumpXml(*doc)));
+}
+
 TEST_F(XmlCompatVersionerTest, SingleRule) {
   auto doc = test::BuildXmlDomForPackageName(context_.get(), R"(
       <View xmlns:android="http://schemas.android.com/apk/res/android"
@@ -17,12 +17,16 @@
 #include "MultiApkGenerator.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <regex>
 #include <string>
+#include <thread>
 
 #include "androidfw/ConfigDescription.h"
 #include "androidfw/StringPiece.h"
 
+#include "Diagnostics.h"
 #include "LoadedApk.h"
 #include "ResourceUtils.h"
 #include "ValueVisitor.h"
@@ -35,6 +39,7 @@
 #include "optimize/VersionCollapser.h"
 #include "process/IResourceTableConsumer.h"
 #include "split/TableSplitter.h"
+#include "trace/TraceBuffer.h"
 #include "util/Files.h"
 #include "xml/XmlDom.h"
 #include "xml/XmlUtil.h"
@@ -54,7 +59,8 @@ using ::android::StringPiece;
 class ContextWrapper : public IAaptContext {
  public:
   explicit ContextWrapper(IAaptContext* context)
-      : context_(context), min_sdk_(context_->GetMinSdkVersion()) {
+      : context_(context), diag_(context_->GetDiagnostics()),
+        min_sdk_(context_->GetMinSdkVersion()) {
   }
 
   PackageType GetPackageType() override {
@@ -69,7 +75,11 @@ class ContextWrapper : public IAaptContext {
     if (source_diag_) {
       return source_diag_.get();
     }
-    return context_->GetDiagnostics();
+    return diag_;
+  }
+
+  void SetDiagnostics(android::IDiagnostics* diag) {
+    diag_ = diag;
   }
 
   const std::string& GetCompilationPackage() override {
@@ -97,8 +107,8 @@ class ContextWrapper : public IAaptContext {
   }
 
   void SetSource(const std::string& source) {
-    source_diag_ = util::make_unique<android::SourcePathDiagnostics>(android::Source{source},
-                                                                     context_->GetDiagnostics());
+    source_diag_ =
+        util::make_unique<android::SourcePathDiagnostics>(android::Source{source}, diag_);
   }
 
   const std::set<std::string>& GetSplitNameDependencies() override {
@@ -107,6 +117,7 @@ class ContextWrapper : public IAaptContext {
 
  private:
   IAaptContext* context_;
+  android::IDiagnostics* diag_;
   std::unique_ptr<android::SourcePathDiagnostics> source_diag_;
 
   int min_sdk_ = -1;
@@ -131,13 +142,8 @@ bool MultiApkGenerator::FromBaseApk(const MultiApkGeneratorOptions& options) {
   std::unordered_set<std::string> filtered_artifacts;
   std::unordered_set<std::string> kept_artifacts;
 
-  // For now, just write out the stripped APK since ABI splitting doesn't modify anything else.
+  std::vector<const OutputArtifact*> artifacts;
   for (const OutputArtifact& artifact : options.apk_artifacts) {
-    FilterChain filters;
-
-    ContextWrapper wrapped_context{context_};
-    wrapped_context.SetSource(artifact.name);
-
     if (!options.kept_artifacts.empty()) {
       const auto& it = artifacts_to_keep.find(artifact.name);
       if (it == artifacts_to_keep.end()) {
@@ -152,42 +158,18 @@ bool MultiApkGenerator::FromBaseApk(const MultiApkGeneratorOptions& options) {
         kept_artifacts.insert(artifact.name);
       }
     }
+    artifacts.push_back(&artifact);
+  }
 
-    std::unique_ptr<ResourceTable> table =
-        FilterTable(context_, artifact, *apk_->GetResourceTable(), &filters);
-    if (!table) {
-      return false;
-    }
-
-    android::IDiagnostics* diag = wrapped_context.GetDiagnostics();
-
-    std::unique_ptr<XmlResource> manifest;
-    if (!UpdateManifest(artifact, &manifest, diag)) {
-      diag->Error(android::DiagMessage()
-                  << "could not update AndroidManifest.xml for output artifact");
+  if (options.jobs > 1 && artifacts.size() > 1) {
+    if (!GenerateArtifactsInParallel(artifacts, options)) {
       return false;
     }
-
-    std::string out = options.out_dir;
-    if (!file::mkdirs(out)) {
-      diag->Warn(android::DiagMessage() << "could not create out dir: " << out);
-    }
-    file::AppendPath(&out, artifact.name);
-
-    if (context_->IsVerbose()) {
-      diag->Note(android::DiagMessage() << "Generating split: " << out);
-    }
-
-    std::unique_ptr<IArchiveWriter> writer = CreateZipFileArchiveWriter(diag, out);
-
-    if (context_->IsVerbose()) {
-      diag->Note(android::DiagMessage() << "Writing output: " << out);
-    }
-
-    filters.AddFilter(util::make_unique<SignatureFilter>());
-    if (!apk_->WriteToArchive(&wrapped_context, table.get(), options.table_flattener_options,
-                              &filters, writer.get(), manifest.get())) {
-      return false;
+  } else {
+    for (const OutputArtifact* artifact : artifacts) {
+      if (!GenerateArtifact(*artifact, options, context_)) {
+        return false;
+      }
     }
   }
 
@@ -221,6 +203,120 @@ bool MultiApkGenerator::FromBaseApk(const MultiApkGeneratorOptions& options) {
   return true;
 }
 
+bool MultiApkGenerator::GenerateArtifact(const OutputArtifact& artifact,
+                                         const MultiApkGeneratorOptions& options,
+                                         IAaptContext* context) {
+  TRACE_NAME("MultiApkGenerator::GenerateArtifact " + artifact.name);
+  FilterChain filters;
+
+  ContextWrapper wrapped_context{context};
+  wrapped_context.SetSource(artifact.name);
+
+  // For now, just write out the stripped APK since ABI splitting doesn't modify anything else.
+  std::unique_ptr<ResourceTable> table =
+      FilterTable(context, artifact, *apk_->GetResourceTable(), &filters);
+  if (!table) {
+    return false;
+  }
+
+  android::IDiagnostics* diag = wrapped_context.GetDiagnostics();
+
+  std::unique_ptr<XmlResource> manifest;
+  if (!UpdateManifest(artifact, &manifest, diag)) {
+    diag->Error(android::DiagMessage()
+                << "could not update AndroidManifest.xml for output artifact");
+    return false;
+  }
+
+  std::string out = options.out_dir;
+  if (!file::mkdirs(out)) {
+    diag->Warn(android::DiagMessage() << "could not create out dir: " << out);
+  }
+  file::AppendPath(&out, artifact.name);
+
+  if (context->IsVerbose()) {
+    diag->Note(android::DiagMessage() << "Generating split: " << out);
+  }
+
+  std::unique_ptr<IArchiveWriter> writer = CreateZipFileArchiveWriter(diag, out);
+
+  if (context->IsVerbose()) {
+    diag->Note(android::DiagMessage() << "Writing output: " << out);
+  }
+
+  filters.AddFilter(util::make_unique<SignatureFilter>());
+  return apk_->WriteToArchive(&wrapped_context, table.get(), options.table_flattener_options,
+                              &filters, writer.get(), manifest.get());
+}
+
+bool MultiApkGenerator::GenerateArtifactsInParallel(
+    const std::vector<const OutputArtifact*>& artifacts, const MultiApkGeneratorOptions& options) {
+  struct Result {
+    BufferedDiagnostics diagnostics;
+    bool generated = false;
+    bool skipped = false;
+    bool done = false;
+  };
+  std::vector<Result> results(artifacts.size());
+  std::mutex results_lock;
+  std::condition_variable result_done;
+  std::atomic<size_t> next_artifact = 0;
+  std::atomic<bool> failed = false;
+
+  // Each artifact holds a copy of the table while it is generated, so there are at most as many
+  // copies as jobs. Once an artifact fails, the ones after it are skipped, as they would be when
+  // generating them one after the other.
+  const bool verbose = context_->GetDiagnostics()->IsVerbose();
+  auto generate_artifacts = [&]() {
+    for (size_t i = next_artifact++; i < artifacts.size(); i = next_artifact++) {
+      Result& result = results[i];
+      if (failed) {
+        result.skipped = true;
+      } else {
+        result.diagnostics.SetVerbose(verbose);
+        ContextWrapper job_context{context_};
+        job_context.SetDiagnostics(&result.diagnostics);
+        result.generated = GenerateArtifact(*artifacts[i], options, &job_context);
+        if (!result.generated) {
+          failed = true;
+        }
+      }
+
+      std::lock_guard guard(results_lock);
+      result.done = true;
+      result_done.notify_all();
+    }
+  };
+
+  const size_t thread_count = std::min<size_t>(options.jobs, artifacts.size());
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; i++) {
+    threads.emplace_back(generate_artifacts);
+  }
+
+  bool error = false;
+  for (Result& result : results) {
+    {
+      std::unique_lock guard(results_lock);
+      result_done.wait(guard, [&result] { return result.done; });
+    }
+    if (result.skipped) {
+      break;
+    }
+    result.diagnostics.FlushTo(context_->GetDiagnostics());
+    if (!result.generated) {
+      error = true;
+      break;
+    }
+  }
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return !error;
+}
+
 std::unique_ptr<ResourceTable> MultiApkGenerator::FilterTable(IAaptContext* context,
                                                               const OutputArtifact& artifact,
                                                               const ResourceTable& old_table,
@@ -251,7 +347,11 @@ std::unique_ptr<ResourceTable> MultiApkGenerator::FilterTable(IAaptContext* cont
     wrapped_context.SetMinSdkVersion(artifact.android_sdk.value().min_sdk_version);
   }
 
-  std::unique_ptr<ResourceTable> table = old_table.Clone();
+  std::unique_ptr<ResourceTable> table;
+  {
+    std::lock_guard<std::mutex> lock(clone_lock_);
+    table = old_table.Clone();
+  }
 
   VersionCollapser collapser;
   if (!collapser.Consume(&wrapped_context, table.get())) {
@@ -273,7 +373,10 @@ bool MultiApkGenerator::UpdateManifest(const OutputArtifact& artifact,
     return false;
   }
 
-  *updated_manifest = apk_manifest->Clone();
+  {
+    std::lock_guard<std::mutex> lock(clone_lock_);
+    *updated_manifest = apk_manifest->Clone();
+  }
   XmlResource* manifest = updated_manifest->get();
 
   // Make sure the first element is <manifest> with package attribute.
@@ -18,6 +18,7 @@
 #define AAPT2_APKSPLITTER_H
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -34,6 +35,8 @@ struct MultiApkGeneratorOptions {
   std::vector<configuration::OutputArtifact> apk_artifacts;
   TableFlattenerOptions table_flattener_options;
   std::unordered_set<std::string> kept_artifacts;
+  // The number of artifacts to generate at the same time.
+  int jobs = 1;
 };
 
 /**
@@ -61,6 +64,16 @@ class MultiApkGenerator {
     return context_->GetDiagnostics();
   }
 
+  // Filters the table, updates the manifest and writes the APK of one artifact.
+  bool GenerateArtifact(const configuration::OutputArtifact& artifact,
+                        const MultiApkGeneratorOptions& options, IAaptContext* context);
+
+  // Generates the artifacts on options.jobs threads. The diagnostics of each artifact are
+  // buffered, then logged in the order of the artifacts.
+  bool GenerateArtifactsInParallel(
+      const std::vector<const configuration::OutputArtifact*>& artifacts,
+      const MultiApkGeneratorOptions& options);
+
   bool UpdateManifest(const configuration::OutputArtifact& artifact,
                       std::unique_ptr<xml::XmlResource>* updated_manifest,
                       android::IDiagnostics* diag);
@@ -72,6 +85,10 @@ class MultiApkGenerator {
 
   LoadedApk* apk_;
   IAaptContext* context_;
+
+  // Held while cloning the table and the manifest of the base APK, which copies the references
+  // to their string pools.
+  std::mutex clone_lock_;
 };
 
 }  // namespace aapt
@@ -25,6 +25,7 @@
 #include "ResourceTable.h"
 #include "ValueVisitor.h"
 #include "androidfw/StringPiece.h"
+#include "trace/TraceBuffer.h"
 #include "util/Util.h"
 
 static const char base64_chars[] =
@@ -214,6 +215,7 @@ static bool HandleCollapseKeyStringPool(
 }
 
 bool Obfuscator::Consume(IAaptContext* context, ResourceTable* table) {
+  TRACE_NAME("Obfuscator::Consume");
   HandleCollapseKeyStringPool(table, options_.collapse_key_stringpool,
                               options_.name_collapse_exemptions, options_.id_resource_map);
   if (shorten_resource_paths_) {
@@ -17,6 +17,7 @@
 #include "optimize/ResourceDeduper.h"
 
 #include <algorithm>
+#include <unordered_map>
 
 #include "DominatorTree.h"
 #include "ResourceTable.h"
@@ -56,7 +57,7 @@ class DominatedKeyValueRemover : public DominatorTree::BottomUpVisitor {
     if (!node_value || !parent_value) {
       return;
     }
-    if (!node_value->value->Equals(parent_value->value.get())) {
+    if (!ValuesEqual(node_value->value.get(), parent_value->value.get())) {
       return;
     }
 
@@ -85,7 +86,7 @@ class DominatedKeyValueRemover : public DominatorTree::BottomUpVisitor {
         continue;
       }
       if (node_configuration.IsCompatibleWith(sibling_value->config) &&
-          !node_value->value->Equals(sibling_value->value.get())) {
+          !ValuesEqual(node_value->value.get(), sibling_value->value.get())) {
         // The configurations are compatible, but the value is
         // different, so we can't remove this value.
         return;
@@ -98,14 +99,30 @@ class DominatedKeyValueRemover : public DominatorTree::BottomUpVisitor {
       context_->GetDiagnostics()->Note(android::DiagMessage(parent_value->value->GetSource())
                                        << "dominated here");
     }
+    hashes_.erase(node_value->value.get());
     node_value->value = {};
   }
 
  private:
   DISALLOW_COPY_AND_ASSIGN(DominatedKeyValueRemover);
 
+  // Compares the hashes of the values first, which are only computed once per value. Most of the
+  // values of an entry with many configurations, such as the translations of a string, differ.
+  bool ValuesEqual(const Value* a, const Value* b) {
+    return GetHash(a) == GetHash(b) && a->Equals(b);
+  }
+
+  size_t GetHash(const Value* value) {
+    auto [iter, inserted] = hashes_.try_emplace(value, 0);
+    if (inserted) {
+      iter->second = value->Hash();
+    }
+    return iter->second;
+  }
+
   IAaptContext* context_;
   ResourceEntry* entry_;
+  std::unordered_map<const Value*, size_t> hashes_;
 };
 
 static void DedupeEntry(IAaptContext* context, ResourceEntry* entry) {
@@ -16,6 +16,8 @@
 
 #include "process/SymbolTable.h"
 
+#include <sys/stat.h>
+
 #include <iostream>
 
 #include "android-base/logging.h"
@@ -40,15 +42,21 @@ using ::android::StringPiece16;
 
 namespace aapt {
 
+// The number of symbols kept by name and by ID. The references of all the XML files of a link go
+// through the same table, and most of them are to a few thousand resources, such as the attributes
+// of the framework and the app's own strings and dimensions, which a small cache keeps evicting.
+constexpr size_t kSymbolCacheSize = 4096;
+
 SymbolTable::SymbolTable(NameMangler* mangler)
     : mangler_(mangler),
       delegate_(util::make_unique<DefaultSymbolTableDelegate>()),
-      cache_(200),
-      id_cache_(200) {
+      cache_(kSymbolCacheSize),
+      id_cache_(kSymbolCacheSize) {
 }
 
 void SymbolTable::SetDelegate(std::unique_ptr<ISymbolTableDelegate> delegate) {
   CHECK(delegate != nullptr) << "can't set a nullptr delegate";
+  std::lock_guard<std::mutex> guard(lock_);
   delegate_ = std::move(delegate);
 
   // Clear the cache in case this delegate changes the order of lookup.
@@ -56,6 +64,7 @@ void SymbolTable::SetDelegate(std::unique_ptr<ISymbolTableDelegate> delegate) {
 }
 
 void SymbolTable::AppendSource(std::unique_ptr<ISymbolSource> source) {
+  std::lock_guard<std::mutex> guard(lock_);
   sources_.push_back(std::move(source));
 
   // We do not clear the cache, because sources earlier in the list take
@@ -63,6 +72,7 @@ void SymbolTable::AppendSource(std::unique_ptr<ISymbolSource> source) {
 }
 
 void SymbolTable::PrependSource(std::unique_ptr<ISymbolSource> source) {
+  std::lock_guard<std::mutex> guard(lock_);
   sources_.insert(sources_.begin(), std::move(source));
 
   // We must clear the cache in case we did a lookup before adding this
@@ -70,7 +80,18 @@ void SymbolTable::PrependSource(std::unique_ptr<ISymbolSource> source) {
   cache_.clear();
 }
 
+const SymbolTable::Symbol* SymbolTable::Pin(const std::shared_ptr<Symbol>& symbol) {
+  pinned_[std::this_thread::get_id()] = symbol;
+  return symbol.get();
+}
+
+void SymbolTable::ReleasePinnedSymbols() {
+  std::lock_guard<std::mutex> guard(lock_);
+  pinned_.clear();
+}
+
 const SymbolTable::Symbol* SymbolTable::FindByName(const ResourceName& name) {
+  std::lock_guard<std::mutex> guard(lock_);
   const ResourceName* name_with_package = &name;
 
   // Fill in the package name if necessary.
@@ -84,7 +105,7 @@ const SymbolTable::Symbol* SymbolTable::FindByName(const ResourceName& name) {
 
   // We store the name unmangled in the cache, so look it up as-is.
   if (const std::shared_ptr<Symbol>& s = cache_.get(*name_with_package)) {
-    return s.get();
+    return Pin(s);
   }
 
   // The name was not found in the cache. Mangle it (if necessary) and find it in our sources.
@@ -116,12 +137,13 @@ const SymbolTable::Symbol* SymbolTable::FindByName(const ResourceName& name) {
 
   // Returns the raw pointer. Callers are not expected to hold on to this
   // between calls to Find*.
-  return shared_symbol.get();
+  return Pin(shared_symbol);
 }
 
 const SymbolTable::Symbol* SymbolTable::FindById(const ResourceId& id) {
+  std::lock_guard<std::mutex> guard(lock_);
   if (const std::shared_ptr<Symbol>& s = id_cache_.get(id)) {
-    return s.get();
+    return Pin(s);
   }
 
   // We did not find it in the cache, so look through the sources.
@@ -137,7 +159,7 @@ const SymbolTable::Symbol* SymbolTable::FindById(const ResourceId& id) {
 
   // Returns the raw pointer. Callers are not expected to hold on to this
   // between calls to Find*.
-  return shared_symbol.get();
+  return Pin(shared_symbol);
 }
 
 const SymbolTable::Symbol* SymbolTable::FindByReference(const Reference& ref) {
@@ -218,9 +240,75 @@ std::unique_ptr<SymbolTable::Symbol> ResourceTableSymbolSource::FindByName(
   return symbol;
 }
 
+ApkAssetsCache& ApkAssetsCache::Get() {
+  static ApkAssetsCache cache;
+  return cache;
+}
+
+void ApkAssetsCache::SetEnabled(bool enabled) {
+  std::lock_guard<std::mutex> lock(lock_);
+  enabled_ = enabled;
+  if (!enabled_) {
+    entries_.clear();
+  }
+}
+
+std::optional<ApkAssetsCache::FileIdentity> ApkAssetsCache::GetFileIdentity(
+    const std::string& path) {
+  struct stat sb;
+  if (stat(path.c_str(), &sb) != 0) {
+    return {};
+  }
+  FileIdentity identity;
+  identity.device = sb.st_dev;
+  identity.inode = sb.st_ino;
+  identity.size = sb.st_size;
+  identity.modification_time = android::getModDate(sb);
+  return identity;
+}
+
+AssetManager2::ApkAssetsPtr ApkAssetsCache::Load(const std::string& path) {
+  std::optional<FileIdentity> identity = GetFileIdentity(path);
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (enabled_) {
+      auto iter = entries_.find(path);
+      if (iter != entries_.end()) {
+        if (identity && iter->second.identity == *identity) {
+          TRACE_NAME("ApkAssetsCache hit");
+          return iter->second.apk;
+        }
+        entries_.erase(iter);
+      }
+    }
+  }
+
+  // Loading takes long, don't keep the other threads from the APKs that are already cached.
+  AssetManager2::ApkAssetsPtr apk = ApkAssets::Load(path);
+  if (apk != nullptr && identity) {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (enabled_) {
+      entries_[path] = Entry{*identity, apk};
+    }
+  }
+  return apk;
+}
+
+void ApkAssetsCache::EvictStale() {
+  std::lock_guard<std::mutex> lock(lock_);
+  for (auto iter = entries_.begin(); iter != entries_.end();) {
+    std::optional<FileIdentity> identity = GetFileIdentity(iter->first);
+    if (!identity || !(iter->second.identity == *identity)) {
+      iter = entries_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
 bool AssetManagerSymbolSource::AddAssetPath(StringPiece path) {
   TRACE_CALL();
-  if (auto apk = ApkAssets::Load(path.data(), nullptr)) {
+  if (auto apk = ApkAssetsCache::Get().Load(std::string(path))) {
     apk_assets_.push_back(std::move(apk));
     asset_manager_.SetApkAssets(apk_assets_);
     return true;
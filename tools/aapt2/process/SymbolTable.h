@@ -19,11 +19,17 @@
 
 #include <algorithm>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "android-base/macros.h"
 #include "androidfw/Asset.h"
 #include "androidfw/AssetManager2.h"
+#include "androidfw/misc.h"
 #include "utils/JenkinsHash.h"
 #include "utils/LruCache.h"
 
@@ -51,6 +57,7 @@ class ISymbolSource;
 class ISymbolTableDelegate;
 class NameMangler;
 
+// Lookups may be done from several threads at once.
 class SymbolTable {
  public:
   struct Symbol {
@@ -86,8 +93,9 @@ class SymbolTable {
   // cause the existing cache to be cleared.
   void PrependSource(std::unique_ptr<ISymbolSource> source);
 
-  // NOTE: Never hold on to the result between calls to FindByXXX. The
-  // results are stored in a cache which may evict entries on subsequent calls.
+  // NOTE: Never hold on to the result between calls to FindByXXX on the same
+  // thread. The results are stored in a cache which may evict entries on
+  // subsequent calls.
   const Symbol* FindByName(const ResourceName& name);
 
   // NOTE: Never hold on to the result between calls to FindByXXX. The
@@ -100,7 +108,15 @@ class SymbolTable {
   // results are stored in a cache which may evict entries on subsequent calls.
   const Symbol* FindByReference(const Reference& ref);
 
+  // Drops the symbols kept alive for the threads that looked them up. Only call this once no
+  // thread holds on to a result anymore, e.g. after the threads looking up symbols are done.
+  void ReleasePinnedSymbols();
+
  private:
+  // Keeps the last symbol found by the calling thread alive, in case another
+  // thread evicts it from the cache.
+  const Symbol* Pin(const std::shared_ptr<Symbol>& symbol);
+
   NameMangler* mangler_;
   std::unique_ptr<ISymbolTableDelegate> delegate_;
   std::vector<std::unique_ptr<ISymbolSource>> sources_;
@@ -110,6 +126,10 @@ class SymbolTable {
   android::LruCache<ResourceName, std::shared_ptr<Symbol>> cache_;
   android::LruCache<ResourceId, std::shared_ptr<Symbol>> id_cache_;
 
+  // Guards the caches and the sources, which are not thread-safe.
+  std::mutex lock_;
+  std::unordered_map<std::thread::id, std::shared_ptr<Symbol>> pinned_;
+
   DISALLOW_COPY_AND_ASSIGN(SymbolTable);
 };
 
@@ -188,6 +208,55 @@ class ResourceTableSymbolSource : public ISymbolSource {
   DISALLOW_COPY_AND_ASSIGN(ResourceTableSymbolSource);
 };
 
+// Keeps the APKs that AssetManagerSymbolSource loads alive once it is destroyed, so that a long
+// running process, such as the daemon, links against the same framework and library includes
+// without loading them again. An APK is reloaded once the file at its path is replaced or modified.
+// May be used from many threads.
+class ApkAssetsCache {
+ public:
+  static ApkAssetsCache& Get();
+
+  // Disabled by default, in which case every load reads the APK.
+  void SetEnabled(bool enabled);
+
+  android::AssetManager2::ApkAssetsPtr Load(const std::string& path);
+
+  // Drops the APKs whose file was removed, replaced or modified since they were loaded, so that
+  // the cache doesn't keep them alive until their path is loaded again.
+  void EvictStale();
+
+ private:
+  // Identifies the contents of a file without reading it.
+  struct FileIdentity {
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    int64_t size = 0;
+    // With nanoseconds where the platform has them, so that a rewrite within the same second as
+    // the previous one is still noticed.
+    android::ModDate modification_time = {};
+
+    bool operator==(const FileIdentity& other) const {
+      return device == other.device && inode == other.inode && size == other.size &&
+             modification_time == other.modification_time;
+    }
+  };
+
+  struct Entry {
+    FileIdentity identity;
+    android::AssetManager2::ApkAssetsPtr apk;
+  };
+
+  ApkAssetsCache() = default;
+
+  static std::optional<FileIdentity> GetFileIdentity(const std::string& path);
+
+  std::mutex lock_;
+  bool enabled_ = false;
+  std::unordered_map<std::string, Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApkAssetsCache);
+};
+
 class AssetManagerSymbolSource : public ISymbolSource {
  public:
   AssetManagerSymbolSource() = default;
@@ -134,4 +134,60 @@ TEST_F(SymbolTableTestFixture, FindByNameWhenSymbolIsMangledInResTable) {
   EXPECT_THAT(symbol_table.FindByName(test::ParseNameOrDie("com.android.other:id/foo")), IsNull());
 }
 
+TEST_F(SymbolTableTestFixture, ApkAssetsCacheReloadsModifiedApks) {
+  StdErrDiagnostics diag;
+  const std::string compiled_files_dir = GetTestPath("compiled");
+  ASSERT_TRUE(CompileFile(GetTestPath("res/values/values.xml"),
+      R"(<?xml version="1.0" encoding="utf-8"?>
+         <resources>
+             <item type="id" name="foo"/>
+        </resources>)",
+        compiled_files_dir, &diag));
+
+  const std::string out_apk = GetTestPath("out.apk");
+  std::vector<std::string> link_args = {
+      "--manifest", GetDefaultManifest("com.android.app"),
+      "-o", out_apk,
+  };
+  ASSERT_TRUE(Link(link_args, compiled_files_dir, &diag));
+
+  ApkAssetsCache& cache = ApkAssetsCache::Get();
+  cache.SetEnabled(true);
+  auto apk = cache.Load(out_apk);
+  ASSERT_THAT(apk, NotNull());
+  EXPECT_THAT(cache.Load(out_apk), Eq(apk));
+
+  ASSERT_TRUE(CompileFile(GetTestPath("res/values/more_values.xml"),
+      R"(<?xml version="1.0" encoding="utf-8"?>
+         <resources>
+             <item type="id" name="bar"/>
+        </resources>)",
+        compiled_files_dir, &diag));
+  ASSERT_TRUE(Link(link_args, compiled_files_dir, &diag));
+
+  auto reloaded_apk = cache.Load(out_apk);
+  ASSERT_THAT(reloaded_apk, NotNull());
+  EXPECT_THAT(reloaded_apk, Ne(apk));
+  EXPECT_THAT(cache.Load(out_apk), Eq(reloaded_apk));
+
+  // Evicting keeps the APKs that are still up to date.
+  cache.EvictStale();
+  EXPECT_THAT(cache.Load(out_apk), Eq(reloaded_apk));
+
+  // It drops the ones whose file changed, without waiting for their path to be loaded again.
+  ASSERT_TRUE(CompileFile(GetTestPath("res/values/even_more_values.xml"),
+      R"(<?xml version="1.0" encoding="utf-8"?>
+         <resources>
+             <item type="id" name="baz"/>
+        </resources>)",
+        compiled_files_dir, &diag));
+  ASSERT_TRUE(Link(link_args, compiled_files_dir, &diag));
+  ASSERT_THAT(reloaded_apk->getStrongCount(), Eq(2));
+  cache.EvictStale();
+  EXPECT_THAT(reloaded_apk->getStrongCount(), Eq(1));
+
+  cache.SetEnabled(false);
+  EXPECT_THAT(cache.Load(out_apk), Ne(reloaded_apk));
+}
+
 }  // namespace aapt
@@ -16,12 +16,20 @@
 
 #include "TraceBuffer.h"
 
+#include <algorithm>
 #include <chrono>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <unistd.h>
 #include <vector>
 
 #include <inttypes.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <time.h>
+#endif
 
 #include "android-base/utf8.h"
 
@@ -34,14 +42,23 @@ namespace {
 
 constexpr char kBegin = 'B';
 constexpr char kEnd = 'E';
+constexpr char kCounter = 'C';
 
 struct TracePoint {
   char type;
   pid_t tid;
   int64_t time;
   std::string tag;
+  // Only kept for the perf report.
+  std::thread::id thread;
+  int64_t cpu_time;
+  int64_t max_rss_kb;
+  // The value of a counter.
+  int64_t value;
 };
 
+// Guards the trace points and the start time, which worker threads record as well.
+std::mutex lock;
 std::vector<TracePoint> traces;
 bool enabled = true;
 constinit std::chrono::steady_clock::time_point startTime = {};
@@ -54,17 +71,102 @@ int64_t GetTime() noexcept {
   return std::chrono::duration_cast<std::chrono::microseconds>(now - startTime).count();
 }
 
-void AddWithTime(std::string tag, char type, int64_t time) noexcept {
-  TracePoint t = {type, getpid(), time, std::move(tag)};
+// The CPU time of the calling thread, in microseconds.
+int64_t GetThreadCpuTime() noexcept {
+#ifndef _WIN32
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    return int64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+  }
+#endif
+  return 0;
+}
+
+// The peak resident set size of the process so far, in kilobytes.
+int64_t GetMaxRssKb() noexcept {
+#ifndef _WIN32
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+  }
+#endif
+  return 0;
+}
+
+void Add(std::string tag, char type, int64_t value = 0) noexcept {
+  const int64_t cpu_time = GetThreadCpuTime();
+  const int64_t max_rss_kb = GetMaxRssKb();
+  std::lock_guard guard(lock);
+  TracePoint t = {type,     getpid(),   GetTime(), std::move(tag), std::this_thread::get_id(),
+                  cpu_time, max_rss_kb, value};
   traces.emplace_back(std::move(t));
 }
 
-void Add(std::string tag, char type) noexcept {
-  AddWithTime(std::move(tag), type, GetTime());
+struct PerfStats {
+  int64_t count = 0;
+  int64_t wall_time = 0;
+  int64_t cpu_time = 0;
+  int64_t max_rss_growth_kb = 0;
+};
+
+void WriteReport(const std::string& path) {
+  std::map<std::string, PerfStats> events;
+  std::map<std::string, int64_t> counters;
+  {
+    std::lock_guard guard(lock);
+    // The begin points that are still open, per thread.
+    std::map<std::thread::id, std::vector<const TracePoint*>> open;
+    for (const TracePoint& trace : traces) {
+      if (trace.type == kCounter) {
+        counters[trace.tag] += trace.value;
+      } else if (trace.type == kBegin) {
+        open[trace.thread].push_back(&trace);
+      } else {
+        std::vector<const TracePoint*>& stack = open[trace.thread];
+        auto begin = std::find_if(stack.rbegin(), stack.rend(),
+                                  [&](const TracePoint* t) { return t->tag == trace.tag; });
+        if (begin == stack.rend()) {
+          continue;
+        }
+        PerfStats& stats = events[trace.tag];
+        stats.count++;
+        stats.wall_time += trace.time - (*begin)->time;
+        stats.cpu_time += trace.cpu_time - (*begin)->cpu_time;
+        stats.max_rss_growth_kb =
+            std::max(stats.max_rss_growth_kb, trace.max_rss_kb - (*begin)->max_rss_kb);
+        stack.erase(std::next(begin).base());
+      }
+    }
+  }
+
+  FILE* f = android::base::utf8::fopen(path.c_str(), "w");
+  if (f == nullptr) {
+    return;
+  }
+  fprintf(f, "%10s %12s %12s %14s  %s\n", "count", "wall ms", "cpu ms", "peak rss +KB", "event");
+  for (const auto& [tag, stats] : events) {
+    fprintf(f, "%10" PRId64 " %12.3f %12.3f %14" PRId64 "  %s\n", stats.count,
+            stats.wall_time / 1000.0, stats.cpu_time / 1000.0, stats.max_rss_growth_kb,
+            tag.c_str());
+  }
+  if (!counters.empty()) {
+    fprintf(f, "\n%10s  %s\n", "total", "counter");
+    for (const auto& [name, total] : counters) {
+      fprintf(f, "%10" PRId64 "  %s\n", total, name.c_str());
+    }
+  }
+  fclose(f);
 }
 
 void Flush(const std::string& basePath) {
   if (basePath.empty()) {
+    // The events were only recorded for the perf report.
+    std::lock_guard guard(lock);
+    traces.clear();
     return;
   }
   BeginTrace(__func__);  // We can't do much here, only record that it happened.
@@ -76,9 +178,19 @@ void Flush(const std::string& basePath) {
     return;
   }
 
+  std::lock_guard guard(lock);
   // Wrap the trace in a JSON array [] to make Chrome/Perfetto UI handle it.
   char delimiter = '[';
   for (const TracePoint& trace : traces) {
+    if (trace.type == kCounter) {
+      fprintf(f,
+              "%c{\"ts\" : \"%" PRIu64
+              "\", \"ph\" : \"%c\", \"tid\" : \"%d\" , \"pid\" : \"%d\", \"name\" : \"%s\", "
+              "\"args\" : { \"value\" : %" PRId64 " } }\n",
+              delimiter, trace.time, trace.type, 0, trace.tid, trace.tag.c_str(), trace.value);
+      delimiter = ',';
+      continue;
+    }
     fprintf(f,
             "%c{\"ts\" : \"%" PRIu64
             "\", \"ph\" : \"%c\", \"tid\" : \"%d\" , \"pid\" : \"%d\", \"name\" : \"%s\" }\n",
@@ -106,6 +218,11 @@ void EndTrace(std::string tag) {
   tracebuffer::Add(std::move(tag), tracebuffer::kEnd);
 }
 
+void TraceCounter(std::string name, int64_t value) {
+  if (!tracebuffer::enabled) return;
+  tracebuffer::Add(std::move(name), tracebuffer::kCounter, value);
+}
+
 bool Trace::enable(bool value) {
   return tracebuffer::enabled = value;
 }
@@ -174,4 +291,15 @@ FlushTrace::~FlushTrace() {
   tracebuffer::Flush(basepath_);
 }
 
+PerfReport::PerfReport(std::string_view path) {
+  if (path.empty()) return;
+  Trace::enable();
+  path_.assign(path);
+}
+
+PerfReport::~PerfReport() {
+  if (path_.empty()) return;
+  tracebuffer::WriteReport(path_);
+}
+
 }  // namespace aapt
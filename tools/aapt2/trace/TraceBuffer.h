@@ -19,6 +19,7 @@
 
 #include <androidfw/StringPiece.h>
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -27,7 +28,7 @@ namespace aapt {
 
 // Record timestamps for beginning and end of a task and generate systrace json fragments.
 // This is an in-process ftrace which has the advantage of being platform independent.
-// These methods are NOT thread-safe since aapt2 is not multi-threaded.
+// Events are recorded under a lock, so that the worker threads of a command can trace as well.
 
 // Convenience RAII object to automatically finish an event when object goes out of scope.
 class Trace {
@@ -47,6 +48,10 @@ private:
 void BeginTrace(std::string tag);
 void EndTrace(std::string tag);
 
+// Records the number of items or bytes that a task processed, such as the entries flattened or
+// the bytes written to an archive. The values of a counter add up in the perf report.
+void TraceCounter(std::string name, int64_t value);
+
 // A main trace is required to flush events to disk. Events are formatted in systrace
 // json format.
 class FlushTrace {
@@ -63,11 +68,25 @@ private:
   std::string tag_;
 };
 
+// Writes a summary of the events traced while it is alive to the file at path: for each tag, the
+// number of times it was traced and its total wall and CPU time and largest peak RSS growth, and
+// the total of each counter. Tags are sorted by name so that the reports of two builds can be
+// diffed. Declare it after the FlushTrace of the command, which would turn tracing off otherwise.
+class PerfReport {
+public:
+ explicit PerfReport(std::string_view path);
+ ~PerfReport();
+
+private:
+  std::string path_;
+};
+
 #define TRACE_CALL() Trace __t(__func__)
 #define TRACE_NAME(tag) Trace __t(tag)
 #define TRACE_NAME_ARGS(tag, args) Trace __t(tag, args)
 
 #define TRACE_FLUSH(basename, tag) FlushTrace __t(basename, tag)
 #define TRACE_FLUSH_ARGS(basename, tag, args) FlushTrace __t(basename, tag, args)
+#define TRACE_PERF_REPORT(path) PerfReport __r(path)
 } // namespace aapt
 #endif //AAPT_TRACEBUFFER_H
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace/TraceBuffer.h"
+
+#include "android-base/file.h"
+#include "test/Test.h"
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+namespace aapt {
+
+TEST(TraceBufferTest, PerfReportAggregatesEventsAndCounters) {
+  TemporaryFile report;
+  {
+    TRACE_FLUSH("", "TraceBufferTest");
+    TRACE_PERF_REPORT(report.path);
+    for (int i = 0; i < 3; i++) {
+      TRACE_NAME("Pass");
+      TraceCounter("Items", 2);
+    }
+    { TRACE_NAME("OtherPass"); }
+  }
+  // The perf report left tracing on.
+  Trace::enable(false);
+
+  std::string contents;
+  ASSERT_TRUE(android::base::ReadFileToString(report.path, &contents));
+  EXPECT_THAT(contents, HasSubstr("peak rss +KB"));
+  EXPECT_THAT(contents, HasSubstr("         3 "));
+  EXPECT_THAT(contents, HasSubstr("  Pass\n"));
+  EXPECT_THAT(contents, HasSubstr("  OtherPass\n"));
+  EXPECT_THAT(contents, HasSubstr("         6  Items\n"));
+  // Tags are sorted by name.
+  EXPECT_LT(contents.find("OtherPass"), contents.find("  Pass"));
+  // The command itself is still running when the report is written.
+  EXPECT_THAT(contents, Not(HasSubstr("TraceBufferTest")));
+}
+
+}  // namespace aapt
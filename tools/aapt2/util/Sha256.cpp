@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/Sha256.h"
+
+#include "android-base/stringprintf.h"
+
+using ::android::StringPiece;
+
+namespace aapt {
+namespace util {
+
+Sha256::Sha256() {
+  SHA256_Init(&ctx_);
+}
+
+void Sha256::AddBytes(const void* data, size_t size) {
+  SHA256_Update(&ctx_, data, size);
+}
+
+void Sha256::Add(uint64_t value) {
+  AddBytes(&value, sizeof(value));
+}
+
+void Sha256::Add(StringPiece str) {
+  Add(static_cast<uint64_t>(str.size()));
+  AddBytes(str.data(), str.size());
+}
+
+void Sha256::Add(const std::optional<std::string>& str) {
+  Add(static_cast<uint64_t>(str.has_value()));
+  if (str) {
+    Add(StringPiece(*str));
+  }
+}
+
+std::string Sha256::Finish() {
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256_Final(digest, &ctx_);
+  std::string hex;
+  hex.reserve(sizeof(digest) * 2);
+  for (uint8_t byte : digest) {
+    android::base::StringAppendF(&hex, "%02x", byte);
+  }
+  return hex;
+}
+
+}  // namespace util
+}  // namespace aapt
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAPT_UTIL_SHA256_H
+#define AAPT_UTIL_SHA256_H
+
+#include <optional>
+#include <string>
+
+#include "android-base/macros.h"
+#include "androidfw/StringPiece.h"
+#include "openssl/sha.h"
+
+namespace aapt {
+namespace util {
+
+// Computes the SHA-256 digest of a sequence of values. Strings are prefixed with their size, so
+// that the fields of a digest can't run into each other.
+class Sha256 {
+ public:
+  Sha256();
+
+  void AddBytes(const void* data, size_t size);
+  void Add(uint64_t value);
+  void Add(android::StringPiece str);
+  void Add(const std::string& str) {
+    Add(android::StringPiece(str));
+  }
+  void Add(const std::optional<std::string>& str);
+
+  // Returns the digest as lowercase hex.
+  std::string Finish();
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Sha256);
+
+  SHA256_CTX ctx_;
+};
+
+}  // namespace util
+}  // namespace aapt
+
+#endif  // AAPT_UTIL_SHA256_H
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/Sha256.h"
+
+#include "test/Test.h"
+
+namespace aapt {
+namespace util {
+
+TEST(Sha256Test, DigestOfBytes) {
+  Sha256 sha;
+  sha.AddBytes("abc", 3);
+  EXPECT_EQ(sha.Finish(), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST(Sha256Test, StringsDoNotRunIntoEachOther) {
+  Sha256 first;
+  first.Add(android::StringPiece("ab"));
+  first.Add(android::StringPiece("c"));
+  Sha256 second;
+  second.Add(android::StringPiece("a"));
+  second.Add(android::StringPiece("bc"));
+  EXPECT_NE(first.Finish(), second.Finish());
+}
+
+}  // namespace util
+}  // namespace aapt
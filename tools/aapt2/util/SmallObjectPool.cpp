@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/SmallObjectPool.h"
+
+#include <mutex>
+#include <new>
+
+namespace aapt {
+namespace util {
+
+namespace {
+
+constexpr size_t kGranularity = 16;
+constexpr size_t kSizeClassCount = SmallObjectPool::kMaxObjectSize / kGranularity;
+constexpr size_t kBlockSize = 64 * 1024;
+
+// The number of free objects of a size that a thread keeps before handing half of them over.
+constexpr size_t kMaxThreadObjectCount = 1024;
+
+// The pool is bypassed under AddressSanitizer, which would otherwise miss the uses of freed values.
+#if defined(__SANITIZE_ADDRESS__)
+constexpr bool kEnabled = false;
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+constexpr bool kEnabled = false;
+#else
+constexpr bool kEnabled = true;
+#endif
+#else
+constexpr bool kEnabled = true;
+#endif
+
+struct FreeObject {
+  FreeObject* next;
+};
+
+struct FreeList {
+  FreeObject* head = nullptr;
+  size_t count = 0;
+
+  void Push(void* ptr) {
+    FreeObject* object = static_cast<FreeObject*>(ptr);
+    object->next = head;
+    head = object;
+    count++;
+  }
+
+  void* Pop() {
+    FreeObject* object = head;
+    head = object->next;
+    count--;
+    return object;
+  }
+
+  void MoveTo(FreeList* list, size_t max_count) {
+    for (size_t i = 0; i < max_count && head != nullptr; i++) {
+      list->Push(Pop());
+    }
+  }
+};
+
+struct SharedLists {
+  std::mutex lock;
+  FreeList lists[kSizeClassCount];
+};
+
+SharedLists& GetSharedLists() {
+  // Never destroyed, since objects may still be freed while the static objects are destroyed.
+  static SharedLists* shared = new SharedLists();
+  return *shared;
+}
+
+// Trivially destructible, so that the objects freed while a thread exits don't use a destroyed
+// object. Those are never reused.
+thread_local FreeList tls_lists[kSizeClassCount];
+thread_local bool tls_exited = false;
+
+// Hands the objects that the thread kept over to the other threads once it exits.
+struct ThreadListsReleaser {
+  ~ThreadListsReleaser() {
+    tls_exited = true;
+    SharedLists& shared = GetSharedLists();
+    std::lock_guard<std::mutex> lock(shared.lock);
+    for (size_t i = 0; i < kSizeClassCount; i++) {
+      tls_lists[i].MoveTo(&shared.lists[i], tls_lists[i].count);
+    }
+  }
+};
+
+void RegisterThreadListsReleaser() {
+  if (!tls_exited) {
+    static thread_local ThreadListsReleaser releaser;
+    (void)releaser;
+  }
+}
+
+size_t GetSizeClass(size_t size) {
+  return size == 0 ? 0 : (size - 1) / kGranularity;
+}
+
+void Refill(size_t size_class, FreeList* list) {
+  RegisterThreadListsReleaser();
+  {
+    SharedLists& shared = GetSharedLists();
+    std::lock_guard<std::mutex> lock(shared.lock);
+    shared.lists[size_class].MoveTo(list, kMaxThreadObjectCount / 2);
+  }
+  if (list->head != nullptr) {
+    return;
+  }
+
+  const size_t object_size = (size_class + 1) * kGranularity;
+  char* block = static_cast<char*>(::operator new(kBlockSize));
+  for (size_t offset = 0; offset + object_size <= kBlockSize; offset += object_size) {
+    list->Push(block + offset);
+  }
+}
+
+}  // namespace
+
+void* SmallObjectPool::Allocate(size_t size) {
+  if (!kEnabled || size > kMaxObjectSize) {
+    return ::operator new(size);
+  }
+  const size_t size_class = GetSizeClass(size);
+  FreeList& list = tls_lists[size_class];
+  if (list.head == nullptr) {
+    Refill(size_class, &list);
+  }
+  return list.Pop();
+}
+
+void SmallObjectPool::Free(void* ptr, size_t size) {
+  if (ptr == nullptr) {
+    return;
+  }
+  if (!kEnabled || size > kMaxObjectSize) {
+    ::operator delete(ptr);
+    return;
+  }
+  const size_t size_class = GetSizeClass(size);
+  FreeList& list = tls_lists[size_class];
+  if (list.head == nullptr) {
+    // The thread may never have allocated anything itself.
+    RegisterThreadListsReleaser();
+  }
+  list.Push(ptr);
+  if (list.count > kMaxThreadObjectCount) {
+    SharedLists& shared = GetSharedLists();
+    std::lock_guard<std::mutex> lock(shared.lock);
+    list.MoveTo(&shared.lists[size_class], kMaxThreadObjectCount / 2);
+  }
+}
+
+}  // namespace util
+}  // namespace aapt
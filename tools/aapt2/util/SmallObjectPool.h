@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AAPT_UTIL_SMALLOBJECTPOOL_H
+#define AAPT_UTIL_SMALLOBJECTPOOL_H
+
+#include <cstddef>
+
+namespace aapt {
+namespace util {
+
+// Allocates the small objects that resource tables are made of, such as their entries and values,
+// from blocks of objects of the same size. The objects that a thread frees are kept for it to
+// reuse, and handed over to the other threads when there are too many of them or when it exits, so
+// that most allocations take no lock. The blocks are never returned to the system.
+class SmallObjectPool {
+ public:
+  // Larger objects are allocated with the global operator new.
+  static constexpr size_t kMaxObjectSize = 512;
+
+  static void* Allocate(size_t size);
+  static void Free(void* ptr, size_t size);
+
+  SmallObjectPool() = delete;
+};
+
+}  // namespace util
+}  // namespace aapt
+
+// Declares the operators that allocate the objects of a class from the SmallObjectPool, along with
+// those of its subclasses if its destructor is virtual.
+#define AAPT_SMALL_OBJECT_POOL_ALLOCATED()                       \
+  static void* operator new(size_t size) {                       \
+    return ::aapt::util::SmallObjectPool::Allocate(size);        \
+  }                                                              \
+  static void operator delete(void* ptr, size_t size) {          \
+    ::aapt::util::SmallObjectPool::Free(ptr, size);              \
+  }
+
+#endif  // AAPT_UTIL_SMALLOBJECTPOOL_H
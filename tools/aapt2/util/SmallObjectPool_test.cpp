@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/SmallObjectPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "ResourceValues.h"
+#include "ValueVisitor.h"
+#include "test/Test.h"
+
+namespace aapt {
+namespace util {
+
+TEST(SmallObjectPoolTest, AllocatesDistinctAlignedObjects) {
+  std::vector<std::pair<void*, size_t>> objects;
+  std::set<void*> addresses;
+  for (size_t size = 1; size <= SmallObjectPool::kMaxObjectSize * 2; size += 7) {
+    void* object = SmallObjectPool::Allocate(size);
+    ASSERT_NE(object, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(object) % alignof(std::max_align_t), 0u);
+    memset(object, 0xa5, size);
+    EXPECT_TRUE(addresses.insert(object).second);
+    objects.emplace_back(object, size);
+  }
+  for (const auto& [object, size] : objects) {
+    SmallObjectPool::Free(object, size);
+  }
+}
+
+TEST(SmallObjectPoolTest, ObjectsFreedOnAnotherThread) {
+  std::vector<void*> objects;
+  for (int i = 0; i < 5000; i++) {
+    objects.push_back(SmallObjectPool::Allocate(48));
+  }
+  std::thread([&objects] {
+    for (void* object : objects) {
+      SmallObjectPool::Free(object, 48);
+    }
+  }).join();
+
+  for (int i = 0; i < 5000; i++) {
+    void* object = SmallObjectPool::Allocate(48);
+    memset(object, 0, 48);
+    objects[i] = object;
+  }
+  for (void* object : objects) {
+    SmallObjectPool::Free(object, 48);
+  }
+}
+
+TEST(SmallObjectPoolTest, AllocatesValues) {
+  std::vector<std::unique_ptr<Value>> values;
+  for (int i = 0; i < 100; i++) {
+    values.push_back(util::make_unique<Id>());
+    values.push_back(util::make_unique<Reference>(test::ParseNameOrDie("android:string/foo")));
+  }
+  for (size_t i = 0; i < values.size(); i += 2) {
+    EXPECT_THAT(ValueCast<Id>(values[i].get()), testing::NotNull());
+    EXPECT_THAT(ValueCast<Reference>(values[i + 1].get()), testing::NotNull());
+  }
+}
+
+}  // namespace util
+}  // namespace aapt
@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <cstdlib>
 
 #include "aapt/AaptUtil.h"
 
@@ -37,11 +38,14 @@ namespace split {
 static void usage() {
     fprintf(stderr,
             "split-select --help\n"
-            "split-select --target <config> --base <path/to/apk> [--split <path/to/apk> [...]]\n"
+            "split-select --target <config> [--target <config> [...]] [-j <jobs>] --base <path/to/apk>\n"
+            "             [--split <path/to/apk> [...]]\n"
             "split-select --generate --base <path/to/apk> [--split <path/to/apk> [...]]\n"
             "\n"
             "  --help                   Displays more information about this program.\n"
             "  --target <config>        Performs the Split APK selection on the given configuration.\n"
+            "                           May be repeated to select for several configurations at once.\n"
+            "  -j <jobs>                Number of threads used to select for several configurations.\n"
             "  --generate               Generates the logic for selecting the Split APK, in JSON format.\n"
             "  --base <path/to/apk>     Specifies the base APK, from which all Split APKs must be based off.\n"
             "  --split <path/to/apk>    Includes a Split APK in the selection process.\n"
@@ -60,12 +64,14 @@ static void help() {
             "  Using the flag --generate will emit a JSON encoded tree of rules that must be satisfied in order\n"
             "  to install the given Split APK. Using the flag --target along with the device configuration\n"
             "  will emit the set of Split APKs to install, following the same logic that would have been emitted\n"
-            "  via JSON.\n");
+            "  via JSON. When several --target flags are given, the set of Split APKs for each of them is\n"
+            "  emitted after a line naming the target, in the order the targets were given.\n");
 }
 
-Vector<SplitDescription> select(const SplitDescription& target, const Vector<SplitDescription>& splits) {
+Vector<Vector<SplitDescription> > select(const Vector<SplitDescription>& targets,
+        const Vector<SplitDescription>& splits, int jobs) {
     const SplitSelector selector(splits);
-    return selector.getBestSplits(target);
+    return selector.getBestSplits(targets, jobs);
 }
 
 void generate(const KeyedVector<String8, Vector<SplitDescription> >& splits, const String8& base) {
@@ -244,7 +250,8 @@ static int main(int argc, char** argv) {
     argv++;
 
     bool generateFlag = false;
-    String8 targetConfigStr;
+    Vector<String8> targetConfigStrs;
+    int jobs = 1;
     Vector<String8> splitApkPaths;
     String8 baseApkPath;
     while (argc > 0) {
@@ -257,7 +264,22 @@ static int main(int argc, char** argv) {
                 usage();
                 return 1;
             }
-            targetConfigStr = *argv;
+            targetConfigStrs.add(String8(*argv));
+        } else if (arg == "-j") {
+            argc--;
+            argv++;
+            if (argc < 1) {
+                fprintf(stderr, "error: missing parameter for -j.\n");
+                usage();
+                return 1;
+            }
+            char* endPtr;
+            jobs = strtol(*argv, &endPtr, 10);
+            if (*endPtr != '\0' || jobs < 1) {
+                fprintf(stderr, "error: invalid -j value: '%s'.\n", *argv);
+                usage();
+                return 1;
+            }
         } else if (arg == "--split") {
             argc--;
             argv++;
@@ -296,7 +318,7 @@ static int main(int argc, char** argv) {
         argv++;
     }
 
-    if (!generateFlag && targetConfigStr == "") {
+    if (!generateFlag && targetConfigStrs.isEmpty()) {
         usage();
         return 1;
     }
@@ -314,17 +336,23 @@ static int main(int argc, char** argv) {
         return 1;
     }
 
-    SplitDescription targetSplit;
+    Vector<SplitDescription> targetSplits;
     if (!generateFlag) {
-        if (!SplitDescription::parse(targetConfigStr, &targetSplit)) {
-            fprintf(stderr, "error: invalid --target config: '%s'.\n", targetConfigStr.c_str());
-            usage();
-            return 1;
-        }
+        const size_t targetCount = targetConfigStrs.size();
+        for (size_t i = 0; i < targetCount; i++) {
+            SplitDescription targetSplit;
+            if (!SplitDescription::parse(targetConfigStrs[i], &targetSplit)) {
+                fprintf(stderr, "error: invalid --target config: '%s'.\n",
+                        targetConfigStrs[i].c_str());
+                usage();
+                return 1;
+            }
 
-        // We don't want to match on things that will change at run-time
-        // (orientation, w/h, etc.).
-        removeRuntimeQualifiers(&targetSplit.config);
+            // We don't want to match on things that will change at run-time
+            // (orientation, w/h, etc.).
+            removeRuntimeQualifiers(&targetSplit.config);
+            targetSplits.add(targetSplit);
+        }
     }
 
     splitApkPaths.add(baseApkPath);
@@ -350,17 +378,28 @@ static int main(int argc, char** argv) {
     }
 
     if (!generateFlag) {
-        Vector<SplitDescription> matchingConfigs = select(targetSplit, splitConfigs);
-        const size_t matchingConfigCount = matchingConfigs.size();
-        SortedVector<String8> matchingSplitPaths;
-        for (size_t i = 0; i < matchingConfigCount; i++) {
-            matchingSplitPaths.add(splitApkPathMap.valueFor(matchingConfigs[i]));
-        }
+        const Vector<Vector<SplitDescription> > matchingConfigsPerTarget =
+                select(targetSplits, splitConfigs, jobs);
+        const bool multipleTargets = targetSplits.size() > 1;
+        const size_t targetCount = matchingConfigsPerTarget.size();
+        for (size_t t = 0; t < targetCount; t++) {
+            const Vector<SplitDescription>& matchingConfigs = matchingConfigsPerTarget[t];
+            const size_t matchingConfigCount = matchingConfigs.size();
+            SortedVector<String8> matchingSplitPaths;
+            for (size_t i = 0; i < matchingConfigCount; i++) {
+                matchingSplitPaths.add(splitApkPathMap.valueFor(matchingConfigs[i]));
+            }
 
-        const size_t matchingSplitApkPathCount = matchingSplitPaths.size();
-        for (size_t i = 0; i < matchingSplitApkPathCount; i++) {
-            if (matchingSplitPaths[i] != baseApkPath) {
-                fprintf(stdout, "%s\n", matchingSplitPaths[i].c_str());
+            if (multipleTargets) {
+                fprintf(stdout, "%s:\n", targetConfigStrs[t].c_str());
+            }
+
+            const size_t matchingSplitApkPathCount = matchingSplitPaths.size();
+            for (size_t i = 0; i < matchingSplitApkPathCount; i++) {
+                if (matchingSplitPaths[i] != baseApkPath) {
+                    fprintf(stdout, multipleTargets ? "  %s\n" : "%s\n",
+                            matchingSplitPaths[i].c_str());
+                }
             }
         }
     } else {
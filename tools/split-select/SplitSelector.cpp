@@ -14,6 +14,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include <utils/KeyedVector.h>
 #include <utils/SortedVector.h>
 #include <utils/Vector.h>
@@ -65,6 +70,42 @@ Vector<SplitDescription> SplitSelector::getBestSplits(const SplitDescription& ta
     return bestSplits;
 }
 
+Vector<Vector<SplitDescription> > SplitSelector::getBestSplits(
+        const Vector<SplitDescription>& targets, int jobs) const {
+    SortedVector<SplitDescription> distinctTargets;
+    const size_t targetCount = targets.size();
+    for (size_t i = 0; i < targetCount; i++) {
+        distinctTargets.add(targets[i]);
+    }
+
+    const size_t distinctCount = distinctTargets.size();
+    std::vector<Vector<SplitDescription> > distinctSplits(distinctCount);
+    std::atomic<size_t> nextTarget(0);
+    auto selectNext = [&]() {
+        for (size_t i = nextTarget++; i < distinctCount; i = nextTarget++) {
+            distinctSplits[i] = getBestSplits(distinctTargets[i]);
+        }
+    };
+
+    // The calling thread is one of the jobs.
+    const size_t threadCount = std::min<size_t>(std::max(jobs, 1), distinctCount);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(selectNext);
+    }
+    selectNext();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    Vector<Vector<SplitDescription> > bestSplits;
+    bestSplits.setCapacity(targetCount);
+    for (size_t i = 0; i < targetCount; i++) {
+        bestSplits.add(distinctSplits[distinctTargets.indexOf(targets[i])]);
+    }
+    return bestSplits;
+}
+
 KeyedVector<SplitDescription, sp<Rule> > SplitSelector::getRules() const {
     KeyedVector<SplitDescription, sp<Rule> > rules;
 
@@ -33,6 +33,14 @@ public:
 
     android::Vector<SplitDescription> getBestSplits(const SplitDescription& target) const;
 
+    /**
+     * Returns the best splits for each of the targets, in the same order. Targets that are equal,
+     * as many device profiles are, are only evaluated once, and the distinct ones are spread over
+     * the given number of threads.
+     */
+    android::Vector<android::Vector<SplitDescription> > getBestSplits(
+            const android::Vector<SplitDescription>& targets, int jobs = 1) const;
+
     android::KeyedVector<SplitDescription, android::sp<Rule> > getRules() const;
 
 private:
@@ -69,4 +69,34 @@ TEST(SplitSelectorTest, rulesShouldMatchSelection) {
     EXPECT_RULES_EQ(rule, expectedRule);
 }
 
+TEST(SplitSelectorTest, batchSelectionMatchesSingleSelection) {
+    Vector<SplitDescription> splits;
+    ASSERT_TRUE(addSplit(splits, "hdpi"));
+    ASSERT_TRUE(addSplit(splits, "xhdpi"));
+    ASSERT_TRUE(addSplit(splits, "xxhdpi"));
+    ASSERT_TRUE(addSplit(splits, "mdpi"));
+    ASSERT_TRUE(addSplit(splits, "en"));
+    ASSERT_TRUE(addSplit(splits, "fr"));
+
+    Vector<SplitDescription> targets;
+    ASSERT_TRUE(addSplit(targets, "en-hdpi"));
+    ASSERT_TRUE(addSplit(targets, "fr-xxhdpi"));
+    ASSERT_TRUE(addSplit(targets, "en-hdpi"));
+    ASSERT_TRUE(addSplit(targets, "de-ldpi"));
+    ASSERT_TRUE(addSplit(targets, "fr-mdpi"));
+
+    SplitSelector selector(splits);
+    for (int jobs : {1, 4}) {
+        Vector<Vector<SplitDescription> > bestSplits = selector.getBestSplits(targets, jobs);
+        ASSERT_EQ(targets.size(), bestSplits.size());
+        for (size_t i = 0; i < targets.size(); i++) {
+            Vector<SplitDescription> expected = selector.getBestSplits(targets[i]);
+            ASSERT_EQ(expected.size(), bestSplits[i].size());
+            for (size_t j = 0; j < expected.size(); j++) {
+                EXPECT_EQ(expected[j], bestSplits[i][j]);
+            }
+        }
+    }
+}
+
 } // namespace split
@@ -49,8 +49,132 @@ write_enum(stringstream& text, const EnumDescriptorProto& enu, const string& ind
     text << endl;
 }
 
+/**
+ * Returns the wire type of the field, or -1 if it has no typed writer.
+ */
+static int
+get_wire_type(const FieldDescriptorProto& field)
+{
+    switch (field.type()) {
+        case FieldDescriptorProto::TYPE_INT64:
+        case FieldDescriptorProto::TYPE_UINT64:
+        case FieldDescriptorProto::TYPE_INT32:
+        case FieldDescriptorProto::TYPE_BOOL:
+        case FieldDescriptorProto::TYPE_UINT32:
+        case FieldDescriptorProto::TYPE_ENUM:
+        case FieldDescriptorProto::TYPE_SINT32:
+        case FieldDescriptorProto::TYPE_SINT64:
+            return 0;
+        case FieldDescriptorProto::TYPE_DOUBLE:
+        case FieldDescriptorProto::TYPE_FIXED64:
+        case FieldDescriptorProto::TYPE_SFIXED64:
+            return 1;
+        case FieldDescriptorProto::TYPE_STRING:
+        case FieldDescriptorProto::TYPE_BYTES:
+            return 2;
+        case FieldDescriptorProto::TYPE_FLOAT:
+        case FieldDescriptorProto::TYPE_FIXED32:
+        case FieldDescriptorProto::TYPE_SFIXED32:
+            return 5;
+        default:
+            // Messages are written with start and end.
+            return -1;
+    }
+}
+
+/**
+ * Writes a function that writes the field with the tag already encoded, so that
+ * ProtoOutputStream doesn't have to switch on the type of the field id.
+ */
+static void
+write_typed_writer(stringstream& text, const FieldDescriptorProto& field, const string& indent)
+{
+    int wire_type = get_wire_type(field);
+    if (wire_type < 0) {
+        return;
+    }
+    const uint32_t key = ((uint32_t)field.number() << 3) | wire_type;
+
+    string params;
+    string body;
+    switch (field.type()) {
+        case FieldDescriptorProto::TYPE_DOUBLE:
+            params = "double val";
+            body = "writeDoubleField(key, val)";
+            break;
+        case FieldDescriptorProto::TYPE_FLOAT:
+            params = "float val";
+            body = "writeFloatField(key, val)";
+            break;
+        case FieldDescriptorProto::TYPE_INT64:
+            params = "int64_t val";
+            body = "writeVarintField(key, (uint64_t)val)";
+            break;
+        case FieldDescriptorProto::TYPE_UINT64:
+            params = "uint64_t val";
+            body = "writeVarintField(key, val)";
+            break;
+        case FieldDescriptorProto::TYPE_INT32:
+            params = "int32_t val";
+            body = "writeVarintField(key, (uint32_t)val)";
+            break;
+        case FieldDescriptorProto::TYPE_UINT32:
+            params = "uint32_t val";
+            body = "writeVarintField(key, val)";
+            break;
+        case FieldDescriptorProto::TYPE_ENUM:
+            params = "int val";
+            body = "writeVarintField(key, (uint32_t)val)";
+            break;
+        case FieldDescriptorProto::TYPE_BOOL:
+            params = "bool val";
+            body = "writeVarintField(key, val ? 1 : 0)";
+            break;
+        case FieldDescriptorProto::TYPE_SINT32:
+            params = "int32_t val";
+            body = "writeVarintField(key, ((uint32_t)val << 1) ^ (uint32_t)(val >> 31))";
+            break;
+        case FieldDescriptorProto::TYPE_SINT64:
+            params = "int64_t val";
+            body = "writeVarintField(key, ((uint64_t)val << 1) ^ (uint64_t)(val >> 63))";
+            break;
+        case FieldDescriptorProto::TYPE_FIXED64:
+            params = "uint64_t val";
+            body = "writeFixed64Field(key, val)";
+            break;
+        case FieldDescriptorProto::TYPE_SFIXED64:
+            params = "int64_t val";
+            body = "writeFixed64Field(key, (uint64_t)val)";
+            break;
+        case FieldDescriptorProto::TYPE_FIXED32:
+            params = "uint32_t val";
+            body = "writeFixed32Field(key, val)";
+            break;
+        case FieldDescriptorProto::TYPE_SFIXED32:
+            params = "int32_t val";
+            body = "writeFixed32Field(key, (uint32_t)val)";
+            break;
+        case FieldDescriptorProto::TYPE_STRING:
+            params = "std::string_view val";
+            body = "writeLengthDelimitedField(key, val.data(), val.size())";
+            break;
+        default:
+            params = "const char* val, size_t size";
+            body = "writeLengthDelimitedField(key, val, size)";
+            break;
+    }
+
+    const string indented = indent + INDENT;
+    text << indent << "inline bool write_" << field.name()
+            << "(::android::util::ProtoOutputStream* proto, " << params << ") {" << endl;
+    text << indented << "constexpr uint32_t key = 0x" << hex << key << dec << ";" << endl;
+    text << indented << "return proto->" << body << ";" << endl;
+    text << indent << "}" << endl;
+}
+
 static void
-write_field(stringstream& text, const FieldDescriptorProto& field, const string& indent)
+write_field(stringstream& text, const FieldDescriptorProto& field, const string& indent,
+        bool typed_writers)
 {
     string optional_comment = field.label() == FieldDescriptorProto::LABEL_OPTIONAL
             ? "optional " : "";
@@ -70,11 +194,16 @@ write_field(stringstream& text, const FieldDescriptorProto& field, const string&
 
     text << "LL;" << endl;
 
+    if (typed_writers) {
+        write_typed_writer(text, field, indent);
+    }
+
     text << endl;
 }
 
 static void
-write_message(stringstream& text, const DescriptorProto& message, const string& indent)
+write_message(stringstream& text, const DescriptorProto& message, const string& indent,
+        bool typed_writers)
 {
     int N;
     const string indented = indent + INDENT;
@@ -91,13 +220,13 @@ write_message(stringstream& text, const DescriptorProto& message, const string&
     // Nested classes
     N = message.nested_type_size();
     for (int i=0; i<N; i++) {
-        write_message(text, message.nested_type(i), indented);
+        write_message(text, message.nested_type(i), indented, typed_writers);
     }
 
     // Fields
     N = message.field_size();
     for (int i=0; i<N; i++) {
-        write_field(text, message.field(i), indented);
+        write_field(text, message.field(i), indented, typed_writers);
     }
 
     if (GENERATE_MAPPING) {
@@ -122,6 +251,8 @@ write_message(stringstream& text, const DescriptorProto& message, const string&
 static void write_header_file(const string& request_parameter, CodeGeneratorResponse* response,
                               const FileDescriptorProto& file_descriptor) {
     stringstream text;
+    // The typed writers make the header depend on libprotoutil, so they are opt in.
+    const bool typed_writers = request_parameter.find("typed_writers") != string::npos;
 
     text << "// Generated by protoc-gen-cppstream. DO NOT MODIFY." << endl;
     text << "// source: " << file_descriptor.name() << endl << endl;
@@ -134,6 +265,14 @@ static void write_header_file(const string& request_parameter, CodeGeneratorResp
     text << "#define " << header << endl;
     text << endl;
 
+    if (typed_writers) {
+        text << "#include <android/util/ProtoOutputStream.h>" << endl;
+        text << endl;
+        text << "#include <cstdint>" << endl;
+        text << "#include <string_view>" << endl;
+        text << endl;
+    }
+
     vector<string> namespaces = split(file_descriptor.package(), '.');
     for (vector<string>::iterator it = namespaces.begin(); it != namespaces.end(); it++) {
         text << "namespace " << *it << " {" << endl;
@@ -148,7 +287,7 @@ static void write_header_file(const string& request_parameter, CodeGeneratorResp
 
     N = file_descriptor.message_type_size();
     for (size_t i=0; i<N; i++) {
-        write_message(text, file_descriptor.message_type(i), "");
+        write_message(text, file_descriptor.message_type(i), "", typed_writers);
     }
 
     for (vector<string>::reverse_iterator it = namespaces.rbegin(); it != namespaces.rend(); it++) {